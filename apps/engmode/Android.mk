@@ -40,6 +40,7 @@ LOCAL_C_INCLUDES    +=  $(TARGET_OUT_INTERMEDIATES)/KERNEL/source/include/uapi/m
 LOCAL_SRC_FILES     := eng_pcclient.c  \
 		       eng_diag.c \
 		       vlog.c \
+		       eng_logfwd.c \
 		       vdiag.c \
 		       eng_productdata.c \
 		       adc_calibration.c\
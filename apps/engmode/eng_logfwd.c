@@ -0,0 +1,269 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include "engopt.h"
+#include "vlog.h"
+#include "eng_logfwd.h"
+
+#define MAX_OPEN_TIMES  10
+
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE   0x01
+#endif
+
+/*
+ * Log forwarding from a SIPC channel to the host port.
+ *
+ * When nobody has to look at the data it is moved with splice() through
+ * a pipe, so the log pages never get copied to user space. Small reads
+ * are batched in the pipe as long as the channel has more data ready.
+ * Channels or ports that cannot splice fall back to read()/write() on
+ * the user buffer, which is also used when the caller asks for a copy.
+ */
+
+/* not every libc wraps splice(), go to the kernel directly */
+static int eng_splice(int fd_in, int fd_out, int len)
+{
+    return syscall(__NR_splice, fd_in, NULL, fd_out, NULL, (size_t)len, SPLICE_F_MOVE);
+}
+
+static long long eng_fwd_elapsed_ms(struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000LL +
+        (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static void eng_fwd_report(eng_fwd_t* fwd)
+{
+    long long ms = eng_fwd_elapsed_ms(&fwd->stat_start);
+    unsigned long long kbps;
+
+    if (ms < ENG_FWD_REPORT_SEC * 1000LL)
+        return;
+
+    kbps = fwd->stat_bytes * 1000 / ms / 1024;
+    ENG_LOG("%s: %llu.%02llu MB/s (%s), total %llu bytes, dropped %llu bytes in %u drops\n",
+            fwd->name, kbps / 1024, (kbps % 1024) * 100 / 1024,
+            fwd->use_splice ? "splice" : "copy",
+            fwd->total_bytes, fwd->drop_bytes, fwd->drops);
+
+    fwd->stat_bytes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &fwd->stat_start);
+}
+
+/* create the pipe of the splice path and size it, -1 when there is none */
+static int eng_fwd_open_pipe(eng_fwd_t* fwd)
+{
+    if (pipe(fwd->pipe_fd) < 0) {
+        fwd->pipe_fd[0] = fwd->pipe_fd[1] = -1;
+        return -1;
+    }
+
+    fwd->pipe_size = 4096 * 16;
+#ifdef F_SETPIPE_SZ
+    fcntl(fwd->pipe_fd[1], F_SETPIPE_SZ, fwd->buf_size);
+#endif
+#ifdef F_GETPIPE_SZ
+    fwd->pipe_size = fcntl(fwd->pipe_fd[1], F_GETPIPE_SZ);
+#endif
+    /* the pipe must fit in buf in case the port cannot splice */
+    if (fwd->pipe_size <= 0 || fwd->pipe_size > fwd->buf_size)
+        fwd->pipe_size = fwd->buf_size;
+
+    return 0;
+}
+
+static void eng_fwd_close_pipe(eng_fwd_t* fwd)
+{
+    if (fwd->pipe_fd[0] >= 0)
+        close(fwd->pipe_fd[0]);
+    if (fwd->pipe_fd[1] >= 0)
+        close(fwd->pipe_fd[1]);
+    fwd->pipe_fd[0] = fwd->pipe_fd[1] = -1;
+}
+
+/* move what is in the pipe to the user buffer, for ports that cannot splice */
+static int eng_fwd_pipe_to_buf(eng_fwd_t* fwd)
+{
+    int r_cnt, offset = 0;
+
+    while (offset < fwd->pending) {
+        r_cnt = read(fwd->pipe_fd[0], fwd->buf + offset, fwd->pending - offset);
+        if (r_cnt < 0 && errno == EINTR)
+            continue;
+        if (r_cnt <= 0) {
+            /*
+             * What is left cannot be read back. Start over on an empty
+             * pipe, or the next splice would queue behind stale data.
+             */
+            ENG_LOG("%s: cannot empty pipe, error: %s, recreate it\n",
+                    fwd->name, strerror(errno));
+            eng_fwd_close_pipe(fwd);
+            if (eng_fwd_open_pipe(fwd) < 0) {
+                ENG_LOG("%s: cannot create pipe, use copy path\n", fwd->name);
+                fwd->use_splice = 0;
+            }
+            /* none of the pending bytes are in the pipe any more */
+            fwd->copied = 1;
+            return -1;
+        }
+        offset += r_cnt;
+    }
+    fwd->copied = 1;
+    return 0;
+}
+
+static void eng_fwd_drop(eng_fwd_t* fwd)
+{
+    if (fwd->pending && !fwd->copied)
+        eng_fwd_pipe_to_buf(fwd);
+
+    fwd->drop_bytes += fwd->pending;
+    fwd->drops++;
+    fwd->pending = 0;
+    fwd->copied = 0;
+}
+
+int eng_fwd_init(eng_fwd_t* fwd, const char* name, char* buf, int buf_size)
+{
+    memset(fwd, 0, sizeof(eng_fwd_t));
+    fwd->name = name;
+    fwd->buf = buf;
+    fwd->buf_size = buf_size;
+    fwd->pipe_fd[0] = fwd->pipe_fd[1] = -1;
+    clock_gettime(CLOCK_MONOTONIC, &fwd->stat_start);
+
+    if (eng_fwd_open_pipe(fwd) < 0) {
+        ENG_LOG("%s: cannot create pipe, error: %s, use copy path\n", name, strerror(errno));
+        return 0;
+    }
+
+    fwd->use_splice = 1;
+    ENG_LOG("%s: splice forwarding, pipe size %d\n", name, fwd->pipe_size);
+
+    return 0;
+}
+
+void eng_fwd_deinit(eng_fwd_t* fwd)
+{
+    eng_fwd_close_pipe(fwd);
+    fwd->use_splice = 0;
+}
+
+int eng_fwd_fill(eng_fwd_t* fwd, int in_fd, int flags)
+{
+    int r_cnt, room;
+    int copy = (flags & ENG_FWD_COPY) || !fwd->use_splice;
+    struct pollfd pfd;
+
+    fwd->copied = copy;
+
+    while (1) {
+        room = (copy ? fwd->buf_size : fwd->pipe_size) - fwd->pending;
+        if (room <= 0)
+            break;
+
+        if (copy) {
+            r_cnt = read(in_fd, fwd->buf + fwd->pending, room);
+        } else {
+            r_cnt = eng_splice(in_fd, fwd->pipe_fd[1], room);
+            if (r_cnt < 0 && !fwd->pending && (errno == EINVAL || errno == ENOSYS)) {
+                ENG_LOG("%s: channel cannot splice, use copy path\n", fwd->name);
+                fwd->use_splice = 0;
+                fwd->copied = copy = 1;
+                continue;
+            }
+        }
+
+        if (r_cnt <= 0) {
+            if (fwd->pending)
+                break;
+            if (r_cnt < 0)
+                fwd->drops++;
+            return r_cnt;
+        }
+        fwd->pending += r_cnt;
+
+        if ((flags & ENG_FWD_COPY) || fwd->pending >= ENG_FWD_BATCH_SIZE)
+            break;
+
+        /* small read, take more only if it is already there */
+        pfd.fd = in_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN))
+            break;
+    }
+
+    return fwd->pending;
+}
+
+int eng_fwd_flush(eng_fwd_t* fwd, int* out_fd, char* dev_path, int split_enable)
+{
+    int offset = 0, pos = 0;
+    int w_cnt, len;
+    int retry_num;
+    int split_flag = split_enable && (fwd->pending % 64 == 0);
+
+    while (fwd->pending > 0) {
+        len = split_flag ? fwd->pending - 32 : fwd->pending;
+        if (fwd->copied)
+            w_cnt = write(*out_fd, fwd->buf + pos, len);
+        else
+            w_cnt = eng_splice(fwd->pipe_fd[0], *out_fd, len);
+
+        if (w_cnt < 0) {
+            if (errno == EBUSY) {
+                usleep(59000);
+                continue;
+            }
+            if (!fwd->copied && (errno == EINVAL || errno == ENOSYS)) {
+                ENG_LOG("%s: port cannot splice, use copy path\n", fwd->name);
+                fwd->use_splice = 0;
+                if (eng_fwd_pipe_to_buf(fwd) < 0) {
+                    eng_fwd_drop(fwd);
+                    break;
+                }
+                pos = 0;
+                continue;
+            }
+
+            ENG_LOG("%s: no log data write:%d ,%s\n", fwd->name, w_cnt, strerror(errno));
+
+            retry_num = 0;
+            while (-1 == restart_gser(out_fd, dev_path)) {
+                ENG_LOG("%s: open gser port failed\n", fwd->name);
+                sleep(1);
+                retry_num ++;
+                if (retry_num > MAX_OPEN_TIMES) {
+                    ENG_LOG("%s: stop for gser error !\n", fwd->name);
+                    eng_fwd_drop(fwd);
+                    return -1;
+                }
+            }
+        } else {
+            fwd->pending -= w_cnt;
+            offset += w_cnt;
+            pos += w_cnt;
+            split_flag = 0;
+        }
+    }
+
+    fwd->copied = 0;
+    fwd->total_bytes += offset;
+    fwd->stat_bytes += offset;
+    eng_fwd_report(fwd);
+
+    return offset;
+}
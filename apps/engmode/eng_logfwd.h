@@ -0,0 +1,43 @@
+#ifndef _ENG_LOGFWD_H
+#define _ENG_LOGFWD_H
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* stop batching once this much is queued for the host */
+#define ENG_FWD_BATCH_SIZE      (4096 * 16)
+/* seconds between two throughput reports */
+#define ENG_FWD_REPORT_SEC      10
+
+/* read once into the user buffer, the caller needs to look at the data */
+#define ENG_FWD_COPY            0x1
+
+typedef struct eng_fwd {
+    const char* name;
+    char* buf;                  /* user buffer of the copy path */
+    int buf_size;
+    int pipe_fd[2];             /* pipe buffers of the splice path */
+    int pipe_size;
+    int use_splice;
+    int pending;                /* bytes queued in the pipe or buf */
+    int copied;                 /* pending bytes are in buf */
+    unsigned long long total_bytes;
+    unsigned long long drop_bytes;
+    unsigned int drops;
+    unsigned long long stat_bytes;
+    struct timespec stat_start;
+} eng_fwd_t;
+
+int eng_fwd_init(eng_fwd_t* fwd, const char* name, char* buf, int buf_size);
+void eng_fwd_deinit(eng_fwd_t* fwd);
+int eng_fwd_fill(eng_fwd_t* fwd, int in_fd, int flags);
+int eng_fwd_flush(eng_fwd_t* fwd, int* out_fd, char* dev_path, int split_flag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*!_ENG_LOGFWD_H*/
@@ -19,6 +19,7 @@
 #include "eng_util.h"
 #include "gps_pc_mode.h"
 #include "eng_diag.h"
+#include "eng_logfwd.h"
 
 #define DATA_BUF_SIZE (4096 * 64)
 #define MAX_OPEN_TIMES  10
@@ -107,9 +108,11 @@ int restart_gser(int* fd, char* dev_path)
 void *eng_vlog_thread(void *x)
 {
     int ser_fd, modem_fd;
-    int r_cnt, w_cnt, offset;
+    int r_cnt;
     int retry_num = 0;
     int dumpmemlen = 0;
+    int split_enable;
+    eng_fwd_t fwd;
     eng_dev_info_t* dev_info = (eng_dev_info_t*)x;
 
     ENG_LOG("eng_vlog thread start\n");
@@ -138,59 +141,31 @@ void *eng_vlog_thread(void *x)
     }while(modem_fd < 0);
 
     ENG_LOG("eng_vlog put log data from SIPC to serial\n");
+    eng_fwd_init(&fwd, "eng_vlog", log_data, DATA_BUF_SIZE);
+    split_enable = dev_info->host_int.cali_flag && (dev_info->host_int.dev_type == CONNECT_USB);
     while(1) {
-        int split_flag = 0;
-
         if(g_armlog_enable) {
             sem_post(&g_armlog_sem);
         }
         sem_wait(&g_armlog_sem);
 
-        memset(log_data, 0, sizeof(log_data));
-        r_cnt = read(modem_fd, log_data, DATA_BUF_SIZE);
+        // the dump length check needs to see the data
+        r_cnt = eng_fwd_fill(&fwd, modem_fd, g_ass_start ? ENG_FWD_COPY : 0);
         if (r_cnt <= 0) {
             ENG_LOG("eng_vlog read no log data : r_cnt=%d, %s\n",  r_cnt, strerror(errno));
             continue;
         }
 
         // printf dump memory len
-        dump_mem_len_print(r_cnt, &dumpmemlen);
-
-        offset = 0; //reset the offset
-
-        if((r_cnt%64==0) && dev_info->host_int.cali_flag && (dev_info->host_int.dev_type == CONNECT_USB))
-            split_flag = 1;
-        do {
-            if(split_flag)
-                w_cnt = write(ser_fd, log_data + offset, r_cnt-32);
-            else
-                w_cnt = write(ser_fd, log_data + offset, r_cnt);
-            if (w_cnt < 0) {
-                if(errno == EBUSY)
-                    usleep(59000);
-                else {
-                    ENG_LOG("eng_vlog no log data write:%d ,%s\n", w_cnt, strerror(errno));
+        if (fwd.copied)
+            dump_mem_len_print(r_cnt, &dumpmemlen);
 
-                    // FIX ME: retry to open
-                    retry_num = 0; //reset the try number.
-                    while (-1 == restart_gser(&ser_fd, dev_info->host_int.dev_log)) {
-                        ENG_LOG("eng_vlog open gser port failed\n");
-                        sleep(1);
-                        retry_num ++;
-                        if(retry_num > MAX_OPEN_TIMES) {
-                            ENG_LOG("eng_vlog: vlog thread stop for gser error !\n");
-                            sem_post(&g_armlog_sem);
-                            return 0;
-                        }
-                    }
-                }
-            } else {
-                r_cnt -= w_cnt;
-                offset += w_cnt;
-                split_flag = 0;
-                //ENG_LOG("eng_vlog: r_cnt: %d, w_cnt: %d, offset: %d\n", r_cnt, w_cnt, offset);
-            }
-        } while(r_cnt > 0);
+        if (eng_fwd_flush(&fwd, &ser_fd, dev_info->host_int.dev_log, split_enable) < 0) {
+            ENG_LOG("eng_vlog: vlog thread stop for gser error !\n");
+            sem_post(&g_armlog_sem);
+            eng_fwd_deinit(&fwd);
+            return 0;
+        }
     }
 
 out:
@@ -210,6 +185,8 @@ void *eng_vdiag_rthread(void *x)
     int dumpmemlen = 0;
     int ret = -1;
     int flag = 0;
+    int cali_filter, split_enable;
+    eng_fwd_t fwd;
     s_dev_info = (eng_dev_info_t*)x;
     char get_propvalue[PROPERTY_VALUE_MAX] = {0};
 
@@ -230,6 +207,7 @@ void *eng_vdiag_rthread(void *x)
     }
 
     s_ser_diag_fd = ser_fd;
+    eng_fwd_init(&fwd, "eng_vdiag_r", diag_data, DATA_BUF_SIZE);
 
     /*open vbpipe/spipe*/
     ENG_LOG("eng_vdiag_r open SIPC channel...\n");
@@ -250,9 +228,33 @@ void *eng_vdiag_rthread(void *x)
         eng_usb_enable();
     }
 
+    // a read-only property, the calibration filter is fixed for this boot
+    property_get("ro.config.engcplog.enable", get_propvalue, "not_find");
+    cali_filter = (0 == strcmp(get_propvalue, "1")) && (1 == s_dev_info->host_int.cali_flag);
+    ENG_LOG("%s ro.config.engcplog.enable= %s\n",__FUNCTION__, get_propvalue);
+
+    split_enable = s_dev_info->host_int.cali_flag && (s_dev_info->host_int.dev_type == CONNECT_USB);
+
     ENG_LOG("eng_vdiag_r put log data from SIPC to serial\n");
     while(1) {
-        int split_flag = 0;
+        if(!cali_filter) {
+            // nothing to decode, forward without looking at the data
+            r_cnt = eng_fwd_fill(&fwd, modem_fd, g_ass_start ? ENG_FWD_COPY : 0);
+            if (r_cnt <= 0) {
+                ENG_LOG("eng_vdiag_r read no log data : r_cnt=%d, %s\n",  r_cnt, strerror(errno));
+                continue;
+            }
+
+            // printf dump memory len
+            if (fwd.copied)
+                dump_mem_len_print(r_cnt, &dumpmemlen);
+            ret = eng_fwd_flush(&fwd, &ser_fd, s_dev_info->host_int.dev_diag, split_enable);
+            s_ser_diag_fd = ser_fd;
+            if (ret < 0)
+                goto out;
+            continue;
+        }
+
         memset(diag_data, 0, sizeof(diag_data));
         r_cnt = read(modem_fd, diag_data, DATA_BUF_SIZE);
         if (r_cnt <= 0) {
@@ -260,40 +262,31 @@ void *eng_vdiag_rthread(void *x)
             continue;
         }
 
-	property_get("ro.config.engcplog.enable", get_propvalue, "not_find");
-	if((0 == strcmp(get_propvalue, "1")) && (1 == s_dev_info->host_int.cali_flag)){
-	    ENG_LOG("%s ro.config.engcplog.enable= %s\n",__FUNCTION__, get_propvalue);
-	    if (flag == 0) {
-		ret = create_log_dir();
-		if (!ret) {
-		    flag = 1;
-		    test_fd = open_log_path();
-		    if(test_fd < 0){
-			ENG_LOG("eng_vdiag_r cannot open %s.\n", external_path);
-		    }
-		}
-	    }
+        if (flag == 0) {
+            ret = create_log_dir();
+            if (!ret) {
+                flag = 1;
+                test_fd = open_log_path();
+                if(test_fd < 0){
+                    ENG_LOG("eng_vdiag_r cannot open %s.\n", external_path);
+                }
+            }
+        }
 
-	    if (test_fd >= 0) {
-		ret = eng_write_data_to_file(diag_data,r_cnt,test_fd);
-		if(ret < 0){
-		    ENG_LOG("eng_vdiag_r write to logfile failed\n");
-		}
-	    }
+        if (test_fd >= 0) {
+            ret = eng_write_data_to_file(diag_data,r_cnt,test_fd);
+            if(ret < 0){
+                ENG_LOG("eng_vdiag_r write to logfile failed\n");
+            }
+        }
 
-	    ENG_LOG("%s: r_cnt=%d\n", __FUNCTION__,r_cnt);
+        ENG_LOG("%s: r_cnt=%d\n", __FUNCTION__,r_cnt);
 
-	    eng_filter_calibration_log_diag(diag_data,r_cnt,ser_fd);
-	}else{
-	    // printf dump memory len
-	    dump_mem_len_print(r_cnt, &dumpmemlen);
-	    if( 0 == eng_write_usb(diag_data, r_cnt, ser_fd)){
-		    goto out;
-	    }
-	}
+        eng_filter_calibration_log_diag(diag_data,r_cnt,ser_fd);
     }
 out:
     ENG_LOG("eng_vdiag_r thread end\n");
+    eng_fwd_deinit(&fwd);
     if (modem_fd >= 0)
 	close(modem_fd);
     if (test_fd >= 0)
@@ -435,7 +428,7 @@ int eng_is_send_to_usb(char *buf,int len)
     int i = 0;
     int ret = CMD_COMMON;
     MSG_HEAD_T *head_ptr=NULL;
-    char diag_header[20];
+    char diag_header[20] = {0};
     char* tmp = buf;
 
     if(*tmp == 0x7e){
@@ -445,8 +438,15 @@ int eng_is_send_to_usb(char *buf,int len)
 	}
     }
 
-    memcpy(diag_header, tmp, 20);
-    eng_diag_decode7d7e(diag_header, 20);
+    // only the message head is needed, unescape just that much
+    for (i = 0; (i < (int)sizeof(MSG_HEAD_T)) && (tmp < buf + len); i++) {
+        if ((*tmp == 0x7d) || (*tmp == 0x7e)) {
+            diag_header[i] = *(tmp + 1) ^ 0x20;
+            tmp += 2;
+        } else {
+            diag_header[i] = *tmp++;
+        }
+    }
     head_ptr =(MSG_HEAD_T *)(diag_header);
 
     ENG_LOG("%s: cmd=0x%x; subcmd=0x%x\n",__FUNCTION__, head_ptr->type, head_ptr->subtype);
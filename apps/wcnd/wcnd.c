@@ -3,6 +3,8 @@
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
+#include <time.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -184,6 +186,7 @@ void generate_bt_mac()
 static int send_back_cmd_result(int client_fd, char *str, int isOK);
 static int config_cp2_bootup(WcndManager *pWcndManger);
 static void prepare_cp2_recovery(WcndManager *pWcnManager);
+static WcndClient *find_client(WcndManager *pWcndManger, int fd);
 /**
 * static variables
 */
@@ -281,7 +284,7 @@ static int send_back_cmd_result(int client_fd, char *str, int isOK)
 		snprintf(buffer, 255, "%s %s", (isOK?OK_STR:FAIL_STR), str);
 	}
 
-	int ret = write(client_fd, buffer, strlen(buffer)+1);
+	int ret = wcnd_send_to_client(&default_wcn_manager, client_fd, buffer, strlen(buffer)+1);
 	if(ret < 0)
 	{
 		WCND_LOGE("write %s to client_fd:%d fail (error:%s)", buffer, client_fd, strerror(errno));
@@ -458,20 +461,33 @@ overflow:
 }
 
 /**
-* if it is a engineer mode command, dispatch it to engineer worker thread
+* if it is a engineer mode command, dispatch it to engineer worker thread,
+* else dispatch it to the cmd worker thread. No cmd is handled on the main
+* loop, as some of them sleep (AT cmds, CP2 reset) and the main loop must
+* keep watching CP2 assert/watchdog meanwhile.
 */
 static int worker_dispatch(WcndManager *pWcndManger, int client_fd, char *data)
 {
+	WcndClient *client;
+	unsigned int gen = 0;
+
 	if(!pWcndManger || !data)
 	{
 		send_back_cmd_result(client_fd, "Null pointer!!", 0);
 		return -1;
 	}
 
+	//the reply goes to this connection only, not to one that gets client_fd later
+	pthread_mutex_lock(&pWcndManger->clients_lock);
+	client = find_client(pWcndManger, client_fd);
+	if(client)
+		gen = client->gen;
+	pthread_mutex_unlock(&pWcndManger->clients_lock);
+
 	//for engineer mode command, dispatch it to engineer worker thread
 	if(strstr(data, "eng"))
 	{
-		if(wcnd_worker_dispatch(pWcndManger, wcnd_woker_handle, data, client_fd, 0) < 0)
+		if(wcnd_worker_dispatch(pWcndManger, wcnd_woker_handle, data, client_fd, gen, WCND_WORKER_ENG) < 0)
 		{
 			send_back_cmd_result(client_fd, "eng cmd dispatch error!!", 0);
 			return -1;
@@ -480,7 +496,11 @@ static int worker_dispatch(WcndManager *pWcndManger, int client_fd, char *data)
 		return 0;
 	}
 
-	dispatch_command2(pWcndManger, client_fd, data) ;
+	if(wcnd_worker_dispatch(pWcndManger, wcnd_woker_handle, data, client_fd, gen, WCND_WORKER_CMD) < 0)
+	{
+		send_back_cmd_result(client_fd, "cmd dispatch error!!", 0);
+		return -1;
+	}
 
 	return 0;
 }
@@ -592,41 +612,195 @@ static void blockSigpipe(void)
 		WCND_LOGD("WARNING: SIGPIPE not blocked\n");
 }
 
+#define RDWR_FD_FAIL (-2)
+#define GENERIC_FAIL (-1)
+
+static long long wcnd_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static int wcnd_set_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+
+	if(flags < 0) return -1;
+
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
 /**
-* store the fd in the client_fds array.
-* when the array is full, then something will go wrong, so please NOTE!!!
+* add/modify/delete the fd in the epoll set of the main loop.
+* return -1 for fail
 */
-static void store_client_fd(int client_fds[], int fd)
+static int wcnd_epoll_ctl(WcndManager *pWcndManger, int op, int fd, unsigned int events)
 {
-	if(!client_fds) return;
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.fd = fd;
+
+	if(epoll_ctl(pWcndManger->epoll_fd, op, fd, &ev) < 0)
+	{
+		WCND_LOGE("epoll_ctl(%d) fd:%d fail (error:%s)", op, fd, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
 
+/**
+* find the client that owns the socket fd.
+* Note: must be called with clients_lock held.
+*/
+static WcndClient *find_client(WcndManager *pWcndManger, int fd)
+{
 	int i = 0;
 
+	if(fd < 0) return NULL;
+
 	for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
 	{
-		if(client_fds[i] == -1) //invalid fd
-		{
-			client_fds[i] = fd;
-			return;
-		}
-		else if(client_fds[i] == fd)
+		if(pWcndManger->clients[i].sockfd == fd)
+			return &pWcndManger->clients[i];
+	}
+
+	return NULL;
+}
+
+/**
+* find the client a reply for client_fd goes to. On a worker the client
+* must still be the connection the cmd was read from: when client_fd has
+* been closed and reused since, NULL is returned.
+* Note: must be called with clients_lock held.
+*/
+WcndClient *wcnd_find_reply_client(WcndManager *pWcndManger, int client_fd)
+{
+	WcndClient *client = find_client(pWcndManger, client_fd);
+	unsigned int gen;
+
+	if(client && wcnd_worker_reply_gen(client_fd, &gen) && client->gen != gen)
+		return NULL;
+
+	return client;
+}
+
+/**
+* close the client socket and free its slot.
+* Note: must be called with clients_lock held.
+*/
+static void close_client(WcndManager *pWcndManger, WcndClient *client)
+{
+	WCND_LOGD("going to zap %d for %s", client->sockfd, WCND_SOCKET_NAME);
+
+	//close() also removes it from the epoll set
+	close(client->sockfd);
+	client->sockfd = -1;
+	client->type = WCND_CLIENT_TYPE_NOTIFY;
+	client->wq_len = 0;
+	client->wq_armed = 0;
+}
+
+/**
+* write as much of the client write queue as the socket takes, what is left
+* is sent by the main loop when the socket becomes writable again.
+* Note: must be called with clients_lock held.
+* return RDWR_FD_FAIL if the client socket is broken.
+*/
+static int flush_client(WcndManager *pWcndManger, WcndClient *client)
+{
+	int ret;
+	int armed;
+
+	while(client->wq_len > 0)
+	{
+		ret = TEMP_FAILURE_RETRY(write(client->sockfd, client->wq_buf, client->wq_len));
+		if(ret < 0)
 		{
-			WCND_LOGD("%s: Somethine error happens. restore the same fd:%d", __FUNCTION__, fd);
-			return;
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+
+			WCND_LOGE("write %d bytes to client_fd:%d fail (error:%s)", client->wq_len, client->sockfd, strerror(errno));
+			return RDWR_FD_FAIL;
 		}
+
+		client->wq_len -= ret;
+		if(client->wq_len)
+			memmove(client->wq_buf, client->wq_buf + ret, client->wq_len);
 	}
 
-	//if full, ignore the last one, and save the new one
-	if(i == WCND_MAX_CLIENT_NUM)
+	armed = (client->wq_len > 0);
+	if(armed != client->wq_armed)
 	{
-		WCND_LOGD("ERRORR::%s: client_fds is FULL", __FUNCTION__);
-		client_fds[i-1] = fd;
-		return;
+		if(wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_MOD, client->sockfd, EPOLLIN | (armed ? EPOLLOUT : 0)) < 0)
+			return RDWR_FD_FAIL;
+		client->wq_armed = armed;
 	}
+
+	return 0;
 }
 
-#define RDWR_FD_FAIL (-2)
-#define GENERIC_FAIL (-1)
+/**
+* append len bytes to the client write queue and try to send them at once.
+* A client that lets its queue fill up does not read any more, it is
+* reported as broken instead of holding up the others.
+* Note: must be called with clients_lock held.
+*/
+static int queue_to_client(WcndManager *pWcndManger, WcndClient *client, char *buf, int len)
+{
+	if(client->wq_len + len > WCND_CLIENT_WQ_SIZE)
+	{
+		WCND_LOGE("client_fd:%d does not read, %d bytes queued, drop it", client->sockfd, client->wq_len);
+		return RDWR_FD_FAIL;
+	}
+
+	memcpy(client->wq_buf + client->wq_len, buf, len);
+	client->wq_len += len;
+
+	//the main loop is already waiting to send the older bytes, keep the order
+	if(client->wq_armed)
+		return 0;
+
+	return flush_client(pWcndManger, client);
+}
+
+/**
+* send len bytes to client_fd without blocking on the client.
+* A connected client gets them through its write queue, other fds such as
+* the self cmd socket are written directly.
+* return -1 for fail
+*/
+int wcnd_send_to_client(WcndManager *pWcndManger, int client_fd, char *buf, int len)
+{
+	WcndClient *client;
+	int ret;
+
+	if(!pWcndManger || !buf || client_fd < 0) return -1;
+
+	//the self cmd socket is not a client
+	if(client_fd == pWcndManger->selfcmd_sockets[1])
+		return TEMP_FAILURE_RETRY(write(client_fd, buf, len));
+
+	pthread_mutex_lock(&pWcndManger->clients_lock);
+	client = wcnd_find_reply_client(pWcndManger, client_fd);
+	if(!client)
+	{
+		pthread_mutex_unlock(&pWcndManger->clients_lock);
+		WCND_LOGD("client_fd:%d is gone, drop %s", client_fd, buf);
+		return -1;
+	}
+
+	ret = queue_to_client(pWcndManger, client, buf, len);
+	if(RDWR_FD_FAIL == ret)
+		close_client(pWcndManger, client);
+	pthread_mutex_unlock(&pWcndManger->clients_lock);
+
+	return (ret < 0) ? -1 : len;
+}
 
 /**
 * process the active client fd ( the client close the remote socket or send something)
@@ -643,6 +817,9 @@ static int process_active_client_fd(WcndManager *pWcndManger, int fd)
 	len = TEMP_FAILURE_RETRY(read(fd, buffer, sizeof(buffer)-1));//reserve last byte for null character.
 	if (len < 0)
 	{
+		if(errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0;
+
 		WCND_LOGD("read() failed (%s)", strerror(errno));
 		return RDWR_FD_FAIL;
 	}
@@ -658,173 +835,112 @@ static int process_active_client_fd(WcndManager *pWcndManger, int fd)
 }
 
 /**
-* listen on the server socket for accept connection from client.
-* and then also set the client socket to select read fds for:
-* 1. to detect the exception from client, then to close the client socket.
-* 2. to process the cmd from client in feature.
+* accept the connection from a client and add it to the epoll set.
 */
-static void *client_listen_thread(void *arg)
+static void accept_client(WcndManager *pWcndManger)
 {
-	WcndManager *pWcndManger = (WcndManager *)arg;
-
-	if(!pWcndManger)
-	{
-		WCND_LOGD("%s: UNEXCPET NULL WcndManager", __FUNCTION__);
-		exit(-1);
-	}
+	struct sockaddr addr;
+	socklen_t alen;
+	int c;
+	int i = 0;
 
-	int pending_fds[WCND_MAX_CLIENT_NUM];
-	memset(pending_fds, -1, sizeof(pending_fds));
+	//accept the client connection
+	do {
+		alen = sizeof(addr);
+		c = accept(pWcndManger->listen_fd, &addr, &alen);
+		WCND_LOGD("%s got %d from accept", WCND_SOCKET_NAME, c);
+	} while (c < 0 && errno == EINTR);
 
-	while(1)
+	if (c < 0)
 	{
-		int  i = 0;
-		fd_set read_fds;
-		int rc = 0;
-		int max = -1;
-
-		FD_ZERO(&read_fds);
+		if(errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
 
-		max = pWcndManger->listen_fd;
-		FD_SET(pWcndManger->listen_fd, &read_fds);
+		//such as out of fds, do not spin on the listen socket
+		WCND_LOGE("accept failed (%s)", strerror(errno));
+		sleep(1);
+		return;
+	}
 
-		FD_SET(pWcndManger->selfcmd_sockets[1], &read_fds);
-		if (pWcndManger->selfcmd_sockets[1] > max)
-			max = pWcndManger->selfcmd_sockets[1];
+	//a client must never block the main loop
+	wcnd_set_nonblock(c);
 
-		//if need to deal with the cmd sent from client, here add them to read_fds
-		pthread_mutex_lock(&pWcndManger->clients_lock);
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			int fd = pWcndManger->clients[i].sockfd;
-			if(fd != -1) //valid fd
-			{
-				FD_SET(fd, &read_fds);
-				if (fd > max)
-					max = fd;
-			}
-		}
-		pthread_mutex_unlock(&pWcndManger->clients_lock);
+	//save client
+	pthread_mutex_lock(&pWcndManger->clients_lock);
+	for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
+	{
+		if(pWcndManger->clients[i].sockfd == -1) //invalid fd
+			break;
+	}
 
-		WCND_LOGD("listen_fd = %d, max=%d", pWcndManger->listen_fd, max);
-		if ((rc = select(max + 1, &read_fds, NULL, NULL, NULL)) < 0)
-		{
-			if (errno == EINTR)
-				continue;
+	if(i == WCND_MAX_CLIENT_NUM)
+	{
+		WCND_LOGD("ERRORR::%s: clients is FULL", __FUNCTION__);
+		close(c);
+	}
+	else
+	{
+		WcndClient *client = &pWcndManger->clients[i];
 
-			WCND_LOGD("select failed (%s) listen_fd = %d, max=%d", strerror(errno), pWcndManger->listen_fd, max);
-			sleep(1);
-			continue;
-		}
-		else if (!rc)
-			continue;
+		client->sockfd = c;
+		client->type = WCND_CLIENT_TYPE_NOTIFY;
+		client->wq_len = 0;
+		client->wq_armed = 0;
+		if(!++pWcndManger->client_gen)
+			++pWcndManger->client_gen;
+		client->gen = pWcndManger->client_gen;
 
-		if (FD_ISSET(pWcndManger->listen_fd, &read_fds))
-		{
-			struct sockaddr addr;
-			socklen_t alen;
-			int c;
-
-			//accept the client connection
-			do {
-				alen = sizeof(addr);
-				c = accept(pWcndManger->listen_fd, &addr, &alen);
-				WCND_LOGD("%s got %d from accept", WCND_SOCKET_NAME, c);
-			} while (c < 0 && errno == EINTR);
-
-			if (c < 0)
-			{
-				WCND_LOGE("accept failed (%s)", strerror(errno));
-				sleep(1);
-				continue;
-			}
+		if(wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_ADD, c, EPOLLIN) < 0)
+			close_client(pWcndManger, client);
+	}
+	pthread_mutex_unlock(&pWcndManger->clients_lock);
+}
 
-			//save client
-			pthread_mutex_lock(&pWcndManger->clients_lock);
-			for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-			{
-				if(pWcndManger->clients[i].sockfd == -1) //invalid fd
-				{
-					pWcndManger->clients[i].sockfd = c;
-					pWcndManger->clients[i].type = WCND_CLIENT_TYPE_NOTIFY;
-					break;
+/**
+* handle the events of a client socket:
+* 1. send what is left in its write queue.
+* 2. process the cmd from client, or close the socket when the client is gone.
+*/
+static void handle_client_event(WcndManager *pWcndManger, int fd, unsigned int events)
+{
+	WcndClient *client;
+	int ret = 0;
 
-				}
-				else if(pWcndManger->clients[i].sockfd == c)
-				{
-					WCND_LOGD("%s: Somethine error happens. restore the same fd:%d", __FUNCTION__, c);
-					break;
-				}
-			}
+	pthread_mutex_lock(&pWcndManger->clients_lock);
+	client = find_client(pWcndManger, fd);
+	if(client && (events & EPOLLOUT))
+	{
+		ret = flush_client(pWcndManger, client);
+		if(RDWR_FD_FAIL == ret)
+			close_client(pWcndManger, client);
+	}
+	pthread_mutex_unlock(&pWcndManger->clients_lock);
 
-			//if full, ignore the last one, and save the new one
-			if(i == WCND_MAX_CLIENT_NUM)
-			{
-				WCND_LOGD("ERRORR::%s: clients is FULL", __FUNCTION__);
-				close(c);
-			}
-			pthread_mutex_unlock(&pWcndManger->clients_lock);
-		}
+	//already closed by another thread or just above
+	if(!client || ret < 0)
+		return;
 
-		/* TODO:   */
+	if(!(events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+		return;
 
-		/* Add all active clients to the pending list first */
-		memset(pending_fds, -1, sizeof(pending_fds));
+	/* Process it, if fail is returned and our sockets are connection-based, remove and destroy it */
+	if(process_active_client_fd(pWcndManger, fd) == RDWR_FD_FAIL)
+	{
 		pthread_mutex_lock(&pWcndManger->clients_lock);
-		for (i = 0; i<WCND_MAX_CLIENT_NUM; i++)
-		{
-			int fd = pWcndManger->clients[i].sockfd;
-			if ((fd!= -1) && FD_ISSET(fd, &read_fds))
-			{
-				store_client_fd(pending_fds, fd);
-			}
-		}
+		client = find_client(pWcndManger, fd);
+		if(client)
+			close_client(pWcndManger, client);
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
-
-
-		if (FD_ISSET(pWcndManger->selfcmd_sockets[1], &read_fds))
-			store_client_fd(pending_fds, pWcndManger->selfcmd_sockets[1]);
-
-
-		/* Process the pending list, since it is owned by the thread, there is no need to lock it */
-		for (i = 0; i<WCND_MAX_CLIENT_NUM; i++)
-		{
-			int fd = pending_fds[i];
-
-			/* remove from the pending list */
-			pending_fds[i] = -1;
-
-			/* Process it, if fail is returned and our sockets are connection-based, remove and destroy it */
-			if( (fd != -1) && (process_active_client_fd(pWcndManger, fd)  == RDWR_FD_FAIL))
-			{
-				int j = 0;
-
-				/* Remove the client from our array */
-				WCND_LOGD("going to zap %d for %s", fd, WCND_SOCKET_NAME);
-				pthread_mutex_lock(&pWcndManger->clients_lock);
-				for (j = 0; j<WCND_MAX_CLIENT_NUM; j++)
-				{
-					if (pWcndManger->clients[j].sockfd == fd) {
-						close(fd); //close the socket
-						pWcndManger->clients[j].sockfd = -1;
-						pWcndManger->clients[j].type = WCND_CLIENT_TYPE_NOTIFY;
-						break;
-					}
-				}
-				pthread_mutex_unlock(&pWcndManger->clients_lock);
-			}
-		}
-
 	}
-
 }
 
 
 /**
 * Note: message send from wcnd must end with null character
 *             use null character to identify a completed message.
+* Note: must be called with clients_lock held.
 */
-static int send_msg(WcndManager *pWcndManger, int client_fd, char *msg_str)
+static int send_msg(WcndManager *pWcndManger, WcndClient *client, char *msg_str)
 {
 	if(!pWcndManger || !msg_str) return GENERIC_FAIL;
 
@@ -839,20 +955,15 @@ static int send_msg(WcndManager *pWcndManger, int client_fd, char *msg_str)
 	//use null character to identify a completed message.
 	int len = strlen(buf) + 1; //including null character
 
-	WCND_LOGD("send %s to client_fd:%d", buf, client_fd);
-
-	int ret = TEMP_FAILURE_RETRY(write(client_fd, buf, len));
-	if(ret < 0)
-	{
-		WCND_LOGE("write %d bytes to client_fd:%d fail (error:%s)", len, client_fd, strerror(errno));
-		ret = RDWR_FD_FAIL;
-	}
+	WCND_LOGD("send %s to client_fd:%d", buf, client->sockfd);
 
-	return ret;
+	return queue_to_client(pWcndManger, client, buf, len);
 }
 
 /**
 * send notify information to all the connected clients.
+* The message is only queued for a client that is slow to read, so one
+* stuck client does not delay the notify to the others.
 * return -1 for fail
 * Note: message send from wcnd must end with null character
 *             use null character to identify a completed message.
@@ -884,13 +995,11 @@ int wcnd_send_notify_to_client(WcndManager *pWcndManger, char *info_str, int not
 			|| ((notify_type == WCND_CLIENT_TYPE_CMD) && ((type & WCND_CLIENT_TYPE_CMD_MASK) == notify_type)))
 			)
 		{
-			ret = send_msg(pWcndManger, fd, info_str);
+			ret = send_msg(pWcndManger, &pWcndManger->clients[i], info_str);
 			if(RDWR_FD_FAIL == ret)
 			{
 				WCND_LOGD("reset clients[%d].sockfd = -1",i);
-				close(fd);
-				pWcndManger->clients[i].sockfd = -1;
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_NOTIFY;
+				close_client(pWcndManger, &pWcndManger->clients[i]);
 			}
 			else if(notify_type == WCND_CLIENT_TYPE_CMD || notify_type == WCND_CLIENT_TYPE_CMD_PENDING
 				|| (notify_type & WCND_CLIENT_TYPE_CMD_MASK) == WCND_CLIENT_TYPE_CMD)
@@ -1611,113 +1720,74 @@ static int handle_cp2_watchdog_exception(WcndManager *pWcndManger, int watchdog_
 }
 
 
-static void *cp2_listen_thread(void *arg)
-{
-	WcndManager *pWcndManger = (WcndManager *)arg;
-
-	if(!pWcndManger)
-	{
-		WCND_LOGD("%s: UNEXCPET NULL WcndManager", __FUNCTION__);
-		exit(-1);
-	}
+#ifdef CP2_WATCHER_ENABLE
 
-	int assert_fd = -1;
-	int watchdog_fd = -1;
+//retry to open the cp2 assert/watchdog interface after this long
+#define CP2_WATCH_REOPEN_MSECS (2000)
+//do not look at the cp2 assert/watchdog interface again for this long after an event
+#define CP2_WATCH_REARM_MSECS (1000)
 
-get_assertfd:
-	assert_fd = open( pWcndManger->wcn_assert_iface_name, O_RDWR);
-	WCND_LOGD("%s: open assert dev: %s, fd = %d", __func__, pWcndManger->wcn_assert_iface_name, assert_fd);
-	if (assert_fd < 0)
-	{
-		WCND_LOGD("open %s failed, error: %s", pWcndManger->wcn_assert_iface_name, strerror(errno));
-		sleep(2);
-		goto get_assertfd;
-		//return NULL;
-	}
+/**
+* open the cp2 assert/watchdog interfaces and let the main loop watch them.
+* Their events are one shot, an interface that fired is enabled again here.
+*/
+static void arm_cp2_watcher(WcndManager *pWcndManger)
+{
+	int *fds[2] = {&pWcndManger->assert_fd, &pWcndManger->watchdog_fd};
+	char *names[2] = {pWcndManger->wcn_assert_iface_name, pWcndManger->wcn_watchdog_iface_name};
+	int i = 0;
 
-get_watchdogfd:
-	watchdog_fd = open( pWcndManger->wcn_watchdog_iface_name, O_RDWR);
-	WCND_LOGD("%s: open watchdog dev: %s, fd = %d", __func__, pWcndManger->wcn_watchdog_iface_name, watchdog_fd);
-	if (watchdog_fd < 0)
-	{
-		WCND_LOGD("open %s failed, error: %s", pWcndManger->wcn_watchdog_iface_name, strerror(errno));
-		//close(assert_fd);
-		//return NULL;
-		sleep(2);
-		goto get_watchdogfd;
-	}
+	pWcndManger->cp2_watch_deadline = -1;
 
-	while(1)
+	for (i = 0; i < 2; i++)
 	{
-		int  i = 0;
-		fd_set read_fds;
-		int rc = 0;
-		int max = -1;
-
-		FD_ZERO(&read_fds);
-
-		max = assert_fd;
-		FD_SET(assert_fd, &read_fds);
-
-		FD_SET(watchdog_fd, &read_fds);
-		if (watchdog_fd > max)
-			max = watchdog_fd;
-
-		WCND_LOGD("assert_fd = %d, watchdog_fd = %d, max=%d", assert_fd, watchdog_fd, max);
-		if ((rc = select(max + 1, &read_fds, NULL, NULL, NULL)) < 0)
+		if(*fds[i] >= 0)
 		{
-			if (errno == EINTR)
-				continue;
-
-			WCND_LOGD("select failed assert_fd = %d, watchdog_fd = %d, max=%d", assert_fd, watchdog_fd, max);
-			sleep(1);
+			wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_MOD, *fds[i], EPOLLIN | EPOLLONESHOT);
 			continue;
 		}
-		else if (!rc)
-			continue;
 
-		if (FD_ISSET(assert_fd, &read_fds))
+		*fds[i] = open(names[i], O_RDWR);
+		WCND_LOGD("%s: open cp2 watch dev: %s, fd = %d", __func__, names[i], *fds[i]);
+		if (*fds[i] < 0)
 		{
-			//there is exception from assert.
-			handle_cp2_assert(pWcndManger, assert_fd);
+			WCND_LOGD("open %s failed, error: %s", names[i], strerror(errno));
+			pWcndManger->cp2_watch_deadline = wcnd_now_ms() + CP2_WATCH_REOPEN_MSECS;
+			continue;
 		}
 
-		if (FD_ISSET(watchdog_fd, &read_fds))
+		if(wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_ADD, *fds[i], EPOLLIN | EPOLLONESHOT) < 0)
 		{
-			//there is exception from watchdog.
-			handle_cp2_watchdog_exception(pWcndManger, watchdog_fd);
+			close(*fds[i]);
+			*fds[i] = -1;
+			pWcndManger->cp2_watch_deadline = wcnd_now_ms() + CP2_WATCH_REOPEN_MSECS;
 		}
-
-		//sleep for a while before going to next polling
-		sleep(1);
-
-		/* TODO:   */
-
 	}
 }
 
 /**
-* Start thread to listen for connection from clients.
-* return -1 fail;
+* handle the event of the cp2 assert/watchdog interface in the main loop.
 */
-static int start_client_listener(WcndManager *pWcndManger)
+static void handle_cp2_watch_event(WcndManager *pWcndManger, int fd)
 {
-	if(!pWcndManger) return -1;
-
-	pthread_t thread_id;
-
-	if (pthread_create(&thread_id, NULL, client_listen_thread, pWcndManger))
+	if (fd == pWcndManger->assert_fd)
 	{
-		WCND_LOGE("start_client_listener: pthread_create (%s)", strerror(errno));
-		return -1;
+		//there is exception from assert.
+		handle_cp2_assert(pWcndManger, fd);
+	}
+	else
+	{
+		//there is exception from watchdog.
+		handle_cp2_watchdog_exception(pWcndManger, fd);
 	}
 
-	return 0;
-
+	//wait for a while before watching it again
+	pWcndManger->cp2_watch_deadline = wcnd_now_ms() + CP2_WATCH_REARM_MSECS;
 }
 
 /**
-* Start thread to listen on the CP2 assert/watchdog interface to detect CP2 exception
+* Let the main loop watch the CP2 assert/watchdog interface to detect CP2 exception
+* Note: must be called before the main loop is started.
 * return -1 fail;
 */
 static int start_cp2_listener(WcndManager *pWcndManger)
@@ -1728,17 +1798,14 @@ static int start_cp2_listener(WcndManager *pWcndManger)
 
 	if(!pWcndManger->is_wcn_modem_enabled) return 0;
 
-	pthread_t thread_id;
-
-	if (pthread_create(&thread_id, NULL, cp2_listen_thread, pWcndManger))
-	{
-		WCND_LOGE("start_cp2_listener: pthread_create (%s)", strerror(errno));
-		return -1;
-	}
+	//opened by the main loop as soon as it runs
+	pWcndManger->cp2_watch_deadline = 0;
 
 	return 0;
 }
 
+#endif
+
 /**
 * Initial the wcnd manager struct.
 * return -1 for fail;
@@ -1757,6 +1824,12 @@ static int init(WcndManager *pWcndManger, int is_eng_only)
 	for(i=0; i<WCND_MAX_CLIENT_NUM; i++)
 		pWcndManger->clients[i].sockfd = -1;
 
+	pWcndManger->assert_fd = -1;
+	pWcndManger->watchdog_fd = -1;
+	pWcndManger->loop_fd = -1;
+	pWcndManger->cp2_watch_deadline = -1;
+	pWcndManger->loop_check_deadline = -1;
+
 	pWcndManger->is_eng_mode_only = is_eng_only;
 	if(pWcndManger->is_eng_mode_only)
 	{
@@ -1809,6 +1882,20 @@ static int init(WcndManager *pWcndManger, int is_eng_only)
 		return -1;
 	}
 
+	pWcndManger->epoll_fd = epoll_create(WCND_MAX_CLIENT_NUM + 4);
+	if (pWcndManger->epoll_fd < 0) {
+		WCND_LOGE("%s: cannot create epoll fd (%s)", __FUNCTION__, strerror(errno));
+		return -1;
+	}
+
+	//the main loop must never block on them
+	wcnd_set_nonblock(pWcndManger->listen_fd);
+	wcnd_set_nonblock(pWcndManger->selfcmd_sockets[1]);
+
+	if(wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_ADD, pWcndManger->listen_fd, EPOLLIN) < 0 ||
+		wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_ADD, pWcndManger->selfcmd_sockets[1], EPOLLIN) < 0)
+		return -1;
+
 
 	// to get the wcn modem state
 	pWcndManger->is_wcn_modem_enabled = check_if_wcnmodem_enable();
@@ -1827,7 +1914,7 @@ static int init(WcndManager *pWcndManger, int is_eng_only)
 	memcpy(pWcndManger->cp2_version_info, WCND_CP2_DEFAULT_CP2_VERSION_INFO, sizeof(WCND_CP2_DEFAULT_CP2_VERSION_INFO));
 
 
-	//start engineer worker thread
+	//start engineer and cmd worker threads
 	wcnd_worker_init(pWcndManger);
 
 	pWcndManger->inited = 1;
@@ -1894,102 +1981,207 @@ static void handle_cp2_loop_check_fail(WcndManager *pWcndManger)
 }
 
 /**
-*check cp2 loop dev interface in a interval of 5 seconds
+* check cp2 loop dev interface in a interval of 5 seconds
 * if fail, reset the cp2
+*
+* The check is driven by the main loop: the test string is written to the
+* non-blocking loop interface and the ack is waited for with a deadline,
+* so clients are still served while CP2 is slow to answer.
 */
 #define LOOP_CHECK_INTERVAL_MSECS (5000)
-static void *cp2_loop_check_thread(void *arg)
+//First wait for 20 seconds for CP2 to be ready, and then start doing LOOP CHECK
+#define LOOP_CHECK_START_MSECS (20000)
+//wait 20 seconds for reset after loop check fail
+#define LOOP_CHECK_RESET_WAIT_MSECS (20000)
+//time out 2.5 seconds
+#define LOOP_CHECK_ACK_TIMEOUT_MSECS (2500)
+//marlin cannot support select, so read the ack after a while in non-block mode
+#define LOOP_CHECK_NONBLOCK_WAIT_MSECS (100)
+#define LOOP_CHECK_COUNT (2)
+
+#define LOOP_CHECK_STATE_BOOT (0)
+#define LOOP_CHECK_STATE_IDLE (1)
+#define LOOP_CHECK_STATE_WAIT_ACK (2)
+
+static void loop_check_done(WcndManager *pWcndManger, int result);
+
+static void loop_check_close(WcndManager *pWcndManger)
 {
-	WcndManager *pWcndManger = (WcndManager *)arg;
+	if(pWcndManger->loop_fd >= 0)
+		close(pWcndManger->loop_fd);
+	pWcndManger->loop_fd = -1;
+}
 
-	int count = 0;
-	int is_loopcheck_fail = 0;
+/**
+* write the test string to the loop interface, the ack is read in loop_check_read()
+*/
+static void loop_check_send(WcndManager *pWcndManger)
+{
+	int len = 0;
 
-	if(!pWcndManger)
+	pWcndManger->loop_fd = open( pWcndManger->wcn_loop_iface_name, O_RDWR|O_NONBLOCK);
+	if (pWcndManger->loop_fd < 0)
 	{
-		WCND_LOGD("%s: UNEXCPET NULL WcndManager", __FUNCTION__);
-		exit(-1);
+		WCND_LOGE("open %s failed, error: %s", pWcndManger->wcn_loop_iface_name, strerror(errno));
+		loop_check_done(pWcndManger, -1);
+		return;
+	}
+
+	len = write(pWcndManger->loop_fd, LOOP_TEST_STR, strlen(LOOP_TEST_STR));
+	if(len < 0)
+	{
+		WCND_LOGE("%s: write %s failed, error:%s", __func__, pWcndManger->wcn_loop_iface_name, strerror(errno));
+		loop_check_close(pWcndManger);
+		loop_check_done(pWcndManger, -1);
+		return;
 	}
 
-	//First wait for 20 seconds for CP2 to be ready, and then start doing LOOP CHECK
-	sleep(20);
+	pWcndManger->loop_check_state = LOOP_CHECK_STATE_WAIT_ACK;
+
+#ifdef USE_MARLIN
+	pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_NONBLOCK_WAIT_MSECS;
+#else
+	if(wcnd_epoll_ctl(pWcndManger, EPOLL_CTL_ADD, pWcndManger->loop_fd, EPOLLIN) < 0)
+		pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_NONBLOCK_WAIT_MSECS;
+	else
+		pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_ACK_TIMEOUT_MSECS;
+#endif
+}
 
+/**
+* read the ack from the loop interface
+* Note: return 0 for OK; return -1 for fail
+*/
+static int loop_check_read(WcndManager *pWcndManger)
+{
+	char buffer[32];
+	int len = 0;
 
-	//special handle for the case that an assert/watchdog assert happens when system up
-	//before WcnManagerService is ready. At this time need to notify assert again
-	if(pWcndManger->is_cp2_error && !pWcndManger->doing_reset)
+	memset(buffer, 0, sizeof(buffer));
+	do {
+		len = read(pWcndManger->loop_fd, buffer, sizeof(buffer) - 1);
+	} while(len < 0 && errno == EINTR);
+
+	if ((len <= 0) || !strstr(buffer,LOOP_TEST_ACK_STR))
 	{
-		char value[PROPERTY_VALUE_MAX] = {'\0'};
+		WCND_LOGE("%s: read %d return %d, buffer:%s,  errno = %s", __func__, pWcndManger->loop_fd , len, buffer, strerror(errno));
+		loop_check_close(pWcndManger);
+		return -1;
+	}
 
-		property_get(WCND_RESET_PROP_KEY, value, "0");
-		int is_reset = atoi(value);
-		if(is_reset)
-		{
-			WCND_LOGD("%s: CP2 assert/watchdog assert, and reset is enabled, but does not doing reset."
-				"So notify loop fail again!!", __FUNCTION__);
+	WCND_LOGD("%s: loop: %s is OK", __func__, pWcndManger->wcn_loop_iface_name);
+	loop_check_close(pWcndManger);
 
-			handle_cp2_loop_check_fail(pWcndManger);
-			//wait 20 seconds for reset
-			sleep(20);
-		}
+	return 0;
+}
+
+/**
+* one loop check is done, check again once or reset the cp2 if it failed.
+*/
+static void loop_check_done(WcndManager *pWcndManger, int result)
+{
+	pWcndManger->loop_check_state = LOOP_CHECK_STATE_IDLE;
+	pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_INTERVAL_MSECS;
+
+	if(!result || pWcndManger->is_cp2_error ||
+		(pWcndManger->state != WCND_STATE_CP2_STARTED))//during loop checking, cp2 exception happens just continue
+	{
+		pWcndManger->loop_check_retry = 0;
+		return;
 	}
 
-	while(1)
+	if(++pWcndManger->loop_check_retry < LOOP_CHECK_COUNT)
 	{
-		usleep(LOOP_CHECK_INTERVAL_MSECS*1000);
+		loop_check_send(pWcndManger);
+		return;
+	}
 
-		if(!pWcndManger->notify_enabled || (pWcndManger->state != WCND_STATE_CP2_STARTED))
-			continue;
+	pWcndManger->loop_check_retry = 0;
 
-		//cp2 exception happens just continue for next poll
-		if(pWcndManger->is_cp2_error)
-		{
-			WCND_LOGD("%s: CP2 exception happened and not reset success!!", __FUNCTION__);
+	WCND_LOGD("%s: loop check fail, going to reset cp2!!", __FUNCTION__);
+	handle_cp2_loop_check_fail(pWcndManger);
 
-			//wait for another 20 seconds for cp2 to be reset success
-			//sleep(20);
+	//wait 20 seconds for reset
+	pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_RESET_WAIT_MSECS;
+}
 
-			continue;
-		}
+/**
+* the ack arrives on the loop interface
+*/
+static void handle_loop_check_event(WcndManager *pWcndManger)
+{
+	if(pWcndManger->loop_check_state != LOOP_CHECK_STATE_WAIT_ACK)
+	{
+		loop_check_close(pWcndManger);
+		return;
+	}
 
-		count = 2;
-		while(count-- > 0)
+	loop_check_done(pWcndManger, loop_check_read(pWcndManger));
+}
+
+/**
+* the loop check deadline is reached
+*/
+static void loop_check_timeout(WcndManager *pWcndManger)
+{
+	switch(pWcndManger->loop_check_state)
+	{
+	case LOOP_CHECK_STATE_BOOT:
+		pWcndManger->loop_check_state = LOOP_CHECK_STATE_IDLE;
+		pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_INTERVAL_MSECS;
+
+		//special handle for the case that an assert/watchdog assert happens when system up
+		//before WcnManagerService is ready. At this time need to notify assert again
+		if(pWcndManger->is_cp2_error && !pWcndManger->doing_reset)
 		{
-#ifdef USE_MARLIN
-			if(is_cp2_alive_ok(pWcndManger, 0) < 0) //marlin cannot support select, so use non-block mode
-#else
-			if(is_cp2_alive_ok(pWcndManger, 1) < 0)
-#endif
-			{
-				if(pWcndManger->is_cp2_error ||
-					(pWcndManger->state != WCND_STATE_CP2_STARTED))//during loop checking, cp2 exception happens just continue
-				{
-					is_loopcheck_fail = 0;
-					break;
-				}
+			char value[PROPERTY_VALUE_MAX] = {'\0'};
 
-				is_loopcheck_fail = 1;
-			}
-			else
+			property_get(WCND_RESET_PROP_KEY, value, "0");
+			int is_reset = atoi(value);
+			if(is_reset)
 			{
-				is_loopcheck_fail = 0;
-				break;
+				WCND_LOGD("%s: CP2 assert/watchdog assert, and reset is enabled, but does not doing reset."
+					"So notify loop fail again!!", __FUNCTION__);
+
+				handle_cp2_loop_check_fail(pWcndManger);
+				//wait 20 seconds for reset
+				pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_RESET_WAIT_MSECS;
 			}
 		}
+		break;
+
+	case LOOP_CHECK_STATE_IDLE:
+		pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_INTERVAL_MSECS;
+
+		if(!pWcndManger->notify_enabled || (pWcndManger->state != WCND_STATE_CP2_STARTED))
+			break;
 
-		if(is_loopcheck_fail)
+		//cp2 exception happens just continue for next poll
+		if(pWcndManger->is_cp2_error)
 		{
-			WCND_LOGD("%s: loop check fail, going to reset cp2!!", __FUNCTION__);
-			handle_cp2_loop_check_fail(pWcndManger);
-			//wait 20 seconds for reset
-			sleep(20);
+			WCND_LOGD("%s: CP2 exception happened and not reset success!!", __FUNCTION__);
+			break;
 		}
 
+		pWcndManger->loop_check_retry = 0;
+		loop_check_send(pWcndManger);
+		break;
+
+	case LOOP_CHECK_STATE_WAIT_ACK:
+#ifdef USE_MARLIN
+		loop_check_done(pWcndManger, loop_check_read(pWcndManger));
+#else
+		WCND_LOGD("loop check loop_fd(%d) TimeOut", pWcndManger->loop_fd);
+		loop_check_close(pWcndManger);
+		loop_check_done(pWcndManger, -1);
+#endif
+		break;
 	}
 }
 
 /**
-* Start thread to loop check if CP2 is alive.
+* Start loop check if CP2 is alive in the main loop.
+* Note: must be called before the main loop is started.
 * return -1 fail;
 */
 static int start_cp2_loop_check(WcndManager *pWcndManger)
@@ -2001,20 +2193,139 @@ static int start_cp2_loop_check(WcndManager *pWcndManger)
 	//if wcn modem is not enabled, just return
 	if(!pWcndManger->is_wcn_modem_enabled) return 0;
 
+	pWcndManger->loop_check_state = LOOP_CHECK_STATE_BOOT;
+	pWcndManger->loop_check_deadline = wcnd_now_ms() + LOOP_CHECK_START_MSECS;
+
+	return 0;
+
+}
+#endif
+
+/// loop check related code end /////
+
+
+///////////////////////////////////////////////////////////////////////////
+
+#define WCND_MAX_EPOLL_EVENTS (WCND_MAX_CLIENT_NUM + 4)
+
+/**
+* return the ms to wait for the nearest deadline, -1 if there is none.
+*/
+static int next_timeout(WcndManager *pWcndManger)
+{
+	long long deadline = -1;
+	long long now;
+
+	if(pWcndManger->cp2_watch_deadline >= 0)
+		deadline = pWcndManger->cp2_watch_deadline;
+
+	if(pWcndManger->loop_check_deadline >= 0 &&
+		(deadline < 0 || pWcndManger->loop_check_deadline < deadline))
+		deadline = pWcndManger->loop_check_deadline;
+
+	if(deadline < 0)
+		return -1;
+
+	now = wcnd_now_ms();
+
+	return (deadline > now) ? (int)(deadline - now) : 0;
+}
+
+static void run_timers(WcndManager *pWcndManger)
+{
+	long long now = wcnd_now_ms();
+
+#ifdef CP2_WATCHER_ENABLE
+	if(pWcndManger->cp2_watch_deadline >= 0 && now >= pWcndManger->cp2_watch_deadline)
+		arm_cp2_watcher(pWcndManger);
+#endif
+
+#ifdef LOOP_CHECK
+	if(pWcndManger->loop_check_deadline >= 0 && now >= pWcndManger->loop_check_deadline)
+		loop_check_timeout(pWcndManger);
+#endif
+}
+
+/**
+* The main loop of wcnd, all on one epoll set:
+* 1. accept connection from clients, read their cmds and send their queued messages.
+* 2. read the cmds sent to self.
+*    the cmds are handled by the worker threads, the loop never blocks on them.
+* 3. listen on the CP2 assert/watchdog interface to detect CP2 exception.
+* 4. loop check if CP2 is alive.
+*/
+static void *wcnd_loop_thread(void *arg)
+{
+	WcndManager *pWcndManger = (WcndManager *)arg;
+	struct epoll_event events[WCND_MAX_EPOLL_EVENTS];
+
+	if(!pWcndManger)
+	{
+		WCND_LOGD("%s: UNEXCPET NULL WcndManager", __FUNCTION__);
+		exit(-1);
+	}
+
+	while(1)
+	{
+		int i = 0;
+		int rc = 0;
+
+		rc = epoll_wait(pWcndManger->epoll_fd, events, WCND_MAX_EPOLL_EVENTS, next_timeout(pWcndManger));
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			WCND_LOGD("epoll_wait failed (%s) epoll_fd = %d", strerror(errno), pWcndManger->epoll_fd);
+			sleep(1);
+			continue;
+		}
+
+		for (i = 0; i < rc; i++)
+		{
+			int fd = events[i].data.fd;
+
+			if (fd == pWcndManger->listen_fd)
+				accept_client(pWcndManger);
+			else if (fd == pWcndManger->selfcmd_sockets[1])
+				process_active_client_fd(pWcndManger, fd);
+#ifdef CP2_WATCHER_ENABLE
+			else if (fd == pWcndManger->assert_fd || fd == pWcndManger->watchdog_fd)
+				handle_cp2_watch_event(pWcndManger, fd);
+#endif
+#ifdef LOOP_CHECK
+			else if (fd == pWcndManger->loop_fd)
+				handle_loop_check_event(pWcndManger);
+#endif
+			else
+				handle_client_event(pWcndManger, fd, events[i].events);
+		}
+
+		run_timers(pWcndManger);
+	}
+
+	return NULL;
+}
+
+/**
+* Start the main loop thread.
+* return -1 fail;
+*/
+static int start_event_loop(WcndManager *pWcndManger)
+{
+	if(!pWcndManger) return -1;
+
 	pthread_t thread_id;
 
-	if (pthread_create(&thread_id, NULL, cp2_loop_check_thread, pWcndManger))
+	if (pthread_create(&thread_id, NULL, wcnd_loop_thread, pWcndManger))
 	{
-		WCND_LOGE("start_cp2_loop_check: pthread_create (%s)", strerror(errno));
+		WCND_LOGE("start_event_loop: pthread_create (%s)", strerror(errno));
 		return -1;
 	}
 
 	return 0;
 
 }
-#endif
-
-/// loop check related code end /////
 
 
 ///////////////////////////////////////////////////////////////////////////
@@ -2255,12 +2566,6 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-	if(start_client_listener(pWcndManger) < 0)
-	{
-		WCND_LOGE("Start client listener Fail!!!");
-		return -1;
-	}
-
 #ifdef CP2_WATCHER_ENABLE
 	if(start_cp2_listener(pWcndManger) < 0)
 	{
@@ -2269,6 +2574,13 @@ int main(int argc, char *argv[])
 	}
 #endif
 
+#ifdef LOOP_CHECK
+	if(start_cp2_loop_check(pWcndManger) < 0)
+	{
+		WCND_LOGE("Start CP2loop_check Fail!!!");
+	}
+#endif
+
 	//Start engineer service , such as for get CP2 log from PC.
 	start_engineer_service(pWcndManger);
 
@@ -2280,6 +2592,13 @@ int main(int argc, char *argv[])
 	wcnd_register_cmdexecuter(pWcndManger, &wcn_eng_cmdexecuter);
 #endif
 
+	//the main loop owns the clients and the cp2 watcher/loop check from now on
+	if(start_event_loop(pWcndManger) < 0)
+	{
+		WCND_LOGE("Start event loop Fail!!!");
+		return -1;
+	}
+
 
 	//first check if CP2 alive, then config cp2 at bootup
 	if(!pWcndManger->is_eng_mode_only && pWcndManger->state == WCND_STATE_CP2_STARTED
@@ -2318,14 +2637,6 @@ int main(int argc, char *argv[])
 	}
 
 
-#ifdef LOOP_CHECK
-	if(start_cp2_loop_check(pWcndManger) < 0)
-	{
-		WCND_LOGE("Start CP2loop_check Fail!!!");
-	}
-#endif
-
-
 	//get CP2 version and save it
 	store_cp2_version_info(pWcndManger);
 
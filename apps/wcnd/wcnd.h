@@ -149,6 +149,7 @@
 #define WCND_CP2_RESET_END_STRING "WCN-CP2-RESET-END"
 #define WCND_CP2_ALIVE_STRING "WCN-CP2-ALIVE"
 #define WCND_CP2_CLOSED_STRING "WCN-CP2-CLOSED"
+#define WCND_TEST_NOTIFY_STRING "WCN-TEST-NOTIFY"
 
 
 #define WCND_CP2_DEFAULT_CP2_VERSION_INFO "Fail: UNKNOW VERSION"
@@ -158,18 +159,35 @@ typedef struct structWcndWorker {
 	void *ctx;
 	void *data;
 	int replyto_fd; //fd to replay message
+	unsigned int replyto_gen; //generation of the client on replyto_fd when the cmd was read
 	struct structWcndWorker *next;
 } WcndWorker;
 
+//the queue a worker is put to, each queue has its own thread
+#define WCND_WORKER_ENG 0 //engineer mode cmds
+#define WCND_WORKER_CMD 1 //other client cmds, kept off the main loop
+#define WCND_WORKER_NUM 2
+
 
 typedef struct structWcndMessage{
 	int event;
 	int replyto_fd; //fd to replay message
 }WcndMessage;
 
+//bytes that may wait for a client that does not read, the client is dropped beyond that
+#define WCND_CLIENT_WQ_SIZE	(2048)
+
 typedef struct structWcndClient{
 	int sockfd;
 	int type;//to identify if it is a socket for sending cmds or just for listening event
+
+	//new for every connection taken into the slot, a reply for an older one is dropped
+	unsigned int gen;
+
+	//messages not taken by the non-blocking socket yet, sent by the main loop on EPOLLOUT
+	int wq_len;
+	int wq_armed;//EPOLLOUT is being watched
+	char wq_buf[WCND_CLIENT_WQ_SIZE];
 }WcndClient;
 
 typedef int (*cmd_handler)(int client_fd, int argc, char* argv[]);
@@ -179,7 +197,7 @@ typedef struct structWcnCmdExecuter{
 	int (*runcommand)(int client_fd, int argc, char* argv[]);
 }WcnCmdExecuter;
 
-#define WCND_MAX_CLIENT_NUM	(10)
+#define WCND_MAX_CLIENT_NUM	(32)
 
 #define WCND_MAX_IFACE_NAME_SIZE		(32)
 
@@ -195,9 +213,26 @@ typedef struct structWcndManager
 	//to store the sockets that connect from the clients
 	WcndClient clients[WCND_MAX_CLIENT_NUM];
 
+	//last generation given to a client, 0 is never used
+	unsigned int client_gen;
+
 	//the server socket to listen for client to connect
 	int listen_fd;
 
+	//epoll set of the main loop, which serves the clients and watches CP2
+	int epoll_fd;
+
+	//cp2 assert/watchdog interfaces, and when to (re)open or re-enable them (CLOCK_MONOTONIC ms)
+	int assert_fd;
+	int watchdog_fd;
+	long long cp2_watch_deadline;
+
+	//cp2 loop check, run by the main loop
+	int loop_fd;
+	int loop_check_state;
+	int loop_check_retry;
+	long long loop_check_deadline;
+
 	char wcn_assert_iface_name[WCND_MAX_IFACE_NAME_SIZE];
 	char wcn_loop_iface_name[WCND_MAX_IFACE_NAME_SIZE];
 	char wcn_watchdog_iface_name[WCND_MAX_IFACE_NAME_SIZE];
@@ -262,6 +297,9 @@ typedef struct structWcndManager
 	//engineer mode cmds queue
 	WcndWorker *eng_cmd_queue;
 
+	//other client cmds queue
+	WcndWorker *cmd_queue;
+
 	//to identify if the wcn modem (CP2) is enabled or not.
 	//to check property "ro.modem.wcn.enable"
 	int is_wcn_modem_enabled;
@@ -301,6 +339,8 @@ int wcnd_do_wcn_reset_process(WcndManager *pWcndManger);
 int wcnd_runcommand(int client_fd, int argc, char* argv[]);
 int wcnd_process_atcmd(int client_fd, char *atcmd_str, WcndManager *pWcndManger);
 int wcnd_send_selfcmd(WcndManager *pWcndManger, char *cmd);
+int wcnd_send_to_client(WcndManager *pWcndManger, int client_fd, char *buf, int len);
+WcndClient *wcnd_find_reply_client(WcndManager *pWcndManger, int client_fd);
 
 
 int wcnd_reboot_cp2(WcndManager *pWcndManger);
@@ -315,7 +355,8 @@ int wcnd_config_cp2_bootup(WcndManager *pWcndManger);
 
 
 int wcnd_worker_init(WcndManager *pWcndManger);
-int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char *data, int fd, int type);
+int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char *data, int fd, unsigned int gen, int type);
+int wcnd_worker_reply_gen(int fd, unsigned int *gen);
 int wcnd_woker_handle(void *worker);
 
 
@@ -160,7 +160,7 @@ static int before_send_atcmd(int client_fd, char *atcmd_str, WcndManager *pWcndM
 			//send back the response
 			if(client_fd > 0)
 			{
-				int ret = write(client_fd, buffer, strlen(buffer)+1);
+				int ret = wcnd_send_to_client(pWcndManger, client_fd, buffer, strlen(buffer)+1);
 				if(ret < 0)
 				{
 					WCND_LOGE("write %s to client_fd:%d fail (error:%s)", buffer, client_fd, strerror(errno));
@@ -338,7 +338,7 @@ try_again:
 	}
 
 	//send back the response
-	int ret = write(client_fd, buffer, strlen(buffer)+1);
+	int ret = wcnd_send_to_client(pWcndManger, client_fd, buffer, strlen(buffer)+1);
 	if(ret < 0)
 	{
 		WCND_LOGE("write %s to client_fd:%d fail (error:%s)", buffer, client_fd, strerror(errno));
@@ -382,6 +382,22 @@ int wcnd_runcommand(int client_fd, int argc, char* argv[])
 		WCND_LOGD("%s: do nothing for test cmd", __FUNCTION__);
 		wcnd_send_back_cmd_result(client_fd, NULL, 1);
 	}
+	else if(!strcmp(argv[0], "notifytest"))
+	{
+		//send a notify to all the notify clients, to measure the notify fan-out
+		if(!pWcndManger->is_in_userdebug)
+		{
+			wcnd_send_back_cmd_result(client_fd, "Not support cmd", 0);
+		}
+		else
+		{
+			char buffer[255];
+
+			snprintf(buffer, sizeof(buffer), "%s %s", WCND_TEST_NOTIFY_STRING, (argc > 1) ? argv[1] : "0");
+			wcnd_send_back_cmd_result(client_fd, NULL, 1);
+			wcnd_send_notify_to_client(pWcndManger, buffer, WCND_CLIENT_TYPE_NOTIFY);
+		}
+	}
 	else if(strstr(argv[0], "at+")) //at cmd
 	{
 		WCND_LOGD("%s: AT cmd(%s)(len=%d)", __FUNCTION__, argv[0], strlen(argv[0]));
@@ -389,17 +405,12 @@ int wcnd_runcommand(int client_fd, int argc, char* argv[])
 	}
 	else if(strstr(argv[0], "BT") || strstr(argv[0], "WIFI")) //bt/wifi cmd
 	{
-		int i = 0;
+		WcndClient *client;
 		//to set the type to be cmd
 		pthread_mutex_lock(&pWcndManger->clients_lock);
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			if(pWcndManger->clients[i].sockfd == client_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, client_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 		wcn_process_btwificmd(client_fd, argv[0], pWcndManger);
@@ -434,18 +445,13 @@ int wcnd_runcommand(int client_fd, int argc, char* argv[])
 	else if(!strcmp(argv[0], WCND_CMD_CP2_POWER_ON))
 	{
 		WcndMessage message;
-		int i = 0;
+		WcndClient *client;
 
 		//to set the type to be cmd
 		pthread_mutex_lock(&pWcndManger->clients_lock);
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			if(pWcndManger->clients[i].sockfd == client_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, client_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 #ifdef WCND_STATE_MACHINE_ENABLE
@@ -482,18 +488,13 @@ int wcnd_runcommand(int client_fd, int argc, char* argv[])
 	else if(!strcmp(argv[0], WCND_CMD_CP2_POWER_OFF))
 	{
 		WcndMessage message;
-		int i = 0;
+		WcndClient *client;
 
 		//to set the type to be cmd
 		pthread_mutex_lock(&pWcndManger->clients_lock);
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			if(pWcndManger->clients[i].sockfd == client_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, client_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 #ifdef WCND_STATE_MACHINE_ENABLE
@@ -257,7 +257,7 @@ static void wcn_state_cp2_started(WcndManager *pWcndManger, WcndMessage *pMessag
 
 static void wcn_state_cp2_assert(WcndManager *pWcndManger, WcndMessage *pMessage)
 {
-	int i = 0;
+	WcndClient *client;
 
 	if(!pWcndManger || !pMessage) return;
 
@@ -282,14 +282,9 @@ static void wcn_state_cp2_assert(WcndManager *pWcndManger, WcndMessage *pMessage
 		pthread_mutex_lock(&pWcndManger->clients_lock);
 
 		//save the pending message
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			 if(pWcndManger->clients[i].sockfd == pMessage->replyto_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD_SUBTYPE_CLOSE;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, pMessage->replyto_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD_SUBTYPE_CLOSE;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 		wcnd_send_notify_to_client(pWcndManger, WCND_CMD_RESPONSE_STRING" OK", WCND_CLIENT_TYPE_CMD_SUBTYPE_CLOSE);
@@ -307,14 +302,9 @@ static void wcn_state_cp2_assert(WcndManager *pWcndManger, WcndMessage *pMessage
 		pthread_mutex_lock(&pWcndManger->clients_lock);
 
 		//save the pending message
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			 if(pWcndManger->clients[i].sockfd == pMessage->replyto_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD_SUBTYPE_OPEN;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, pMessage->replyto_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD_SUBTYPE_OPEN;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 
@@ -354,7 +344,7 @@ static void wcn_state_cp2_assert(WcndManager *pWcndManger, WcndMessage *pMessage
 
 static void wcn_state_cp2_stopping(WcndManager *pWcndManger, WcndMessage *pMessage)
 {
-	int i = 0;
+	WcndClient *client;
 
 	if(!pWcndManger || !pMessage) return;
 
@@ -379,14 +369,9 @@ static void wcn_state_cp2_stopping(WcndManager *pWcndManger, WcndMessage *pMessa
 		pthread_mutex_lock(&pWcndManger->clients_lock);
 
 		//save the pending message
-		for (i = 0; i < WCND_MAX_CLIENT_NUM; i++)
-		{
-			 if(pWcndManger->clients[i].sockfd == pMessage->replyto_fd)
-			{
-				pWcndManger->clients[i].type = WCND_CLIENT_TYPE_CMD_PENDING;
-				break;
-			}
-		}
+		client = wcnd_find_reply_client(pWcndManger, pMessage->replyto_fd);
+		if(client)
+			client->type = WCND_CLIENT_TYPE_CMD_PENDING;
 		pthread_mutex_unlock(&pWcndManger->clients_lock);
 
 		pWcndManger->pending_events |= pMessage->event ;
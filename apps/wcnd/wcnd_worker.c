@@ -24,14 +24,36 @@
 * Note: if need, the worker threads can be extended to a thread pool.
 */
 
+typedef struct structWcndWorkerThread {
+	WcndManager *pWcndManger;
+	int type;
+} WcndWorkerThread;
 
+static WcndWorkerThread worker_threads[WCND_WORKER_NUM];
+
+//the worker a thread is running, to check whom its replies go to
+static pthread_key_t current_worker_key;
+
+/*
+* the queue of the workers of 'type'.
+*/
+static WcndWorker **worker_queue(WcndManager *pWcndManger, int type)
+{
+	if(type == WCND_WORKER_ENG)
+		return &pWcndManger->eng_cmd_queue;
+
+	return &pWcndManger->cmd_queue;
+}
 
 /*
-* The thread to handle the engineer command
+* The thread to handle the commands of one queue, so that a command that
+* sleeps or retries does not hold up the main loop nor the other queue.
 */
-static void* eng_worker_thread(void *arg)
+static void* worker_thread(void *arg)
 {
-	WcndManager *pWcndManger = (WcndManager *)arg;
+	WcndWorkerThread *pThread = (WcndWorkerThread *)arg;
+	WcndManager *pWcndManger = pThread->pWcndManger;
+	WcndWorker **queue = worker_queue(pWcndManger, pThread->type);
 	int retval = 0;
 	WcndWorker *pWorker = NULL;
 
@@ -44,7 +66,7 @@ static void* eng_worker_thread(void *arg)
 			WCND_LOGE("!Fatal: mutex lock failed\n");
 		}
 
-		while (pWcndManger->eng_cmd_queue == NULL)
+		while (*queue == NULL)
 		{
 			/* Sleep until be wakeup */
 			retval = pthread_cond_wait(&(pWcndManger->worker_cond),
@@ -52,11 +74,11 @@ static void* eng_worker_thread(void *arg)
 
 		}
 
-		pWorker = pWcndManger->eng_cmd_queue;
+		pWorker = *queue;
 		if(pWorker)
-			pWcndManger->eng_cmd_queue = pWorker->next;
+			*queue = pWorker->next;
 		else
-			pWcndManger->eng_cmd_queue = NULL;
+			*queue = NULL;
 
 		if (pthread_mutex_unlock(&(pWcndManger->worker_lock)) != 0)
 		{
@@ -66,8 +88,10 @@ static void* eng_worker_thread(void *arg)
 
 		if (pWorker)
 		{
+			pthread_setspecific(current_worker_key, pWorker);
 			if(pWorker->handler)
 				pWorker->handler(pWorker);
+			pthread_setspecific(current_worker_key, NULL);
 
 			if(pWorker->data) free(pWorker->data);
 
@@ -76,19 +100,26 @@ static void* eng_worker_thread(void *arg)
 		}
 	}
 
-	WCND_LOGE("eng_worker_thread exit unexceptly!!");
+	WCND_LOGE("worker_thread %d exit unexceptly!!", pThread->type);
 	return NULL;	
 }
 
 /*
-* To init a worker threads.
-* Now noly engineer mode work thread is needed.
+* To init the worker threads, one for the engineer mode cmds and one for
+* the other client cmds.
 */
 int wcnd_worker_init(WcndManager *pWcndManger)
 {
+	int i = 0;
+
 	if(!pWcndManger) return -1;
 
 	pthread_mutex_init(&pWcndManger->worker_lock, NULL);
+	if (pthread_key_create(&current_worker_key, NULL) != 0)
+	{
+		WCND_LOGE("wcnd_worker_init: pthread_key_create (%s)", strerror(errno));
+		return -1;
+	}
 	if (pthread_cond_init(&(pWcndManger->worker_cond), NULL) != 0)
 	{
 		WCND_LOGE("wcnd_worker_init: pthread_cond_init (%s)", strerror(errno));
@@ -96,23 +127,28 @@ int wcnd_worker_init(WcndManager *pWcndManger)
 	}
 
 
-	pthread_t thread_id;
-
-	if (pthread_create(&thread_id, NULL, eng_worker_thread, pWcndManger))
+	for (i = 0; i < WCND_WORKER_NUM; i++)
 	{
-		WCND_LOGE("wcnd_worker_init: pthread_create (%s)", strerror(errno));
-		return -1;
+		pthread_t thread_id;
+
+		worker_threads[i].pWcndManger = pWcndManger;
+		worker_threads[i].type = i;
+
+		if (pthread_create(&thread_id, NULL, worker_thread, &worker_threads[i]))
+		{
+			WCND_LOGE("wcnd_worker_init: pthread_create (%s)", strerror(errno));
+			return -1;
+		}
 	}
 
 	return 0;
 }
 
 /*
-* To put a worker to the correct queue specified by 'type' (Now 'type' is not used, because
-* only engineer mode is needed currently).
+* To put a worker to the correct queue specified by 'type' (WCND_WORKER_ENG or WCND_WORKER_CMD).
 * Then wake up the thread to do it.
 */
-int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char *data, int fd, int type)
+int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char *data, int fd, unsigned int gen, int type)
 {
 	WcndWorker *pNewWorker = NULL;
 
@@ -140,13 +176,15 @@ int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char
 	pNewWorker->ctx = pWcndManger;
 	pNewWorker->data = strdup(data);
 	pNewWorker->replyto_fd = fd;
+	pNewWorker->replyto_gen = gen;
 	pNewWorker->next = NULL;
 
-	WcndWorker *item = pWcndManger->eng_cmd_queue;
+	WcndWorker **queue = worker_queue(pWcndManger, type);
+	WcndWorker *item = *queue;
 
 	if (item == NULL)
 	{
-		pWcndManger->eng_cmd_queue = pNewWorker;
+		*queue = pNewWorker;
 	}
 	else
 	{
@@ -155,7 +193,8 @@ int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char
 		item->next = pNewWorker;
 	}
 
-	pthread_cond_signal(&(pWcndManger->worker_cond));
+	//both threads wait on worker_cond, wake them both so the one of 'type' is not missed
+	pthread_cond_broadcast(&(pWcndManger->worker_cond));
 
 	if (pthread_mutex_unlock(&(pWcndManger->worker_lock)) != 0) {
 		WCND_LOGE("Mutex unlock failed!");
@@ -165,7 +204,16 @@ int wcnd_worker_dispatch(WcndManager *pWcndManger, int (*handler)(void *), char
 
 }
 
+/*
+* When the calling thread runs a worker for the cmd read from fd, get the
+* generation the client on fd had then and return 1, else return 0.
+*/
+int wcnd_worker_reply_gen(int fd, unsigned int *gen)
+{
+	WcndWorker *pWorker = (WcndWorker *)pthread_getspecific(current_worker_key);
 
+	if(!pWorker || pWorker->replyto_fd != fd) return 0;
 
-
-
+	*gen = pWorker->replyto_gen;
+	return 1;
+}
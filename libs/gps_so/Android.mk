@@ -3,7 +3,8 @@ LOCAL_PATH := $(call my-dir)
 
 include $(CLEAR_VARS)
 
-LOCAL_SRC_FILES := gps_pc_mode.c
+LOCAL_SRC_FILES := gps_pc_mode.c \
+	gps_nmea.c
 
 LOCAL_MODULE := libgpspc
 LOCAL_MODULE_TAGS := debug
@@ -0,0 +1,307 @@
+///============================================================================
+/// Copyright 2012-2014  spreadtrum  --
+/// This program be used, duplicated, modified or distributed
+/// pursuant to the terms and conditions of the Apache 2 License.
+/// ---------------------------------------------------------------------------
+/// file gps_nmea.c
+/// single pass NMEA reader for the engineering mode GPS library
+///============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gps_nmea.h"
+
+enum {
+	NMEA_IDLE = 0,
+	NMEA_BODY,
+	NMEA_CKSUM
+};
+
+struct NmeaSentence {
+	const char* id;
+	void (*field)(NmeaReader* r, const char* p, int len);
+	void (*done)(NmeaReader* r);
+};
+
+////////////////////////////////NUMBERS///////////////////////////////////////////
+
+int nmea_str2int(const char* p, const char* end)
+{
+	int result = 0;
+
+	if (p >= end)
+		return -1;
+
+	for ( ; p < end; p++) {
+		int c = *p - '0';
+		if ((unsigned)c >= 10)
+			return -1;
+		result = result*10 + c;
+	}
+	return result;
+}
+
+static const double s_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+	1e21, 1e22
+};
+
+/*
+ * Plain decimals are read as an integer mantissa and a count of
+ * fraction digits. While the mantissa stays below 2^53 and the scale
+ * within 1e22 both are exact doubles, so the one division rounds the
+ * same way strtod() does. Anything else goes through strtod().
+ */
+double nmea_str2float(const char* p, const char* end)
+{
+	const char* s = p;
+	long long mant = 0;
+	int frac = -1;
+	int neg = 0;
+	char temp[NMEA_MAX_FIELD + 1];
+	int len = end - p;
+
+	if (len <= 0)
+		return 0.;
+
+	if (*s == '-' || *s == '+') {
+		neg = (*s == '-');
+		s++;
+	}
+	for ( ; s < end; s++) {
+		int c = *s - '0';
+		if ((unsigned)c < 10) {
+			mant = mant*10 + c;
+			if (mant >= (1LL << 53))
+				goto Slow;
+			if (frac >= 0)
+				frac++;
+		} else if (*s == '.' && frac < 0) {
+			frac = 0;
+		} else {
+			goto Slow;
+		}
+	}
+	if (frac > 22)
+		goto Slow;
+	if (frac > 0)
+		return neg ? -(mant / s_pow10[frac]) : mant / s_pow10[frac];
+	return neg ? -(double)mant : (double)mant;
+
+Slow:
+	if (len >= (int)sizeof(temp))
+		return 0.;
+	memcpy(temp, p, len);
+	temp[len] = 0;
+	return strtod(temp, NULL);
+}
+
+static int nmea_hex(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+////////////////////////////////$PCGDS///////////////////////////////////////////
+
+static const char* const s_pcgds_items[NMEA_PCGDS_MAX] = {
+	"CWCN0",
+	"TSXTEMP",
+	"TCXO",
+};
+
+/* (name[1] ^ len) & 7 keeps the $PCGDS item names apart */
+#define PCGDS_HASH(p, len)  (((p)[1] ^ (len)) & 7)
+static signed char s_pcgds_slot[8];
+
+static void nmea_pcgds_field(NmeaReader* r, const char* p, int len)
+{
+	int i;
+
+	switch (r->field) {
+	case 1:
+		r->item = -1;
+		if (len < 2)
+			break;
+		i = s_pcgds_slot[PCGDS_HASH(p, len)];
+		if (i >= 0 && (int)strlen(s_pcgds_items[i]) == len
+		    && !memcmp(p, s_pcgds_items[i], len))
+			r->item = i;
+		break;
+	case 2:
+		if (r->item < 0 || len == 0)
+			break;
+		if (r->item == NMEA_PCGDS_CWCN0)
+			r->ivalue = nmea_str2int(p, p + len);
+		else
+			r->fvalue = nmea_str2float(p, p + len);
+		r->has_value = 1;
+		break;
+	}
+}
+
+static void nmea_pcgds_done(NmeaReader* r)
+{
+	if (r->item >= 0 && r->has_value && r->pcgds_cb)
+		r->pcgds_cb(r, r->item, r->ivalue, r->fvalue);
+}
+
+////////////////////////////////DISPATCH///////////////////////////////////////////
+
+static const NmeaSentence s_sentences[] = {
+	{ "PCGDS", nmea_pcgds_field, nmea_pcgds_done },
+};
+
+#define NMEA_ID_LEN        5
+#define NMEA_HASH_SIZE     16
+#define NMEA_ID_HASH(p)    ((((p)[0] ^ (p)[1]) + ((p)[2] << 1) + (p)[3] + ((p)[4] << 2)) & (NMEA_HASH_SIZE - 1))
+static const NmeaSentence* s_dispatch[NMEA_HASH_SIZE];
+static int s_dispatch_ready;
+
+static void nmea_dispatch_init(void)
+{
+	unsigned int i;
+
+	memset(s_pcgds_slot, -1, sizeof(s_pcgds_slot));
+	for (i = 0; i < NMEA_PCGDS_MAX; i++) {
+		const char* name = s_pcgds_items[i];
+		s_pcgds_slot[PCGDS_HASH(name, (int)strlen(name))] = i;
+	}
+	for (i = 0; i < sizeof(s_sentences) / sizeof(s_sentences[0]); i++)
+		s_dispatch[NMEA_ID_HASH(s_sentences[i].id)] = &s_sentences[i];
+	s_dispatch_ready = 1;
+}
+
+static const NmeaSentence* nmea_lookup(const char* p, int len)
+{
+	const NmeaSentence* s;
+
+	if (len < NMEA_ID_LEN)
+		return NULL;
+	s = s_dispatch[NMEA_ID_HASH(p)];
+	if (s && !memcmp(p, s->id, NMEA_ID_LEN))
+		return s;
+	return NULL;
+}
+
+////////////////////////////////READER///////////////////////////////////////////
+
+static void nmea_start(NmeaReader* r)
+{
+	r->state = NMEA_BODY;
+	r->cksum = 0;
+	r->cksum_rx = 0;
+	r->cksum_digits = 0;
+	r->field = 0;
+	r->len = 0;
+	r->truncated = 0;
+	r->sentence = NULL;
+	r->item = -1;
+	r->has_value = 0;
+	r->ivalue = 0;
+	r->fvalue = 0.;
+}
+
+static void nmea_end_field(NmeaReader* r)
+{
+	if (r->field == 0)
+		r->sentence = nmea_lookup(r->field_buf, r->len);
+	else if (r->sentence)
+		r->sentence->field(r, r->field_buf, r->len);
+	r->field++;
+	r->len = 0;
+}
+
+static void nmea_finish(NmeaReader* r, int has_cksum)
+{
+	r->state = NMEA_IDLE;
+	r->sentences++;
+
+	if (has_cksum && (r->cksum_digits != 2 || r->cksum_rx != r->cksum)) {
+		r->bad_checksum++;
+		return;
+	}
+	if (r->sentence && !r->truncated) {
+		r->dispatched++;
+		r->sentence->done(r);
+	}
+}
+
+void nmea_reader_init(NmeaReader* r, nmea_pcgds_cb cb, void* opaque)
+{
+	if (!s_dispatch_ready)
+		nmea_dispatch_init();
+
+	memset(r, 0, sizeof(NmeaReader));
+	r->state = NMEA_IDLE;
+	r->item = -1;
+	r->pcgds_cb = cb;
+	r->opaque = opaque;
+}
+
+void nmea_reader_feed(NmeaReader* r, const char* p, int len)
+{
+	const char* end = p + len;
+
+	for ( ; p < end; p++) {
+		char c = *p;
+
+		switch (r->state) {
+		case NMEA_IDLE:
+			if (c == '\r' || c == '\n')
+				break;
+			nmea_start(r);
+			// the initial '$' is optional
+			if (c == '$')
+				break;
+			/* fall through */
+		case NMEA_BODY:
+			if (c == '$' || c == '\r' || c == '\n') {
+				// sentence without checksum
+				nmea_end_field(r);
+				nmea_finish(r, 0);
+				if (c == '$')
+					nmea_start(r);
+				break;
+			}
+			if (c == '*') {
+				nmea_end_field(r);
+				r->state = NMEA_CKSUM;
+				break;
+			}
+			r->cksum ^= (unsigned char)c;
+			if (c == ',') {
+				nmea_end_field(r);
+				break;
+			}
+			// only the ID and fields of handled sentences are kept
+			if (r->field != 0 && !r->sentence)
+				break;
+			if (r->len < NMEA_MAX_FIELD)
+				r->field_buf[r->len++] = c;
+			else
+				r->truncated = 1;
+			break;
+		case NMEA_CKSUM: {
+			int h = nmea_hex(c);
+			if (h >= 0) {
+				r->cksum_rx = (r->cksum_rx << 4) | h;
+				if (++r->cksum_digits == 2)
+					nmea_finish(r, 1);
+				break;
+			}
+			nmea_finish(r, 1);
+			if (c == '$')
+				nmea_start(r);
+			break;
+		}
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef GPS_NMEA_H
+#define GPS_NMEA_H
+
+/* longest field kept, longer ones are cut and make the sentence invalid */
+#define NMEA_MAX_FIELD  32
+
+enum {
+	NMEA_PCGDS_CWCN0 = 0,
+	NMEA_PCGDS_TSXTEMP,
+	NMEA_PCGDS_TCXO,
+	NMEA_PCGDS_MAX
+};
+
+typedef struct NmeaReader NmeaReader;
+typedef struct NmeaSentence NmeaSentence;
+
+/* called for a complete $PCGDS sentence with a valid checksum */
+typedef void (*nmea_pcgds_cb)(NmeaReader* r, int item, int ivalue, double fvalue);
+
+struct NmeaReader {
+	int            state;
+	unsigned char  cksum;
+	unsigned char  cksum_rx;
+	int            cksum_digits;
+	int            field;
+	int            len;
+	int            truncated;
+	char           field_buf[NMEA_MAX_FIELD];
+	const NmeaSentence* sentence;
+
+	/* $PCGDS state */
+	int            item;
+	int            has_value;
+	int            ivalue;
+	double         fvalue;
+
+	nmea_pcgds_cb  pcgds_cb;
+	void*          opaque;
+
+	/* statistics */
+	unsigned int   sentences;
+	unsigned int   dispatched;
+	unsigned int   bad_checksum;
+};
+
+/*
+ * Streaming NMEA reader. Data can be fed in any pieces, a sentence may
+ * span several buffers and a buffer may hold several sentences. Every
+ * byte is looked at once: the checksum is accumulated on the way, the
+ * sentence ID is dispatched through a perfect hash table as soon as the
+ * first field ends, and fields of sentences nobody handles are skipped
+ * without being copied.
+ */
+extern void nmea_reader_init(NmeaReader* r, nmea_pcgds_cb cb, void* opaque);
+extern void nmea_reader_feed(NmeaReader* r, const char* p, int len);
+
+extern int nmea_str2int(const char* p, const char* end);
+extern double nmea_str2float(const char* p, const char* end);
+
+#endif
@@ -35,6 +35,7 @@
 #include <dlfcn.h>
 
 #include "gps_pc_mode.h"
+#include "gps_nmea.h"
 
 // GPS PC MODE
 #define INIT_MODE  0x07
@@ -83,60 +84,10 @@ static int chip_id = 0;
 static char *version = "VERSION: 2015-07-22\r\n";
 
 ////////////////////////////////NMEA PARSE START///////////////////////////////////////////
-#define TOKEN_LEN(tok)  (tok.end>tok.p?tok.end-tok.p:0)
-#define  MAX_NMEA_TOKENS  32
 int cwcn_value = 0;
 double tsx_value = 0;
 double tcxo_value = 0;
-
-typedef struct {
-    const char*  p;
-    const char*  end;
-} Token;
-
-typedef struct {
-    int     count;
-    Token   tokens[ MAX_NMEA_TOKENS ];
-} NmeaTokenizer;
-
-static int str2int( const char*  p, const char*  end )
-{
-    int   result = 0;
-    int   len    = end - p;
-
-    for ( ; len > 0; len--, p++ )
-    {
-        int  c;
-
-        if (p >= end)
-            goto Fail;
-
-        c = *p - '0';
-        if ((unsigned)c >= 10)
-            goto Fail;
-
-        result = result*10 + c;
-    }
-    return  result;
-
-Fail:
-    return -1;
-}
-
-static double str2float( const char*  p, const char*  end )
-{
-    int   result = 0;
-    int   len    = end - p;
-    char  temp[16];
-
-    if (len >= (int)sizeof(temp))
-        return 0.;
-    if(len == 0)
-        return 0.;
-    memcpy( temp, p, len );
-    temp[len] = 0;
-    return strtod( temp, NULL );
-}
+static NmeaReader s_nmea_reader;
 
 static int strhex2int( const char*  p, int len )
 {
@@ -177,151 +128,37 @@ Fail:
 	return -1;
 }
 
-static int nmea_tokenizer_init( NmeaTokenizer*  t, const char*  p, const char*  end )
-{
-    int    count = 0;
-    char*  q;
-
-    // the initial '$' is optional
-    if (p < end && p[0] == '$')
-        p += 1;
-
-    // remove trailing newline
-    if (end > p && end[-1] == '\n') {
-        end -= 1;
-        if (end > p && end[-1] == '\r')
-            end -= 1;
-    }
-
-    // get rid of checksum at the end of the sentecne
-    if (end >= p+3 && end[-3] == '*') {
-        end -= 3;
-    }
-
-    while (p < end) {
-        const char*  q = p;
-
-        q = memchr(p, ',', end-p);
-        if (q == NULL)
-            q = end;
-
-        if (q >= p) {
-            if (count < MAX_NMEA_TOKENS) {
-                t->tokens[count].p   = p;
-                t->tokens[count].end = q;
-                count += 1;
-            }
-        }
-        if (q < end)
-            q += 1;
-
-        p = q;
-    }
-
-    t->count = count;
-    return count;
-}
-
-static Token  nmea_tokenizer_get( NmeaTokenizer*  t, int  index )
+static void nmea_pcgds_update(NmeaReader* r, int item, int ivalue, double fvalue)
 {
-	Token  tok;
-	static const char*  dummy = "";
-
-	if (index < 0 || index >= t->count) 
-	{
-		tok.p = tok.end = dummy;
-	} 
-	else
-	{
-		tok = t->tokens[index];
+	switch (item) {
+	case NMEA_PCGDS_CWCN0:
+		D("PCGDS ==>> CWCN0\n");
+		pthread_mutex_lock(&mutex_cwcn);
+		cwcn_value = ivalue;
+		D("nmea_update_cwcn: value=%d \n", cwcn_value);
+		pthread_mutex_unlock(&mutex_cwcn);
+		break;
+	case NMEA_PCGDS_TSXTEMP:
+		D("PCGDS ==>> TSXTEMP\n");
+		pthread_mutex_lock(&mutex_tsx);
+		tsx_value = fvalue;
+		D("nmea_update_tsx: value=%f \n", tsx_value);
+		pthread_mutex_unlock(&mutex_tsx);
+		break;
+	case NMEA_PCGDS_TCXO:
+		D("PCGDS ==>> TCXO\n");
+		pthread_mutex_lock(&mutex_tcxo);
+		tcxo_value = fvalue;
+		D("nmea_update_tcxo: value=%f \n", tcxo_value);
+		pthread_mutex_unlock(&mutex_tcxo);
+		break;
 	}
-	
-	return tok;
-}
-
-static int nmea_update_cwcn(Token cwcn)
-{
-	Token   tok = cwcn;
-
-	if (tok.p >= tok.end)
-		return -1;
-	pthread_mutex_lock(&mutex_cwcn);
-	cwcn_value = str2int(tok.p, tok.end);
-	D("nmea_update_cwcn: value=%d \n", cwcn_value);	
-	pthread_mutex_unlock(&mutex_cwcn);
-	return 0;
-}
-
-static int nmea_update_tsx(Token tsx)
-{
-	Token   tok = tsx;
-
-	if (tok.p >= tok.end)
-		return -1;
-	pthread_mutex_lock(&mutex_tsx);
-	tsx_value = str2float(tok.p, tok.end);
-	D("nmea_update_tsx: value=%f \n", tsx_value);
-	pthread_mutex_unlock(&mutex_tsx);
-	return 0;
-}
-
-static int nmea_update_tcxo(Token tcxo)
-{
-	Token   tok = tcxo;
-
-	if (tok.p >= tok.end)
-		return -1;
-	pthread_mutex_lock(&mutex_tcxo);
-	tcxo_value = str2float(tok.p, tok.end);
-	D("nmea_update_tcxo: value=%f \n", tcxo_value);
-	pthread_mutex_unlock(&mutex_tcxo);
-	return 0;
 }
 
 static void  nmea_parse(const char* nmea, int length)
 {
-	NmeaTokenizer  tzer[1];
-	Token          tok;
-
-	if (length < 9) 
-	{
-		E("nmea_parse: sentence too short.");
-		return;
-	}
-
-	nmea_tokenizer_init(tzer, nmea, nmea+length);
-
-	tok = nmea_tokenizer_get(tzer, 0);
-	if (tok.p + 5 > tok.end) 
-	{
-		//E("sentence id '%.*s' too short, ignored.", tok.end-tok.p, tok.p);
-		return;
-	}
-	
-	//if ( !memcmp(tok.p,"PCGDS",5))
-	if ( !memcmp(tok.p,"PCGDS",5))
-	{
-		D("PCGDS enter now\n");
-		Token  name = nmea_tokenizer_get(tzer,1);
-		if( !memcmp(name.p,"CWCN0",5))
-		{
-			D("PCGDS ==>> CWCN0\n");
-			Token  value = nmea_tokenizer_get(tzer,2);
-			nmea_update_cwcn(value);
-		}
-		else if( !memcmp(name.p,"TSXTEMP",7))
-		{
-			D("PCGDS ==>> TSXTEMP\n");
-			Token  value = nmea_tokenizer_get(tzer,2);
-			nmea_update_tsx(value);
-		}
-		else if( !memcmp(name.p,"TCXO",4))
-		{
-			D("PCGDS ==>> TCXO\n");
-			Token  value = nmea_tokenizer_get(tzer,2);
-			nmea_update_tcxo(value);
-		}
-	}
+	// sentences may be split or merged across callbacks
+	nmea_reader_feed(&s_nmea_reader, nmea, length);
 }
 ////////////////////////////////NMEA PARSE END///////////////////////////////////////////
 
@@ -672,6 +509,7 @@ int get_init_mode(void)
 		get_interface = dlsym(handle, "gps_get_hardware_interface");
 		D("obtain GPS HAL interface \n");
 		pGpsface = get_interface(NULL);
+		nmea_reader_init(&s_nmea_reader, nmea_pcgds_update, NULL);
 		pGpsface->init(&sGpsCallbacks);
 		first_open = 1;
 		sem_init(&sem_a,0,0);
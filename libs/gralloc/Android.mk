@@ -86,6 +86,8 @@ endif
 LOCAL_SRC_FILES := \
 	gralloc_module.cpp \
 	alloc_device.cpp \
+	alloc_pool.cpp \
+	gralloc_sync.cpp \
 	framebuffer_device.cpp \
 	dump_bmp.cpp
 
@@ -17,11 +17,15 @@
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include <errno.h>
 #include <pthread.h>
 
 #include <cutils/log.h>
 #include <cutils/atomic.h>
+#include <cutils/properties.h>
 #include <hardware/hardware.h>
 #include <hardware/gralloc.h>
 
@@ -43,6 +47,7 @@
 #endif
 
 #include "ion_sprd.h"
+#include "alloc_pool.h"
 
 #if GRALLOC_SIMULATE_FAILURES
 #include <cutils/properties.h>
@@ -95,85 +100,212 @@ static int __ump_alloc_should_fail()
 #endif
 
 
-static int gralloc_alloc_buffer(alloc_device_t *dev, size_t size, int usage, buffer_handle_t *pHandle)
-{
 #if GRALLOC_ARM_DMA_BUF_MODULE
+/* below this much free and cached memory the pool gives its buffers back */
+#define ALLOC_POOL_LOW_MEMORY_KB    (64 * 1024)
+
+/* /proc/meminfo is read at most this often */
+#define ALLOC_POOL_MEMINFO_MS       1000
+
+static struct alloc_pool s_pool;
+
+static void gralloc_ion_heap(int usage, int *heap_mask, int *flags)
+{
+	if (usage & (GRALLOC_USAGE_VIDEO_BUFFER|GRALLOC_USAGE_CAMERA_BUFFER))
 	{
-		private_module_t *m = reinterpret_cast<private_module_t *>(dev->common.module);
-		struct ion_handle *ion_hnd;
-		unsigned char *cpu_ptr;
-		int shared_fd;
-		int ret;
-		int ion_heap_mask = 0;
-		int ion_flag = 0;
-		private_handle_t *hnd = NULL;
+		*heap_mask = ION_HEAP_ID_MASK_MM;
+	}
+	else if(usage & GRALLOC_USAGE_OVERLAY_BUFFER)
+	{
+		*heap_mask = ION_HEAP_ID_MASK_OVERLAY;
+	}
+	else
+	{
+		*heap_mask = ION_HEAP_ID_MASK_SYSTEM;
+	}
 
-		if (usage & (GRALLOC_USAGE_VIDEO_BUFFER|GRALLOC_USAGE_CAMERA_BUFFER))
-		{
-			ion_heap_mask = ION_HEAP_ID_MASK_MM;
-		}
-		else if(usage & GRALLOC_USAGE_OVERLAY_BUFFER)
-		{
-			ion_heap_mask = ION_HEAP_ID_MASK_OVERLAY;
-		}
-		else
+	*flags = 0;
+
+	if (usage & (GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK))
+	{
+		*flags = ION_FLAG_CACHED | ION_FLAG_CACHED_NEEDS_SYNC;
+	}
+}
+
+static int gralloc_ion_alloc(void *ctx, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf)
+{
+	private_module_t *m = reinterpret_cast<private_module_t *>(ctx);
+	struct ion_handle *ion_hnd;
+	unsigned char *cpu_ptr;
+	int shared_fd;
+	int ret;
+
+	ret = ion_alloc(m->ion_client, size, 0, heap_mask, flags, &ion_hnd);
+
+	if (ret != 0)
+	{
+		AERR("Failed to ion_alloc from ion_client:%d", m->ion_client);
+		return -1;
+	}
+
+	ret = ion_share(m->ion_client, ion_hnd, &shared_fd);
+
+	if (ret != 0)
+	{
+		AERR("ion_share( %d ) failed", m->ion_client);
+
+		if (0 != ion_free(m->ion_client, ion_hnd))
 		{
-			ion_heap_mask = ION_HEAP_ID_MASK_SYSTEM;
+			AERR("ion_free( %d ) failed", m->ion_client);
 		}
 
-		if (usage & (GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK))
+		return -1;
+	}
+
+	cpu_ptr = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shared_fd, 0);
+
+	if (MAP_FAILED == cpu_ptr)
+	{
+		AERR("ion_map( %d ) failed", m->ion_client);
+
+		if (0 != ion_free(m->ion_client, ion_hnd))
 		{
-			ion_flag = ION_FLAG_CACHED | ION_FLAG_CACHED_NEEDS_SYNC;
+			AERR("ion_free( %d ) failed", m->ion_client);
 		}
 
-		ret = ion_alloc(m->ion_client, size, 0, ion_heap_mask, ion_flag, &ion_hnd);
+		close(shared_fd);
+		return -1;
+	}
+
+	buf->ion_hnd = ion_hnd;
+	buf->share_fd = shared_fd;
+	buf->base = cpu_ptr;
+	buf->size = size;
+	buf->heap_mask = heap_mask;
+	buf->flags = flags;
 
-		if (ret != 0)
+	return 0;
+}
+
+static void gralloc_ion_free(void *ctx, struct alloc_pool_buffer *buf)
+{
+	private_module_t *m = reinterpret_cast<private_module_t *>(ctx);
+
+	/* Buffer might be unregistered so we need to check for invalid base */
+	if (0 != buf->base)
+	{
+		ALOGD_IF(mDebug>0,"free vaddress:0x%x size:0x%x ion_hnd:%p",(uintptr_t)buf->base,buf->size,buf->ion_hnd);
+		if (0 != munmap(buf->base, buf->size))
 		{
-			AERR("Failed to ion_alloc from ion_client:%d", m->ion_client);
-			return -1;
+			AERR("munmap failed for base:%p size: %d", buf->base, buf->size);
 		}
+	}
 
-		ret = ion_share(m->ion_client, ion_hnd, &shared_fd);
+	close(buf->share_fd);
 
-		if (ret != 0)
-		{
-			AERR("ion_share( %d ) failed", m->ion_client);
+	if (0 != ion_free(m->ion_client, buf->ion_hnd))
+	{
+		AERR("Failed to ion_free( ion_client: %d ion_hnd:%p )", m->ion_client, buf->ion_hnd);
+	}
+}
 
-			if (0 != ion_free(m->ion_client, ion_hnd))
-			{
-				AERR("ion_free( %d ) failed", m->ion_client);
-			}
+static int64_t gralloc_ion_now(void *ctx)
+{
+	struct timespec ts;
 
-			return -1;
-		}
+	MALI_IGNORE(ctx);
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-		cpu_ptr = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shared_fd, 0);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-		if (MAP_FAILED == cpu_ptr)
-		{
-			AERR("ion_map( %d ) failed", m->ion_client);
+/*
+ * Free and page cache memory as the low memory killer counts it,
+ * read again after ALLOC_POOL_MEMINFO_MS. Called with the pool locked.
+ */
+static int gralloc_ion_low_memory(void *ctx)
+{
+	static int64_t s_read_ms = -ALLOC_POOL_MEMINFO_MS;
+	static int s_low = 0;
+	int64_t now = gralloc_ion_now(ctx);
+	char line[128];
+	long free_kb = 0;
+	long cached_kb = 0;
+	FILE *fp;
+
+	if (now - s_read_ms < ALLOC_POOL_MEMINFO_MS)
+	{
+		return s_low;
+	}
 
-			if (0 != ion_free(m->ion_client, ion_hnd))
-			{
-				AERR("ion_free( %d ) failed", m->ion_client);
-			}
+	s_read_ms = now;
+	fp = fopen("/proc/meminfo", "r");
 
-			close(shared_fd);
-			return -1;
+	if (NULL == fp)
+	{
+		return s_low;
+	}
+
+	while (fgets(line, sizeof(line), fp))
+	{
+		sscanf(line, "MemFree: %ld kB", &free_kb);
+		sscanf(line, "Cached: %ld kB", &cached_kb);
+	}
+
+	fclose(fp);
+	s_low = (free_kb + cached_kb < ALLOC_POOL_LOW_MEMORY_KB);
+
+	return s_low;
+}
+
+static const struct alloc_pool_ops s_pool_ops =
+{
+	gralloc_ion_alloc,
+	gralloc_ion_free,
+	gralloc_ion_now,
+	gralloc_ion_low_memory,
+};
+#endif
+
+static int gralloc_alloc_buffer(alloc_device_t *dev, size_t size, int usage, buffer_handle_t *pHandle)
+{
+#if GRALLOC_ARM_DMA_BUF_MODULE
+	{
+		private_module_t *m = reinterpret_cast<private_module_t *>(dev->common.module);
+		struct alloc_pool_buffer buf;
+		int ret;
+		int ion_heap_mask = 0;
+		int ion_flag = 0;
+		private_handle_t *hnd = NULL;
+
+		gralloc_ion_heap(usage, &ion_heap_mask, &ion_flag);
+
+		if (usage & GRALLOC_USAGE_PROTECTED)
+		{
+			/* protected content never goes to another buffer */
+			ret = gralloc_ion_alloc(m, size, ion_heap_mask, ion_flag, &buf);
+		}
+		else
+		{
+			ret = alloc_pool_alloc(&s_pool, size, ion_heap_mask, ion_flag, &buf);
 		}
 
+		if (ret != 0)
+		{
+			return -1;
+		}
 
-		hnd = new private_handle_t( private_handle_t::PRIV_FLAGS_USES_ION, usage, size, cpu_ptr, private_handle_t::LOCK_STATE_MAPPED );
+		/* the size class, not size, is mapped and freed */
+		hnd = new private_handle_t( private_handle_t::PRIV_FLAGS_USES_ION, usage, buf.size, buf.base, private_handle_t::LOCK_STATE_MAPPED );
 		if (NULL != hnd)
 		{
 			if(ion_heap_mask == ION_HEAP_CARVEOUT_MASK || ion_heap_mask == ION_HEAP_ID_MASK_OVERLAY)
 			{
 				hnd->flags=(private_handle_t::PRIV_FLAGS_USES_ION)|(private_handle_t::PRIV_FLAGS_USES_PHY);
 			}
-			ALOGD_IF(mDebug>0,"get vadress:0x%x size:0x%x ion_hnd:%p",(int)cpu_ptr,size,hnd->ion_hnd);
-			hnd->share_fd = shared_fd;
-			hnd->ion_hnd = ion_hnd;
+			ALOGD_IF(mDebug>0,"get vadress:0x%x size:0x%x ion_hnd:%p",(int)buf.base,buf.size,buf.ion_hnd);
+			hnd->share_fd = buf.share_fd;
+			hnd->ion_hnd = buf.ion_hnd;
 			*pHandle = hnd;
 			ion_invalidate_fd(m->ion_client,hnd->share_fd);
 			return 0;
@@ -183,20 +315,7 @@ static int gralloc_alloc_buffer(alloc_device_t *dev, size_t size, int usage, buf
 			AERR("Gralloc out of mem for ion_client:%d", m->ion_client);
 		}
 
-		close(shared_fd);
-		ret = munmap(cpu_ptr, size);
-
-		if (0 != ret)
-		{
-			AERR("munmap failed for base:%p size: %d", cpu_ptr, size);
-		}
-
-		ret = ion_free(m->ion_client, ion_hnd);
-
-		if (0 != ret)
-		{
-			AERR("ion_free( %d ) failed", m->ion_client);
-		}
+		alloc_pool_free(&s_pool, &buf, 0);
 
 		return -1;
 	}
@@ -585,24 +704,19 @@ static int alloc_device_free(alloc_device_t *dev, buffer_handle_t handle)
 	else if (hnd->flags & private_handle_t::PRIV_FLAGS_USES_ION)
 	{
 #if GRALLOC_ARM_DMA_BUF_MODULE
-		private_module_t *m = reinterpret_cast<private_module_t *>(dev->common.module);
-
-		/* Buffer might be unregistered so we need to check for invalid ump handle*/
-		if (0 != hnd->base)
-		{
-			ALOGD_IF(mDebug>0,"free vaddress:0x%x size:0x%x ion_hnd:%p",(uintptr_t)hnd->base,hnd->size,hnd->ion_hnd);
-			if (0 != munmap((void *)hnd->base, hnd->size))
-			{
-				AERR("Failed to munmap handle 0x%p", hnd);
-			}
-		}
+		struct alloc_pool_buffer buf;
 
-		close(hnd->share_fd);
+		buf.ion_hnd = hnd->ion_hnd;
+		buf.share_fd = hnd->share_fd;
+		buf.base = (void *)hnd->base;
+		buf.size = hnd->size;
+		gralloc_ion_heap(hnd->usage, &buf.heap_mask, &buf.flags);
 
-		if (0 != ion_free(m->ion_client, hnd->ion_hnd))
-		{
-			AERR("Failed to ion_free( ion_client: %d ion_hnd:%p )", m->ion_client, hnd->ion_hnd);
-		}
+		/*
+		 * Clients may still hold the buffer, it is freed and never handed out again.
+		 * Only the system heap clears what it hands out, only its buffers are replaced.
+		 */
+		alloc_pool_free(&s_pool, &buf, ION_HEAP_ID_MASK_SYSTEM == buf.heap_mask && 0 == (hnd->usage & GRALLOC_USAGE_PROTECTED));
 
 		memset((void *)hnd, 0, sizeof(*hnd));
 #else
@@ -617,6 +731,14 @@ static int alloc_device_free(alloc_device_t *dev, buffer_handle_t handle)
 	return 0;
 }
 
+#if GRALLOC_ARM_DMA_BUF_MODULE
+static void alloc_device_dump(alloc_device_t *dev, char *buff, int buff_len)
+{
+	MALI_IGNORE(dev);
+	alloc_pool_dump(&s_pool, buff, buff_len);
+}
+#endif
+
 static int alloc_device_close(struct hw_device_t *device)
 {
 	alloc_device_t *dev = reinterpret_cast<alloc_device_t *>(device);
@@ -626,6 +748,8 @@ static int alloc_device_close(struct hw_device_t *device)
 #if GRALLOC_ARM_DMA_BUF_MODULE
 		private_module_t *m = reinterpret_cast<private_module_t *>(device->module);
 
+		alloc_pool_destroy(&s_pool);
+
 		if (0 != ion_close(m->ion_client))
 		{
 			AERR("Failed to close ion_client: %d", m->ion_client);
@@ -687,6 +811,11 @@ int alloc_device_open(hw_module_t const *module, const char *name, hw_device_t *
 		return -1;
 	}
 
+	char prop_value[PROPERTY_VALUE_MAX];
+
+	property_get("debug.gralloc.pool_kb", prop_value, "-1");
+	alloc_pool_init(&s_pool, &s_pool_ops, m, (atoi(prop_value) >= 0) ? (size_t)atoi(prop_value) * 1024 : ALLOC_POOL_BUDGET);
+	dev->dump = alloc_device_dump;
 #endif
 
 	*device = &dev->common;
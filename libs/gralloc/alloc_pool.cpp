@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2010 ARM Limited. All rights reserved.
+ *
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "alloc_pool.h"
+
+#define ALLOC_POOL_PAGE_SIZE        4096
+
+/* sizes up to this many pages are their own class */
+#define ALLOC_POOL_EXACT_PAGES      16
+
+size_t alloc_pool_size_class(size_t size)
+{
+	size_t step = ALLOC_POOL_PAGE_SIZE;
+
+	size = (size + ALLOC_POOL_PAGE_SIZE - 1) & ~(size_t)(ALLOC_POOL_PAGE_SIZE - 1);
+
+	if (size > ALLOC_POOL_EXACT_PAGES * ALLOC_POOL_PAGE_SIZE)
+	{
+		size_t top = ALLOC_POOL_EXACT_PAGES * ALLOC_POOL_PAGE_SIZE;
+
+		while ((top << 1) <= size)
+		{
+			top <<= 1;
+		}
+
+		step = top / 16;
+	}
+
+	return (size + step - 1) & ~(step - 1);
+}
+
+void alloc_pool_init(struct alloc_pool *pool, const struct alloc_pool_ops *ops, void *ctx, size_t budget)
+{
+	memset(pool, 0, sizeof(*pool));
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+	pool->ops = ops;
+	pool->ctx = ctx;
+	pool->budget = budget;
+}
+
+/*
+ * Take entry i out of the pool, the caller frees or reuses it.
+ */
+static void alloc_pool_remove_locked(struct alloc_pool *pool, int i, struct alloc_pool_buffer *buf)
+{
+	*buf = pool->entries[i].buf;
+	pool->bytes -= buf->size;
+	pool->count--;
+	memmove(&pool->entries[i], &pool->entries[i + 1], (pool->count - i) * sizeof(struct alloc_pool_entry));
+}
+
+/*
+ * Take out the buffers kept too long, or all of them when the
+ * system is short of memory, or the oldest down to bytes.
+ * return value: the number of buffers in victims.
+ */
+static int alloc_pool_expire_locked(struct alloc_pool *pool, size_t bytes, struct alloc_pool_buffer *victims)
+{
+	int64_t now = pool->ops->now(pool->ctx);
+	int n = 0;
+
+	if (pool->count > 0 && pool->ops->low_memory(pool->ctx))
+	{
+		while (pool->count > 0)
+		{
+			alloc_pool_remove_locked(pool, 0, &victims[n++]);
+			pool->stats.pressure++;
+		}
+	}
+
+	while (pool->count > 0 && now - pool->entries[0].made_ms >= ALLOC_POOL_IDLE_MS)
+	{
+		alloc_pool_remove_locked(pool, 0, &victims[n++]);
+		pool->stats.idle++;
+	}
+
+	while (pool->count > 0 && pool->bytes > bytes)
+	{
+		alloc_pool_remove_locked(pool, 0, &victims[n++]);
+		pool->stats.evicted++;
+	}
+
+	return n;
+}
+
+static void alloc_pool_release(struct alloc_pool *pool, struct alloc_pool_buffer *victims, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		pool->ops->free(pool->ctx, &victims[i]);
+	}
+}
+
+void alloc_pool_trim(struct alloc_pool *pool, size_t bytes)
+{
+	struct alloc_pool_buffer victims[ALLOC_POOL_ENTRIES];
+	int n;
+
+	pthread_mutex_lock(&pool->lock);
+	n = alloc_pool_expire_locked(pool, bytes, victims);
+	pthread_mutex_unlock(&pool->lock);
+
+	alloc_pool_release(pool, victims, n);
+}
+
+/*
+ * Insert buf as the most recent entry, older ones go for the budget.
+ * return value: the number of buffers in victims.
+ */
+static int alloc_pool_insert_locked(struct alloc_pool *pool, struct alloc_pool_buffer *buf, struct alloc_pool_buffer *victims)
+{
+	int n = alloc_pool_expire_locked(pool, pool->budget - buf->size, victims);
+
+	if (pool->count == ALLOC_POOL_ENTRIES)
+	{
+		alloc_pool_remove_locked(pool, 0, &victims[n++]);
+		pool->stats.evicted++;
+	}
+
+	pool->entries[pool->count].buf = *buf;
+	pool->entries[pool->count].made_ms = pool->ops->now(pool->ctx);
+	pool->count++;
+	pool->bytes += buf->size;
+	pool->stats.made++;
+
+	if (pool->bytes > pool->stats.peak_bytes)
+	{
+		pool->stats.peak_bytes = pool->bytes;
+	}
+
+	return n;
+}
+
+/*
+ * Sleep until the oldest kept buffer has been idle for ALLOC_POOL_IDLE_MS,
+ * ALLOC_POOL_CHECK_MS at most, or a request comes.
+ */
+static void alloc_pool_sleep_locked(struct alloc_pool *pool)
+{
+	int64_t ms = pool->entries[0].made_ms + ALLOC_POOL_IDLE_MS - pool->ops->now(pool->ctx);
+	struct timespec ts;
+
+	if (ms <= 0)
+	{
+		return;
+	}
+
+	if (ms > ALLOC_POOL_CHECK_MS)
+	{
+		ms = ALLOC_POOL_CHECK_MS;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000;
+
+	if (ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_cond_timedwait(&pool->cond, &pool->lock, &ts);
+}
+
+/*
+ * Make the buffers asked for, one at a time, outside the lock. While
+ * buffers are kept, free the idle ones and all of them under memory
+ * pressure, though nothing is allocated or freed.
+ */
+static void *alloc_pool_worker(void *arg)
+{
+	struct alloc_pool *pool = (struct alloc_pool *)arg;
+	struct alloc_pool_buffer victims[ALLOC_POOL_ENTRIES + 1];
+	struct alloc_pool_request r;
+	struct alloc_pool_buffer buf;
+	int ret;
+	int n;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (!pool->quit)
+	{
+		if (pool->wanted == 0)
+		{
+			if (pool->count == 0)
+			{
+				pthread_cond_wait(&pool->cond, &pool->lock);
+				continue;
+			}
+
+			alloc_pool_sleep_locked(pool);
+			n = alloc_pool_expire_locked(pool, pool->budget, victims);
+
+			if (n > 0)
+			{
+				pool->busy = 1;
+				pthread_mutex_unlock(&pool->lock);
+				alloc_pool_release(pool, victims, n);
+				pthread_mutex_lock(&pool->lock);
+				pool->busy = 0;
+				pthread_cond_broadcast(&pool->cond);
+			}
+
+			continue;
+		}
+
+		r = pool->requests[0];
+		pool->wanted--;
+		memmove(&pool->requests[0], &pool->requests[1], pool->wanted * sizeof(struct alloc_pool_request));
+		pool->busy = 1;
+		pthread_mutex_unlock(&pool->lock);
+
+		ret = pool->ops->alloc(pool->ctx, r.size, r.heap_mask, r.flags, &buf);
+
+		pthread_mutex_lock(&pool->lock);
+		n = 0;
+
+		if (ret != 0)
+		{
+			pool->stats.failed++;
+		}
+		else if (pool->quit)
+		{
+			victims[n++] = buf;
+		}
+		else if (pool->ops->low_memory(pool->ctx))
+		{
+			victims[n++] = buf;
+			pool->stats.made++;
+			pool->stats.pressure++;
+		}
+		else
+		{
+			n = alloc_pool_insert_locked(pool, &buf, victims);
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+		alloc_pool_release(pool, victims, n);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->busy = 0;
+		pthread_cond_broadcast(&pool->cond);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+void alloc_pool_destroy(struct alloc_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pool->wanted = 0;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	if (pool->started)
+	{
+		pthread_join(pool->thread, NULL);
+	}
+
+	alloc_pool_trim(pool, 0);
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+int alloc_pool_alloc(struct alloc_pool *pool, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf)
+{
+	struct alloc_pool_buffer victims[ALLOC_POOL_ENTRIES];
+	size_t class_size = (pool->budget > 0) ? alloc_pool_size_class(size) : size;
+	int found = 0;
+	int n;
+	int ret;
+
+	pthread_mutex_lock(&pool->lock);
+	n = alloc_pool_expire_locked(pool, pool->budget, victims);
+
+	/* the most recently made first */
+	for (int i = pool->count - 1; i >= 0; i--)
+	{
+		struct alloc_pool_buffer *b = &pool->entries[i].buf;
+
+		if (b->size == class_size && b->heap_mask == heap_mask && b->flags == flags)
+		{
+			alloc_pool_remove_locked(pool, i, buf);
+			found = 1;
+			break;
+		}
+	}
+
+	if (found)
+	{
+		pool->stats.hits++;
+	}
+	else
+	{
+		pool->stats.misses++;
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	alloc_pool_release(pool, victims, n);
+
+	if (found)
+	{
+		return 0;
+	}
+
+	ret = pool->ops->alloc(pool->ctx, class_size, heap_mask, flags, buf);
+
+	if (ret != 0)
+	{
+		/* the kept buffers may hold the memory of the heap, give it back, make no more and try again */
+		pthread_mutex_lock(&pool->lock);
+		pool->wanted = 0;
+		n = (pool->count > 0) ? alloc_pool_expire_locked(pool, 0, victims) : 0;
+
+		if (n > 0)
+		{
+			pool->stats.retries++;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+
+		if (n > 0)
+		{
+			alloc_pool_release(pool, victims, n);
+			ret = pool->ops->alloc(pool->ctx, class_size, heap_mask, flags, buf);
+		}
+	}
+
+	return ret;
+}
+
+void alloc_pool_free(struct alloc_pool *pool, struct alloc_pool_buffer *buf, int replace)
+{
+	struct alloc_pool_request r;
+
+	/* only whole size classes can be asked for */
+	if (replace && (pool->budget == 0 || buf->size != alloc_pool_size_class(buf->size) ||
+	                buf->size > pool->budget / 2))
+	{
+		replace = 0;
+	}
+
+	r.size = buf->size;
+	r.heap_mask = buf->heap_mask;
+	r.flags = buf->flags;
+
+	/* its memory goes back before the replacement is made */
+	pool->ops->free(pool->ctx, buf);
+
+	if (replace == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (!pool->quit && !pool->ops->low_memory(pool->ctx))
+	{
+		if (pool->wanted == ALLOC_POOL_ENTRIES)
+		{
+			pool->wanted--;
+			memmove(&pool->requests[0], &pool->requests[1], pool->wanted * sizeof(struct alloc_pool_request));
+		}
+
+		pool->requests[pool->wanted++] = r;
+
+		if (!pool->started)
+		{
+			pool->started = (0 == pthread_create(&pool->thread, NULL, alloc_pool_worker, pool));
+
+			if (!pool->started)
+			{
+				pool->wanted = 0;
+			}
+		}
+
+		pthread_cond_broadcast(&pool->cond);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void alloc_pool_wait(struct alloc_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	while (pool->wanted > 0 || pool->busy)
+	{
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int alloc_pool_dump(struct alloc_pool *pool, char *buff, int buff_len)
+{
+	int len;
+
+	pthread_mutex_lock(&pool->lock);
+	len = snprintf(buff, buff_len,
+	               "gralloc pool: %u KB in %d buffers, %d wanted, budget %u KB, peak %u KB\n"
+	               "    hits %u misses %u made %u failed %u evicted %u idle %u pressure %u retries %u\n",
+	               (unsigned int)(pool->bytes / 1024), pool->count, pool->wanted, (unsigned int)(pool->budget / 1024),
+	               (unsigned int)(pool->stats.peak_bytes / 1024),
+	               pool->stats.hits, pool->stats.misses, pool->stats.made, pool->stats.failed,
+	               pool->stats.evicted, pool->stats.idle, pool->stats.pressure, pool->stats.retries);
+	pthread_mutex_unlock(&pool->lock);
+
+	return len;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2010 ARM Limited. All rights reserved.
+ *
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ALLOC_POOL_H_
+#define ALLOC_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/*
+ * Pool of ION buffers made ahead for the next allocation of the same
+ * heap, cache flags and size class. A freed buffer may still be held by
+ * the processes it was handed to, so it is never handed out again:
+ * freeing it asks a worker thread for a fresh buffer of its class in
+ * its place. A buffer in the pool has never left gralloc.
+ */
+
+/* buffers kept and buffers asked for at most */
+#define ALLOC_POOL_ENTRIES          32
+
+/* default byte budget, debug.gralloc.pool_kb overrides it, 0 disables the pool */
+#define ALLOC_POOL_BUDGET           (16 * 1024 * 1024)
+
+/* a buffer kept longer than this is freed */
+#define ALLOC_POOL_IDLE_MS          3000
+
+/* while it keeps buffers the worker checks for idle ones and memory pressure this often */
+#define ALLOC_POOL_CHECK_MS         1000
+
+struct ion_handle;
+
+struct alloc_pool_buffer
+{
+	struct ion_handle *ion_hnd;
+	int share_fd;
+	void *base;
+	size_t size;
+	int heap_mask;
+	int flags;
+};
+
+/*
+ * The memory layer under the pool, ION on the device.
+ */
+struct alloc_pool_ops
+{
+	/* allocate size bytes, share and map them */
+	int (*alloc)(void *ctx, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf);
+
+	/* unmap, close and free a buffer */
+	void (*free)(void *ctx, struct alloc_pool_buffer *buf);
+
+	/* monotonic time in ms */
+	int64_t (*now)(void *ctx);
+
+	/* non-zero when the system runs short of memory */
+	int (*low_memory)(void *ctx);
+};
+
+/*
+ * A buffer made ahead leaves the pool as a hit, or is freed as evicted
+ * for the budget, idle or under memory pressure.
+ */
+struct alloc_pool_stats
+{
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int made;
+	unsigned int failed;
+	unsigned int evicted;
+	unsigned int idle;
+	unsigned int pressure;
+	unsigned int retries;
+	size_t peak_bytes;
+};
+
+struct alloc_pool_entry
+{
+	struct alloc_pool_buffer buf;
+	int64_t made_ms;
+};
+
+struct alloc_pool_request
+{
+	size_t size;
+	int heap_mask;
+	int flags;
+};
+
+struct alloc_pool
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	const struct alloc_pool_ops *ops;
+	void *ctx;
+	size_t budget;
+	size_t bytes;
+
+	/* oldest first */
+	int count;
+	struct alloc_pool_entry entries[ALLOC_POOL_ENTRIES];
+
+	/* buffers to make, oldest first */
+	int wanted;
+	struct alloc_pool_request requests[ALLOC_POOL_ENTRIES];
+
+	/* the worker is started with the first request, it also trims the pool */
+	pthread_t thread;
+	int started;
+	int busy;
+	int quit;
+
+	struct alloc_pool_stats stats;
+};
+
+/* size rounded up to its class, at most 1/16 more */
+size_t alloc_pool_size_class(size_t size);
+
+void alloc_pool_init(struct alloc_pool *pool, const struct alloc_pool_ops *ops, void *ctx, size_t budget);
+
+/* stop the worker and free every kept buffer */
+void alloc_pool_destroy(struct alloc_pool *pool);
+
+/*
+ * Allocate a buffer of the size class of size, one made ahead if there
+ * is. It is as the heap hands it out, nobody has seen it before.
+ */
+int alloc_pool_alloc(struct alloc_pool *pool, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf);
+
+/*
+ * Free a buffer of alloc_pool_alloc(). If replace is set and the budget
+ * allows, a fresh buffer of its class is made for the next allocation.
+ * Only a heap that clears what it hands out may be replaced.
+ */
+void alloc_pool_free(struct alloc_pool *pool, struct alloc_pool_buffer *buf, int replace);
+
+/* wait until the worker has made the buffers asked for */
+void alloc_pool_wait(struct alloc_pool *pool);
+
+/* free kept buffers down to bytes */
+void alloc_pool_trim(struct alloc_pool *pool, size_t bytes);
+
+/* statistics for dumpsys */
+int alloc_pool_dump(struct alloc_pool *pool, char *buff, int buff_len);
+
+#endif /* ALLOC_POOL_H_ */
@@ -17,10 +17,13 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
 #include <pthread.h>
+#include <sys/ioctl.h>
 
 #include <cutils/log.h>
 #include <cutils/atomic.h>
+#include <cutils/properties.h>
 #include <hardware/hardware.h>
 #include <hardware/gralloc.h>
 #include <linux/ion.h>
@@ -38,10 +41,239 @@ static int s_ump_is_open = 0;
 #include <linux/ion.h>
 #include <ion/ion.h>
 #include <sys/mman.h>
+#include "ion_sprd.h"
+#include "gralloc_sync.h"
 #endif
 
 static pthread_mutex_t s_map_lock = PTHREAD_MUTEX_INITIALIZER;
 
+#if GRALLOC_ARM_DMA_BUF_MODULE
+/* buffers locked at the same time in a process at most */
+#define GRALLOC_LOCK_RECT_MAX       32
+
+/*
+ * The rectangle of a lock, its cache maintenance at unlock covers
+ * only this rectangle. phys is 0 unless the buffer is contiguous.
+ */
+struct gralloc_lock_rect
+{
+	private_handle_t *hnd;
+	void *base;
+	int share_fd;
+	int l;
+	int t;
+	int w;
+	int h;
+	unsigned long phys;
+};
+
+struct gralloc_sync_ctx
+{
+	private_module_t *m;
+	private_handle_t *hnd;
+	unsigned long phys;
+};
+
+static pthread_mutex_t s_rect_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct gralloc_lock_rect s_lock_rects[GRALLOC_LOCK_RECT_MAX];
+static int s_sync_full_pct = -1;
+
+static unsigned long gralloc_ion_phys(private_module_t *m, private_handle_t *hnd)
+{
+	struct ion_phys_data phys_data;
+	struct ion_custom_data custom_data;
+
+	if (!hnd->usesPhysicallyContiguousMemory())
+	{
+		return 0;
+	}
+
+	phys_data.fd_buffer = hnd->share_fd;
+	custom_data.cmd = ION_SPRD_CUSTOM_PHYS;
+	custom_data.arg = (unsigned long)&phys_data;
+
+	if (ioctl(m->ion_client, ION_IOC_CUSTOM, &custom_data) < 0)
+	{
+		AERR("Failed to get phys of share_fd:%d", hnd->share_fd);
+		return 0;
+	}
+
+	return phys_data.phys;
+}
+
+/*
+ * The driver cleans and invalidates the range, which serves
+ * either way.
+ */
+static int gralloc_ion_sync_range(void *ctx, int op, size_t offset, size_t size)
+{
+	struct gralloc_sync_ctx *c = (struct gralloc_sync_ctx *)ctx;
+	struct ion_msync_data msync_data;
+	struct ion_custom_data custom_data;
+
+	MALI_IGNORE(op);
+	msync_data.fd_buffer = c->hnd->share_fd;
+	msync_data.vaddr = (void *)((uintptr_t)c->hnd->base + offset);
+	msync_data.paddr = (void *)(c->phys + offset);
+	msync_data.size = size;
+	custom_data.cmd = ION_SPRD_CUSTOM_MSYNC;
+	custom_data.arg = (unsigned long)&msync_data;
+
+	return (ioctl(c->m->ion_client, ION_IOC_CUSTOM, &custom_data) < 0) ? -1 : 0;
+}
+
+static void gralloc_ion_sync_all(void *ctx, int op)
+{
+	struct gralloc_sync_ctx *c = (struct gralloc_sync_ctx *)ctx;
+
+	if (op == GRALLOC_SYNC_INVALIDATE)
+	{
+		ion_invalidate_fd(c->m->ion_client, c->hnd->share_fd);
+	}
+	else
+	{
+		ion_sync_fd(c->m->ion_client, c->hnd->share_fd);
+	}
+}
+
+static const struct gralloc_sync_ops s_sync_range_ops =
+{
+	gralloc_ion_sync_range,
+	gralloc_ion_sync_all,
+};
+
+static const struct gralloc_sync_ops s_sync_all_ops =
+{
+	NULL,
+	gralloc_ion_sync_all,
+};
+
+/*
+ * Record the rectangle of a lock, a second lock before the unlock
+ * widens it to both.
+ */
+static void gralloc_rect_save(private_module_t *m, private_handle_t *hnd, int l, int t, int w, int h, struct gralloc_lock_rect *rect)
+{
+	struct gralloc_lock_rect *entry = NULL;
+	struct gralloc_lock_rect *unused = NULL;
+
+	pthread_mutex_lock(&s_rect_lock);
+
+	for (int i = 0; i < GRALLOC_LOCK_RECT_MAX; i++)
+	{
+		if (s_lock_rects[i].hnd == hnd)
+		{
+			entry = &s_lock_rects[i];
+			break;
+		}
+		else if (s_lock_rects[i].hnd == NULL && unused == NULL)
+		{
+			unused = &s_lock_rects[i];
+		}
+	}
+
+	/* a handle of a buffer freed without unlock */
+	if (entry != NULL && (entry->base != hnd->base || entry->share_fd != hnd->share_fd))
+	{
+		entry->hnd = NULL;
+		unused = entry;
+		entry = NULL;
+	}
+
+	if (entry != NULL && w > 0 && h > 0 && entry->w > 0 && entry->h > 0)
+	{
+		int r = (l + w > entry->l + entry->w) ? l + w : entry->l + entry->w;
+		int b = (t + h > entry->t + entry->h) ? t + h : entry->t + entry->h;
+
+		entry->l = (l < entry->l) ? l : entry->l;
+		entry->t = (t < entry->t) ? t : entry->t;
+		entry->w = r - entry->l;
+		entry->h = b - entry->t;
+	}
+	else if (entry != NULL)
+	{
+		/* the whole buffer */
+		entry->w = 0;
+		entry->h = 0;
+	}
+	else if (unused != NULL)
+	{
+		entry = unused;
+		entry->hnd = hnd;
+		entry->base = hnd->base;
+		entry->share_fd = hnd->share_fd;
+		entry->l = l;
+		entry->t = t;
+		entry->w = w;
+		entry->h = h;
+		entry->phys = gralloc_ion_phys(m, hnd);
+	}
+
+	if (entry != NULL)
+	{
+		*rect = *entry;
+	}
+	else
+	{
+		memset(rect, 0, sizeof(*rect));
+	}
+
+	pthread_mutex_unlock(&s_rect_lock);
+}
+
+/* return value: non-zero if hnd was locked with a rectangle */
+static int gralloc_rect_take(private_handle_t *hnd, struct gralloc_lock_rect *rect)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&s_rect_lock);
+
+	for (int i = 0; i < GRALLOC_LOCK_RECT_MAX; i++)
+	{
+		if (s_lock_rects[i].hnd == hnd)
+		{
+			found = (s_lock_rects[i].base == hnd->base && s_lock_rects[i].share_fd == hnd->share_fd);
+			*rect = s_lock_rects[i];
+			s_lock_rects[i].hnd = NULL;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&s_rect_lock);
+
+	return found;
+}
+
+static void gralloc_sync(private_module_t *m, private_handle_t *hnd, int op, const struct gralloc_lock_rect *rect)
+{
+	struct gralloc_sync_buffer buf;
+	struct gralloc_sync_ctx ctx;
+
+	if (s_sync_full_pct < 0)
+	{
+		char prop_value[PROPERTY_VALUE_MAX];
+
+		property_get("debug.gralloc.sync_pct", prop_value, "");
+		s_sync_full_pct = prop_value[0] ? atoi(prop_value) : GRALLOC_SYNC_FULL_PCT;
+	}
+
+	buf.format = hnd->format;
+	buf.width = hnd->width;
+	buf.height = hnd->height;
+	buf.stride = hnd->stride;
+	buf.size = hnd->size;
+	ctx.m = m;
+	ctx.hnd = hnd;
+	ctx.phys = rect->phys;
+
+	size_t bytes = gralloc_sync_rect(rect->phys ? &s_sync_range_ops : &s_sync_all_ops, &ctx, op, &buf,
+	                                 rect->l, rect->t, rect->w, rect->h, s_sync_full_pct);
+
+	ALOGD_IF(mDebug>1,"%s handle:%p rect:%d,%d %dx%d bytes:%d of %d", (op == GRALLOC_SYNC_INVALIDATE) ? "invalidate" : "clean",
+	         hnd, rect->l, rect->t, rect->w, rect->h, bytes, hnd->size);
+}
+#endif
+
 static int gralloc_device_open(const hw_module_t* module, const char* name, hw_device_t** device)
 {
 	int status = -EINVAL;
@@ -236,6 +468,9 @@ static int gralloc_unregister_buffer(gralloc_module_t const *module, buffer_hand
 #if GRALLOC_ARM_DMA_BUF_MODULE
 			void *base = (void *)hnd->base;
 			size_t size = hnd->size;
+			struct gralloc_lock_rect rect;
+
+			gralloc_rect_take(hnd, &rect);
 
 			if (munmap(base, size) < 0)
 			{
@@ -286,8 +521,10 @@ static int gralloc_lock(gralloc_module_t const *module, buffer_handle_t handle,
 		*vaddr = (void *)hnd->base;
 #if GRALLOC_ARM_DMA_BUF_MODULE
 		private_module_t *m = (private_module_t*)module;
+		struct gralloc_lock_rect rect;
 
-		ion_invalidate_fd(m->ion_client, hnd->share_fd);
+		gralloc_rect_save(m, hnd, l, t, w, h, &rect);
+		gralloc_sync(m, hnd, GRALLOC_SYNC_INVALIDATE, &rect);
 #endif
 	}
 
@@ -341,6 +578,16 @@ static int gralloc_lock_ycbcr(struct gralloc_module_t const* module,
 			err = -EINVAL;
 	}
 
+#if GRALLOC_ARM_DMA_BUF_MODULE
+	if (err == 0 && (hnd->flags & private_handle_t::PRIV_FLAGS_USES_ION) &&
+	    (usage & (GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK)))
+	{
+		struct gralloc_lock_rect rect;
+
+		gralloc_rect_save((private_module_t*)module, hnd, l, t, w, h, &rect);
+	}
+#endif
+
 	MALI_IGNORE(module);
 	MALI_IGNORE(usage);
 	MALI_IGNORE(l);
@@ -373,12 +620,22 @@ static int gralloc_unlock(gralloc_module_t const* module, buffer_handle_t handle
 #else
 		AERR("Buffer 0x%p is UMP type but it is not supported", hnd);
 #endif
-	} else if ( hnd->flags & private_handle_t::PRIV_FLAGS_USES_ION && hnd->writeOwner)
+	} else if ( hnd->flags & private_handle_t::PRIV_FLAGS_USES_ION)
 	{
 #if GRALLOC_ARM_DMA_BUF_MODULE
 		private_module_t *m = (private_module_t*)module;
+		struct gralloc_lock_rect rect;
+
+		if (gralloc_rect_take(hnd, &rect) == 0)
+		{
+			/* locked before a rectangle was kept, or by another path */
+			memset(&rect, 0, sizeof(rect));
+		}
 
-		ion_sync_fd(m->ion_client, hnd->share_fd);
+		if (hnd->writeOwner)
+		{
+			gralloc_sync(m, hnd, GRALLOC_SYNC_CLEAN, &rect);
+		}
 #endif
 	}
 
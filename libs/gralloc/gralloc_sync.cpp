@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2010 ARM Limited. All rights reserved.
+ *
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <system/graphics.h>
+
+#include "gralloc_sync.h"
+
+#define GRALLOC_SYNC_ALIGN(value, base) (((value) + ((base) - 1)) & ~((base) - 1))
+
+/*
+ * A plane of hsub x vsub pixels per sample of bytes, or a region
+ * whose rows are not known, maintained whole.
+ */
+struct gralloc_sync_plane
+{
+	size_t offset;
+	size_t pitch;
+	int bytes;
+	int hsub;
+	int vsub;
+	size_t whole;
+};
+
+static void gralloc_sync_plane_set(struct gralloc_sync_plane *plane, size_t offset, size_t pitch, int bytes, int hsub, int vsub)
+{
+	plane->offset = offset;
+	plane->pitch = pitch;
+	plane->bytes = bytes;
+	plane->hsub = hsub;
+	plane->vsub = vsub;
+	plane->whole = 0;
+}
+
+/*
+ * The planes as alloc_device_alloc() lays them out and
+ * gralloc_lock_ycbcr() hands them out.
+ */
+static int gralloc_sync_planes(const struct gralloc_sync_buffer *buf, struct gralloc_sync_plane *planes)
+{
+	size_t stride = buf->stride;
+	size_t height = buf->height;
+	size_t cpitch;
+	size_t coffset;
+
+	switch (buf->format)
+	{
+		case HAL_PIXEL_FORMAT_RGBA_8888:
+		case HAL_PIXEL_FORMAT_RGBX_8888:
+		case HAL_PIXEL_FORMAT_BGRA_8888:
+			gralloc_sync_plane_set(&planes[0], 0, stride * 4, 4, 1, 1);
+			return 1;
+
+		case HAL_PIXEL_FORMAT_RGB_888:
+			gralloc_sync_plane_set(&planes[0], 0, stride * 3, 3, 1, 1);
+			return 1;
+
+		case HAL_PIXEL_FORMAT_RGB_565:
+		case HAL_PIXEL_FORMAT_RGBA_5551:
+		case HAL_PIXEL_FORMAT_RGBA_4444:
+			gralloc_sync_plane_set(&planes[0], 0, stride * 2, 2, 1, 1);
+			return 1;
+
+		case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+		case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+			gralloc_sync_plane_set(&planes[0], 0, stride, 1, 1, 1);
+			gralloc_sync_plane_set(&planes[1], stride * height, stride, 2, 2, 2);
+			return 2;
+
+		case HAL_PIXEL_FORMAT_YV12:
+		case HAL_PIXEL_FORMAT_YCbCr_420_P:
+			cpitch = GRALLOC_SYNC_ALIGN(stride / 2, 16);
+			coffset = GRALLOC_SYNC_ALIGN(height * stride, 64);
+			gralloc_sync_plane_set(&planes[0], 0, stride, 1, 1, 1);
+			gralloc_sync_plane_set(&planes[1], coffset, cpitch, 1, 2, 2);
+			gralloc_sync_plane_set(&planes[2], coffset + GRALLOC_SYNC_ALIGN(height / 2 * cpitch, 64), cpitch, 1, 2, 2);
+			return 3;
+
+		case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+			/* the chroma layout belongs to the producer */
+			coffset = GRALLOC_SYNC_ALIGN(height * stride, 64);
+			gralloc_sync_plane_set(&planes[0], 0, stride, 1, 1, 1);
+			gralloc_sync_plane_set(&planes[1], coffset, 0, 0, 1, 1);
+			planes[1].whole = (buf->size > coffset) ? buf->size - coffset : 0;
+			return 2;
+
+		default:
+			return -1;
+	}
+}
+
+/*
+ * Round a range out to cache lines and add it to the last one
+ * when they are close.
+ */
+static int gralloc_sync_add(const struct gralloc_sync_buffer *buf, size_t offset, size_t size,
+                            struct gralloc_sync_range *ranges, int count, int max)
+{
+	size_t start = offset & ~(size_t)(GRALLOC_SYNC_LINE - 1);
+	size_t end = GRALLOC_SYNC_ALIGN(offset + size, GRALLOC_SYNC_LINE);
+
+	if (end > buf->size)
+	{
+		end = buf->size;
+	}
+
+	if (start >= end)
+	{
+		return count;
+	}
+
+	if (count > 0)
+	{
+		struct gralloc_sync_range *last = &ranges[count - 1];
+		size_t last_end = last->offset + last->size;
+
+		if (start >= last->offset && start <= last_end + GRALLOC_SYNC_MERGE_GAP)
+		{
+			if (end > last_end)
+			{
+				last->size = end - last->offset;
+			}
+
+			return count;
+		}
+	}
+
+	if (count >= max)
+	{
+		return -1;
+	}
+
+	ranges[count].offset = start;
+	ranges[count].size = end - start;
+
+	return count + 1;
+}
+
+int gralloc_sync_ranges(const struct gralloc_sync_buffer *buf, int l, int t, int w, int h,
+                        struct gralloc_sync_range *ranges, int max)
+{
+	struct gralloc_sync_plane planes[3];
+	int num = gralloc_sync_planes(buf, planes);
+	int count = 0;
+
+	for (int i = 0; i < num && count >= 0; i++)
+	{
+		struct gralloc_sync_plane *p = &planes[i];
+
+		if (p->whole)
+		{
+			count = gralloc_sync_add(buf, p->offset, p->whole, ranges, count, max);
+			continue;
+		}
+
+		size_t rows = (buf->height + p->vsub - 1) / p->vsub;
+		size_t y0 = t / p->vsub;
+		size_t y1 = (t + h + p->vsub - 1) / p->vsub;
+		size_t x0 = (l / p->hsub) * p->bytes;
+		size_t x1 = ((l + w + p->hsub - 1) / p->hsub) * p->bytes;
+
+		if (y1 > rows)
+		{
+			y1 = rows;
+		}
+
+		if (y0 >= y1)
+		{
+			continue;
+		}
+
+		if (y1 - y0 > GRALLOC_SYNC_ROWS_MAX)
+		{
+			/* the gaps between the rows are maintained too */
+			size_t start = p->offset + y0 * p->pitch + x0;
+
+			count = gralloc_sync_add(buf, start, p->offset + (y1 - 1) * p->pitch + x1 - start, ranges, count, max);
+			continue;
+		}
+
+		for (size_t y = y0; y < y1 && count >= 0; y++)
+		{
+			count = gralloc_sync_add(buf, p->offset + y * p->pitch + x0, x1 - x0, ranges, count, max);
+		}
+	}
+
+	return (num < 0) ? -1 : count;
+}
+
+size_t gralloc_sync_rect(const struct gralloc_sync_ops *ops, void *ctx, int op, const struct gralloc_sync_buffer *buf,
+                         int l, int t, int w, int h, int full_pct)
+{
+	struct gralloc_sync_range ranges[GRALLOC_SYNC_RANGES_MAX];
+	size_t bytes = 0;
+	int count = -1;
+
+	if (l < 0)
+	{
+		w += l;
+		l = 0;
+	}
+
+	if (t < 0)
+	{
+		h += t;
+		t = 0;
+	}
+
+	if (l + w > buf->width)
+	{
+		w = buf->width - l;
+	}
+
+	if (t + h > buf->height)
+	{
+		h = buf->height - t;
+	}
+
+	if (ops->range != NULL && w > 0 && h > 0)
+	{
+		count = gralloc_sync_ranges(buf, l, t, w, h, ranges, GRALLOC_SYNC_RANGES_MAX);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		bytes += ranges[i].size;
+	}
+
+	if (count < 0 || bytes * 100 > buf->size * full_pct)
+	{
+		ops->all(ctx, op);
+		return buf->size;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (ops->range(ctx, op, ranges[i].offset, ranges[i].size) != 0)
+		{
+			ops->all(ctx, op);
+			return buf->size;
+		}
+	}
+
+	return bytes;
+}
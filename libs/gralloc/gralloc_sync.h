@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2010 ARM Limited. All rights reserved.
+ *
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GRALLOC_SYNC_H_
+#define GRALLOC_SYNC_H_
+
+#include <stddef.h>
+
+/*
+ * Cache maintenance of the rectangle of a lock, rather than of the
+ * whole buffer.
+ */
+
+/* the cpu cache line, ranges are rounded out to it */
+#define GRALLOC_SYNC_LINE           64
+
+/* ranges closer than this are maintained as one */
+#define GRALLOC_SYNC_MERGE_GAP      (4 * GRALLOC_SYNC_LINE)
+
+/* a plane with more rows in the rectangle is maintained as one span */
+#define GRALLOC_SYNC_ROWS_MAX       32
+
+/* ranges of one maintenance at most, 3 planes of GRALLOC_SYNC_ROWS_MAX */
+#define GRALLOC_SYNC_RANGES_MAX     (3 * GRALLOC_SYNC_ROWS_MAX)
+
+/*
+ * Above this percentage of the buffer the whole buffer is maintained,
+ * debug.gralloc.sync_pct overrides it.
+ */
+#define GRALLOC_SYNC_FULL_PCT       50
+
+enum
+{
+	GRALLOC_SYNC_INVALIDATE,
+	GRALLOC_SYNC_CLEAN,
+};
+
+/* the layout of private_handle_t */
+struct gralloc_sync_buffer
+{
+	int format;
+	int width;
+	int height;
+	int stride;
+	size_t size;
+};
+
+struct gralloc_sync_range
+{
+	size_t offset;
+	size_t size;
+};
+
+/*
+ * The cache maintenance under the rectangles, ION on the device.
+ * range is NULL when the buffer can only be maintained whole.
+ */
+struct gralloc_sync_ops
+{
+	/* return value: 0 on success, the whole buffer is maintained otherwise */
+	int (*range)(void *ctx, int op, size_t offset, size_t size);
+
+	void (*all)(void *ctx, int op);
+};
+
+/*
+ * The byte ranges under the pixels of rectangle l, t, w, h of every
+ * plane of buf, rounded to cache lines and merged, in offset order.
+ * return value: the number of ranges, -1 if the format is not known
+ * or there are more than max.
+ */
+int gralloc_sync_ranges(const struct gralloc_sync_buffer *buf, int l, int t, int w, int h,
+                        struct gralloc_sync_range *ranges, int max);
+
+/*
+ * Clean or invalidate the rectangle l, t, w, h of buf, or the whole
+ * buffer when the ranges cover more than full_pct percent of it.
+ * An empty rectangle stands for the whole buffer.
+ * return value: the number of bytes maintained.
+ */
+size_t gralloc_sync_rect(const struct gralloc_sync_ops *ops, void *ctx, int op, const struct gralloc_sync_buffer *buf,
+                         int l, int t, int w, int h, int full_pct);
+
+#endif /* GRALLOC_SYNC_H_ */
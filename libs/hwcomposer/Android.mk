@@ -30,6 +30,7 @@ LOCAL_SRC_FILES := SprdHWComposer.cpp \
 		   SprdHWLayer.cpp \
 		   SprdPrimaryDisplayDevice/SprdPrimaryDisplayDevice.cpp \
 		   SprdPrimaryDisplayDevice/SprdVsyncEvent.cpp \
+		   SprdPrimaryDisplayDevice/SprdVsyncModel.cpp \
 		   SprdPrimaryDisplayDevice/SprdHWLayerList.cpp \
 		   SprdPrimaryDisplayDevice/SprdOverlayPlane.cpp \
 		   SprdPrimaryDisplayDevice/SprdPrimaryPlane.cpp \
@@ -60,6 +61,7 @@ ifeq ($(strip $(TARGET_BOARD_PLATFORM)),sc8830)
 DEVICE_WITH_GSP := true
 DEVICE_OVERLAYPLANE_BORROW_PRIMARYPLANE_BUFFER := true
 DEVICE_USE_FB_HW_VSYNC := true
+#DEVICE_USE_VSYNC_PREDICT := true
 DEVICE_DIRECT_DISPLAY_SINGLE_OSD_LAYER := true
 endif
 ifeq ($(strip $(TARGET_BOARD_PLATFORM)),scx15)
@@ -73,6 +75,13 @@ ifeq ($(strip $(DEVICE_USE_FB_HW_VSYNC)),true)
 	LOCAL_CFLAGS += -DUSE_FB_HW_VSYNC
 endif
 
+#DEVICE_USE_VSYNC_PREDICT runs the hardware vsync on a timer
+#locked to the display, the fb driver vsync is only waited for
+#a few frames every two seconds to resynchronise.
+ifeq ($(strip $(DEVICE_USE_VSYNC_PREDICT)),true)
+	LOCAL_CFLAGS += -DVSYNC_USE_PREDICT
+endif
+
 #SPRD_HWC_DEBUG_TRACE := true
 
 ifeq ($(strip $(DEVICE_WITH_GSP)),true)
@@ -138,6 +147,8 @@ ifeq ($(strip $(USE_OVERLAY_COMPOSER_GPU)),true)
 
 	LOCAL_SRC_FILES += OverlayComposer/Layer.cpp
 
+	LOCAL_SRC_FILES += OverlayComposer/OverlayDamage.cpp
+
 	LOCAL_SRC_FILES += OverlayComposer/Utility.cpp
 
 	LOCAL_SRC_FILES += OverlayComposer/SyncThread.cpp
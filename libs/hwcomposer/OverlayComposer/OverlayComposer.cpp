@@ -32,6 +32,11 @@
 #include "GLErro.h"
 #include "Layer.h"
 #include "SyncThread.h"
+#include "dump.h"
+
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
 
 
 namespace android
@@ -49,7 +54,11 @@ OverlayComposer::OverlayComposer(SprdPrimaryPlane *displayPlane, sp<OverlayNativ
       mFlags(0),
       mMaxTextureSize(0),
       mWormholeTexName(-1),
-      mProtectedTexName(-1)
+      mProtectedTexName(-1),
+      mDamage(displayPlane->getWidth(), displayPlane->getHeight()),
+      mBufferAgeFlag(false),
+      mDamageResetFlag(false),
+      mDebugFlag(0)
 {
 };
 
@@ -173,6 +182,12 @@ bool OverlayComposer::initEGL()
     eglInitialize(display, NULL, NULL);
     eglGetConfigs(display, NULL, 0, &numConfigs);
 
+    /*
+     *  Without the buffer age, every frame is drawn in full.
+     * */
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    mBufferAgeFlag = (extensions != NULL && strstr(extensions, "EGL_EXT_buffer_age") != NULL);
+
     EGLConfig config = NULL;
     err = selectConfigForPixelFormat(display, attribs, format, &config);
     ALOGE_IF(err, "couldn't find an EGLConfig matching the screen format");
@@ -372,22 +387,46 @@ void OverlayComposer::caculateLayerRect(hwc_layer_1_t  *l, struct LayerRect *rec
     rV->bottom = l->displayFrame.bottom;
 }
 
-void OverlayComposer::ClearOverlayComposerBuffer()
+void OverlayComposer::setScissor(struct LayerRect *r)
 {
-    static GLfloat vertices[] = {
-        0.0f, 0.0f,
-        0.0f, 0.0f,
-        0.0f,  0.0f,
-        0.0f,  0.0f
-    };
+    unsigned int mFBHeight = mDisplayPlane->getHeight();
 
-    glColor4f(0.0f, 0.0f, 0.0f, 1.0f);
-    glDisable(GL_TEXTURE_EXTERNAL_OES);
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_BLEND);
+    /*
+     *  The scissor box has a bottom-left origin.
+     * */
+    glScissor(r->left, mFBHeight - r->bottom,
+              r->right - r->left, r->bottom - r->top);
+}
+
+void OverlayComposer::ClearOverlayComposerBuffer(struct LayerRect *r)
+{
+    setScissor(r);
 
-    glVertexPointer(2, GL_FLOAT, 0, vertices);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+int OverlayComposer::queryBufferAge()
+{
+    EGLint age = 0;
+
+    if (mBufferAgeFlag == false)
+    {
+        return 0;
+    }
+
+    if (eglQuerySurface(mDisplay, mSurface, EGL_BUFFER_AGE_EXT, &age) == EGL_FALSE)
+    {
+        checkEGLErrors("eglQuerySurface");
+        return 0;
+    }
+
+    return age;
+}
+
+void OverlayComposer::invalidateDamage()
+{
+    mDamageResetFlag = true;
 }
 
 
@@ -423,6 +462,32 @@ int OverlayComposer::composerHWLayers()
     //    return status;
     //}
 
+    queryDebugFlag(&mDebugFlag);
+
+    if (mDamageResetFlag)
+    {
+        mDamage.reset();
+        mDamageResetFlag = false;
+    }
+
+    struct OverlayDamageRegion region;
+    int bufferAge = queryBufferAge();
+    unsigned int pixels = mDamage.update(mList, bufferAge, &region);
+
+    ALOGI_IF(mDebugFlag, "OverlayComposer buffer age: %d, damage %d rects, %u pixels",
+             bufferAge, region.count, pixels);
+
+    /*
+     *  Clear the damaged rects first, then draw the layers
+     *  from bottom to top into each rect they cross.
+     *  The rects do not overlap.
+     * */
+    glEnable(GL_SCISSOR_TEST);
+    for (int j = 0; j < region.count; j++)
+    {
+        ClearOverlayComposerBuffer(&(region.rects[j]));
+    }
+
     for (unsigned int i = 0; i < mList->numHwLayers; i++)
     {
         hwc_layer_1_t  *pL = &(mList->hwLayers[i]);
@@ -447,6 +512,32 @@ int OverlayComposer::composerHWLayers()
             continue;
         }
 
+        struct LayerRect r;
+        struct LayerRect rV;
+
+        memset(&r, 0, sizeof(struct LayerRect));
+        memset(&rV, 0, sizeof(struct LayerRect));
+        caculateLayerRect(pL, &r, &rV);
+
+        bool damaged = false;
+        for (int j = 0; j < region.count; j++)
+        {
+            if (OverlayDamage::intersect(&rV, &(region.rects[j])))
+            {
+                damaged = true;
+                break;
+            }
+        }
+
+        /*
+         *  The layer is not in the damage,
+         *  no need to import its buffer.
+         * */
+        if (damaged == false)
+        {
+            continue;
+        }
+
         glMatrixMode(GL_MODELVIEW);
         glLoadIdentity();
 
@@ -454,22 +545,24 @@ int OverlayComposer::composerHWLayers()
         if (L == NULL)
         {
             ALOGE("The %dth Layer object is NULL", numLayer);
+            glDisable(GL_SCISSOR_TEST);
             status = -1;
             return status;
         }
 
-        struct LayerRect r;
-        struct LayerRect rV;
-
-        memset(&r, 0, sizeof(struct LayerRect));
-        caculateLayerRect(pL, &r, &rV);
-
         L->setLayerTransform(pL->transform);
         L->setLayerRect(&r, &rV);
         L->setLayerAlpha(pL->planeAlpha);
         L->setBlendFlag(pL->blending);
 
-        L->draw();
+        for (int j = 0; j < region.count; j++)
+        {
+            if (OverlayDamage::intersect(&rV, &(region.rects[j])))
+            {
+                setScissor(&(region.rects[j]));
+                L->draw();
+            }
+        }
 
 
         /*
@@ -478,6 +571,7 @@ int OverlayComposer::composerHWLayers()
         mDrawLayerList.push_back(L);
     }
 
+    glDisable(GL_SCISSOR_TEST);
 
     status = 0;
 
@@ -89,6 +89,7 @@
 #include "../SprdPrimaryDisplayDevice/SprdFrameBufferHAL.h"
 
 #include "OverlayNativeWindow.h"
+#include "OverlayDamage.h"
 #include "Layer.h"
 
 
@@ -110,6 +111,12 @@ public:
     /* Start display the composered Overlay Buffer */
     void onDisplay();
 
+    /*
+     *  The Overlay buffers were written by others,
+     *  the next frame is drawn in full.
+     * */
+    void invalidateDamage();
+
 private:
 
     /* Overlay composer Info */
@@ -139,6 +146,16 @@ private:
     typedef List<Layer * > DrawLayerList;
     DrawLayerList mDrawLayerList;
 
+    /*
+     *  Damage tracking, only the damaged rects of the
+     *  Overlay buffer are cleared and drawn again.
+     *  The buffer age is from EGL_EXT_buffer_age.
+     * */
+    OverlayDamage   mDamage;
+    bool            mBufferAgeFlag;
+    volatile bool   mDamageResetFlag;
+    int             mDebugFlag;
+
 
     static status_t selectConfigForPixelFormat(
                                  EGLDisplay dpy,
@@ -150,7 +167,9 @@ private:
     bool initEGL();
     void deInitEGL();
 
-    void ClearOverlayComposerBuffer();
+    void setScissor(struct LayerRect *r);
+    void ClearOverlayComposerBuffer(struct LayerRect *r);
+    int queryBufferAge();
     void caculateLayerRect(hwc_layer_1_t  *l, struct LayerRect *rect, struct LayerRect *rV);
 
     bool swapBuffers();
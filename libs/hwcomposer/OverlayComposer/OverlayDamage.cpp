@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/******************************************************************************
+ **                   Edit    History                                         *
+ **---------------------------------------------------------------------------*
+ ** DATE          Module              DESCRIPTION                             *
+ ** 16/08/2013    Hardware Composer   Add a new feature to Harware composer,  *
+ **                                   verlayComposer use GPU to do the        *
+ **                                   Hardware layer blending on Overlay      *
+ **                                   buffer, and then post the OVerlay       *
+ **                                   buffer to Display                       *
+ ******************************************************************************
+ ** Author:         zhongjun.chen@spreadtrum.com                              *
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "OverlayDamage.h"
+
+
+namespace android
+{
+
+/*
+ *  Layer::prepareDrawData aligns the vertices to even pixels
+ *  and the texture is filtered, so a damaged frame grows by a
+ *  few pixels.
+ * */
+#define OVERLAY_DAMAGE_MARGIN       2
+
+/*
+ *  Past this part of the buffer, in 1/16, the whole buffer is drawn.
+ * */
+#define OVERLAY_DAMAGE_FULL_RATIO   14
+
+OverlayDamage::OverlayDamage(unsigned int width, unsigned int height)
+    : mWidth(width), mHeight(height),
+      mValid(false),
+      mLayerCount(0),
+      mHistoryCount(0)
+{
+    memset(mLayers, 0, sizeof(mLayers));
+    memset(mHistory, 0, sizeof(mHistory));
+}
+
+OverlayDamage::~OverlayDamage()
+{
+}
+
+void OverlayDamage::reset()
+{
+    mValid = false;
+    mLayerCount = 0;
+    mHistoryCount = 0;
+}
+
+bool OverlayDamage::intersect(const struct LayerRect *frame, const struct LayerRect *r)
+{
+    return (frame->left < r->right + OVERLAY_DAMAGE_MARGIN &&
+            r->left < frame->right + OVERLAY_DAMAGE_MARGIN &&
+            frame->top < r->bottom + OVERLAY_DAMAGE_MARGIN &&
+            r->top < frame->bottom + OVERLAY_DAMAGE_MARGIN);
+}
+
+void OverlayDamage::setFull(struct OverlayDamageRegion *region)
+{
+    region->count = 1;
+    region->rects[0].left = 0;
+    region->rects[0].top = 0;
+    region->rects[0].right = mWidth;
+    region->rects[0].bottom = mHeight;
+}
+
+bool OverlayDamage::isFull(const struct OverlayDamageRegion *region)
+{
+    return (region->count == 1 &&
+            region->rects[0].left == 0 && region->rects[0].top == 0 &&
+            region->rects[0].right == mWidth && region->rects[0].bottom == mHeight);
+}
+
+unsigned int OverlayDamage::area(const struct OverlayDamageRegion *region)
+{
+    unsigned int pixels = 0;
+
+    for (int i = 0; i < region->count; i++)
+    {
+        pixels += rectArea(&(region->rects[i]));
+    }
+
+    return pixels;
+}
+
+/*
+ *  The rects of a region do not overlap. A rect that touches
+ *  one of them is merged into it, when the region is full the
+ *  two rects whose union grows least are merged.
+ * */
+void OverlayDamage::addRect(struct OverlayDamageRegion *region, const struct LayerRect *r)
+{
+    struct LayerRect u = *r;
+    int i = 0;
+
+    if (u.left >= u.right || u.top >= u.bottom)
+    {
+        return;
+    }
+
+    while (i < region->count)
+    {
+        struct LayerRect *p = &(region->rects[i]);
+
+        if (u.left <= p->right && p->left <= u.right &&
+            u.top <= p->bottom && p->top <= u.bottom)
+        {
+            u.left = MIN(u.left, p->left);
+            u.top = MIN(u.top, p->top);
+            u.right = MAX(u.right, p->right);
+            u.bottom = MAX(u.bottom, p->bottom);
+
+            region->count--;
+            region->rects[i] = region->rects[region->count];
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    if (region->count == OVERLAY_DAMAGE_RECT_MAX)
+    {
+        uint32_t best = 0xFFFFFFFF;
+        int index = 0;
+
+        for (i = 0; i < region->count; i++)
+        {
+            struct LayerRect *p = &(region->rects[i]);
+            struct LayerRect m;
+
+            m.left = MIN(u.left, p->left);
+            m.top = MIN(u.top, p->top);
+            m.right = MAX(u.right, p->right);
+            m.bottom = MAX(u.bottom, p->bottom);
+            if (rectArea(&m) - rectArea(p) < best)
+            {
+                best = rectArea(&m) - rectArea(p);
+                index = i;
+            }
+        }
+
+        u.left = MIN(u.left, region->rects[index].left);
+        u.top = MIN(u.top, region->rects[index].top);
+        u.right = MAX(u.right, region->rects[index].right);
+        u.bottom = MAX(u.bottom, region->rects[index].bottom);
+
+        region->count--;
+        region->rects[index] = region->rects[region->count];
+
+        /*
+         *  The merged rect may touch others now.
+         * */
+        addRect(region, &u);
+        return;
+    }
+
+    region->rects[region->count] = u;
+    region->count++;
+}
+
+void OverlayDamage::addRegion(struct OverlayDamageRegion *region, const struct OverlayDamageRegion *r)
+{
+    for (int i = 0; i < r->count; i++)
+    {
+        addRect(region, &(r->rects[i]));
+    }
+}
+
+void OverlayDamage::addFrame(struct OverlayDamageRegion *region, const hwc_rect_t *frame)
+{
+    struct LayerRect r;
+    int left = frame->left - OVERLAY_DAMAGE_MARGIN;
+    int top = frame->top - OVERLAY_DAMAGE_MARGIN;
+    int right = frame->right + OVERLAY_DAMAGE_MARGIN;
+    int bottom = frame->bottom + OVERLAY_DAMAGE_MARGIN;
+
+    r.left = (left < 0) ? 0 : left;
+    r.top = (top < 0) ? 0 : top;
+    r.right = (right > (int)mWidth) ? mWidth : right;
+    r.bottom = (bottom > (int)mHeight) ? mHeight : bottom;
+
+    if (r.left >= r.right || r.top >= r.bottom)
+    {
+        return;
+    }
+
+    addRect(region, &r);
+}
+
+/*
+ *  Only the buffer of the layer changed.
+ * */
+void OverlayDamage::addLayer(struct OverlayDamageRegion *region, hwc_layer_1_t *l)
+{
+#ifdef HWC_DEVICE_API_VERSION_1_5
+    float cropWidth = l->sourceCropf.right - l->sourceCropf.left;
+    float cropHeight = l->sourceCropf.bottom - l->sourceCropf.top;
+
+    /*
+     *  Map the surface damage from the buffer to the display
+     *  when the layer is not rotated, otherwise take the frame.
+     * */
+    if (l->surfaceDamage.numRects > 0 && l->transform == 0 &&
+        cropWidth > 0 && cropHeight > 0)
+    {
+        float sx = (float)(l->displayFrame.right - l->displayFrame.left) / cropWidth;
+        float sy = (float)(l->displayFrame.bottom - l->displayFrame.top) / cropHeight;
+
+        for (size_t i = 0; i < l->surfaceDamage.numRects; i++)
+        {
+            const hwc_rect_t *d = &(l->surfaceDamage.rects[i]);
+            hwc_rect_t f;
+
+            f.left = l->displayFrame.left + (int)((d->left - l->sourceCropf.left) * sx);
+            f.top = l->displayFrame.top + (int)((d->top - l->sourceCropf.top) * sy);
+            f.right = l->displayFrame.left + (int)((d->right - l->sourceCropf.left) * sx + 0.999f);
+            f.bottom = l->displayFrame.top + (int)((d->bottom - l->sourceCropf.top) * sy + 0.999f);
+
+            f.left = (f.left < l->displayFrame.left) ? l->displayFrame.left : f.left;
+            f.top = (f.top < l->displayFrame.top) ? l->displayFrame.top : f.top;
+            f.right = (f.right > l->displayFrame.right) ? l->displayFrame.right : f.right;
+            f.bottom = (f.bottom > l->displayFrame.bottom) ? l->displayFrame.bottom : f.bottom;
+
+            addFrame(region, &f);
+        }
+
+        return;
+    }
+#endif
+
+    addFrame(region, &(l->displayFrame));
+}
+
+unsigned int OverlayDamage::update(hwc_display_contents_1_t *list, int bufferAge,
+                                   struct OverlayDamageRegion *region)
+{
+    struct OverlayDamageLayer layers[OVERLAY_DAMAGE_LAYER_MAX];
+    struct OverlayDamageRegion damage;
+    hwc_layer_1_t *drawn[OVERLAY_DAMAGE_LAYER_MAX];
+    int count = 0;
+    bool overflow = false;
+
+    memset(&damage, 0, sizeof(damage));
+
+    for (unsigned int i = 0; i < list->numHwLayers; i++)
+    {
+        hwc_layer_1_t *l = &(list->hwLayers[i]);
+
+        if (l->compositionType != HWC_OVERLAY || l->handle == NULL)
+        {
+            continue;
+        }
+
+        if (count == OVERLAY_DAMAGE_LAYER_MAX)
+        {
+            overflow = true;
+            break;
+        }
+
+        drawn[count] = l;
+        layers[count].handle = l->handle;
+        layers[count].sourceCropf = l->sourceCropf;
+        layers[count].displayFrame = l->displayFrame;
+        layers[count].transform = l->transform;
+        layers[count].blending = l->blending;
+        layers[count].planeAlpha = l->planeAlpha;
+        count++;
+    }
+
+    /*
+     *  The damage of this frame, the layers are matched
+     *  to the last frame by their order.
+     * */
+    if (mValid == false || overflow)
+    {
+        setFull(&damage);
+    }
+    else
+    {
+        int n = (count > mLayerCount) ? count : mLayerCount;
+
+        for (int i = 0; i < n && isFull(&damage) == false; i++)
+        {
+            if (i >= count)
+            {
+                addFrame(&damage, &(mLayers[i].displayFrame));
+                continue;
+            }
+
+            if (i >= mLayerCount)
+            {
+                addFrame(&damage, &(layers[i].displayFrame));
+                continue;
+            }
+
+            if (memcmp(&(layers[i].sourceCropf), &(mLayers[i].sourceCropf), sizeof(hwc_frect_t)) ||
+                memcmp(&(layers[i].displayFrame), &(mLayers[i].displayFrame), sizeof(hwc_rect_t)) ||
+                layers[i].transform != mLayers[i].transform ||
+                layers[i].blending != mLayers[i].blending ||
+                layers[i].planeAlpha != mLayers[i].planeAlpha)
+            {
+                addFrame(&damage, &(mLayers[i].displayFrame));
+                addFrame(&damage, &(layers[i].displayFrame));
+            }
+            else if (layers[i].handle != mLayers[i].handle)
+            {
+                addLayer(&damage, drawn[i]);
+            }
+        }
+    }
+
+    memmove(&(mHistory[1]), &(mHistory[0]),
+            (OVERLAY_DAMAGE_HISTORY - 1) * sizeof(struct OverlayDamageRegion));
+    mHistory[0] = damage;
+    if (mHistoryCount < OVERLAY_DAMAGE_HISTORY)
+    {
+        mHistoryCount++;
+    }
+
+    memcpy(mLayers, layers, count * sizeof(struct OverlayDamageLayer));
+    mLayerCount = overflow ? 0 : count;
+    mValid = (overflow == false);
+
+    /*
+     *  The buffer holds the frame of bufferAge frames ago,
+     *  it misses the damage of the frames since.
+     * */
+    memset(region, 0, sizeof(struct OverlayDamageRegion));
+    if (bufferAge <= 0 || bufferAge > mHistoryCount)
+    {
+        setFull(region);
+    }
+    else
+    {
+        for (int i = 0; i < bufferAge && isFull(region) == false; i++)
+        {
+            addRegion(region, &(mHistory[i]));
+        }
+
+        if (area(region) * 16 > mWidth * mHeight * OVERLAY_DAMAGE_FULL_RATIO)
+        {
+            setFull(region);
+        }
+    }
+
+    return area(region);
+}
+
+
+};
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/******************************************************************************
+ **                   Edit    History                                         *
+ **---------------------------------------------------------------------------*
+ ** DATE          Module              DESCRIPTION                             *
+ ** 16/08/2013    Hardware Composer   Add a new feature to Harware composer,  *
+ **                                   verlayComposer use GPU to do the        *
+ **                                   Hardware layer blending on Overlay      *
+ **                                   buffer, and then post the OVerlay       *
+ **                                   buffer to Display                       *
+ ******************************************************************************
+ ** Author:         zhongjun.chen@spreadtrum.com                              *
+ *****************************************************************************/
+
+
+#ifndef _OVERLAY_DAMAGE_H_
+#define _OVERLAY_DAMAGE_H_
+
+#include <stdint.h>
+#include <hardware/hwcomposer.h>
+
+#include "Utility.h"
+
+
+namespace android
+{
+
+/*
+ *  Frames of damage kept, a buffer older than this is drawn again.
+ * */
+#define OVERLAY_DAMAGE_HISTORY      4
+#define OVERLAY_DAMAGE_RECT_MAX     4
+#define OVERLAY_DAMAGE_LAYER_MAX    16
+
+/*
+ *  Rects of the Overlay buffer to clear and draw again,
+ *  in display coordinates, top-left origin.
+ * */
+struct OverlayDamageRegion {
+    int count;
+    struct LayerRect rects[OVERLAY_DAMAGE_RECT_MAX];
+};
+
+/*
+ *  What the last frame drew of one HWC_OVERLAY layer.
+ * */
+struct OverlayDamageLayer {
+    buffer_handle_t handle;
+    hwc_frect_t sourceCropf;
+    hwc_rect_t displayFrame;
+    uint32_t transform;
+    int32_t blending;
+    uint32_t planeAlpha;
+};
+
+/*
+ *  OverlayDamage tracks which part of the Overlay buffer changed
+ *  between frames. A layer is damaged where its buffer handle,
+ *  source crop, display frame, transform, blending or plane alpha
+ *  changed, or by its surface damage when HWC gives one.
+ *  The damage of the last frames is kept, so a buffer of age n
+ *  only needs the union of the last n frames to be drawn again.
+ * */
+class OverlayDamage
+{
+public:
+    OverlayDamage(unsigned int width, unsigned int height);
+    ~OverlayDamage();
+
+    /*
+     *  The content of the Overlay buffers is unknown,
+     *  the next frame is drawn in full.
+     * */
+    void reset();
+
+    /*
+     *  Compare the HWC_OVERLAY layers of list with the last frame,
+     *  and give the region to draw on a buffer of bufferAge.
+     *  bufferAge 0 means the buffer content is unknown.
+     *  return value: pixels of the region.
+     * */
+    unsigned int update(hwc_display_contents_1_t *list, int bufferAge,
+                        struct OverlayDamageRegion *region);
+
+    /*
+     *  Whether a layer of display frame draws into rect r,
+     *  the drawn area of a layer may pass its frame a little.
+     * */
+    static bool intersect(const struct LayerRect *frame, const struct LayerRect *r);
+
+private:
+    unsigned int mWidth;
+    unsigned int mHeight;
+    bool mValid;
+
+    struct OverlayDamageLayer mLayers[OVERLAY_DAMAGE_LAYER_MAX];
+    int mLayerCount;
+
+    /*
+     *  mHistory[0] is the damage of the last frame.
+     * */
+    struct OverlayDamageRegion mHistory[OVERLAY_DAMAGE_HISTORY];
+    int mHistoryCount;
+
+    void setFull(struct OverlayDamageRegion *region);
+    void addRect(struct OverlayDamageRegion *region, const struct LayerRect *r);
+    void addRegion(struct OverlayDamageRegion *region, const struct OverlayDamageRegion *r);
+    void addFrame(struct OverlayDamageRegion *region, const hwc_rect_t *frame);
+    void addLayer(struct OverlayDamageRegion *region, hwc_layer_1_t *l);
+    bool isFull(const struct OverlayDamageRegion *region);
+    unsigned int area(const struct OverlayDamageRegion *region);
+
+    inline uint32_t rectArea(const struct LayerRect *r)
+    {
+        return (r->right - r->left) * (r->bottom - r->top);
+    }
+
+    inline uint32_t MIN(uint32_t x, uint32_t y)
+    {
+        return ((x < y) ? x: y);
+    }
+
+    inline uint32_t MAX(uint32_t x, uint32_t y)
+    {
+        return ((x > y) ? x : y);
+    }
+};
+
+
+};
+
+#endif
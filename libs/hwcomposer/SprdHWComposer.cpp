@@ -246,6 +246,12 @@ int SprdHWComposer:: blank(int disp, int blank)
          * */
     }
 
+    if (disp == DISPLAY_PRIMARY && mPrimaryDisplay)
+    {
+        mPrimaryDisplay->invalidateLayerPlan();
+        mPrimaryDisplay->resyncVsync();
+    }
+
     /*
      *  DisplayC need implementing this feature.
      * */
@@ -284,6 +290,7 @@ int SprdHWComposer:: query(int what, int* value)
 
 void SprdHWComposer:: dump(char *buff, int buff_len)
 {
+    dumpPlanCache(buff, buff_len);
 }
 
 int SprdHWComposer:: getDisplayConfigs(int disp, uint32_t* configs, size_t* numConfigs)
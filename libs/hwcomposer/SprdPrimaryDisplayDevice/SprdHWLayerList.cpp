@@ -62,6 +62,24 @@ SprdHWLayerList::~SprdHWLayerList()
         delete [] mVideoLayerList;
         mVideoLayerList = NULL;
     }
+
+    if (mPlanKey)
+    {
+        delete [] mPlanKey;
+        mPlanKey = NULL;
+    }
+
+    if (mPlanNewKey)
+    {
+        delete [] mPlanNewKey;
+        mPlanNewKey = NULL;
+    }
+
+    if (mPlanCompositionType)
+    {
+        delete [] mPlanCompositionType;
+        mPlanCompositionType = NULL;
+    }
 }
 
 void SprdHWLayerList::dump_yuv(uint8_t* pBuffer,uint32_t aInBufSize)
@@ -130,6 +148,11 @@ int SprdHWLayerList:: updateGeometry(hwc_display_contents_1_t *list, int acceler
     mAcceleratorMode = ACCELERATOR_NON;
     mAcceleratorMode |= accelerator;
 
+    /*
+     *  mLayerList is built again, the layer plan is gone.
+     * */
+    mPlanValid = false;
+
     if (list == NULL)
     {
         ALOGE("updateGeometry input parameter list is NULL");
@@ -255,6 +278,8 @@ int SprdHWLayerList:: revisitGeometry(int *DisplayFlag, SprdPrimaryDisplayDevice
     uint32_t GXPMaxComposeVideoLayerCount = 0;
     bool GXPSupportVideoAndOSDBlending = false;
 
+    mPlaneReclaimFailed = false;
+
     if (mDisableHWCFlag)
     {
         return 0;
@@ -443,6 +468,8 @@ int SprdHWLayerList:: revisitGeometry(int *DisplayFlag, SprdPrimaryDisplayDevice
 #endif
 
     ret = mPrimary->reclaimPlaneBuffer(holdCond);
+    mPlaneHoldCond = holdCond;
+    mPlaneReclaimFailed = (ret == 1);
     if (ret == 1)
     {
         resetOverlayFlag(YUVLayer);
@@ -1381,3 +1408,215 @@ int SprdHWLayerList::checkHWLayerList(hwc_display_contents_1_t* list)
 
     return 0;
 }
+
+int SprdHWLayerList::buildPlanKey(hwc_display_contents_1_t *list)
+{
+    unsigned int count = list->numHwLayers;
+
+    if (count > mPlanKeySize)
+    {
+        if (mPlanKey)
+        {
+            delete [] mPlanKey;
+        }
+        if (mPlanNewKey)
+        {
+            delete [] mPlanNewKey;
+        }
+        if (mPlanCompositionType)
+        {
+            delete [] mPlanCompositionType;
+        }
+
+        mPlanValid = false;
+        mPlanKeySize = 0;
+        mPlanKey = new struct sprdLayerKey[count];
+        mPlanNewKey = new struct sprdLayerKey[count];
+        mPlanCompositionType = new int32_t[count];
+        if (mPlanKey == NULL || mPlanNewKey == NULL || mPlanCompositionType == NULL)
+        {
+            ALOGE("Cannot create layer plan");
+            return -1;
+        }
+        mPlanKeySize = count;
+    }
+
+    memset(mPlanNewKey, 0, count * sizeof(struct sprdLayerKey));
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        hwc_layer_1_t *layer = &list->hwLayers[i];
+        struct private_handle_t *privateH = (struct private_handle_t *)(layer->handle);
+        struct sprdLayerKey *key = &(mPlanNewKey[i]);
+
+        /*
+         *  Skip layers and the FramebufferTarget layer are not classified,
+         *  the FramebufferTarget handle is only set for commit.
+         * */
+        if (layer->flags & HWC_SKIP_LAYER)
+        {
+            key->flags |= SPRD_LAYER_KEY_SKIP;
+            continue;
+        }
+
+        if (layer->compositionType == HWC_FRAMEBUFFER_TARGET)
+        {
+            key->flags |= SPRD_LAYER_KEY_FB_TARGET;
+            continue;
+        }
+
+        if (privateH)
+        {
+            key->flags |= SPRD_LAYER_KEY_HANDLE;
+            if ((privateH->usage & GRALLOC_USAGE_PROTECTED) == GRALLOC_USAGE_PROTECTED)
+            {
+                key->flags |= SPRD_LAYER_KEY_PROTECTED;
+            }
+            key->format = privateH->format;
+            key->width = privateH->width;
+            key->height = privateH->height;
+            key->privFlags = privateH->flags & (private_handle_t::PRIV_FLAGS_USES_PHY |
+                                                private_handle_t::PRIV_FLAGS_NOT_OVERLAY);
+            key->yuvInfo = privateH->yuv_info;
+        }
+
+        key->transform = layer->transform;
+        key->blending = layer->blending;
+        key->planeAlpha = layer->planeAlpha;
+        key->sourceCropf = layer->sourceCropf;
+        key->displayFrame = layer->displayFrame;
+    }
+
+    return 0;
+}
+
+int SprdHWLayerList::reusePlan(hwc_display_contents_1_t *list, int accelerator,
+                               int *DisplayFlag, SprdPrimaryDisplayDevice *mPrimary)
+{
+    if (list == NULL || DisplayFlag == NULL || mPrimary == NULL)
+    {
+        ALOGE("reusePlan input parameters error");
+        return -1;
+    }
+
+    queryDebugFlag(&mDebugFlag);
+
+    if (buildPlanKey(list) != 0)
+    {
+        mPlanValid = false;
+        return -1;
+    }
+
+    HWCLayerPreCheck();
+
+    if (mDisableHWCFlag || (mPlanValid == false)
+        || (accelerator != mPlanAccelerator)
+        || (list->numHwLayers != mPlanKeyCount)
+        || (list->numHwLayers != mLayerCount)
+        || memcmp(mPlanKey, mPlanNewKey, mPlanKeyCount * sizeof(struct sprdLayerKey)))
+    {
+        countPlanCache(HWC_PLAN_CACHE_MISS, mDebugFlag);
+        return -1;
+    }
+
+#ifdef DYNAMIC_RELEASE_PLANEBUFFER
+    if (mPrimary->reclaimPlaneBuffer(mPlaneHoldCond) == 1)
+    {
+        ALOGI_IF(mDebugFlag, "reusePlan alloc plane buffer failed, classify layers again");
+        invalidatePlan();
+        countPlanCache(HWC_PLAN_CACHE_MISS, mDebugFlag);
+        return -1;
+    }
+#endif
+
+    mList = list;
+
+    queryDumpFlag(&mDumpFlag);
+    if (HWCOMPOSER_DUMP_ORIGINAL_LAYERS & mDumpFlag)
+    {
+        dumpImage(mList);
+    }
+
+    /*
+     *  Only the buffers changed, rebind the layers and give
+     *  SurfaceFlinger the composition type and hints of the plan.
+     * */
+    for (unsigned int i = 0; i < mLayerCount; i++)
+    {
+        hwc_layer_1_t *layer = &list->hwLayers[i];
+
+        mLayerList[i].setAndroidLayer(layer);
+
+        if (mPlanKey[i].flags & (SPRD_LAYER_KEY_SKIP | SPRD_LAYER_KEY_FB_TARGET))
+        {
+            continue;
+        }
+
+        layer->compositionType = mPlanCompositionType[i];
+        if (mLayerList[i].getSprdLayerIndex() >= 0)
+        {
+            ClearFrameBuffer(layer, i);
+        }
+    }
+
+    if (mPlanFBTargetIndex >= 0)
+    {
+        mFBTargetLayer = &list->hwLayers[mPlanFBTargetIndex];
+    }
+
+    *DisplayFlag |= mPlanDisplayFlag;
+
+    ALOGI_IF(mDebugFlag, "reusePlan FB layer: %d, OSD layer: %d, video layer: %d",
+             mFBLayerCount, mOSDLayerCount, mVideoLayerCount);
+
+    countPlanCache(HWC_PLAN_CACHE_HIT, mDebugFlag);
+
+    return 0;
+}
+
+void SprdHWLayerList::savePlan(int accelerator, int DisplayFlag)
+{
+    struct sprdLayerKey *key = NULL;
+
+    /*
+     *  A frame whose plane buffer could not be allocated
+     *  is not a plan to repeat.
+     * */
+    if (mDisableHWCFlag || mPlaneReclaimFailed || mList == NULL
+        || mLayerCount == 0 || mLayerCount > mPlanKeySize
+        || mList->numHwLayers != mLayerCount)
+    {
+        mPlanValid = false;
+        return;
+    }
+
+    for (unsigned int i = 0; i < mLayerCount; i++)
+    {
+        mPlanCompositionType[i] = mList->hwLayers[i].compositionType;
+    }
+
+    mPlanFBTargetIndex = -1;
+    if (mFBTargetLayer >= &mList->hwLayers[0] &&
+        mFBTargetLayer < &mList->hwLayers[mLayerCount])
+    {
+        mPlanFBTargetIndex = mFBTargetLayer - &mList->hwLayers[0];
+    }
+
+    key = mPlanKey;
+    mPlanKey = mPlanNewKey;
+    mPlanNewKey = key;
+    mPlanKeyCount = mLayerCount;
+    mPlanAccelerator = accelerator;
+    mPlanDisplayFlag = DisplayFlag;
+    mPlanValid = true;
+}
+
+void SprdHWLayerList::invalidatePlan()
+{
+    if (mPlanValid)
+    {
+        countPlanCache(HWC_PLAN_CACHE_INVALIDATE, mDebugFlag);
+    }
+
+    mPlanValid = false;
+}
@@ -58,6 +58,30 @@ using namespace android;
 
 class SprdPrimaryDisplayDevice;
 
+/*
+ *  The inputs of the classification of one layer.
+ *  While the keys of all layers and the accelerator are unchanged,
+ *  prepare reuses the layer plan of the last frame.
+ * */
+#define SPRD_LAYER_KEY_SKIP       (0x00000001)
+#define SPRD_LAYER_KEY_FB_TARGET  (0x00000002)
+#define SPRD_LAYER_KEY_HANDLE     (0x00000004)
+#define SPRD_LAYER_KEY_PROTECTED  (0x00000008)
+
+struct sprdLayerKey {
+    uint32_t flags;
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    int32_t privFlags;
+    int32_t yuvInfo;
+    uint32_t transform;
+    int32_t blending;
+    uint32_t planeAlpha;
+    hwc_frect_t sourceCropf;
+    hwc_rect_t displayFrame;
+};
+
 /*
  *  Mainly responsible for traversaling HWLayer list,
  *  find layers that meet SprdDisplayPlane specification
@@ -82,7 +106,16 @@ public:
           mDisableHWCFlag(false),
           mSkipLayerFlag(false),
           mPData(NULL),
-          mDebugFlag(0), mDumpFlag(0)
+          mDebugFlag(0), mDumpFlag(0),
+          mPlanValid(false),
+          mPlanAccelerator(ACCELERATOR_NON),
+          mPlanDisplayFlag(HWC_DISPLAY_MASK),
+          mPlanFBTargetIndex(-1),
+          mPlanKeyCount(0), mPlanKeySize(0),
+          mPlanKey(NULL), mPlanNewKey(NULL),
+          mPlanCompositionType(NULL),
+          mPlaneHoldCond(false),
+          mPlaneReclaimFailed(false)
     {
     }
     ~SprdHWLayerList();
@@ -102,6 +135,26 @@ public:
 
     int checkHWLayerList(hwc_display_contents_1_t* list);
 
+    /*
+     *  Reuse the layer plan of the last frame if the layer list
+     *  geometry is the same, only the Android layers are rebound.
+     *  return value:
+     *      0: plan reused, DisplayFlag is set.
+     *      -1: updateGeometry and revisitGeometry are needed.
+     * */
+    int reusePlan(hwc_display_contents_1_t *list, int accelerator,
+                  int *DisplayFlag, SprdPrimaryDisplayDevice *mPrimary);
+
+    /*
+     *  Keep the plan of updateGeometry and revisitGeometry.
+     * */
+    void savePlan(int accelerator, int DisplayFlag);
+
+    /*
+     *  The display state changed, classify the next frame again.
+     * */
+    void invalidatePlan();
+
     inline SprdHWLayer *getSprdLayer(unsigned int index)
     {
         return &(mLayerList[index]);
@@ -175,6 +228,23 @@ private:
     int mDebugFlag;
     int mDumpFlag;
 
+    /*
+     *  Layer plan cache.
+     * */
+    bool mPlanValid;
+    int mPlanAccelerator;
+    int mPlanDisplayFlag;
+    int mPlanFBTargetIndex;
+    unsigned int mPlanKeyCount;
+    unsigned int mPlanKeySize;
+    struct sprdLayerKey *mPlanKey;
+    struct sprdLayerKey *mPlanNewKey;
+    int32_t *mPlanCompositionType;
+    bool mPlaneHoldCond;
+    bool mPlaneReclaimFailed;
+
+    int buildPlanKey(hwc_display_contents_1_t *list);
+
     /*
      *  Filter OSD layer
      * */
@@ -542,20 +542,30 @@ int SprdPrimaryDisplayDevice:: prepare(hwc_display_contents_1_t *list, unsigned
 
     acceleratorLocal = AcceleratorAdapt(accelerator);
 
-    ret = mLayerList->updateGeometry(list, acceleratorLocal);
+    /*
+     *  When only the buffers changed, the layer plan
+     *  of the last frame is still right.
+     * */
+    ret = mLayerList->reusePlan(list, acceleratorLocal, &displayFlag, this);
     if (ret != 0)
     {
-        ALOGE("(FILE:%s, line:%d, func:%s) updateGeometry failed",
-              __FILE__, __LINE__, __func__);
-        return -1;
-    }
+        ret = mLayerList->updateGeometry(list, acceleratorLocal);
+        if (ret != 0)
+        {
+            ALOGE("(FILE:%s, line:%d, func:%s) updateGeometry failed",
+                  __FILE__, __LINE__, __func__);
+            return -1;
+        }
 
-    ret = mLayerList->revisitGeometry(&displayFlag, this);
-    if (ret !=0)
-    {
-        ALOGE("(FILE:%s, line:%d, func:%s) revisitGeometry failed",
-              __FILE__, __LINE__, __func__);
-        return -1;
+        ret = mLayerList->revisitGeometry(&displayFlag, this);
+        if (ret !=0)
+        {
+            ALOGE("(FILE:%s, line:%d, func:%s) revisitGeometry failed",
+                  __FILE__, __LINE__, __func__);
+            return -1;
+        }
+
+        mLayerList->savePlan(acceleratorLocal, displayFlag);
     }
 
     ret = attachToDisplayPlane(displayFlag);
@@ -568,6 +578,14 @@ int SprdPrimaryDisplayDevice:: prepare(hwc_display_contents_1_t *list, unsigned
     return 0;
 }
 
+void SprdPrimaryDisplayDevice:: invalidateLayerPlan()
+{
+    if (mLayerList)
+    {
+        mLayerList->invalidatePlan();
+    }
+}
+
 int SprdPrimaryDisplayDevice:: commit(hwc_display_contents_1_t* list)
 {
     HWC_TRACE_CALL;
@@ -715,6 +733,15 @@ int SprdPrimaryDisplayDevice:: commit(hwc_display_contents_1_t* list)
 
         goto displayDone;
     }
+
+    /*
+     *  Other ways may write the SprdPrimaryPlane buffers,
+     *  OverlayComposer cannot trust its damage any more.
+     * */
+    if (mOverlayComposer != NULL)
+    {
+        mOverlayComposer->invalidateDamage();
+    }
 #endif
 
     if (DisplayOverlayPlane)
@@ -847,7 +874,16 @@ int SprdPrimaryDisplayDevice:: commit(hwc_display_contents_1_t* list)
 
    if (DisplayOverlayPlane || DisplayPrimaryPlane || DisplayFBTarget)
    {
-       mPrimaryPlane->display(DisplayOverlayPlane, DisplayPrimaryPlane, DisplayFBTarget);
+       bool sync = mPrimaryPlane->display(DisplayOverlayPlane, DisplayPrimaryPlane, DisplayFBTarget);
+
+       /*
+        *  A synchronous display ends on a vsync,
+        *  the timer vsync can follow it.
+        * */
+       if (sync && mVsyncEvent != NULL)
+       {
+           mVsyncEvent->addPresentSample(systemTime(CLOCK_MONOTONIC));
+       }
    }
 
 
@@ -876,6 +912,18 @@ void SprdPrimaryDisplayDevice:: setVsyncEventProcs(const hwc_procs_t *procs)
     VE->setVsyncEventProcs(procs);
 }
 
+void SprdPrimaryDisplayDevice:: resyncVsync()
+{
+    sp<SprdVsyncEvent> VE = getVsyncEventHandle();
+    if (VE == NULL)
+    {
+        ALOGE("getVsyncEventHandle failed");
+        return;
+    }
+
+    VE->resync();
+}
+
 void SprdPrimaryDisplayDevice:: eventControl(int enabled)
 {
     sp<SprdVsyncEvent> VE = getVsyncEventHandle();
@@ -105,6 +105,12 @@ public:
      * */
     void eventControl(int enabled);
 
+    /*
+     *  The display timing may have changed,
+     *  fit the vsync model again.
+     * */
+    void resyncVsync();
+
     /*
      *  Display configure attribution.
      * */
@@ -115,6 +121,12 @@ public:
      * */
     int reclaimPlaneBuffer(bool condition);
 
+    /*
+     *  The display state changed, do not reuse the
+     *  layer plan of the last frame.
+     * */
+    void invalidateLayerPlan();
+
 private:
     FrameBufferInfo   *mFBInfo;
     SprdHWLayerList   *mLayerList;
@@ -234,9 +234,10 @@ bool SprdPrimaryPlane::SetDisplayParameters(hwc_layer_1_t *AndroidLayer)
     return mDirectDisplayFlag;
 }
 
-void SprdPrimaryPlane::display(bool DisplayOverlayPlane, bool DisplayPrimaryPlane, bool DisplayFBTarget)
+bool SprdPrimaryPlane::display(bool DisplayOverlayPlane, bool DisplayPrimaryPlane, bool DisplayFBTarget)
 {
     int PlaneType = 0;
+    int ret = -1;
     struct overlay_display_setting displayContext;
 
     displayContext.display_mode = SPRD_DISPLAY_OVERLAY_ASYNC;
@@ -264,7 +265,7 @@ void SprdPrimaryPlane::display(bool DisplayOverlayPlane, bool DisplayPrimaryPlan
 
     ALOGI_IF(mDebugFlag, "SPRD_FB_DISPLAY_OVERLAY %d", PlaneType);
 
-    ioctl(mFBInfo->fbfd, SPRD_FB_DISPLAY_OVERLAY, &displayContext);
+    ret = ioctl(mFBInfo->fbfd, SPRD_FB_DISPLAY_OVERLAY, &displayContext);
 
     /*
      *  Restore some status.
@@ -274,6 +275,8 @@ void SprdPrimaryPlane::display(bool DisplayOverlayPlane, bool DisplayPrimaryPlan
     mDirectDisplayFlag = false;
 
     mDisplayFormat = mDefaultDisplayFormat;
+
+    return (ret == 0 && displayContext.display_mode == SPRD_DISPLAY_OVERLAY_SYNC);
 }
 
 void SprdPrimaryPlane::disable()
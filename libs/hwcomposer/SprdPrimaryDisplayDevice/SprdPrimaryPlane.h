@@ -83,8 +83,11 @@ public:
 
     /*
      *  Finally display Overlay plane and Primary plane buffer.
+     *  return value:
+     *      true: the display is synchronous, it returned after the frame was shown.
+     *      false: the display is asynchronous.
      * */
-    void display(bool DisplayOverlayPlane, bool DisplayPrimaryPlane, bool DisplayFBTarget);
+    bool display(bool DisplayOverlayPlane, bool DisplayPrimaryPlane, bool DisplayFBTarget);
 
     /*
      * Check whether SprdPrimaryPlane is available.
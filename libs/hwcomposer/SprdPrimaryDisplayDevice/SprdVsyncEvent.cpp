@@ -43,6 +43,16 @@
 #include "SprdFrameBufferHAL.h"
 #include "../SprdDisplayDevice.h"
 #include "../SprdTrace.h"
+#include "../dump.h"
+
+
+/*
+ *  sc8830 takes the vsync from the fb driver,
+ *  the others run vsync on a timer.
+ * */
+#if defined(USE_FB_HW_VSYNC) && !defined(_VSYNC_USE_SOFT_TIMER)
+#define VSYNC_USE_HW_EVENT
+#endif
 
 
 namespace android
@@ -53,7 +63,12 @@ extern "C" int clock_nanosleep(clockid_t clock_id, int flags,
 
 
 SprdVsyncEvent::SprdVsyncEvent()
-    : mProcs(NULL), mEnabled(false)
+    : mProcs(NULL), mEnabled(false),
+      mVSyncPeriod(1000000000 / 60),
+      mModel(mVSyncPeriod),
+      mNextFakeVsync(0), mLastVsync(0),
+      mVsyncCount(0), mHWEventCount(0),
+      mDebugFlag(0)
 {
     char const * const device_template[] =
     {
@@ -76,6 +91,11 @@ SprdVsyncEvent::SprdVsyncEvent()
     }
     mFbFd = fd;
     getVSyncPeriod();
+
+    mModel.setNominalPeriod(mVSyncPeriod);
+#ifdef VSYNC_USE_PREDICT
+    mModel.setPredictMode(true);
+#endif
 }
 SprdVsyncEvent::~SprdVsyncEvent()
 {
@@ -104,97 +124,162 @@ void SprdVsyncEvent::setVsyncEventProcs(const hwc_procs_t *procs)
     mProcs = procs;
 }
 
-bool SprdVsyncEvent::threadLoop() {
-    { // scope for lock
-        Mutex::Autolock _l(mLock);
-        while (!mEnabled) {
-            mCondition.wait(mLock);
-        }
-    }
+void SprdVsyncEvent::addPresentSample(nsecs_t timestamp)
+{
+#ifndef VSYNC_USE_HW_EVENT
+    Mutex::Autolock _l(mLock);
 
-    //8810 use sleep mode
-#ifdef _VSYNC_USE_SOFT_TIMER
-    static nsecs_t netxfakevsync = 0;
-    const nsecs_t period = mVSyncPeriod;;
-    const nsecs_t now = systemTime(CLOCK_MONOTONIC);
-    nsecs_t next_vsync = netxfakevsync;
-    nsecs_t sleep = next_vsync - now;
-    if (sleep < 0) {
-        // we missed, find where the next vsync should be
-        sleep = (period - ((now - next_vsync) % period));
-        next_vsync = now + sleep;
-    }
-    netxfakevsync = next_vsync + period;
+    /*
+     *  Without the hardware event, a synchronous display
+     *  is the only timestamp that follows a vsync.
+     * */
+    mModel.addSample(timestamp);
+#else
+    (void)timestamp;
+#endif
+}
 
+void SprdVsyncEvent::resync()
+{
+    Mutex::Autolock _l(mLock);
+    mModel.reset();
+}
+
+int SprdVsyncEvent::sleepUntil(nsecs_t t)
+{
     struct timespec spec;
-    spec.tv_sec  = next_vsync / 1000000000;
-    spec.tv_nsec = next_vsync % 1000000000;
+    spec.tv_sec  = t / 1000000000;
+    spec.tv_nsec = t % 1000000000;
 
     int err;
     do {
         err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &spec, NULL);
     } while (err<0 && errno == EINTR);
 
-    if (err == 0) {
+    return err;
+}
+
+void SprdVsyncEvent::postVsync(nsecs_t timestamp)
+{
     if(!mProcs || !mProcs->vsync)
     {
-        return true;
-    }
-        mProcs->vsync(mProcs, DISPLAY_PRIMARY, next_vsync);
-    }
-#else //8825 use driver vsync mode now use sleep for temporaryly
-#ifndef USE_FB_HW_VSYNC
-    static nsecs_t netxfakevsync = 0;
-    const nsecs_t period = mVSyncPeriod;
-    const nsecs_t now = systemTime(CLOCK_MONOTONIC);
-    nsecs_t next_vsync = netxfakevsync;
-    nsecs_t sleep = next_vsync - now;
-    if (sleep < 0) {
-        // we missed, find where the next vsync should be
-        sleep = (period - ((now - next_vsync) % period));
-        next_vsync = now + sleep;
+        ALOGW("device procs or vsync is null procs:%p , vsync:%p",
+              (void *)mProcs , mProcs ? (void *)(mProcs->vsync):NULL);
+        return;
     }
-    netxfakevsync = next_vsync + period;
 
-    struct timespec spec;
-    spec.tv_sec  = next_vsync / 1000000000;
-    spec.tv_nsec = next_vsync % 1000000000;
+    mProcs->vsync(mProcs, DISPLAY_PRIMARY, timestamp);
+    mLastVsync = timestamp;
 
-    int err;
-    do {
-        err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &spec, NULL);
-    } while (err<0 && errno == EINTR);
+    if (++mVsyncCount % 600 == 0)
+    {
+        Mutex::Autolock _l(mLock);
+
+        queryDebugFlag(&mDebugFlag);
+        ALOGI_IF(mDebugFlag, "vsync model: %s period %lld ns, error %lld ns, outliers %u, resets %u, hw events %u of %u",
+                 mModel.isLocked() ? "locked" : "unlocked",
+                 (long long)mModel.getPeriod(), (long long)mModel.getError(),
+                 mModel.getOutlierCount(), mModel.getResetCount(),
+                 mHWEventCount, mVsyncCount);
+    }
+}
+
+bool SprdVsyncEvent::threadLoop() {
+    { // scope for lock
+        Mutex::Autolock _l(mLock);
+        while (!mEnabled) {
+            mCondition.wait(mLock);
+        }
+    }
 
-    if (err == 0)
+#ifndef VSYNC_USE_HW_EVENT
+    /*
+     *  8810 use sleep mode, and 8825 until the driver vsync is ready.
+     *  Once the model is locked by synchronous displays, the timer
+     *  follows the display phase.
+     * */
+    const nsecs_t now = systemTime(CLOCK_MONOTONIC);
+    nsecs_t next_vsync;
     {
-        if(!mProcs || !mProcs->vsync)
+        Mutex::Autolock _l(mLock);
+
+        if (mModel.isLocked())
         {
-            return true;
+            nsecs_t t = mLastVsync + mModel.getPeriod() / 2;
+            next_vsync = mModel.vsyncAfter((now > t) ? now : t);
         }
+        else
+        {
+            const nsecs_t period = mVSyncPeriod;
+            next_vsync = mNextFakeVsync;
+            nsecs_t sleep = next_vsync - now;
+            if (sleep < 0) {
+                // we missed, find where the next vsync should be
+                sleep = (period - ((now - next_vsync) % period));
+                next_vsync = now + sleep;
+            }
+        }
+        mNextFakeVsync = next_vsync + mVSyncPeriod;
+    }
 
-        mProcs->vsync(mProcs, DISPLAY_PRIMARY, next_vsync);
+    if (sleepUntil(next_vsync) == 0)
+    {
+        postVsync(next_vsync);
     }
-    //may open when driver ready
 #else
     HWC_TRACE_BEGIN_VSYNC;
 
-    if (ioctl(mFbFd, FBIO_WAITFORVSYNC, NULL) == -1)
+    bool hardware;
     {
-        ALOGE("fail to wait vsync , mFbFd:%d" , mFbFd);
+        Mutex::Autolock _l(mLock);
+        hardware = mModel.waitHardware();
+    }
+
+    if (hardware)
+    {
+        if (ioctl(mFbFd, FBIO_WAITFORVSYNC, NULL) == -1)
+        {
+            ALOGE("fail to wait vsync , mFbFd:%d" , mFbFd);
+        }
+        else
+        {
+            /*
+             *  The wake-up time carries the scheduler latency,
+             *  post the vsync of the model instead.
+             * */
+            const nsecs_t now = systemTime(CLOCK_MONOTONIC);
+            nsecs_t timestamp;
+            {
+                Mutex::Autolock _l(mLock);
+                mModel.addSample(now);
+                timestamp = mModel.vsyncOf(now);
+            }
+            mHWEventCount++;
+
+            if (timestamp <= mLastVsync)
+            {
+                timestamp = now;
+            }
+            postVsync(timestamp);
+        }
     }
     else
     {
-        if(!mProcs || !mProcs->vsync)
+        nsecs_t next_vsync;
         {
-            ALOGW("device procs or vsync is null procs:%p , vsync:%p",
-                  (void *)mProcs , mProcs ? (void *)(mProcs->vsync):NULL);
-            return true;
+            Mutex::Autolock _l(mLock);
+            nsecs_t now = systemTime(CLOCK_MONOTONIC);
+            nsecs_t t = mLastVsync + mModel.getPeriod() / 2;
+            next_vsync = mModel.vsyncAfter((now > t) ? now : t);
+        }
+
+        if (sleepUntil(next_vsync) == 0)
+        {
+            postVsync(next_vsync);
         }
-        mProcs->vsync(mProcs, 0, systemTime(CLOCK_MONOTONIC));
     }
 
     HWC_TRACE_END;
-#endif
 #endif
 
     return true;
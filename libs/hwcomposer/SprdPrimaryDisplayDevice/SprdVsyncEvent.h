@@ -40,6 +40,8 @@
 #include <utils/threads.h>
 #include <hardware/hwcomposer.h>
 
+#include "SprdVsyncModel.h"
+
 namespace android
 {
 
@@ -52,13 +54,35 @@ class SprdVsyncEvent: public Thread
     virtual void onFirstRef();
     virtual bool threadLoop();
     int getVSyncPeriod();
+    int sleepUntil(nsecs_t t);
+    void postVsync(nsecs_t timestamp);
     int mFbFd;
     nsecs_t mVSyncPeriod;
+
+    /*
+     *  The vsync model is shared with commit, under mLock.
+     * */
+    SprdVsyncModel mModel;
+    nsecs_t mNextFakeVsync;
+    nsecs_t mLastVsync;
+    unsigned int mVsyncCount;
+    unsigned int mHWEventCount;
+    int mDebugFlag;
 public:
     SprdVsyncEvent();
     ~SprdVsyncEvent();
     void setEnabled(bool enabled);
     void setVsyncEventProcs(const hwc_procs_t *procs);
+
+    /*
+     *  A synchronous display finished at timestamp.
+     * */
+    void addPresentSample(nsecs_t timestamp);
+
+    /*
+     *  The display timing may have changed, fit the model again.
+     * */
+    void resync();
 };
 
 }
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/******************************************************************************
+ **                   Edit    History                                         *
+ **---------------------------------------------------------------------------*
+ ** DATE          Module              DESCRIPTION                             *
+ ** 22/09/2013    Hardware Composer   Responsible for processing some         *
+ **                                   Hardware layers. These layers comply    *
+ **                                   with display controller specification,  *
+ **                                   can be displayed directly, bypass       *
+ **                                   SurfaceFligner composition. It will     *
+ **                                   improve system performance.             *
+ ******************************************************************************
+ ** File: SprdVsyncModel.cpp          DESCRIPTION                             *
+ **                                   Fit the period and phase of the display *
+ **                                   vsync from event timestamps, predict    *
+ **                                   the vsync timestamps.                   *
+ ******************************************************************************
+ ******************************************************************************
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SprdVsyncModel.h"
+
+
+namespace android
+{
+
+/*
+ *  A sample may come before the model vsync by this much,
+ *  the model phase is an estimate.
+ * */
+#define VSYNC_MODEL_EARLY           1000000
+
+/*
+ *  Smallest distance from the model that rejects a sample.
+ * */
+#define VSYNC_MODEL_LIMIT_MIN       1000000
+
+/*
+ *  Smallest residual the fit trims.
+ * */
+#define VSYNC_MODEL_TRIM_MIN        100000
+
+/*
+ *  Drift of the model over VSYNC_MODEL_PREDICT_FRAMES allowed
+ *  in predicted mode, from the standard error of the period.
+ * */
+#define VSYNC_MODEL_DRIFT_MAX       100000
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+SprdVsyncModel::SprdVsyncModel(nsecs_t period)
+    : mNominalPeriod(period),
+      mSampleIndex(0), mSampleNum(0),
+      mLocked(false),
+      mPeriod((double)period),
+      mReference(0),
+      mError(0),
+      mPeriodError(0),
+      mOutliers(0),
+      mPredictMode(false),
+      mPredictFrames(0), mResyncFrames(0),
+      mOutlierTotal(0), mResetTotal(0)
+{
+    memset(mSamples, 0, sizeof(mSamples));
+}
+
+SprdVsyncModel::~SprdVsyncModel()
+{
+}
+
+void SprdVsyncModel::reset()
+{
+    mSampleIndex = 0;
+    mSampleNum = 0;
+    mLocked = false;
+    mPeriod = (double)mNominalPeriod;
+    mReference = 0;
+    mError = 0;
+    mPeriodError = 0;
+    mOutliers = 0;
+    mPredictFrames = 0;
+    mResyncFrames = 0;
+}
+
+void SprdVsyncModel::setNominalPeriod(nsecs_t period)
+{
+    mNominalPeriod = period;
+    reset();
+}
+
+void SprdVsyncModel::setPredictMode(bool enable)
+{
+    mPredictMode = enable;
+    mPredictFrames = 0;
+    mResyncFrames = 0;
+}
+
+/*
+ *  Median of the sample intervals, an interval may span
+ *  several vsyncs when events are missed.
+ * */
+double SprdVsyncModel::estimatePeriod(nsecs_t *samples, int count)
+{
+    double intervals[VSYNC_MODEL_SAMPLE_MAX];
+    double unit = mLocked ? mPeriod : (double)mNominalPeriod;
+    int n = 0;
+
+    for (int i = 1; i < count; i++)
+    {
+        double d = (double)(samples[i] - samples[i - 1]);
+        double m = floor(d / unit + 0.5);
+
+        if (m < 1)
+        {
+            continue;
+        }
+        intervals[n++] = d / m;
+    }
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    qsort(intervals, n, sizeof(double), compareDouble);
+
+    return intervals[n / 2];
+}
+
+/*
+ *  Least squares of the samples against their vsync index gives
+ *  the period. The event latency is never negative, so the phase
+ *  is taken from the early samples rather than the mean.
+ * */
+void SprdVsyncModel::fit()
+{
+    nsecs_t samples[VSYNC_MODEL_SAMPLE_MAX];
+    double k[VSYNC_MODEL_SAMPLE_MAX];
+    double y[VSYNC_MODEL_SAMPLE_MAX];
+    double r[VSYNC_MODEL_SAMPLE_MAX];
+    bool keep[VSYNC_MODEL_SAMPLE_MAX];
+    double a = 0;
+    double b = 0;
+    double rms = 0;
+    double skk = 0;
+    int oldest = (mSampleIndex - mSampleNum + VSYNC_MODEL_SAMPLE_MAX) % VSYNC_MODEL_SAMPLE_MAX;
+    int n = mSampleNum;
+    int kept = 0;
+
+    if (n < VSYNC_MODEL_SAMPLE_MIN)
+    {
+        mLocked = false;
+        return;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        samples[i] = mSamples[(oldest + i) % VSYNC_MODEL_SAMPLE_MAX];
+    }
+
+    /*
+     *  The samples may be far apart in predicted mode,
+     *  a locked period finds their vsync index best.
+     * */
+    double period = mLocked ? mPeriod : estimatePeriod(samples, n);
+
+    mLocked = false;
+    if (period <= 0)
+    {
+        return;
+    }
+
+    nsecs_t ref = samples[n - 1];
+    for (int i = 0; i < n; i++)
+    {
+        y[i] = (double)(samples[i] - ref);
+        k[i] = floor(y[i] / period + 0.5);
+        keep[i] = true;
+    }
+
+    /*
+     *  Fit, trim the samples far from the line, fit again.
+     * */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        double sk = 0, sy = 0, sky = 0;
+        double e2 = 0;
+
+        kept = 0;
+        for (int i = 0; i < n; i++)
+        {
+            if (keep[i] == false)
+            {
+                continue;
+            }
+            sk += k[i];
+            sy += y[i];
+            kept++;
+        }
+
+        if (kept < VSYNC_MODEL_SAMPLE_MIN)
+        {
+            return;
+        }
+
+        double mk = sk / kept;
+        double my = sy / kept;
+        skk = 0;
+        for (int i = 0; i < n; i++)
+        {
+            if (keep[i] == false)
+            {
+                continue;
+            }
+            skk += (k[i] - mk) * (k[i] - mk);
+            sky += (k[i] - mk) * (y[i] - my);
+        }
+
+        if (skk <= 0)
+        {
+            return;
+        }
+
+        b = sky / skk;
+        a = my - b * mk;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (keep[i])
+            {
+                double e = y[i] - a - b * k[i];
+                e2 += e * e;
+            }
+        }
+        rms = sqrt(e2 / kept);
+
+        if (pass == 0)
+        {
+            double limit = 3 * rms;
+
+            if (limit < VSYNC_MODEL_TRIM_MIN)
+            {
+                limit = VSYNC_MODEL_TRIM_MIN;
+            }
+
+            for (int i = 0; i < n; i++)
+            {
+                double e = y[i] - a - b * k[i];
+                keep[i] = (e <= limit && e >= -limit);
+            }
+        }
+    }
+
+    if (b <= 0)
+    {
+        return;
+    }
+
+    kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (keep[i])
+        {
+            r[kept++] = y[i] - b * k[i];
+        }
+    }
+    qsort(r, kept, sizeof(double), compareDouble);
+
+    mPeriod = b;
+    mReference = ref + (nsecs_t)r[kept / 8];
+    mError = rms;
+    mPeriodError = rms / sqrt(skk);
+    mLocked = true;
+}
+
+bool SprdVsyncModel::addSample(nsecs_t timestamp)
+{
+    bool used = true;
+
+    if (mSampleNum > 0)
+    {
+        int newest = (mSampleIndex - 1 + VSYNC_MODEL_SAMPLE_MAX) % VSYNC_MODEL_SAMPLE_MAX;
+
+        if (timestamp <= mSamples[newest])
+        {
+            return false;
+        }
+    }
+
+    if (mLocked)
+    {
+        double r = (double)(timestamp - vsyncOf(timestamp));
+        double limit = 4 * mError;
+
+        if (limit < VSYNC_MODEL_LIMIT_MIN)
+        {
+            limit = VSYNC_MODEL_LIMIT_MIN;
+        }
+        if (limit > mPeriod / 4)
+        {
+            limit = mPeriod / 4;
+        }
+
+        if (r > limit || r < -limit)
+        {
+            mOutlierTotal++;
+            mOutliers++;
+            if (mOutliers < VSYNC_MODEL_OUTLIER_MAX)
+            {
+                return false;
+            }
+
+            /*
+             *  The display timing changed, start a new fit
+             *  from this sample.
+             * */
+            reset();
+            mResetTotal++;
+            used = false;
+        }
+        else
+        {
+            mOutliers = 0;
+        }
+    }
+
+    mSamples[mSampleIndex] = timestamp;
+    mSampleIndex = (mSampleIndex + 1) % VSYNC_MODEL_SAMPLE_MAX;
+    if (mSampleNum < VSYNC_MODEL_SAMPLE_MAX)
+    {
+        mSampleNum++;
+    }
+
+    fit();
+
+    return used;
+}
+
+/*
+ *  The timer runs as long as the period error keeps the drift
+ *  small, each resynchronisation spreads the samples further
+ *  apart and makes the period better.
+ * */
+bool SprdVsyncModel::waitHardware()
+{
+    int frames = VSYNC_MODEL_PREDICT_FRAMES;
+
+    if (mLocked && mPeriodError > 0 &&
+        mPeriodError * VSYNC_MODEL_PREDICT_FRAMES > VSYNC_MODEL_DRIFT_MAX)
+    {
+        frames = (int)(VSYNC_MODEL_DRIFT_MAX / mPeriodError);
+    }
+
+    if (mPredictMode == false || mLocked == false ||
+        frames < VSYNC_MODEL_RESYNC_FRAMES)
+    {
+        mPredictFrames = 0;
+        mResyncFrames = 0;
+        return true;
+    }
+
+    if (mResyncFrames > 0)
+    {
+        mResyncFrames--;
+        return true;
+    }
+
+    mPredictFrames++;
+    if (mPredictFrames >= frames)
+    {
+        mPredictFrames = 0;
+        mResyncFrames = VSYNC_MODEL_RESYNC_FRAMES - 1;
+        return true;
+    }
+
+    return false;
+}
+
+nsecs_t SprdVsyncModel::vsyncBefore(nsecs_t t)
+{
+    double k = floor((double)(t - mReference) / mPeriod);
+
+    return mReference + (nsecs_t)(k * mPeriod);
+}
+
+nsecs_t SprdVsyncModel::vsyncOf(nsecs_t timestamp)
+{
+    if (mLocked == false)
+    {
+        return timestamp;
+    }
+
+    return vsyncBefore(timestamp + VSYNC_MODEL_EARLY);
+}
+
+nsecs_t SprdVsyncModel::vsyncAfter(nsecs_t t)
+{
+    if (mLocked == false)
+    {
+        return t + mNominalPeriod;
+    }
+
+    double k = floor((double)(t - mReference) / mPeriod) + 1;
+
+    return mReference + (nsecs_t)(k * mPeriod);
+}
+
+
+}
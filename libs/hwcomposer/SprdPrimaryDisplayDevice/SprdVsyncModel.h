@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/******************************************************************************
+ **                   Edit    History                                         *
+ **---------------------------------------------------------------------------*
+ ** DATE          Module              DESCRIPTION                             *
+ ** 22/09/2013    Hardware Composer   Responsible for processing some         *
+ **                                   Hardware layers. These layers comply    *
+ **                                   with display controller specification,  *
+ **                                   can be displayed directly, bypass       *
+ **                                   SurfaceFligner composition. It will     *
+ **                                   improve system performance.             *
+ ******************************************************************************
+ ** File: SprdVsyncModel.h            DESCRIPTION                             *
+ **                                   Fit the period and phase of the display *
+ **                                   vsync from event timestamps, predict    *
+ **                                   the vsync timestamps.                   *
+ ******************************************************************************
+ ******************************************************************************
+ *****************************************************************************/
+
+#ifndef _SPRD_VSYNC_MODEL_H_
+#define _SPRD_VSYNC_MODEL_H_
+
+#include <sys/types.h>
+#include <utils/Timers.h>
+
+
+namespace android
+{
+
+/*
+ *  Timestamps kept for the fit, and needed to lock.
+ * */
+#define VSYNC_MODEL_SAMPLE_MAX      32
+#define VSYNC_MODEL_SAMPLE_MIN      6
+
+/*
+ *  Consecutive rejected samples that drop the model,
+ *  the display timing changed.
+ * */
+#define VSYNC_MODEL_OUTLIER_MAX     4
+
+/*
+ *  In predicted mode, vsync runs on the timer for
+ *  VSYNC_MODEL_PREDICT_FRAMES, then waits for
+ *  VSYNC_MODEL_RESYNC_FRAMES hardware events.
+ * */
+#define VSYNC_MODEL_PREDICT_FRAMES  120
+#define VSYNC_MODEL_RESYNC_FRAMES   6
+
+/*
+ *  SprdVsyncModel fits the vsync period and phase from timestamps
+ *  taken after a vsync, the wake-up of FBIO_WAITFORVSYNC or the end
+ *  of a synchronous display. These timestamps come late by the
+ *  interrupt and scheduler latency, the model gives the vsync
+ *  they belong to without this jitter.
+ * */
+class SprdVsyncModel
+{
+public:
+    SprdVsyncModel(nsecs_t period);
+    ~SprdVsyncModel();
+
+    /*
+     *  Forget the samples, the display timing is unknown.
+     * */
+    void reset();
+
+    /*
+     *  The period from the panel timing, used until locked.
+     * */
+    void setNominalPeriod(nsecs_t period);
+
+    /*
+     *  Run vsync on the timer once locked,
+     *  resynchronise with the hardware now and then.
+     * */
+    void setPredictMode(bool enable);
+
+    /*
+     *  Add the timestamp of an event that follows a vsync.
+     *  return value:
+     *      true: the sample is used by the model.
+     *      false: the sample is too far from the model.
+     * */
+    bool addSample(nsecs_t timestamp);
+
+    /*
+     *  Whether the next vsync must wait for the hardware event.
+     *  Called once per vsync.
+     * */
+    bool waitHardware();
+
+    /*
+     *  The vsync that an event of timestamp follows.
+     * */
+    nsecs_t vsyncOf(nsecs_t timestamp);
+
+    /*
+     *  The first vsync after t.
+     * */
+    nsecs_t vsyncAfter(nsecs_t t);
+
+    inline bool isLocked()
+    {
+        return mLocked;
+    }
+
+    inline nsecs_t getPeriod()
+    {
+        return mLocked ? (nsecs_t)mPeriod : mNominalPeriod;
+    }
+
+    /*
+     *  RMS of the sample residuals, in ns.
+     * */
+    inline nsecs_t getError()
+    {
+        return (nsecs_t)mError;
+    }
+
+    inline unsigned int getOutlierCount()
+    {
+        return mOutlierTotal;
+    }
+
+    inline unsigned int getResetCount()
+    {
+        return mResetTotal;
+    }
+
+private:
+    nsecs_t mNominalPeriod;
+
+    /*
+     *  Ring of the last samples, mSampleIndex is the next to write.
+     * */
+    nsecs_t mSamples[VSYNC_MODEL_SAMPLE_MAX];
+    int mSampleIndex;
+    int mSampleNum;
+
+    bool mLocked;
+    double mPeriod;
+    nsecs_t mReference;
+    double mError;
+    double mPeriodError;
+    int mOutliers;
+
+    bool mPredictMode;
+    int mPredictFrames;
+    int mResyncFrames;
+
+    unsigned int mOutlierTotal;
+    unsigned int mResetTotal;
+
+    void fit();
+    double estimatePeriod(nsecs_t *samples, int count);
+    nsecs_t vsyncBefore(nsecs_t t);
+};
+
+
+}
+#endif
@@ -11,6 +11,7 @@ static int64_t GeometryChangedNum = 0;
 static bool GeometryChanged = false;
 static bool GeometryChangedFirst = false;
 char dumpPath[MAX_DUMP_PATH_LENGTH];
+static unsigned int PlanCacheCount[HWC_PLAN_CACHE_EVENT_MAX];
 
 using namespace android;
 
@@ -433,3 +434,51 @@ void dumpFrameBuffer(char *virAddr, const char* ptype, int width, int height, in
     dump_layer(dumpPath, virAddr, ptype, width, height, format, 2, index);
     index++;
 }
+
+void countPlanCache(int event, int debugFlag)
+{
+    unsigned int prepareCount = 0;
+    unsigned int hitRate = 0;
+
+    if (event < 0 || event >= HWC_PLAN_CACHE_EVENT_MAX)
+    {
+        return;
+    }
+
+    PlanCacheCount[event]++;
+
+    if (event == HWC_PLAN_CACHE_INVALIDATE)
+    {
+        return;
+    }
+
+    prepareCount = PlanCacheCount[HWC_PLAN_CACHE_HIT] + PlanCacheCount[HWC_PLAN_CACHE_MISS];
+    if (debugFlag && (prepareCount % HWC_PLAN_CACHE_LOG_PERIOD) == 0)
+    {
+        hitRate = (unsigned int)((uint64_t)PlanCacheCount[HWC_PLAN_CACHE_HIT] * 100 / prepareCount);
+        ALOGI("layer plan cache: hit %u, miss %u, invalidate %u, hit rate %u%%",
+              PlanCacheCount[HWC_PLAN_CACHE_HIT], PlanCacheCount[HWC_PLAN_CACHE_MISS],
+              PlanCacheCount[HWC_PLAN_CACHE_INVALIDATE], hitRate);
+    }
+}
+
+int dumpPlanCache(char *buff, int buff_len)
+{
+    unsigned int prepareCount = PlanCacheCount[HWC_PLAN_CACHE_HIT] + PlanCacheCount[HWC_PLAN_CACHE_MISS];
+    unsigned int hitRate = 0;
+
+    if (buff == NULL || buff_len <= 0)
+    {
+        return 0;
+    }
+
+    if (prepareCount > 0)
+    {
+        hitRate = (unsigned int)((uint64_t)PlanCacheCount[HWC_PLAN_CACHE_HIT] * 100 / prepareCount);
+    }
+
+    return snprintf(buff, buff_len,
+                    "  layer plan cache: hit %u, miss %u, invalidate %u, hit rate %u%%\n",
+                    PlanCacheCount[HWC_PLAN_CACHE_HIT], PlanCacheCount[HWC_PLAN_CACHE_MISS],
+                    PlanCacheCount[HWC_PLAN_CACHE_INVALIDATE], hitRate);
+}
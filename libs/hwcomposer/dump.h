@@ -96,6 +96,24 @@ extern void queryIntFlag(const char* strProperty,int *IntFlag);
 
 extern int dumpImage(hwc_display_contents_1_t *list);
 
+/*
+ *  Layer plan cache counters of the primary display, logged every
+ *  HWC_PLAN_CACHE_LOG_PERIOD prepares when debug.hwc.info is set
+ *  and printed by dumpsys SurfaceFlinger.
+ * */
+#define HWC_PLAN_CACHE_LOG_PERIOD 600
+typedef enum
+{
+    HWC_PLAN_CACHE_HIT,
+    HWC_PLAN_CACHE_MISS,
+    HWC_PLAN_CACHE_INVALIDATE,
+    HWC_PLAN_CACHE_EVENT_MAX
+} plan_cache_event;
+
+extern void countPlanCache(int event, int debugFlag);
+
+extern int dumpPlanCache(char *buff, int buff_len);
+
 extern int dumpOverlayImage(private_handle_t* buffer, const char* name);
 
 void dumpFrameBuffer(char *virAddr, const char* ptype, int width, int height, int format);
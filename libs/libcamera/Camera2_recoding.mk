@@ -38,6 +38,7 @@ LOCAL_SRC_FILES:= \
 	oem/src/cmr_oem.c \
 	oem/src/cmr_setting.c \
 	oem/src/cmr_mem.c \
+	oem/src/cmr_mem_plan.c \
 	oem/src/cmr_msg.c \
 	oem/src/cmr_scale.c \
 	oem/src/cmr_rotate.c \
@@ -51,8 +52,11 @@ LOCAL_SRC_FILES:= \
 	oem/src/cmr_ipm.c \
 	oem/src/cmr_hdr.c \
 	oem/src/cmr_fd.c \
+	oem/src/cmr_fd_scale.c \
+	oem/src/cmr_sw_cvt.c \
 	oem/src/cmr_focus.c \
 	oem/src/sensor_drv_u.c \
+	oem/src/sensor_reg_shadow.c \
 	sensor/sensor_ov8825_mipi_raw.c \
 	sensor/sensor_autotest_ov8825_mipi_raw.c \
 	sensor/sensor_ov13850_mipi_raw.c \
@@ -103,6 +107,7 @@ LOCAL_SRC_FILES:= \
 	jpeg/jpeg_fw_8830/src/jpegdec_interface.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_malloc.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_dequant.c	\
+	jpeg/jpeg_fw_8830/src/jpegdec_idct_simd.c	\
 	jpeg/jpeg_fw_8830/src/jpegdec_out.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_parse.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_pvld.c \
@@ -98,6 +98,7 @@ LOCAL_SRC_FILES:= \
 	jpeg/jpeg_fw_8830/src/jpegdec_interface.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_malloc.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_dequant.c	\
+	jpeg/jpeg_fw_8830/src/jpegdec_idct_simd.c	\
 	jpeg/jpeg_fw_8830/src/jpegdec_out.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_parse.c \
 	jpeg/jpeg_fw_8830/src/jpegdec_pvld.c \
@@ -102,6 +102,7 @@ public:
 		CAMERA_FLUSH_RAW_HEAP,
 		CAMERA_FLUSH_RAW_HEAP_ALL,
 		CAMERA_FLUSH_PREVIEW_HEAP,
+		CAMERA_FLUSH_RANGE,
 		CAMERA_FLUSH_MAX
 	};
 
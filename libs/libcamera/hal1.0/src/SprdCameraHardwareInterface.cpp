@@ -32,6 +32,7 @@
 #include "ion_sprd.h"
 #include <media/hardware/MetadataBufferType.h>
 #include "SprdOEMCamera.h"
+#include "cmr_sw_cvt.h"
 #include <androidfw/SprdIlog.h>
 
 #ifdef CONFIG_CAMERA_ISP
@@ -4613,8 +4614,8 @@ bool SprdCameraHardware::getCameraLocation(camera_position_type *pt)
 
 int SprdCameraHardware::uv420CopyTrim(struct _dma_copy_cfg_tag dma_copy_cfg)
 {
-	uint32_t i = 0;
-	uint32_t src_y_addr = 0, src_uv_addr = 0,  dst_y_addr = 0,  dst_uv_addr = 0;
+	struct cmr_sw_frame src, dst;
+	struct cmr_sw_rect rect;
 
 	if (DMA_COPY_YUV400 <= dma_copy_cfg.format ||
 		(dma_copy_cfg.src_size.w & 0x01) || (dma_copy_cfg.src_size.h & 0x01) ||
@@ -4630,23 +4631,29 @@ int SprdCameraHardware::uv420CopyTrim(struct _dma_copy_cfg_tag dma_copy_cfg)
 		return -1;
 	}
 
-	src_y_addr = dma_copy_cfg.src_addr.y_addr + dma_copy_cfg.src_rec.y *
-			dma_copy_cfg.src_size.w + dma_copy_cfg.src_rec.x;
-	src_uv_addr = dma_copy_cfg.src_addr.uv_addr + ((dma_copy_cfg.src_rec.y * dma_copy_cfg.src_size.w) >> 1) +
-			dma_copy_cfg.src_rec.x;
-	dst_y_addr = dma_copy_cfg.dst_addr.y_addr;
-	dst_uv_addr = dma_copy_cfg.dst_addr.uv_addr;
-
-	for (i = 0; i < dma_copy_cfg.src_rec.h; i++) {
-		memcpy((void *)dst_y_addr, (void *)src_y_addr, dma_copy_cfg.src_rec.w);
-		src_y_addr += dma_copy_cfg.src_size.w;
-		dst_y_addr += dma_copy_cfg.src_rec.w;
-
-		if (0 == (i & 0x01)) {
-			memcpy((void *)dst_uv_addr, (void *)src_uv_addr, dma_copy_cfg.src_rec.w);
-			src_uv_addr += dma_copy_cfg.src_size.w;
-			dst_uv_addr += dma_copy_cfg.src_rec.w;
-		}
+	/* a crop at the same size, copied by the software scaler in threads */
+	src.layout = CMR_SW_CVT_SEMIPLANAR;
+	src.width = dma_copy_cfg.src_size.w;
+	src.height = dma_copy_cfg.src_size.h;
+	src.stride = dma_copy_cfg.src_size.w;
+	src.y = (cmr_u8 *)dma_copy_cfg.src_addr.y_addr;
+	src.u = (cmr_u8 *)dma_copy_cfg.src_addr.uv_addr;
+	src.v = NULL;
+	dst.layout = CMR_SW_CVT_SEMIPLANAR;
+	dst.width = dma_copy_cfg.src_rec.w;
+	dst.height = dma_copy_cfg.src_rec.h;
+	dst.stride = dma_copy_cfg.src_rec.w;
+	dst.y = (cmr_u8 *)dma_copy_cfg.dst_addr.y_addr;
+	dst.u = (cmr_u8 *)dma_copy_cfg.dst_addr.uv_addr;
+	dst.v = NULL;
+	rect.x = dma_copy_cfg.src_rec.x;
+	rect.y = dma_copy_cfg.src_rec.y;
+	rect.w = dma_copy_cfg.src_rec.w;
+	rect.h = dma_copy_cfg.src_rec.h;
+
+	if (cmr_sw_scale(&src, &rect, &dst)) {
+		LOGE("uv420CopyTrim: copy failed. \n");
+		return -1;
 	}
 
 	return 0;
@@ -4681,6 +4688,14 @@ int SprdCameraHardware::displayCopy(uint32_t dst_phy_addr, uint32_t dst_virtual_
 			dma_copy_cfg.dst_addr.uv_addr = dst_phy_addr + dma_copy_cfg.src_rec.w * dma_copy_cfg.src_rec.h;
 		}
 		ret = camera_dma_copy_data(dma_copy_cfg);
+		if (ret) {
+			LOGW("displayCopy: dma copy failed %d, copy by cpu", ret);
+			dma_copy_cfg.src_addr.y_addr = src_virtual_addr;
+			dma_copy_cfg.src_addr.uv_addr = src_virtual_addr + dma_copy_cfg.src_size.w * dma_copy_cfg.src_size.h;
+			dma_copy_cfg.dst_addr.uv_addr = dst_virtual_addr + dma_copy_cfg.dst_addr.uv_addr - dst_phy_addr;
+			dma_copy_cfg.dst_addr.y_addr = dst_virtual_addr;
+			ret = uv420CopyTrim(dma_copy_cfg);
+		}
 #else
 
 #ifdef CONFIG_CAMERA_ANTI_SHAKE
@@ -6026,11 +6041,11 @@ void SprdCameraHardware::HandleStartPreview(enum camera_cb_type cb, void *parm4)
 		{
 			camera_frame_type *frame = (camera_frame_type *)parm4;
 			mPrevBufLock.lock();
-			if (isPreviewing()) {
-				flush_buffer(CAMERA_FLUSH_PREVIEW_HEAP, frame->buf_id,
+			if (isPreviewing() && frame) {
+				flush_buffer(CAMERA_FLUSH_RANGE, frame->buf_id,
 					(void*)frame->y_vir_addr,
 					(void*)frame->y_phy_addr,
-					mPreviewHeapSize);
+					(int)(frame->width * frame->height));
 			}
 			mPrevBufLock.unlock();
 		}
@@ -6089,7 +6104,15 @@ void SprdCameraHardware::HandleTakePicture(enum camera_cb_type cb, void* parm4)
 		LOGD("capture:flush.");
 		mCapBufLock.lock();
 		if (mCapBufIsAvail == 1) {
-			flush_buffer(CAMERA_FLUSH_RAW_HEAP_ALL, 0,(void*)0,(void*)0,0);
+			camera_frame_type *frame = (camera_frame_type *)parm4;
+			if (frame) {
+				flush_buffer(CAMERA_FLUSH_RANGE, 0,
+					(void*)frame->y_vir_addr,
+					(void*)frame->y_phy_addr,
+					(int)(frame->width * frame->height));
+			} else {
+				flush_buffer(CAMERA_FLUSH_RAW_HEAP_ALL, 0,(void*)0,(void*)0,0);
+			}
 		}
 		mCapBufLock.unlock();
 		break;
@@ -6774,6 +6797,37 @@ int SprdCameraHardware::flush_buffer(camera_flush_mem_type_e  type, int index, v
 		}
 		break;
 
+	case CAMERA_FLUSH_RANGE:
+		/* the range lies in one of the cached preview or capture heaps,
+		 * it is flushed from its own address to the end of the heap at most */
+		if ((PREVIEW_BUFFER_USAGE_DCAM == mPreviewBufferUsage) && mPreviewHeapArray != NULL) {
+			for (i=0; i<mPreviewHeapNum; i++) {
+				if (mPreviewHeapArray[i] && mPreviewHeapArray[i]->data
+					&& (uint8_t*)v_addr >= (uint8_t*)mPreviewHeapArray[i]->data
+					&& (uint8_t*)v_addr < (uint8_t*)mPreviewHeapArray[i]->data + mPreviewHeapArray[i]->phys_size) {
+					pmem = mPreviewHeapArray[i];
+					break;
+				}
+			}
+		}
+		for (i=0; !pmem && i<mSubRawHeapNum; i++) {
+			if (mSubRawHeapArray[i] && mSubRawHeapArray[i]->data
+				&& (uint8_t*)v_addr >= (uint8_t*)mSubRawHeapArray[i]->data
+				&& (uint8_t*)v_addr < (uint8_t*)mSubRawHeapArray[i]->data + mSubRawHeapArray[i]->phys_size) {
+				pmem = mSubRawHeapArray[i];
+			}
+		}
+		if (pmem) {
+			uint32_t offset = (uint8_t*)v_addr - (uint8_t*)pmem->data;
+			p_addr = (void*)(pmem->phys_addr + offset);
+			if (size <= 0 || (uint32_t)size > pmem->phys_size - offset) {
+				size = (int)(pmem->phys_size - offset);
+			}
+		} else {
+			LOGV("flush_buffer no cached heap holds vaddr=0x%x", (uint32_t)v_addr);
+		}
+		break;
+
 	default:
 		break;
 	}
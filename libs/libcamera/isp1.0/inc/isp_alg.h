@@ -23,6 +23,8 @@
 #include "isp_ae_alg_v00.h"
 #include "isp_app.h"
 #include "isp_awb_ctrl.h"
+#include "isp_smart_track.h"
+#include "isp_stat_kernel.h"
 
 /**---------------------------------------------------------------------------*
  **				 Compiler Flag					*
@@ -158,6 +160,7 @@ int32_t isp_get_denoise_tab_diswei(uint32_t de_level, uint8_t** diswei);
 int32_t isp_get_denoise_tab_ranwei(uint32_t de_level, uint8_t** ranwei);
 int32_t isp_flash_calculation(uint32_t handler_id, struct isp_ae_v00_flash_alg_param* v00_flash_ptr);
 int32_t isp_adjust_cmc(uint32_t handler_id, int32_t cur_ev);
+int32_t isp_smart_get_stat(uint32_t handler_id, struct isp_smart_stat* stat_ptr);
 int32_t _ispGetFetchPitch(struct isp_pitch* pitch_ptr, uint16_t width, enum isp_format format);
 int32_t _ispGetStorePitch(struct isp_pitch* pitch_ptr, uint16_t width, enum isp_format format);
 int32_t _ispGetSliceHeightNum(struct isp_size* src_size_ptr, struct isp_slice_param* slice_ptr);
@@ -659,6 +659,7 @@ struct isp_context{
 	uint32_t flash_lnc_index;
 	struct lsc_adv_info smart_lsc_log_info;
 	struct isp_adv_lsc_param adv_lsc;
+	struct isp_smart_track smart_track;
 };
 
 struct isp_system{
@@ -35,6 +35,10 @@ extern "C"
 **----------------------------------------------------------------------------*/
 
 uint32_t isp_raw_para_update_from_file(SENSOR_INFO_T *sensor_info_ptr,SENSOR_ID_E sensor_id);
+/* maps sensor_<name>_raw_param.pack in place of the compiled tune and fix
+ * tables of the sensor, called before the sensor is identified */
+uint32_t isp_raw_para_load_pack(SENSOR_INFO_T *sensor_info_ptr,SENSOR_ID_E sensor_id);
+void isp_raw_para_release_pack(SENSOR_INFO_T *sensor_info_ptr,SENSOR_ID_E sensor_id);
 
 
 /**----------------------------------------------------------------------------*
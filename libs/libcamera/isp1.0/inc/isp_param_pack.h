@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _ISP_PARAM_PACK_H_
+#define _ISP_PARAM_PACK_H_
+/*----------------------------------------------------------------------------*
+ **				 Dependencies					*
+ **---------------------------------------------------------------------------*/
+#include <sys/types.h>
+#include "sensor_raw.h"
+/**---------------------------------------------------------------------------*
+ **				 Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+extern	 "C"
+{
+#endif
+
+/**---------------------------------------------------------------------------*
+**				 Micro Define					*
+**----------------------------------------------------------------------------*/
+/* a tuning pack is the raw_param.c tables of one sensor laid out as
+ * sections of a flat file, nothing in it is a pointer so the loader maps
+ * it and points a sensor_raw_fix_info at the sections */
+#define ISP_PARAM_PACK_MAGIC 0x4b505053 /* "SPPK" */
+#define ISP_PARAM_PACK_VERSION 0x00010000 /* major-xxxx0000, minor-0000xxxx */
+#define ISP_PARAM_PACK_ALIGN 0x20
+#define ISP_PARAM_PACK_NAME_LEN 0x20
+#define ISP_PARAM_PACK_LNC_NUM (SENSOR_MAP_NUM*SENSOR_AWB_CALI_NUM)
+#define ISP_PARAM_PACK_SEC_MAX (0x05+SENSOR_AE_TAB_NUM*2+ISP_PARAM_PACK_LNC_NUM)
+
+enum isp_param_pack_sec_id{
+	ISP_PARAM_PACK_FIX=0x01,
+	ISP_PARAM_PACK_TUNE,
+	ISP_PARAM_PACK_AE_WEIGHT,
+	ISP_PARAM_PACK_AE_E,
+	ISP_PARAM_PACK_AE_G,
+	ISP_PARAM_PACK_LNC,
+	ISP_PARAM_PACK_AWB_MAP,
+	ISP_PARAM_PACK_AWB_WEIGHT,
+	ISP_PARAM_PACK_SEC_ID_MAX
+};
+
+/**---------------------------------------------------------------------------*
+**				 Data Structures					*
+**---------------------------------------------------------------------------*/
+struct isp_param_pack_head{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t raw_version_id;
+	uint32_t tune_size;
+	uint32_t sec_num;
+	uint32_t reserved[2];
+	char name[ISP_PARAM_PACK_NAME_LEN];
+};
+
+/* the section table follows the head, offset is from the pack start and
+ * size is by bytes, sections with the same data share their offset */
+struct isp_param_pack_sec{
+	uint16_t id;
+	uint16_t index;
+	uint32_t offset;
+	uint32_t size;
+};
+
+/* the values of sensor_raw_fix_info, the ISP_PARAM_PACK_FIX section */
+struct isp_param_pack_fix{
+	struct sensor_ae_index ae_index[SENSOR_AE_TAB_NUM][SENSOR_ISO_NUM];
+	uint32_t lnc_grid[ISP_PARAM_PACK_LNC_NUM];
+	uint32_t awb_len;
+	uint16_t awb_weight_width;
+	uint16_t awb_weight_height;
+};
+
+/* the table lengths sensor_raw_fix_info does not carry, by bytes, an
+ * awb_map of 0 packs the awb.len bytes the fix info has */
+struct isp_param_pack_len{
+	uint32_t ae_weight;
+	uint32_t ae_e[SENSOR_AE_TAB_NUM];
+	uint32_t ae_g[SENSOR_AE_TAB_NUM];
+	uint32_t awb_map;
+};
+
+/* a parsed pack, tune_ptr and the fix pointers point into addr */
+struct isp_param_pack{
+	void* addr;
+	uint32_t size;
+	uint32_t is_map;
+	uint32_t raw_version_id;
+	struct sensor_raw_tune_info* tune_ptr;
+	struct sensor_raw_fix_info fix;
+	struct isp_param_pack_len len;
+};
+
+/**---------------------------------------------------------------------------*
+**				 Public Function Prototypes				*
+**---------------------------------------------------------------------------*/
+/* returns the pack size of raw_info_ptr, the pack is written when buf is
+ * not null and size is enough, 0 on error */
+uint32_t isp_param_pack_write(const struct sensor_raw_info* raw_info_ptr, const struct isp_param_pack_len* len_ptr, const char* name, void* buf, uint32_t size);
+/* checks the pack at addr and fills pack_ptr, a null name matches any
+ * sensor, returns 0 on success */
+int32_t isp_param_pack_parse(void* addr, uint32_t size, const char* name, struct isp_param_pack* pack_ptr);
+/* maps file_name copy on write and parses it, returns 0 on success */
+int32_t isp_param_pack_map(const char* file_name, const char* name, struct isp_param_pack* pack_ptr);
+void isp_param_pack_unmap(struct isp_param_pack* pack_ptr);
+
+/**---------------------------------------------------------------------------*
+**				 Compiler Flag					*
+**---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+}
+#endif
+/**---------------------------------------------------------------------------*/
+#endif
+// End
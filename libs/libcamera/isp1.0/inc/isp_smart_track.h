@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _ISP_SMART_TRACK_H_
+#define _ISP_SMART_TRACK_H_
+/*----------------------------------------------------------------------------*
+ **				 Dependencies					*
+ **---------------------------------------------------------------------------*/
+#include <sys/types.h>
+/**---------------------------------------------------------------------------*
+ **				 Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+extern	 "C"
+{
+#endif
+
+/**---------------------------------------------------------------------------*
+**				 Micro Define					*
+**----------------------------------------------------------------------------*/
+#define ISP_SMART_GAMMA_NUM 26
+/* largest block parameter that can be compared, bigger blocks are always marked */
+#define ISP_SMART_SHOT_SIZE 512
+/* ISP_EB of isp_drv.h */
+#define ISP_SMART_TUNE_EB 0x01
+
+enum isp_smart_level_id {
+	ISP_SMART_LEVEL_DISWEI=0x00,
+	ISP_SMART_LEVEL_RANWEI,
+	ISP_SMART_LEVEL_PREF_Y,
+	ISP_SMART_LEVEL_SOFT_Y,
+	ISP_SMART_LEVEL_SOFT_UV,
+	ISP_SMART_LEVEL_EDGE,
+	ISP_SMART_LEVEL_NUM
+};
+
+enum isp_smart_block_id {
+	ISP_SMART_BLOCK_GAMMA=0x00,
+	ISP_SMART_BLOCK_DENOISE,
+	ISP_SMART_BLOCK_PREF,
+	ISP_SMART_BLOCK_EDGE,
+	ISP_SMART_BLOCK_NUM
+};
+
+#define ISP_SMART_BLOCK_BIT(id) (0x01<<(id))
+
+/**---------------------------------------------------------------------------*
+**				 Data Structures					*
+**---------------------------------------------------------------------------*/
+/* the ae state one smart level is interpolated from */
+struct isp_smart_in{
+	uint32_t cur_index;
+	uint32_t max_index;
+	uint32_t start_index;
+	uint32_t start_zone;
+	uint32_t bias_value;
+	uint32_t cur_value;
+	uint32_t max_value;
+	uint32_t target_lum_low_thr;
+	uint32_t cur_lum;
+	uint32_t low_thr;
+};
+
+/* tuning of one smart level, edge uses min and max only */
+struct isp_smart_level_param{
+	uint32_t outdoor;
+	uint32_t min;
+	uint32_t mid;
+	uint32_t max;
+};
+
+/* the inputs the level really depends on in its ae region */
+struct isp_smart_key{
+	uint32_t region;
+	uint32_t value[2];
+	struct isp_smart_level_param param;
+};
+
+struct isp_smart_memo{
+	uint32_t valid;
+	struct isp_smart_key key;
+	uint32_t level;
+	uint32_t hit;
+	uint32_t miss;
+};
+
+struct isp_smart_gamma_memo{
+	uint32_t valid;
+	uint32_t numerator;
+	uint32_t denominator;
+	uint16_t gamma0[ISP_SMART_GAMMA_NUM];
+	uint16_t gamma1[ISP_SMART_GAMMA_NUM];
+	uint16_t axis[ISP_SMART_GAMMA_NUM];
+	uint32_t hit;
+	uint32_t miss;
+};
+
+/* an isp block the smart adjust writes and the sof handler programs */
+struct isp_smart_block{
+	void* param_ptr;
+	uint32_t size;
+	uint8_t* tune_ptr;
+};
+
+struct isp_smart_track{
+	struct isp_smart_memo level[ISP_SMART_LEVEL_NUM];
+	struct isp_smart_gamma_memo gamma;
+	uint32_t shot_mask;
+	uint8_t shot[ISP_SMART_BLOCK_NUM][ISP_SMART_SHOT_SIZE];
+	uint32_t dirty[ISP_SMART_BLOCK_NUM];
+	uint32_t clean[ISP_SMART_BLOCK_NUM];
+};
+
+struct isp_smart_stat{
+	uint32_t level_hit[ISP_SMART_LEVEL_NUM];
+	uint32_t level_miss[ISP_SMART_LEVEL_NUM];
+	uint32_t gamma_hit;
+	uint32_t gamma_miss;
+	uint32_t block_dirty[ISP_SMART_BLOCK_NUM];
+	uint32_t block_clean[ISP_SMART_BLOCK_NUM];
+};
+
+/**---------------------------------------------------------------------------*
+**				 Public Function Prototypes				*
+**---------------------------------------------------------------------------*/
+uint32_t isp_smart_get_level(struct isp_smart_memo* memo, const struct isp_smart_in* in, const struct isp_smart_level_param* param);
+uint32_t isp_smart_get_edge(struct isp_smart_memo* memo, const struct isp_smart_in* in, const struct isp_smart_level_param* param);
+void isp_smart_fit_gamma(struct isp_smart_gamma_memo* memo, const uint16_t* gamma0, const uint16_t* gamma1, uint32_t numerator, uint32_t denominator, uint16_t* axis);
+void isp_smart_track_begin(struct isp_smart_track* track, const struct isp_smart_block* block, uint32_t mask);
+uint32_t isp_smart_track_end(struct isp_smart_track* track, const struct isp_smart_block* block, uint32_t mask);
+void isp_smart_track_get_stat(const struct isp_smart_track* track, struct isp_smart_stat* stat);
+
+/**---------------------------------------------------------------------------*
+**				 Compiler Flag					*
+**---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+}
+#endif
+/**---------------------------------------------------------------------------*/
+#endif
+// End
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _ISP_STAT_KERNEL_H_
+#define _ISP_STAT_KERNEL_H_
+/*----------------------------------------------------------------------------*
+ **				 Dependencies					*
+ **---------------------------------------------------------------------------*/
+#include <sys/types.h>
+/**---------------------------------------------------------------------------*
+ **				 Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+extern	 "C"
+{
+#endif
+
+/**---------------------------------------------------------------------------*
+**				 Micro Define					*
+**----------------------------------------------------------------------------*/
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__SSE2__)
+#define ISP_STAT_SIMD 1
+#else
+#define ISP_STAT_SIMD 0
+#endif
+
+enum isp_stat_awbm_layout{
+	ISP_STAT_AWBM_SC8825=0x00,
+	ISP_STAT_AWBM_SC8830,
+	ISP_STAT_AWBM_MAX
+};
+
+/**---------------------------------------------------------------------------*
+**				 Public Function Prototypes				*
+**---------------------------------------------------------------------------*/
+/* src is num records of stride words as read back by ISP_IO_READ, the
+ * value is the word at offset of each record, two records per awbm item */
+void isp_stat_unpack_aem(const uint32_t* src, uint32_t stride, uint32_t offset, uint32_t mask, uint32_t* y, uint32_t num);
+void isp_stat_unpack_awbm(const uint32_t* src, uint32_t stride, uint32_t offset, enum isp_stat_awbm_layout layout, uint32_t* r, uint32_t* g, uint32_t* b, uint32_t num);
+
+/* the scalar reference, the functions above are bit exact with them */
+void isp_stat_unpack_aem_c(const uint32_t* src, uint32_t stride, uint32_t offset, uint32_t mask, uint32_t* y, uint32_t num);
+void isp_stat_unpack_awbm_c(const uint32_t* src, uint32_t stride, uint32_t offset, enum isp_stat_awbm_layout layout, uint32_t* r, uint32_t* g, uint32_t* b, uint32_t num);
+
+/**---------------------------------------------------------------------------*
+**				 Compiler Flag					*
+**---------------------------------------------------------------------------*/
+#ifdef	 __cplusplus
+}
+#endif
+/**---------------------------------------------------------------------------*/
+#endif
+// End
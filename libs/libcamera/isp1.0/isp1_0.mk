@@ -8,6 +8,8 @@ LOCAL_SRC_FILES+= \
 	isp1.0/isp_drv.c \
 	isp1.0/isp_ctrl.c \
 	isp1.0/isp_smart.c \
+	isp1.0/isp_smart_track.c \
+	isp1.0/isp_stat_kernel.c \
 	isp1.0/aaal/lsc/isp_smart_lsc.c \
 	isp1.0/aaal/af/isp_af_ctrl.c \
 	isp1.0/aaal/awb/isp_awb_ctrl.c \
@@ -20,6 +22,7 @@ LOCAL_SRC_FILES+= \
 	isp1.0/isp_param_tune_v0001.c \
 	isp1.0/isp_param_size.c \
 	isp1.0/isp_param_file_update.c \
+	isp1.0/isp_param_pack.c \
 	isp1.0/isp_stub_proc.c \
 	isp1.0/isp_stub_msg.c \
 	isp1.0/isp_otp.c \
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include <sys/types.h>
+#include <stddef.h>
 #include "isp_reg.h"
 #include "isp_com.h"
 /**---------------------------------------------------------------------------*
@@ -36,6 +37,10 @@ typedef void (*ISP_ISR_HANDLER)(void);
 
 #define ISP_AWB_DEFAULT_GAIN 0x100
 
+/* words of one struct isp_reg_bits and the word of its value, for the statistics unpack */
+#define ISP_REG_BITS_STRIDE (sizeof(struct isp_reg_bits)/sizeof(uint32_t))
+#define ISP_REG_BITS_VALUE (offsetof(struct isp_reg_bits, reg_value)/sizeof(uint32_t))
+
 #define ISP_MAX_WIDTH_V0001 3280
 #define ISP_MAX_HEIGHT_V0001 2464
 
@@ -2449,9 +2454,6 @@ void ispGetAWBMStatistic(uint32_t handler_id, uint32_t* r_info, uint32_t* g_info
 {
 /*	union _isp_mem_reg_tag* reg_ptr=(union _isp_mem_reg_tag*)ISP_AWBM_OUTPUT;*/
 	uint32_t i = 0x00;
-	uint32_t k = 0x00;
-	uint32_t temp32_0 = 0x00;
-	uint32_t temp32_1 = 0x00;
 	uint32_t offset_addr = ISP_AWBM_OUTPUT - ISP_BASE_ADDR;
 	struct isp_reg_bits reg_config[2*ISP_AWBM_ITEM];
 	struct isp_reg_param read_param;
@@ -2472,14 +2474,8 @@ void ispGetAWBMStatistic(uint32_t handler_id, uint32_t* r_info, uint32_t* g_info
 		{
 			if(ISP_SUCCESS == _isp_read((uint32_t *)&read_param))
 			{
-				for(i=0x00; i<ISP_AWBM_ITEM; i++)
-				{
-					temp32_0=reg_config[k++].reg_value;
-					temp32_1=reg_config[k++].reg_value;
-					r_info[i]= (temp32_1>>9) & 0xfffff;
-					g_info[i]= temp32_0 & 0x1fffff;
-					b_info[i]= ((temp32_1 & 0x1ff)<<11) | ((temp32_0 >>21) & 0x7ff);
-				}
+				isp_stat_unpack_awbm((uint32_t*)reg_config, ISP_REG_BITS_STRIDE, ISP_REG_BITS_VALUE,
+					ISP_STAT_AWBM_SC8825, r_info, g_info, b_info, ISP_AWBM_ITEM);
 			}
 			break ;
 		}
@@ -2488,14 +2484,8 @@ void ispGetAWBMStatistic(uint32_t handler_id, uint32_t* r_info, uint32_t* g_info
 		{
 			if(ISP_SUCCESS == _isp_read((uint32_t *)&read_param))
 			{
-				for(i=0x00; i<ISP_AWBM_ITEM; i++)
-				{
-					temp32_0=reg_config[k++].reg_value;
-					temp32_1=reg_config[k++].reg_value;
-					r_info[i]= (temp32_1>>11) & 0x1fffff;
-					g_info[i]= temp32_0 & 0x3fffff;
-					b_info[i]= ((temp32_1 & 0x7ff)<<10) | ((temp32_0 >>22) & 0x3ff);
-				}
+				isp_stat_unpack_awbm((uint32_t*)reg_config, ISP_REG_BITS_STRIDE, ISP_REG_BITS_VALUE,
+					ISP_STAT_AWBM_SC8830, r_info, g_info, b_info, ISP_AWBM_ITEM);
 			}
 			break ;
 		}
@@ -9183,9 +9173,6 @@ int32_t ispGetAEMStatistic(uint32_t handler_id, uint32_t* y_info)
 {
 /*	union _isp_mem_reg_tag* reg_ptr=(union _isp_mem_reg_tag*)ISP_AWBM_OUTPUT;*/
 	uint32_t i = 0x00;
-	uint32_t k = 0x00;
-	uint32_t temp32_0 = 0x00;
-	uint32_t temp32_1 = 0x00;
 	uint32_t offset_addr = ISP_AEM_OUTPUT - ISP_BASE_ADDR;
 	struct isp_reg_bits reg_config[ISP_AEM_ITEM];
 	struct isp_reg_param read_param;
@@ -9207,10 +9194,8 @@ int32_t ispGetAEMStatistic(uint32_t handler_id, uint32_t* y_info)
 		{
 			if(ISP_SUCCESS == _isp_read((uint32_t *)&read_param))
 			{
-				for(i=0x00; i<ISP_AEM_ITEM; i++)
-				{
-					y_info[i]=reg_config[i].reg_value & 0x3fffff;
-				}
+				isp_stat_unpack_aem((uint32_t*)reg_config, ISP_REG_BITS_STRIDE, ISP_REG_BITS_VALUE,
+					0x3fffff, y_info, ISP_AEM_ITEM);
 			}
 			break ;
 		}
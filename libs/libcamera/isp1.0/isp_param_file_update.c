@@ -21,6 +21,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include "isp_param_file_update.h"
+#include "isp_param_pack.h"
 /**---------------------------------------------------------------------------*
  **				Compiler Flag					*
  **---------------------------------------------------------------------------*/
@@ -39,6 +40,7 @@ extern "C"
 #define TUNE_INFO_LOOKUP_STR "s_%s_tune_info"
 #define SENSOR_RAW_FIX_INFO_LOOKUP_STR "s_%s_fix_info"
 #define AWB_MAP_LOOKUP_STR "s_%s_awb_map"
+#define PACK_FILE_STR "%ssensor_%s_raw_param.pack"
 
 struct isp_raw_info_update_status
 {
@@ -82,6 +84,23 @@ static struct isp_raw_info_update_status raw_info_update_status[2] = {
 
 };
 
+/* the pack mapped for each sensor id, the /data pack overrides the
+ * one installed with the system like the raw_param.c file does */
+struct isp_raw_pack_status
+{
+	struct sensor_raw_info *raw_info_addr;
+	struct sensor_raw_tune_info *tune_info_table_org_addr;
+	struct sensor_raw_fix_info *fix_info_table_org_addr;
+	struct isp_param_pack pack;
+};
+
+static const char *raw_pack_dir[] = {
+	"/data/",
+	"/system/etc/",
+};
+
+static struct isp_raw_pack_status raw_pack_status[SENSOR_ID_MAX];
+
 
 /**---------------------------------------------------------------------------*
 *				Data Prototype					*
@@ -689,6 +708,85 @@ update_error:
 	return SENSOR_FAIL;
 }
 
+void isp_raw_para_release_pack(SENSOR_INFO_T *sensor_info_ptr,SENSOR_ID_E sensor_id)
+{
+	struct isp_raw_pack_status *status = PNULL;
+	struct sensor_raw_info *raw_info_ptr = PNULL;
+
+	if(SENSOR_ID_MAX <= sensor_id){
+		return;
+	}
+
+	status = &raw_pack_status[sensor_id];
+	raw_info_ptr = status->raw_info_addr;
+	if(PNULL == raw_info_ptr){
+		return;
+	}
+
+	if(raw_info_ptr->tune_ptr == status->pack.tune_ptr){
+		raw_info_ptr->tune_ptr = status->tune_info_table_org_addr;
+	}
+	if(raw_info_ptr->fix_ptr == &status->pack.fix){
+		raw_info_ptr->fix_ptr = status->fix_info_table_org_addr;
+	}
+	CMR_LOGI("sensor id:%d release pack", sensor_id);
+
+	isp_param_pack_unmap(&status->pack);
+	status->raw_info_addr = PNULL;
+	status->tune_info_table_org_addr = PNULL;
+	status->fix_info_table_org_addr = PNULL;
+}
+
+uint32_t isp_raw_para_load_pack(SENSOR_INFO_T *sensor_info_ptr,SENSOR_ID_E sensor_id)
+{
+	struct isp_raw_pack_status *status = PNULL;
+	struct sensor_raw_info *raw_info_ptr = PNULL;
+	char file_name[80] = {0};
+	uint32_t i = 0;
+
+	if((PNULL == sensor_info_ptr)
+		|| (SENSOR_ID_MAX <= sensor_id)
+		|| (SENSOR_IMAGE_FORMAT_RAW != sensor_info_ptr->image_format)
+		|| (PNULL == sensor_info_ptr->raw_info_ptr)
+		|| (PNULL == (*sensor_info_ptr->raw_info_ptr))){
+		return SENSOR_FAIL;
+	}
+
+	status = &raw_pack_status[sensor_id];
+	raw_info_ptr = *sensor_info_ptr->raw_info_ptr;
+	if(raw_info_ptr == status->raw_info_addr){
+		return SENSOR_SUCCESS;
+	}
+	isp_raw_para_release_pack(sensor_info_ptr, sensor_id);
+
+	for(i=0; i<sizeof(raw_pack_dir)/sizeof(raw_pack_dir[0]); i++){
+		snprintf(file_name, sizeof(file_name), PACK_FILE_STR, raw_pack_dir[i], sensor_info_ptr->name);
+		if(0 == isp_param_pack_map(file_name, (const char*)sensor_info_ptr->name, &status->pack)){
+			break;
+		}
+	}
+
+	if(sizeof(raw_pack_dir)/sizeof(raw_pack_dir[0]) == i){
+		return SENSOR_FAIL;
+	}
+
+	/* the layout is checked by the pack parser, most drivers rewrite the
+	 * raw version id in identify, so a different one is not refused */
+	if((PNULL != raw_info_ptr->version_info)
+		&& (raw_info_ptr->version_info->version_id != status->pack.raw_version_id)){
+		CMR_LOGI("pack:%s raw version 0x%x, driver 0x%x", file_name, status->pack.raw_version_id, raw_info_ptr->version_info->version_id);
+	}
+
+	status->raw_info_addr = raw_info_ptr;
+	status->tune_info_table_org_addr = raw_info_ptr->tune_ptr;
+	status->fix_info_table_org_addr = raw_info_ptr->fix_ptr;
+	raw_info_ptr->tune_ptr = status->pack.tune_ptr;
+	raw_info_ptr->fix_ptr = &status->pack.fix;
+	CMR_LOGI("sensor id:%d pack:%s size:%d", sensor_id, file_name, status->pack.size);
+
+	return SENSOR_SUCCESS;
+}
+
 
 /**----------------------------------------------------------------------------*
 **				Compiler Flag					*
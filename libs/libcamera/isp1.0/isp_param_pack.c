@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "isp_param_pack.h"
+/**---------------------------------------------------------------------------*
+ ** 				Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**---------------------------------------------------------------------------*
+**				Micro Define					*
+**----------------------------------------------------------------------------*/
+#define ISP_PARAM_PACK_ALIGN_UP(x) (((x)+ISP_PARAM_PACK_ALIGN-1)&~(ISP_PARAM_PACK_ALIGN-1))
+#define ISP_PARAM_PACK_MAJOR(v) ((v)>>16)
+
+struct isp_param_pack_src{
+	const void* data;
+	uint32_t id;
+	uint32_t index;
+	uint32_t size;
+};
+
+/**---------------------------------------------------------------------------*
+**				Local Function Prototypes				*
+**---------------------------------------------------------------------------*/
+
+/* _isp_param_pack_add --
+*@
+*@
+*@ return:
+*/
+static void _isp_param_pack_add(struct isp_param_pack_src* src, uint32_t* num, uint32_t id, uint32_t index, const void* data, uint32_t size)
+{
+	if ((NULL == data)
+		|| (0x00 == size)) {
+		return;
+	}
+
+	src[*num].data = data;
+	src[*num].id = id;
+	src[*num].index = index;
+	src[*num].size = size;
+	*num += 0x01;
+}
+
+/* _isp_param_pack_collect --
+*@
+*@
+*@ return: the section number
+*/
+static uint32_t _isp_param_pack_collect(const struct sensor_raw_info* raw_info_ptr, const struct isp_param_pack_len* len_ptr, const struct isp_param_pack_fix* fix, struct isp_param_pack_src* src)
+{
+	const struct sensor_raw_fix_info* fix_ptr = raw_info_ptr->fix_ptr;
+	uint32_t num = 0x00;
+	uint32_t i = 0x00;
+	uint32_t j = 0x00;
+
+	_isp_param_pack_add(src, &num, ISP_PARAM_PACK_FIX, 0x00, fix, sizeof(*fix));
+	_isp_param_pack_add(src, &num, ISP_PARAM_PACK_TUNE, 0x00, raw_info_ptr->tune_ptr, sizeof(struct sensor_raw_tune_info));
+	_isp_param_pack_add(src, &num, ISP_PARAM_PACK_AE_WEIGHT, 0x00, fix_ptr->ae.weight_tab, len_ptr->ae_weight);
+
+	for (i=0x00; i<SENSOR_AE_TAB_NUM; i++) {
+		_isp_param_pack_add(src, &num, ISP_PARAM_PACK_AE_E, i, fix_ptr->ae.tab[i].e_ptr, len_ptr->ae_e[i]);
+		_isp_param_pack_add(src, &num, ISP_PARAM_PACK_AE_G, i, fix_ptr->ae.tab[i].g_ptr, len_ptr->ae_g[i]);
+	}
+
+	for (i=0x00; i<SENSOR_MAP_NUM; i++) {
+		for (j=0x00; j<SENSOR_AWB_CALI_NUM; j++) {
+			_isp_param_pack_add(src, &num, ISP_PARAM_PACK_LNC, i*SENSOR_AWB_CALI_NUM+j, fix_ptr->lnc.map[i][j].param_addr, fix_ptr->lnc.map[i][j].len);
+		}
+	}
+
+	_isp_param_pack_add(src, &num, ISP_PARAM_PACK_AWB_MAP, 0x00, fix_ptr->awb.addr, (0x00 != len_ptr->awb_map) ? len_ptr->awb_map : fix_ptr->awb.len);
+	_isp_param_pack_add(src, &num, ISP_PARAM_PACK_AWB_WEIGHT, 0x00, fix_ptr->awb_weight.addr, fix_ptr->awb_weight.width*fix_ptr->awb_weight.height);
+
+	return num;
+}
+
+/* _isp_param_pack_check_sec --
+*@
+*@
+*@ return: 0 when the section can be used
+*/
+static int32_t _isp_param_pack_check_sec(const struct isp_param_pack_sec* sec, uint32_t data_start, uint32_t size)
+{
+	uint32_t unit = 0x01;
+
+	switch (sec->id)
+	{
+		case ISP_PARAM_PACK_AE_E:
+			unit = sizeof(uint32_t);
+			if (SENSOR_AE_TAB_NUM <= sec->index) {
+				return -1;
+			}
+			break;
+
+		case ISP_PARAM_PACK_AE_G:
+			unit = sizeof(uint16_t);
+			if (SENSOR_AE_TAB_NUM <= sec->index) {
+				return -1;
+			}
+			break;
+
+		case ISP_PARAM_PACK_LNC:
+			/* the unused slots of some tunings are one byte tables */
+			if (ISP_PARAM_PACK_LNC_NUM <= sec->index) {
+				return -1;
+			}
+			break;
+
+		case ISP_PARAM_PACK_FIX:
+		case ISP_PARAM_PACK_TUNE:
+			unit = sizeof(uint32_t);
+			break;
+
+		default:
+			break;
+	}
+
+	if ((sec->offset < data_start)
+		|| (sec->offset > size)
+		|| (sec->size > size-sec->offset)
+		|| (0x00 != (sec->offset&(ISP_PARAM_PACK_ALIGN-1)))
+		|| (0x00 != (sec->size%unit))) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**---------------------------------------------------------------------------*
+**				Public Function Prototypes				*
+**---------------------------------------------------------------------------*/
+
+/* isp_param_pack_write --
+*@
+*@
+*@ return: the pack size, 0 on error
+*/
+uint32_t isp_param_pack_write(const struct sensor_raw_info* raw_info_ptr, const struct isp_param_pack_len* len_ptr, const char* name, void* buf, uint32_t size)
+{
+	struct isp_param_pack_src src[ISP_PARAM_PACK_SEC_MAX];
+	struct isp_param_pack_sec sec[ISP_PARAM_PACK_SEC_MAX];
+	struct isp_param_pack_fix fix;
+	struct isp_param_pack_head* head = (struct isp_param_pack_head*)buf;
+	const struct sensor_raw_fix_info* fix_ptr = NULL;
+	uint8_t* dst = (uint8_t*)buf;
+	uint32_t sec_num = 0x00;
+	uint32_t offset = 0x00;
+	uint32_t i = 0x00;
+	uint32_t j = 0x00;
+
+	if ((NULL == raw_info_ptr)
+		|| (NULL == raw_info_ptr->tune_ptr)
+		|| (NULL == raw_info_ptr->fix_ptr)
+		|| (NULL == len_ptr)
+		|| (NULL == name)
+		|| (ISP_PARAM_PACK_NAME_LEN <= strlen(name))) {
+		return 0x00;
+	}
+
+	fix_ptr = raw_info_ptr->fix_ptr;
+	memset(&fix, 0x00, sizeof(fix));
+	for (i=0x00; i<SENSOR_AE_TAB_NUM; i++) {
+		memcpy(fix.ae_index[i], fix_ptr->ae.tab[i].index, sizeof(fix.ae_index[i]));
+	}
+	for (i=0x00; i<SENSOR_MAP_NUM; i++) {
+		for (j=0x00; j<SENSOR_AWB_CALI_NUM; j++) {
+			fix.lnc_grid[i*SENSOR_AWB_CALI_NUM+j] = fix_ptr->lnc.map[i][j].grid;
+		}
+	}
+	fix.awb_len = fix_ptr->awb.len;
+	fix.awb_weight_width = fix_ptr->awb_weight.width;
+	fix.awb_weight_height = fix_ptr->awb_weight.height;
+
+	sec_num = _isp_param_pack_collect(raw_info_ptr, len_ptr, &fix, src);
+
+	/* the lnc and ae tables are often shared between slots, a table
+	 * already laid out keeps its offset */
+	offset = ISP_PARAM_PACK_ALIGN_UP(sizeof(struct isp_param_pack_head)+sec_num*sizeof(struct isp_param_pack_sec));
+	for (i=0x00; i<sec_num; i++) {
+		sec[i].id = src[i].id;
+		sec[i].index = src[i].index;
+		sec[i].size = src[i].size;
+		for (j=0x00; j<i; j++) {
+			if ((src[j].data == src[i].data)
+				&& (src[j].size == src[i].size)) {
+				break;
+			}
+		}
+		if (j < i) {
+			sec[i].offset = sec[j].offset;
+		} else {
+			sec[i].offset = offset;
+			offset = ISP_PARAM_PACK_ALIGN_UP(offset+src[i].size);
+		}
+	}
+
+	if (NULL == buf) {
+		return offset;
+	}
+	if (size < offset) {
+		return 0x00;
+	}
+
+	memset(dst, 0x00, offset);
+	head->magic = ISP_PARAM_PACK_MAGIC;
+	head->version = ISP_PARAM_PACK_VERSION;
+	head->size = offset;
+	head->raw_version_id = (NULL != raw_info_ptr->version_info) ? raw_info_ptr->version_info->version_id : 0x00;
+	head->tune_size = sizeof(struct sensor_raw_tune_info);
+	head->sec_num = sec_num;
+	strncpy(head->name, name, ISP_PARAM_PACK_NAME_LEN-1);
+	memcpy(dst+sizeof(struct isp_param_pack_head), sec, sec_num*sizeof(struct isp_param_pack_sec));
+
+	for (i=0x00; i<sec_num; i++) {
+		memcpy(dst+sec[i].offset, src[i].data, src[i].size);
+	}
+
+	return offset;
+}
+
+/* isp_param_pack_parse --
+*@
+*@
+*@ return: 0 on success
+*/
+int32_t isp_param_pack_parse(void* addr, uint32_t size, const char* name, struct isp_param_pack* pack_ptr)
+{
+	const struct isp_param_pack_head* head = (const struct isp_param_pack_head*)addr;
+	const struct isp_param_pack_sec* sec = NULL;
+	const struct isp_param_pack_fix* fix = NULL;
+	struct sensor_raw_fix_info* fix_ptr = NULL;
+	uint8_t* base = (uint8_t*)addr;
+	uint32_t awb_weight_size = 0x00;
+	uint32_t data_start = 0x00;
+	uint32_t i = 0x00;
+	uint32_t j = 0x00;
+
+	if ((NULL == addr)
+		|| (NULL == pack_ptr)
+		|| (sizeof(struct isp_param_pack_head) > size)
+		|| (ISP_PARAM_PACK_MAGIC != head->magic)
+		|| (ISP_PARAM_PACK_MAJOR(ISP_PARAM_PACK_VERSION) != ISP_PARAM_PACK_MAJOR(head->version))
+		|| (head->size > size)
+		|| (sizeof(struct sensor_raw_tune_info) != head->tune_size)
+		|| (ISP_PARAM_PACK_SEC_MAX < head->sec_num)) {
+		return -1;
+	}
+
+	if ((NULL != name)
+		&& (0x00 != strncmp(head->name, name, ISP_PARAM_PACK_NAME_LEN))) {
+		return -1;
+	}
+
+	data_start = sizeof(struct isp_param_pack_head)+head->sec_num*sizeof(struct isp_param_pack_sec);
+	if (data_start > head->size) {
+		return -1;
+	}
+
+	memset(&pack_ptr->fix, 0x00, sizeof(pack_ptr->fix));
+	memset(&pack_ptr->len, 0x00, sizeof(pack_ptr->len));
+	pack_ptr->tune_ptr = NULL;
+	fix_ptr = &pack_ptr->fix;
+
+	sec = (const struct isp_param_pack_sec*)(base+sizeof(struct isp_param_pack_head));
+	for (i=0x00; i<head->sec_num; i++, sec++) {
+		if (0x00 != _isp_param_pack_check_sec(sec, data_start, head->size)) {
+			return -1;
+		}
+
+		switch (sec->id)
+		{
+			case ISP_PARAM_PACK_FIX:
+				if (sizeof(struct isp_param_pack_fix) != sec->size) {
+					return -1;
+				}
+				fix = (const struct isp_param_pack_fix*)(base+sec->offset);
+				break;
+
+			case ISP_PARAM_PACK_TUNE:
+				if (head->tune_size != sec->size) {
+					return -1;
+				}
+				pack_ptr->tune_ptr = (struct sensor_raw_tune_info*)(base+sec->offset);
+				break;
+
+			case ISP_PARAM_PACK_AE_WEIGHT:
+				fix_ptr->ae.weight_tab = base+sec->offset;
+				pack_ptr->len.ae_weight = sec->size;
+				break;
+
+			case ISP_PARAM_PACK_AE_E:
+				fix_ptr->ae.tab[sec->index].e_ptr = (uint32_t*)(base+sec->offset);
+				pack_ptr->len.ae_e[sec->index] = sec->size;
+				break;
+
+			case ISP_PARAM_PACK_AE_G:
+				fix_ptr->ae.tab[sec->index].g_ptr = (uint16_t*)(base+sec->offset);
+				pack_ptr->len.ae_g[sec->index] = sec->size;
+				break;
+
+			case ISP_PARAM_PACK_LNC:
+				fix_ptr->lnc.map[sec->index/SENSOR_AWB_CALI_NUM][sec->index%SENSOR_AWB_CALI_NUM].param_addr = (uint16_t*)(base+sec->offset);
+				fix_ptr->lnc.map[sec->index/SENSOR_AWB_CALI_NUM][sec->index%SENSOR_AWB_CALI_NUM].len = sec->size;
+				break;
+
+			case ISP_PARAM_PACK_AWB_MAP:
+				fix_ptr->awb.addr = (uint16_t*)(base+sec->offset);
+				pack_ptr->len.awb_map = sec->size;
+				break;
+
+			case ISP_PARAM_PACK_AWB_WEIGHT:
+				fix_ptr->awb_weight.addr = base+sec->offset;
+				awb_weight_size = sec->size;
+				break;
+
+			default:
+				/* a newer minor version may add sections */
+				break;
+		}
+	}
+
+	if ((NULL == fix)
+		|| (NULL == pack_ptr->tune_ptr)) {
+		return -1;
+	}
+
+	for (i=0x00; i<SENSOR_AE_TAB_NUM; i++) {
+		memcpy(fix_ptr->ae.tab[i].index, fix->ae_index[i], sizeof(fix->ae_index[i]));
+	}
+	for (i=0x00; i<SENSOR_MAP_NUM; i++) {
+		for (j=0x00; j<SENSOR_AWB_CALI_NUM; j++) {
+			fix_ptr->lnc.map[i][j].grid = fix->lnc_grid[i*SENSOR_AWB_CALI_NUM+j];
+		}
+	}
+	/* some tunings give the awb map with a length of 0 */
+	fix_ptr->awb.len = fix->awb_len;
+	if ((NULL != fix_ptr->awb.addr)
+		&& (fix->awb_len > pack_ptr->len.awb_map)) {
+		return -1;
+	}
+	fix_ptr->awb_weight.width = fix->awb_weight_width;
+	fix_ptr->awb_weight.height = fix->awb_weight_height;
+	if ((NULL != fix_ptr->awb_weight.addr)
+		&& ((uint32_t)fix->awb_weight_width*fix->awb_weight_height != awb_weight_size)) {
+		return -1;
+	}
+
+	pack_ptr->addr = addr;
+	pack_ptr->size = head->size;
+	pack_ptr->raw_version_id = head->raw_version_id;
+
+	return 0;
+}
+
+/* isp_param_pack_map --
+*@
+*@
+*@ return: 0 on success
+*/
+int32_t isp_param_pack_map(const char* file_name, const char* name, struct isp_param_pack* pack_ptr)
+{
+	struct stat file_status;
+	void* addr = NULL;
+	int fd = -1;
+
+	if ((NULL == file_name)
+		|| (NULL == pack_ptr)) {
+		return -1;
+	}
+
+	memset(pack_ptr, 0x00, sizeof(*pack_ptr));
+
+	fd = open(file_name, O_RDONLY);
+	if (0 > fd) {
+		return -1;
+	}
+
+	if ((0 != fstat(fd, &file_status))
+		|| ((off_t)sizeof(struct isp_param_pack_head) > file_status.st_size)
+		|| ((off_t)0xffffffff < file_status.st_size)) {
+		close(fd);
+		return -1;
+	}
+
+	/* the sensor drivers and the otp calibration write into the tune
+	 * like they do into the compiled tables, a private mapping gives
+	 * them copies of only the pages they touch */
+	addr = mmap(NULL, (size_t)file_status.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == addr) {
+		return -1;
+	}
+
+	if (0 != isp_param_pack_parse(addr, (uint32_t)file_status.st_size, name, pack_ptr)) {
+		munmap(addr, (size_t)file_status.st_size);
+		memset(pack_ptr, 0x00, sizeof(*pack_ptr));
+		return -1;
+	}
+
+	pack_ptr->size = (uint32_t)file_status.st_size;
+	pack_ptr->is_map = 0x01;
+
+	return 0;
+}
+
+/* isp_param_pack_unmap --
+*@
+*@
+*@ return:
+*/
+void isp_param_pack_unmap(struct isp_param_pack* pack_ptr)
+{
+	if (NULL == pack_ptr) {
+		return;
+	}
+
+	if ((0x00 != pack_ptr->is_map)
+		&& (NULL != pack_ptr->addr)) {
+		munmap(pack_ptr->addr, pack_ptr->size);
+	}
+
+	memset(pack_ptr, 0x00, sizeof(*pack_ptr));
+}
+
+/**---------------------------------------------------------------------------*
+**				Compiler Flag					*
+**---------------------------------------------------------------------------*/
+#ifdef __cplusplus
+}
+#endif
+// End
@@ -28,6 +28,9 @@ extern "C"
 /**---------------------------------------------------------------------------*
 **				Micro Define					*
 **----------------------------------------------------------------------------*/
+#define ISP_SMART_STAB_BLOCK (ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_DENOISE) \
+				|ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_PREF) \
+				|ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_EDGE))
 
 /**---------------------------------------------------------------------------*
 **				Data Structures					*
@@ -579,6 +582,90 @@ static uint32_t _isp_adjust_soft_y(uint32_t handler_id, uint32_t bias_gain, uint
 static uint32_t _isp_adjust_soft_uv(uint32_t handler_id, uint32_t bias_gain, uint32_t gain, uint32_t max_gain);
 static uint32_t _isp_adjust_hw_sta_hue(uint32_t handler_id);
 
+/* _isp_smart_get_in --
+*@ the ae state the smart levels are interpolated from
+*@
+*@ return:
+*/
+static void _isp_smart_get_in(uint32_t handler_id, uint32_t bias_gain, uint32_t gain, uint32_t max_gain, struct isp_smart_in* in_ptr)
+{
+	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
+	int32_t EVCompensation=ae_param_ptr->ev;
+	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
+	uint32_t wDeadZone=ae_param_ptr->target_zone;
+
+	in_ptr->cur_index=ae_param_ptr->cur_index;
+	in_ptr->max_index=ae_param_ptr->max_index;
+	in_ptr->start_index=ae_param_ptr->denoise_start_index;
+	in_ptr->start_zone=ae_param_ptr->denoise_start_zone;
+	in_ptr->target_lum_low_thr=target_lum-wDeadZone;
+	in_ptr->cur_lum=ae_param_ptr->cur_lum;
+	in_ptr->low_thr=ae_param_ptr->denoise_lum_thr;
+
+#if SMART_FOLLOW_INDEX
+	in_ptr->bias_value=in_ptr->start_index;
+	in_ptr->max_value=in_ptr->max_index;
+	in_ptr->cur_value=in_ptr->cur_index;
+#else
+	in_ptr->bias_value=bias_gain;
+	in_ptr->max_value=max_gain;
+	in_ptr->cur_value=gain;
+#endif
+}
+
+/* _isp_smart_get_block --
+*@ the blocks the smart adjust writes, by isp_smart_block_id
+*@
+*@ return:
+*/
+static void _isp_smart_get_block(struct isp_context* isp_context_ptr, struct isp_smart_block* block_ptr)
+{
+	block_ptr[ISP_SMART_BLOCK_GAMMA].param_ptr=(void*)&isp_context_ptr->gamma;
+	block_ptr[ISP_SMART_BLOCK_GAMMA].size=sizeof(struct isp_gamma_param);
+	block_ptr[ISP_SMART_BLOCK_GAMMA].tune_ptr=&isp_context_ptr->tune.gamma;
+
+	block_ptr[ISP_SMART_BLOCK_DENOISE].param_ptr=(void*)&isp_context_ptr->denoise;
+	block_ptr[ISP_SMART_BLOCK_DENOISE].size=sizeof(struct isp_denoise_param);
+	block_ptr[ISP_SMART_BLOCK_DENOISE].tune_ptr=&isp_context_ptr->tune.denoise;
+
+	/* pref y and uv are programmed together */
+	block_ptr[ISP_SMART_BLOCK_PREF].param_ptr=(void*)&isp_context_ptr->pref;
+	block_ptr[ISP_SMART_BLOCK_PREF].size=sizeof(struct isp_pref_param);
+	block_ptr[ISP_SMART_BLOCK_PREF].tune_ptr=&isp_context_ptr->tune.pref_y;
+
+	block_ptr[ISP_SMART_BLOCK_EDGE].param_ptr=(void*)&isp_context_ptr->edge;
+	block_ptr[ISP_SMART_BLOCK_EDGE].size=sizeof(struct isp_edge_param);
+	block_ptr[ISP_SMART_BLOCK_EDGE].tune_ptr=&isp_context_ptr->tune.edge;
+}
+
+/* _isp_smart_track_begin --
+*@
+*@
+*@ return:
+*/
+static void _isp_smart_track_begin(uint32_t handler_id, uint32_t mask)
+{
+	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
+	struct isp_smart_block block[ISP_SMART_BLOCK_NUM];
+
+	_isp_smart_get_block(isp_context_ptr, block);
+	isp_smart_track_begin(&isp_context_ptr->smart_track, block, mask);
+}
+
+/* _isp_smart_track_end --
+*@ only the blocks the pass changed are programmed at the next sof
+*@
+*@ return:
+*/
+static void _isp_smart_track_end(uint32_t handler_id, uint32_t mask)
+{
+	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
+	struct isp_smart_block block[ISP_SMART_BLOCK_NUM];
+
+	_isp_smart_get_block(isp_context_ptr, block);
+	isp_smart_track_end(&isp_context_ptr->smart_track, block, mask);
+}
+
 /* _isp_gamma_fitting --
 *@
 *@
@@ -590,12 +677,11 @@ static uint32_t _isp_gamma_fitting(uint32_t handler_id, uint8_t gamma0, uint8_t
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
 	uint8_t i = ISP_ZERO;
-	uint32_t tmp = 0, tmp1 = 0;;
 
 	if ((gamma0 == isp_context_ptr->gamma_index)
 		&& (gamma1 == isp_context_ptr->gamma_index)) {
 		isp_context_ptr->tune.gamma = ISP_UEB;
-	}else {
+	} else {
 		if (gamma0 == gamma1) {
 			//ISP_LOG("tim_gamma ------gamma:%d", gamma0);
 			for (i = ISP_ZERO; i < 26; i++) {
@@ -607,18 +693,16 @@ static uint32_t _isp_gamma_fitting(uint32_t handler_id, uint8_t gamma0, uint8_t
 			//ISP_LOG("tim_gamma ------gamma:01");
 			for (i = ISP_ZERO; i < 26; i++) {
 				isp_context_ptr->gamma_tab[6].axis[0][i] = isp_context_ptr->gamma_tab[gamma0].axis[0][i];
-				tmp = isp_context_ptr->gamma_tab[gamma0].axis[1][i] * (denominator-numerator);
-				tmp1 = isp_context_ptr->gamma_tab[gamma1].axis[1][i] * numerator;
-				tmp = (tmp + tmp1)/denominator;
-				isp_context_ptr->gamma_tab[6].axis[1][i] = tmp;
-				//isp_context_ptr->gamma_tab[6].axis[0][i] = isp_context_ptr->gamma_tab[gamma0].axis[0][i];
 			}
+			isp_smart_fit_gamma(&isp_context_ptr->smart_track.gamma,
+					isp_context_ptr->gamma_tab[gamma0].axis[1],
+					isp_context_ptr->gamma_tab[gamma1].axis[1],
+					numerator, denominator, isp_context_ptr->gamma_tab[6].axis[1]);
 			isp_context_ptr->gamma_index = 0xff;
 		}
 
+		/* tune.gamma is set by _isp_smart_track_end when the table changed */
 		ae_param_ptr->set_gamma(&isp_context_ptr->gamma, &isp_context_ptr->gamma_tab[6]);
-
-		isp_context_ptr->tune.gamma = ISP_EB;
 	}
 
 	return rtn;
@@ -808,10 +892,8 @@ static int32_t _isp_nr_strength_adjust(uint32_t handler_id)
 	bypass = isp_context_ptr->pref.bypass;
 	if (ISP_EB != bypass && !is_single) {
 		isp_context_ptr->pref.y_thr = (isp_context_ptr->pref.y_thr * denoise_coef)>>6;
-		isp_context_ptr->tune.pref_y = ISP_EB;
 		isp_context_ptr->pref.u_thr = (isp_context_ptr->pref.u_thr * denoise_coef)>>6;
 		isp_context_ptr->pref.v_thr = (isp_context_ptr->pref.v_thr * denoise_coef)>>6;
-		isp_context_ptr->tune.pref_uv= ISP_EB;
 	}
 	if (!is_single) {
 		ae_param_ptr->prv_noise_info.y_level = (ae_param_ptr->prv_noise_info.y_level * denoise_coef)>>6;
@@ -835,7 +917,6 @@ static int32_t _isp_nr_strength_adjust(uint32_t handler_id)
 		}
 		isp_ae_set_denoise_ranwei(handler_id, level&0xff);
 		isp_ae_set_denosie_ranwei_level(handler_id, level&0xff);
-		isp_context_ptr->tune.denoise = ISP_EB;
 	}
 	return rtn;
 }
@@ -858,7 +939,6 @@ static int32_t _isp_edge_strength_adjust(uint32_t handler_id)
 		level = isp_context_ptr->edge.strength;
 		level = (level * adjust_coef)>>6;
 		isp_context_ptr->edge.strength = level;
-		isp_context_ptr->tune.edge = ISP_EB;
 	}
 	return rtn;
 }
@@ -892,9 +972,6 @@ static uint32_t _isp_adjust_denoise(uint32_t handler_id, uint32_t bias_gain, uin
 				isp_context_ptr->denoise.bypass = isp_context_ptr->denoise_bak.bypass;
 		}
 //		isp_context_ptr->pref.y_thr = ae_param_ptr->prv_noise_info.y_level;
-		isp_context_ptr->tune.pref_y=ISP_EB;
-
-		isp_context_ptr->tune.denoise=ISP_EB;
 	}
 
 	return rtn;
@@ -906,83 +983,21 @@ static uint32_t _isp_adjust_pref_y(uint32_t handler_id, uint32_t bias_gain, uint
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t denoise_level=0x00;
-	uint16_t thread_hold=0x00;
-	uint16_t denoise_thr=ae_param_ptr->smart_pref_y_mid-ae_param_ptr->smart_pref_y_min;
-	uint32_t denoise_min_index=ae_param_ptr->smart_pref_y_min;
-	uint32_t denoise_mid_index=ae_param_ptr->smart_pref_y_mid;
-	uint32_t denoise_max_index=ae_param_ptr->smart_pref_y_max;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-
-	int32_t EVCompensation=ae_param_ptr->ev;
-	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
-	uint32_t wDeadZone=ae_param_ptr->target_zone;
-	uint32_t target_lum_low_thr=target_lum-wDeadZone;
-	uint32_t wYlayer=ae_param_ptr->cur_lum;
-	uint32_t low_thr=ae_param_ptr->denoise_lum_thr;
-
-	uint32_t outdoor_denoise_level = ae_param_ptr->smart_pref_y_outdoor;
-	uint32_t start_zone = ae_param_ptr->denoise_start_zone;
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = cur_index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
 
 	denoise_level = isp_context_ptr->pref.y_thr;
 	if((ISP_ZERO!=(AE_SMART_DENOISE_PREF_Y&ae_param_ptr->smart))) {
-
-		if(cur_index<=start_index) {
-			denoise_level=outdoor_denoise_level;
-		} else {
-
-			if(cur_index<max_index) {
-				if(cur_value<bias_value) {
-					denoise_level=denoise_min_index;
-					if((cur_index < (start_index + start_zone))
-						&&(outdoor_denoise_level<denoise_min_index)){
-						denoise_level = outdoor_denoise_level
-									+ (denoise_min_index - outdoor_denoise_level)*(cur_index - start_index)/start_zone;
-					}
-
-				
-				} else {
-					denoise_level=((cur_value-bias_value)*255)/(max_value-bias_value);
-					denoise_level=(denoise_thr*denoise_level/255)+denoise_min_index;
-					if(denoise_level < denoise_min_index) {
-						denoise_level=denoise_min_index;
-					} else if (denoise_level > denoise_mid_index) {
-						denoise_level=denoise_mid_index;
-					}
-				}
-			} else {
-				if (target_lum_low_thr < wYlayer) {
-					denoise_level=denoise_mid_index;
-				} else if (low_thr<wYlayer) {
-					denoise_level = (target_lum_low_thr - wYlayer)*(denoise_max_index-denoise_mid_index);
-					denoise_level /= (target_lum_low_thr - low_thr);
-					denoise_level += denoise_mid_index;
-				} else {
-					denoise_level=denoise_max_index;
-				}
-			}
-		
-		}
+		param.outdoor=ae_param_ptr->smart_pref_y_outdoor;
+		param.min=ae_param_ptr->smart_pref_y_min;
+		param.mid=ae_param_ptr->smart_pref_y_mid;
+		param.max=ae_param_ptr->smart_pref_y_max;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		denoise_level=isp_smart_get_level(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_PREF_Y], &in, &param);
 	}
-		isp_context_ptr->pref.y_thr = denoise_level;
-	
+	isp_context_ptr->pref.y_thr = denoise_level;
+
 	ISP_LOG("ISP_RAW: y_thr:%d\n", denoise_level);
 
 	return rtn;
@@ -1116,119 +1131,27 @@ static uint32_t _isp_adjust_pref_uv(uint32_t handler_id, uint32_t bias_gain, uin
 	return rtn;
 }
 
-static uint32_t _isp_adjust_pref(uint32_t handler_id, uint32_t bias_gain, uint32_t gain, uint32_t max_gain)
-{
-	uint32_t rtn=ISP_SUCCESS;
-	struct isp_context* isp_context_ptr = ispGetAlgContext(handler_id);
-	struct isp_ae_param* ae_param_ptr = ispGetAeContext(handler_id);
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-
-	if(ISP_ZERO!=(AE_SMART_DENOISE&ae_param_ptr->smart)){
-		if(cur_index<=start_index){
-//			isp_context_ptr->pref.bypass = ISP_EB;
-//			ISP_LOG("turn off pref : %d !!!",isp_context_ptr->pref.bypass);
-			isp_context_ptr->pref.y_thr= ae_param_ptr->smart_pref_y_min;
-			isp_context_ptr->pref.u_thr= ae_param_ptr->smart_pref_uv_min;
-			isp_context_ptr->pref.v_thr= ae_param_ptr->smart_pref_uv_min;
-		}else{
-			isp_context_ptr->pref.bypass = isp_context_ptr->pref_bak.bypass;
-			ISP_LOG("recover pref : %d!!!",isp_context_ptr->pref.bypass);
-			_isp_adjust_pref_y(handler_id, bias_gain, gain, max_gain);
-			_isp_adjust_pref_uv(handler_id, bias_gain, gain, max_gain);
-		}
-		isp_context_ptr->tune.pref_y=ISP_EB;
-	}
-
-	return rtn;
-
-}
-
 static uint32_t _isp_adjust_soft_y(uint32_t handler_id, uint32_t bias_gain, uint32_t gain, uint32_t max_gain)
 {
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t denoise_level=0x00;
-	uint16_t thread_hold=0x00;
-	uint16_t denoise_thr=ae_param_ptr->smart_denoise_soft_y_mid_index-ae_param_ptr->smart_denoise_soft_y_min_index;
-	uint32_t denoise_min_index=ae_param_ptr->smart_denoise_soft_y_min_index;
-	uint32_t denoise_mid_index=ae_param_ptr->smart_denoise_soft_y_mid_index;
-	uint32_t denoise_max_index=ae_param_ptr->smart_denoise_soft_y_max_index;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-
-	int32_t EVCompensation=ae_param_ptr->ev;
-	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
-	uint32_t wDeadZone=ae_param_ptr->target_zone;
-	uint32_t target_lum_low_thr=target_lum-wDeadZone;
-	uint32_t wYlayer=ae_param_ptr->cur_lum;
-	uint32_t low_thr=ae_param_ptr->denoise_lum_thr;
-
-	uint32_t outdoor_denoise_level = ae_param_ptr->smart_denoise_soft_y_outdoor_index;
-	uint32_t start_zone = ae_param_ptr->denoise_start_zone;
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = cur_index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
-
 
 	if((ISP_ZERO!=(AE_SMART_DENOISE_SOFT_Y&ae_param_ptr->smart))) {
-		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", max_index,  wYlayer, cur_index, start_index, start_zone);
+		param.outdoor=ae_param_ptr->smart_denoise_soft_y_outdoor_index;
+		param.min=ae_param_ptr->smart_denoise_soft_y_min_index;
+		param.mid=ae_param_ptr->smart_denoise_soft_y_mid_index;
+		param.max=ae_param_ptr->smart_denoise_soft_y_max_index;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", in.max_index,  in.cur_lum, in.cur_index, in.start_index, in.start_zone);
 		ISP_LOG("ISP_RAW: base_gain:0x%x, cur_gain:0x%x, max_gain:0x%x\n", bias_gain,gain,max_gain);
-		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", ae_param_ptr->smart_denoise_soft_y_outdoor_index,  ae_param_ptr->smart_denoise_soft_y_min_index, ae_param_ptr->smart_denoise_soft_y_mid_index, ae_param_ptr->smart_denoise_soft_y_max_index);
-		/* balit/raw wave/ yuv wave */
-		//ISP_LOG("index:%d, max_index:%d, bias_gain:%d, gain:%d, max_gain:%d, exposure:%d",index,max_index, bias_gain, gain, max_gain, exposure);
-		if(cur_index<=start_index) {
-			denoise_level=outdoor_denoise_level;
-		} else {
-
-			if(cur_index<max_index) {
-				if(cur_value<bias_value) {
-					denoise_level=denoise_min_index;
-					if((cur_index < (start_index + start_zone))
-						&&(outdoor_denoise_level<denoise_min_index)){
-						denoise_level = outdoor_denoise_level
-									+ (denoise_min_index - outdoor_denoise_level)*(cur_index - start_index)/start_zone;
-					}
-
-				
-				} else {
-					denoise_level=((cur_value-bias_value)*255)/(max_value-bias_value);
-					denoise_level=(denoise_thr*denoise_level/255)+denoise_min_index;
-					if(denoise_level < denoise_min_index) {
-						denoise_level=denoise_min_index;
-					} else if (denoise_level > denoise_mid_index) {
-						denoise_level=denoise_mid_index;
-					}
-				}
-			} else {
-				if (target_lum_low_thr < wYlayer) {
-					denoise_level=denoise_mid_index;
-				} else if (low_thr<wYlayer) {
-					denoise_level = (target_lum_low_thr - wYlayer)*(denoise_max_index-denoise_mid_index);
-					denoise_level /= (target_lum_low_thr - low_thr);
-					denoise_level += denoise_mid_index;
-				} else {
-					denoise_level=denoise_max_index;
-				}
-			}
-		
-		}
+		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", param.outdoor, param.min, param.mid, param.max);
+		denoise_level=isp_smart_get_level(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_SOFT_Y], &in, &param);
 		ae_param_ptr->prv_noise_info.y_level = denoise_level;
-	
+
 		ISP_LOG("ISP_RAW: denoise_level:%d\n", denoise_level);
 	}
 
@@ -1240,85 +1163,20 @@ static uint32_t _isp_adjust_soft_uv(uint32_t handler_id, uint32_t bias_gain, uin
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t denoise_level=0x00;
-	uint16_t thread_hold=0x00;
-	uint16_t denoise_thr=ae_param_ptr->smart_denoise_soft_uv_mid_index-ae_param_ptr->smart_denoise_soft_uv_min_index;
-	uint32_t denoise_min_index=ae_param_ptr->smart_denoise_soft_uv_min_index;
-	uint32_t denoise_mid_index=ae_param_ptr->smart_denoise_soft_uv_mid_index;
-	uint32_t denoise_max_index=ae_param_ptr->smart_denoise_soft_uv_max_index;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-
-	int32_t EVCompensation=ae_param_ptr->ev;
-	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
-	uint32_t wDeadZone=ae_param_ptr->target_zone;
-	uint32_t target_lum_low_thr=target_lum-wDeadZone;
-	uint32_t wYlayer=ae_param_ptr->cur_lum;
-	uint32_t low_thr=ae_param_ptr->denoise_lum_thr;
-
-	uint32_t outdoor_denoise_level = ae_param_ptr->smart_denoise_soft_uv_outdoor_index;
-	uint32_t start_zone = ae_param_ptr->denoise_start_zone;
-
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = cur_index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
 
-
-	if((ISP_ZERO!=(AE_SMART_DENOISE_SOFT_UV&ae_param_ptr->smart))){
-		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", max_index,  wYlayer, cur_index, start_index, start_zone);
+	if((ISP_ZERO!=(AE_SMART_DENOISE_SOFT_UV&ae_param_ptr->smart))) {
+		param.outdoor=ae_param_ptr->smart_denoise_soft_uv_outdoor_index;
+		param.min=ae_param_ptr->smart_denoise_soft_uv_min_index;
+		param.mid=ae_param_ptr->smart_denoise_soft_uv_mid_index;
+		param.max=ae_param_ptr->smart_denoise_soft_uv_max_index;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", in.max_index,  in.cur_lum, in.cur_index, in.start_index, in.start_zone);
 		ISP_LOG("ISP_RAW: base_gain:0x%x, cur_gain:0x%x, max_gain:0x%x\n", bias_gain,gain,max_gain);
-		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", ae_param_ptr->smart_denoise_soft_uv_outdoor_index,  ae_param_ptr->smart_denoise_soft_uv_min_index, ae_param_ptr->smart_denoise_soft_uv_mid_index, ae_param_ptr->smart_denoise_soft_uv_max_index);
-		/* balit/raw wave/ yuv wave */
-		//ISP_LOG("index:%d, max_index:%d, bias_gain:%d, gain:%d, max_gain:%d, exposure:%d",index,max_index, bias_gain, gain, max_gain, exposure);
-		if(cur_index<=start_index) {
-			denoise_level=outdoor_denoise_level;
-		} else {
-
-			if(cur_index<max_index) {
-				if(cur_value<bias_value) {
-					denoise_level=denoise_min_index;
-					if((cur_index < (start_index + start_zone))
-						&&(outdoor_denoise_level<denoise_min_index)){
-						denoise_level = outdoor_denoise_level
-									+ (denoise_min_index - outdoor_denoise_level)*(cur_index - start_index)/start_zone;
-					}
-
-				
-				} else {
-					denoise_level=((cur_value-bias_value)*255)/(max_value-bias_value);
-					denoise_level=(denoise_thr*denoise_level/255)+denoise_min_index;
-					if(denoise_level < denoise_min_index) {
-						denoise_level=denoise_min_index;
-					} else if (denoise_level > denoise_mid_index) {
-						denoise_level=denoise_mid_index;
-					}
-				}
-			} else {
-				if (target_lum_low_thr < wYlayer) {
-					denoise_level=denoise_mid_index;
-				} else if (low_thr<wYlayer) {
-					denoise_level = (target_lum_low_thr - wYlayer)*(denoise_max_index-denoise_mid_index);
-					denoise_level /= (target_lum_low_thr - low_thr);
-					denoise_level += denoise_mid_index;
-				} else {
-					denoise_level=denoise_max_index;
-				}
-			}
-		
-		}
+		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", param.outdoor, param.min, param.mid, param.max);
+		denoise_level=isp_smart_get_level(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_SOFT_UV], &in, &param);
 		ISP_LOG("ISP_RAW: denoise_level:%d\n", denoise_level);
 	}
 	ae_param_ptr->prv_noise_info.uv_level = denoise_level;
@@ -1332,93 +1190,25 @@ static uint32_t _isp_adjust_denoise_diswei(uint32_t handler_id, uint32_t bias_ga
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
-	uint32_t exposure=ae_param_ptr->tab[ae_mode].e_ptr[cur_index];
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t denoise_level=0x00;
-	uint16_t thread_hold=0x00;
-	uint16_t denoise_thr=ae_param_ptr->smart_denoise_diswei_mid_index-ae_param_ptr->smart_denoise_diswei_min_index;
-	uint32_t denoise_min_index=ae_param_ptr->smart_denoise_diswei_min_index;
-	uint32_t denoise_mid_index=ae_param_ptr->smart_denoise_diswei_mid_index;
-	uint32_t denoise_max_index=ae_param_ptr->smart_denoise_diswei_max_index;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-	uint32_t start_index2=ae_param_ptr->denoise_start_index;
-
-	int32_t EVCompensation=ae_param_ptr->ev;
-	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
-	uint32_t wDeadZone=ae_param_ptr->target_zone;
-	uint32_t target_lum_low_thr=target_lum-wDeadZone;
-	uint32_t wYlayer=ae_param_ptr->cur_lum;
-	uint32_t low_thr=ae_param_ptr->denoise_lum_thr;
-
-	uint32_t outdoor_denoise_level = ae_param_ptr->smart_denoise_diswei_outdoor_index;
-	uint32_t start_zone = ae_param_ptr->denoise_start_zone;
-
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = cur_index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
 
 	denoise_level = isp_context_ptr->ae.cur_denoise_diswei_level;
-	if((ISP_ZERO!=(AE_SMART_DENOISE_DISWEI&ae_param_ptr->smart))){
-		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", max_index,  wYlayer, cur_index, start_index, start_zone);
+	if((ISP_ZERO!=(AE_SMART_DENOISE_DISWEI&ae_param_ptr->smart))) {
+		param.outdoor=ae_param_ptr->smart_denoise_diswei_outdoor_index;
+		param.min=ae_param_ptr->smart_denoise_diswei_min_index;
+		param.mid=ae_param_ptr->smart_denoise_diswei_mid_index;
+		param.max=ae_param_ptr->smart_denoise_diswei_max_index;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", in.max_index,  in.cur_lum, in.cur_index, in.start_index, in.start_zone);
 		ISP_LOG("ISP_RAW: base_gain:0x%x, cur_gain:0x%x, max_gain:0x%x\n", bias_gain,gain,max_gain);
-		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", ae_param_ptr->smart_denoise_diswei_outdoor_index,  ae_param_ptr->smart_denoise_diswei_min_index, ae_param_ptr->smart_denoise_diswei_mid_index, ae_param_ptr->smart_denoise_diswei_max_index);
-		/* balit/raw wave/ yuv wave */
-		//ISP_LOG("index:%d, max_index:%d, bias_gain:%d, gain:%d, max_gain:%d, exposure:%d",index,max_index, bias_gain, gain, max_gain, exposure);
-		if(cur_index<=start_index) {
-			denoise_level=outdoor_denoise_level;
-		} else if (cur_index<=start_index2) {
-			denoise_level = 1;
-		} else {
-
-			if(cur_index<max_index) {
-				if(cur_value<bias_value) {
-					denoise_level=denoise_min_index;
-					if((cur_index < (start_index + start_zone))
-						&&(outdoor_denoise_level<denoise_min_index)){
-						denoise_level = outdoor_denoise_level
-									+ (denoise_min_index - outdoor_denoise_level)*(cur_index - start_index)/start_zone;
-					}
-
-				
-				} else {
-					denoise_level=((cur_value-bias_value)*255)/(max_value-bias_value);
-					denoise_level=(denoise_thr*denoise_level/255)+denoise_min_index;
-					if(denoise_level < denoise_min_index) {
-						denoise_level=denoise_min_index;
-					} else if (denoise_level > denoise_mid_index) {
-						denoise_level=denoise_mid_index;
-					}
-				}
-			} else {
-				if (target_lum_low_thr < wYlayer) {
-					denoise_level=denoise_mid_index;
-				} else if (low_thr<wYlayer) {
-					denoise_level = (target_lum_low_thr - wYlayer)*(denoise_max_index-denoise_mid_index);
-					denoise_level /= (target_lum_low_thr - low_thr);
-					denoise_level += denoise_mid_index;
-				} else {
-					denoise_level=denoise_max_index;
-				}
-			}
-
-		}
+		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", param.outdoor, param.min, param.mid, param.max);
+		denoise_level=isp_smart_get_level(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_DISWEI], &in, &param);
 	}
-		//ISP_LOG("ISP_RAW: denoise_level:%d\n", denoise_level);
-		isp_ae_set_denoise_diswei(handler_id, denoise_level);
-		isp_ae_set_denosie_diswei_level(handler_id,denoise_level);
+	//ISP_LOG("ISP_RAW: denoise_level:%d\n", denoise_level);
+	isp_ae_set_denoise_diswei(handler_id, denoise_level);
+	isp_ae_set_denosie_diswei_level(handler_id, denoise_level);
 
 	return rtn;
 }
@@ -1428,93 +1218,25 @@ static uint32_t _isp_adjust_denoise_ranwei(uint32_t handler_id, uint32_t bias_ga
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-	uint32_t cur_index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
-	uint32_t exposure=ae_param_ptr->tab[ae_mode].e_ptr[cur_index];
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t denoise_level=0x00;
-	uint16_t thread_hold=0x00;
-	uint16_t denoise_thr=ae_param_ptr->smart_denoise_ranwei_mid_index-ae_param_ptr->smart_denoise_ranwei_min_index;
-	uint32_t denoise_min_index=ae_param_ptr->smart_denoise_ranwei_min_index;
-	uint32_t denoise_mid_index=ae_param_ptr->smart_denoise_ranwei_mid_index;
-	uint32_t denoise_max_index=ae_param_ptr->smart_denoise_ranwei_max_index;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-	uint32_t start_index2=ae_param_ptr->denoise_start_index;
-
-	int32_t EVCompensation=ae_param_ptr->ev;
-	uint32_t target_lum=ae_param_ptr->target_lum+EVCompensation;
-	uint32_t wDeadZone=ae_param_ptr->target_zone;
-	uint32_t target_lum_low_thr=target_lum-wDeadZone;
-	uint32_t wYlayer=ae_param_ptr->cur_lum;
-	uint32_t low_thr=ae_param_ptr->denoise_lum_thr;
 
-	uint32_t outdoor_denoise_level = ae_param_ptr->smart_denoise_ranwei_outdoor_index;
-	uint32_t start_zone = ae_param_ptr->denoise_start_zone;
-
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = cur_index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
 	denoise_level = ae_param_ptr->cur_denoise_ranwei_level;
 	if((ISP_ZERO!=(AE_SMART_DENOISE_RANWEI&ae_param_ptr->smart))) {
-		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", max_index,  wYlayer, cur_index, start_index, start_zone);
+		param.outdoor=ae_param_ptr->smart_denoise_ranwei_outdoor_index;
+		param.min=ae_param_ptr->smart_denoise_ranwei_min_index;
+		param.mid=ae_param_ptr->smart_denoise_ranwei_mid_index;
+		param.max=ae_param_ptr->smart_denoise_ranwei_max_index;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		ISP_LOG("ISP_RAW: max_index:%d, wYlayer:%d, cur_index:%d, start:%d, zone:%d,\n", in.max_index,  in.cur_lum, in.cur_index, in.start_index, in.start_zone);
 		ISP_LOG("ISP_RAW: base_gain:0x%x, cur_gain:0x%x, max_gain:0x%x\n", bias_gain,gain,max_gain);
-		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", ae_param_ptr->smart_denoise_ranwei_outdoor_index,  ae_param_ptr->smart_denoise_ranwei_min_index, ae_param_ptr->smart_denoise_ranwei_mid_index, ae_param_ptr->smart_denoise_ranwei_max_index);
-		/* balit/raw wave/ yuv wave */
-		//ISP_LOG("index:%d, max_index:%d, bias_gain:%d, gain:%d, max_gain:%d, exposure:%d",index,max_index, bias_gain, gain, max_gain, exposure);
-		if(cur_index<=start_index) {
-			denoise_level=outdoor_denoise_level;
-		} else if (cur_index<=start_index2) {
-			denoise_level = 1;
-		} else {
-
-			if(cur_index<max_index) {
-				if(cur_value<bias_value) {
-					denoise_level=denoise_min_index;
-					if((cur_index < (start_index + start_zone))
-						&&(outdoor_denoise_level<denoise_min_index)){
-						denoise_level = outdoor_denoise_level
-									+ (denoise_min_index - outdoor_denoise_level)*(cur_index - start_index)/start_zone;
-					}
-
-				
-				} else {
-					denoise_level=((cur_value-bias_value)*255)/(max_value-bias_value);
-					denoise_level=(denoise_thr*denoise_level/255)+denoise_min_index;
-					if(denoise_level < denoise_min_index) {
-						denoise_level=denoise_min_index;
-					} else if (denoise_level > denoise_mid_index) {
-						denoise_level=denoise_mid_index;
-					}
-				}
-			} else {
-				if (target_lum_low_thr < wYlayer) {
-					denoise_level=denoise_mid_index;
-				} else if (low_thr<wYlayer) {
-					denoise_level = (target_lum_low_thr - wYlayer)*(denoise_max_index-denoise_mid_index);
-					denoise_level /= (target_lum_low_thr - low_thr);
-					denoise_level += denoise_mid_index;
-				} else {
-					denoise_level=denoise_max_index;
-				}
-			}
-		
-		}
+		ISP_LOG("ISP_RAW: outdoor_index:%d, min_index:%d, mid_index:%d, max_index:%d\n", param.outdoor, param.min, param.mid, param.max);
+		denoise_level=isp_smart_get_level(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_RANWEI], &in, &param);
 	}
-		//ISP_LOG("ISP_RAW: denoise_level:%d\n",denoise_level);
-		isp_ae_set_denoise_ranwei(handler_id, denoise_level);
-		isp_ae_set_denosie_ranwei_level(handler_id, denoise_level);
-
+	//ISP_LOG("ISP_RAW: denoise_level:%d\n", denoise_level);
+	isp_ae_set_denoise_ranwei(handler_id, denoise_level);
+	isp_ae_set_denosie_ranwei_level(handler_id, denoise_level);
 
 	return rtn;
 }
@@ -1528,66 +1250,19 @@ static uint32_t _isp_adjust_edge(uint32_t handler_id, uint32_t bias_gain, uint32
 	uint32_t rtn=ISP_SUCCESS;
 	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
 	struct isp_ae_param* ae_param_ptr=ispGetAeContext(handler_id);
-
-	uint32_t ae_mode=ae_param_ptr->tab_type;
-
-	uint32_t index=ae_param_ptr->cur_index;
-	uint32_t max_index=ae_param_ptr->max_index;
-	uint32_t exposure=ae_param_ptr->tab[ae_mode].e_ptr[index];
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
 	uint32_t edge_index=0x00;
-	uint32_t gain_cali=0x00;
-	uint32_t bias_cali=0x00;
-	uint32_t index_cali=0x00;
-	uint32_t start_index=ae_param_ptr->denoise_start_index;
-	uint32_t max_edge_idx;
-	uint32_t min_edge_idx;
-
-	uint32_t bias_value;
-	uint32_t max_value;
-	uint32_t cur_value;
-
-#if SMART_FOLLOW_INDEX
-	bias_value = start_index;
-	max_value = max_index;
-	cur_value = index;
-#else
-	bias_value = bias_gain;
-	max_value = max_gain;
-	cur_value = gain;
-#endif
 
 	edge_index = isp_context_ptr->edge.strength;
 	if(ISP_ZERO!=(AE_SMART_EDGE&ae_param_ptr->smart)) {
 		/* edge */
-		max_edge_idx = ae_param_ptr->smart_edge_max_index;
-		min_edge_idx = ae_param_ptr->smart_edge_min_index;
-		if(max_index==index) {
-			edge_index=ae_param_ptr->smart_edge_min_index;
-		}else if(index < start_index) {
-			edge_index=ae_param_ptr->smart_edge_max_index;
-		} else {
-			max_edge_idx = ae_param_ptr->smart_edge_max_index;
-			min_edge_idx = ae_param_ptr->smart_edge_min_index;
-			max_edge_idx = max_edge_idx>min_edge_idx ? max_edge_idx-1 : max_edge_idx;
-			if((cur_value<=bias_value)
-				||(max_value<=bias_value)) {
-				edge_index=max_edge_idx;
-			} else {
-				bias_cali=max_value-bias_value;
-				gain_cali=cur_value-bias_value;
-				index_cali=max_edge_idx-min_edge_idx;
-				edge_index=index_cali*gain_cali/bias_cali;
-			
-				edge_index=max_edge_idx-edge_index;
-			}
-		}
-
-		if (edge_index<min_edge_idx) {
-			edge_index=min_edge_idx;
-		} else if (edge_index>max_edge_idx) {
-			edge_index=max_edge_idx;
-		}
-
+		param.outdoor=0x00;
+		param.min=ae_param_ptr->smart_edge_min_index;
+		param.mid=0x00;
+		param.max=ae_param_ptr->smart_edge_max_index;
+		_isp_smart_get_in(handler_id, bias_gain, gain, max_gain, &in);
+		edge_index=isp_smart_get_edge(&isp_context_ptr->smart_track.level[ISP_SMART_LEVEL_EDGE], &in, &param);
 	}
 	if (edge_index >= 64) {		
 		isp_context_ptr->edge.detail_thr=isp_context_ptr->edge_tab[edge_index - 64].detail_thr;
@@ -1599,7 +1274,6 @@ static uint32_t _isp_adjust_edge(uint32_t handler_id, uint32_t bias_gain, uint32
 		isp_context_ptr->edge.strength=edge_index;
 	}
 		//ISP_LOG("smart edge_index:%d,detail:%d,smooth:%d,strength:%d",edge_index,isp_context_ptr->edge.detail_thr,isp_context_ptr->edge.smooth_thr,isp_context_ptr->edge.strength);
-		isp_context_ptr->tune.edge=ISP_EB;
 
 	return rtn;
 }
@@ -1703,7 +1377,9 @@ int32_t isp_ae_fast_smart_adjust(uint32_t handler_id, int32_t cur_ev, uint32_t e
 		cur_gain=isp_ae_get_real_gain(cur_gain);
 		max_gain=isp_ae_get_real_gain(max_gain);
 		/* max_gain/bias_gain/gain */
+		_isp_smart_track_begin(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_GAMMA));
 		_isp_adjust_gamma(handler_id, cur_index);
+		_isp_smart_track_end(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_GAMMA));
 		isp_adjust_cmc(handler_id, cur_ev);
 	}
 
@@ -1741,11 +1417,13 @@ int32_t isp_ae_stab_smart_adjust(uint32_t handler_id, int32_t cur_ev)
 
 	ISP_LOG("smart:%d, bias_gain:%d, gain:%d, max_gain:%d",ae_param_ptr->smart, bias_gain, gain, max_gain);
 
+	_isp_smart_track_begin(handler_id, ISP_SMART_STAB_BLOCK);
 	_isp_adjust_denoise(handler_id, bias_gain, gain, max_gain);
 	_isp_nr_strength_adjust(handler_id);
 
 	_isp_adjust_edge(handler_id, bias_gain, gain, max_gain);
 	_isp_edge_strength_adjust(handler_id);
+	_isp_smart_track_end(handler_id, ISP_SMART_STAB_BLOCK);
 	_isp_adjust_lnc(handler_id, cur_index, max_index);
 	isp_adjust_cmc(handler_id, EVCompensation);
 
@@ -1766,8 +1444,10 @@ int32_t _isp_set_nr_strength (uint32_t handler_id)
 	bias_gain=isp_ae_get_real_gain(bias_gain);
 	gain=isp_ae_get_real_gain(gain);
 	max_gain=isp_ae_get_real_gain(max_gain);
+	_isp_smart_track_begin(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_DENOISE)|ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_PREF));
 	_isp_adjust_denoise(handler_id, bias_gain, gain, max_gain);
 	_isp_nr_strength_adjust(handler_id);
+	_isp_smart_track_end(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_DENOISE)|ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_PREF));
 	return rtn;
 }
 int32_t _isp_set_edge_strength (uint32_t handler_id)
@@ -1784,8 +1464,10 @@ int32_t _isp_set_edge_strength (uint32_t handler_id)
 	bias_gain=isp_ae_get_real_gain(bias_gain);
 	gain=isp_ae_get_real_gain(gain);
 	max_gain=isp_ae_get_real_gain(max_gain);
+	_isp_smart_track_begin(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_EDGE));
 	_isp_adjust_edge(handler_id, bias_gain, gain, max_gain);
 	_isp_edge_strength_adjust(handler_id);
+	_isp_smart_track_end(handler_id, ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_EDGE));
 	return rtn;
 }
 int32_t isp_adjust_switch_denoise(uint32_t handler_id, int is_single)
@@ -1799,6 +1481,21 @@ int32_t isp_adjust_switch_denoise(uint32_t handler_id, int is_single)
 	return rtn;
 }
 
+/* isp_smart_get_stat --
+*@ hit/miss of the smart level memos and how often each block the
+*@ smart adjust writes had to be programmed
+*@ return:
+*/
+int32_t isp_smart_get_stat(uint32_t handler_id, struct isp_smart_stat* stat_ptr)
+{
+	int32_t rtn = ISP_SUCCESS;
+	struct isp_context* isp_context_ptr=ispGetAlgContext(handler_id);
+
+	isp_smart_track_get_stat(&isp_context_ptr->smart_track, stat_ptr);
+
+	return rtn;
+}
+
 
 /**----------------------------------------------------------------------------*
 **					Compiler Flag				**
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include "isp_smart_track.h"
+/**---------------------------------------------------------------------------*
+ ** 				Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**---------------------------------------------------------------------------*
+**				Micro Define					*
+**----------------------------------------------------------------------------*/
+#define ISP_SMART_REGION_OUTDOOR 0x00
+#define ISP_SMART_REGION_ZONE 0x01
+#define ISP_SMART_REGION_GAIN 0x02
+#define ISP_SMART_REGION_LUM_MID 0x03
+#define ISP_SMART_REGION_LUM 0x04
+#define ISP_SMART_REGION_LUM_MAX 0x05
+
+#define ISP_SMART_REGION_EDGE_MIN 0x00
+#define ISP_SMART_REGION_EDGE_MAX 0x01
+#define ISP_SMART_REGION_EDGE_BIAS 0x02
+#define ISP_SMART_REGION_EDGE_GAIN 0x03
+
+/**---------------------------------------------------------------------------*
+**				Local Function Prototypes				*
+**---------------------------------------------------------------------------*/
+
+/* _isp_smart_level_key --
+*@ keep only the inputs the level reads in the ae region cur_index is in,
+*@ so ae steps that can not change the level share one key
+*@ return:
+*/
+static void _isp_smart_level_key(const struct isp_smart_in* in, const struct isp_smart_level_param* param, struct isp_smart_key* key)
+{
+	memset((void*)key, 0x00, sizeof(struct isp_smart_key));
+	key->param = *param;
+
+	if (in->cur_index<=in->start_index) {
+		key->region = ISP_SMART_REGION_OUTDOOR;
+	} else if (in->cur_index<in->max_index) {
+		if (in->cur_value<in->bias_value) {
+			key->region = ISP_SMART_REGION_ZONE;
+			key->value[0] = in->cur_index - in->start_index;
+			key->value[1] = in->start_zone;
+		} else {
+			key->region = ISP_SMART_REGION_GAIN;
+			key->value[0] = in->cur_value - in->bias_value;
+			key->value[1] = in->max_value - in->bias_value;
+		}
+	} else {
+		if (in->target_lum_low_thr < in->cur_lum) {
+			key->region = ISP_SMART_REGION_LUM_MID;
+		} else if (in->low_thr < in->cur_lum) {
+			key->region = ISP_SMART_REGION_LUM;
+			key->value[0] = in->target_lum_low_thr - in->cur_lum;
+			key->value[1] = in->target_lum_low_thr - in->low_thr;
+		} else {
+			key->region = ISP_SMART_REGION_LUM_MAX;
+		}
+	}
+}
+
+/* _isp_smart_level_calc --
+*@ the denoise level interpolation of the smart adjust, from the key only
+*@
+*@ return: level
+*/
+static uint32_t _isp_smart_level_calc(const struct isp_smart_key* key)
+{
+	const struct isp_smart_level_param* param = &key->param;
+	uint16_t denoise_thr = param->mid - param->min;
+	uint32_t level = 0x00;
+
+	switch (key->region) {
+	case ISP_SMART_REGION_OUTDOOR:
+		level = param->outdoor;
+		break;
+	case ISP_SMART_REGION_ZONE:
+		level = param->min;
+		if ((key->value[0] < key->value[1])
+			&& (param->outdoor < param->min)) {
+			level = param->outdoor + (param->min - param->outdoor)*key->value[0]/key->value[1];
+		}
+		break;
+	case ISP_SMART_REGION_GAIN:
+		level = (key->value[0]*255)/key->value[1];
+		level = (denoise_thr*level/255) + param->min;
+		if (level < param->min) {
+			level = param->min;
+		} else if (level > param->mid) {
+			level = param->mid;
+		}
+		break;
+	case ISP_SMART_REGION_LUM_MID:
+		level = param->mid;
+		break;
+	case ISP_SMART_REGION_LUM:
+		level = key->value[0]*(param->max - param->mid);
+		level /= key->value[1];
+		level += param->mid;
+		break;
+	default:
+		level = param->max;
+		break;
+	}
+
+	return level;
+}
+
+/* _isp_smart_edge_key --
+*@
+*@
+*@ return:
+*/
+static void _isp_smart_edge_key(const struct isp_smart_in* in, const struct isp_smart_level_param* param, struct isp_smart_key* key)
+{
+	memset((void*)key, 0x00, sizeof(struct isp_smart_key));
+	key->param.min = param->min;
+	key->param.max = param->max;
+
+	if (in->max_index == in->cur_index) {
+		key->region = ISP_SMART_REGION_EDGE_MIN;
+	} else if (in->cur_index < in->start_index) {
+		key->region = ISP_SMART_REGION_EDGE_MAX;
+	} else if ((in->cur_value <= in->bias_value)
+		|| (in->max_value <= in->bias_value)) {
+		key->region = ISP_SMART_REGION_EDGE_BIAS;
+	} else {
+		key->region = ISP_SMART_REGION_EDGE_GAIN;
+		key->value[0] = in->cur_value - in->bias_value;
+		key->value[1] = in->max_value - in->bias_value;
+	}
+}
+
+/* _isp_smart_edge_calc --
+*@ the edge index of the smart adjust, from the key only
+*@
+*@ return: edge index
+*/
+static uint32_t _isp_smart_edge_calc(const struct isp_smart_key* key)
+{
+	uint32_t min_edge_idx = key->param.min;
+	uint32_t max_edge_idx = key->param.max;
+	uint32_t edge_index = 0x00;
+
+	if (ISP_SMART_REGION_EDGE_MIN == key->region) {
+		edge_index = min_edge_idx;
+	} else if (ISP_SMART_REGION_EDGE_MAX == key->region) {
+		edge_index = max_edge_idx;
+	} else {
+		max_edge_idx = max_edge_idx>min_edge_idx ? max_edge_idx-1 : max_edge_idx;
+		if (ISP_SMART_REGION_EDGE_BIAS == key->region) {
+			edge_index = max_edge_idx;
+		} else {
+			edge_index = (max_edge_idx-min_edge_idx)*key->value[0]/key->value[1];
+			edge_index = max_edge_idx-edge_index;
+		}
+	}
+
+	if (edge_index < min_edge_idx) {
+		edge_index = min_edge_idx;
+	} else if (edge_index > max_edge_idx) {
+		edge_index = max_edge_idx;
+	}
+
+	return edge_index;
+}
+
+/* _isp_smart_memo_get --
+*@
+*@
+*@ return: 1 when the memo holds the level of the key
+*/
+static uint32_t _isp_smart_memo_get(struct isp_smart_memo* memo, const struct isp_smart_key* key)
+{
+	if ((0x00 != memo->valid)
+		&& (0x00 == memcmp((void*)&memo->key, (void*)key, sizeof(struct isp_smart_key)))) {
+		memo->hit++;
+		return 0x01;
+	}
+
+	memo->miss++;
+	return 0x00;
+}
+
+static void _isp_smart_memo_set(struct isp_smart_memo* memo, const struct isp_smart_key* key, uint32_t level)
+{
+	memo->key = *key;
+	memo->level = level;
+	memo->valid = 0x01;
+}
+
+/**---------------------------------------------------------------------------*
+**				Public Function Prototypes				*
+**---------------------------------------------------------------------------*/
+
+/* isp_smart_get_level --
+*@ the smart denoise level of the ae state, computed only when an input it
+*@ depends on changed since the last call
+*@ return: level
+*/
+uint32_t isp_smart_get_level(struct isp_smart_memo* memo, const struct isp_smart_in* in, const struct isp_smart_level_param* param)
+{
+	struct isp_smart_key key;
+
+	_isp_smart_level_key(in, param, &key);
+
+	if (0x00 == _isp_smart_memo_get(memo, &key)) {
+		_isp_smart_memo_set(memo, &key, _isp_smart_level_calc(&key));
+	}
+
+	return memo->level;
+}
+
+/* isp_smart_get_edge --
+*@
+*@
+*@ return: edge index
+*/
+uint32_t isp_smart_get_edge(struct isp_smart_memo* memo, const struct isp_smart_in* in, const struct isp_smart_level_param* param)
+{
+	struct isp_smart_key key;
+
+	_isp_smart_edge_key(in, param, &key);
+
+	if (0x00 == _isp_smart_memo_get(memo, &key)) {
+		_isp_smart_memo_set(memo, &key, _isp_smart_edge_calc(&key));
+	}
+
+	return memo->level;
+}
+
+/* isp_smart_fit_gamma --
+*@ axis = (gamma0*(denominator-numerator) + gamma1*numerator)/denominator
+*@
+*@ return:
+*/
+void isp_smart_fit_gamma(struct isp_smart_gamma_memo* memo, const uint16_t* gamma0, const uint16_t* gamma1, uint32_t numerator, uint32_t denominator, uint16_t* axis)
+{
+	uint32_t tmp = 0, tmp1 = 0;
+	uint32_t i = 0;
+
+	if ((0x00 != memo->valid)
+		&& (numerator == memo->numerator)
+		&& (denominator == memo->denominator)
+		&& (0x00 == memcmp((void*)memo->gamma0, (void*)gamma0, sizeof(memo->gamma0)))
+		&& (0x00 == memcmp((void*)memo->gamma1, (void*)gamma1, sizeof(memo->gamma1)))) {
+		memo->hit++;
+	} else {
+		memo->miss++;
+		for (i = 0; i < ISP_SMART_GAMMA_NUM; i++) {
+			tmp = gamma0[i] * (denominator-numerator);
+			tmp1 = gamma1[i] * numerator;
+			memo->axis[i] = (tmp + tmp1)/denominator;
+		}
+		memcpy((void*)memo->gamma0, (void*)gamma0, sizeof(memo->gamma0));
+		memcpy((void*)memo->gamma1, (void*)gamma1, sizeof(memo->gamma1));
+		memo->numerator = numerator;
+		memo->denominator = denominator;
+		memo->valid = 0x01;
+	}
+
+	memcpy((void*)axis, (void*)memo->axis, sizeof(memo->axis));
+}
+
+/* isp_smart_track_begin --
+*@ keep the parameters of the blocks in mask before a smart adjust pass
+*@
+*@ return:
+*/
+void isp_smart_track_begin(struct isp_smart_track* track, const struct isp_smart_block* block, uint32_t mask)
+{
+	uint32_t i = 0;
+
+	track->shot_mask = 0x00;
+
+	for (i = 0; i < ISP_SMART_BLOCK_NUM; i++) {
+		if ((0x00 != (mask&ISP_SMART_BLOCK_BIT(i)))
+			&& (ISP_SMART_SHOT_SIZE >= block[i].size)) {
+			memcpy((void*)track->shot[i], block[i].param_ptr, block[i].size);
+			track->shot_mask |= ISP_SMART_BLOCK_BIT(i);
+		}
+	}
+}
+
+/* isp_smart_track_end --
+*@ mark the blocks in mask the pass changed to be programmed at the next sof,
+*@ blocks that came out as they went in keep their registers
+*@ return: mask of the changed blocks
+*/
+uint32_t isp_smart_track_end(struct isp_smart_track* track, const struct isp_smart_block* block, uint32_t mask)
+{
+	uint32_t changed = 0x00;
+	uint32_t i = 0;
+
+	for (i = 0; i < ISP_SMART_BLOCK_NUM; i++) {
+		if (0x00 == (mask&ISP_SMART_BLOCK_BIT(i))) {
+			continue;
+		}
+
+		if ((0x00 == (track->shot_mask&ISP_SMART_BLOCK_BIT(i)))
+			|| (0x00 != memcmp((void*)track->shot[i], block[i].param_ptr, block[i].size))) {
+			*block[i].tune_ptr = ISP_SMART_TUNE_EB;
+			track->dirty[i]++;
+			changed |= ISP_SMART_BLOCK_BIT(i);
+		} else {
+			track->clean[i]++;
+		}
+	}
+
+	return changed;
+}
+
+/* isp_smart_track_get_stat --
+*@
+*@
+*@ return:
+*/
+void isp_smart_track_get_stat(const struct isp_smart_track* track, struct isp_smart_stat* stat)
+{
+	uint32_t i = 0;
+
+	memset((void*)stat, 0x00, sizeof(struct isp_smart_stat));
+
+	for (i = 0; i < ISP_SMART_LEVEL_NUM; i++) {
+		stat->level_hit[i] = track->level[i].hit;
+		stat->level_miss[i] = track->level[i].miss;
+	}
+
+	stat->gamma_hit = track->gamma.hit;
+	stat->gamma_miss = track->gamma.miss;
+
+	for (i = 0; i < ISP_SMART_BLOCK_NUM; i++) {
+		stat->block_dirty[i] = track->dirty[i];
+		stat->block_clean[i] = track->clean[i];
+	}
+}
+
+/**----------------------------------------------------------------------------*
+**					Compiler Flag				**
+**----------------------------------------------------------------------------*/
+#ifdef	__cplusplus
+}
+#endif
+/**---------------------------------------------------------------------------*/
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "isp_stat_kernel.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+/**---------------------------------------------------------------------------*
+ ** 				Compiler Flag					*
+ **---------------------------------------------------------------------------*/
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**---------------------------------------------------------------------------*
+**				Micro Define					*
+**----------------------------------------------------------------------------*/
+/* bit fields of the two awbm output words, g is the low g_bits of the
+ * first word, b straddles the words, r is above r_shift of the second */
+struct isp_stat_awbm_bits{
+	uint32_t g_bits;
+	uint32_t r_shift;
+	uint32_t r_mask;
+};
+
+static const struct isp_stat_awbm_bits s_isp_stat_awbm_bits[ISP_STAT_AWBM_MAX]={
+	{21, 9, 0xfffff},
+	{22, 11, 0x1fffff}
+};
+
+/**---------------------------------------------------------------------------*
+**				Local Function Prototypes				*
+**---------------------------------------------------------------------------*/
+
+/* isp_stat_unpack_aem_c --
+*@
+*@
+*@ return:
+*/
+void isp_stat_unpack_aem_c(const uint32_t* src, uint32_t stride, uint32_t offset, uint32_t mask, uint32_t* y, uint32_t num)
+{
+	uint32_t i = 0;
+
+	src += offset;
+	for (i=0; i<num; i++) {
+		y[i] = src[i*stride]&mask;
+	}
+}
+
+/* isp_stat_unpack_awbm_c --
+*@
+*@
+*@ return:
+*/
+void isp_stat_unpack_awbm_c(const uint32_t* src, uint32_t stride, uint32_t offset, enum isp_stat_awbm_layout layout, uint32_t* r, uint32_t* g, uint32_t* b, uint32_t num)
+{
+	const struct isp_stat_awbm_bits* bits = &s_isp_stat_awbm_bits[layout];
+	uint32_t g_mask = (1<<bits->g_bits)-1;
+	uint32_t b_mask = (1<<bits->r_shift)-1;
+	uint32_t i = 0;
+	uint32_t t0 = 0;
+	uint32_t t1 = 0;
+
+	src += offset;
+	for (i=0; i<num; i++) {
+		t0 = src[(2*i)*stride];
+		t1 = src[(2*i+1)*stride];
+		r[i] = (t1>>bits->r_shift)&bits->r_mask;
+		g[i] = t0&g_mask;
+		b[i] = ((t1&b_mask)<<(32-bits->g_bits)) | (t0>>bits->g_bits);
+	}
+}
+
+#if ISP_STAT_SIMD
+/* the vector kernels only take the record layout of 32 bit isp_reg_bits */
+#define ISP_STAT_SIMD_STRIDE 2
+#define ISP_STAT_SIMD_OFFSET 1
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+typedef uint32x4_t isp_stat_vec;
+
+#define ISP_STAT_LOAD(p) vld1q_u32(p)
+#define ISP_STAT_STORE(p, v) vst1q_u32(p, v)
+#define ISP_STAT_DUP(x) vdupq_n_u32(x)
+#define ISP_STAT_AND(a, b) vandq_u32(a, b)
+#define ISP_STAT_OR(a, b) vorrq_u32(a, b)
+#define ISP_STAT_SHR(a, n) vshlq_u32(a, vdupq_n_s32(-(int32_t)(n)))
+#define ISP_STAT_SHL(a, n) vshlq_u32(a, vdupq_n_s32((int32_t)(n)))
+
+/* _isp_stat_deinterleave2 --
+*@ the value words of four records
+*@
+*@ return:
+*/
+static isp_stat_vec _isp_stat_deinterleave2(const uint32_t* src)
+{
+	uint32x4x2_t v = vld2q_u32(src);
+
+	return v.val[ISP_STAT_SIMD_OFFSET];
+}
+
+/* _isp_stat_deinterleave4 --
+*@ the value words of four awbm items, t0 of the first record and t1 of
+*@ the second
+*@ return:
+*/
+static void _isp_stat_deinterleave4(const uint32_t* src, isp_stat_vec* t0, isp_stat_vec* t1)
+{
+	uint32x4x4_t v = vld4q_u32(src);
+
+	*t0 = v.val[ISP_STAT_SIMD_OFFSET];
+	*t1 = v.val[ISP_STAT_SIMD_STRIDE+ISP_STAT_SIMD_OFFSET];
+}
+
+#else
+typedef __m128i isp_stat_vec;
+
+#define ISP_STAT_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define ISP_STAT_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define ISP_STAT_DUP(x) _mm_set1_epi32((int32_t)(x))
+#define ISP_STAT_AND(a, b) _mm_and_si128(a, b)
+#define ISP_STAT_OR(a, b) _mm_or_si128(a, b)
+#define ISP_STAT_SHR(a, n) _mm_srl_epi32(a, _mm_cvtsi32_si128((int32_t)(n)))
+#define ISP_STAT_SHL(a, n) _mm_sll_epi32(a, _mm_cvtsi32_si128((int32_t)(n)))
+
+/* _isp_stat_deinterleave2 --
+*@ the value words of four records
+*@
+*@ return:
+*/
+static isp_stat_vec _isp_stat_deinterleave2(const uint32_t* src)
+{
+	isp_stat_vec v0 = _mm_shuffle_epi32(ISP_STAT_LOAD(src), _MM_SHUFFLE(3, 1, 3, 1));
+	isp_stat_vec v1 = _mm_shuffle_epi32(ISP_STAT_LOAD(src+4), _MM_SHUFFLE(3, 1, 3, 1));
+
+	return _mm_unpacklo_epi64(v0, v1);
+}
+
+/* _isp_stat_deinterleave4 --
+*@ the value words of four awbm items, t0 of the first record and t1 of
+*@ the second
+*@ return:
+*/
+static void _isp_stat_deinterleave4(const uint32_t* src, isp_stat_vec* t0, isp_stat_vec* t1)
+{
+	isp_stat_vec v0 = _mm_shuffle_epi32(ISP_STAT_LOAD(src), _MM_SHUFFLE(3, 1, 3, 1));
+	isp_stat_vec v1 = _mm_shuffle_epi32(ISP_STAT_LOAD(src+4), _MM_SHUFFLE(3, 1, 3, 1));
+	isp_stat_vec v2 = _mm_shuffle_epi32(ISP_STAT_LOAD(src+8), _MM_SHUFFLE(3, 1, 3, 1));
+	isp_stat_vec v3 = _mm_shuffle_epi32(ISP_STAT_LOAD(src+12), _MM_SHUFFLE(3, 1, 3, 1));
+	isp_stat_vec v01 = _mm_unpacklo_epi32(v0, v1);
+	isp_stat_vec v23 = _mm_unpacklo_epi32(v2, v3);
+
+	*t0 = _mm_unpacklo_epi64(v01, v23);
+	*t1 = _mm_unpackhi_epi64(v01, v23);
+}
+
+#endif
+
+/* isp_stat_unpack_aem --
+*@
+*@
+*@ return:
+*/
+void isp_stat_unpack_aem(const uint32_t* src, uint32_t stride, uint32_t offset, uint32_t mask, uint32_t* y, uint32_t num)
+{
+	isp_stat_vec v_mask = ISP_STAT_DUP(mask);
+	uint32_t i = 0;
+
+	if ((ISP_STAT_SIMD_STRIDE!=stride) || (ISP_STAT_SIMD_OFFSET!=offset)) {
+		isp_stat_unpack_aem_c(src, stride, offset, mask, y, num);
+		return;
+	}
+
+	for (i=0; i+4<=num; i+=4) {
+		ISP_STAT_STORE(y+i, ISP_STAT_AND(_isp_stat_deinterleave2(src+i*stride), v_mask));
+	}
+	isp_stat_unpack_aem_c(src+i*stride, stride, offset, mask, y+i, num-i);
+}
+
+/* isp_stat_unpack_awbm --
+*@
+*@
+*@ return:
+*/
+void isp_stat_unpack_awbm(const uint32_t* src, uint32_t stride, uint32_t offset, enum isp_stat_awbm_layout layout, uint32_t* r, uint32_t* g, uint32_t* b, uint32_t num)
+{
+	const struct isp_stat_awbm_bits* bits = &s_isp_stat_awbm_bits[layout];
+	isp_stat_vec g_mask = ISP_STAT_DUP((1<<bits->g_bits)-1);
+	isp_stat_vec b_mask = ISP_STAT_DUP((1<<bits->r_shift)-1);
+	isp_stat_vec r_mask = ISP_STAT_DUP(bits->r_mask);
+	isp_stat_vec t0;
+	isp_stat_vec t1;
+	uint32_t i = 0;
+
+	if ((ISP_STAT_SIMD_STRIDE!=stride) || (ISP_STAT_SIMD_OFFSET!=offset)) {
+		isp_stat_unpack_awbm_c(src, stride, offset, layout, r, g, b, num);
+		return;
+	}
+
+	for (i=0; i+4<=num; i+=4) {
+		_isp_stat_deinterleave4(src+2*i*stride, &t0, &t1);
+		ISP_STAT_STORE(r+i, ISP_STAT_AND(ISP_STAT_SHR(t1, bits->r_shift), r_mask));
+		ISP_STAT_STORE(g+i, ISP_STAT_AND(t0, g_mask));
+		ISP_STAT_STORE(b+i, ISP_STAT_OR(ISP_STAT_SHL(ISP_STAT_AND(t1, b_mask), 32-bits->g_bits), ISP_STAT_SHR(t0, bits->g_bits)));
+	}
+	isp_stat_unpack_awbm_c(src+2*i*stride, stride, offset, layout, r+i, g+i, b+i, num-i);
+}
+#else
+void isp_stat_unpack_aem(const uint32_t* src, uint32_t stride, uint32_t offset, uint32_t mask, uint32_t* y, uint32_t num)
+{
+	isp_stat_unpack_aem_c(src, stride, offset, mask, y, num);
+}
+
+void isp_stat_unpack_awbm(const uint32_t* src, uint32_t stride, uint32_t offset, enum isp_stat_awbm_layout layout, uint32_t* r, uint32_t* g, uint32_t* b, uint32_t num)
+{
+	isp_stat_unpack_awbm_c(src, stride, offset, layout, r, g, b, num);
+}
+#endif
+
+/**----------------------------------------------------------------------------*
+**					Compiler Flag				**
+**----------------------------------------------------------------------------*/
+#ifdef	__cplusplus
+}
+#endif
+/**---------------------------------------------------------------------------*/
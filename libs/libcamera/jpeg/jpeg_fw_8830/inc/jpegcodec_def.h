@@ -21,7 +21,9 @@
 
 
 
+#ifndef PROGRESSIVE_SUPPORT
 #define PROGRESSIVE_SUPPORT 0
+#endif
 
 /*down sample*/
 #define DOWN_SAMPLE_DIS	0
@@ -117,14 +119,23 @@ typedef struct
 	uint8		*src_buf;		/* start of buffer */
 	uint32      	src_buf_len;   /* src mem buffer len */		
 	uint32		bytes_in_buf;
-	uint32		jstream_words;
+	uint64		jstream_words;
 	uint32		jremain_bit_num;
 	uint32      	read_write_bytes;
 } bitstream_info;
 
 /* Derived data constructed for each Huffman table */
 
-#define HUFF_LOOKAHEAD 	8	/* # of bits of lookahead */
+#define HUFF_LOOKAHEAD 	10	/* # of bits of lookahead */
+
+/* look_up[] entry, 0 if the code is longer than HUFF_LOOKAHEAD */
+#define HUFF_LOOK_NBITS(e)		((e) & 15)
+/* bits of the code and of the coefficient after it, 0 if they do not
+ * all fit in the lookahead or the symbol is an EOB run or ZRL */
+#define HUFF_LOOK_COEF_NBITS(e)	(((e) >> 4) & 15)
+#define HUFF_LOOK_SYM(e)		(((e) >> 8) & 0xFF)
+/* coefficient, sign extended, valid when HUFF_LOOK_COEF_NBITS() is not 0 */
+#define HUFF_LOOK_COEF(e)		((e) >> 16)
 
 typedef struct {
   /* Basic tables: (element [0] of each array is unused) */
@@ -138,13 +149,14 @@ typedef struct {
     /* Link to public Huffman table (needed only in jpeg_huff_decode) */
   HUFF_TBL_T *pub;
   
-  /* Lookahead tables: indexed by the next HUFF_LOOKAHEAD bits of
+  /* Lookahead table: indexed by the next HUFF_LOOKAHEAD bits of
    * the input data stream.  If the next Huffman code is no more
    * than HUFF_LOOKAHEAD bits long, we can obtain its length and
-   * the corresponding symbol directly from these tables.
+   * the corresponding symbol directly from this table, and the
+   * run and the value of the coefficient too when its bits follow
+   * within the lookahead.
    */
-  int32 look_nbits[1<<HUFF_LOOKAHEAD]; /* # bits, or 0 if too long */
-  uint8 look_sym[1<<HUFF_LOOKAHEAD]; /* symbol, or unused */
+  int32 look_up[1<<HUFF_LOOKAHEAD];
 } d_derived_tbl;
 
 typedef struct 
@@ -287,6 +299,7 @@ typedef struct jpeg_progressive_info_tag
 	jpeg_component_info *cur_comp_info[MAX_COMPS_IN_SCAN];
 
 	uint8			low_quality_idct;
+	uint8			idct_size;		/*output block width of jpeg_transform, 8 to 1*/
 	uint32			DC_Diff;
 	JPEG_TRANSFORM_FUN jpeg_transform;
 
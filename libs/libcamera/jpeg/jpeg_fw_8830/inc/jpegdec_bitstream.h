@@ -29,7 +29,9 @@
     {
 #endif
 
-extern uint32 			s_jstream_words;
+/* bits are taken from the top of the s_jremain_bit_num valid ones, a fill
+ * makes it at least 57 */
+extern uint64 			s_jstream_words;
 extern uint32 			s_jremain_bit_num;
 
 #define CHECK_BIT_BUFFER(nbits) \
@@ -42,9 +44,11 @@ extern uint32 			s_jremain_bit_num;
 #define JPEG_GETBITS(nbits) (((int) (s_jstream_words >> (s_jremain_bit_num -= (nbits)))) & ((1<<(nbits))-1))
 
 void JPEG_Fill_Bit_Buffer(void);
-//uint8 huff_DECODE_Progressive(d_derived_tbl *tbl, int32 min_bits);
-//void Update_Global_Bitstrm_Info(bitstream_info *pBitstrmInfo);
-//void Update_Local_Bitstrm_Info(bitstream_info *pBitstrmInfo);
+#if PROGRESSIVE_SUPPORT
+uint8 huff_DECODE_Progressive(d_derived_tbl *tbl, int32 min_bits);
+void Update_Global_Bitstrm_Info(bitstream_info *pBitstrmInfo);
+void Update_Local_Bitstrm_Info(bitstream_info *pBitstrmInfo);
+#endif
 int32 check_RstMarker(void);
 
 PUBLIC JPEG_RET_E  JpegDec_InitBitream(JPEG_DEC_INPUT_PARA_T  *jpeg_dec_input);
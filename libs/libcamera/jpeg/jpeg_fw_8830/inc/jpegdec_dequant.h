@@ -33,6 +33,13 @@ PUBLIC void JPEGFW_InitQuantTbl(JPEG_QUALITY_E level);
 PUBLIC JPEG_RET_E JPEGFW_AdjustQuantTbl_Dec();
 PUBLIC void JPEGFW_InitTransFun(JPEG_PROGRESSIVE_INFO_T *progressive_info_ptr);
 PUBLIC void Initialize_Clip();
+void JPEG_SWIDCT_LOW_Quality(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_High_Quality(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_4X4(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_2X2(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_1X1(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+PUBLIC void JPEG_SWIDCT_Batch(JPEG_PROGRESSIVE_INFO_T *progressive_info_ptr, int16 **block,
+							uint8 **output_buf, const int32 **quantptr, uint32 block_num);
 /**---------------------------------------------------------------------------*
 **                         Compiler Flag                                      *
 **---------------------------------------------------------------------------*/
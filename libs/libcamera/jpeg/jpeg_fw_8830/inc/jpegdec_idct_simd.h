@@ -0,0 +1,65 @@
+/******************************************************************************
+ ** File Name:      jpegdec_idct_simd.h                                       *
+ ** Author:                                                                   *
+ ** DATE:           10/19/2026                                                *
+ ** Copyright:      2007 Spreadtrum, Incoporated. All Rights Reserved.        *
+ ** Description:    NEON/SSE2 dequantization and inverse DCT of the software *
+ **                 decode path, bit exact with the C code.                   *
+ *****************************************************************************/
+/******************************************************************************
+ **                   Edit    History                                         *
+ **---------------------------------------------------------------------------*
+ ** DATE          NAME            DESCRIPTION                                 *
+ ** 10/19/2026                    Create.                                     *
+ *****************************************************************************/
+#ifndef _JPEGDEC_IDCT_SIMD_H_
+#define _JPEGDEC_IDCT_SIMD_H_
+/*----------------------------------------------------------------------------*
+**                        Dependencies                                        *
+**---------------------------------------------------------------------------*/
+#include "jpegcodec_def.h"
+/**---------------------------------------------------------------------------*
+**                        Compiler Flag                                       *
+**---------------------------------------------------------------------------*/
+#ifdef   __cplusplus
+    extern   "C"
+    {
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__SSE2__)
+#define JPEG_SWIDCT_SIMD	1
+#else
+#define JPEG_SWIDCT_SIMD	0
+#endif
+
+/*
+ * JPEGFW_InitTransFun() only picks the SIMD transforms when the 32 bit
+ * low multiply is one instruction. SSE2 makes it of two 32x32->64
+ * multiplies and shuffles, and there the 2x2, 4x4 and 8x8 low ones are
+ * no faster than the C code.
+ */
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__SSE4_1__)
+#define JPEG_SWIDCT_SIMD_SELECT	1
+#else
+#define JPEG_SWIDCT_SIMD_SELECT	0
+#endif
+
+/* 1 when all the AC coefficients of the block are zero */
+PUBLIC uint32 JPEG_SWIDCT_IsDCOnly(const int16 *coef_block);
+
+#if JPEG_SWIDCT_SIMD
+/* same arguments and output as the C functions of jpegdec_dequant.c */
+void JPEG_SWIDCT_LOW_Quality_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_High_Quality_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_4X4_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+void JPEG_SWIDCT_2X2_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr);
+#endif
+/**---------------------------------------------------------------------------*
+**                         Compiler Flag                                      *
+**---------------------------------------------------------------------------*/
+#ifdef   __cplusplus
+    }
+#endif
+/**---------------------------------------------------------------------------*/
+// End
+#endif //_JPEGDEC_IDCT_SIMD_H_
@@ -28,24 +28,32 @@
 #endif
 
 #if PROGRESSIVE_SUPPORT
-#define HUFF_DECODE(result,tbl,slowlabel) \
-{   register int32 nb, look; \
-	if (s_jremain_bit_num < HUFF_FIRST_READ) { \
-    JPEG_Fill_Bit_Buffer();\
-    if (s_jremain_bit_num < HUFF_FIRST_READ) { \
-	nb = 1; goto slowlabel; }\
-	} \
-	look = PEEK_BITS(HUFF_FIRST_READ); \
-	if ((nb = tbl->look_nbits[look]) != 0) { \
-    DROP_BITS(nb); \
-    result = tbl->look_sym[look]; \
+/* look_up[] entry of the next HUFF_LOOKAHEAD bits, nothing dropped */
+#define HUFF_PEEK(look,tbl) \
+{ \
+	CHECK_BIT_BUFFER(HUFF_LOOKAHEAD); \
+	look = tbl->look_up[PEEK_BITS(HUFF_LOOKAHEAD)]; \
+}
+
+/* the symbol of a peeked entry, from the longer codes if not in it */
+#define HUFF_DECODE_LOOK(result,look,tbl) \
+{ \
+	if (HUFF_LOOK_NBITS(look) != 0) { \
+		DROP_BITS(HUFF_LOOK_NBITS(look)); \
+		result = HUFF_LOOK_SYM(look); \
 	} else { \
-    nb = HUFF_FIRST_READ+1; \
-slowlabel: \
-    result=huff_DECODE_Progressive(tbl,nb);\
-} \
+		result = huff_DECODE_Progressive(tbl, HUFF_LOOKAHEAD+1); \
+	} \
 }
 
+#define HUFF_DECODE(result,tbl) \
+{   register int32 look; \
+	HUFF_PEEK(look,tbl); \
+	HUFF_DECODE_LOOK(result,look,tbl); \
+}
+
+uint32 init_scan_entropy_info(phuff_entropy_info *p_entropy_info);
+
 uint32 JPEG_Generate_Entry_Point_Map_Progressive(void);
 #endif
 /**---------------------------------------------------------------------------*
@@ -27,21 +27,19 @@
     {
 #endif
 
-#if _CMODEL_
-#else
-__inline void JPEGFW_PutBits(uint32 val, uint32 nbits);
-/*{
-	READ_REG_POLL(VSP_BSM_REG_BASE+BSM_READY_OFF, 1, 1, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
-
-	VSP_WRITE_REG(VSP_BSM_REG_BASE+BSM_CFG2_OFF, (nbits << 24) , "BSM_CFG2: configure write n bits");
-	VSP_WRITE_REG(VSP_BSM_REG_BASE+BSM_WDATA_OFF, val, "BSM_WDATA: write val(n bits) to bitstream, auto-stuffing");
-}*/
-#endif //_CMODEL_
-
+/*
+* The put functions keep up to 31 bits in the firmware and write the BSM a
+* word at a time. JPEGFW_FlushBits() writes the rest, before the hardware
+* starts or other BSM_CFG2/BSM_WDATA writes.
+*/
+PUBLIC void JPEGFW_InitBits(void);
+PUBLIC void JPEGFW_FlushBits(void);
+PUBLIC void JPEGFW_PutBits(uint32 val, uint32 nbits);
 PUBLIC void JPEGFW_PutC(uint8 ch);
 PUBLIC void JPEGFW_PutW(uint16 w);
 PUBLIC void JPEGFW_PutW_II(uint16 w);
 PUBLIC void JPEGFW_PutBits32_II(uint32 val, uint32 nbits);
+PUBLIC void JPEGFW_PutBytes(const uint8 *buf, uint32 len);
 
 /**---------------------------------------------------------------------------*
 **                         Compiler Flag                                      *
@@ -88,6 +88,7 @@
 		#include "jpegdec_init.h"
 		#include "jpegdec_vld.h"
 		#include "jpegdec_dequant.h"
+		#include "jpegdec_idct_simd.h"
 		#include "jpegdec_malloc.h"
 		#include "jpegdec_bitstream.h"
 		#include "jpegdec_parse.h"
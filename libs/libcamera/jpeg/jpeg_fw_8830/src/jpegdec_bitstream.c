@@ -29,7 +29,7 @@
 
 //for bitstream operation
 uint32 s_read_bytes;
-uint32 s_jstream_words;
+uint64 s_jstream_words;
 uint32 s_jremain_bit_num;
 uint32 s_jremain_byte_num;
 uint32 s_jremain_bit_num_back;
@@ -61,82 +61,130 @@ void Update_Local_Bitstrm_Info(bitstream_info *pBitstrmInfo)
 }
 #endif
 
+/*
+ * The bit buffer stops in front of the marker, so what is left in it is the
+ * padding of the last byte of the interval and the zeros fed after it.
+ * Returns TRUE when a RSTn marker is there, which is skipped.
+ */
 int32 check_RstMarker(void)
 {
-	uint32 i = s_jremain_bit_num>>3;
-//	uint32 flush_bits = s_jremain_bit_num - i*8;
-	uint8 ret = 0; 
+	s_jstream_words = 0;
+	s_jremain_bit_num = 0;
 
-//	flush_read(0xFFFFFFFF);	
-	s_jremain_bit_num = i*8;
- 
-	ret = (uint8)JPEG_GETBITS(8);
-	ret = (uint8)JPEG_GETBITS(8); 
+	/* fill bytes before the marker */
+	while((s_jremain_byte_num > 2) && (0xFF == s_inter_buf_bitstream[0]) && (0xFF == s_inter_buf_bitstream[1]))
+	{
+		s_inter_buf_bitstream++;
+		s_jremain_byte_num--;
+	}
 
-	if((ret < M_RST0) || (ret > M_RST7))
+	if((s_jremain_byte_num < 2) || (0xFF != s_inter_buf_bitstream[0]) ||
+		(s_inter_buf_bitstream[1] < M_RST0) || (s_inter_buf_bitstream[1] > M_RST7))
 	{
-		return JPEG_FAILED;
+		return FALSE;
 	}
 
-	return JPEG_SUCCESS;
+	s_inter_buf_bitstream += 2;
+	s_jremain_byte_num -= 2;
+
+	return TRUE;
 }
 
+/*
+ * Takes the entropy coded data 4 bytes at a time while none of them is 0xFF,
+ * byte by byte around the 0xFF00 stuffing. The data ends at a marker, left
+ * in the buffer, or at the end of the buffer; zeros are fed after it so that
+ * the bits asked for are always there.
+ */
 void JPEG_Fill_Bit_Buffer(void)
 {
-	register uint8 tmp = 0;
+	register uint8 *ptr = s_inter_buf_bitstream;
+	register uint32 left = s_jremain_byte_num;
+	register uint32 bits = s_jremain_bit_num;
+	register uint64 words = s_jstream_words;
+	register uint32 tmp;
 
-	while((s_jremain_bit_num < 15) && s_jremain_byte_num)
+	while((bits <= 32) && (left >= 4))
 	{
-		tmp = *s_inter_buf_bitstream++;
-		s_jremain_byte_num--;
-		
-		if(ESC_MODE && (tmp == 0xFF))
+		tmp = (ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+
+		/* one of the bytes is 0xFF */
+		if(((~tmp) - 0x01010101) & tmp & 0x80808080)
 		{
-			do {
-				tmp = *s_inter_buf_bitstream++;
-				s_jremain_byte_num--;
-			} while(tmp == 0xFF);
+			break;
+		}
+
+		words = (words << 32) | tmp;
+		bits += 32;
+		ptr += 4;
+		left -= 4;
+	}
+
+	while((bits <= 56) && left)
+	{
+		tmp = *ptr;
 
-			if(tmp == 0x00)
+		if(ESC_MODE && (tmp == 0xFF))
+		{
+			if(left < 2)
 			{
-				s_jstream_words = (s_jstream_words<<8) | 0xFF;
-				s_jremain_bit_num += 8;
-			}else if((tmp == M_SOS) || (tmp == M_DHT) || (tmp == M_EOI))
+				break;
+			}
+
+			if(ptr[1] == 0xFF)
 			{
-				return;
-			}else
+				/* fill byte */
+				ptr++;
+				left--;
+				continue;
+			}else if(ptr[1] != 0x00)
 			{
-				s_inter_buf_bitstream -= 2;
-				s_jremain_byte_num+=2;
+				break;
 			}
-		}else
-		{
-			s_jstream_words = (s_jstream_words<<8) | tmp;
-			s_jremain_bit_num += 8;
+
+			ptr++;
+			left--;
 		}
+
+		words = (words << 8) | tmp;
+		bits += 8;
+		ptr++;
+		left--;
 	}
+
+	while(bits <= 56)
+	{
+		words <<= 8;
+		bits += 8;
+	}
+
+	s_inter_buf_bitstream = ptr;
+	s_jremain_byte_num = left;
+	s_jremain_bit_num = bits;
+	s_jstream_words = words;
 }
 #if PROGRESSIVE_SUPPORT
+/* codes of min_bits bits or longer, all 16 bits of them are in the buffer */
 uint8 huff_DECODE_Progressive(d_derived_tbl *tbl, int32 min_bits)
 {
-	register uint16 l = min_bits;
+	register int32 l;
 	register int32 code;
 
-	CHECK_BIT_BUFFER(l);
-	code = JPEG_GETBITS(l);
-	while(code > tbl->maxcode[l])
-	{
-		CHECK_BIT_BUFFER(1);
-		code = ((code << 1) | JPEG_GETBITS(1));
-		l++;
-	}
+	CHECK_BIT_BUFFER(16);
+	code = PEEK_BITS(16);
 
-	if(l > 16)
+	for(l = min_bits; l <= 16; l++)
 	{
-		return 0;
+		if((code >> (16 - l)) <= tbl->maxcode[l])
+		{
+			DROP_BITS(l);
+			return tbl->pub->huffval[(int32)((code >> (16 - l)) + tbl->valoffset[l])];
+		}
 	}
 
-	return tbl->pub->huffval[(int32)(code + tbl->valoffset[l])];
+	DROP_BITS(16);
+
+	return 0;
 }
 #endif
 PUBLIC JPEG_RET_E  JpegDec_InitBitream(JPEG_DEC_INPUT_PARA_T  *jpeg_dec_input)
@@ -210,6 +258,17 @@ PUBLIC BOOLEAN get_short_word(uint16 *value_ptr)
 	uint8 value0 = 0;
 	uint8 value1= 0;
 
+	/* both bytes in the buffer */
+	if (s_jremain_byte_num >= 2 && PNULL != value_ptr)
+	{
+		*value_ptr = (s_inter_buf_ptr[0] << 8) | s_inter_buf_ptr[1];
+		s_inter_buf_ptr += 2;
+		s_jremain_byte_num -= 2;
+		s_header_len += 2;
+
+		return TRUE;
+	}
+
 	if (get_char(&value0) && get_char(&value1) && PNULL != value_ptr)
 	{
 		*value_ptr = (value0 << 8) | value1;
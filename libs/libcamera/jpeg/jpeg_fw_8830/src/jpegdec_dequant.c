@@ -15,6 +15,7 @@
 /*----------------------------------------------------------------------------*
 **                        Dependencies                                        *
 **---------------------------------------------------------------------------*/
+#include <string.h>
 #include "sc8830_video_header.h"
 
 /**---------------------------------------------------------------------------*
@@ -880,6 +881,37 @@ void JPEG_SWIDCT_1X1(int16 *coef_block, uint8 *output_buf, const int32 *quantptr
 	output_buf[0]/*[0]*/ = s_pClip_table[dcval+128];
 }
 
+/************************************************************************/
+/* Dequant and idct the blocks of one MCU                               */
+/************************************************************************/
+PUBLIC void JPEG_SWIDCT_Batch(JPEG_PROGRESSIVE_INFO_T *progressive_info_ptr, int16 **block,
+							uint8 **output_buf, const int32 **quantptr, uint32 block_num)
+{
+	JPEG_TRANSFORM_FUN jpeg_transform = progressive_info_ptr->jpeg_transform;
+	uint32 size = progressive_info_ptr->idct_size;
+	int32 dcval;
+	uint32 i;
+
+	for(i = 0; i < block_num; i++)
+	{
+		/* Flat blocks are common in progressive scans and thumbnails. Every
+		 * transform maps them to one value: the DC over 8, with the low
+		 * quality one's table scaled by a further 4. The 1x1 one reads
+		 * nothing else anyway.
+		 */
+		if(size > 1 && JPEG_SWIDCT_IsDCOnly(block[i]))
+		{
+			dcval = DEQUANTIZE(block[i][0], quantptr[i][0]);
+			dcval = progressive_info_ptr->low_quality_idct ?
+				DESCALE(dcval, LQ_PASS1_BITS+3) : DESCALE(dcval, 3);
+			memset(output_buf[i], s_pClip_table[dcval+128], size*size);
+		}else
+		{
+			(*jpeg_transform)(block[i], output_buf[i], quantptr[i]);
+		}
+	}
+}
+
 /************************************************************************/
 /* Init the transform function                                          */
 /************************************************************************/
@@ -888,17 +920,30 @@ PUBLIC void JPEGFW_InitTransFun(JPEG_PROGRESSIVE_INFO_T *progressive_info_ptr)
 	JPEG_CODEC_T *jpeg_fw_codec = Get_JPEGDecCodec();
 
 	progressive_info_ptr->low_quality_idct = 0;
+	progressive_info_ptr->idct_size = 8 >> jpeg_fw_codec->scale_factor;
 	if(jpeg_fw_codec->scale_factor == 0)
 	{
 		progressive_info_ptr->low_quality_idct = 1;
+#if JPEG_SWIDCT_SIMD_SELECT
+		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_LOW_Quality_SIMD;
+#else
 		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_LOW_Quality;
+#endif
 		progressive_info_ptr->DC_Diff = 8192;
 	}else if(jpeg_fw_codec->scale_factor == 1)
 	{
+#if JPEG_SWIDCT_SIMD_SELECT
+		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_4X4_SIMD;
+#else
  		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_4X4;
+#endif
 	}else if(jpeg_fw_codec->scale_factor == 2)
 	{
+#if JPEG_SWIDCT_SIMD_SELECT
+		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_2X2_SIMD;
+#else
  		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_2X2;
+#endif
 	}else if(jpeg_fw_codec->scale_factor == 3)
 	{
  		progressive_info_ptr->jpeg_transform = JPEG_SWIDCT_1X1;
@@ -642,11 +642,11 @@ PUBLIC JPEG_RET_E START_SW_DECODE_PROGRESSIVE(JPEG_CODEC_T *jpeg_fw_codec, uint3
 	int32 block_id;
 	int32 luma_blk_num;
 	int32 chroma_blk_num;
-	int16 *block;
-	uint8 *rgiDst;
+	int16 *block[MAX_MCU_NUM];
+	uint8 *rgiDst[MAX_MCU_NUM];
 	uint32 ci;
 
-	const int32 *quant;
+	const int32 *quant[MAX_MCU_NUM];
 	uint8 *y_coeff = jpeg_fw_codec->mbio_bfr0_valid ? jpeg_fw_codec->YUV_Info_0.y_data_ptr : jpeg_fw_codec->YUV_Info_1.y_data_ptr;
 	uint8 *uv_coeff = jpeg_fw_codec->mbio_bfr0_valid ? jpeg_fw_codec->YUV_Info_0.u_data_ptr : jpeg_fw_codec->YUV_Info_1.u_data_ptr;
 	JPEG_PROGRESSIVE_INFO_T *progressive_info = JPEGFW_GetProgInfo();
@@ -730,21 +730,21 @@ PUBLIC JPEG_RET_E START_SW_DECODE_PROGRESSIVE(JPEG_CODEC_T *jpeg_fw_codec, uint3
 				if(block_id < luma_blk_num)
 				{
 					offset = ((block_id/luma_h_ratio)*jpeg_fw_codec->mcu_num_x+x)*luma_h_ratio+(block_id%luma_v_ratio);
-					block = progressive_info->block_line[0]+offset*JPEG_FW_DCTSIZE2;
+					block[block_id] = progressive_info->block_line[0]+offset*JPEG_FW_DCTSIZE2;
 				}else
 				{
-					block = progressive_info->block_line[block_id - luma_blk_num+1]+x*JPEG_FW_DCTSIZE2;
+					block[block_id] = progressive_info->block_line[block_id - luma_blk_num+1]+x*JPEG_FW_DCTSIZE2;
 				}
 				
-				rgiDst = progressive_info->org_blocks[block_id];
+				rgiDst[block_id] = progressive_info->org_blocks[block_id];
 				
 				ci = progressive_info->blocks_membership[block_id];
-				quant = progressive_info->quant_tbl_new[jpeg_fw_codec->tbl_map[ci].quant_tbl_id];
-
-				//dequant has been performed in idct transformation
-	 			(*progressive_info->jpeg_transform)(block, rgiDst, quant);
+				quant[block_id] = progressive_info->quant_tbl_new[jpeg_fw_codec->tbl_map[ci].quant_tbl_id];
 			}
 
+			//dequant has been performed in idct transformation
+			JPEG_SWIDCT_Batch(progressive_info, block, rgiDst, quant, progressive_info->block_num);
+
 			//copy MCU data to coeff buffer,Added by wangyi 2007/05/02
 			 MCUToFrm((uint8*)y_coeff, (uint8*)uv_coeff, x, y, scale_factor);
 		}
@@ -0,0 +1,476 @@
+/******************************************************************************
+ ** File Name:      jpegdec_idct_simd.c                                       *
+ ** Author:                                                                   *
+ ** DATE:           10/19/2026                                                *
+ ** Copyright:      2007 Spreadtrum, Incoporated. All Rights Reserved.        *
+ ** Description:    NEON/SSE2 dequantization and inverse DCT of the software *
+ **                 decode path. Every variant computes the same 32 bit      *
+ **                 integer operations as its C version in jpegdec_dequant.c *
+ **                 four columns or rows at a time, so the output is bit     *
+ **                 exact. The zero AC shortcuts of the C code give the same *
+ **                 result as the full transform and are left out.          *
+ ** Note:           None                                                      *
+******************************************************************************/
+/******************************************************************************
+ **                        Edit History                                       *
+ ** ------------------------------------------------------------------------- *
+ ** DATE           NAME             DESCRIPTION                               *
+ ** 10/19/2026                      Create.                                   *
+******************************************************************************/
+/*----------------------------------------------------------------------------*
+**                        Dependencies                                        *
+**---------------------------------------------------------------------------*/
+#include "sc8830_video_header.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+/**---------------------------------------------------------------------------*
+**                        Compiler Flag                                       *
+**---------------------------------------------------------------------------*/
+#ifdef   __cplusplus
+    extern   "C"
+    {
+#endif
+
+PUBLIC uint32 JPEG_SWIDCT_IsDCOnly(const int16 *coef_block)
+{
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	int16x8_t acc = vsetq_lane_s16(0, vld1q_s16(coef_block), 0);
+	int32 i;
+
+	for(i = 1; i < 8; i++)
+	{
+		acc = vorrq_s16(acc, vld1q_s16(coef_block + i * 8));
+	}
+	acc = vorrq_s16(acc, vextq_s16(acc, acc, 4));
+	return (vgetq_lane_u64(vreinterpretq_u64_s16(acc), 0) == 0);
+#elif defined(__SSE2__)
+	__m128i acc = _mm_insert_epi16(_mm_loadu_si128((const __m128i *)coef_block), 0, 0);
+	int32 i;
+
+	for(i = 1; i < 8; i++)
+	{
+		acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(coef_block + i * 8)));
+	}
+	return (_mm_movemask_epi8(_mm_cmpeq_epi16(acc, _mm_setzero_si128())) == 0xffff);
+#else
+	int32 i;
+
+	for(i = 1; i < 64; i++)
+	{
+		if(coef_block[i] != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+#endif
+}
+
+#if JPEG_SWIDCT_SIMD
+
+/*
+ * Four int32 lanes. NEON has every operation; SSE2 lacks the 32 bit
+ * low multiply, made of two 32x32->64 multiplies.
+ */
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+typedef int32x4_t vint32;
+
+#define V_LOAD_S16(p)		vmovl_s16(vld1_s16(p))
+#define V_LOAD_S32(p)		vld1q_s32(p)
+#define V_ADD(a, b)			vaddq_s32(a, b)
+#define V_SUB(a, b)			vsubq_s32(a, b)
+#define V_MUL(a, b)			vmulq_s32(a, b)
+#define V_MULC(a, c)		vmulq_n_s32(a, c)
+#define V_SHL(a, n)			vshlq_n_s32(a, n)
+#define V_SRA(a, n)			vshrq_n_s32(a, n)
+#define V_DUP(c)			vdupq_n_s32(c)
+
+static __inline void v_transpose(vint32 *r0, vint32 *r1, vint32 *r2, vint32 *r3)
+{
+	int32x4x2_t t0 = vtrnq_s32(*r0, *r1);
+	int32x4x2_t t1 = vtrnq_s32(*r2, *r3);
+
+	*r0 = vcombine_s32(vget_low_s32(t0.val[0]), vget_low_s32(t1.val[0]));
+	*r1 = vcombine_s32(vget_low_s32(t0.val[1]), vget_low_s32(t1.val[1]));
+	*r2 = vcombine_s32(vget_high_s32(t0.val[0]), vget_high_s32(t1.val[0]));
+	*r3 = vcombine_s32(vget_high_s32(t0.val[1]), vget_high_s32(t1.val[1]));
+}
+
+/* a then b, saturated to 8 bytes */
+static __inline void v_store_u8x8(uint8 *dst, vint32 a, vint32 b)
+{
+	vst1_u8(dst, vqmovun_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b))));
+}
+
+#else
+
+typedef __m128i vint32;
+
+static __inline __m128i v_load_s16(const int16 *p)
+{
+	__m128i x = _mm_loadl_epi64((const __m128i *)p);
+
+	return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+static __inline __m128i v_mullo(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+	return _mm_mullo_epi32(a, b);
+#else
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+							  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+#define V_LOAD_S16(p)		v_load_s16(p)
+#define V_LOAD_S32(p)		_mm_loadu_si128((const __m128i *)(p))
+#define V_ADD(a, b)			_mm_add_epi32(a, b)
+#define V_SUB(a, b)			_mm_sub_epi32(a, b)
+#define V_MUL(a, b)			v_mullo(a, b)
+#define V_MULC(a, c)		v_mullo(a, _mm_set1_epi32(c))
+#define V_SHL(a, n)			_mm_slli_epi32(a, n)
+#define V_SRA(a, n)			_mm_srai_epi32(a, n)
+#define V_DUP(c)			_mm_set1_epi32(c)
+
+static __inline void v_transpose(vint32 *r0, vint32 *r1, vint32 *r2, vint32 *r3)
+{
+	__m128i t0 = _mm_unpacklo_epi32(*r0, *r1);
+	__m128i t1 = _mm_unpacklo_epi32(*r2, *r3);
+	__m128i t2 = _mm_unpackhi_epi32(*r0, *r1);
+	__m128i t3 = _mm_unpackhi_epi32(*r2, *r3);
+
+	*r0 = _mm_unpacklo_epi64(t0, t1);
+	*r1 = _mm_unpackhi_epi64(t0, t1);
+	*r2 = _mm_unpacklo_epi64(t2, t3);
+	*r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+static __inline void v_store_u8x8(uint8 *dst, vint32 a, vint32 b)
+{
+	__m128i w = _mm_packs_epi32(a, b);
+
+	_mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(w, w));
+}
+
+#endif
+
+/* same rounding as DESCALE() */
+#define V_DESCALE(x, n)		V_SRA(V_ADD(x, V_DUP(1 << ((n) - 1))), n)
+
+#define V_DESCALE8(v, n)	\
+	do {	\
+		v[0] = V_DESCALE(v[0], n); v[1] = V_DESCALE(v[1], n);	\
+		v[2] = V_DESCALE(v[2], n); v[3] = V_DESCALE(v[3], n);	\
+		v[4] = V_DESCALE(v[4], n); v[5] = V_DESCALE(v[5], n);	\
+		v[6] = V_DESCALE(v[6], n); v[7] = V_DESCALE(v[7], n);	\
+	} while(0)
+
+/* row r of four columns from col on, dequantized */
+#define V_DEQUANT(coef, quant, r, col)	\
+	V_MUL(V_LOAD_S16((coef) + (r) * DCTSIZE + (col)), V_LOAD_S32((quant) + (r) * DCTSIZE + (col)))
+
+/*
+ * The steps below are written out, not looped, so that the vectors stay
+ * in registers at -O2.
+ */
+static __inline void v_dequant8(vint32 *v, const int16 *coef, const int32 *quant, int32 col)
+{
+	v[0] = V_DEQUANT(coef, quant, 0, col);
+	v[1] = V_DEQUANT(coef, quant, 1, col);
+	v[2] = V_DEQUANT(coef, quant, 2, col);
+	v[3] = V_DEQUANT(coef, quant, 3, col);
+	v[4] = V_DEQUANT(coef, quant, 4, col);
+	v[5] = V_DEQUANT(coef, quant, 5, col);
+	v[6] = V_DEQUANT(coef, quant, 6, col);
+	v[7] = V_DEQUANT(coef, quant, 7, col);
+}
+
+/*
+ * The 8x8 transforms run pass 1 on columns 0-3 (l) and 4-7 (r), then
+ * pass 2 on rows 0-3 (t) and 4-7 (b): l[k] and r[k] hold row k of the
+ * work array, t[k] and b[k] column k, four rows in the lanes.
+ */
+static __inline void v_rows(vint32 *l, vint32 *r, vint32 *t, vint32 *b)
+{
+	v_transpose(&l[0], &l[1], &l[2], &l[3]);
+	v_transpose(&r[0], &r[1], &r[2], &r[3]);
+	v_transpose(&l[4], &l[5], &l[6], &l[7]);
+	v_transpose(&r[4], &r[5], &r[6], &r[7]);
+
+	t[0] = l[0]; t[1] = l[1]; t[2] = l[2]; t[3] = l[3];
+	t[4] = r[0]; t[5] = r[1]; t[6] = r[2]; t[7] = r[3];
+	b[0] = l[4]; b[1] = l[5]; b[2] = l[6]; b[3] = l[7];
+	b[4] = r[4]; b[5] = r[5]; b[6] = r[6]; b[7] = r[7];
+}
+
+/* v[k] holds output column k of four rows, +128 and clipped to uint8 */
+static __inline void v_store_rows(uint8 *outptr, vint32 *v)
+{
+	vint32 bias = V_DUP(128);
+
+	v[0] = V_ADD(v[0], bias); v[1] = V_ADD(v[1], bias);
+	v[2] = V_ADD(v[2], bias); v[3] = V_ADD(v[3], bias);
+	v[4] = V_ADD(v[4], bias); v[5] = V_ADD(v[5], bias);
+	v[6] = V_ADD(v[6], bias); v[7] = V_ADD(v[7], bias);
+	v_transpose(&v[0], &v[1], &v[2], &v[3]);
+	v_transpose(&v[4], &v[5], &v[6], &v[7]);
+	v_store_u8x8(outptr, v[0], v[4]);
+	v_store_u8x8(outptr + DCTSIZE, v[1], v[5]);
+	v_store_u8x8(outptr + 2 * DCTSIZE, v[2], v[6]);
+	v_store_u8x8(outptr + 3 * DCTSIZE, v[3], v[7]);
+}
+
+#define LQ_CONST_BITS		8
+#define LQ_PASS1_BITS		2
+#define V_LQ_MULC(x, c)		V_DESCALE(V_MULC(x, c), LQ_CONST_BITS)
+
+/* 1-D pass of JPEG_SWIDCT_LOW_Quality, v[k] is input k and becomes output k */
+static __inline void v_idct8_lq(vint32 *v)
+{
+	vint32 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+	vint32 tmp10, tmp11, tmp12, tmp13;
+	vint32 z5, z10, z11, z12, z13;
+
+	tmp10 = V_ADD(v[0], v[4]);
+	tmp11 = V_SUB(v[0], v[4]);
+	tmp13 = V_ADD(v[2], v[6]);
+	tmp12 = V_SUB(V_LQ_MULC(V_SUB(v[2], v[6]), 362), tmp13);
+
+	tmp0 = V_ADD(tmp10, tmp13);
+	tmp3 = V_SUB(tmp10, tmp13);
+	tmp1 = V_ADD(tmp11, tmp12);
+	tmp2 = V_SUB(tmp11, tmp12);
+
+	z13 = V_ADD(v[5], v[3]);
+	z10 = V_SUB(v[5], v[3]);
+	z11 = V_ADD(v[1], v[7]);
+	z12 = V_SUB(v[1], v[7]);
+
+	tmp7 = V_ADD(z11, z13);
+	tmp11 = V_LQ_MULC(V_SUB(z11, z13), 362);
+	z5 = V_LQ_MULC(V_ADD(z10, z12), 473);
+	tmp10 = V_SUB(V_LQ_MULC(z12, 277), z5);
+	tmp12 = V_ADD(V_LQ_MULC(z10, -669), z5);
+
+	tmp6 = V_SUB(tmp12, tmp7);
+	tmp5 = V_SUB(tmp11, tmp6);
+	tmp4 = V_ADD(tmp10, tmp5);
+
+	v[0] = V_ADD(tmp0, tmp7);
+	v[7] = V_SUB(tmp0, tmp7);
+	v[1] = V_ADD(tmp1, tmp6);
+	v[6] = V_SUB(tmp1, tmp6);
+	v[2] = V_ADD(tmp2, tmp5);
+	v[5] = V_SUB(tmp2, tmp5);
+	v[4] = V_ADD(tmp3, tmp4);
+	v[3] = V_SUB(tmp3, tmp4);
+}
+
+void JPEG_SWIDCT_LOW_Quality_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr)
+{
+	vint32 l[DCTSIZE], r[DCTSIZE], t[DCTSIZE], b[DCTSIZE];
+
+	/* Pass 1: columns */
+	v_dequant8(l, coef_block, quantptr, 0);
+	v_dequant8(r, coef_block, quantptr, 4);
+	v_idct8_lq(l);
+	v_idct8_lq(r);
+
+	/* Pass 2: rows */
+	v_rows(l, r, t, b);
+	v_idct8_lq(t);
+	v_idct8_lq(b);
+	V_DESCALE8(t, LQ_PASS1_BITS + 3);
+	V_DESCALE8(b, LQ_PASS1_BITS + 3);
+	v_store_rows(output_buf, t);
+	v_store_rows(output_buf + 4 * DCTSIZE, b);
+}
+
+#define HQ_CONST_BITS		13
+#define HQ_PASS1_BITS		2
+
+/* 1-D pass of JPEG_SWIDCT_High_Quality before the descale */
+static __inline void v_idct8_hq(vint32 *v)
+{
+	vint32 tmp0, tmp1, tmp2, tmp3;
+	vint32 tmp10, tmp11, tmp12, tmp13;
+	vint32 z1, z2, z3, z4, z5;
+
+	z1 = V_MULC(V_ADD(v[2], v[6]), 4433);
+	tmp2 = V_ADD(z1, V_MULC(v[6], -15137));
+	tmp3 = V_ADD(z1, V_MULC(v[2], 6270));
+
+	tmp0 = V_SHL(V_ADD(v[0], v[4]), HQ_CONST_BITS);
+	tmp1 = V_SHL(V_SUB(v[0], v[4]), HQ_CONST_BITS);
+
+	tmp10 = V_ADD(tmp0, tmp3);
+	tmp13 = V_SUB(tmp0, tmp3);
+	tmp11 = V_ADD(tmp1, tmp2);
+	tmp12 = V_SUB(tmp1, tmp2);
+
+	tmp0 = v[7];
+	tmp1 = v[5];
+	tmp2 = v[3];
+	tmp3 = v[1];
+
+	z1 = V_ADD(tmp0, tmp3);
+	z2 = V_ADD(tmp1, tmp2);
+	z3 = V_ADD(tmp0, tmp2);
+	z4 = V_ADD(tmp1, tmp3);
+	z5 = V_MULC(V_ADD(z3, z4), 9633);
+
+	tmp0 = V_MULC(tmp0, 2446);
+	tmp1 = V_MULC(tmp1, 16819);
+	tmp2 = V_MULC(tmp2, 25172);
+	tmp3 = V_MULC(tmp3, 12299);
+	z1 = V_MULC(z1, -7373);
+	z2 = V_MULC(z2, -20995);
+	z3 = V_ADD(V_MULC(z3, -16069), z5);
+	z4 = V_ADD(V_MULC(z4, -3196), z5);
+
+	tmp0 = V_ADD(tmp0, V_ADD(z1, z3));
+	tmp1 = V_ADD(tmp1, V_ADD(z2, z4));
+	tmp2 = V_ADD(tmp2, V_ADD(z2, z3));
+	tmp3 = V_ADD(tmp3, V_ADD(z1, z4));
+
+	v[0] = V_ADD(tmp10, tmp3);
+	v[7] = V_SUB(tmp10, tmp3);
+	v[1] = V_ADD(tmp11, tmp2);
+	v[6] = V_SUB(tmp11, tmp2);
+	v[2] = V_ADD(tmp12, tmp1);
+	v[5] = V_SUB(tmp12, tmp1);
+	v[3] = V_ADD(tmp13, tmp0);
+	v[4] = V_SUB(tmp13, tmp0);
+}
+
+void JPEG_SWIDCT_High_Quality_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr)
+{
+	vint32 l[DCTSIZE], r[DCTSIZE], t[DCTSIZE], b[DCTSIZE];
+
+	v_dequant8(l, coef_block, quantptr, 0);
+	v_dequant8(r, coef_block, quantptr, 4);
+	v_idct8_hq(l);
+	v_idct8_hq(r);
+	V_DESCALE8(l, HQ_CONST_BITS - HQ_PASS1_BITS);
+	V_DESCALE8(r, HQ_CONST_BITS - HQ_PASS1_BITS);
+
+	v_rows(l, r, t, b);
+	v_idct8_hq(t);
+	v_idct8_hq(b);
+	V_DESCALE8(t, HQ_CONST_BITS + HQ_PASS1_BITS + 3);
+	V_DESCALE8(b, HQ_CONST_BITS + HQ_PASS1_BITS + 3);
+	v_store_rows(output_buf, t);
+	v_store_rows(output_buf + 4 * DCTSIZE, b);
+}
+
+#define CONST_BITS			13
+#define PASS1_BITS			2
+#define DESCALE(x, n)		((int32)(((x) + (1 << ((n) - 1))) >> (n)))
+
+/* 1-D pass of JPEG_SWIDCT_4X4 before the descale, input 4 is not used */
+static __inline void v_idct4(const vint32 *v, vint32 *out)
+{
+	vint32 tmp0, tmp2, tmp10, tmp12;
+
+	tmp0 = V_SHL(v[0], CONST_BITS + 1);
+	tmp2 = V_ADD(V_MULC(v[2], 15137), V_MULC(v[6], -6270));
+
+	tmp10 = V_ADD(tmp0, tmp2);
+	tmp12 = V_SUB(tmp0, tmp2);
+
+	tmp0 = V_ADD(V_ADD(V_ADD(V_MULC(v[7], -1730), V_MULC(v[5], 11893)),
+		V_MULC(v[3], -17799)), V_MULC(v[1], 8697));
+	tmp2 = V_ADD(V_ADD(V_ADD(V_MULC(v[7], -4176), V_MULC(v[5], -4926)),
+		V_MULC(v[3], 7373)), V_MULC(v[1], 20995));
+
+	out[0] = V_ADD(tmp10, tmp2);
+	out[3] = V_SUB(tmp10, tmp2);
+	out[1] = V_ADD(tmp12, tmp0);
+	out[2] = V_SUB(tmp12, tmp0);
+}
+
+void JPEG_SWIDCT_4X4_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr)
+{
+	vint32 l[DCTSIZE], r[DCTSIZE], v[DCTSIZE];
+	vint32 bias = V_DUP(128);
+
+	/* Pass 1: columns 0-3 and 4-7, 4 rows out in v[0-3] and v[4-7] */
+	v_dequant8(l, coef_block, quantptr, 0);
+	v_dequant8(r, coef_block, quantptr, 4);
+	v_idct4(l, &v[0]);
+	v_idct4(r, &v[4]);
+	V_DESCALE8(v, CONST_BITS - PASS1_BITS + 1);
+
+	/* Pass 2: the 4 rows at once, l[k] is column k */
+	v_transpose(&v[0], &v[1], &v[2], &v[3]);
+	v_transpose(&v[4], &v[5], &v[6], &v[7]);
+	v_idct4(v, l);
+
+	l[0] = V_ADD(V_DESCALE(l[0], CONST_BITS + PASS1_BITS + 3 + 1), bias);
+	l[1] = V_ADD(V_DESCALE(l[1], CONST_BITS + PASS1_BITS + 3 + 1), bias);
+	l[2] = V_ADD(V_DESCALE(l[2], CONST_BITS + PASS1_BITS + 3 + 1), bias);
+	l[3] = V_ADD(V_DESCALE(l[3], CONST_BITS + PASS1_BITS + 3 + 1), bias);
+	v_transpose(&l[0], &l[1], &l[2], &l[3]);
+	v_store_u8x8(output_buf, l[0], l[1]);
+	v_store_u8x8(output_buf + 8, l[2], l[3]);
+}
+
+void JPEG_SWIDCT_2X2_SIMD(int16 *coef_block, uint8 *output_buf, const int32 *quantptr)
+{
+	int32 ws[2][DCTSIZE];
+	vint32 tmp0, tmp10;
+	int32 h, ctr, t0, t10, val;
+	int32 *wsptr;
+
+	/* Pass 1: columns, 2 rows out */
+	for(h = 0; h < 2; h++)
+	{
+		tmp10 = V_SHL(V_DEQUANT(coef_block, quantptr, 0, h * 4), CONST_BITS + 2);
+		tmp0 = V_MULC(V_DEQUANT(coef_block, quantptr, 7, h * 4), -5906);
+		tmp0 = V_ADD(tmp0, V_MULC(V_DEQUANT(coef_block, quantptr, 5, h * 4), 6967));
+		tmp0 = V_ADD(tmp0, V_MULC(V_DEQUANT(coef_block, quantptr, 3, h * 4), -10426));
+		tmp0 = V_ADD(tmp0, V_MULC(V_DEQUANT(coef_block, quantptr, 1, h * 4), 29692));
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+		vst1q_s32(&ws[0][h * 4], V_DESCALE(V_ADD(tmp10, tmp0), CONST_BITS - PASS1_BITS + 2));
+		vst1q_s32(&ws[1][h * 4], V_DESCALE(V_SUB(tmp10, tmp0), CONST_BITS - PASS1_BITS + 2));
+#else
+		_mm_storeu_si128((__m128i *)&ws[0][h * 4], V_DESCALE(V_ADD(tmp10, tmp0), CONST_BITS - PASS1_BITS + 2));
+		_mm_storeu_si128((__m128i *)&ws[1][h * 4], V_DESCALE(V_SUB(tmp10, tmp0), CONST_BITS - PASS1_BITS + 2));
+#endif
+	}
+
+	/* Pass 2: two rows of four products, not worth the vectors */
+	for(ctr = 0; ctr < 2; ctr++)
+	{
+		wsptr = ws[ctr];
+		t10 = wsptr[0] << (CONST_BITS + 2);
+		t0 = wsptr[7] * -5906 + wsptr[5] * 6967 + wsptr[3] * -10426 + wsptr[1] * 29692;
+
+		val = DESCALE(t10 + t0, CONST_BITS + PASS1_BITS + 3 + 2) + 128;
+		output_buf[ctr * 2] = (uint8)(val < 0 ? 0 : (val > 255 ? 255 : val));
+		val = DESCALE(t10 - t0, CONST_BITS + PASS1_BITS + 3 + 2) + 128;
+		output_buf[ctr * 2 + 1] = (uint8)(val < 0 ? 0 : (val > 255 ? 255 : val));
+	}
+}
+
+#endif //JPEG_SWIDCT_SIMD
+/**---------------------------------------------------------------------------*
+**                         Compiler Flag                                      *
+**---------------------------------------------------------------------------*/
+#ifdef   __cplusplus
+    }
+#endif
+/**---------------------------------------------------------------------------*/
+// End
@@ -102,6 +102,10 @@ JPEG_RET_E get_huff_table(uint8 *pBitstrm)
 	return JPEG_SUCCESS;
 }
 
+#define HUFF_EXTEND(x, s)	((x) < (1 << ((s)-1)) ? \
+	(x) + (-1 << (s)) + 1 : \
+(x))
+
 void build_vld_table(d_derived_tbl *tbl, int32 is_dc, int32 tbl_no)
 {
 	uint16 p = 0, i = 0, l = 0, lastp = 0, si = 0;
@@ -109,6 +113,7 @@ void build_vld_table(d_derived_tbl *tbl, int32 is_dc, int32 tbl_no)
 	int16 symbol_num = 0;
 	uint16 look_bits;
 	int16 ctr;
+	int32 sym, size, coef, look;
 	uint8 *huffsize = (uint8 *)JpegDec_ExtraMemAlloc(sizeof(uint8) * (AC_SYMBOL_NUM+1));
 	uint16 *huffcode = (uint16 *)JpegDec_ExtraMemAlloc(sizeof(uint16) * (AC_SYMBOL_NUM+1));
 	JPEG_CODEC_T *jpeg_fw_codec = Get_JPEGDecCodec();
@@ -176,18 +181,35 @@ void build_vld_table(d_derived_tbl *tbl, int32 is_dc, int32 tbl_no)
 	}
 
 	
+	SCI_MEMSET(tbl->look_up, 0, sizeof(tbl->look_up));
+
 	p = 0;
-	for(l = 1; l <= HUFF_FIRST_READ; l++)
+	for(l = 1; l <= HUFF_LOOKAHEAD; l++)
 	{
 		for(i = 1; i <= (int32)pub->bits[l]; i++, p++)
 		{
 			/* l = current code's length, p = its index in huffcode[] & huffval[]. */
 			/* Generate left-justified code followed by all possible bit sequences */
-			look_bits = (huffcode[p] <<(HUFF_FIRST_READ-l));
-			for(ctr = 1<<(HUFF_FIRST_READ-l); ctr > 0; ctr--)
+			sym = pub->huffval[p];
+			/* DC symbols are sizes, AC ones run and size, 0 for EOB runs and ZRL */
+			size = is_dc ? sym : (sym & 15);
+			look_bits = (huffcode[p] <<(HUFF_LOOKAHEAD-l));
+			for(ctr = 1<<(HUFF_LOOKAHEAD-l); ctr > 0; ctr--)
 			{
-				tbl->look_nbits[look_bits] = l;
-				tbl->look_sym[look_bits] = pub->huffval[p];
+				look = (sym << 8) | l;
+
+				if((is_dc || size) && (l + size <= HUFF_LOOKAHEAD))
+				{
+					coef = 0;
+					if(size)
+					{
+						coef = (look_bits >> (HUFF_LOOKAHEAD - l - size)) & ((1 << size) - 1);
+						coef = HUFF_EXTEND(coef, size);
+					}
+					look |= ((l + size) << 4) | (int32)((uint32)coef << 16);
+				}
+
+				tbl->look_up[look_bits] = look;
 				look_bits++;
 			}
 		}
@@ -199,10 +221,6 @@ void build_vld_table(d_derived_tbl *tbl, int32 is_dc, int32 tbl_no)
 	return;
 }
 
-#define HUFF_EXTEND(x, s)	((x) < (1 << ((s)-1)) ? \
-	(x) + (-1 << (s)) + 1 : \
-(x))
-
 /*lint --e{737}*/
 BOOLEAN decode_mcu_DC_first(int16 **MCU_data)
 {
@@ -216,6 +234,7 @@ BOOLEAN decode_mcu_DC_first(int16 **MCU_data)
 	phuff_entropy_info *entropy = &(progressive_info->buf_storage[curr_scan].entropy);
 	jpeg_component_info *compptr;
 	d_derived_tbl *tbl;
+	int32 look;
 	
 	/* Process restart marker if needed; may have to suspend */
 	if((jpeg_fw_codec->restart_interval) && (jpeg_fw_codec->restart_interval != 0x3FFFF))
@@ -229,7 +248,7 @@ BOOLEAN decode_mcu_DC_first(int16 **MCU_data)
 
 			entropy->next_restart_num += 1;
 			entropy->next_restart_num &= 0x07;
-			entropy->restarts_to_go = (uint8)jpeg_fw_codec->restart_interval;
+			entropy->restarts_to_go = (uint16)jpeg_fw_codec->restart_interval;
 			entropy->last_dc_value[0] = 0;
 			entropy->last_dc_value[1] = 0;
 			entropy->last_dc_value[2] = 0;
@@ -249,13 +268,22 @@ BOOLEAN decode_mcu_DC_first(int16 **MCU_data)
 
 		/* Decode a single block's worth of coefficients */
 		/* Section F.2.2.1: decode the DC coefficient difference */
-		HUFF_DECODE(s, tbl, label1);
+		HUFF_PEEK(look, tbl);
 
-		if(s)
+		if(HUFF_LOOK_COEF_NBITS(look))
 		{
-			CHECK_BIT_BUFFER((uint32)s);
-			r = JPEG_GETBITS(s);
-			s = HUFF_EXTEND(r, s);
+			DROP_BITS(HUFF_LOOK_COEF_NBITS(look));
+			s = HUFF_LOOK_COEF(look);
+		}else
+		{
+			HUFF_DECODE_LOOK(s, look, tbl);
+
+			if(s)
+			{
+				CHECK_BIT_BUFFER((uint32)s);
+				r = JPEG_GETBITS(s);
+				s = HUFF_EXTEND(r, s);
+			}
 		}
 
 		/* Convert DC difference to actual value, update last_dc_val */
@@ -289,6 +317,7 @@ BOOLEAN decode_mcu_AC_first (int16 **MCU_data)
 	int16 *block;
 	phuff_entropy_info *entropy = &(progressive_info->buf_storage[curr_scan].entropy);
 	d_derived_tbl *tbl;
+	int32 look;
 
 	/* Process restart marker if needed; may have to suspend */
 	/* Process restart marker if needed; may have to suspend */
@@ -302,7 +331,7 @@ BOOLEAN decode_mcu_AC_first (int16 **MCU_data)
 			}
 			entropy->next_restart_num += 1;
 			entropy->next_restart_num &= 0x07;
-			entropy->restarts_to_go = (uint8)jpeg_fw_codec->restart_interval;
+			entropy->restarts_to_go = (uint16)jpeg_fw_codec->restart_interval;
 			entropy->last_dc_value[0] = 0;
 			entropy->last_dc_value[1] = 0;
 			entropy->last_dc_value[2] = 0;
@@ -329,7 +358,18 @@ BOOLEAN decode_mcu_AC_first (int16 **MCU_data)
 
 		for(k = progressive_info->Ss; k <= Se; k++)
 		{
-			HUFF_DECODE(s, tbl, label1);
+			HUFF_PEEK(look, tbl);
+
+			if(HUFF_LOOK_COEF_NBITS(look))
+			{
+				/* code and coefficient in one go */
+				DROP_BITS(HUFF_LOOK_COEF_NBITS(look));
+				k += HUFF_LOOK_SYM(look) >> 4;
+				block[jpeg_fw_zigzag_order[k]] = (int16)(HUFF_LOOK_COEF(look)<<Al);
+				continue;
+			}
+
+			HUFF_DECODE_LOOK(s, look, tbl);
 			r = s >> 4;
 			s &= 15;
 			if(s)
@@ -400,7 +440,7 @@ BOOLEAN decode_mcu_DC_refine (int16 **MCU_data)
 
 			entropy->next_restart_num += 1;
 			entropy->next_restart_num &= 0x07;
-			entropy->restarts_to_go = (uint8)jpeg_fw_codec->restart_interval;
+			entropy->restarts_to_go = (uint16)jpeg_fw_codec->restart_interval;
 			entropy->last_dc_value[0] = 0;
 			entropy->last_dc_value[1] = 0;
 			entropy->last_dc_value[2] = 0;
@@ -447,6 +487,7 @@ BOOLEAN decode_mcu_AC_refine (int16 **MCU_data)
 	phuff_entropy_info *entropy = &(progressive_info->buf_storage[curr_scan].entropy);
 	d_derived_tbl *tbl;
 	int16 *thiscoef;
+	int32 look;
 	int32 num_newnz = 0;
 	int32 newnz_pos[JPEG_FW_DCTSIZE2] = {0};
 	
@@ -462,7 +503,7 @@ BOOLEAN decode_mcu_AC_refine (int16 **MCU_data)
 
 			entropy->next_restart_num += 1;
 			entropy->next_restart_num &= 0x07;
-			entropy->restarts_to_go = (uint8)jpeg_fw_codec->restart_interval;
+			entropy->restarts_to_go = (uint16)jpeg_fw_codec->restart_interval;
 			entropy->last_dc_value[0] = 0;
 			entropy->last_dc_value[1] = 0;
 			entropy->last_dc_value[2] = 0;
@@ -493,39 +534,50 @@ BOOLEAN decode_mcu_AC_refine (int16 **MCU_data)
 	{
 		for(; k <= Se; k++)
 		{
-			HUFF_DECODE(s, tbl, label1);
-			r = s>>4;
-			s &= 15;
-			if(s)
+			HUFF_PEEK(look, tbl);
+
+			if(HUFF_LOOK_COEF_NBITS(look) && (1 == (HUFF_LOOK_SYM(look) & 15)))
 			{
-				if(s != 1)/* size of new coef should always be 1 */
-				{
-					JPEG_TRACE("JWRN_HUFF_BAD_CODE!\n");
-				}
-				CHECK_BIT_BUFFER(1);
-				if(JPEG_GETBITS(1))
-				{
-					s = p1;/* newly nonzero coef is positive */
-				}else
-				{
-					s = m1;/* newly nonzero coef is negative */
-				}
+				/* code and sign bit in one go */
+				DROP_BITS(HUFF_LOOK_COEF_NBITS(look));
+				r = HUFF_LOOK_SYM(look) >> 4;
+				s = (HUFF_LOOK_COEF(look) > 0) ? p1 : m1;
 			}else
 			{
-				if(r != 15)
+				HUFF_DECODE_LOOK(s, look, tbl);
+				r = s>>4;
+				s &= 15;
+				if(s)
 				{
-					EOBRUN = 1 <<r;/* EOBr, run length is 2^r + appended bits */
-					if(r)
+					if(s != 1)/* size of new coef should always be 1 */
 					{
-						CHECK_BIT_BUFFER((uint32)r);
-						r = JPEG_GETBITS(r);
-						EOBRUN += r;
+						JPEG_TRACE("JWRN_HUFF_BAD_CODE!\n");
+					}
+					CHECK_BIT_BUFFER(1);
+					if(JPEG_GETBITS(1))
+					{
+						s = p1;/* newly nonzero coef is positive */
+					}else
+					{
+						s = m1;/* newly nonzero coef is negative */
 					}
+				}else
+				{
+					if(r != 15)
+					{
+						EOBRUN = 1 <<r;/* EOBr, run length is 2^r + appended bits */
+						if(r)
+						{
+							CHECK_BIT_BUFFER((uint32)r);
+							r = JPEG_GETBITS(r);
+							EOBRUN += r;
+						}
 
-					break;/* rest of block is handled by EOB logic */
-					
+						break;/* rest of block is handled by EOB logic */
+						
+					}
+					/* note s = 0 for processing ZRL */
 				}
-				/* note s = 0 for processing ZRL */
 			}
 
 			/* Advance over already-nonzero coefs and r still-zero coefs,
@@ -620,8 +672,34 @@ BOOLEAN decode_mcu_AC_refine (int16 **MCU_data)
 	return TRUE;
 }
 
+/* a derived table is 4K of lookahead, only the ones a scan uses are taken */
+LOCAL JPEG_RET_E alloc_vld_table(d_derived_tbl **tbl_ptr)
+{
+	d_derived_tbl *tbl;
+
+	if(*tbl_ptr != NULL)
+	{
+		return JPEG_SUCCESS;
+	}
+
+	tbl = (d_derived_tbl*)JpegDec_ExtraMemAlloc(sizeof(d_derived_tbl));
+	if(tbl == NULL)
+	{
+		return JPEG_FAILED;
+	}
+
+	tbl->pub = (HUFF_TBL_T *)JpegDec_ExtraMemAlloc(sizeof(HUFF_TBL_T));
+	tbl->pub->bits = (uint8*)JpegDec_ExtraMemAlloc(17);
+	tbl->pub->huffval = (uint8*)JpegDec_ExtraMemAlloc(257);
+
+	*tbl_ptr = tbl;
+
+	return JPEG_SUCCESS;
+}
+
 uint32 init_scan_entropy_info(phuff_entropy_info *p_entropy_info)
 {
+	JPEG_CODEC_T *jpeg_fw_codec = Get_JPEGDecCodec();
 	JPEG_PROGRESSIVE_INFO_T *progressive_info = JPEGFW_GetProgInfo();
 	phuff_entropy_info *entropy = p_entropy_info;
 	int32 curr_scan_num = progressive_info->cur_scan;
@@ -631,21 +709,16 @@ uint32 init_scan_entropy_info(phuff_entropy_info *p_entropy_info)
 	int32 Ss, Se, Al, Ah, comps_in_scan;
 	int i;
 	
-	/* Mark derived tables unallocated */
+	/* Mark derived tables unallocated, the ones of the scan are below */
 	for (i = 0; i < NUM_HUFF_TBLS; i++) 
 	{
-		entropy->vld_table[i] = (d_derived_tbl*)JpegDec_ExtraMemAlloc(sizeof(d_derived_tbl));
-		if(entropy->vld_table[i] == NULL)
-		{
-			return JPEG_FAILED;
-		}	
-		
-		entropy->vld_table[i]->pub = (HUFF_TBL_T *)JpegDec_ExtraMemAlloc(sizeof(HUFF_TBL_T));
-
-		entropy->vld_table[i]->pub->bits = (uint8*)JpegDec_ExtraMemAlloc(17);
-		entropy->vld_table[i]->pub->huffval = (uint8*)JpegDec_ExtraMemAlloc(257);
+		entropy->vld_table[i] = NULL;
 	}
 
+	entropy->restarts_to_go = (uint16)jpeg_fw_codec->restart_interval;
+	entropy->next_restart_num = 0;
+	entropy->EOBRUN = 0;
+
 	//
 	Ss = progressive_info->buf_storage[curr_scan_num].Ss;
 	Se = progressive_info->buf_storage[curr_scan_num].Se;
@@ -741,11 +814,19 @@ uint32 init_scan_entropy_info(phuff_entropy_info *p_entropy_info)
 			if(Ah == 0)
 			{
 				tbl_no = compptr->dc_tbl_no;
+				if(alloc_vld_table(&entropy->vld_table[tbl_no]) != JPEG_SUCCESS)
+				{
+					return JPEG_FAILED;
+				}
 				build_vld_table(entropy->vld_table[tbl_no], TRUE, tbl_no);
 			}
 		}else
 		{
 			tbl_no = compptr->ac_tbl_no;
+			if(alloc_vld_table(&entropy->vld_table[tbl_no]) != JPEG_SUCCESS)
+			{
+				return JPEG_FAILED;
+			}
 			build_vld_table(entropy->vld_table[tbl_no], FALSE, tbl_no);
 			/* remember the single active table */
 			entropy->ac_derived_tbl = entropy->vld_table[tbl_no];
@@ -767,7 +848,7 @@ void init_scan_bitstrm_info(bitstream_info *address, uint8 *buf_addr, uint32 buf
 	address->src_buf_len = buf_len;
 	address->bytes_in_buf = buf_len;
 	address->jstream_words = 0;
-	address->jremain_bit_num = s_jremain_bit_num;
+	address->jremain_bit_num = 0;
 	address->read_write_bytes = buf_len;
 }
 
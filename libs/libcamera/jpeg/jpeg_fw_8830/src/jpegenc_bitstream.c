@@ -27,28 +27,80 @@
 #if defined(JPEG_ENC)
 //////////////////////////////////////////////////////////////////////////
 
-//used in JPEG encode.
-#if _CMODEL_
-LOCAL void JPEGFW_PutBits(uint32 val, uint32 nbits)
+/*
+* Bits put by the firmware that are not in the BSM yet, msb first. They are
+* written a word at a time, one poll and one write instead of a poll and
+* two writes per byte. The BSM stuffs the data, not the firmware.
+*/
+LOCAL uint64 s_put_bits = 0;
+LOCAL uint32 s_put_nbits = 0;
+/*last BSM_CFG2 written by the writer, 0 when the register is unknown*/
+LOCAL uint32 s_put_cfg2 = 0;
+
+LOCAL void JPEGFW_WriteBsm(uint32 val, uint32 nbits)
 {
-#if _CMODEL_
-	write_nbits(val, nbits, 0);
-#endif //_CMODEL_
+	uint32 cfg2 = nbits << 24;
 
 	JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
 
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (nbits << 24) , "BSM_CFG2: configure write n bits");
+	if (cfg2 != s_put_cfg2)
+	{
+		JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, cfg2, "BSM_CFG2: configure write n bits");
+		s_put_cfg2 = cfg2;
+	}
 	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, val, "BSM_WDATA: write val(n bits) to bitstream, auto-stuffing");
 }
-#else
-__inline void JPEGFW_PutBits(uint32 val, uint32 nbits)
+
+/*****************************************************************************
+**	Name : 			JPEGFW_InitBits
+**	Description:	Drop the bits of an encoder that did not finish its header
+**	Author:
+**	Note:
+*****************************************************************************/
+PUBLIC void JPEGFW_InitBits(void)
 {
-	//VSP_READ_REG_POLL(VSP_BSM_REG_BASE+BSM_DEBUG_OFF, V_BIT_3, 0, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
-    JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (nbits << 24) , "BSM_CFG2: configure write n bits");
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, val, "BSM_WDATA: write val(n bits) to bitstream, auto-stuffing");
+	s_put_bits = 0;
+	s_put_nbits = 0;
+	s_put_cfg2 = 0;
 }
+
+/*****************************************************************************
+**	Name : 			JPEGFW_FlushBits
+**	Description:	Write the bits left to the BSM
+**	Author:
+**	Note:			Shall be called before the hardware or any other code
+**					writes to the BSM.
+*****************************************************************************/
+PUBLIC void JPEGFW_FlushBits(void)
+{
+	if (s_put_nbits)
+	{
+		JPEGFW_WriteBsm((uint32)s_put_bits & ((1U << s_put_nbits) - 1), s_put_nbits);
+	}
+
+	s_put_bits = 0;
+	s_put_nbits = 0;
+	/*BSM_CFG2 is also written by the tail and the fifo flush*/
+	s_put_cfg2 = 0;
+}
+
+//used in JPEG encode.
+PUBLIC void JPEGFW_PutBits(uint32 val, uint32 nbits)
+{
+#if _CMODEL_
+	write_nbits(val, nbits, 0);
 #endif //_CMODEL_
+
+	s_put_bits = (s_put_bits << nbits) | (val & (uint32)(((uint64)1 << nbits) - 1));
+	s_put_nbits += nbits;
+
+	if (s_put_nbits >= 32)
+	{
+		s_put_nbits -= 32;
+		JPEGFW_WriteBsm((uint32)(s_put_bits >> s_put_nbits), 32);
+	}
+}
+
 /*****************************************************************************
 **	Name : 			JPEG_PutC
 **	Description:	Output CHAR
@@ -57,14 +109,7 @@ __inline void JPEGFW_PutBits(uint32 val, uint32 nbits)
 *****************************************************************************/
 PUBLIC void JPEGFW_PutC(uint8 ch)
 {
-#if _CMODEL_
-	write_nbits(ch, 8, 0);
-#endif //_CMODEL_
-
-	JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
-
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (8<<24), "BSM_CFG2: configure 8 bit for writing");
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, ch, "BSM_WDATA: configure the value to be written to bitstream");
+	JPEGFW_PutBits(ch, 8);
 }
 
 /*****************************************************************************
@@ -75,14 +120,7 @@ PUBLIC void JPEGFW_PutC(uint8 ch)
 *****************************************************************************/
 PUBLIC void JPEGFW_PutW(uint16 w)
 {
-#if _CMODEL_
-	write_nbits(w, 16, 0);
-#endif //_CMODEL_
-
-	JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "BSM_READY: polling bsm rfifo ready");
-
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (16<<24), "BSM_CFG2: configure 16 bit for writing");
-	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, w, "BSM_WDATA: configure the value to be written to bitstream");
+	JPEGFW_PutBits(w, 16);
 }
 PUBLIC void JPEGFW_PutW_II(uint16 w)
 {
@@ -95,6 +133,25 @@ PUBLIC void JPEGFW_PutBits32_II(uint32 val, uint32 nbits)
 	JPEGFW_PutBits(tmp, 32);
 }
 
+/*****************************************************************************
+**	Name : 			JPEGFW_PutBytes
+**	Description:	Output a byte array, a word at a time
+**	Author:
+**	Note:
+*****************************************************************************/
+PUBLIC void JPEGFW_PutBytes(const uint8 *buf, uint32 len)
+{
+	for (; len >= 4; len -= 4, buf += 4)
+	{
+		JPEGFW_PutBits(((uint32)buf[0] << 24) | ((uint32)buf[1] << 16) | ((uint32)buf[2] << 8) | buf[3], 32);
+	}
+
+	for (; len > 0; len--)
+	{
+		JPEGFW_PutBits(*buf++, 8);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 #endif //JPEG_ENC
 /**---------------------------------------------------------------------------*
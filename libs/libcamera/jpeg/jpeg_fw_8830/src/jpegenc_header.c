@@ -53,6 +53,7 @@ PUBLIC void OutPutRstMarker(void)
 	}
 	JPEGFW_PutC(0xFF);
 	JPEGFW_PutC(jpeg_fw_codec->RST_Count++);
+	JPEGFW_FlushBits();
 }
 
 PUBLIC JPEG_RET_E PutAPP0(void)
@@ -134,6 +135,9 @@ PUBLIC JPEG_RET_E JPEG_HWWriteHeadForThumbnail(void)
 	{
 		return JPEG_FAILED;
 	}
+
+	/*the hardware writes the entropy coded data next*/
+	JPEGFW_FlushBits();
 	
 	return JPEG_SUCCESS;
 }
@@ -145,25 +149,13 @@ PUBLIC JPEG_RET_E JPEG_HWWriteTailForThumbnail(void){
 	
 	/*put SOI*/
 	PutMarker(M_EOI);
+	JPEGFW_FlushBits();
 	return JPEG_SUCCESS;
 }
 
 LOCAL void WriteThumbnailData(APP1_T *app1_t)
 {
-	uint32 *buf32 = NULL;
-	uint8 *buf8 = NULL;
-	uint32 i, j;
-	
-	buf32 = (uint32 *)app1_t->thumbnail_virt_addr;	
-	for(i = 0; i < (app1_t->thumbnail_len / 4); i++){
-		JPEGFW_PutBits32_II(*buf32++, 32);		
-	}
-	buf8 = (uint8*)buf32;
-	for(j = 0; j < (app1_t->thumbnail_len - i * 4); j++){
-		JPEGFW_PutC(*buf8++); 			 			
-	}
-	buf32 = NULL;
-	buf8 = NULL;
+	JPEGFW_PutBytes((const uint8 *)app1_t->thumbnail_virt_addr, app1_t->thumbnail_len);
 }
 
 #if 1
@@ -208,10 +200,7 @@ PUBLIC JPEG_RET_E PutAPP1(APP1_T *app1_t)
 	   	return ret;
 	}
 
-	for (i=0; i<app1_size; i++)
-	{
-		JPEGFW_PutC(*app1_buf_ptr++);
-	}
+	JPEGFW_PutBytes(app1_buf_ptr, app1_size);
 #endif
     SCI_TRACE_LOW("[PutAPP1]  Done, app1_size = %x \n", app1_size); 
 
@@ -710,22 +699,8 @@ PUBLIC JPEG_RET_E PutQuantTbl(void)
 		quant = jpeg_fw_codec->quant_tbl[i];
 		JPEG_ASSERT(quant!=0);
 
-		if(JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, V_BIT_0, V_BIT_0, TIME_OUT_CLK, "BSM,Polling the bsm rfifo can read/write"))
-		{
-			return JPEG_FAILED;
-		}
-
-		for (k=0; k<32; k++)
-		{
-			JPEGFW_PutC(quant[zigzag[k]]);
-		}
-
-		if(JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, V_BIT_0, V_BIT_0, TIME_OUT_CLK, "BSM,Polling the bsm rfifo can read/write"))
-		{
-			return JPEG_FAILED;
-		}
-		
-		for (k=32; k<64; k++)
+		/*the put functions poll the bsm once a word*/
+		for (k=0; k<64; k++)
 		{
 			JPEGFW_PutC(quant[zigzag[k]]);
 		}
@@ -736,9 +711,7 @@ PUBLIC JPEG_RET_E PutQuantTbl(void)
 
 LOCAL JPEG_RET_E PutOneHuffTbl(uint8 index, const uint8 *bits, const uint8 *huffval)
 {
-	uint16 count = 0, i = 0, j = 0, length = 0;
-	uint16 int_count = 0;
-	uint16 left_count = 0;
+	uint16 count = 0, i = 0, length = 0;
 	
 	JPEG_ASSERT(bits != 0);
 	JPEG_ASSERT(huffval != 0);
@@ -767,37 +740,8 @@ LOCAL JPEG_RET_E PutOneHuffTbl(uint8 index, const uint8 *bits, const uint8 *huff
 	PutMarker(M_DHT);			/*put marker*/
 	JPEGFW_PutW(length);			/*length*/
 	JPEGFW_PutC(index);			/*table id*/
-
-	for(i = 1; i <= 16; i++)		/*put bits*/
-	{
-		JPEGFW_PutC(bits[i]);
-	}
-	
-	int_count = count/32;
-	left_count = count%32;
-	
-	for(i = 0; (int_count--) > 0; )
-	{
-		if(JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, V_BIT_0, V_BIT_0, TIME_OUT_CLK, "BSM,Polling the bsm rfifo can read/write"))
-		{
-			return JPEG_FAILED;
-		}
-		
-		for(j = 0; j < 32; j++,i++)
-		{
-			JPEGFW_PutC(huffval[i]);
-		}		
-	}
-
-	if(JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, V_BIT_0, V_BIT_0, TIME_OUT_CLK, "BSM,Polling the bsm rfifo can read/write"))
-	{
-		return JPEG_FAILED;
-	}
-
-	for( ;(left_count--) > 0; i++)
-	{
-		JPEGFW_PutC(huffval[i]);
-	}
+	JPEGFW_PutBytes(bits + 1, 16);		/*put bits*/
+	JPEGFW_PutBytes(huffval, count);
 
 	return JPEG_SUCCESS;
 }
@@ -64,6 +64,7 @@ PUBLIC JPEG_RET_E JPEG_HWEncInit(JPEG_ENC_INPUT_PARA_T *input_para_ptr)
 	//initialize VSP hardware module
 	JpegEnc_HwTopRegCfg();
 	JpegEnc_HwSubModuleCfg();
+	JPEGFW_InitBits();
 	JPEGFW_InitHuffTblWithDefaultValue(jpeg_fw_codec);
 	configure_huff_tab(g_huff_tab_enc, 162);
 	JpegEnc_QTableCfg();
@@ -181,6 +182,9 @@ PUBLIC JPEG_RET_E JPEG_HWWriteHead(APP1_T *app1_t)
 	{
 		return JPEG_FAILED;
 	}
+
+	/*the hardware writes the entropy coded data next*/
+	JPEGFW_FlushBits();
 	
 	return JPEG_SUCCESS;
 }
@@ -23,6 +23,7 @@ extern "C"
 
 #include "cmr_common.h"
 #include "sprd_dma_copy_k.h"
+#include "cmr_sw_cvt.h"
 
 enum cmr_img_cvt_evt {
 	CMR_IMG_CVT_ROT_DONE = CMR_EVT_CVT_BASE,
@@ -35,21 +36,36 @@ enum cmr_img_cvt_ret {
 
 #define SCALER_IS_DONE          0xFF000000
 
+/* cleans and invalidates the cpu cache over the planes of img, the
+ * software path calls it on src before reading and on dst before done,
+ * as the hardware reads and writes these buffers by physical address */
+typedef void (*cmr_cvt_flush)(cmr_handle flush_handle, struct img_frm *img);
+
 struct cmr_rot_param{
 	cmr_handle              handle;
 	enum img_angle          angle;
 	struct img_frm          src_img;
 	struct img_frm          dst_img;
+	cmr_cvt_flush           flush;
+	cmr_handle              flush_handle;
 };
 
 cmr_int cmr_rot_open(cmr_handle *rot_handle);
 cmr_int cmr_rot(struct cmr_rot_param *rot_param);
 cmr_int cmr_rot_close(cmr_handle rot_handle);
+cmr_int cmr_rot_sw(struct cmr_rot_param *rot_param);
 cmr_int cmr_scale_open(cmr_handle *scale_handle);
 cmr_int cmr_scale_start(cmr_handle scale_handle, struct img_frm *src_img,
 			struct img_frm *dst_img, cmr_evt_cb cmr_event_cb, cmr_handle cb_handle);
 cmr_int cmr_scale_close(cmr_handle scale_handle);
 cmr_int cmr_scale_capability(cmr_handle scale_handle,cmr_u32 *width, cmr_u32 *sc_factor);
+cmr_int cmr_scale_set_flush(cmr_handle scale_handle, cmr_cvt_flush flush, cmr_handle flush_handle);
+/* crop src_img->rect, the whole frame when it is empty, and scale it to
+ * dst_img by the cpu on the virtual addresses, is_check only validates */
+cmr_int cmr_scale_sw(struct img_frm *src_img, struct img_frm *dst_img, cmr_uint is_check);
+cmr_int cmr_sw_img_frm(struct img_frm *img, struct cmr_sw_frame *frame);
+/* debug.camera.sw.cvt is 1, scale and rotate by software */
+cmr_uint cmr_sw_cvt_forced(void);
 int cmr_dma_copy_init(void);
 int cmr_dma_copy_deinit(void);
 int cmr_dma_cpy(struct _dma_copy_cfg_tag dma_copy_cfg);
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _CMR_FD_SCALE_H_
+#define _CMR_FD_SCALE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cmr_type.h"
+
+/* the detector runs at no more than this, frames are box filtered down to it */
+#define CMR_FD_WORK_SIZE                  (640 * 480)
+/* and at no less than this */
+#define CMR_FD_MIN_SIZE                   (320 * 240)
+#define CMR_FD_SCALE_MAX                  16
+/* percent of the time the detector may run */
+#define CMR_FD_PACE_DUTY                  50
+#define CMR_FD_PACE_MAX_GAP               1000000000LL
+
+struct cmr_fd_pace {
+	cmr_s64                         latency;
+	cmr_s64                         next_time;
+};
+
+/* integer factor from a w x h frame to the detector size, 1 for no scaling */
+cmr_u32 cmr_fd_scale_factor(cmr_u32 width, cmr_u32 height);
+
+void cmr_fd_scale_size(cmr_u32 width, cmr_u32 height, cmr_u32 factor,
+			cmr_u32 *out_width, cmr_u32 *out_height);
+
+/*
+ * Box filter a NV21 frame down by factor into a packed NV21 image of
+ * cmr_fd_scale_size(). Every source pixel is read once, straight from the
+ * preview buffer. line is scratch for width 16 bit sums.
+ */
+void cmr_fd_scale_nv21(const cmr_u8 *src_y, const cmr_u8 *src_uv,
+			cmr_u32 width, cmr_u32 height, cmr_u32 factor,
+			cmr_u8 *dst, cmr_u16 *line);
+
+/*
+ * Frame pacing from the measured detector time: after a detection that
+ * took t, the next frame is taken no sooner than t * (100 - duty) / duty
+ * later, t being averaged over the last detections.
+ */
+void cmr_fd_pace_init(struct cmr_fd_pace *pace);
+
+cmr_u32 cmr_fd_pace_ready(struct cmr_fd_pace *pace, cmr_s64 now);
+
+void cmr_fd_pace_done(struct cmr_fd_pace *pace, cmr_s64 start, cmr_s64 end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
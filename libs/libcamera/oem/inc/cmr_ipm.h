@@ -47,6 +47,8 @@ struct ipm_frame_out {
 };
 
 typedef cmr_int (*ipm_callback)(cmr_u32 class_type, struct ipm_frame_out *cb_parm);
+/*the class is done with the source frame of a transfer_frame*/
+typedef cmr_int (*ipm_frame_release)(cmr_u32 class_type, struct ipm_frame_in *in);
 
 struct ipm_init_in {
 	cmr_handle              oem_handle;
@@ -56,6 +58,7 @@ struct ipm_init_in {
 
 struct ipm_open_in {
 	ipm_callback            reg_cb;
+	ipm_frame_release       frame_release;
 	struct img_size         frame_size;
 	struct img_rect         frame_rect;
 	cmr_uint                frame_cnt;
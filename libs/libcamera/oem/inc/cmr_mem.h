@@ -55,6 +55,17 @@ int camera_arrange_capture_buf(struct cmr_cap_2_frm *cap_2_frm,
 						struct cmr_cap_mem *capture_mem,
 						uint32_t need_rot,
 						uint32_t image_cnt);
+
+/* the planned layout camera_arrange_capture_buf tries first, -1 if it does not fit */
+int arrange_planned_buf(struct cmr_cap_2_frm *cap_2_frm,
+				struct img_size *sn_size,
+				struct img_rect *sn_trim,
+				struct img_size *image_size,
+				uint32_t orig_fmt,
+				struct img_size *cap_size,
+				struct img_size *thum_size,
+				struct cmr_cap_mem *capture_mem,
+				uint32_t need_rot);
 #ifdef __cplusplus
 }
 #endif
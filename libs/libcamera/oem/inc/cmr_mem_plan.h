@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _CMR_MEM_PLAN_H_
+#define _CMR_MEM_PLAN_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cmr_type.h"
+
+#define CMR_MEM_PLAN_MAX                  16
+#define CMR_MEM_PLAN_ALIGN                256
+
+/*
+ * A buffer used from stage first to stage last, both included. Two
+ * buffers sharing a stage never overlap, the others may.
+ */
+struct cmr_mem_plan_buf {
+	cmr_u32                         size;
+	/* power of 2 */
+	cmr_u32                         align;
+	cmr_u32                         first;
+	cmr_u32                         last;
+	/* the offset is given by the caller, not planned */
+	cmr_u32                         fixed;
+	cmr_u32                         offset;
+};
+
+/* buffers of a capture laid out in the frame memory */
+enum cmr_cap_plan_buf {
+	/* raw, cap yuv and target yuv, overlapped on purpose for the streaming hardware */
+	CMR_CAP_PLAN_MAIN = 0,
+	/* target yuv uv plane when it is not in the main block */
+	CMR_CAP_PLAN_UV,
+	CMR_CAP_PLAN_JPEG,
+	CMR_CAP_PLAN_THUM_YUV,
+	CMR_CAP_PLAN_THUM_JPEG,
+	CMR_CAP_PLAN_ROT,
+	CMR_CAP_PLAN_NUM
+};
+
+struct cmr_cap_plan {
+	/* in, 0 for a buffer the capture does not need */
+	cmr_u32                         size[CMR_CAP_PLAN_NUM];
+	/* out, from the start of the frame memory */
+	cmr_u32                         offset[CMR_CAP_PLAN_NUM];
+	/* out, the buffers one after the other and the planned layout */
+	cmr_u32                         seq_size;
+	cmr_u32                         plan_size;
+};
+
+/*
+ * Fixed buffers keep their offset, the others go one by one, largest
+ * first, to the lowest aligned offset clear of every buffer placed so far
+ * whose stages meet theirs. Buffers of size 0 are left out.
+ */
+cmr_int cmr_mem_plan_layout(struct cmr_mem_plan_buf *buf, cmr_u32 num, cmr_u32 *out_size);
+
+/*
+ * Lay out the capture buffers, the main block at offset 0. Fails when the
+ * layout does not fit in mem_size.
+ */
+cmr_int cmr_mem_plan_capture(struct cmr_cap_plan *plan, cmr_u32 mem_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _CMR_SW_CVT_H_
+#define _CMR_SW_CVT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cmr_type.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__SSE2__)
+#define CMR_SW_CVT_SIMD                   1
+#else
+#define CMR_SW_CVT_SIMD                   0
+#endif
+
+/* frames of at least this many pixels are split across threads */
+#define CMR_SW_CVT_THREAD_PIXELS          (1280 * 720)
+#define CMR_SW_CVT_THREAD_MAX             4
+/* 90 and 270 walk the frame in tiles of this many pixels square */
+#define CMR_SW_CVT_TILE                   32
+
+enum cmr_sw_cvt_layout {
+	CMR_SW_CVT_SEMIPLANAR = 0,
+	CMR_SW_CVT_PLANAR,
+	CMR_SW_CVT_LAYOUT_MAX
+};
+
+/* same order as enum img_angle from IMG_ANGLE_90 on */
+enum cmr_sw_cvt_angle {
+	CMR_SW_CVT_ROT_90 = 0,
+	CMR_SW_CVT_ROT_270,
+	CMR_SW_CVT_ROT_180,
+	CMR_SW_CVT_MIRROR,
+	CMR_SW_CVT_ANGLE_MAX
+};
+
+/*
+ * A 4:2:0 frame. stride is by bytes of a y row, a chroma row is stride
+ * bytes for a semiplanar frame, whose interleaved plane is u, and
+ * stride / 2 for a planar one. Chroma bytes are taken in the order they
+ * are stored, as the scaler and rotator do, so NV12 and NV21 are the same
+ * layout.
+ */
+struct cmr_sw_frame {
+	cmr_u32                         layout;
+	cmr_u32                         width;
+	cmr_u32                         height;
+	cmr_u32                         stride;
+	cmr_u8                          *y;
+	cmr_u8                          *u;
+	cmr_u8                          *v;
+};
+
+struct cmr_sw_rect {
+	cmr_u32                         x;
+	cmr_u32                         y;
+	cmr_u32                         w;
+	cmr_u32                         h;
+};
+
+/*
+ * Crop rect of src and scale it to the size of dst, rect and sizes even.
+ * Each axis is copied at the same size, bilinear filtered when it grows or
+ * shrinks by less than 2 and area averaged otherwise. A planar frame may
+ * be scaled into a semiplanar one and the other way round.
+ */
+cmr_int cmr_sw_scale_check(const struct cmr_sw_frame *src, const struct cmr_sw_rect *rect,
+			const struct cmr_sw_frame *dst);
+
+cmr_int cmr_sw_scale(const struct cmr_sw_frame *src, const struct cmr_sw_rect *rect,
+			const struct cmr_sw_frame *dst);
+
+/*
+ * 90 turns the frame clockwise, 270 counter clockwise, mirror swaps left
+ * and right. dst is height x width for 90 and 270 and has the layout of
+ * src.
+ */
+cmr_int cmr_sw_rotate_check(const struct cmr_sw_frame *src, const struct cmr_sw_frame *dst,
+			cmr_u32 angle);
+
+cmr_int cmr_sw_rotate(const struct cmr_sw_frame *src, const struct cmr_sw_frame *dst,
+			cmr_u32 angle);
+
+/* use_simd 0 runs the C kernels, threads caps the workers, 0 for the default */
+void cmr_sw_cvt_config(cmr_u32 use_simd, cmr_u32 threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
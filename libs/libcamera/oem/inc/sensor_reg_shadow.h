@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _SENSOR_REG_SHADOW_H_
+#define _SENSOR_REG_SHADOW_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cmr_type.h"
+#include "sensor_drv_k.h"
+
+#define SENSOR_REG_SHADOW_SIZE                        0x10000
+/* CCI software_reset, all registers go back to default */
+#define SENSOR_REG_SOFT_RESET                         0x0103
+/* shorter runs of consecutive registers are written one by one */
+#define SENSOR_REG_BURST_MIN                          4
+#define SENSOR_REG_BURST_MAX                          32
+
+#ifndef SENSOR_WRITE_DELAY
+#define SENSOR_WRITE_DELAY                            0xffff
+#endif
+
+/*
+ * Last value written to every register of the sensor in use. A register
+ * is known only after it has been written since the last power on or
+ * reset, registers never written are sent again.
+ */
+struct sensor_reg_shadow {
+	cmr_u16                             *value;
+	cmr_u32                             *known;
+	/* registers of the table being sent, and the ones it sets twice */
+	cmr_u32                             *in_tab;
+	cmr_u32                             *repeated;
+};
+
+struct sensor_reg_ops {
+	/* write registers and delays one by one, in table order */
+	cmr_int (*write_tab)(void *priv, struct sensor_reg_tag *reg, cmr_u32 count);
+	/* write 8 bit values to count registers from addr on in one transfer, may be NULL */
+	cmr_int (*write_burst)(void *priv, cmr_u16 addr, cmr_u8 *value, cmr_u32 count);
+	void                                *priv;
+};
+
+struct sensor_reg_stat {
+	cmr_u32                             reg_count;
+	cmr_u32                             skipped;
+	cmr_u32                             singles;
+	cmr_u32                             bursts;
+	cmr_u32                             burst_regs;
+};
+
+cmr_int sensor_reg_shadow_init(struct sensor_reg_shadow *shadow);
+
+void sensor_reg_shadow_deinit(struct sensor_reg_shadow *shadow);
+
+/* forget every register, for power off, reset or writes the shadow does not see */
+void sensor_reg_shadow_clear(struct sensor_reg_shadow *shadow);
+
+void sensor_reg_shadow_update(struct sensor_reg_shadow *shadow, cmr_u16 addr, cmr_u16 value);
+
+/*
+ * Send a register table. With is_delta, registers already holding the
+ * value are skipped, except the software reset. A table that sets a
+ * register more than once, like the access codes of imx219 or the
+ * pointer and data registers of s5k3h7yx, is written in full. The
+ * remaining entries keep their
+ * table order and every delay stays where it is. Runs of adjacent table
+ * entries with consecutive addresses go out as one burst when the ops
+ * can write bursts.
+ */
+cmr_int sensor_reg_shadow_send(struct sensor_reg_shadow *shadow,
+				const struct sensor_reg_tag *tab, cmr_u32 count,
+				cmr_u32 is_delta, const struct sensor_reg_ops *ops,
+				struct sensor_reg_stat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
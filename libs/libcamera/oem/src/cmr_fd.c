@@ -16,10 +16,12 @@
 
 #define LOG_TAG "cmr_fd"
 
+#include <time.h>
 #include "cmr_msg.h"
 #include "cmr_ipm.h"
 #include "cmr_common.h"
 #include "SprdOEMCamera.h"
+#include "cmr_fd_scale.h"
 #include "../../arithmetic/sc8830/inc/FaceFinder.h"
 
 
@@ -41,11 +43,17 @@ struct class_fd {
 	cmr_int                         ops_init_ret;
 	void                            *alloc_addr;
 	cmr_uint                        mem_size;
+	cmr_u16                         *line_buf;
 	cmr_uint                        frame_cnt;
 	cmr_uint                        frame_total_num;
+	struct img_size                 frame_size;
+	struct img_size                 work_size;
+	cmr_u32                         scale;
+	struct cmr_fd_pace              pace;
 	struct ipm_frame_in             frame_in;
 	struct ipm_frame_out            frame_out;
 	ipm_callback                    frame_cb;
+	ipm_frame_release               frame_release;
 };
 
 struct fd_start_parameter {
@@ -53,6 +61,8 @@ struct fd_start_parameter {
 	ipm_callback                    frame_cb;
 	cmr_handle                      caller_handle;
 	void                            *private_data;
+	/*the preview frame, held until the detection is done*/
+	struct ipm_frame_in             frame_in;
 };
 
 static cmr_int fd_open(cmr_handle ipm_handle, struct ipm_open_in *in, struct ipm_open_out *out,
@@ -68,6 +78,9 @@ static cmr_uint fd_is_busy(struct class_fd *class_handle);
 static void fd_set_busy(struct class_fd *class_handle, cmr_uint is_busy);
 static cmr_int fd_thread_create(struct class_fd *class_handle);
 static cmr_int fd_thread_proc(struct cmr_msg *message, void *private_data);
+static void fd_release_frame(struct class_fd *class_handle, struct ipm_frame_in *in);
+static cmr_u8 *fd_get_work_frame(struct class_fd *class_handle, struct ipm_frame_in *in);
+static cmr_s64 fd_get_time(void);
 
 
 static struct face_finder_ops fd_face_finder_ops = {
@@ -138,14 +151,25 @@ static cmr_int fd_open(cmr_handle ipm_handle, struct ipm_open_in *in, struct ipm
 	fd_handle->common.class_type  = IPM_TYPE_FD;
 	fd_handle->common.ops         = &fd_ops_tab_info;
 	fd_handle->frame_cb           = in->reg_cb;
-	fd_handle->mem_size           = in->frame_size.height * in->frame_size.width * 3 / 2;
+	fd_handle->frame_release      = in->frame_release;
 	fd_handle->frame_total_num    = in->frame_cnt;
 	fd_handle->frame_cnt          = 0;
+	fd_handle->frame_size         = in->frame_size;
+	cmr_fd_pace_init(&fd_handle->pace);
+
+	/*the detector works on a box filtered copy of the preview no larger than CMR_FD_WORK_SIZE*/
+	fd_handle->scale = cmr_fd_scale_factor(in->frame_size.width, in->frame_size.height);
+	cmr_fd_scale_size(in->frame_size.width, in->frame_size.height, fd_handle->scale,
+			&fd_handle->work_size.width, &fd_handle->work_size.height);
+	fd_handle->mem_size = fd_handle->work_size.height * fd_handle->work_size.width * 3 / 2;
 
-	CMR_LOGD("mem_size = 0x%ld", fd_handle->mem_size);
+	CMR_LOGD("scale %d, work size %dx%d, mem_size = 0x%ld", fd_handle->scale,
+		fd_handle->work_size.width, fd_handle->work_size.height, fd_handle->mem_size);
 	fd_handle->alloc_addr = malloc(fd_handle->mem_size);
-	if (!fd_handle->alloc_addr) {
+	fd_handle->line_buf = (cmr_u16 *)malloc(in->frame_size.width * sizeof(cmr_u16));
+	if (!fd_handle->alloc_addr || !fd_handle->line_buf) {
 		CMR_LOGE("mem alloc failed");
+		ret = CMR_CAMERA_NO_MEM;
 		goto free_fd_handle;
 	}
 
@@ -157,6 +181,7 @@ static cmr_int fd_open(cmr_handle ipm_handle, struct ipm_open_in *in, struct ipm
 
 	fd_size = &in->frame_size;
 	CMR_LOGI("fd_size height = %d, width = %d", fd_size->height, fd_size->width);
+	fd_size = &fd_handle->work_size;
 	ret = fd_call_init(fd_handle, fd_size);
 	if (ret) {
 		CMR_LOGE("failed to init fd");
@@ -171,6 +196,9 @@ free_fd_handle:
 	if (fd_handle->alloc_addr) {
 		free(fd_handle->alloc_addr);
 	}
+	if (fd_handle->line_buf) {
+		free(fd_handle->line_buf);
+	}
 	free(fd_handle);
 	return ret;
 }
@@ -200,6 +228,9 @@ static cmr_int fd_close(cmr_handle class_handle)
 	if (fd_handle->alloc_addr) {
 		free(fd_handle->alloc_addr);
 	}
+	if (fd_handle->line_buf) {
+		free(fd_handle->line_buf);
+	}
 
 	free(fd_handle);
 
@@ -220,15 +251,21 @@ static cmr_int fd_transfer_frame(cmr_handle class_handle,struct ipm_frame_in *in
 		return CMR_CAMERA_INVALID_PARAM;
 	}
 
+	/*every frame comes back through frame_release, right here when it is not taken*/
 	frame_cnt   = ++fd_handle->frame_cnt;
 
 	if (frame_cnt < fd_handle->frame_total_num) {
 		CMR_LOGD("This is fd 0x%ld frame. need the 0x%ld frame,",frame_cnt, fd_handle->frame_total_num);
-		return ret;
+		goto out;
 	}
 
 	is_busy = fd_is_busy(fd_handle);
-	CMR_LOGI("fd is_busy =%d", is_busy);
+	CMR_LOGD("fd is_busy =%d", is_busy);
+
+	if (!is_busy && !cmr_fd_pace_ready(&fd_handle->pace, fd_get_time())) {
+		CMR_LOGD("fd paced, latency %lld ns", fd_handle->pace.latency);
+		goto out;
+	}
 
 	if (!is_busy) {
 		fd_handle->frame_cnt = 0;
@@ -238,12 +275,14 @@ static cmr_int fd_transfer_frame(cmr_handle class_handle,struct ipm_frame_in *in
 		param.frame_cb      = fd_handle->frame_cb;
 		param.caller_handle = in->caller_handle;
 		param.private_data  = in->private_data;
+		param.frame_in      = *in;
 
-		memcpy(fd_handle->alloc_addr, (void *)in->src_frame.addr_vir.addr_y, fd_handle->mem_size);
-
+		/*the preview buffer is read by the fd thread, no copy here*/
+		fd_set_busy(fd_handle, 1);
 		ret = fd_start(class_handle,&param);
 		if (ret) {
 			CMR_LOGE("send msg fail");
+			fd_set_busy(fd_handle, 0);
 			goto out;
 		}
 
@@ -258,8 +297,10 @@ static cmr_int fd_transfer_frame(cmr_handle class_handle,struct ipm_frame_in *in
 				CMR_LOGE("sync err,out parm can't NULL.");
 			}
 		}
+		return ret;
 	}
 out:
+	fd_release_frame(fd_handle, in);
 	return ret;
 }
 
@@ -391,6 +432,47 @@ static void fd_set_busy(struct class_fd *class_handle, cmr_uint is_busy)
 	class_handle->is_busy = is_busy;
 }
 
+static void fd_release_frame(struct class_fd *class_handle, struct ipm_frame_in *in)
+{
+	if (class_handle->frame_release) {
+		class_handle->frame_release(IPM_TYPE_FD, in);
+	}
+}
+
+static cmr_s64 fd_get_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (cmr_s64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*the frame at the detector size: the preview itself when it is small enough, else a box filtered copy*/
+static cmr_u8 *fd_get_work_frame(struct class_fd *class_handle, struct ipm_frame_in *in)
+{
+	cmr_u8               *src_y  = (cmr_u8 *)in->src_frame.addr_vir.addr_y;
+	cmr_u8               *src_uv = (cmr_u8 *)in->src_frame.addr_vir.addr_u;
+	cmr_u32              width   = class_handle->frame_size.width;
+	cmr_u32              height  = class_handle->frame_size.height;
+
+	if (!src_y) {
+		return NULL;
+	}
+
+	if (!src_uv) {
+		src_uv = src_y + width * height;
+	}
+
+	if (1 == class_handle->scale && src_uv == src_y + width * height) {
+		return src_y;
+	}
+
+	cmr_fd_scale_nv21(src_y, src_uv, width, height, class_handle->scale,
+			(cmr_u8 *)class_handle->alloc_addr, class_handle->line_buf);
+
+	return (cmr_u8 *)class_handle->alloc_addr;
+}
+
 
 static cmr_int fd_thread_create(struct class_fd *class_handle)
 {
@@ -433,6 +515,9 @@ static cmr_int fd_thread_proc(struct cmr_msg *message, void *private_data)
 	cmr_int                   face_num = 0;
 	cmr_int                   k,min_fd;
 	struct fd_start_parameter *start_param;
+	cmr_u8                    *work_addr;
+	cmr_s64                   start_time;
+	cmr_s32                   scale;
 
 	if (!message || !class_handle) {
 		CMR_LOGE("parameter is fail");
@@ -470,10 +555,14 @@ static cmr_int fd_thread_proc(struct cmr_msg *message, void *private_data)
 		}
 
 		fd_set_busy(class_handle, 1);
+		start_time = fd_get_time();
 
 		/*check memory addr*/
-		if (NULL == class_handle->alloc_addr) {
-			CMR_LOGE("handle->addr 0x%lx", (cmr_uint)class_handle->alloc_addr);
+		work_addr = fd_get_work_frame(class_handle, &start_param->frame_in);
+		if (NULL == work_addr) {
+			CMR_LOGE("no frame addr");
+			fd_release_frame(class_handle, &start_param->frame_in);
+			fd_set_busy(class_handle, 0);
 			break;
 		}
 
@@ -481,17 +570,23 @@ static cmr_int fd_thread_proc(struct cmr_msg *message, void *private_data)
 		CMR_LOGV("fd detect start");
 
 		if (fd_face_finder_ops.function) {
-			facesolid_ret = fd_face_finder_ops.function((cmr_u8*)class_handle->alloc_addr,
+			facesolid_ret = fd_face_finder_ops.function(work_addr,
 									&face_rect_ptr,
 									(int*)&face_num,
 									0);
 		}
 
+		/*the detector is done with the preview frame*/
+		fd_release_frame(class_handle, &start_param->frame_in);
+		cmr_fd_pace_done(&class_handle->pace, start_time, fd_get_time());
+		CMR_LOGV("fd detect done, latency %lld ns", class_handle->pace.latency);
+
 		if (FD_FAIL == facesolid_ret) {
 			CMR_LOGE("face function fail.");
 			fd_set_busy(class_handle, 0);
 		} else {
 			min_fd = MIN(face_num,FACE_DETECT_NUM);
+			scale = (cmr_s32)class_handle->scale;
 			int invalid_count = 0;
 			for (k = 0; k < min_fd; k++) {
 				if (face_rect_ptr->sx < 0 || face_rect_ptr->sy < 0 ||
@@ -503,6 +598,15 @@ static cmr_int fd_thread_proc(struct cmr_msg *message, void *private_data)
 				CMR_LOGI("face detect sx = %d, sy = %d, ex = %d, ey = %d",
 				face_rect_ptr->sx, face_rect_ptr->sy, face_rect_ptr->ex, face_rect_ptr->ey);
 				class_handle->frame_out.face_area.range[k]      = *face_rect_ptr;
+				/*back to preview coordinates*/
+				class_handle->frame_out.face_area.range[k].sx  *= scale;
+				class_handle->frame_out.face_area.range[k].sy  *= scale;
+				class_handle->frame_out.face_area.range[k].srx *= scale;
+				class_handle->frame_out.face_area.range[k].sry *= scale;
+				class_handle->frame_out.face_area.range[k].ex  *= scale;
+				class_handle->frame_out.face_area.range[k].ey  *= scale;
+				class_handle->frame_out.face_area.range[k].elx *= scale;
+				class_handle->frame_out.face_area.range[k].ely *= scale;
 				face_rect_ptr++;
 			}
 			class_handle->frame_out.face_area.face_count = min_fd - invalid_count;
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+
+#include "cmr_fd_scale.h"
+
+cmr_u32 cmr_fd_scale_factor(cmr_u32 width, cmr_u32 height)
+{
+	cmr_u32 factor = 1;
+
+	while (factor < CMR_FD_SCALE_MAX
+		&& (width / factor) * (height / factor) > CMR_FD_WORK_SIZE)
+		factor++;
+
+	if (factor > 1 && (width / factor) * (height / factor) < CMR_FD_MIN_SIZE)
+		factor--;
+
+	return factor;
+}
+
+void cmr_fd_scale_size(cmr_u32 width, cmr_u32 height, cmr_u32 factor,
+			cmr_u32 *out_width, cmr_u32 *out_height)
+{
+	if (1 == factor) {
+		*out_width  = width;
+		*out_height = height;
+	} else {
+		/* NV21 wants even sizes */
+		*out_width  = (width / factor) & ~1;
+		*out_height = (height / factor) & ~1;
+	}
+}
+
+/*
+ * dst_w bytes of dst_h rows, comps (1 or 2) interleaved components per
+ * pixel. The factor rows of a block are summed into line first, so every
+ * row of the source is walked once from left to right.
+ */
+static void fd_box_plane(const cmr_u8 *src, cmr_u32 src_stride,
+			cmr_u8 *dst, cmr_u32 dst_w, cmr_u32 dst_h,
+			cmr_u32 factor, cmr_u32 comps, cmr_u16 *line)
+{
+	cmr_u32 src_w = dst_w * factor;
+	cmr_u32 recip = (1 << 16) / (factor * factor);
+	cmr_u32 x, y, r, k, c, sum;
+	const cmr_u8 *row;
+	const cmr_u16 *p;
+
+	for (y = 0; y < dst_h; y++) {
+		row = src + y * factor * src_stride;
+		for (x = 0; x < src_w; x++)
+			line[x] = row[x];
+		for (r = 1; r < factor; r++) {
+			row += src_stride;
+			for (x = 0; x < src_w; x++)
+				line[x] += row[x];
+		}
+
+		p = line;
+		for (x = 0; x < dst_w; x += comps) {
+			for (c = 0; c < comps; c++) {
+				sum = 0;
+				for (k = 0; k < factor; k++)
+					sum += p[k * comps + c];
+				dst[x + c] = (cmr_u8)((sum * recip + (1 << 15)) >> 16);
+			}
+			p += factor * comps;
+		}
+		dst += dst_w;
+	}
+}
+
+static void fd_box2_plane(const cmr_u8 *src, cmr_u32 src_stride,
+			cmr_u8 *dst, cmr_u32 dst_w, cmr_u32 dst_h, cmr_u32 comps)
+{
+	cmr_u32 x, y, c;
+	const cmr_u8 *r0, *r1;
+
+	for (y = 0; y < dst_h; y++) {
+		r0 = src + 2 * y * src_stride;
+		r1 = r0 + src_stride;
+		for (x = 0; x < dst_w; x += comps) {
+			for (c = 0; c < comps; c++)
+				dst[x + c] = (cmr_u8)((r0[2 * x + c] + r0[2 * x + comps + c]
+					+ r1[2 * x + c] + r1[2 * x + comps + c] + 2) >> 2);
+		}
+		dst += dst_w;
+	}
+}
+
+void cmr_fd_scale_nv21(const cmr_u8 *src_y, const cmr_u8 *src_uv,
+			cmr_u32 width, cmr_u32 height, cmr_u32 factor,
+			cmr_u8 *dst, cmr_u16 *line)
+{
+	cmr_u32 dst_w, dst_h;
+
+	cmr_fd_scale_size(width, height, factor, &dst_w, &dst_h);
+
+	if (1 == factor) {
+		memcpy(dst, src_y, width * height);
+		memcpy(dst + width * height, src_uv, width * height / 2);
+	} else if (2 == factor) {
+		fd_box2_plane(src_y, width, dst, dst_w, dst_h, 1);
+		fd_box2_plane(src_uv, width, dst + dst_w * dst_h, dst_w, dst_h / 2, 2);
+	} else {
+		fd_box_plane(src_y, width, dst, dst_w, dst_h, factor, 1, line);
+		fd_box_plane(src_uv, width, dst + dst_w * dst_h, dst_w, dst_h / 2, factor, 2, line);
+	}
+}
+
+void cmr_fd_pace_init(struct cmr_fd_pace *pace)
+{
+	pace->latency   = 0;
+	pace->next_time = 0;
+}
+
+cmr_u32 cmr_fd_pace_ready(struct cmr_fd_pace *pace, cmr_s64 now)
+{
+	return now >= pace->next_time;
+}
+
+void cmr_fd_pace_done(struct cmr_fd_pace *pace, cmr_s64 start, cmr_s64 end)
+{
+	cmr_s64 gap;
+
+	if (pace->latency)
+		pace->latency = (pace->latency * 7 + (end - start)) / 8;
+	else
+		pace->latency = end - start;
+
+	gap = pace->latency * (100 - CMR_FD_PACE_DUTY) / CMR_FD_PACE_DUTY;
+	if (gap > CMR_FD_PACE_MAX_GAP)
+		gap = CMR_FD_PACE_MAX_GAP;
+	pace->next_time = end + gap;
+}
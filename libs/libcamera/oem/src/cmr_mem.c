@@ -16,6 +16,7 @@
 #define LOG_TAG "cmr_mem"
 
 #include "cmr_mem.h"
+#include "cmr_mem_plan.h"
 #include "cmr_oem.h"
 #include <unistd.h>
 
@@ -49,6 +50,8 @@
 #define FRONT_CAMERA_ID           1
 #define JPEG_SMALL_SIZE           (300 * 1024)
 #define ADDR_BY_WORD(a)           (((a) + 3 ) & (~3))
+/* big enough for any sensor, the planner checks the real frame size */
+#define PLAN_MEM_RES              0x7FFFFFFF
 #define CMR_NO_MEM(a, b) \
 	do { \
 		if ((a) > (b)) { \
@@ -222,7 +225,6 @@ static int arrange_rot_buf(struct cmr_cap_2_frm *cap_2_frm,
 					uint32_t *io_mem_res,
 					uint32_t *io_mem_end,
 					uint32_t *io_channel_size);
-
 static const cmr_get_size get_size[BUF_TYPE_NUM] = {
 	get_jpeg_size,
 	get_thum_yuv_size,
@@ -424,6 +426,18 @@ int camera_arrange_capture_buf(struct cmr_cap_2_frm *cap_2_frm,
 					thum_size->width,
 					thum_size->height);
 
+	if (0 == arrange_planned_buf(cap_2_frm,
+				sn_size,
+				sn_trim,
+				image_size,
+				orig_fmt,
+				cap_size,
+				thum_size,
+				cap_mem,
+				need_rot)) {
+		goto arranged;
+	}
+
 	if (IMG_DATA_TYPE_RAW == orig_fmt) {
 		ret = arrange_raw_buf(cap_2_frm,
 					sn_size,
@@ -540,6 +554,7 @@ int camera_arrange_capture_buf(struct cmr_cap_2_frm *cap_2_frm,
 
 	CMR_LOGI("mem_end, mem_res: 0x%x 0x%x ", mem_end, mem_res);
 
+arranged:
 	/* resize target jpeg buffer */
 	cap_mem->target_jpeg.addr_phy.addr_y = cap_mem->target_jpeg.addr_phy.addr_y + JPEG_EXIF_SIZE;
 	cap_mem->target_jpeg.addr_vir.addr_y = cap_mem->target_jpeg.addr_vir.addr_y + JPEG_EXIF_SIZE;
@@ -1215,6 +1230,196 @@ int arrange_rot_buf(struct cmr_cap_2_frm *cap_2_frm,
 }
 
 
+static void plan_move_addr(struct img_addr *addr,
+				cmr_uint base,
+				uint32_t uv_start,
+				uint32_t uv_offset)
+{
+	/* only the raw layout has the uv plane out of the main block */
+	if (uv_start && addr->addr_u >= uv_start) {
+		addr->addr_u = base + uv_offset + (addr->addr_u - uv_start);
+	} else if (addr->addr_u) {
+		addr->addr_u += base;
+	}
+	addr->addr_y += base;
+}
+
+/*
+ * The main block, where raw, cap yuv and target yuv overlap so the
+ * streaming hardware can work in place, is arranged the legacy way at
+ * offset 0. The other buffers are planned by the stages they are used
+ * in, those never used at the same time share memory. Fails without
+ * touching capture_mem when the plan does not fit in the frame memory.
+ */
+int arrange_planned_buf(struct cmr_cap_2_frm *cap_2_frm,
+				struct img_size *sn_size,
+				struct img_rect *sn_trim,
+				struct img_size *image_size,
+				uint32_t orig_fmt,
+				struct img_size *cap_size,
+				struct img_size *thum_size,
+				struct cmr_cap_mem *capture_mem,
+				uint32_t need_rot)
+{
+	uint32_t       channel_size = 0;
+	uint32_t       mem_res = PLAN_MEM_RES, mem_end = 0;
+	uint32_t       uv_start = 0, uv_end = 0;
+	uint32_t       i = 0;
+	int            ret = -1;
+	cmr_uint       base_phy = cap_2_frm->mem_frm.addr_phy.addr_y;
+	cmr_uint       base_vir = cap_2_frm->mem_frm.addr_vir.addr_y;
+	struct cmr_cap_2_frm plan_frm;
+	struct cmr_cap_mem   plan_mem;
+	struct cmr_cap_plan  plan;
+	struct img_frm       *main_frm[] = {&plan_mem.cap_raw, &plan_mem.target_yuv, &plan_mem.cap_yuv};
+	struct img_size      align16_image_size;
+
+	align16_image_size.width = CAMERA_ALIGNED_16(image_size->width);
+	align16_image_size.height = CAMERA_ALIGNED_16(image_size->height);
+
+	/* main block at address 0, never short of memory so nothing gets allocated */
+	memset((void*)&plan_frm, 0, sizeof(struct cmr_cap_2_frm));
+	memset((void*)&plan_mem, 0, sizeof(struct cmr_cap_mem));
+	memset((void*)&plan, 0, sizeof(struct cmr_cap_plan));
+	plan_mem.target_jpeg.buf_size = capture_mem->target_jpeg.buf_size;
+
+	if (IMG_DATA_TYPE_RAW == orig_fmt) {
+		ret = arrange_raw_buf(&plan_frm,
+					sn_size,
+					sn_trim,
+					image_size,
+					orig_fmt,
+					cap_size,
+					thum_size,
+					&plan_mem,
+					need_rot,
+					&mem_res,
+					&mem_end,
+					&channel_size);
+		uv_start = (uint32_t)plan_mem.target_yuv.addr_phy.addr_u;
+	} else if (IMG_DATA_TYPE_JPEG == orig_fmt) {
+		ret = arrange_jpeg_buf(&plan_frm,
+					sn_size,
+					sn_trim,
+					image_size,
+					orig_fmt,
+					cap_size,
+					thum_size,
+					&plan_mem,
+					need_rot,
+					&mem_res,
+					&mem_end,
+					&channel_size);
+	} else {
+		ret = arrange_yuv_buf(&plan_frm,
+					sn_size,
+					sn_trim,
+					image_size,
+					orig_fmt,
+					cap_size,
+					thum_size,
+					&plan_mem,
+					need_rot,
+					&mem_res,
+					&mem_end,
+					&channel_size);
+	}
+	if (ret) {
+		return -1;
+	}
+
+	/* the legacy target jpeg follows the main block unless rotating */
+	if (!need_rot) {
+		plan.size[CMR_CAP_PLAN_MAIN] = (uint32_t)plan_mem.target_jpeg.addr_phy.addr_y;
+	} else if (uv_start) {
+		plan.size[CMR_CAP_PLAN_MAIN] = uv_start;
+	} else {
+		plan.size[CMR_CAP_PLAN_MAIN] = mem_end;
+	}
+	/* the cap yuv uv plane of a trimmed or unaligned frame runs past the legacy block */
+	uv_end = (uint32_t)plan_mem.cap_yuv.addr_phy.addr_u
+		+ plan_mem.cap_yuv.size.width * plan_mem.cap_yuv.size.height / 2;
+	if (uv_start) {
+		plan.size[CMR_CAP_PLAN_UV] = MAX(mem_end, uv_end) - uv_start;
+	} else {
+		plan.size[CMR_CAP_PLAN_MAIN] = MAX(plan.size[CMR_CAP_PLAN_MAIN], uv_end);
+	}
+	plan.size[CMR_CAP_PLAN_JPEG] = plan_mem.target_jpeg.buf_size;
+	plan.size[CMR_CAP_PLAN_THUM_YUV] = get_thum_yuv_size(align16_image_size.width,
+						align16_image_size.height,
+						thum_size->width,
+						thum_size->height);
+	plan.size[CMR_CAP_PLAN_THUM_JPEG] = get_thum_jpeg_size(align16_image_size.width,
+						align16_image_size.height,
+						thum_size->width,
+						thum_size->height);
+	if (need_rot) {
+		if (IMG_DATA_TYPE_JPEG == orig_fmt) {
+			plan.size[CMR_CAP_PLAN_ROT] = channel_size << 1;
+		} else {
+			plan.size[CMR_CAP_PLAN_ROT] = (channel_size * 3) >> 1;
+		}
+	}
+
+	if (cmr_mem_plan_capture(&plan, cap_2_frm->mem_frm.buf_size)) {
+		CMR_LOGI("planned 0x%x, frame mem 0x%x, use sequential layout",
+			plan.plan_size,
+			cap_2_frm->mem_frm.buf_size);
+		return -1;
+	}
+
+	for (i = 0; i < sizeof(main_frm) / sizeof(main_frm[0]); i++) {
+		if (!main_frm[i]->buf_size)
+			continue;
+		plan_move_addr(&main_frm[i]->addr_phy, base_phy, uv_start, plan.offset[CMR_CAP_PLAN_UV]);
+		plan_move_addr(&main_frm[i]->addr_vir, base_vir, uv_start, plan.offset[CMR_CAP_PLAN_UV]);
+	}
+
+	plan_mem.target_jpeg.addr_phy.addr_y = base_phy + plan.offset[CMR_CAP_PLAN_JPEG];
+	plan_mem.target_jpeg.addr_vir.addr_y = base_vir + plan.offset[CMR_CAP_PLAN_JPEG];
+
+	plan_mem.thum_yuv.buf_size = plan.size[CMR_CAP_PLAN_THUM_YUV];
+	plan_mem.thum_yuv.addr_phy.addr_y = base_phy + plan.offset[CMR_CAP_PLAN_THUM_YUV];
+	plan_mem.thum_yuv.addr_vir.addr_y = base_vir + plan.offset[CMR_CAP_PLAN_THUM_YUV];
+	plan_mem.thum_yuv.addr_phy.addr_u = plan_mem.thum_yuv.addr_phy.addr_y + plan_mem.thum_yuv.buf_size * 2 / 3;
+	plan_mem.thum_yuv.addr_vir.addr_u = plan_mem.thum_yuv.addr_vir.addr_y + plan_mem.thum_yuv.buf_size * 2 / 3;
+	plan_mem.thum_yuv.size.width = thum_size->width;
+	plan_mem.thum_yuv.size.height = thum_size->height;
+
+	plan_mem.thum_jpeg.buf_size = plan.size[CMR_CAP_PLAN_THUM_JPEG];
+	plan_mem.thum_jpeg.addr_phy.addr_y = base_phy + plan.offset[CMR_CAP_PLAN_THUM_JPEG];
+	plan_mem.thum_jpeg.addr_vir.addr_y = base_vir + plan.offset[CMR_CAP_PLAN_THUM_JPEG];
+
+	/* mem reuse, jpeg_tmp/uv */
+	plan_mem.jpeg_tmp.buf_size = plan_mem.cap_yuv.buf_size;
+	plan_mem.jpeg_tmp.addr_phy.addr_y = plan_mem.cap_yuv.addr_phy.addr_u;
+	plan_mem.jpeg_tmp.addr_vir.addr_y = plan_mem.cap_yuv.addr_vir.addr_u;
+
+	if (need_rot) {
+		plan_mem.cap_yuv_rot.addr_phy.addr_y = base_phy + plan.offset[CMR_CAP_PLAN_ROT];
+		plan_mem.cap_yuv_rot.addr_vir.addr_y = base_vir + plan.offset[CMR_CAP_PLAN_ROT];
+		plan_mem.cap_yuv_rot.addr_phy.addr_u = plan_mem.cap_yuv_rot.addr_phy.addr_y + channel_size;
+		plan_mem.cap_yuv_rot.addr_vir.addr_u = plan_mem.cap_yuv_rot.addr_vir.addr_y + channel_size;
+		plan_mem.cap_yuv_rot.addr_phy.addr_v = 0;
+		plan_mem.cap_yuv_rot.size.width = align16_image_size.height;
+		plan_mem.cap_yuv_rot.size.height = align16_image_size.width;
+		plan_mem.cap_yuv_rot.buf_size = plan.size[CMR_CAP_PLAN_ROT];
+		plan_mem.cap_yuv_rot.fmt = IMG_DATA_TYPE_YUV420;
+
+		plan_mem.jpeg_tmp.addr_phy.addr_y = plan_mem.cap_yuv_rot.addr_phy.addr_u;
+		plan_mem.jpeg_tmp.addr_vir.addr_y = plan_mem.cap_yuv_rot.addr_vir.addr_u;
+	}
+
+	CMR_LOGI("sequential 0x%x, planned 0x%x, saved 0x%x",
+		plan.seq_size,
+		plan.plan_size,
+		plan.seq_size - plan.plan_size);
+
+	memcpy((void*)capture_mem, (void*)&plan_mem, sizeof(struct cmr_cap_mem));
+
+	return 0;
+}
+
 uint32_t get_jpeg_size(uint32_t width, uint32_t height, uint32_t thum_width, uint32_t thum_height)
 {
 	uint32_t       size;
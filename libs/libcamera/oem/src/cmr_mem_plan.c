@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cmr_mem_plan.h"
+
+#define PLAN_ALIGN(x, a)                 (((x) + (a) - 1) & ~((a) - 1))
+
+/* the stages of a snapshot, in order */
+enum {
+	CAP_STAGE_SENSOR = 0,
+	/* jpeg decode or isp raw to yuv */
+	CAP_STAGE_CONVERT,
+	CAP_STAGE_ROT,
+	CAP_STAGE_SCALE,
+	/* thumbnail, jpeg encode and redisplay, all in parallel */
+	CAP_STAGE_ENCODE,
+	/* thumbnail jpeg put in the exif of the picture */
+	CAP_STAGE_DONE
+};
+
+struct cap_plan_stages {
+	cmr_u32                         first;
+	cmr_u32                         last;
+};
+
+/*
+ * Kept wide on purpose: the rotation buffer also takes the isp output
+ * before scaling when the channel rotates, and the thumbnail yuv is only
+ * encoded once the picture is done.
+ */
+static const struct cap_plan_stages cap_plan_stages[CMR_CAP_PLAN_NUM] = {
+	{CAP_STAGE_SENSOR,  CAP_STAGE_DONE},  /* MAIN */
+	{CAP_STAGE_CONVERT, CAP_STAGE_DONE},  /* UV */
+	{CAP_STAGE_ENCODE,  CAP_STAGE_DONE},  /* JPEG */
+	{CAP_STAGE_ENCODE,  CAP_STAGE_DONE},  /* THUM_YUV */
+	{CAP_STAGE_ENCODE,  CAP_STAGE_DONE},  /* THUM_JPEG */
+	{CAP_STAGE_SENSOR,  CAP_STAGE_SCALE}, /* ROT */
+};
+
+static cmr_u32 plan_conflict(const struct cmr_mem_plan_buf *a, const struct cmr_mem_plan_buf *b)
+{
+	return a->first <= b->last && b->first <= a->last;
+}
+
+cmr_int cmr_mem_plan_layout(struct cmr_mem_plan_buf *buf, cmr_u32 num, cmr_u32 *out_size)
+{
+	cmr_u32 order[CMR_MEM_PLAN_MAX];
+	cmr_u32 placed = 0, end = 0;
+	cmr_u32 i, j, k, moved;
+	struct cmr_mem_plan_buf *b, *p;
+
+	if (!buf || !out_size || num > CMR_MEM_PLAN_MAX)
+		return CMR_CAMERA_INVALID_PARAM;
+
+	/* fixed buffers first, then by size, larger first */
+	for (i = 0; i < num; i++) {
+		for (j = i; j > 0; j--) {
+			p = &buf[order[j - 1]];
+			if (p->fixed > buf[i].fixed
+				|| (p->fixed == buf[i].fixed && p->size >= buf[i].size))
+				break;
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	for (i = 0; i < num; i++) {
+		b = &buf[order[i]];
+		if (!b->size)
+			continue;
+		if (!b->fixed) {
+			if (!b->align || (b->align & (b->align - 1)))
+				return CMR_CAMERA_INVALID_PARAM;
+			b->offset = 0;
+			do {
+				moved = 0;
+				for (k = 0; k < placed; k++) {
+					p = &buf[order[k]];
+					if (!p->size || !plan_conflict(b, p))
+						continue;
+					if (b->offset < p->offset + p->size && p->offset < b->offset + b->size) {
+						b->offset = PLAN_ALIGN(p->offset + p->size, b->align);
+						moved = 1;
+					}
+				}
+			} while (moved);
+		}
+		if (b->offset + b->size > end)
+			end = b->offset + b->size;
+		placed = i + 1;
+	}
+
+	*out_size = end;
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+cmr_int cmr_mem_plan_capture(struct cmr_cap_plan *plan, cmr_u32 mem_size)
+{
+	cmr_int ret;
+	struct cmr_mem_plan_buf buf[CMR_CAP_PLAN_NUM];
+	cmr_u32 i;
+
+	plan->seq_size = 0;
+	for (i = 0; i < CMR_CAP_PLAN_NUM; i++) {
+		buf[i].size = plan->size[i];
+		buf[i].align = CMR_MEM_PLAN_ALIGN;
+		buf[i].first = cap_plan_stages[i].first;
+		buf[i].last = cap_plan_stages[i].last;
+		buf[i].fixed = (CMR_CAP_PLAN_MAIN == i);
+		buf[i].offset = 0;
+		/* the jpeg always went to the rotation buffer */
+		if (CMR_CAP_PLAN_JPEG != i || !plan->size[CMR_CAP_PLAN_ROT])
+			plan->seq_size += PLAN_ALIGN(plan->size[i], CMR_MEM_PLAN_ALIGN);
+	}
+
+	ret = cmr_mem_plan_layout(buf, CMR_CAP_PLAN_NUM, &plan->plan_size);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < CMR_CAP_PLAN_NUM; i++)
+		plan->offset[i] = buf[i].offset;
+
+	if (plan->plan_size > mem_size)
+		return CMR_CAMERA_NO_MEM;
+
+	return CMR_CAMERA_SUCCESS;
+}
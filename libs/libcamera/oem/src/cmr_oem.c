@@ -135,6 +135,8 @@ static cmr_int camera_start_scale(cmr_handle oem_handle, cmr_handle caller_handl
                                              struct img_frm *dst, struct cmr_op_mean *mean);
 static cmr_int camera_start_rot(cmr_handle oem_handle, cmr_handle caller_handle, struct img_frm *src,
                                          struct img_frm *dst, struct cmr_op_mean *mean);
+static void camera_preview_cvt_flush(cmr_handle oem_handle, struct img_frm *img);
+static void camera_snapshot_cvt_flush(cmr_handle oem_handle, struct img_frm *img);
 static cmr_int camera_ipm_pre_proc(cmr_handle oem_handle, void * private_data);
 static cmr_int camera_capture_pre_proc(cmr_handle oem_handle, cmr_u32 camera_id, cmr_u32 preview_mode, cmr_u32 capture_mode, cmr_u32 is_restart, cmr_u32 is_sn_reopen);
 static cmr_int camera_capture_post_proc(cmr_handle oem_handle, cmr_u32 camera_id);
@@ -1553,6 +1555,49 @@ exit:
 	return ret;
 }
 
+static void camera_cvt_flush_plane(struct camera_context *cxt, cmr_uint func,
+                                    cmr_uint vir_addr, cmr_uint phy_addr, cmr_u32 size)
+{
+	struct camera_frame_type       frame;
+
+	if (!vir_addr || !size)
+		return;
+
+	cmr_bzero(&frame, sizeof(frame));
+	frame.y_vir_addr = vir_addr;
+	frame.y_phy_addr = phy_addr;
+	frame.width = size;
+	frame.height = 1;
+	cxt->camera_cb(CAMERA_EVT_CB_FLUSH, cxt->client_data, func, &frame);
+}
+
+static void camera_cvt_flush(struct camera_context *cxt, cmr_uint func, struct img_frm *img)
+{
+	cmr_u32                        y_size;
+
+	if (!cxt->camera_cb || !img)
+		return;
+
+	y_size = img->size.width * img->size.height;
+	camera_cvt_flush_plane(cxt, func, img->addr_vir.addr_y, img->addr_phy.addr_y, y_size);
+	if (img->addr_vir.addr_v) {
+		camera_cvt_flush_plane(cxt, func, img->addr_vir.addr_u, img->addr_phy.addr_u, y_size / 4);
+		camera_cvt_flush_plane(cxt, func, img->addr_vir.addr_v, img->addr_phy.addr_v, y_size / 4);
+	} else {
+		camera_cvt_flush_plane(cxt, func, img->addr_vir.addr_u, img->addr_phy.addr_u, y_size / 2);
+	}
+}
+
+static void camera_preview_cvt_flush(cmr_handle oem_handle, struct img_frm *img)
+{
+	camera_cvt_flush((struct camera_context*)oem_handle, CAMERA_FUNC_START_PREVIEW, img);
+}
+
+static void camera_snapshot_cvt_flush(cmr_handle oem_handle, struct img_frm *img)
+{
+	camera_cvt_flush((struct camera_context*)oem_handle, CAMERA_FUNC_TAKE_PICTURE, img);
+}
+
 cmr_int camera_scaler_init(cmr_handle  oem_handle)
 {
 	cmr_int                         ret = CMR_CAMERA_SUCCESS;
@@ -1573,6 +1618,8 @@ cmr_int camera_scaler_init(cmr_handle  oem_handle)
 		CMR_LOGE("failed to init scaler %ld", ret);
 		ret = -CMR_CAMERA_NO_SUPPORT;
 	} else {
+		/* only the snapshot scales */
+		cmr_scale_set_flush(scaler_cxt->scaler_handle, camera_snapshot_cvt_flush, oem_handle);
 		scaler_cxt->inited = 1;
 	}
 
@@ -3164,6 +3211,11 @@ cmr_int camera_start_rot(cmr_handle oem_handle, cmr_handle caller_handle, struct
 		rot_param.handle = cxt->rot_cxt.rotation_handle;
 		rot_param.src_img = *src;
 		rot_param.dst_img = *dst;
+		if (caller_handle == cxt->prev_cxt.preview_handle)
+			rot_param.flush = camera_preview_cvt_flush;
+		else
+			rot_param.flush = camera_snapshot_cvt_flush;
+		rot_param.flush_handle = oem_handle;
 		ret = cmr_rot(&rot_param);
 		if (ret) {
 			CMR_LOGE("failed to rotate %ld", ret);
@@ -5135,6 +5187,8 @@ cmr_int camera_local_redisplay_data(cmr_handle oem_handle, cmr_uint output_addr,
 		rot_param.angle = angle;
 		rot_param.src_img = src_img;
 		rot_param.dst_img = dst_img;
+		rot_param.flush = NULL;
+		rot_param.flush_handle = NULL;
 		src_img.rect = rect;
 		ret = cmr_rot(&rot_param);
 		if (ret) {
@@ -168,6 +168,10 @@ struct prev_context {
 	cmr_uint                        prev_rot_index;
 	cmr_uint                        prev_rot_frm_is_lock[PREV_ROT_FRM_CNT];
 	struct img_frm                  prev_rot_frm[PREV_ROT_FRM_CNT];
+	/*frames being read by fd, and the ones released by app meanwhile*/
+	cmr_uint                        prev_frm_fd_ref[PREV_FRM_CNT];
+	cmr_uint                        prev_frm_free_pending[PREV_FRM_CNT];
+	cmr_uint                        prev_rot_frm_fd_ref[PREV_ROT_FRM_CNT];
 	cmr_uint                        prev_phys_addr_array[PREV_FRM_CNT + PREV_ROT_FRM_CNT];
 	cmr_uint                        prev_virt_addr_array[PREV_FRM_CNT + PREV_ROT_FRM_CNT];
 	cmr_uint                        prev_mem_size;
@@ -402,6 +406,8 @@ static cmr_int prev_fd_send_data(struct prev_handle *handle, cmr_u32 camera_id,
 
 static cmr_int prev_fd_cb(cmr_u32 class_type, struct ipm_frame_out *cb_param);
 
+static cmr_int prev_fd_release_frame(cmr_u32 class_type, struct ipm_frame_in *in);
+
 static cmr_int prev_fd_ctrl(struct prev_handle *handle,
 				cmr_u32 camera_id,
 				cmr_u32 on_off);
@@ -817,6 +823,17 @@ cmr_int cmr_preview_release_frame(cmr_handle preview_handle, cmr_u32 camera_id,
 
 			frm_id     = index;
 			channel_id = prev_cxt->prev_channel_id;
+
+			/*fd still reads it, freed when fd is done*/
+			pthread_mutex_lock(&handle->thread_cxt.prev_mutex);
+			if (prev_cxt->prev_frm_fd_ref[frm_id - PREV_ID_BASE]) {
+				prev_cxt->prev_frm_free_pending[frm_id - PREV_ID_BASE] = 1;
+				pthread_mutex_unlock(&handle->thread_cxt.prev_mutex);
+				CMR_LOGD("held by fd, 0x%x", frm_id);
+				return ret;
+			}
+			pthread_mutex_unlock(&handle->thread_cxt.prev_mutex);
+
 			ret = handle->ops.channel_free_frame(handle->oem_handle, channel_id, frm_id);
 			if (ret) {
 				CMR_LOGE("release frm failed");
@@ -3429,6 +3446,9 @@ cmr_int prev_set_prev_param(struct prev_handle *handle, cmr_u32 camera_id, struc
 	zoom_param       = &prev_cxt->prev_param.zoom_setting;
 
 	cmr_bzero(prev_cxt->prev_rot_frm_is_lock, PREV_ROT_FRM_CNT * sizeof(cmr_uint));
+	cmr_bzero(prev_cxt->prev_frm_fd_ref, PREV_FRM_CNT * sizeof(cmr_uint));
+	cmr_bzero(prev_cxt->prev_frm_free_pending, PREV_FRM_CNT * sizeof(cmr_uint));
+	cmr_bzero(prev_cxt->prev_rot_frm_fd_ref, PREV_ROT_FRM_CNT * sizeof(cmr_uint));
 	prev_cxt->prev_rot_index = 0;
 	prev_cxt->prev_frm_cnt   = 0;
 	prev_cxt->prev_skip_num  = sensor_info->preview_skip_num;
@@ -4531,7 +4551,8 @@ cmr_uint prev_search_rot_buffer(struct prev_context *prev_cxt)
 	for (count = 0; count < PREV_ROT_FRM_CNT; count++){
 		search_index += count;
 		search_index %= PREV_ROT_FRM_CNT;
-		if (0 == prev_cxt->prev_rot_frm_is_lock[search_index]) {
+		if (0 == prev_cxt->prev_rot_frm_is_lock[search_index]
+			&& 0 == prev_cxt->prev_rot_frm_fd_ref[search_index]) {
 			ret = CMR_CAMERA_SUCCESS;
 			prev_cxt->prev_rot_index = search_index;
 			CMR_LOGI("[prev_rot] find %ld", search_index);
@@ -4897,6 +4918,7 @@ cmr_int prev_fd_open(struct prev_handle *handle, cmr_u32 camera_id)
 	}
 
 	in_param.reg_cb             = prev_fd_cb;
+	in_param.frame_release      = prev_fd_release_frame;
 
 	ret = cmr_ipm_open(handle->ipm_handle, IPM_TYPE_FD, &in_param, &out_param, &prev_cxt->fd_handle);
 	if (ret) {
@@ -4962,6 +4984,15 @@ cmr_int prev_fd_send_data(struct prev_handle *handle, cmr_u32 camera_id, struct
 	ipm_in_param.caller_handle = (void*)handle;
 	ipm_in_param.private_data  = (void*)camera_id;
 
+	/*fd reads the preview buffer itself, hold it until prev_fd_release_frame*/
+	pthread_mutex_lock(&handle->thread_cxt.prev_mutex);
+	if (frm >= prev_cxt->prev_frm && frm < prev_cxt->prev_frm + PREV_FRM_CNT) {
+		prev_cxt->prev_frm_fd_ref[frm - prev_cxt->prev_frm]++;
+	} else if (frm >= prev_cxt->prev_rot_frm && frm < prev_cxt->prev_rot_frm + PREV_ROT_FRM_CNT) {
+		prev_cxt->prev_rot_frm_fd_ref[frm - prev_cxt->prev_rot_frm]++;
+	}
+	pthread_mutex_unlock(&handle->thread_cxt.prev_mutex);
+
 	ret = ipm_transfer_frame(prev_cxt->fd_handle, &ipm_in_param, NULL);
 	if (ret) {
 		CMR_LOGE("failed to transfer frame to ipm %ld", ret);
@@ -4973,6 +5004,60 @@ exit:
 	return ret;
 }
 
+cmr_int prev_fd_release_frame(cmr_u32 class_type, struct ipm_frame_in *in)
+{
+	cmr_int                         ret = CMR_CAMERA_SUCCESS;
+	struct prev_handle              *handle = NULL;
+	struct prev_context             *prev_cxt = NULL;
+	cmr_u32                         camera_id = CAMERA_ID_MAX;
+	cmr_u32                         i = 0;
+	cmr_u32                         need_free = 0;
+
+	if (!in || !in->caller_handle) {
+		CMR_LOGE("error param");
+		return CMR_CAMERA_INVALID_PARAM;
+	}
+
+	handle    = (struct prev_handle*)in->caller_handle;
+	camera_id = (cmr_u32)in->private_data;
+	CHECK_HANDLE_VALID(handle);
+	CHECK_CAMERA_ID(camera_id);
+
+	prev_cxt  = &handle->prev_cxt[camera_id];
+
+	pthread_mutex_lock(&handle->thread_cxt.prev_mutex);
+	for (i = 0; i < PREV_FRM_CNT; i++) {
+		if (prev_cxt->prev_frm[i].addr_vir.addr_y == in->src_frame.addr_vir.addr_y) {
+			if (prev_cxt->prev_frm_fd_ref[i] && 0 == --prev_cxt->prev_frm_fd_ref[i]) {
+				need_free = prev_cxt->prev_frm_free_pending[i];
+				prev_cxt->prev_frm_free_pending[i] = 0;
+			}
+			break;
+		}
+	}
+	if (PREV_FRM_CNT == i) {
+		for (i = 0; i < PREV_ROT_FRM_CNT; i++) {
+			if (prev_cxt->prev_rot_frm[i].addr_vir.addr_y == in->src_frame.addr_vir.addr_y) {
+				if (prev_cxt->prev_rot_frm_fd_ref[i])
+					prev_cxt->prev_rot_frm_fd_ref[i]--;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&handle->thread_cxt.prev_mutex);
+
+	/*app released it while fd was reading it*/
+	if (need_free && IS_PREVIEW(handle, camera_id)) {
+		CMR_LOGD("free frame 0x%x after fd", i + PREV_ID_BASE);
+		ret = handle->ops.channel_free_frame(handle->oem_handle, prev_cxt->prev_channel_id, i + PREV_ID_BASE);
+		if (ret) {
+			CMR_LOGE("release frm failed");
+		}
+	}
+
+	return ret;
+}
+
 cmr_int prev_fd_cb(cmr_u32 class_type, struct ipm_frame_out *cb_param)
 {
 	cmr_int                         ret = CMR_CAMERA_SUCCESS;
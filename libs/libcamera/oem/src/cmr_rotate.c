@@ -71,24 +71,61 @@ cmr_int cmr_rot_open(cmr_handle *rot_handle)
 
 	fd = open(rot_dev_name, O_RDWR, 0);
 	if (fd < 0) {
-		CMR_LOGE("Fail to open rotation device.");
-		goto rot_free;
+		CMR_LOGE("Fail to open rotation device, rotate by software.");
 	}
 
 	file->fd = fd;
 
 	*rot_handle = (cmr_handle)file;
-	goto open_out;
 
-rot_free:
-	if (file)
-		free(file);
-	file = NULL;
 open_out:
 
 	return ret;
 }
 
+cmr_int cmr_rot_sw(struct cmr_rot_param *rot_param)
+{
+	cmr_int                 ret = CMR_CAMERA_SUCCESS;
+	cmr_u32                 angle;
+	struct cmr_sw_frame     src, dst;
+
+	if (!rot_param || (cmr_u32)rot_param->angle < (cmr_u32)IMG_ANGLE_90) {
+		return -CMR_CAMERA_INVALID_PARAM;
+	}
+
+	ret = cmr_sw_img_frm(&rot_param->src_img, &src);
+	if (!ret)
+		ret = cmr_sw_img_frm(&rot_param->dst_img, &dst);
+	if (ret) {
+		CMR_LOGE("no virtual address or fmt %d", rot_param->src_img.fmt);
+		return ret;
+	}
+
+	/* the rotator takes the size of the source only */
+	angle = rot_param->angle - IMG_ANGLE_90 + CMR_SW_CVT_ROT_90;
+	if (CMR_SW_CVT_ROT_90 == angle || CMR_SW_CVT_ROT_270 == angle) {
+		dst.width = src.height;
+		dst.height = src.width;
+	} else {
+		dst.width = src.width;
+		dst.height = src.height;
+	}
+	dst.stride = dst.width;
+	if (CMR_SW_CVT_PLANAR == dst.layout && !rot_param->dst_img.addr_vir.addr_v)
+		dst.v = dst.u + dst.width * dst.height / 4;
+
+	if (rot_param->flush)
+		rot_param->flush(rot_param->flush_handle, &rot_param->src_img);
+	ret = cmr_sw_rotate(&src, &dst, angle);
+	if (ret) {
+		CMR_LOGE("software rotation failed %ld", ret);
+	} else if (rot_param->flush) {
+		rot_param->flush(rot_param->flush_handle, &rot_param->dst_img);
+	}
+
+	return ret;
+}
+
 cmr_int cmr_rot(struct cmr_rot_param *rot_param)
 {
 	struct _rot_cfg_tag     rot_cfg;
@@ -113,9 +150,11 @@ cmr_int cmr_rot(struct cmr_rot_param *rot_param)
 	}
 
 	fd = file->fd;
-	if (fd < 0) {
-		CMR_LOGE("Invalid Param handle!");
-		ret = -CMR_CAMERA_FAIL;
+	if (fd < 0 || cmr_sw_cvt_forced()) {
+		ret = cmr_rot_sw(rot_param);
+		if (ret) {
+			ret = -CMR_CAMERA_FAIL;
+		}
 		goto rot_exit;
 	}
 
@@ -168,7 +207,10 @@ cmr_int cmr_rot(struct cmr_rot_param *rot_param)
 		CMR_LOGE("src y=%x u=%x v=%x", rot_cfg.src_addr.y_addr, rot_cfg.src_addr.u_addr, rot_cfg.src_addr.v_addr);
 		CMR_LOGE("dst y=%x u=%x v=%x", rot_cfg.dst_addr.y_addr, rot_cfg.dst_addr.u_addr, rot_cfg.dst_addr.v_addr);
 		CMR_LOGE("Unsupported format %d, %d", src_img->fmt, rot_cfg.format);
-		ret = -CMR_CAMERA_FAIL;
+		ret = cmr_rot_sw(rot_param);
+		if (ret) {
+			ret = -CMR_CAMERA_FAIL;
+		}
 		goto rot_exit;
 	}
 
@@ -187,15 +229,10 @@ cmr_int cmr_rot_close(cmr_handle rot_handle)
 	if (!file)
 		goto out;
 
-	if (-1 == file->fd) {
-		CMR_LOGE("Invalid fd");
-		ret = -CMR_CAMERA_FAIL;
-		goto close_free;
+	if (-1 != file->fd) {
+		close(file->fd);
 	}
 
-	close(file->fd);
-
-close_free:
 	free(file);
 out:
 
@@ -18,6 +18,7 @@
 
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include "cutils/properties.h"
 #include "cmr_type.h"
 #include "cmr_msg.h"
 #include "cmr_cvt.h"
@@ -43,12 +44,18 @@ struct scale_file {
 	cmr_int                         err_code;
 	cmr_handle                      scale_thread;
 	sem_t                           sync_sem;
+	cmr_cvt_flush                   flush;
+	cmr_handle                      flush_handle;
 };
 
 struct scale_cfg_param_t{
 	struct scale_frame_param_t      frame_params;
 	cmr_evt_cb                      scale_cb;
 	cmr_handle                      cb_handle;
+	struct img_frm                  src_img;
+	struct img_frm                  dst_img;
+	cmr_uint                        is_sw;
+	cmr_uint                        sw_ok;
 };
 
 static cmr_s8 scaler_dev_name[50] = "/dev/sprd_scale";
@@ -85,6 +92,132 @@ static enum scale_fmt_e cmr_scale_fmt_cvt(cmr_u32 cmt_fmt)
 	return sc_fmt;
 }
 
+cmr_int cmr_sw_img_frm(struct img_frm *img, struct cmr_sw_frame *frame)
+{
+	cmr_u32                 y_size;
+
+	if (!img || !frame || !img->addr_vir.addr_y || !img->addr_vir.addr_u)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	switch (img->fmt) {
+	case IMG_DATA_TYPE_YUV420:
+	case IMG_DATA_TYPE_YVU420:
+		frame->layout = CMR_SW_CVT_SEMIPLANAR;
+		break;
+
+	case IMG_DATA_TYPE_YUV420_3PLANE:
+	case IMG_DATA_TYPE_YV12:
+		frame->layout = CMR_SW_CVT_PLANAR;
+		break;
+
+	default:
+		return -CMR_CAMERA_INVALID_PARAM;
+	}
+
+	y_size = img->size.width * img->size.height;
+	frame->width = img->size.width;
+	frame->height = img->size.height;
+	frame->stride = img->size.width;
+	frame->y = (cmr_u8 *)img->addr_vir.addr_y;
+	frame->u = (cmr_u8 *)img->addr_vir.addr_u;
+	frame->v = NULL;
+	if (CMR_SW_CVT_PLANAR == frame->layout) {
+		if (img->addr_vir.addr_v)
+			frame->v = (cmr_u8 *)img->addr_vir.addr_v;
+		else
+			frame->v = frame->u + y_size / 4;
+	}
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+static cmr_int cmr_scale_sw_frame(struct img_frm *src_img, struct img_frm *dst_img,
+			struct cmr_sw_frame *src, struct cmr_sw_rect *rect, struct cmr_sw_frame *dst)
+{
+	cmr_int                 ret;
+
+	ret = cmr_sw_img_frm(src_img, src);
+	if (!ret)
+		ret = cmr_sw_img_frm(dst_img, dst);
+	if (ret)
+		return ret;
+
+	if (src_img->rect.width && src_img->rect.height) {
+		rect->x = src_img->rect.start_x;
+		rect->y = src_img->rect.start_y;
+		rect->w = src_img->rect.width;
+		rect->h = src_img->rect.height;
+	} else {
+		rect->x = 0;
+		rect->y = 0;
+		rect->w = src->width;
+		rect->h = src->height;
+	}
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+cmr_int cmr_scale_sw(struct img_frm *src_img, struct img_frm *dst_img, cmr_uint is_check)
+{
+	cmr_int                 ret;
+	struct cmr_sw_frame     src, dst;
+	struct cmr_sw_rect      rect;
+
+	ret = cmr_scale_sw_frame(src_img, dst_img, &src, &rect, &dst);
+	if (ret)
+		return ret;
+
+	if (is_check)
+		return cmr_sw_scale_check(&src, &rect, &dst);
+
+	return cmr_sw_scale(&src, &rect, &dst);
+}
+
+cmr_uint cmr_sw_cvt_forced(void)
+{
+	char                    value[PROPERTY_VALUE_MAX];
+
+	property_get("debug.camera.sw.cvt", value, "0");
+
+	return !strcmp(value, "1");
+}
+
+/* the request was checked by cmr_scale_start, is_posted tells the start
+ * was already reported to the caller by a failed hardware done */
+static void cmr_scale_sw_proc(struct scale_file *file, struct scale_cfg_param_t *cfg_params,
+			cmr_uint is_posted)
+{
+	cmr_int               ret = CMR_CAMERA_SUCCESS;
+	struct img_frm        frame;
+
+	CMR_LOGI("scale by software");
+	if (!is_posted) {
+		file->err_code = CMR_CAMERA_SUCCESS;
+		if (cfg_params->scale_cb) {
+			cmr_sem_post(&file->sync_sem);
+		}
+	}
+
+	if (file->flush)
+		file->flush(file->flush_handle, &cfg_params->src_img);
+	ret = cmr_scale_sw(&cfg_params->src_img, &cfg_params->dst_img, 0);
+	if (ret) {
+		CMR_LOGE("scale error: software %ld", ret);
+		file->err_code = CMR_CAMERA_FAIL;
+		return;
+	}
+	if (file->flush)
+		file->flush(file->flush_handle, &cfg_params->dst_img);
+
+	if (cfg_params->scale_cb) {
+		memset((void *)&frame, 0x00, sizeof(frame));
+		frame.size = cfg_params->dst_img.size;
+		frame.addr_phy = cfg_params->dst_img.addr_phy;
+		frame.addr_vir = cfg_params->dst_img.addr_vir;
+		(*cfg_params->scale_cb)(CMR_IMG_CVT_SC_DONE, &frame, cfg_params->cb_handle);
+	}
+}
+
 static cmr_int cmr_scale_thread_proc(struct cmr_msg *message, void *private_data)
 {
 	cmr_int               ret = CMR_CAMERA_SUCCESS;
@@ -97,11 +230,6 @@ static cmr_int cmr_scale_thread_proc(struct cmr_msg *message, void *private_data
 		return CMR_CAMERA_INVALID_PARAM;
 	}
 
-	if (-1 == file->handle) {
-		CMR_LOGE("scale error: handle is invalid");
-		return CMR_CAMERA_INVALID_PARAM;
-	}
-
 	CMR_LOGV("scale message.msg_type 0x%x, data 0x%x", message->msg_type, (uint32_t)message->data);
 
 	evt = (cmr_u32)message->msg_type;
@@ -118,12 +246,21 @@ static cmr_int cmr_scale_thread_proc(struct cmr_msg *message, void *private_data
 		struct scale_cfg_param_t *cfg_params = (struct scale_cfg_param_t *)message->data;
 		struct scale_frame_param_t *frame_params = &cfg_params->frame_params;
 
+		if (-1 == file->handle || cfg_params->is_sw) {
+			cmr_scale_sw_proc(file, cfg_params, 0);
+			break;
+		}
+
 		while ((restart_cnt < SCALE_RESTART_SUM) && (CMR_CAMERA_SUCCESS == file->err_code)) {
 			file->err_code = CMR_CAMERA_SUCCESS;
 			ret = ioctl(file->handle, SCALE_IO_START, frame_params);
 			if (ret) {
 				CMR_PERROR;
 				CMR_LOGE("scale error: start");
+				if (cfg_params->sw_ok) {
+					cmr_scale_sw_proc(file, cfg_params, 0);
+					break;
+				}
 			}
 			CMR_LOGI("scale started");
 
@@ -138,7 +275,10 @@ static cmr_int cmr_scale_thread_proc(struct cmr_msg *message, void *private_data
 				if (ret) {
 					CMR_LOGE("scale done error");
 					ret = cmr_scale_restart(file);
-					if (ret) {
+					if (cfg_params->sw_ok) {
+						cmr_scale_sw_proc(file, cfg_params, 1);
+						break;
+					} else if (ret) {
 						file->err_code = CMR_CAMERA_FAIL;
 					} else {
 						restart_cnt++;
@@ -296,9 +436,8 @@ cmr_int cmr_scale_open(cmr_handle *scale_handle)
 		}
 	};
 
-	if (0 == time_out) {
-		CMR_LOGE("scale error: open device");
-		goto free_file;
+	if (-1 == fd) {
+		CMR_LOGE("scale error: open device, scale by software");
 	}
 
 	file->handle = fd;
@@ -315,8 +454,8 @@ cmr_int cmr_scale_open(cmr_handle *scale_handle)
 	goto exit;
 
 free_cb:
-	close(fd);
-free_file:
+	if (-1 != fd)
+		close(fd);
 	if(file)
 		free(file);
 	file = NULL;
@@ -325,6 +464,21 @@ exit:
 	return ret;
 }
 
+cmr_int cmr_scale_set_flush(cmr_handle scale_handle, cmr_cvt_flush flush, cmr_handle flush_handle)
+{
+	struct scale_file       *file = (struct scale_file*)(scale_handle);
+
+	if (!file) {
+		CMR_LOGE("scale error: file hand is null");
+		return CMR_CAMERA_INVALID_PARAM;
+	}
+
+	file->flush = flush;
+	file->flush_handle = flush_handle;
+
+	return CMR_CAMERA_SUCCESS;
+}
+
 cmr_int cmr_scale_start(cmr_handle scale_handle, struct img_frm *src_img,
 			struct img_frm *dst_img, cmr_evt_cb cmr_event_cb, cmr_handle cb_handle)
 {
@@ -352,6 +506,16 @@ cmr_int cmr_scale_start(cmr_handle scale_handle, struct img_frm *src_img,
 	frame_params = &cfg_params->frame_params;
 	cfg_params->scale_cb = cmr_event_cb;
 	cfg_params->cb_handle = cb_handle;
+	cfg_params->src_img = *src_img;
+	cfg_params->dst_img = *dst_img;
+	cfg_params->sw_ok = !cmr_scale_sw(src_img, dst_img, 1);
+	cfg_params->is_sw = -1 == file->handle || cmr_sw_cvt_forced();
+	if (cfg_params->is_sw && !cfg_params->sw_ok) {
+		CMR_LOGE("scale error: software can't do fmt %d %d, size %d %d",
+			src_img->fmt, dst_img->fmt, dst_img->size.width, dst_img->size.height);
+		ret = CMR_CAMERA_INVALID_PARAM;
+		goto free_frame;
+	}
 
 	/*set scale input parameters*/
 	memcpy((void*)&frame_params->input_size, (void*)&src_img->size,
@@ -0,0 +1,1156 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "cmr_sw_cvt.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum sw_axis_mode {
+	SW_AXIS_COPY = 0,
+	SW_AXIS_BILINEAR,
+	SW_AXIS_AREA
+};
+
+/*
+ * Source taps of every output coordinate of one axis. Bilinear takes i0
+ * and i1 with w / 256 of i1, area averages n pixels from i0 with w the
+ * reciprocal of n by 65536. half is set when every n is 2.
+ */
+struct sw_axis {
+	cmr_u32                         mode;
+	cmr_u32                         half;
+	cmr_u32                         *i0;
+	cmr_u32                         *n;
+	cmr_u32                         *w;
+};
+
+/* one component of a plane: its byte in a source pixel, where it goes */
+struct sw_chan {
+	cmr_u32                         src_off;
+	cmr_u8                          *dst;
+	cmr_u32                         dst_step;
+};
+
+struct sw_plane {
+	const cmr_u8                    *src;
+	cmr_u32                         src_stride;
+	cmr_u32                         src_step;
+	cmr_u32                         src_w;
+	cmr_u32                         dst_w;
+	cmr_u32                         dst_stride;
+	/* 1 for the luma plane, 2 for chroma, rows are bands / sub */
+	cmr_u32                         sub;
+	/* the dst row has the bytes of the src row */
+	cmr_u32                         same;
+	cmr_u32                         chan_num;
+	struct sw_chan                  chan[2];
+	const struct sw_axis            *h;
+	const struct sw_axis            *v;
+};
+
+struct sw_rot_plane {
+	const cmr_u8                    *src;
+	cmr_u32                         src_stride;
+	cmr_u8                          *dst;
+	cmr_u32                         dst_stride;
+	cmr_u32                         w;
+	cmr_u32                         h;
+	/* bytes per element, 2 moves the u v pairs together */
+	cmr_u32                         size;
+	cmr_u32                         sub;
+};
+
+struct sw_job {
+	void                            (*run)(struct sw_job *job, cmr_u32 start, cmr_u32 end);
+	cmr_u32                         plane_num;
+	struct sw_plane                 plane[3];
+	struct sw_rot_plane             rot[3];
+	cmr_u32                         angle;
+	/* bytes of the widest source row */
+	cmr_u32                         line_size;
+	cmr_int                         err;
+};
+
+struct sw_band {
+	struct sw_job                   *job;
+	cmr_u32                         start;
+	cmr_u32                         end;
+};
+
+/*
+ * Workers started on the first split job and kept for the life of the
+ * process, worker i takes band i of a job, the calling thread band 0.
+ * One job runs at a time, a job that finds the pool busy runs in the
+ * calling thread.
+ */
+struct sw_pool {
+	pthread_mutex_t                 run_lock;
+	pthread_mutex_t                 lock;
+	pthread_cond_t                  work_cond;
+	pthread_cond_t                  done_cond;
+	cmr_u32                         worker_num;
+	cmr_u32                         generation;
+	cmr_u32                         pending;
+	cmr_u32                         band_num;
+	struct sw_band                  *band;
+};
+
+struct sw_worker {
+	cmr_u32                         index;
+	cmr_u32                         generation;
+};
+
+static struct sw_pool s_sw_pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	0, 0, 0, 0, NULL
+};
+static struct sw_worker s_sw_worker[CMR_SW_CVT_THREAD_MAX];
+
+static cmr_u32 s_sw_use_simd = 1;
+static cmr_u32 s_sw_threads = CMR_SW_CVT_THREAD_MAX;
+
+void cmr_sw_cvt_config(cmr_u32 use_simd, cmr_u32 threads)
+{
+	s_sw_use_simd = use_simd;
+	s_sw_threads = threads ? threads : CMR_SW_CVT_THREAD_MAX;
+}
+
+#if CMR_SW_CVT_SIMD
+static cmr_u32 sw_simd(void)
+{
+	return s_sw_use_simd;
+}
+#endif
+
+/* ---------------------------------------------------------------- threads */
+
+static cmr_u32 sw_thread_num(cmr_u32 pixels)
+{
+	long cpus;
+	cmr_u32 num = s_sw_threads;
+
+	if (pixels < CMR_SW_CVT_THREAD_PIXELS)
+		return 1;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 0 && (cmr_u32)cpus < num)
+		num = (cmr_u32)cpus;
+	if (num > CMR_SW_CVT_THREAD_MAX)
+		num = CMR_SW_CVT_THREAD_MAX;
+
+	return num ? num : 1;
+}
+
+static void *sw_worker_proc(void *data)
+{
+	struct sw_worker *worker = (struct sw_worker *)data;
+	struct sw_pool *pool = &s_sw_pool;
+	struct sw_band *band;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (pool->generation == worker->generation)
+			pthread_cond_wait(&pool->work_cond, &pool->lock);
+		worker->generation = pool->generation;
+		band = worker->index < pool->band_num ? &pool->band[worker->index] : NULL;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (NULL == band)
+			continue;
+
+		band->job->run(band->job, band->start, band->end);
+
+		pthread_mutex_lock(&pool->lock);
+		if (0 == --pool->pending)
+			pthread_cond_signal(&pool->done_cond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+/* start workers up to num - 1 with run_lock held, returns how many run */
+static cmr_u32 sw_pool_start(struct sw_pool *pool, cmr_u32 num)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	while (pool->worker_num + 1 < num) {
+		struct sw_worker *worker = &s_sw_worker[pool->worker_num + 1];
+
+		pthread_mutex_lock(&pool->lock);
+		worker->index = pool->worker_num + 1;
+		worker->generation = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (pthread_create(&thread, &attr, sw_worker_proc, worker))
+			break;
+		pool->worker_num++;
+	}
+
+	pthread_attr_destroy(&attr);
+	return pool->worker_num;
+}
+
+/*
+ * Split rows into bands of a multiple of align and run them on up to
+ * sw_thread_num() threads of the pool, the calling one taking the first
+ * band and those the pool has no worker for.
+ */
+static cmr_int sw_job_run(struct sw_job *job, cmr_u32 rows, cmr_u32 align, cmr_u32 pixels)
+{
+	struct sw_pool *pool = &s_sw_pool;
+	struct sw_band band[CMR_SW_CVT_THREAD_MAX];
+	cmr_u32 num = sw_thread_num(pixels);
+	cmr_u32 workers = 0;
+	cmr_u32 size, i;
+
+	if (num > 1 && pthread_mutex_trylock(&pool->run_lock))
+		num = 1;
+
+	size = (rows + num - 1) / num;
+	size = (size + align - 1) / align * align;
+
+	for (i = 0; i < num; i++) {
+		band[i].job = job;
+		band[i].start = i * size < rows ? i * size : rows;
+		band[i].end = band[i].start + size < rows ? band[i].start + size : rows;
+	}
+
+	if (num > 1) {
+		workers = sw_pool_start(pool, num);
+		if (workers > num - 1)
+			workers = num - 1;
+
+		pthread_mutex_lock(&pool->lock);
+		pool->band = band;
+		pool->band_num = workers + 1;
+		pool->pending = workers;
+		pool->generation++;
+		pthread_cond_broadcast(&pool->work_cond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	job->run(job, band[0].start, band[0].end);
+	for (i = workers + 1; i < num; i++)
+		job->run(job, band[i].start, band[i].end);
+
+	if (num > 1) {
+		pthread_mutex_lock(&pool->lock);
+		while (pool->pending)
+			pthread_cond_wait(&pool->done_cond, &pool->lock);
+		pool->band = NULL;
+		pool->band_num = 0;
+		pthread_mutex_unlock(&pool->lock);
+		pthread_mutex_unlock(&pool->run_lock);
+	}
+
+	return job->err;
+}
+
+/* ------------------------------------------------------------ row kernels */
+
+static void sw_v_bilinear_c(const cmr_u8 *a, const cmr_u8 *b, cmr_u32 f,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	cmr_u32 i;
+
+	for (i = 0; i < bytes; i++)
+		dst[i] = (cmr_u8)((a[i] * (256 - f) + b[i] * f + 128) >> 8);
+}
+
+static void sw_v_area_c(const cmr_u8 *src, cmr_u32 stride, cmr_u32 n, cmr_u32 recip,
+			cmr_u8 *dst, cmr_u32 bytes, cmr_u32 *sum)
+{
+	cmr_u32 i, r, v;
+	cmr_u32 half = n >> 1;
+	const cmr_u8 *row = src;
+
+	for (i = 0; i < bytes; i++)
+		sum[i] = row[i];
+	for (r = 1; r < n; r++) {
+		row += stride;
+		for (i = 0; i < bytes; i++)
+			sum[i] += row[i];
+	}
+	for (i = 0; i < bytes; i++) {
+		v = ((sum[i] + half) * recip) >> 16;
+		dst[i] = (cmr_u8)(v > 255 ? 255 : v);
+	}
+}
+
+/* w pixels of step bytes, each the rounded mean of two source pixels */
+static void sw_h_half_c(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 w, cmr_u32 step)
+{
+	cmr_u32 x, c;
+
+	for (x = 0; x < w; x++) {
+		for (c = 0; c < step; c++)
+			dst[x * step + c] = (cmr_u8)((src[2 * x * step + c]
+				+ src[(2 * x + 1) * step + c] + 1) >> 1);
+	}
+}
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+static cmr_u32 sw_v_bilinear_simd(const cmr_u8 *a, const cmr_u8 *b, cmr_u32 f,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	uint8x8_t wa = vdup_n_u8((cmr_u8)(256 - f));
+	uint8x8_t wb = vdup_n_u8((cmr_u8)f);
+	uint8x16_t va, vb;
+	uint16x8_t lo, hi;
+	cmr_u32 i;
+
+	for (i = 0; i + 16 <= bytes; i += 16) {
+		va = vld1q_u8(a + i);
+		vb = vld1q_u8(b + i);
+		lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+		hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+		vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+	}
+
+	return i;
+}
+
+static cmr_u32 sw_v_area_simd(const cmr_u8 *src, cmr_u32 stride, cmr_u32 n, cmr_u32 recip,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	uint16x8_t half = vdupq_n_u16((cmr_u16)(n >> 1));
+	uint16x4_t rv = vdup_n_u16((cmr_u16)recip);
+	uint16x8_t lo, hi;
+	uint8x16_t p;
+	const cmr_u8 *row;
+	cmr_u32 i, r;
+
+	for (i = 0; i + 16 <= bytes; i += 16) {
+		row = src + i;
+		lo = vdupq_n_u16(0);
+		hi = lo;
+		for (r = 0; r < n; r++) {
+			p = vld1q_u8(row);
+			lo = vaddw_u8(lo, vget_low_u8(p));
+			hi = vaddw_u8(hi, vget_high_u8(p));
+			row += stride;
+		}
+		lo = vaddq_u16(lo, half);
+		hi = vaddq_u16(hi, half);
+		lo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(lo), rv), 16),
+			vshrn_n_u32(vmull_u16(vget_high_u16(lo), rv), 16));
+		hi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(hi), rv), 16),
+			vshrn_n_u32(vmull_u16(vget_high_u16(hi), rv), 16));
+		vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi)));
+	}
+
+	return i;
+}
+
+static cmr_u32 sw_h_half_simd(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 w, cmr_u32 step)
+{
+	uint8x16x2_t p;
+	uint8x8x4_t q;
+	uint8x8x2_t o;
+	cmr_u32 x = 0;
+
+	if (1 == step) {
+		for (; x + 16 <= w; x += 16) {
+			p = vld2q_u8(src + 2 * x);
+			vst1q_u8(dst + x, vrhaddq_u8(p.val[0], p.val[1]));
+		}
+	} else {
+		for (; x + 8 <= w; x += 8) {
+			q = vld4_u8(src + 4 * x);
+			o.val[0] = vrhadd_u8(q.val[0], q.val[2]);
+			o.val[1] = vrhadd_u8(q.val[1], q.val[3]);
+			vst2_u8(dst + 2 * x, o);
+		}
+	}
+
+	return x;
+}
+
+#elif defined(__SSE2__)
+
+static cmr_u32 sw_v_bilinear_simd(const cmr_u8 *a, const cmr_u8 *b, cmr_u32 f,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	__m128i wa = _mm_set1_epi16((short)(256 - f));
+	__m128i wb = _mm_set1_epi16((short)f);
+	__m128i round = _mm_set1_epi16(128);
+	__m128i zero = _mm_setzero_si128();
+	__m128i va, vb, lo, hi;
+	cmr_u32 i;
+
+	for (i = 0; i + 16 <= bytes; i += 16) {
+		va = _mm_loadu_si128((const __m128i *)(a + i));
+		vb = _mm_loadu_si128((const __m128i *)(b + i));
+		lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+		hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+static cmr_u32 sw_v_area_simd(const cmr_u8 *src, cmr_u32 stride, cmr_u32 n, cmr_u32 recip,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	__m128i half = _mm_set1_epi16((short)(n >> 1));
+	__m128i rv = _mm_set1_epi16((short)recip);
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo, hi, p;
+	const cmr_u8 *row;
+	cmr_u32 i, r;
+
+	for (i = 0; i + 16 <= bytes; i += 16) {
+		row = src + i;
+		lo = zero;
+		hi = zero;
+		for (r = 0; r < n; r++) {
+			p = _mm_loadu_si128((const __m128i *)row);
+			lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(p, zero));
+			hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(p, zero));
+			row += stride;
+		}
+		lo = _mm_mulhi_epu16(_mm_add_epi16(lo, half), rv);
+		hi = _mm_mulhi_epu16(_mm_add_epi16(hi, half), rv);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+/* the even and odd bytes, or u v pairs, are sign extended so the signed
+ * pack keeps them as they are */
+static cmr_u32 sw_h_half_simd(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 w, cmr_u32 step)
+{
+	__m128i a, b, even, odd;
+	cmr_u32 x = 0;
+
+	if (1 == step) {
+		for (; x + 16 <= w; x += 16) {
+			a = _mm_loadu_si128((const __m128i *)(src + 2 * x));
+			b = _mm_loadu_si128((const __m128i *)(src + 2 * x + 16));
+			even = _mm_packs_epi16(_mm_srai_epi16(_mm_slli_epi16(a, 8), 8),
+				_mm_srai_epi16(_mm_slli_epi16(b, 8), 8));
+			odd = _mm_packs_epi16(_mm_srai_epi16(a, 8), _mm_srai_epi16(b, 8));
+			_mm_storeu_si128((__m128i *)(dst + x), _mm_avg_epu8(even, odd));
+		}
+	} else {
+		for (; x + 8 <= w; x += 8) {
+			a = _mm_loadu_si128((const __m128i *)(src + 4 * x));
+			b = _mm_loadu_si128((const __m128i *)(src + 4 * x + 16));
+			even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+				_mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+			odd = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+			_mm_storeu_si128((__m128i *)(dst + 2 * x), _mm_avg_epu8(even, odd));
+		}
+	}
+
+	return x;
+}
+
+#endif
+
+static void sw_v_bilinear(const cmr_u8 *a, const cmr_u8 *b, cmr_u32 f,
+			cmr_u8 *dst, cmr_u32 bytes)
+{
+	cmr_u32 i = 0;
+
+#if CMR_SW_CVT_SIMD
+	if (sw_simd())
+		i = sw_v_bilinear_simd(a, b, f, dst, bytes);
+#endif
+	sw_v_bilinear_c(a + i, b + i, f, dst + i, bytes - i);
+}
+
+/* the 16 bit sums of the simd code hold up to 256 rows */
+static void sw_v_area(const cmr_u8 *src, cmr_u32 stride, cmr_u32 n, cmr_u32 recip,
+			cmr_u8 *dst, cmr_u32 bytes, cmr_u32 *sum)
+{
+	cmr_u32 i = 0;
+
+#if CMR_SW_CVT_SIMD
+	if (sw_simd() && n <= 256)
+		i = sw_v_area_simd(src, stride, n, recip, dst, bytes);
+#endif
+	if (i < bytes)
+		sw_v_area_c(src + i, stride, n, recip, dst + i, bytes - i, sum);
+}
+
+static void sw_h_half(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 w, cmr_u32 step)
+{
+	cmr_u32 x = 0;
+
+#if CMR_SW_CVT_SIMD
+	if (sw_simd())
+		x = sw_h_half_simd(src, dst, w, step);
+#endif
+	sw_h_half_c(src + 2 * x * step, dst + x * step, w - x, step);
+}
+
+static void sw_h_pass(const struct sw_axis *h, const cmr_u8 *row, cmr_u32 step,
+			cmr_u32 off, cmr_u8 *dst, cmr_u32 dst_step, cmr_u32 w)
+{
+	cmr_u32 x, k, sum, v;
+	const cmr_u8 *p;
+
+	row += off;
+	switch (h->mode) {
+	case SW_AXIS_BILINEAR:
+		for (x = 0; x < w; x++) {
+			v = h->w[x];
+			dst[x * dst_step] = (cmr_u8)((row[h->i0[x] * step] * (256 - v)
+				+ row[h->n[x] * step] * v + 128) >> 8);
+		}
+		break;
+
+	case SW_AXIS_AREA:
+		for (x = 0; x < w; x++) {
+			p = row + h->i0[x] * step;
+			sum = 0;
+			for (k = 0; k < h->n[x]; k++)
+				sum += p[k * step];
+			v = ((sum + (h->n[x] >> 1)) * h->w[x]) >> 16;
+			dst[x * dst_step] = (cmr_u8)(v > 255 ? 255 : v);
+		}
+		break;
+
+	default:
+		for (x = 0; x < w; x++)
+			dst[x * dst_step] = row[x * step];
+		break;
+	}
+}
+
+/* ------------------------------------------------------------------ scale */
+
+static void sw_axis_free(struct sw_axis *axis)
+{
+	if (axis->i0)
+		free(axis->i0);
+	memset(axis, 0, sizeof(*axis));
+}
+
+static cmr_int sw_axis_init(struct sw_axis *axis, cmr_u32 src_len, cmr_u32 dst_len)
+{
+	cmr_u32 i, end;
+	cmr_s64 pos;
+
+	memset(axis, 0, sizeof(*axis));
+	if (src_len == dst_len)
+		return CMR_CAMERA_SUCCESS;
+
+	axis->i0 = (cmr_u32 *)malloc(3 * dst_len * sizeof(cmr_u32));
+	if (!axis->i0)
+		return -CMR_CAMERA_NO_MEM;
+	axis->n = axis->i0 + dst_len;
+	axis->w = axis->n + dst_len;
+
+	if (src_len >= 2 * dst_len) {
+		axis->mode = SW_AXIS_AREA;
+		for (i = 0; i < dst_len; i++) {
+			axis->i0[i] = (cmr_u32)((cmr_u64)i * src_len / dst_len);
+			end = (cmr_u32)((cmr_u64)(i + 1) * src_len / dst_len);
+			axis->n[i] = end - axis->i0[i];
+			axis->w[i] = (65536 + (axis->n[i] >> 1)) / axis->n[i];
+		}
+		axis->half = src_len == 2 * dst_len;
+	} else {
+		/* pixel centres line up, positions by 1/256 */
+		axis->mode = SW_AXIS_BILINEAR;
+		for (i = 0; i < dst_len; i++) {
+			pos = (cmr_s64)(2 * i + 1) * src_len * 128 / dst_len - 128;
+			if (pos < 0)
+				pos = 0;
+			axis->i0[i] = (cmr_u32)(pos >> 8);
+			axis->w[i] = (cmr_u32)(pos & 0xff);
+			if (axis->i0[i] >= src_len - 1) {
+				axis->i0[i] = src_len - 1;
+				axis->w[i] = 0;
+			}
+			axis->n[i] = axis->i0[i] + 1 < src_len ? axis->i0[i] + 1 : axis->i0[i];
+		}
+	}
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+
+static void sw_scale_plane(const struct sw_plane *p, cmr_u32 start, cmr_u32 end,
+			cmr_u8 *line, cmr_u32 *sum)
+{
+	const struct sw_axis *v = p->v;
+	cmr_u32 bytes = p->src_w * p->src_step;
+	cmr_u32 y, c;
+	const cmr_u8 *row;
+
+	for (y = start / p->sub; y < end / p->sub; y++) {
+		switch (v->mode) {
+		case SW_AXIS_BILINEAR:
+			row = p->src + v->i0[y] * p->src_stride;
+			if (v->w[y]) {
+				sw_v_bilinear(row, p->src + v->n[y] * p->src_stride, v->w[y], line, bytes);
+				row = line;
+			}
+			break;
+
+		case SW_AXIS_AREA:
+			sw_v_area(p->src + v->i0[y] * p->src_stride, p->src_stride,
+				v->n[y], v->w[y], line, bytes, sum);
+			row = line;
+			break;
+
+		default:
+			row = p->src + y * p->src_stride;
+			break;
+		}
+
+		if (SW_AXIS_COPY == p->h->mode && p->same) {
+			memcpy(p->chan[0].dst + y * p->dst_stride, row, bytes);
+			continue;
+		}
+		if (p->h->half && p->same) {
+			sw_h_half(row, p->chan[0].dst + y * p->dst_stride, p->dst_w, p->src_step);
+			continue;
+		}
+		for (c = 0; c < p->chan_num; c++) {
+			sw_h_pass(p->h, row, p->src_step, p->chan[c].src_off,
+				p->chan[c].dst + y * p->dst_stride, p->chan[c].dst_step, p->dst_w);
+		}
+	}
+}
+
+static void sw_scale_run(struct sw_job *job, cmr_u32 start, cmr_u32 end)
+{
+	cmr_u32 *sum;
+	cmr_u32 i;
+
+	sum = (cmr_u32 *)malloc(job->line_size * (sizeof(cmr_u32) + 1));
+	if (!sum) {
+		job->err = -CMR_CAMERA_NO_MEM;
+		return;
+	}
+
+	for (i = 0; i < job->plane_num; i++)
+		sw_scale_plane(&job->plane[i], start, end, (cmr_u8 *)(sum + job->line_size), sum);
+
+	free(sum);
+}
+
+static cmr_int sw_frame_check(const struct cmr_sw_frame *frame)
+{
+	if (!frame || !frame->y || !frame->u || frame->layout >= CMR_SW_CVT_LAYOUT_MAX)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	if (CMR_SW_CVT_PLANAR == frame->layout && !frame->v)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	if (!frame->width || !frame->height || ((frame->width | frame->height | frame->stride) & 1)
+		|| frame->stride < frame->width)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+cmr_int cmr_sw_scale_check(const struct cmr_sw_frame *src, const struct cmr_sw_rect *rect,
+			const struct cmr_sw_frame *dst)
+{
+	if (sw_frame_check(src) || sw_frame_check(dst) || !rect)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	if (!rect->w || !rect->h || ((rect->x | rect->y | rect->w | rect->h) & 1)
+		|| rect->x + rect->w > src->width || rect->y + rect->h > src->height
+		|| rect->x + rect->w < rect->x || rect->y + rect->h < rect->y)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+static void sw_plane_set(struct sw_plane *p, const cmr_u8 *src, cmr_u32 src_stride,
+			cmr_u32 src_step, cmr_u32 src_w, cmr_u32 dst_w, cmr_u32 dst_stride,
+			cmr_u32 sub, const struct sw_axis *axis)
+{
+	p->src = src;
+	p->src_stride = src_stride;
+	p->src_step = src_step;
+	p->src_w = src_w;
+	p->dst_w = dst_w;
+	p->dst_stride = dst_stride;
+	p->sub = sub;
+	p->h = &axis[0];
+	p->v = &axis[1];
+}
+
+static void sw_plane_chan(struct sw_plane *p, cmr_u32 src_off, cmr_u8 *dst, cmr_u32 dst_step)
+{
+	p->chan[p->chan_num].src_off = src_off;
+	p->chan[p->chan_num].dst = dst;
+	p->chan[p->chan_num].dst_step = dst_step;
+	p->chan_num++;
+	p->same = 1 == p->chan_num ? p->src_step == dst_step
+		: p->same && 2 == dst_step && dst == p->chan[0].dst + 1;
+}
+
+cmr_int cmr_sw_scale(const struct cmr_sw_frame *src, const struct cmr_sw_rect *rect,
+			const struct cmr_sw_frame *dst)
+{
+	cmr_int ret;
+	struct sw_axis axis[4];
+	struct sw_job job;
+	struct sw_plane *p;
+	cmr_u32 semi = CMR_SW_CVT_SEMIPLANAR == dst->layout;
+	cmr_u32 c_stride, c_off, src_pixels, dst_pixels, i;
+
+	ret = cmr_sw_scale_check(src, rect, dst);
+	if (ret)
+		return ret;
+
+	memset(&job, 0, sizeof(job));
+	memset(axis, 0, sizeof(axis));
+	ret = sw_axis_init(&axis[0], rect->w, dst->width);
+	if (!ret)
+		ret = sw_axis_init(&axis[1], rect->h, dst->height);
+	if (!ret)
+		ret = sw_axis_init(&axis[2], rect->w / 2, dst->width / 2);
+	if (!ret)
+		ret = sw_axis_init(&axis[3], rect->h / 2, dst->height / 2);
+	if (ret)
+		goto exit;
+
+	p = &job.plane[0];
+	sw_plane_set(p, src->y + rect->y * src->stride + rect->x, src->stride, 1,
+		rect->w, dst->width, dst->stride, 1, &axis[0]);
+	sw_plane_chan(p, 0, dst->y, 1);
+
+	if (CMR_SW_CVT_SEMIPLANAR == src->layout) {
+		c_off = rect->y / 2 * src->stride + rect->x;
+		p = &job.plane[1];
+		sw_plane_set(p, src->u + c_off, src->stride, 2, rect->w / 2, dst->width / 2,
+			semi ? dst->stride : dst->stride / 2, 2, &axis[2]);
+		sw_plane_chan(p, 0, dst->u, semi ? 2 : 1);
+		sw_plane_chan(p, 1, semi ? dst->u + 1 : dst->v, semi ? 2 : 1);
+		job.plane_num = 2;
+	} else {
+		c_stride = src->stride / 2;
+		c_off = rect->y / 2 * c_stride + rect->x / 2;
+		for (i = 1; i < 3; i++) {
+			p = &job.plane[i];
+			sw_plane_set(p, (1 == i ? src->u : src->v) + c_off, c_stride, 1,
+				rect->w / 2, dst->width / 2,
+				semi ? dst->stride : dst->stride / 2, 2, &axis[2]);
+			if (semi)
+				sw_plane_chan(p, 0, dst->u + i - 1, 2);
+			else
+				sw_plane_chan(p, 0, 1 == i ? dst->u : dst->v, 1);
+		}
+		job.plane_num = 3;
+	}
+
+	job.run = sw_scale_run;
+	job.line_size = rect->w;
+	src_pixels = rect->w * rect->h;
+	dst_pixels = dst->width * dst->height;
+	ret = sw_job_run(&job, dst->height, 2, src_pixels > dst_pixels ? src_pixels : dst_pixels);
+
+exit:
+	for (i = 0; i < 4; i++)
+		sw_axis_free(&axis[i]);
+	return ret;
+}
+
+/* --------------------------------------------------------------- rotation */
+
+static void sw_elem_copy(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 size)
+{
+	dst[0] = src[0];
+	if (2 == size)
+		dst[1] = src[1];
+}
+
+/* dst row i is src column i of 8 rows, strides may be negative */
+static void sw_transpose8_c(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride, cmr_u32 size)
+{
+	cmr_u32 i, k;
+
+	for (i = 0; i < 8; i++) {
+		for (k = 0; k < 8; k++)
+			sw_elem_copy(src + k * src_stride + i * size, dst + i * dst_stride + k * size, size);
+	}
+}
+
+static void sw_reverse_c(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 n, cmr_u32 size)
+{
+	cmr_u32 i;
+
+	for (i = 0; i < n; i++)
+		sw_elem_copy(src + i * size, dst + (n - 1 - i) * size, size);
+}
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+static void sw_transpose8_u8_simd(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride)
+{
+	uint8x8x2_t t01, t23, t45, t67;
+	uint16x4x2_t u02, u13, u46, u57;
+	uint32x2x2_t v04, v15, v26, v37;
+
+	t01 = vtrn_u8(vld1_u8(src), vld1_u8(src + src_stride));
+	t23 = vtrn_u8(vld1_u8(src + 2 * src_stride), vld1_u8(src + 3 * src_stride));
+	t45 = vtrn_u8(vld1_u8(src + 4 * src_stride), vld1_u8(src + 5 * src_stride));
+	t67 = vtrn_u8(vld1_u8(src + 6 * src_stride), vld1_u8(src + 7 * src_stride));
+
+	u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+	u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+	u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+	u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+
+	v04 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]), vreinterpret_u32_u16(u46.val[0]));
+	v15 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]), vreinterpret_u32_u16(u57.val[0]));
+	v26 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]), vreinterpret_u32_u16(u46.val[1]));
+	v37 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]), vreinterpret_u32_u16(u57.val[1]));
+
+	vst1_u8(dst, vreinterpret_u8_u32(v04.val[0]));
+	vst1_u8(dst + dst_stride, vreinterpret_u8_u32(v15.val[0]));
+	vst1_u8(dst + 2 * dst_stride, vreinterpret_u8_u32(v26.val[0]));
+	vst1_u8(dst + 3 * dst_stride, vreinterpret_u8_u32(v37.val[0]));
+	vst1_u8(dst + 4 * dst_stride, vreinterpret_u8_u32(v04.val[1]));
+	vst1_u8(dst + 5 * dst_stride, vreinterpret_u8_u32(v15.val[1]));
+	vst1_u8(dst + 6 * dst_stride, vreinterpret_u8_u32(v26.val[1]));
+	vst1_u8(dst + 7 * dst_stride, vreinterpret_u8_u32(v37.val[1]));
+}
+
+static void sw_transpose8_u16_simd(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride)
+{
+	uint16x8x2_t t01, t23, t45, t67;
+	uint32x4x2_t u02, u13, u46, u57;
+
+#define SW_LD16(k) vreinterpretq_u16_u8(vld1q_u8(src + (k) * src_stride))
+	t01 = vtrnq_u16(SW_LD16(0), SW_LD16(1));
+	t23 = vtrnq_u16(SW_LD16(2), SW_LD16(3));
+	t45 = vtrnq_u16(SW_LD16(4), SW_LD16(5));
+	t67 = vtrnq_u16(SW_LD16(6), SW_LD16(7));
+#undef SW_LD16
+
+	u02 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]), vreinterpretq_u32_u16(t23.val[0]));
+	u13 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]), vreinterpretq_u32_u16(t23.val[1]));
+	u46 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]), vreinterpretq_u32_u16(t67.val[0]));
+	u57 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]), vreinterpretq_u32_u16(t67.val[1]));
+
+#define SW_ST16(k, a, b, half) vst1q_u8(dst + (k) * dst_stride, vreinterpretq_u8_u32( \
+	vcombine_u32(vget_##half##_u32(a), vget_##half##_u32(b))))
+	SW_ST16(0, u02.val[0], u46.val[0], low);
+	SW_ST16(1, u13.val[0], u57.val[0], low);
+	SW_ST16(2, u02.val[1], u46.val[1], low);
+	SW_ST16(3, u13.val[1], u57.val[1], low);
+	SW_ST16(4, u02.val[0], u46.val[0], high);
+	SW_ST16(5, u13.val[0], u57.val[0], high);
+	SW_ST16(6, u02.val[1], u46.val[1], high);
+	SW_ST16(7, u13.val[1], u57.val[1], high);
+#undef SW_ST16
+}
+
+static cmr_u32 sw_reverse_simd(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 n, cmr_u32 size)
+{
+	uint8x16_t x;
+	cmr_u32 i, step = 16 / size;
+
+	for (i = 0; i + step <= n; i += step) {
+		x = vld1q_u8(src + i * size);
+		if (1 == size)
+			x = vrev64q_u8(x);
+		else
+			x = vreinterpretq_u8_u16(vrev64q_u16(vreinterpretq_u16_u8(x)));
+		vst1q_u8(dst + (n - i - step) * size, vcombine_u8(vget_high_u8(x), vget_low_u8(x)));
+	}
+
+	return i;
+}
+
+#elif defined(__SSE2__)
+
+static void sw_transpose8_u8_simd(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride)
+{
+	__m128i a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+
+#define SW_LD8(k) _mm_loadl_epi64((const __m128i *)(src + (k) * src_stride))
+	a0 = _mm_unpacklo_epi8(SW_LD8(0), SW_LD8(1));
+	a1 = _mm_unpacklo_epi8(SW_LD8(2), SW_LD8(3));
+	a2 = _mm_unpacklo_epi8(SW_LD8(4), SW_LD8(5));
+	a3 = _mm_unpacklo_epi8(SW_LD8(6), SW_LD8(7));
+#undef SW_LD8
+
+	b0 = _mm_unpacklo_epi16(a0, a1);
+	b1 = _mm_unpackhi_epi16(a0, a1);
+	b2 = _mm_unpacklo_epi16(a2, a3);
+	b3 = _mm_unpackhi_epi16(a2, a3);
+
+	c0 = _mm_unpacklo_epi32(b0, b2);
+	c1 = _mm_unpackhi_epi32(b0, b2);
+	c2 = _mm_unpacklo_epi32(b1, b3);
+	c3 = _mm_unpackhi_epi32(b1, b3);
+
+#define SW_ST8(k, x) _mm_storel_epi64((__m128i *)(dst + (k) * dst_stride), x)
+	SW_ST8(0, c0);
+	SW_ST8(1, _mm_srli_si128(c0, 8));
+	SW_ST8(2, c1);
+	SW_ST8(3, _mm_srli_si128(c1, 8));
+	SW_ST8(4, c2);
+	SW_ST8(5, _mm_srli_si128(c2, 8));
+	SW_ST8(6, c3);
+	SW_ST8(7, _mm_srli_si128(c3, 8));
+#undef SW_ST8
+}
+
+static void sw_transpose8_u16_simd(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride)
+{
+	__m128i r[8], a[8], b[8];
+	cmr_u32 k;
+
+	for (k = 0; k < 8; k++)
+		r[k] = _mm_loadu_si128((const __m128i *)(src + k * src_stride));
+
+	for (k = 0; k < 4; k++) {
+		a[2 * k] = _mm_unpacklo_epi16(r[2 * k], r[2 * k + 1]);
+		a[2 * k + 1] = _mm_unpackhi_epi16(r[2 * k], r[2 * k + 1]);
+	}
+
+	/* b0..b3 are columns 0-1, 2-3, 4-5, 6-7 of rows 0..3, b4..b7 of rows 4..7 */
+	for (k = 0; k < 2; k++) {
+		b[4 * k] = _mm_unpacklo_epi32(a[4 * k], a[4 * k + 2]);
+		b[4 * k + 1] = _mm_unpackhi_epi32(a[4 * k], a[4 * k + 2]);
+		b[4 * k + 2] = _mm_unpacklo_epi32(a[4 * k + 1], a[4 * k + 3]);
+		b[4 * k + 3] = _mm_unpackhi_epi32(a[4 * k + 1], a[4 * k + 3]);
+	}
+
+	for (k = 0; k < 4; k++) {
+		_mm_storeu_si128((__m128i *)(dst + 2 * k * dst_stride), _mm_unpacklo_epi64(b[k], b[k + 4]));
+		_mm_storeu_si128((__m128i *)(dst + (2 * k + 1) * dst_stride), _mm_unpackhi_epi64(b[k], b[k + 4]));
+	}
+}
+
+static cmr_u32 sw_reverse_simd(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 n, cmr_u32 size)
+{
+	__m128i x;
+	cmr_u32 i, step = 16 / size;
+
+	for (i = 0; i + step <= n; i += step) {
+		x = _mm_loadu_si128((const __m128i *)(src + i * size));
+		x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+		x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+		x = _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2));
+		if (1 == size)
+			x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *)(dst + (n - i - step) * size), x);
+	}
+
+	return i;
+}
+
+#endif
+
+static void sw_transpose8(const cmr_u8 *src, cmr_int src_stride,
+			cmr_u8 *dst, cmr_int dst_stride, cmr_u32 size)
+{
+#if CMR_SW_CVT_SIMD
+	if (sw_simd()) {
+		if (1 == size)
+			sw_transpose8_u8_simd(src, src_stride, dst, dst_stride);
+		else
+			sw_transpose8_u16_simd(src, src_stride, dst, dst_stride);
+		return;
+	}
+#endif
+	sw_transpose8_c(src, src_stride, dst, dst_stride, size);
+}
+
+static void sw_reverse(const cmr_u8 *src, cmr_u8 *dst, cmr_u32 n, cmr_u32 size)
+{
+	cmr_u32 i = 0;
+
+#if CMR_SW_CVT_SIMD
+	if (sw_simd())
+		i = sw_reverse_simd(src, dst, n, size);
+#endif
+	sw_reverse_c(src + i * size, dst, n - i, size);
+}
+
+/* element (x, y) of src to its place in dst for 90 and 270 */
+static void sw_rot_pixels(const struct sw_rot_plane *p, cmr_u32 angle,
+			cmr_u32 x0, cmr_u32 y0, cmr_u32 x1, cmr_u32 y1)
+{
+	cmr_u32 x, y;
+	const cmr_u8 *s;
+	cmr_u8 *d;
+
+	for (y = y0; y < y1; y++) {
+		s = p->src + y * p->src_stride + x0 * p->size;
+		for (x = x0; x < x1; x++, s += p->size) {
+			if (CMR_SW_CVT_ROT_90 == angle)
+				d = p->dst + x * p->dst_stride + (p->h - 1 - y) * p->size;
+			else
+				d = p->dst + (p->w - 1 - x) * p->dst_stride + y * p->size;
+			sw_elem_copy(s, d, p->size);
+		}
+	}
+}
+
+/*
+ * 90 reads the 8 rows of a block bottom up, so the transposed rows are
+ * the dst rows; 270 reads them top down and writes the dst rows bottom up.
+ */
+static void sw_rot_tile(const struct sw_rot_plane *p, cmr_u32 angle,
+			cmr_u32 x0, cmr_u32 y0, cmr_u32 w, cmr_u32 h)
+{
+	cmr_u32 x, y;
+	cmr_u32 xe = x0 + (w & ~7), ye = y0 + (h & ~7);
+	cmr_int ss = p->src_stride, ds = p->dst_stride;
+
+	for (y = y0; y < ye; y += 8) {
+		for (x = x0; x < xe; x += 8) {
+			if (CMR_SW_CVT_ROT_90 == angle)
+				sw_transpose8(p->src + (y + 7) * ss + x * p->size, -ss,
+					p->dst + x * ds + (p->h - 8 - y) * p->size, ds, p->size);
+			else
+				sw_transpose8(p->src + y * ss + x * p->size, ss,
+					p->dst + (p->w - 1 - x) * ds + y * p->size, -ds, p->size);
+		}
+	}
+
+	sw_rot_pixels(p, angle, xe, y0, x0 + w, ye);
+	sw_rot_pixels(p, angle, x0, ye, x0 + w, y0 + h);
+}
+
+static void sw_rot_plane_rows(const struct sw_rot_plane *p, cmr_u32 angle,
+			cmr_u32 start, cmr_u32 end)
+{
+	cmr_u32 x, y, tw, th;
+
+	switch (angle) {
+	case CMR_SW_CVT_ROT_180:
+		for (y = start; y < end; y++)
+			sw_reverse(p->src + y * p->src_stride, p->dst + (p->h - 1 - y) * p->dst_stride,
+				p->w, p->size);
+		break;
+
+	case CMR_SW_CVT_MIRROR:
+		for (y = start; y < end; y++)
+			sw_reverse(p->src + y * p->src_stride, p->dst + y * p->dst_stride, p->w, p->size);
+		break;
+
+	default:
+		for (y = start; y < end; y += CMR_SW_CVT_TILE) {
+			th = end - y < CMR_SW_CVT_TILE ? end - y : CMR_SW_CVT_TILE;
+			for (x = 0; x < p->w; x += CMR_SW_CVT_TILE) {
+				tw = p->w - x < CMR_SW_CVT_TILE ? p->w - x : CMR_SW_CVT_TILE;
+				sw_rot_tile(p, angle, x, y, tw, th);
+			}
+		}
+		break;
+	}
+}
+
+static void sw_rot_run(struct sw_job *job, cmr_u32 start, cmr_u32 end)
+{
+	cmr_u32 i;
+
+	for (i = 0; i < job->plane_num; i++)
+		sw_rot_plane_rows(&job->rot[i], job->angle, start / job->rot[i].sub, end / job->rot[i].sub);
+}
+
+cmr_int cmr_sw_rotate_check(const struct cmr_sw_frame *src, const struct cmr_sw_frame *dst,
+			cmr_u32 angle)
+{
+	if (sw_frame_check(src) || sw_frame_check(dst) || angle >= CMR_SW_CVT_ANGLE_MAX
+		|| src->layout != dst->layout)
+		return -CMR_CAMERA_INVALID_PARAM;
+
+	if (CMR_SW_CVT_ROT_90 == angle || CMR_SW_CVT_ROT_270 == angle) {
+		if (dst->width != src->height || dst->height != src->width)
+			return -CMR_CAMERA_INVALID_PARAM;
+	} else if (dst->width != src->width || dst->height != src->height) {
+		return -CMR_CAMERA_INVALID_PARAM;
+	}
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+static void sw_rot_set(struct sw_rot_plane *p, const cmr_u8 *src, cmr_u32 src_stride,
+			cmr_u8 *dst, cmr_u32 dst_stride, cmr_u32 w, cmr_u32 h, cmr_u32 size, cmr_u32 sub)
+{
+	p->src = src;
+	p->src_stride = src_stride;
+	p->dst = dst;
+	p->dst_stride = dst_stride;
+	p->w = w;
+	p->h = h;
+	p->size = size;
+	p->sub = sub;
+}
+
+cmr_int cmr_sw_rotate(const struct cmr_sw_frame *src, const struct cmr_sw_frame *dst,
+			cmr_u32 angle)
+{
+	cmr_int ret;
+	struct sw_job job;
+	cmr_u32 cw, ch;
+
+	ret = cmr_sw_rotate_check(src, dst, angle);
+	if (ret)
+		return ret;
+
+	memset(&job, 0, sizeof(job));
+	cw = src->width / 2;
+	ch = src->height / 2;
+	sw_rot_set(&job.rot[0], src->y, src->stride, dst->y, dst->stride,
+		src->width, src->height, 1, 1);
+	if (CMR_SW_CVT_SEMIPLANAR == src->layout) {
+		sw_rot_set(&job.rot[1], src->u, src->stride, dst->u, dst->stride, cw, ch, 2, 2);
+		job.plane_num = 2;
+	} else {
+		sw_rot_set(&job.rot[1], src->u, src->stride / 2, dst->u, dst->stride / 2, cw, ch, 1, 2);
+		sw_rot_set(&job.rot[2], src->v, src->stride / 2, dst->v, dst->stride / 2, cw, ch, 1, 2);
+		job.plane_num = 3;
+	}
+
+	job.run = sw_rot_run;
+	job.angle = angle;
+
+	/* chroma bands stay multiples of 8 rows */
+	return sw_job_run(&job, src->height, 16, src->width * src->height);
+}
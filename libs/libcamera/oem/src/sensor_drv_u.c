@@ -22,6 +22,7 @@
 
 #include "sensor_cfg.h"
 #include "sensor_drv_u.h"
+#include "sensor_reg_shadow.h"
 #include "isp_cali_interface.h"
 #include "isp_param_file_update.h"
 
@@ -38,6 +39,8 @@
  **                         Local Variables                                   *
  **---------------------------------------------------------------------------*/
 struct sensor_drv_context s_local_sensor_cxt;
+/*registers of the sensor in use, to send only what a mode table changes*/
+static struct sensor_reg_shadow s_sensor_reg_shadow;
 /**---------------------------------------------------------------------------*
  **                         Local Functions                                   *
  **---------------------------------------------------------------------------*/
@@ -62,6 +65,7 @@ static cmr_int sns_create_ctrl_thread(struct sensor_drv_context *sensor_cxt);
 static cmr_int sns_ctrl_thread_proc(struct cmr_msg *message, void *p_data);
 static cmr_int sns_destroy_ctrl_thread(struct sensor_drv_context *sensor_cxt);
 static cmr_int sns_stream_ctrl_common(struct sensor_drv_context *sensor_cxt, cmr_u32 on_off);
+static cmr_u32 sns_identify_with_pack(SENSOR_INFO_T *sensor_info_ptr, SENSOR_ID_E sensor_id);
 
 /***---------------------------------------------------------------------------*
  **                       Local function contents                              *
@@ -325,12 +329,10 @@ cmr_int sns_dev_get_flash_level (struct sensor_drv_context *sensor_cxt,
 	return ret;
 }
 
-//TBSPLIT
-cmr_int Sensor_Device_WriteRegTab(SENSOR_REG_TAB_PTR reg_tab)
+static cmr_int sns_dev_write_reg_tab(struct sensor_drv_context *sensor_cxt,
+					SENSOR_REG_TAB_PTR reg_tab)
 {
 	cmr_int ret = SENSOR_SUCCESS;
-	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)sensor_get_dev_cxt();
-
 	SENSOR_DRV_CHECK_ZERO(sensor_cxt);
 
 	ret = ioctl(sensor_cxt->fd_sensor, SENSOR_IO_I2C_WRITE_REGS, reg_tab);
@@ -344,6 +346,17 @@ cmr_int Sensor_Device_WriteRegTab(SENSOR_REG_TAB_PTR reg_tab)
 	return ret;
 }
 
+//TBSPLIT
+cmr_int Sensor_Device_WriteRegTab(SENSOR_REG_TAB_PTR reg_tab)
+{
+	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)sensor_get_dev_cxt();
+
+	/*written behind the shadow*/
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
+
+	return sns_dev_write_reg_tab(sensor_cxt, reg_tab);
+}
+
 cmr_int sns_dev_set_i2c_clk(struct sensor_drv_context *sensor_cxt,
 						cmr_u32 clock)
 {
@@ -511,6 +524,9 @@ cmr_int Sensor_WriteI2C(cmr_u16 slave_addr, cmr_u8 *cmd, cmr_u16 cmd_length)
 	CMR_LOGI("slave_addr=0x%x, ptr=0x%x, count=%d",
 		i2c_tab.slave_addr, (cmr_u32)i2c_tab.i2c_data, i2c_tab.i2c_count);
 
+	if (slave_addr == sensor_cxt->i2c_addr)
+		sensor_reg_shadow_clear(&s_sensor_reg_shadow);
+
 	ret = sns_dev_i2c_write(sensor_cxt, &i2c_tab);
 
 	return ret;
@@ -533,6 +549,7 @@ void Sensor_Reset(cmr_u32 level)
 	}
 
 	reset_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->reset;
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 
 	if (PNULL != reset_func) {
 		reset_func(level);
@@ -651,6 +668,7 @@ void Sensor_PowerOn(struct sensor_drv_context *sensor_cxt, cmr_u32 power_on)
 	avdd_val = sensor_cxt->sensor_info_ptr->avdd_val;
 	iovdd_val = sensor_cxt->sensor_info_ptr->iovdd_val;
 	power_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->power;
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 
 	CMR_LOGI("power_on = %d, power_down_level = %d, avdd_val = %d",
 		power_on, power_down, avdd_val);
@@ -694,6 +712,7 @@ void Sensor_PowerOn_Ex(struct sensor_drv_context *sensor_cxt,
 	avdd_val = sensor_cxt->sensor_info_ptr->avdd_val;
 	iovdd_val = sensor_cxt->sensor_info_ptr->iovdd_val;
 	power_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->power;
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 
 	CMR_LOGI("power_down_level = %d, avdd_val = %d", power_down, avdd_val);
 	/*when use the camera vendor functions, the sensor_cxt should be set at first */
@@ -721,6 +740,7 @@ cmr_int Sensor_PowerDown(cmr_u32 power_level)
 	}
 
 	entersleep_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->enter_sleep;
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 
 	CMR_LOGI("power_level %d", power_level);
 
@@ -939,6 +959,8 @@ cmr_int Sensor_WriteReg(cmr_u16 subaddr, cmr_u16 data)
 		if (SENSOR_OP_SUCCESS != write_reg_func((subaddr << S_BIT_4) + data)) {
 			CMR_LOGI("SENSOR: IIC write : reg:0x%04x, val:0x%04x error",
 					subaddr, data);
+		} else {
+			ret = 0;
 		}
 	} else {
 
@@ -950,6 +972,10 @@ cmr_int Sensor_WriteReg(cmr_u16 subaddr, cmr_u16 data)
 
 		ret = sns_dev_write_reg(sensor_cxt, &reg);
 	}
+	if (ret)
+		sensor_reg_shadow_clear(&s_sensor_reg_shadow);
+	else
+		sensor_reg_shadow_update(&s_sensor_reg_shadow, subaddr, data);
 
 	return ret;
 }
@@ -1008,8 +1034,12 @@ cmr_int Sensor_WriteReg_8bits(cmr_u16 reg_addr, cmr_u8 value)
 	reg.reg_bits = SENSOR_I2C_REG_8BIT | SENSOR_I2C_VAL_8BIT;
 
 	ret = sns_dev_write_reg(sensor_cxt, &reg);
+	if (ret)
+		sensor_reg_shadow_clear(&s_sensor_reg_shadow);
+	else
+		sensor_reg_shadow_update(&s_sensor_reg_shadow, reg_addr, value);
 
-	return 0;
+	return ret;
 }
 
 cmr_int Sensor_ReadReg_8bits(cmr_u8 reg_addr, cmr_u8 * reg_val)
@@ -1031,13 +1061,65 @@ cmr_int Sensor_ReadReg_8bits(cmr_u8 reg_addr, cmr_u8 * reg_val)
 	return ret;
 }
 
-cmr_int Sensor_SendRegTabToSensor(SENSOR_REG_TAB_INFO_T *sensor_reg_tab_info_ptr)
+static cmr_int sns_reg_write_tab(void *priv, SENSOR_REG_T *reg, cmr_u32 count)
 {
-	cmr_u32 i;
+	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)priv;
 	SENSOR_IOCTL_FUNC_PTR write_reg_func;
+	SENSOR_REG_TAB_T regTab;
 	cmr_u16 subaddr;
 	cmr_u16 data;
-	cmr_u8 ret = -1;
+	cmr_u32 i;
+	cmr_int ret = SENSOR_SUCCESS;
+
+	write_reg_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->write_reg;
+
+	if (PNULL != write_reg_func) {
+		/*write the rest too, as before, but report the table failed*/
+		for (i = 0; i < count; i++) {
+			subaddr = reg[i].reg_addr;
+			data	= reg[i].reg_value;
+			if (SENSOR_OP_SUCCESS != write_reg_func((subaddr << S_BIT_4) + data)) {
+				CMR_LOGE("SENSOR: IIC write : reg:0x%04x, val:0x%04x error", subaddr, data);
+				ret = SENSOR_FAIL;
+			}
+		}
+		return ret;
+	}
+
+	regTab.reg_count = count;
+	regTab.reg_bits = sensor_cxt->sensor_info_ptr->reg_addr_value_bits;
+	regTab.burst_mode = 0;
+	regTab.sensor_reg_tab_ptr = reg;
+
+	return sns_dev_write_reg_tab(sensor_cxt, &regTab);
+}
+
+/*one I2C transfer of 16 bit address and 8 bit values, the sensor increments the address*/
+static cmr_int sns_reg_write_burst(void *priv, cmr_u16 addr, cmr_u8 *value, cmr_u32 count)
+{
+	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)priv;
+	SENSOR_I2C_T i2c_tab;
+	cmr_u8 cmd[2 + SENSOR_REG_BURST_MAX];
+
+	cmd[0] = (cmr_u8)(addr >> 8);
+	cmd[1] = (cmr_u8)(addr & 0xff);
+	memcpy(&cmd[2], value, count);
+
+	i2c_tab.slave_addr = sensor_cxt->i2c_addr;
+	i2c_tab.i2c_data = cmd;
+	i2c_tab.i2c_count = (cmr_u16)(count + 2);
+
+	return sns_dev_i2c_write(sensor_cxt, &i2c_tab);
+}
+
+cmr_int Sensor_SendRegTabToSensor(SENSOR_REG_TAB_INFO_T *sensor_reg_tab_info_ptr)
+{
+	SENSOR_IOCTL_FUNC_PTR write_reg_func;
+	struct sensor_reg_ops ops;
+	struct sensor_reg_stat stat;
+	cmr_u32 reg_bits;
+	cmr_u32 is_delta;
+	cmr_int ret = -1;
 	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)sensor_get_dev_cxt();
 
 	CMR_LOGI("E.");
@@ -1049,30 +1131,35 @@ cmr_int Sensor_SendRegTabToSensor(SENSOR_REG_TAB_INFO_T *sensor_reg_tab_info_ptr
 	}
 
 	write_reg_func = sensor_cxt->sensor_info_ptr->ioctl_func_tab_ptr->write_reg;
+	reg_bits = sensor_cxt->sensor_info_ptr->reg_addr_value_bits;
 
-	if (PNULL != write_reg_func) {
-		for (i = 0; i < sensor_reg_tab_info_ptr->reg_count; i++) {
-			subaddr = sensor_reg_tab_info_ptr->sensor_reg_tab_ptr[i].reg_addr;
-			data	= sensor_reg_tab_info_ptr->sensor_reg_tab_ptr[i].reg_value;
-			if (SENSOR_OP_SUCCESS != write_reg_func((subaddr << S_BIT_4) + data))
-				CMR_LOGI("SENSOR: IIC write : reg:0x%04x, val:0x%04x error", subaddr, data);
-		}
-	}else{
-		SENSOR_REG_TAB_T regTab;
-		regTab.reg_count = sensor_reg_tab_info_ptr->reg_count;
-		regTab.reg_bits = sensor_cxt->sensor_info_ptr->reg_addr_value_bits;
-		regTab.burst_mode = 0;
-		regTab.sensor_reg_tab_ptr = sensor_reg_tab_info_ptr->sensor_reg_tab_ptr;
+	/*only raw sensors with 16 bit register address (CCI) keep every register as written
+	and increment the address in a multi byte write, the others get the full table*/
+	is_delta = (SENSOR_IMAGE_FORMAT_RAW == sensor_reg_tab_info_ptr->image_format)
+		&& (SENSOR_I2C_REG_16BIT & reg_bits) && !(SENSOR_I2C_VAL_16BIT & reg_bits);
 
-		ret = Sensor_Device_WriteRegTab(&regTab);
+	if (PNULL == s_sensor_reg_shadow.known) {
+		if (sensor_reg_shadow_init(&s_sensor_reg_shadow))
+			CMR_LOGE("no memory for the register shadow, send full table");
 	}
 
-	CMR_LOGI("reg_count = %d, is_main_sensor: %ld.",
-		sensor_reg_tab_info_ptr->reg_count, sensor_cxt->is_main_sensor);
+	ops.write_tab = sns_reg_write_tab;
+	ops.write_burst = (is_delta && PNULL == write_reg_func) ? sns_reg_write_burst : PNULL;
+	ops.priv = sensor_cxt;
+	memset(&stat, 0, sizeof(struct sensor_reg_stat));
+
+	ret = sensor_reg_shadow_send(&s_sensor_reg_shadow, sensor_reg_tab_info_ptr->sensor_reg_tab_ptr,
+				sensor_reg_tab_info_ptr->reg_count, is_delta, &ops, &stat);
+	if (ret)
+		CMR_LOGE("write table failed, ret=%ld", ret);
+
+	CMR_LOGI("reg_count = %d, skipped %d, single %d, burst %d (%d regs), is_main_sensor: %ld.",
+		sensor_reg_tab_info_ptr->reg_count, stat.skipped, stat.singles,
+		stat.bursts, stat.burst_regs, sensor_cxt->is_main_sensor);
 
 	CMR_LOGI("Sensor_SendRegTabToSensor X.");
 
-	return SENSOR_SUCCESS;
+	return ret ? SENSOR_FAIL : SENSOR_SUCCESS;
 }
 
 void sns_clean_info(struct sensor_drv_context *sensor_cxt)
@@ -1111,6 +1198,8 @@ cmr_int sns_set_id(struct sensor_drv_context *sensor_cxt, SENSOR_ID_E sensor_id)
 			return SENSOR_SUCCESS;
 	}
 	if ((SENSOR_MAIN == sensor_id) || (SENSOR_SUB == sensor_id)) {
+		/*another sensor on the bus*/
+		sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 		if (SENSOR_SUB == sensor_id) {
 			if ((1 == sensor_cxt->is_register_sensor) && (1 == sensor_cxt->is_main_sensor)) {
 				sns_dev_i2c_deinit(sensor_cxt, SENSOR_MAIN);
@@ -1196,6 +1285,36 @@ cmr_int sns_i2c_deinit(struct sensor_drv_context *sensor_cxt, SENSOR_ID_E sensor
 	return SENSOR_SUCCESS;
 }
 
+/* identify with the tuning pack in place, so what identify writes into the
+ * tune (InitRawTuneInfo, OTP) goes into the pack. Most drivers pick their
+ * raw info in identify, the first probe finds the pack only after it and
+ * identifies once more */
+static cmr_u32 sns_identify_with_pack(SENSOR_INFO_T *sensor_info_ptr, SENSOR_ID_E sensor_id)
+{
+	struct sensor_raw_info *raw_info_ptr = PNULL;
+
+	if (PNULL != sensor_info_ptr->raw_info_ptr)
+		raw_info_ptr = *sensor_info_ptr->raw_info_ptr;
+
+	isp_raw_para_load_pack(sensor_info_ptr, sensor_id);
+	if (SENSOR_SUCCESS != sensor_info_ptr->ioctl_func_tab_ptr->identify(SENSOR_ZERO_I2C)) {
+		isp_raw_para_release_pack(sensor_info_ptr, sensor_id);
+		return SENSOR_FAIL;
+	}
+
+	if ((PNULL != sensor_info_ptr->raw_info_ptr)
+		&& (raw_info_ptr != *sensor_info_ptr->raw_info_ptr)
+		&& (SENSOR_SUCCESS == isp_raw_para_load_pack(sensor_info_ptr, sensor_id))) {
+		CMR_LOGI("identify again with the pack");
+		if (SENSOR_SUCCESS != sensor_info_ptr->ioctl_func_tab_ptr->identify(SENSOR_ZERO_I2C)) {
+			CMR_LOGW("identify with the pack failed, keep the built-in tune");
+			isp_raw_para_release_pack(sensor_info_ptr, sensor_id);
+		}
+	}
+
+	return SENSOR_SUCCESS;
+}
+
 cmr_int sns_identify(struct sensor_drv_context *sensor_cxt, SENSOR_ID_E sensor_id)
 {
 	cmr_u32 sensor_index = 0;
@@ -1236,7 +1355,7 @@ cmr_int sns_identify(struct sensor_drv_context *sensor_cxt, SENSOR_ID_E sensor_i
 				sns_dev_set_i2c_addr(sensor_cxt);
 
 				CMR_LOGI("identify  Sensor 01");
-				if(SENSOR_SUCCESS == sensor_info_ptr->ioctl_func_tab_ptr->identify(SENSOR_ZERO_I2C)) {
+				if(SENSOR_SUCCESS == sns_identify_with_pack(sensor_info_ptr, sensor_id)) {
 					sensor_cxt->sensor_list_ptr[sensor_id] = sensor_info_ptr;
 					sensor_register_info_ptr->is_register[sensor_id] = SCI_TRUE;
 					sensor_register_info_ptr->img_sensor_num++;
@@ -1279,7 +1398,7 @@ IDENTIFY_SEARCH:
 				sns_dev_set_i2c_addr(sensor_cxt);
 			}
 			CMR_LOGI("identify  Sensor 01");
-			if (SENSOR_SUCCESS == sensor_info_ptr->ioctl_func_tab_ptr->identify(SENSOR_ZERO_I2C)) {
+			if (SENSOR_SUCCESS == sns_identify_with_pack(sensor_info_ptr, sensor_id)) {
 				sensor_cxt->sensor_list_ptr[sensor_id] = sensor_info_ptr;
 				sensor_register_info_ptr->is_register[sensor_id] = SCI_TRUE;
 				if (SENSOR_ATV != snr_get_cur_id(sensor_cxt))
@@ -2349,10 +2468,13 @@ cmr_int sns_set_mode(struct sensor_drv_context *sensor_cxt, cmr_u32 mode, cmr_u3
 
 			if((SENSOR_MODE_COMMON_INIT == mode) && set_reg_tab_func){
 				set_reg_tab_func(SENSOR_MODE_COMMON_INIT);
+				sensor_cxt->sensor_mode[snr_get_cur_id(sensor_cxt)] = mode;
+			}else if (Sensor_SendRegTabToSensor(&sensor_cxt->sensor_info_ptr->resolution_tab_info_ptr[mode])) {
+				/*not kept as the current mode, the next set mode writes it again*/
+				CMR_LOGE("mode %d not set", mode);
 			}else{
-				Sensor_SendRegTabToSensor(&sensor_cxt->sensor_info_ptr->resolution_tab_info_ptr[mode]);
+				sensor_cxt->sensor_mode[snr_get_cur_id(sensor_cxt)] = mode;
 			}
-			sensor_cxt->sensor_mode[snr_get_cur_id(sensor_cxt)] = mode;
 		} else {
 			if(set_reg_tab_func)
 				set_reg_tab_func(0);
@@ -2682,6 +2804,7 @@ cmr_int sensor_close_common(struct sensor_drv_context *sensor_cxt, cmr_u32 senso
 	CMR_LOGI("9.");
 
 	sns_device_deinit(sensor_cxt);
+	sensor_reg_shadow_deinit(&s_sensor_reg_shadow);
 	sensor_cxt->sensor_isInit = SENSOR_FALSE;
 	sensor_cxt->sensor_mode[SENSOR_MAIN] = SENSOR_MODE_MAX;
 	sensor_cxt->sensor_mode[SENSOR_SUB] = SENSOR_MODE_MAX;
@@ -3423,6 +3546,7 @@ cmr_int Sensor_WriteData(cmr_u8 *regPtr, cmr_u32 length)
 {
 	cmr_int ret;
 	struct sensor_drv_context *sensor_cxt = (struct sensor_drv_context *)sensor_get_dev_cxt();
+	sensor_reg_shadow_clear(&s_sensor_reg_shadow);
 	ret = sns_device_write(sensor_cxt, regPtr, length);
 	return ret;
 }
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "sensor_reg_shadow.h"
+
+#define SHADOW_MAP_WORDS                 (SENSOR_REG_SHADOW_SIZE / 32)
+#define SHADOW_BIT_GET(map, addr)        ((map)[(addr) >> 5] & (1u << ((addr) & 31)))
+#define SHADOW_BIT_SET(map, addr)        ((map)[(addr) >> 5] |= (1u << ((addr) & 31)))
+#define SHADOW_BIT_CLR(map, addr)        ((map)[(addr) >> 5] &= ~(1u << ((addr) & 31)))
+
+cmr_int sensor_reg_shadow_init(struct sensor_reg_shadow *shadow)
+{
+	memset(shadow, 0, sizeof(struct sensor_reg_shadow));
+
+	shadow->value = (cmr_u16 *)malloc(SENSOR_REG_SHADOW_SIZE * sizeof(cmr_u16));
+	shadow->known = (cmr_u32 *)calloc(SHADOW_MAP_WORDS, sizeof(cmr_u32));
+	shadow->in_tab = (cmr_u32 *)calloc(SHADOW_MAP_WORDS, sizeof(cmr_u32));
+	shadow->repeated = (cmr_u32 *)calloc(SHADOW_MAP_WORDS, sizeof(cmr_u32));
+	if (!shadow->value || !shadow->known || !shadow->in_tab || !shadow->repeated) {
+		sensor_reg_shadow_deinit(shadow);
+		return CMR_CAMERA_NO_MEM;
+	}
+
+	return CMR_CAMERA_SUCCESS;
+}
+
+void sensor_reg_shadow_deinit(struct sensor_reg_shadow *shadow)
+{
+	free(shadow->value);
+	free(shadow->known);
+	free(shadow->in_tab);
+	free(shadow->repeated);
+	memset(shadow, 0, sizeof(struct sensor_reg_shadow));
+}
+
+void sensor_reg_shadow_clear(struct sensor_reg_shadow *shadow)
+{
+	if (shadow->known)
+		memset(shadow->known, 0, SHADOW_MAP_WORDS * sizeof(cmr_u32));
+}
+
+void sensor_reg_shadow_update(struct sensor_reg_shadow *shadow, cmr_u16 addr, cmr_u16 value)
+{
+	if (!shadow->known || SENSOR_WRITE_DELAY == addr)
+		return;
+
+	if (SENSOR_REG_SOFT_RESET == addr) {
+		sensor_reg_shadow_clear(shadow);
+		return;
+	}
+	shadow->value[addr] = value;
+	SHADOW_BIT_SET(shadow->known, addr);
+}
+
+static cmr_u32 shadow_is_fixed(struct sensor_reg_shadow *shadow, cmr_u16 addr)
+{
+	return SENSOR_REG_SOFT_RESET == addr || SHADOW_BIT_GET(shadow->repeated, addr);
+}
+
+static cmr_u32 shadow_can_skip(struct sensor_reg_shadow *shadow,
+				const struct sensor_reg_tag *reg, cmr_u32 is_delta)
+{
+	return is_delta && !shadow_is_fixed(shadow, reg->reg_addr)
+		&& SHADOW_BIT_GET(shadow->known, reg->reg_addr)
+		&& shadow->value[reg->reg_addr] == reg->reg_value;
+}
+
+/* number of entries from tab[0] on that can go out as one burst */
+static cmr_u32 shadow_burst_len(struct sensor_reg_shadow *shadow,
+				const struct sensor_reg_tag *tab, cmr_u32 count,
+				cmr_u32 is_delta)
+{
+	cmr_u32 n;
+
+	for (n = 0; n < count && n < SENSOR_REG_BURST_MAX; n++) {
+		if (SENSOR_WRITE_DELAY == tab[n].reg_addr
+			|| tab[n].reg_addr != (cmr_u16)(tab[0].reg_addr + n)
+			|| tab[n].reg_value > 0xff
+			|| shadow_is_fixed(shadow, tab[n].reg_addr)
+			|| shadow_can_skip(shadow, &tab[n], is_delta))
+			break;
+	}
+
+	return n;
+}
+
+static cmr_int shadow_flush(const struct sensor_reg_ops *ops,
+				struct sensor_reg_tag *out, cmr_u32 *out_num)
+{
+	cmr_int ret = CMR_CAMERA_SUCCESS;
+
+	if (*out_num) {
+		ret = ops->write_tab(ops->priv, out, *out_num);
+		*out_num = 0;
+	}
+
+	return ret;
+}
+
+cmr_int sensor_reg_shadow_send(struct sensor_reg_shadow *shadow,
+				const struct sensor_reg_tag *tab, cmr_u32 count,
+				cmr_u32 is_delta, const struct sensor_reg_ops *ops,
+				struct sensor_reg_stat *stat)
+{
+	cmr_int ret = CMR_CAMERA_SUCCESS;
+	struct sensor_reg_tag *out;
+	cmr_u32 out_num = 0;
+	cmr_u8 burst[SENSOR_REG_BURST_MAX];
+	cmr_u32 i, j, run;
+	cmr_u16 addr;
+
+	if (!shadow->known || !count)
+		return ops->write_tab(ops->priv, (struct sensor_reg_tag *)tab, count);
+
+	out = (struct sensor_reg_tag *)malloc(count * sizeof(struct sensor_reg_tag));
+	if (!out)
+		return CMR_CAMERA_NO_MEM;
+
+	for (i = 0; i < count; i++) {
+		addr = tab[i].reg_addr;
+		if (SENSOR_WRITE_DELAY == addr)
+			continue;
+		/* a register set twice belongs to an access code or an indirect
+		 * pointer and data sequence, whose other registers must go out too */
+		if (SHADOW_BIT_GET(shadow->in_tab, addr)) {
+			SHADOW_BIT_SET(shadow->repeated, addr);
+			is_delta = 0;
+		} else {
+			SHADOW_BIT_SET(shadow->in_tab, addr);
+		}
+	}
+
+	stat->reg_count += count;
+	i = 0;
+	while (i < count) {
+		addr = tab[i].reg_addr;
+
+		if (SENSOR_WRITE_DELAY == addr) {
+			out[out_num++] = tab[i++];
+			continue;
+		}
+
+		if (shadow_can_skip(shadow, &tab[i], is_delta)) {
+			stat->skipped++;
+			i++;
+			continue;
+		}
+
+		run = ops->write_burst ? shadow_burst_len(shadow, &tab[i], count - i, is_delta) : 0;
+		if (run >= SENSOR_REG_BURST_MIN) {
+			ret = shadow_flush(ops, out, &out_num);
+			if (ret)
+				break;
+			for (j = 0; j < run; j++) {
+				burst[j] = (cmr_u8)tab[i + j].reg_value;
+				sensor_reg_shadow_update(shadow, tab[i + j].reg_addr, tab[i + j].reg_value);
+			}
+			ret = ops->write_burst(ops->priv, addr, burst, run);
+			if (ret)
+				break;
+			stat->bursts++;
+			stat->burst_regs += run;
+			i += run;
+			continue;
+		}
+
+		out[out_num++] = tab[i];
+		sensor_reg_shadow_update(shadow, addr, tab[i].reg_value);
+		stat->singles++;
+		i++;
+	}
+	if (!ret)
+		ret = shadow_flush(ops, out, &out_num);
+
+	/* a failed write leaves the sensor in an unknown state */
+	if (ret)
+		sensor_reg_shadow_clear(shadow);
+
+	for (i = 0; i < count; i++) {
+		addr = tab[i].reg_addr;
+		if (SENSOR_WRITE_DELAY != addr) {
+			SHADOW_BIT_CLR(shadow->in_tab, addr);
+			SHADOW_BIT_CLR(shadow->repeated, addr);
+		}
+	}
+	free(out);
+
+	return ret;
+}
@@ -54,6 +54,7 @@ typedef unsigned char		BOOLEAN;
 typedef unsigned char		uint8;
 typedef unsigned short		uint16;
 typedef unsigned int		uint32;
+typedef unsigned long long	uint64;
 //typedef unsigned int		uint;
 
 typedef signed char			int8;
@@ -40,6 +40,7 @@ LOCAL_SRC_FILES := \
 			SensorBase.cpp \
 			SensorCoordinate.cpp \
 			InputEventReader.cpp \
+			SensorBatch.cpp \
 			sensors.cpp
 
 #################################################################
@@ -163,5 +163,14 @@ int SensorBase::openInput(const char *inputName)
 	}
 	closedir(dir);
 	ALOGE_IF(fd < 0, "couldn't find '%s' input device", inputName);
+#ifdef EVIOCSCLOCKID
+	if (fd >= 0) {
+		/* stamp input events in the same clock as getTimestamp() */
+		int clockId = CLOCK_MONOTONIC;
+		if (ioctl(fd, EVIOCSCLOCKID, &clockId))
+			ALOGW("couldn't set clock of '%s' (%s)", inputName,
+			      strerror(errno));
+	}
+#endif
 	return fd;
 }
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include <cutils/log.h>
+
+#include "SensorBatch.h"
+
+/*****************************************************************************/
+
+SensorBatchQueue::SensorBatchQueue(size_t capacity)
+:
+mBuffer(new sensors_event_t[capacity]),
+mCapacity(capacity),
+mHead(0), mCount(0), mTimeout(0), mOldest(0), mFlushing(false)
+{
+}
+
+SensorBatchQueue::~SensorBatchQueue()
+{
+	delete[]mBuffer;
+}
+
+void SensorBatchQueue::setTimeout(int64_t timeout_ns)
+{
+	/* leaving batch mode reports whatever is still held */
+	if (timeout_ns <= 0 && mCount)
+		mFlushing = true;
+	mTimeout = timeout_ns > 0 ? timeout_ns : 0;
+}
+
+int SensorBatchQueue::push(sensors_event_t const &event, int64_t now)
+{
+	if (mCount == mCapacity) {
+		ALOGE("SensorBatch: fifo full, sensor %d event dropped",
+		      event.sensor);
+		return -ENOSPC;
+	}
+	if (!mCount)
+		mOldest = now;
+	mBuffer[(mHead + mCount) % mCapacity] = event;
+	mCount++;
+	return 0;
+}
+
+int SensorBatchQueue::pop(sensors_event_t * data, int count)
+{
+	int n = 0;
+
+	while (count && mCount) {
+		size_t run = mCapacity - mHead;
+		if (run > mCount)
+			run = mCount;
+		if (run > (size_t)count)
+			run = count;
+		memcpy(data, mBuffer + mHead, run * sizeof(sensors_event_t));
+		mHead = (mHead + run) % mCapacity;
+		mCount -= run;
+		data += run;
+		count -= run;
+		n += run;
+	}
+	if (!mCount) {
+		mHead = 0;
+		mFlushing = false;
+	}
+	return n;
+}
+
+bool SensorBatchQueue::isDue(int64_t now) const
+{
+	if (!mCount)
+		return false;
+	if (mFlushing || !mTimeout || mCount == mCapacity)
+		return true;
+	return now >= mOldest + mTimeout;
+}
+
+int64_t SensorBatchQueue::deadline() const
+{
+	if (!mCount)
+		return -1;
+	if (mFlushing || !mTimeout || mCount == mCapacity)
+		return 0;
+	return mOldest + mTimeout;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_BATCH_H
+#define ANDROID_SENSOR_BATCH_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+#include "sensors.h"
+
+/*****************************************************************************/
+
+/* Events held per sensor while batching, reported as fifoMaxEventCount */
+#define SENSOR_BATCH_FIFO_SIZE      256
+
+/*
+ * Samples the evdev client buffer can hold without dropping (the kernel
+ * sizes it to at least 64 input_events, 4 per 3-axis sample). The input
+ * fd of a batching driver is left out of poll() for at most this many
+ * sampling periods.
+ */
+#define SENSOR_BATCH_EVDEV_SAMPLES  8
+
+/*
+ * Software FIFO for one sensor handle. Events are kept in arrival order
+ * and reported all at once when the oldest one has waited the maximum
+ * report latency, when the ring is full, or when a flush was requested.
+ */
+class SensorBatchQueue {
+    sensors_event_t* const mBuffer;
+    const size_t mCapacity;
+    size_t mHead;
+    size_t mCount;
+    int64_t mTimeout;
+    int64_t mOldest;
+    bool mFlushing;
+
+public:
+    SensorBatchQueue(size_t capacity);
+    ~SensorBatchQueue();
+
+    void setTimeout(int64_t timeout_ns);
+    int64_t getTimeout() const { return mTimeout; }
+    bool isBatching() const { return mTimeout > 0; }
+
+    size_t size() const { return mCount; }
+    size_t freeSpace() const { return mCapacity - mCount; }
+    bool empty() const { return mCount == 0; }
+
+    /* Queues one event, now is the CLOCK_MONOTONIC time of arrival. */
+    int push(sensors_event_t const& event, int64_t now);
+    /* Copies out up to count queued events, oldest first. */
+    int pop(sensors_event_t* data, int count);
+
+    /* Makes the queue due until it has been emptied once. */
+    void flush() { mFlushing = true; }
+    bool isFlushing() const { return mFlushing; }
+
+    bool isDue(int64_t now) const;
+    /* Time at which the queue becomes due, -1 when it is empty. */
+    int64_t deadline() const;
+};
+
+/*****************************************************************************/
+
+#endif  // ANDROID_SENSOR_BATCH_H
@@ -32,6 +32,7 @@
 #include "AccSensor.h"
 #include "OriSensor.h"
 #include "PlsSensor.h"
+#include "SensorBatch.h"
 
 /*****************************************************************************/
 
@@ -51,6 +52,8 @@
 #define SENSORS_LIGHT_HANDLE            3
 #define SENSORS_PROXIMITY_HANDLE        4
 
+#define SENSORS_NUM_HANDLES             (ID_P + 1)
+
 /*****************************************************************************/
 
 /* The SENSORS Module */
@@ -93,8 +96,16 @@ struct sensors_module_t HAL_MODULE_INFO_SYM = {
 		get_sensors_list:sensors__get_sensors_list,
 };
 
+static int64_t getMonotonicTime()
+{
+	struct timespec t;
+	t.tv_sec = t.tv_nsec = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return int64_t(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
 struct sensors_poll_context_t {
-	struct sensors_poll_device_t device;	// must be first
+	struct sensors_poll_device_1 device;	// must be first
 
 	 sensors_poll_context_t();
 	~sensors_poll_context_t();
@@ -102,6 +113,8 @@ struct sensors_poll_context_t {
 	int setDelay(int handle, int64_t ns);
 	int setDelay_sub(int handle, int64_t ns);
 	int pollEvents(sensors_event_t * data, int count);
+	int batch(int handle, int flags, int64_t period_ns, int64_t timeout);
+	int flush(int handle);
 
 private:
 	enum {
@@ -125,6 +138,32 @@ private:
 	SensorBase *mSensors[numSensorDrivers];
 	PlsSensor *PlsObjList[PlsChipNum];
 
+	/* batching state, the queues are only touched by the poll thread */
+	pthread_mutex_t mBatchLock;
+	int64_t mBatchTimeout[SENSORS_NUM_HANDLES];
+	int mFlushRequests[SENSORS_NUM_HANDLES];
+	bool mBatchChanged;
+	SensorBatchQueue *mBatch[SENSORS_NUM_HANDLES];
+	int mFlushPending[SENSORS_NUM_HANDLES];
+	int mHandleDriver[SENSORS_NUM_HANDLES];
+	int mDriverFd[numSensorDrivers];
+	int64_t mNextDrain[numSensorDrivers];
+
+	void wakeUp();
+	void applyBatchState();
+	bool isBatchable(int handle) const {
+		return handle == ID_A || handle == ID_M || handle == ID_O;
+	}
+	bool needsQueue(int handle) const {
+		return mBatch[handle]->isBatching() || !mBatch[handle]->empty();
+	}
+	int driverRoom(int drv, int count) const;
+	int64_t drainInterval(int drv) const;
+	int batchEvents(sensors_event_t * data, int nb, int64_t now);
+	int reportBatched(sensors_event_t * data, int count, int64_t now);
+	void updatePollSet(int64_t now);
+	int batchPollTime(int64_t now) const;
+
 	int handleToDriver(int handle) const {
 		switch (handle) {
 		case ID_A:
@@ -213,6 +252,28 @@ sensors_poll_context_t::sensors_poll_context_t()
 	mPollFds[wake].fd = wakeFds[0];
 	mPollFds[wake].events = POLLIN;
 	mPollFds[wake].revents = 0;
+
+	pthread_mutex_init(&mBatchLock, NULL);
+	mBatchChanged = false;
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		mBatchTimeout[h] = 0;
+		mFlushRequests[h] = 0;
+		mFlushPending[h] = 0;
+		mHandleDriver[h] = -1;
+		mBatch[h] = new SensorBatchQueue(SENSOR_BATCH_FIFO_SIZE);
+	}
+	for (int i = 0; i < numSensors; i++) {
+		int h = sSensorList[i].handle;
+		if (h < 0 || h >= SENSORS_NUM_HANDLES)
+			continue;
+		mHandleDriver[h] = handleToDriver(h);
+		if (isBatchable(h))
+			sSensorList[i].fifoMaxEventCount = SENSOR_BATCH_FIFO_SIZE;
+	}
+	for (int i = 0; i < numSensorDrivers; i++) {
+		mDriverFd[i] = mPollFds[i].fd;
+		mNextDrain[i] = 0;
+	}
 }
 
 sensors_poll_context_t::~sensors_poll_context_t()
@@ -220,6 +281,10 @@ sensors_poll_context_t::~sensors_poll_context_t()
 	for (int i = 0; i < numSensorDrivers; i++) {
 		delete mSensors[i];
 	}
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		delete mBatch[h];
+	}
+	pthread_mutex_destroy(&mBatchLock);
 	close(mPollFds[wake].fd);
 	close(mWritePipeFd);
 }
@@ -251,16 +316,73 @@ int sensors_poll_context_t::activate(int handle, int enabled)
 
 	err = mSensors[drv]->setEnable(handle, enabled);
 
-	if (enabled && !err) {
-		const char wakeMessage(WAKE_MESSAGE);
-		int result = write(mWritePipeFd, &wakeMessage, 1);
-		ALOGE_IF(result < 0, "error sending wake message (%s)",
-			 strerror(errno));
+	if (!enabled && !err) {
+		/* report what is still batched and fall back to streaming */
+		pthread_mutex_lock(&mBatchLock);
+		mBatchTimeout[handle] = 0;
+		mBatchChanged = true;
+		pthread_mutex_unlock(&mBatchLock);
 	}
 
+	if (!err)
+		wakeUp();
+
+	return err;
+}
+
+void sensors_poll_context_t::wakeUp()
+{
+	const char wakeMessage(WAKE_MESSAGE);
+	int result = write(mWritePipeFd, &wakeMessage, 1);
+	ALOGE_IF(result < 0, "error sending wake message (%s)",
+		 strerror(errno));
+}
+
+int sensors_poll_context_t::batch(int handle, int flags, int64_t period_ns,
+				  int64_t timeout)
+{
+	if (handle < 0 || handle >= SENSORS_NUM_HANDLES
+	    || mHandleDriver[handle] < 0)
+		return -EINVAL;
+
+	/* light and proximity are on-change, they are never held back */
+	if (timeout > 0 && !isBatchable(handle))
+		return -EINVAL;
+
+	if (flags & SENSORS_BATCH_DRY_RUN)
+		return 0;
+
+	ALOGD("batch handle=%d; period=%lld; timeout=%lld", handle,
+	      period_ns, timeout);
+
+	pthread_mutex_lock(&mBatchLock);
+	mBatchTimeout[handle] = timeout;
+	mBatchChanged = true;
+	pthread_mutex_unlock(&mBatchLock);
+
+	int err = setDelay(handle, period_ns);
+	wakeUp();
 	return err;
 }
 
+int sensors_poll_context_t::flush(int handle)
+{
+	if (handle < 0 || handle >= SENSORS_NUM_HANDLES
+	    || mHandleDriver[handle] < 0)
+		return -EINVAL;
+
+	if (mSensors[mHandleDriver[handle]]->getEnable(handle) <= 0)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mBatchLock);
+	mFlushRequests[handle]++;
+	mBatchChanged = true;
+	pthread_mutex_unlock(&mBatchLock);
+
+	wakeUp();
+	return 0;
+}
+
 int sensors_poll_context_t::setDelay(int handle, int64_t ns)
 {
 	switch (handle) {
@@ -308,6 +430,176 @@ int sensors_poll_context_t::setDelay_sub(int handle, int64_t ns)
 	return err;
 }
 
+void sensors_poll_context_t::applyBatchState()
+{
+	int64_t timeout[SENSORS_NUM_HANDLES];
+	int flushes[SENSORS_NUM_HANDLES];
+
+	pthread_mutex_lock(&mBatchLock);
+	if (!mBatchChanged) {
+		pthread_mutex_unlock(&mBatchLock);
+		return;
+	}
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		timeout[h] = mBatchTimeout[h];
+		flushes[h] = mFlushRequests[h];
+		mFlushRequests[h] = 0;
+	}
+	mBatchChanged = false;
+	pthread_mutex_unlock(&mBatchLock);
+
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		int drv = mHandleDriver[h];
+		if (drv < 0)
+			continue;
+		if (timeout[h] != mBatch[h]->getTimeout()) {
+			mBatch[h]->setTimeout(timeout[h]);
+			mNextDrain[drv] = 0;
+		}
+		if (!flushes[h])
+			continue;
+		/*
+		 * Everything the kernel has queued so far belongs in front of
+		 * the flush complete event, so pick it up before reporting.
+		 */
+		struct pollfd pfd;
+		pfd.fd = mDriverFd[drv];
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (pfd.fd >= 0 && poll(&pfd, 1, 0) > 0)
+			mPollFds[drv].revents |= pfd.revents & POLLIN;
+		mBatch[h]->flush();
+		mFlushPending[h] += flushes[h];
+		mNextDrain[drv] = 0;
+	}
+}
+
+int sensors_poll_context_t::driverRoom(int drv, int count) const
+{
+	int room = count;
+
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		if (mHandleDriver[h] != drv || !needsQueue(h))
+			continue;
+		if ((size_t)room > mBatch[h]->freeSpace())
+			room = mBatch[h]->freeSpace();
+	}
+	return room;
+}
+
+int64_t sensors_poll_context_t::drainInterval(int drv) const
+{
+	int64_t interval = -1;
+	bool enabled = false;
+
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		if (mHandleDriver[h] != drv || mSensors[drv]->getEnable(h) <= 0)
+			continue;
+		enabled = true;
+		if (!mBatch[h]->isBatching() || mFlushPending[h])
+			return 0;
+		int64_t delay = mSensors[drv]->getDelay(h);
+		if (delay <= 0)
+			return 0;
+		int64_t t = mBatch[h]->getTimeout();
+		if (t > delay * SENSOR_BATCH_EVDEV_SAMPLES)
+			t = delay * SENSOR_BATCH_EVDEV_SAMPLES;
+		if (interval < 0 || t < interval)
+			interval = t;
+	}
+	return enabled ? interval : 0;
+}
+
+int sensors_poll_context_t::batchEvents(sensors_event_t * data, int nb,
+					int64_t now)
+{
+	int kept = 0;
+
+	for (int i = 0; i < nb; i++) {
+		int h = data[i].sensor;
+		if (h >= 0 && h < SENSORS_NUM_HANDLES && needsQueue(h)) {
+			mBatch[h]->push(data[i], now);
+			continue;
+		}
+		if (kept != i)
+			data[kept] = data[i];
+		kept++;
+	}
+	return kept;
+}
+
+int sensors_poll_context_t::reportBatched(sensors_event_t * data, int count,
+					  int64_t now)
+{
+	int nbEvents = 0;
+
+	for (int h = 0; count && h < SENSORS_NUM_HANDLES; h++) {
+		int drv = mHandleDriver[h];
+		if (drv < 0)
+			continue;
+		if (mBatch[h]->isDue(now)) {
+			int nb = mBatch[h]->pop(data, count);
+			count -= nb;
+			nbEvents += nb;
+			data += nb;
+		}
+		while (count && mFlushPending[h] && mBatch[h]->empty()
+		       && !(mPollFds[drv].revents & POLLIN)) {
+			memset(data, 0, sizeof(sensors_event_t));
+			data->version = META_DATA_VERSION;
+			data->type = SENSOR_TYPE_META_DATA;
+			data->meta_data.what = META_DATA_FLUSH_COMPLETE;
+			data->meta_data.sensor = h;
+			mFlushPending[h]--;
+			count--;
+			nbEvents++;
+			data++;
+		}
+	}
+	return nbEvents;
+}
+
+void sensors_poll_context_t::updatePollSet(int64_t now)
+{
+	for (int i = 0; i < numSensorDrivers; i++) {
+		int64_t interval = drainInterval(i);
+		if (interval <= 0) {
+			mNextDrain[i] = 0;
+			mPollFds[i].fd = mDriverFd[i];
+		} else if (!mNextDrain[i]) {
+			/* let the kernel buffer fill up before reading again */
+			mNextDrain[i] = now + interval;
+			mPollFds[i].fd = -1;
+		} else if (now >= mNextDrain[i]) {
+			mPollFds[i].fd = mDriverFd[i];
+		} else {
+			mPollFds[i].fd = -1;
+		}
+	}
+}
+
+int sensors_poll_context_t::batchPollTime(int64_t now) const
+{
+	int64_t next = -1;
+
+	for (int h = 0; h < SENSORS_NUM_HANDLES; h++) {
+		int64_t t = mBatch[h]->deadline();
+		if (t >= 0 && (next < 0 || t < next))
+			next = t;
+	}
+	for (int i = 0; i < numSensorDrivers; i++) {
+		if (mPollFds[i].fd >= 0 || !mNextDrain[i])
+			continue;
+		if (next < 0 || mNextDrain[i] < next)
+			next = mNextDrain[i];
+	}
+	if (next < 0)
+		return -1;
+	if (next <= now)
+		return 0;
+	return (int)((next - now + 999999) / 1000000);
+}
+
 int sensors_poll_context_t::pollEvents(sensors_event_t * data, int count)
 {
 	int nbEvents = 0;
@@ -316,28 +608,47 @@ int sensors_poll_context_t::pollEvents(sensors_event_t * data, int count)
 	bool hasPSensor = false;
 
 	do {
+		int64_t now = getMonotonicTime();
+
+		applyBatchState();
+
 		// see if we have some leftover from the last poll()
 		for (int i = 0; count && i < numSensorDrivers; i++) {
 			SensorBase *const sensor(mSensors[i]);
 			if ((mPollFds[i].revents & POLLIN)
 			    || (sensor->hasPendingEvents())) {
-				int nb = sensor->readEvents(data, count);
-				if (nb < count) {
+				int room = driverRoom(i, count);
+				if (!room) {
+					// fifo full, it is reported below
+					continue;
+				}
+				int nb = sensor->readEvents(data, room);
+				if (nb < room) {
 					// no more data for this sensor
 					mPollFds[i].revents = 0;
+					mNextDrain[i] = 0;
 				}
+				if (nb < 0)
+					nb = 0;
 #ifndef ORI_NULL
 				if ((0 != nb) && (acc == i)) {
 					((OriSensor *) (mSensors[ori]))->
 					    setAccel(&data[nb - 1]);
 				}
 #endif
+				nb = batchEvents(data, nb, now);
 				count -= nb;
 				nbEvents += nb;
 				data += nb;
 			}
 		}
 
+		// hand over the fifos that are due
+		int nb = reportBatched(data, count, now);
+		count -= nb;
+		nbEvents += nb;
+		data += nb;
+
 		if (count) {
 			// we still have some room, so try to see if we can get
 			// some events immediately or just wait if we don't have
@@ -348,6 +659,8 @@ int sensors_poll_context_t::pollEvents(sensors_event_t * data, int count)
 				release_wake_lock(WAKE_LOCK_ID);
 			}
 #endif
+			updatePollSet(now);
+			polltime = batchPollTime(now);
 			do {
 				n = poll(mPollFds, numFds,
 					 nbEvents ? 0 : polltime);
@@ -375,8 +688,9 @@ int sensors_poll_context_t::pollEvents(sensors_event_t * data, int count)
 				mPollFds[wake].revents = 0;
 			}
 		}
-		// if we have events and space, go read them
-	} while (n && count);
+		// if we have events and space, go read them, and keep waiting
+		// while a batch deadline expired without anything to report
+	} while (count && (n || (!nbEvents && polltime >= 0)));
 
 	return nbEvents;
 }
@@ -413,6 +727,20 @@ static int poll__poll(struct sensors_poll_device_t *dev,
 	return ctx->pollEvents(data, count);
 }
 
+static int poll__batch(struct sensors_poll_device_1 *dev,
+		       int handle, int flags, int64_t period_ns,
+		       int64_t timeout)
+{
+	sensors_poll_context_t *ctx = (sensors_poll_context_t *) dev;
+	return ctx->batch(handle, flags, period_ns, timeout);
+}
+
+static int poll__flush(struct sensors_poll_device_1 *dev, int handle)
+{
+	sensors_poll_context_t *ctx = (sensors_poll_context_t *) dev;
+	return ctx->flush(handle);
+}
+
 /*****************************************************************************/
 
 /** Open a new instance of a sensor device using name */
@@ -422,15 +750,17 @@ static int open_sensors(const struct hw_module_t *module, const char *id,
 	int status = -EINVAL;
 	sensors_poll_context_t *dev = new sensors_poll_context_t();
 
-	memset(&dev->device, 0, sizeof(sensors_poll_device_t));
+	memset(&dev->device, 0, sizeof(sensors_poll_device_1));
 
 	dev->device.common.tag = HARDWARE_DEVICE_TAG;
-	dev->device.common.version = 0;
+	dev->device.common.version = SENSORS_DEVICE_API_VERSION_1_1;
 	dev->device.common.module = const_cast < hw_module_t * >(module);
 	dev->device.common.close = poll__close;
 	dev->device.activate = poll__activate;
 	dev->device.setDelay = poll__setDelay;
 	dev->device.poll = poll__poll;
+	dev->device.batch = poll__batch;
+	dev->device.flush = poll__flush;
 
 	*device = &dev->device.common;
 	status = 0;
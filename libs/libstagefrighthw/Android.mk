@@ -4,7 +4,11 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES := \
     SprdOMXPlugin.cpp \
 	SprdOMXComponent.cpp \
-	SprdSimpleOMXComponent.cpp
+	SprdSimpleOMXComponent.cpp \
+	SprdStreamBuffer.cpp \
+	SprdBandwidthGovernor.cpp \
+	SprdWorkerPool.cpp \
+	SprdYuvConvert.cpp
 
 LOCAL_CFLAGS := $(PV_CFLAGS_MINUS_VISIBILITY)
 
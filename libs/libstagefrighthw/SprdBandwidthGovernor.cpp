@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SprdBandwidthGovernor"
+#include <utils/Log.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/SprdBandwidthGovernor.h"
+
+namespace android {
+
+// The frequencies the dmcfreq driver is asked for and the memory traffic
+// in MB/s the video hardware is given at each. A decoder at 30 fps gets
+// 200 MHz up to QVGA, 300 MHz up to 576p, 400 MHz up to 720p and 500 MHz
+// above, as with the resolution ladder of the decoders this replaces.
+static const struct {
+    uint32_t khz;
+    int64_t mbps;
+} kLevels[] = {
+    { 200000, 12 },
+    { 300000, 64 },
+    { 400000, 140 },
+    { 500000, 300 },
+};
+
+static const int kNumLevels = sizeof(kLevels) / sizeof(kLevels[0]);
+
+// Frames of memory traffic per coded frame, in tenths. A decoder writes
+// the frame and reads one reference with overfetch, two with B-frames.
+// The encoder figure is not a traffic estimate but fitted to the ladder
+// the encoders were tuned with: at 30 fps it gives 200 MHz up to 720x480
+// and 300 MHz up to 1080p. An encoder close to its deadline still gets a
+// step more.
+static const int64_t kDecoderTraffic = 30;
+static const int64_t kDecoderBidirTraffic = 40;
+static const int64_t kEncoderTraffic = 5;
+
+static const int64_t kDefaultFrameRate = 30;
+static const int64_t kMaxFrameRate = 120;
+
+static int levelFor(int64_t bytesPerSec) {
+    for (int i = 0; i < kNumLevels; i++) {
+        if (bytesPerSec <= kLevels[i].mbps * 1000000) {
+            return i;
+        }
+    }
+    return kNumLevels - 1;
+}
+
+static Mutex gInstanceLock;
+static SprdBandwidthGovernor *gInstance = NULL;
+
+// static
+SprdBandwidthGovernor *SprdBandwidthGovernor::getInstance() {
+    Mutex::Autolock autoLock(gInstanceLock);
+
+    if (gInstance == NULL) {
+        gInstance = new SprdBandwidthGovernor(SPRD_DMCFREQ_NODE);
+    }
+    return gInstance;
+}
+
+SprdBandwidthGovernor::SprdBandwidthGovernor(const char *node)
+    : mFd(-1),
+      mNextId(0),
+      mLevel(-1),
+      mHeldFrames(0) {
+    strncpy(mNode, node, sizeof(mNode) - 1);
+    mNode[sizeof(mNode) - 1] = '\0';
+}
+
+SprdBandwidthGovernor::~SprdBandwidthGovernor() {
+    Mutex::Autolock autoLock(mLock);
+
+    if (mLevel >= 0) {
+        write(0);
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+    }
+}
+
+int SprdBandwidthGovernor::open(Kind kind) {
+    Mutex::Autolock autoLock(mLock);
+
+    Session s;
+    memset(&s, 0, sizeof(s));
+    s.mId = mNextId++;
+    s.mKind = kind;
+    s.mFrameTimeUs = -1;
+    mSessions.push(s);
+
+    update(true);
+
+    return s.mId;
+}
+
+void SprdBandwidthGovernor::close(int id) {
+    Mutex::Autolock autoLock(mLock);
+
+    for (size_t i = 0; i < mSessions.size(); i++) {
+        if (mSessions[i].mId == id) {
+            mSessions.removeAt(i);
+            break;
+        }
+    }
+
+    update(true);
+}
+
+void SprdBandwidthGovernor::setFormat(int id, int width, int height, bool bidir) {
+    Mutex::Autolock autoLock(mLock);
+
+    Session *s = findSession(id);
+    if (s == NULL) {
+        return;
+    }
+
+    s->mWidth = width;
+    s->mHeight = height;
+    s->mBidir = bidir;
+
+    update(true);
+}
+
+void SprdBandwidthGovernor::onFrame(int id, int64_t timeUs, int64_t codingUs, size_t bytes) {
+    Mutex::Autolock autoLock(mLock);
+
+    Session *s = findSession(id);
+    if (s == NULL) {
+        return;
+    }
+
+    // The slices of a frame share its time, the frame is counted when
+    // the next one starts.
+    if (timeUs != s->mFrameTimeUs) {
+        if (s->mFrameTimeUs >= 0) {
+            endFrame(s);
+            update(false);
+        }
+        s->mFrameTimeUs = timeUs;
+        s->mFrameCodingUs = 0;
+        s->mFrameBytes = 0;
+    }
+
+    s->mFrameCodingUs += codingUs;
+    s->mFrameBytes += bytes;
+}
+
+uint32_t SprdBandwidthGovernor::vote() {
+    Mutex::Autolock autoLock(mLock);
+
+    return (mLevel >= 0) ? kLevels[mLevel].khz : 0;
+}
+
+SprdBandwidthGovernor::Session *SprdBandwidthGovernor::findSession(int id) {
+    for (size_t i = 0; i < mSessions.size(); i++) {
+        if (mSessions[i].mId == id) {
+            return &mSessions.editItemAt(i);
+        }
+    }
+    return NULL;
+}
+
+void SprdBandwidthGovernor::endFrame(Session *s) {
+    s->mTimes[s->mNextTime] = s->mFrameTimeUs;
+    s->mNextTime = (s->mNextTime + 1) % kWindow;
+    if (s->mNumTimes < kWindow) {
+        s->mNumTimes++;
+    }
+
+    // Averages over about eight frames.
+    if (s->mNumTimes == 1) {
+        s->mAvgCodingUs = s->mFrameCodingUs;
+        s->mAvgBytes = s->mFrameBytes;
+    } else {
+        s->mAvgCodingUs += (s->mFrameCodingUs - s->mAvgCodingUs) / 8;
+        s->mAvgBytes += ((int64_t)s->mFrameBytes - s->mAvgBytes) / 8;
+    }
+
+    // A session close to its deadline asks for a step more at once, one
+    // with time to spare asks for a step less after kHoldFrames frames.
+    int64_t intervalUs = 1000000 / frameRate(s);
+    int64_t loadPct = s->mAvgCodingUs * 100 / intervalUs;
+    if (loadPct > kLoadHighPct) {
+        if (s->mStep < 1) {
+            s->mStep++;
+        }
+        s->mIdleFrames = 0;
+    } else if (loadPct < kLoadLowPct) {
+        if (++s->mIdleFrames >= kHoldFrames && s->mStep > -1) {
+            s->mStep--;
+            s->mIdleFrames = 0;
+        }
+    } else {
+        s->mIdleFrames = 0;
+    }
+}
+
+int64_t SprdBandwidthGovernor::frameRate(const Session *s) const {
+    if (s->mNumTimes < 2) {
+        return kDefaultFrameRate;
+    }
+
+    // Frames come out of a decoder in decode order, the span of the
+    // window doesn't depend on it.
+    int64_t minUs = s->mTimes[0];
+    int64_t maxUs = s->mTimes[0];
+    for (int i = 1; i < s->mNumTimes; i++) {
+        if (s->mTimes[i] < minUs) {
+            minUs = s->mTimes[i];
+        }
+        if (s->mTimes[i] > maxUs) {
+            maxUs = s->mTimes[i];
+        }
+    }
+
+    if (maxUs <= minUs) {
+        return kDefaultFrameRate;
+    }
+
+    int64_t fps = ((int64_t)(s->mNumTimes - 1) * 1000000 + (maxUs - minUs) / 2) / (maxUs - minUs);
+    if (fps < 1) {
+        fps = 1;
+    } else if (fps > kMaxFrameRate) {
+        fps = kMaxFrameRate;
+    }
+    return fps;
+}
+
+int64_t SprdBandwidthGovernor::bandwidth(const Session *s) const {
+    int64_t traffic;
+    if (s->mKind == ENCODER) {
+        traffic = kEncoderTraffic;
+    } else {
+        traffic = s->mBidir ? kDecoderBidirTraffic : kDecoderTraffic;
+    }
+
+    // A YUV420 frame, and the bitstream is written once and read once.
+    int64_t frameBytes = (int64_t)s->mWidth * s->mHeight * 3 / 2;
+    int64_t perFrame = frameBytes * traffic / 10 + s->mAvgBytes * 2;
+    int64_t bw = perFrame * frameRate(s);
+
+    // A step moves the estimate to the edge of the next level, so the
+    // session gets that level alone and adds no more than it to others.
+    int level = levelFor(bw) + s->mStep;
+    if (s->mStep > 0 && level < kNumLevels) {
+        bw = kLevels[level - 1].mbps * 1000000 + 1;
+    } else if (s->mStep < 0 && level >= 0) {
+        bw = kLevels[level].mbps * 1000000;
+    }
+
+    return bw;
+}
+
+void SprdBandwidthGovernor::update(bool now) {
+    int level = -1;
+    int64_t total = 0;
+    int counted = 0;
+
+    // A session votes once its frame size is known.
+    for (size_t i = 0; i < mSessions.size(); i++) {
+        if (mSessions[i].mWidth > 0) {
+            total += bandwidth(&mSessions[i]);
+            counted++;
+        }
+    }
+    if (counted > 0) {
+        level = levelFor(total);
+    }
+
+    if (level >= mLevel) {
+        mHeldFrames = 0;
+        if (level == mLevel) {
+            return;
+        }
+    } else if (!now && level >= 0 && ++mHeldFrames < kHoldFrames) {
+        return;
+    }
+
+    // The driver counts requests, only one of them is held.
+    if (mLevel >= 0) {
+        write(0);
+    }
+    if (level >= 0 && !write(kLevels[level].khz)) {
+        level = -1;
+    }
+
+    if (level != mLevel) {
+        ALOGI("%s, %u -> %u kHz, %d sessions", __FUNCTION__,
+              (mLevel >= 0) ? kLevels[mLevel].khz : 0,
+              (level >= 0) ? kLevels[level].khz : 0, (int)mSessions.size());
+    }
+
+    mLevel = level;
+    mHeldFrames = 0;
+}
+
+bool SprdBandwidthGovernor::write(uint32_t khz) {
+    // Opened once, a device without the node is told so once.
+    if (mFd == -1) {
+        mFd = ::open(mNode, O_WRONLY);
+        if (mFd < 0) {
+            ALOGE("%s, open %s failed: %s", __FUNCTION__, mNode, strerror(errno));
+            mFd = -2;
+        }
+    }
+    if (mFd < 0) {
+        return false;
+    }
+
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%u\n", khz);
+    if (::write(mFd, buf, len) != len) {
+        ALOGE("%s, write %u failed: %s", __FUNCTION__, khz, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace android
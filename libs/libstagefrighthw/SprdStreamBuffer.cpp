@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "include/SprdStreamBuffer.h"
+
+namespace android {
+
+static const uint8_t kStartCode[4] = { 0x0, 0x0, 0x0, 0x1 };
+
+static bool hasStartCode(const uint8_t *p, size_t len) {
+    return len >= sizeof(kStartCode) && !memcmp(p, kStartCode, sizeof(kStartCode));
+}
+
+// 00 00 01 or 00 00 00 01.
+static bool beginsWithStartCode(const uint8_t *p, size_t len) {
+    return (len >= 3 && p[0] == 0 && p[1] == 0 && p[2] == 1) || hasStartCode(p, len);
+}
+
+static bool isAligned(size_t value) {
+    return (value & (SprdStreamBuffer::kAlign - 1)) == 0;
+}
+
+static size_t misalignment(size_t value) {
+    return value & (SprdStreamBuffer::kAlign - 1);
+}
+
+SprdStreamBuffer::SprdStreamBuffer()
+    : mHeap(NULL),
+      mHeapPhys(0),
+      mHeapSize(0),
+      mByteStream(false),
+      mCopiedBytes(0),
+      mInPlaceBytes(0) {
+    reset();
+}
+
+void SprdStreamBuffer::setHeap(uint8_t *data, uint32_t phys, size_t size) {
+    mHeap = data;
+    mHeapPhys = phys;
+    mHeapSize = size;
+    reset();
+}
+
+bool SprdStreamBuffer::prepare(uint8_t *src, uint32_t srcPhys, size_t writable,
+                               size_t len, bool startCode) {
+    size_t startCodeLength = (startCode && !hasStartCode(src, len)) ? sizeof(kStartCode) : 0;
+    bool padding = mByteStream && (startCodeLength > 0 || beginsWithStartCode(src, len));
+
+    // Read in place, the start code and the zero bytes that align it go
+    // into bytes already consumed or into the headroom.
+    if (srcPhys != 0) {
+        size_t pad = padding ? misalignment(srcPhys - startCodeLength) : 0;
+        size_t prefix = pad + startCodeLength;
+
+        if (prefix <= writable && isAligned(srcPhys - prefix)) {
+            memset(src - prefix, 0, pad);
+            memcpy(src - startCodeLength, kStartCode, startCodeLength);
+            setSpan(src - prefix, srcPhys - prefix, len + prefix, prefix, false, src);
+            return true;
+        }
+    }
+
+    // The decoder stopped within the span, the rest of it is still in
+    // the heap, after bytes already consumed.
+    if (mInHeap && src == mSrc && len + mPrefixLength == mLength) {
+        size_t offset = mData - mHeap;
+        size_t insert = (mPrefixLength > 0) ? 0 : startCodeLength;
+        size_t pad = (padding || (mByteStream && mPrefixLength > 0)) ?
+                misalignment(offset - insert) : 0;
+        size_t prefix = pad + insert;
+
+        if (prefix <= offset && isAligned(offset - prefix)) {
+            memset(mData - prefix, 0, pad);
+            memcpy(mData - insert, kStartCode, insert);
+            setSpan(mData - prefix, mHeapPhys ? mHeapPhys + offset - prefix : 0,
+                    mLength + prefix, mPrefixLength + prefix, true, src);
+            return true;
+        }
+    }
+
+    if (mHeap == NULL || len + startCodeLength > mHeapSize) {
+        reset();
+        return false;
+    }
+
+    memcpy(mHeap, kStartCode, startCodeLength);
+    memcpy(mHeap + startCodeLength, src, len);
+    setSpan(mHeap, mHeapPhys, len + startCodeLength, startCodeLength, true, src);
+    mCopiedBytes += len;
+
+    return true;
+}
+
+size_t SprdStreamBuffer::consume(size_t n) {
+    if (n > mLength) {
+        n = mLength;
+    }
+
+    size_t prefix = (n < mPrefixLength) ? n : mPrefixLength;
+
+    mData += n;
+    if (mPhys != 0) {
+        mPhys += n;
+    }
+    mLength -= n;
+    mPrefixLength -= prefix;
+    mSrc += n - prefix;
+    if (!mInHeap) {
+        mInPlaceBytes += n - prefix;
+    }
+
+    return n - prefix;
+}
+
+void SprdStreamBuffer::reset() {
+    setSpan(NULL, 0, 0, 0, false, NULL);
+}
+
+void SprdStreamBuffer::setSpan(uint8_t *data, uint32_t phys, size_t len,
+                               size_t prefixLength, bool inHeap, uint8_t *src) {
+    mData = data;
+    mPhys = phys;
+    mLength = len;
+    mPrefixLength = prefixLength;
+    mInHeap = inHeap;
+    mSrc = src;
+}
+
+}  // namespace android
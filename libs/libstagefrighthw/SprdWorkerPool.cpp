@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SprdWorkerPool"
+#include <utils/Log.h>
+#include <stdio.h>
+
+#include "include/SprdWorkerPool.h"
+
+namespace android {
+
+SprdWorkerPool::Worker::Worker(SprdWorkerPool *pool, int band)
+    : Thread(false),
+      mPool(pool),
+      mBand(band),
+      mGeneration(0) {
+}
+
+bool SprdWorkerPool::Worker::threadLoop() {
+    BandFunc func;
+    void *job;
+    int bands;
+
+    {
+        Mutex::Autolock autoLock(mPool->mLock);
+
+        while (!mPool->mExit && mPool->mGeneration == mGeneration) {
+            mPool->mWorkCondition.wait(mPool->mLock);
+        }
+
+        if (mPool->mExit) {
+            return false;
+        }
+
+        mGeneration = mPool->mGeneration;
+        func = mPool->mFunc;
+        job = mPool->mJob;
+        bands = mPool->mWorkers.size();
+    }
+
+    func(job, mBand, bands);
+
+    Mutex::Autolock autoLock(mPool->mLock);
+    if (--mPool->mPending == 0) {
+        mPool->mDoneCondition.broadcast();
+    }
+
+    return true;
+}
+
+SprdWorkerPool::SprdWorkerPool(const char *name, int threads, int32_t priority)
+    : mFunc(NULL),
+      mJob(NULL),
+      mGeneration(0),
+      mPending(0),
+      mExit(false) {
+    Mutex::Autolock autoLock(mLock);
+
+    for (int i = 0; i < threads; i++) {
+        char thread_name[32];
+        snprintf(thread_name, sizeof(thread_name), "%s_%d", name, i);
+
+        sp<Worker> worker = new Worker(this, mWorkers.size());
+        if (worker->run(thread_name, priority) != OK) {
+            ALOGE("%s: failed to start worker %d, %d bands", name, i, (int)mWorkers.size());
+            break;
+        }
+        mWorkers.push(worker);
+    }
+}
+
+SprdWorkerPool::~SprdWorkerPool() {
+    join();
+
+    {
+        Mutex::Autolock autoLock(mLock);
+        mExit = true;
+        mWorkCondition.broadcast();
+    }
+
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        mWorkers.editItemAt(i)->requestExitAndWait();
+    }
+    mWorkers.clear();
+}
+
+int SprdWorkerPool::bands() const {
+    return mWorkers.isEmpty() ? 1 : mWorkers.size();
+}
+
+void SprdWorkerPool::fork(BandFunc func, void *job) {
+    if (mWorkers.isEmpty()) {
+        func(job, 0, 1);
+        return;
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    LOG_ALWAYS_FATAL_IF(mPending != 0, "fork before the last fork was joined");
+
+    mFunc = func;
+    mJob = job;
+    mPending = mWorkers.size();
+    mGeneration++;
+    mWorkCondition.broadcast();
+}
+
+void SprdWorkerPool::join() {
+    Mutex::Autolock autoLock(mLock);
+
+    while (mPending > 0) {
+        mDoneCondition.wait(mLock);
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SprdYuvConvert"
+#include <utils/Log.h>
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "include/SprdYuvConvert.h"
+#include "include/SprdWorkerPool.h"
+
+namespace android {
+
+// d[2i] = a[i], d[2i + 1] = b[i] for n pairs.
+static void interleaveRow(uint8_t *d, const uint8_t *a, const uint8_t *b, int n) {
+    int i = 0;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t t;
+        t.val[0] = vld1q_u8(a + i);
+        t.val[1] = vld1q_u8(b + i);
+        vst2q_u8(d + 2 * i, t);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(d + 2 * i), _mm_unpacklo_epi8(x, y));
+        _mm_storeu_si128((__m128i *)(d + 2 * i + 16), _mm_unpackhi_epi8(x, y));
+    }
+#endif
+
+    for (; i < n; i++) {
+        d[2 * i] = a[i];
+        d[2 * i + 1] = b[i];
+    }
+}
+
+// a[i] = s[2i], b[i] = s[2i + 1] for n pairs.
+static void splitRow(uint8_t *a, uint8_t *b, const uint8_t *s, int n) {
+    int i = 0;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t t = vld2q_u8(s + 2 * i);
+        vst1q_u8(a + i, t.val[0]);
+        vst1q_u8(b + i, t.val[1]);
+    }
+#elif defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0xff);
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + 2 * i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(s + 2 * i + 16));
+        _mm_storeu_si128((__m128i *)(a + i),
+                         _mm_packus_epi16(_mm_and_si128(x, mask), _mm_and_si128(y, mask)));
+        _mm_storeu_si128((__m128i *)(b + i),
+                         _mm_packus_epi16(_mm_srli_epi16(x, 8), _mm_srli_epi16(y, 8)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        a[i] = s[2 * i];
+        b[i] = s[2 * i + 1];
+    }
+}
+
+// The bytes of each of n pairs swapped.
+static void swapRow(uint8_t *d, const uint8_t *s, int n) {
+    int i = 0;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        vst1q_u8(d + 2 * i, vrev16q_u8(vld1q_u8(s + 2 * i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + 2 * i));
+        _mm_storeu_si128((__m128i *)(d + 2 * i),
+                         _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        d[2 * i] = s[2 * i + 1];
+        d[2 * i + 1] = s[2 * i];
+    }
+}
+
+// The start of an interleaved chroma row, whichever of U and V is first.
+static uint8_t *pairs(const SprdYuvConvert::Frame &f) {
+    return (f.u < f.v) ? f.u : f.v;
+}
+
+static bool fits(const SprdYuvConvert::Frame &f, int width, int height) {
+    size_t uvWidth = (width + 1) / 2;
+
+    if (width <= 0 || height <= 0 || f.y == NULL || f.u == NULL || f.v == NULL) {
+        return false;
+    }
+    if (f.uvStep == 2) {
+        if (f.u + 1 != f.v && f.v + 1 != f.u) {
+            return false;
+        }
+    } else if (f.uvStep != 1) {
+        return false;
+    }
+    return f.yStride >= (size_t)width && f.uvStride >= uvWidth * f.uvStep;
+}
+
+namespace {
+
+struct Job {
+    const SprdYuvConvert::Frame *src;
+    const SprdYuvConvert::Frame *dst;
+    int width;
+    int height;
+};
+
+}  // namespace
+
+// Chroma rows [first, last) and the luma rows that go with them.
+static void convertRows(const Job *j, int first, int last) {
+    const SprdYuvConvert::Frame &s = *j->src;
+    const SprdYuvConvert::Frame &d = *j->dst;
+    int uvWidth = (j->width + 1) / 2;
+    int yLast = (2 * last < j->height) ? 2 * last : j->height;
+
+    for (int row = 2 * first; row < yLast; row++) {
+        memcpy(d.y + row * d.yStride, s.y + row * s.yStride, j->width);
+    }
+
+    for (int row = first; row < last; row++) {
+        size_t so = row * s.uvStride;
+        size_t doff = row * d.uvStride;
+
+        if (s.uvStep == 1 && d.uvStep == 1) {
+            memcpy(d.u + doff, s.u + so, uvWidth);
+            memcpy(d.v + doff, s.v + so, uvWidth);
+        } else if (s.uvStep == 1) {
+            if (d.u < d.v) {
+                interleaveRow(d.u + doff, s.u + so, s.v + so, uvWidth);
+            } else {
+                interleaveRow(d.v + doff, s.v + so, s.u + so, uvWidth);
+            }
+        } else if (d.uvStep == 1) {
+            if (s.u < s.v) {
+                splitRow(d.u + doff, d.v + doff, s.u + so, uvWidth);
+            } else {
+                splitRow(d.v + doff, d.u + doff, s.v + so, uvWidth);
+            }
+        } else if ((s.u < s.v) == (d.u < d.v)) {
+            memcpy(pairs(d) + doff, pairs(s) + so, 2 * uvWidth);
+        } else {
+            swapRow(pairs(d) + doff, pairs(s) + so, uvWidth);
+        }
+    }
+}
+
+// One band of the chroma rows, so that every band starts on an even
+// luma row.
+static void convertBand(void *job, int band, int bands) {
+    Job *j = (Job *)job;
+    int uvHeight = (j->height + 1) / 2;
+
+    convertRows(j, uvHeight * band / bands, uvHeight * (band + 1) / bands);
+}
+
+// static
+void SprdYuvConvert::layout(Frame *frame, Format format, uint8_t *data,
+                            size_t stride, size_t sliceHeight) {
+    uint8_t *chroma = data + stride * sliceHeight;
+
+    frame->y = data;
+    frame->yStride = stride;
+
+    switch (format) {
+        case I420:
+        case YV12:
+        {
+            uint8_t *second = chroma + (stride + 1) / 2 * ((sliceHeight + 1) / 2);
+            frame->u = (format == I420) ? chroma : second;
+            frame->v = (format == I420) ? second : chroma;
+            frame->uvStride = (stride + 1) / 2;
+            frame->uvStep = 1;
+            break;
+        }
+
+        case NV12:
+        case NV21:
+        default:
+            frame->u = (format == NV21) ? chroma + 1 : chroma;
+            frame->v = (format == NV21) ? chroma : chroma + 1;
+            frame->uvStride = (stride + 1) & ~1;
+            frame->uvStep = 2;
+            break;
+    }
+}
+
+// static
+size_t SprdYuvConvert::frameSize(Format format, size_t stride, size_t sliceHeight) {
+    size_t uvHeight = (sliceHeight + 1) / 2;
+
+    if (format == I420 || format == YV12) {
+        return stride * sliceHeight + 2 * ((stride + 1) / 2) * uvHeight;
+    }
+    return stride * sliceHeight + ((stride + 1) & ~1) * uvHeight;
+}
+
+// static
+bool SprdYuvConvert::convert(const Frame &src, const Frame &dst, int width, int height,
+                             SprdWorkerPool *pool) {
+    if (!fits(src, width, height) || !fits(dst, width, height)) {
+        ALOGE("%s, %dx%d doesn't fit, strides %d/%d -> %d/%d", __FUNCTION__, width, height,
+              (int)src.yStride, (int)src.uvStride, (int)dst.yStride, (int)dst.uvStride);
+        return false;
+    }
+
+    Job job;
+    job.src = &src;
+    job.dst = &dst;
+    job.width = width;
+    job.height = height;
+
+    if (pool != NULL && width * height >= kMinParallelPixels) {
+        pool->fork(convertBand, &job);
+        pool->join();
+    } else {
+        convertBand(&job, 0, 1);
+    }
+
+    return true;
+}
+
+// static
+bool SprdYuvConvert::convertReference(const Frame &src, const Frame &dst, int width, int height) {
+    if (!fits(src, width, height) || !fits(dst, width, height)) {
+        return false;
+    }
+
+    for (int row = 0; row < height; row++) {
+        for (int x = 0; x < width; x++) {
+            dst.y[row * dst.yStride + x] = src.y[row * src.yStride + x];
+        }
+    }
+
+    for (int row = 0; row < (height + 1) / 2; row++) {
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            dst.u[row * dst.uvStride + x * dst.uvStep] = src.u[row * src.uvStride + x * src.uvStep];
+            dst.v[row * dst.uvStride + x * dst.uvStep] = src.v[row * src.uvStride + x * src.uvStep];
+        }
+    }
+
+    return true;
+}
+
+}  // namespace android
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPRD_BANDWIDTH_GOVERNOR_H_
+
+#define SPRD_BANDWIDTH_GOVERNOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+#define SPRD_DMCFREQ_NODE "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq"
+
+namespace android {
+
+// Votes for the DDR frequency the hardware codecs of this process need.
+// Every codec session reports its frames. The memory traffic of a
+// session is estimated from its frame size, frame rate and bitstream
+// rate. A session whose frames take most of the frame interval asks for
+// a step more, one whose frames take little of it for a step less. The
+// vote covers the sum of all sessions. It rises at once and falls after
+// kHoldFrames frames, or at once when a session closes.
+struct SprdBandwidthGovernor {
+    enum Kind {
+        DECODER,
+        ENCODER,
+    };
+
+    enum {
+        // Frames whose times give the frame rate.
+        kWindow = 16,
+        // Frames the vote waits before it goes down.
+        kHoldFrames = 30,
+        // Percent of the frame interval spent coding above which a
+        // session asks for a step more, and below which a step less.
+        kLoadHighPct = 75,
+        kLoadLowPct = 30,
+    };
+
+    // The governor of this process, voting through SPRD_DMCFREQ_NODE.
+    static SprdBandwidthGovernor *getInstance();
+
+    explicit SprdBandwidthGovernor(const char *node);
+    ~SprdBandwidthGovernor();
+
+    // A session votes from open() until close(), open() returns its id.
+    int open(Kind kind);
+    void close(int id);
+
+    // The coded frame size, bidir when B-frames read two references.
+    void setFormat(int id, int width, int height, bool bidir);
+
+    // The hardware spent codingUs on the frame at timeUs, which has bytes
+    // of bitstream. The slices of a frame may be reported one by one.
+    void onFrame(int id, int64_t timeUs, int64_t codingUs, size_t bytes);
+
+    // The frequency in kHz voted for, 0 when there is no vote.
+    uint32_t vote();
+
+private:
+    struct Session {
+        int mId;
+        Kind mKind;
+        int mWidth;
+        int mHeight;
+        bool mBidir;
+
+        int64_t mTimes[kWindow];
+        int mNumTimes;
+        int mNextTime;
+
+        int64_t mFrameTimeUs;
+        int64_t mFrameCodingUs;
+        size_t mFrameBytes;
+
+        int64_t mAvgCodingUs;
+        int64_t mAvgBytes;
+        int mStep;
+        int mIdleFrames;
+    };
+
+    Mutex mLock;
+    char mNode[128];
+    int mFd;
+    Vector<Session> mSessions;
+    int mNextId;
+    int mLevel;
+    int mHeldFrames;
+
+    Session *findSession(int id);
+    void endFrame(Session *s);
+    int64_t frameRate(const Session *s) const;
+    int64_t bandwidth(const Session *s) const;
+    void update(bool now);
+    bool write(uint32_t khz);
+
+    SprdBandwidthGovernor(const SprdBandwidthGovernor &);
+    SprdBandwidthGovernor &operator=(const SprdBandwidthGovernor &);
+};
+
+}  // namespace android
+
+#endif  // SPRD_BANDWIDTH_GOVERNOR_H_
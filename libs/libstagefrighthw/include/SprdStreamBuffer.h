@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPRD_STREAM_BUFFER_H_
+
+#define SPRD_STREAM_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// Hands a decoder the bitstream it reads next. Bitstream in an input
+// buffer allocated from ION is read in place. Anything else is copied
+// into the stream heap once and read from there until the decoder has
+// consumed it, however many decode calls that takes. In an H.264 byte
+// stream a NAL unit that starts at an address the hardware can't start
+// reading at gets zero bytes in front of its start code, written over
+// bytes already consumed, rather than being copied again.
+struct SprdStreamBuffer {
+    enum {
+        // Bytes an allocated input buffer keeps in front of pBuffer,
+        // a start code is put there when the bitstream lacks one.
+        kHeadroom = 64,
+        // Bytes after the bitstream the hardware may prefetch.
+        kTailroom = 256,
+        // The address the decoder starts reading at is aligned to this.
+        kAlign = 8,
+    };
+
+    SprdStreamBuffer();
+
+    // The heap copies are made into, phys is 0 for a software decoder.
+    void setHeap(uint8_t *data, uint32_t phys, size_t size);
+
+    // The bitstream is an H.264 byte stream, whose start codes may have
+    // any number of zero bytes in front.
+    void setByteStream(bool byteStream) { mByteStream = byteStream; }
+
+    // Set up the span for len bytes of bitstream at src. srcPhys is the
+    // address of src when it lies in an allocated input buffer and 0
+    // otherwise, writable is the number of bytes before src that may be
+    // overwritten. With startCode the span begins with 00 00 00 01,
+    // possibly after zero bytes. Returns false when the bitstream
+    // doesn't fit into the heap.
+    bool prepare(uint8_t *src, uint32_t srcPhys, size_t writable,
+                 size_t len, bool startCode);
+
+    uint8_t *data() const { return mData; }
+    uint32_t phys() const { return mPhys; }
+    size_t length() const { return mLength; }
+
+    // The decoder read n bytes from the front of the span. Returns how
+    // many of them came from src, an inserted start code or zero bytes
+    // don't count.
+    size_t consume(size_t n);
+
+    // Forget the span, its source buffer has been returned or flushed.
+    void reset();
+
+    // Bytes copied into the heap and bytes the decoder consumed in
+    // place so far.
+    uint64_t copiedBytes() const { return mCopiedBytes; }
+    uint64_t inPlaceBytes() const { return mInPlaceBytes; }
+
+private:
+    uint8_t *mHeap;
+    uint32_t mHeapPhys;
+    size_t mHeapSize;
+    bool mByteStream;
+
+    uint8_t *mData;
+    uint32_t mPhys;
+    size_t mLength;
+    size_t mPrefixLength;
+    bool mInHeap;
+    uint8_t *mSrc;
+
+    uint64_t mCopiedBytes;
+    uint64_t mInPlaceBytes;
+
+    void setSpan(uint8_t *data, uint32_t phys, size_t len,
+                 size_t prefixLength, bool inHeap, uint8_t *src);
+
+    SprdStreamBuffer(const SprdStreamBuffer &);
+    SprdStreamBuffer &operator=(const SprdStreamBuffer &);
+};
+
+}  // namespace android
+
+#endif  // SPRD_STREAM_BUFFER_H_
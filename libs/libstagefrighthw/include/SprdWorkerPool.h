@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPRD_WORKER_POOL_H_
+#define SPRD_WORKER_POOL_H_
+
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// Worker threads that live as long as the pool. A job is forked to
+// them one band per worker and joined on a condition, without polling.
+struct SprdWorkerPool {
+    typedef void (*BandFunc)(void *job, int band, int bands);
+
+    SprdWorkerPool(const char *name, int threads, int32_t priority);
+    ~SprdWorkerPool();
+
+    // The number of bands a fork is split into, the calling thread
+    // runs the only band when no worker could be started.
+    int bands() const;
+
+    // Start func(job, band, bands) for every band and return, the
+    // previous fork must have been joined.
+    void fork(BandFunc func, void *job);
+
+    // Wait until every band of the last fork has returned.
+    void join();
+
+private:
+    struct Worker : public Thread {
+        Worker(SprdWorkerPool *pool, int band);
+
+        virtual bool threadLoop();
+
+        SprdWorkerPool *mPool;
+        int mBand;
+        uint32_t mGeneration;
+    };
+
+    Mutex mLock;
+    Condition mWorkCondition;
+    Condition mDoneCondition;
+    BandFunc mFunc;
+    void *mJob;
+    uint32_t mGeneration;
+    int mPending;
+    bool mExit;
+    Vector<sp<Worker> > mWorkers;
+
+    SprdWorkerPool(const SprdWorkerPool &);
+    SprdWorkerPool &operator=(const SprdWorkerPool &);
+};
+
+}  // namespace android
+
+#endif  // SPRD_WORKER_POOL_H_
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPRD_YUV_CONVERT_H_
+
+#define SPRD_YUV_CONVERT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+struct SprdWorkerPool;
+
+// Converts 4:2:0 frames between I420, YV12, NV12 and NV21, of any size
+// and stride. Luma is copied a row at a time, chroma is copied,
+// interleaved, split or swapped a row at a time, with NEON or SSE2 where
+// the build has them. Large frames are split into bands of rows across
+// a worker pool.
+struct SprdYuvConvert {
+    enum Format {
+        I420,   // Y plane, U plane, V plane
+        YV12,   // Y plane, V plane, U plane
+        NV12,   // Y plane, U and V interleaved
+        NV21,   // Y plane, V and U interleaved
+    };
+
+    enum {
+        // Frames of fewer pixels are converted by the calling thread.
+        kMinParallelPixels = 640 * 480,
+    };
+
+    // Where the planes of a frame are. u and v point to the first U and
+    // V sample, uvStep is 1 for planar chroma and 2 for interleaved.
+    struct Frame {
+        uint8_t *y;
+        uint8_t *u;
+        uint8_t *v;
+        size_t yStride;
+        size_t uvStride;
+        int uvStep;
+    };
+
+    // The planes of a frame of format laid out one after another from
+    // data, stride bytes per luma row and sliceHeight luma rows. Planar
+    // chroma rows are half the stride, interleaved ones the stride,
+    // both rounded up.
+    static void layout(Frame *frame, Format format, uint8_t *data,
+                       size_t stride, size_t sliceHeight);
+
+    // The bytes of such a frame.
+    static size_t frameSize(Format format, size_t stride, size_t sliceHeight);
+
+    // Convert width x height pixels of src to dst, which must not
+    // overlap. Bytes of dst outside the picture are left alone. A frame
+    // of kMinParallelPixels or more is split across pool when there is
+    // one. Returns false when a plane is smaller than the picture.
+    static bool convert(const Frame &src, const Frame &dst, int width, int height,
+                        SprdWorkerPool *pool);
+
+    // The same a byte at a time, what the others are checked against.
+    static bool convertReference(const Frame &src, const Frame &dst, int width, int height);
+};
+
+}  // namespace android
+
+#endif  // SPRD_YUV_CONVERT_H_
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ImaAdpcm.h"
+
+namespace android {
+
+/* First table lookup for Ima-ADPCM quantizer */
+static const int8_t IndexAdjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/* Second table lookup for Ima-ADPCM quantizer */
+static const short StepSize[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+enum {
+    kMaxChannels = 2,
+    kCodes = 16,
+};
+
+// What a code does at a step index: the delta to the predicted value
+// and the row of the next step index. The row is the index times
+// kCodes, so that a code picks its entry with one add.
+struct Step {
+    int32_t delta;
+    int32_t next;
+};
+
+static struct StepTable {
+    Step steps[(ImaAdpcm::kMaxStepIndex + 1) * kCodes];
+
+    StepTable() {
+        for (int index = 0; index <= ImaAdpcm::kMaxStepIndex; index++) {
+            for (int code = 0; code < kCodes; code++) {
+                // Computes (code + 0.5) * step / 4 with the bit loop of the
+                // reference decoder, in shorts as it does, so that the
+                // largest steps wrap the same way.
+                short step = StepSize[index];
+                short diff = step >> 3;
+                for (int i = 0x4; i; i >>= 1, step >>= 1) {
+                    if (code & i) {
+                        diff += step;
+                    }
+                }
+
+                int next = index + IndexAdjust[code & 0x7];
+                if (next < 0) {
+                    next = 0;
+                } else if (next > ImaAdpcm::kMaxStepIndex) {
+                    next = ImaAdpcm::kMaxStepIndex;
+                }
+
+                Step *s = &steps[index * kCodes + code];
+                s->delta = (code & 0x8) ? -diff : diff;
+                s->next = next * kCodes;
+            }
+        }
+    }
+} sTable;
+
+static inline int clamp16(int value) {
+    if ((unsigned)(value + 32768) > 65535) {
+        value = (value < 0) ? -32768 : 32767;
+    }
+    return value;
+}
+
+// The step index of a block header, the reference decoder doesn't
+// check it and reads past StepSize.
+static inline int headerRow(int index) {
+    if (index < 0) {
+        index = 0;
+    } else if (index > ImaAdpcm::kMaxStepIndex) {
+        index = ImaAdpcm::kMaxStepIndex;
+    }
+    return index * kCodes;
+}
+
+// The n samples of a group of one channel, n is below kGroupSamples in
+// the last group of a block only.
+static inline void decodeGroup(int16_t *out, int stride, const uint8_t *in, int n,
+                               int *pred, int *row) {
+    uint32_t codes;
+    if (n == ImaAdpcm::kGroupSamples) {
+        codes = in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    } else {
+        codes = 0;
+        for (int i = 0; i < (n + 1) / 2; i++) {
+            codes |= (uint32_t)in[i] << (8 * i);
+        }
+    }
+
+    int p = *pred;
+    int r = *row;
+    for (int i = 0; i < n; i++, codes >>= 4) {
+        const Step *s = &sTable.steps[r + (codes & 0xf)];
+        p = clamp16(p + s->delta);
+        r = s->next;
+        *out = p;
+        out += stride;
+    }
+    *pred = p;
+    *row = r;
+}
+
+static inline void encodeGroup(uint8_t *out, const int16_t *in, int stride, int n,
+                               int *pred, int *row) {
+    uint32_t codes = 0;
+    int p = *pred;
+    int r = *row;
+
+    for (int i = 0; i < n; i++, in += stride) {
+        // The code whose value comes nearest, among those of the sign
+        // of the difference.
+        int sample = *in;
+        int first = (sample < p) ? 0x8 : 0;
+        int code = first;
+        int value = clamp16(p + sTable.steps[r + first].delta);
+        int error = (sample > value) ? sample - value : value - sample;
+        for (int c = first + 1; c < first + 8; c++) {
+            int v = clamp16(p + sTable.steps[r + c].delta);
+            int e = (sample > v) ? sample - v : v - sample;
+            if (e < error) {
+                code = c;
+                value = v;
+                error = e;
+            }
+        }
+
+        codes |= (uint32_t)code << (4 * i);
+        p = value;
+        r = sTable.steps[r + code].next;
+    }
+
+    out[0] = codes;
+    out[1] = codes >> 8;
+    out[2] = codes >> 16;
+    out[3] = codes >> 24;
+    *pred = p;
+    *row = r;
+}
+
+// static
+size_t ImaAdpcm::blockSamples(size_t blockAlign, int channels) {
+    if (channels < 1 || channels > kMaxChannels || blockAlign < (size_t)kHeaderSize * channels) {
+        return 0;
+    }
+    return ((blockAlign / channels - kHeaderSize) << 1) + 1;
+}
+
+// static
+void ImaAdpcm::decodeBlock(int16_t *out, const uint8_t *in, int channels, size_t blockAlign) {
+    int frames = blockSamples(blockAlign, channels);
+    int pred[kMaxChannels];
+    int row[kMaxChannels];
+
+    if (frames == 0) {
+        return;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        pred[ch] = (int16_t)(in[0] | (in[1] << 8));
+        row[ch] = headerRow(in[2]);
+        out[ch] = pred[ch];
+        in += kHeaderSize;
+    }
+    out += channels;
+    frames--;
+
+    while (frames > 0) {
+        int n = (frames > kGroupSamples) ? kGroupSamples : frames;
+        for (int ch = 0; ch < channels; ch++) {
+            decodeGroup(out + ch, channels, in, n, &pred[ch], &row[ch]);
+            in += kGroupSize;
+        }
+        out += kGroupSamples * channels;
+        frames -= kGroupSamples;
+    }
+}
+
+// static
+void ImaAdpcm::encodeBlock(uint8_t *out, const int16_t *in, int channels, size_t blockAlign,
+                           int *stepIndex) {
+    int frames = blockSamples(blockAlign, channels);
+    int pred[kMaxChannels];
+    int row[kMaxChannels];
+
+    if (frames == 0) {
+        return;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        pred[ch] = in[ch];
+        row[ch] = headerRow(stepIndex[ch]);
+        out[0] = pred[ch];
+        out[1] = pred[ch] >> 8;
+        out[2] = row[ch] / kCodes;
+        out[3] = 0;
+        out += kHeaderSize;
+    }
+    in += channels;
+    frames--;
+
+    while (frames > 0) {
+        int n = (frames > kGroupSamples) ? kGroupSamples : frames;
+        for (int ch = 0; ch < channels; ch++) {
+            encodeGroup(out, in + ch, channels, n, &pred[ch], &row[ch]);
+            out += kGroupSize;
+        }
+        in += kGroupSamples * channels;
+        frames -= kGroupSamples;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        stepIndex[ch] = row[ch] / kCodes;
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMA_ADPCM_H_
+
+#define IMA_ADPCM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// IMA ADPCM blocks as WAV files carry them: a 4 byte header for every
+// channel, then groups of 4 bytes, 8 samples, for every channel in turn.
+// Both directions step through one table of the delta and the next
+// step index for every step index and code.
+struct ImaAdpcm {
+    enum {
+        kHeaderSize = 4,
+        kGroupSize = 4,
+        kGroupSamples = 8,
+        kMaxStepIndex = 88,
+    };
+
+    // Samples of a channel in a block of blockAlign bytes.
+    static size_t blockSamples(size_t blockAlign, int channels);
+
+    // The block at in to blockSamples() interleaved frames at out.
+    static void decodeBlock(int16_t *out, const uint8_t *in, int channels, size_t blockAlign);
+
+    // blockSamples() interleaved frames at in to the block at out.
+    // stepIndex holds the step index of every channel from one block to
+    // the next, a stream starts with 0.
+    static void encodeBlock(uint8_t *out, const int16_t *in, int channels, size_t blockAlign,
+                            int *stepIndex);
+};
+
+}  // namespace android
+
+#endif  // IMA_ADPCM_H_
@@ -2,14 +2,17 @@ LOCAL_PATH:= $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES := \
-        SoftIMAADPCM.cpp
+        SoftIMAADPCM.cpp \
+        ../common/ImaAdpcm.cpp
 
 LOCAL_C_INCLUDES := \
         frameworks/av/media/libstagefright/include \
-        frameworks/native/include/media/openmax
+        frameworks/native/include/media/openmax \
+        $(LOCAL_PATH)/../common \
+        $(TOP)/vendor/sprd/open-source/libs/libstagefrighthw/include
 
 LOCAL_SHARED_LIBRARIES := \
-        libstagefright libstagefright_omx libstagefright_foundation libutils liblog
+        libstagefright libstagefright_omx libstagefright_foundation libstagefrighthw libutils liblog
 
 LOCAL_MODULE := libstagefright_soft_imaadpcmdec
 LOCAL_MODULE_TAGS := optional
@@ -19,6 +19,8 @@
 #include <utils/Log.h>
 
 #include "SoftIMAADPCM.h"
+#include "ImaAdpcm.h"
+#include "SprdWorkerPool.h"
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MediaDefs.h>
@@ -43,13 +45,18 @@ SoftIMAADPCM::SoftIMAADPCM(
       mNumChannels(1),
       mSamplingRate(8000),
       mBlockAlign(0x400),
-      mSignalledError(false) {
+      mSignalledError(false),
+      mPool(NULL) {
     CHECK(!strcmp(name, "OMX.google.imaadpcm.decoder"));
 
     initPorts();
+
+    mPool = new SprdWorkerPool("imaadpcmdec", kNumDecodeThreads, ANDROID_PRIORITY_AUDIO);
 }
 
 SoftIMAADPCM::~SoftIMAADPCM() {
+    delete mPool;
+    mPool = NULL;
 }
 
 void SoftIMAADPCM::initPorts() {
@@ -166,6 +173,10 @@ OMX_ERRORTYPE SoftIMAADPCM::internalSetParameter(
                 return OMX_ErrorUndefined;
             }
 
+            if (ImaAdpcm::blockSamples(imaadpcmParams->nBlockAlign, imaadpcmParams->nChannels) == 0) {
+                return OMX_ErrorUndefined;
+            }
+
             mNumChannels = imaadpcmParams->nChannels;
             mSamplingRate = imaadpcmParams->nSampleRate;
             mBlockAlign = imaadpcmParams->nBlockAlign;
@@ -221,8 +232,7 @@ void SoftIMAADPCM::onQueueFilled(OMX_U32 portIndex) {
             return;
         }
 
-        int samples_per_frame;
-        samples_per_frame = ((mBlockAlign / mNumChannels - 4) << 1) + 1;
+        int samples_per_frame = ImaAdpcm::blockSamples(mBlockAlign, mNumChannels);
         if (inHeader->nFilledLen%mBlockAlign != 0) {
             ALOGW("WARNING! input buffer corrupt, len=%d, ba=%d", inHeader->nFilledLen, mBlockAlign);
         }
@@ -230,24 +240,30 @@ void SoftIMAADPCM::onQueueFilled(OMX_U32 portIndex) {
         if (inHeader->nFilledLen/mBlockAlign*samples_per_frame > kMaxNumSamplesPerFrame) {
             ALOGE("input buffer too large (%ld).", inHeader->nFilledLen);
 
+            notify(OMX_EventError, OMX_ErrorUndefined, 0, NULL);
             mSignalledError = true;
+            return;
         }
 
-        const uint8_t *inputPtr = inHeader->pBuffer + inHeader->nOffset;
-        int inputLength = inHeader->nFilledLen;
-
-        int16_t *outputPtr = reinterpret_cast<int16_t *>(outHeader->pBuffer);
-        int frames = 0;
-        while (inputLength >= mBlockAlign) {
-            DecodeIMAADPCM(
-                outputPtr,
-                inputPtr, mNumChannels, mBlockAlign);
-            inputLength -= mBlockAlign;
-            inputPtr += mBlockAlign;
-            outputPtr += samples_per_frame * mNumChannels;
-            frames += samples_per_frame;
+        DecodeJob job;
+        job.out = reinterpret_cast<int16_t *>(outHeader->pBuffer);
+        job.in = inHeader->pBuffer + inHeader->nOffset;
+        job.channels = mNumChannels;
+        job.blockAlign = mBlockAlign;
+        job.blockSamples = samples_per_frame;
+        job.blocks = inHeader->nFilledLen / mBlockAlign;
+
+        // The blocks don't depend on each other, a large buffer is
+        // decoded a share of its blocks per thread.
+        if (job.blocks >= kMinParallelBlocks) {
+            mPool->fork(DecodeBand, &job);
+            mPool->join();
+        } else {
+            DecodeBand(&job, 0, 1);
         }
 
+        int frames = job.blocks * samples_per_frame;
+
         outHeader->nTimeStamp = inHeader->nTimeStamp;
         outHeader->nOffset = 0;
         outHeader->nFilledLen = frames * mNumChannels * sizeof(int16_t);
@@ -267,151 +283,15 @@ void SoftIMAADPCM::onQueueFilled(OMX_U32 portIndex) {
     }
 }
 
-static void _adpcm_decode_frame(int16_t **dst_ptrs,
-                          int dst_step,
-                          const uint8_t *src_frame_ptr,
-                          int frames,
-                          int channels
-                          );
-
 // static
-void SoftIMAADPCM::DecodeIMAADPCM(
-        int16_t *out, const uint8_t *in, int channels, size_t inSize) {
-        int frames = ((inSize / channels - 4) << 1) + 1;
-        int16_t *dst[2];
-        dst[0] = out;
-        dst[1] = out+1;
-        _adpcm_decode_frame(dst, channels, in, frames, channels);
-}
-
-/* First table lookup for Ima-ADPCM quantizer */
-static const int8_t IndexAdjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
-
-/* Second table lookup for Ima-ADPCM quantizer */
-static const short StepSize[89] = {
-	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
-	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
-	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
-	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
-	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
-	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
-	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
-	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
-	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
-};
-
-typedef struct _ima_adpcm_state {
-	int pred_val;		/* Calculated predicted value */
-	int step_idx;		/* Previous StepSize lookup index */
-} ima_adpcm_state_t;
-
-static int adpcm_decoder(unsigned char code, ima_adpcm_state_t * state)
-{
-	short pred_diff;	/* Predicted difference to next sample */
-	short step;		/* holds previous StepSize value */
-	char sign;
-
-	int i;
-
-	/* Separate sign and magnitude */
-	sign = code & 0x8;
-	code &= 0x7;
-
-	/*
-	 * Computes pred_diff = (code + 0.5) * step / 4,
-	 * but see comment in adpcm_coder.
-	 */
-
-	step = StepSize[state->step_idx];
-
-	/* Compute difference and new predicted value */
-	pred_diff = step >> 3;
-	for (i = 0x4; i; i >>= 1, step >>= 1) {
-		if (code & i) {
-			pred_diff += step;
-		}
-	}
-	state->pred_val += (sign) ? -pred_diff : pred_diff;
-
-	/* Clamp output value */
-	if (state->pred_val > 32767) {
-		state->pred_val = 32767;
-	} else if (state->pred_val < -32768) {
-		state->pred_val = -32768;
-	}
-
-	/* Find new StepSize index value */
-	state->step_idx += IndexAdjust[code];
-
-	if (state->step_idx < 0) {
-		state->step_idx = 0;
-	} else if (state->step_idx > 88) {
-		state->step_idx = 88;
-	}
-	return (state->pred_val);
-}
-
-static void _adpcm_decode_mono(int16_t *dst_ptr,
-			  int dst_step,
-			  const uint8_t *src_ptr,
-			  unsigned int frames,
-			  ima_adpcm_state_t *states)
-{
-    int srcbit = 0;
-	while (frames-- > 0) {
-		unsigned char v;
-		if (!srcbit)
-			v = *src_ptr & 0x0f;
-		else
-			v = (*src_ptr >> 4) & 0x0f;
-		*dst_ptr = adpcm_decoder(v, states);
-		srcbit ++;
-		if (srcbit == 2) {
-			src_ptr++;
-			srcbit = 0;
-		}
-		dst_ptr += dst_step;
-	}
-}
-
-static void _adpcm_decode_frame(int16_t **dst_ptrs,
-			  int dst_step,
-			  const uint8_t *src_frame_ptr,
-			  int frames,
-			  int channels
-			  )
-{
-    ima_adpcm_state_t state[2];
-    int16_t *dst_ptr[2];
-    int i;
-    assert(channels==1 || channels==2);
-    // parse headers
-    for (i=0; i<channels; i++)
-    {
-        state[i].pred_val = ((int16_t)(src_frame_ptr[0] | (src_frame_ptr[1]<<8)));
-        src_frame_ptr+=2;
-        state[i].step_idx = *src_frame_ptr;
-        src_frame_ptr+=2;
-        dst_ptr[i] = dst_ptrs[i];
-        *dst_ptr[i] = state[i].pred_val;
-        dst_ptr[i] += dst_step;
-    }
-    frames --;
-    // decode samples
-    while (frames>0)
-    {
-        for (i=0; i<channels; i++)
-        {
-            int decoded_fremes = frames > 8 ? 8 : frames;
-            _adpcm_decode_mono(dst_ptr[i],
-                      dst_step,
-                      src_frame_ptr,
-                      decoded_fremes, // max 8 samples per group
-                      &state[i]);
-            src_frame_ptr += 4;
-            dst_ptr[i] += 8*dst_step;
-        }
-        frames -= 8;
+void SoftIMAADPCM::DecodeBand(void *job, int band, int bands) {
+    DecodeJob *j = (DecodeJob *)job;
+    size_t first = j->blocks * band / bands;
+    size_t last = j->blocks * (band + 1) / bands;
+
+    for (size_t i = first; i < last; i++) {
+        ImaAdpcm::decodeBlock(j->out + i * j->blockSamples * j->channels,
+                              j->in + i * j->blockAlign, j->channels, j->blockAlign);
     }
 }
 
@@ -22,6 +22,8 @@
 
 namespace android {
 
+struct SprdWorkerPool;
+
 struct SoftIMAADPCM : public SimpleSoftOMXComponent {
     SoftIMAADPCM(const char *name,
             const OMX_CALLBACKTYPE *callbacks,
@@ -42,17 +44,29 @@ protected:
 private:
     enum {
         kNumBuffers = 4,
-        kMaxNumSamplesPerFrame = 131072*4
+        kMaxNumSamplesPerFrame = 131072*4,
+        kNumDecodeThreads = 2,
+        kMinParallelBlocks = 8
+    };
+
+    struct DecodeJob {
+        int16_t *out;
+        const uint8_t *in;
+        int channels;
+        size_t blockAlign;
+        size_t blockSamples;
+        size_t blocks;
     };
 
     OMX_U32 mNumChannels;
     OMX_U32 mSamplingRate;
     OMX_U32 mBlockAlign;
     bool mSignalledError;
+    SprdWorkerPool *mPool;
 
     void initPorts();
 
-    static void DecodeIMAADPCM(int16_t *out, const uint8_t *in, int channels, size_t inSize);
+    static void DecodeBand(void *job, int band, int bands);
 
     DISALLOW_EVIL_CONSTRUCTORS(SoftIMAADPCM);
 };
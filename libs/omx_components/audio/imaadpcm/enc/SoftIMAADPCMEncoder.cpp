@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SoftIMAADPCMEncoder"
+#include <utils/Log.h>
+
+#include "SoftIMAADPCMEncoder.h"
+#include "ImaAdpcm.h"
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/MediaDefs.h>
+
+namespace android {
+
+template<class T>
+static void InitOMXParams(T *params) {
+    params->nSize = sizeof(T);
+    params->nVersion.s.nVersionMajor = 1;
+    params->nVersion.s.nVersionMinor = 0;
+    params->nVersion.s.nRevision = 0;
+    params->nVersion.s.nStep = 0;
+}
+
+SoftIMAADPCMEncoder::SoftIMAADPCMEncoder(
+        const char *name,
+        const OMX_CALLBACKTYPE *callbacks,
+        OMX_PTR appData,
+        OMX_COMPONENTTYPE **component)
+    : SimpleSoftOMXComponent(name, callbacks, appData, component),
+      mNumChannels(1),
+      mSamplingRate(8000),
+      mBlockAlign(0),
+      mBlockAlignSet(false),
+      mSignalledError(false),
+      mInputFrame(new int16_t[kMaxBlockSamples]),
+      mInputSize(0),
+      mInputTimeUs(-1ll),
+      mSawInputEOS(false),
+      mSawOutputEOS(false) {
+    CHECK(!strcmp(name, "OMX.google.imaadpcm.encoder"));
+
+    memset(mStepIndex, 0, sizeof(mStepIndex));
+    updateBlockAlign();
+    initPorts();
+}
+
+SoftIMAADPCMEncoder::~SoftIMAADPCMEncoder() {
+    delete[] mInputFrame;
+    mInputFrame = NULL;
+}
+
+void SoftIMAADPCMEncoder::initPorts() {
+    OMX_PARAM_PORTDEFINITIONTYPE def;
+    InitOMXParams(&def);
+
+    def.nPortIndex = 0;
+    def.eDir = OMX_DirInput;
+    def.nBufferCountMin = kNumBuffers;
+    def.nBufferCountActual = def.nBufferCountMin;
+    def.nBufferSize = kInputBufferSize;
+    def.bEnabled = OMX_TRUE;
+    def.bPopulated = OMX_FALSE;
+    def.eDomain = OMX_PortDomainAudio;
+    def.bBuffersContiguous = OMX_FALSE;
+    def.nBufferAlignment = 1;
+
+    def.format.audio.cMIMEType = const_cast<char *>(MEDIA_MIMETYPE_AUDIO_RAW);
+    def.format.audio.pNativeRender = NULL;
+    def.format.audio.bFlagErrorConcealment = OMX_FALSE;
+    def.format.audio.eEncoding = OMX_AUDIO_CodingPCM;
+
+    addPort(def);
+
+    def.nPortIndex = 1;
+    def.eDir = OMX_DirOutput;
+    def.nBufferCountMin = kNumBuffers;
+    def.nBufferCountActual = def.nBufferCountMin;
+    def.nBufferSize = kMaxBlockAlign;
+    def.bEnabled = OMX_TRUE;
+    def.bPopulated = OMX_FALSE;
+    def.eDomain = OMX_PortDomainAudio;
+    def.bBuffersContiguous = OMX_FALSE;
+    def.nBufferAlignment = 2;
+
+    def.format.audio.cMIMEType =
+        const_cast<char *>(MEDIA_MIMETYPE_AUDIO_IMAADPCM);
+
+    def.format.audio.pNativeRender = NULL;
+    def.format.audio.bFlagErrorConcealment = OMX_FALSE;
+    def.format.audio.eEncoding = OMX_AUDIO_CodingIMAADPCM;
+
+    addPort(def);
+}
+
+// The block sizes of WAV files: 256 bytes a channel up to 11 kHz, twice
+// that up to 22 kHz and four times above.
+void SoftIMAADPCMEncoder::updateBlockAlign() {
+    if (mBlockAlignSet) {
+        return;
+    }
+
+    OMX_U32 perChannel = 256;
+    if (mSamplingRate > 22050) {
+        perChannel = 1024;
+    } else if (mSamplingRate > 11025) {
+        perChannel = 512;
+    }
+    mBlockAlign = perChannel * mNumChannels;
+}
+
+OMX_ERRORTYPE SoftIMAADPCMEncoder::internalGetParameter(
+        OMX_INDEXTYPE index, OMX_PTR params) {
+    switch (index) {
+        case OMX_IndexParamAudioPortFormat:
+        {
+            OMX_AUDIO_PARAM_PORTFORMATTYPE *formatParams =
+                (OMX_AUDIO_PARAM_PORTFORMATTYPE *)params;
+
+            if (formatParams->nPortIndex > 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            if (formatParams->nIndex > 0) {
+                return OMX_ErrorNoMore;
+            }
+
+            formatParams->eEncoding =
+                (formatParams->nPortIndex == 0)
+                    ? OMX_AUDIO_CodingPCM : OMX_AUDIO_CodingIMAADPCM;
+
+            return OMX_ErrorNone;
+        }
+
+        case OMX_IndexParamAudioImaAdpcm:
+        {
+            OMX_AUDIO_PARAM_IMAADPCMTYPE *imaadpcmParams =
+                (OMX_AUDIO_PARAM_IMAADPCMTYPE *)params;
+
+            if (imaadpcmParams->nPortIndex != 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            imaadpcmParams->nBitsPerSample = 4;
+            imaadpcmParams->nChannels = mNumChannels;
+            imaadpcmParams->nSampleRate = mSamplingRate;
+            imaadpcmParams->nBlockAlign = mBlockAlign;
+
+            return OMX_ErrorNone;
+        }
+
+        case OMX_IndexParamAudioPcm:
+        {
+            OMX_AUDIO_PARAM_PCMMODETYPE *pcmParams =
+                (OMX_AUDIO_PARAM_PCMMODETYPE *)params;
+
+            if (pcmParams->nPortIndex != 0) {
+                return OMX_ErrorUndefined;
+            }
+
+            pcmParams->eNumData = OMX_NumericalDataSigned;
+            pcmParams->eEndian = OMX_EndianBig;
+            pcmParams->bInterleaved = OMX_TRUE;
+            pcmParams->nBitPerSample = 16;
+            pcmParams->ePCMMode = OMX_AUDIO_PCMModeLinear;
+
+            if (mNumChannels == 1) {
+                pcmParams->eChannelMapping[0] = OMX_AUDIO_ChannelCF;
+            } else {
+                CHECK_EQ(mNumChannels, 2);
+
+                pcmParams->eChannelMapping[0] = OMX_AUDIO_ChannelLF;
+                pcmParams->eChannelMapping[1] = OMX_AUDIO_ChannelRF;
+            }
+
+            pcmParams->nChannels = mNumChannels;
+            pcmParams->nSamplingRate = mSamplingRate;
+
+            return OMX_ErrorNone;
+        }
+
+        default:
+            return SimpleSoftOMXComponent::internalGetParameter(index, params);
+    }
+}
+
+OMX_ERRORTYPE SoftIMAADPCMEncoder::internalSetParameter(
+        OMX_INDEXTYPE index, const OMX_PTR params) {
+    switch (index) {
+        case OMX_IndexParamStandardComponentRole:
+        {
+            const OMX_PARAM_COMPONENTROLETYPE *roleParams =
+                (const OMX_PARAM_COMPONENTROLETYPE *)params;
+
+            if (strncmp((const char *)roleParams->cRole,
+                       "audio_encoder.imaadpcm",
+                       OMX_MAX_STRINGNAME_SIZE - 1)) {
+                return OMX_ErrorUndefined;
+            }
+
+            return OMX_ErrorNone;
+        }
+
+        case OMX_IndexParamAudioPortFormat:
+        {
+            const OMX_AUDIO_PARAM_PORTFORMATTYPE *formatParams =
+                (const OMX_AUDIO_PARAM_PORTFORMATTYPE *)params;
+
+            if (formatParams->nPortIndex > 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            if (formatParams->nIndex > 0) {
+                return OMX_ErrorNoMore;
+            }
+
+            if ((formatParams->nPortIndex == 0
+                        && formatParams->eEncoding != OMX_AUDIO_CodingPCM)
+                || (formatParams->nPortIndex == 1
+                        && formatParams->eEncoding != OMX_AUDIO_CodingIMAADPCM)) {
+                return OMX_ErrorUndefined;
+            }
+
+            return OMX_ErrorNone;
+        }
+
+        case OMX_IndexParamAudioImaAdpcm:
+        {
+            OMX_AUDIO_PARAM_IMAADPCMTYPE *imaadpcmParams =
+                (OMX_AUDIO_PARAM_IMAADPCMTYPE *)params;
+
+            if (imaadpcmParams->nPortIndex != 1) {
+                return OMX_ErrorUndefined;
+            }
+
+            // Whole groups of 4 bytes a channel, as the decoders of WAV
+            // files expect.
+            OMX_U32 align = imaadpcmParams->nBlockAlign;
+            if (align != 0 && (align % (4 * mNumChannels) != 0
+                        || align <= 4 * mNumChannels || align > kMaxBlockAlign)) {
+                return OMX_ErrorUndefined;
+            }
+
+            mBlockAlignSet = (align != 0);
+            mBlockAlign = align;
+            updateBlockAlign();
+
+            return OMX_ErrorNone;
+        }
+
+        case OMX_IndexParamAudioPcm:
+        {
+            OMX_AUDIO_PARAM_PCMMODETYPE *pcmParams =
+                (OMX_AUDIO_PARAM_PCMMODETYPE *)params;
+
+            if (pcmParams->nPortIndex != 0) {
+                return OMX_ErrorUndefined;
+            }
+
+            if (pcmParams->nChannels < 1 || pcmParams->nChannels > kMaxChannels
+                    || pcmParams->nSamplingRate == 0) {
+                return OMX_ErrorUndefined;
+            }
+
+            mNumChannels = pcmParams->nChannels;
+            mSamplingRate = pcmParams->nSamplingRate;
+            if (mBlockAlignSet && mBlockAlign % (4 * mNumChannels) != 0) {
+                mBlockAlignSet = false;
+            }
+            updateBlockAlign();
+
+            return OMX_ErrorNone;
+        }
+
+        default:
+            return SimpleSoftOMXComponent::internalSetParameter(index, params);
+    }
+}
+
+void SoftIMAADPCMEncoder::onQueueFilled(OMX_U32 portIndex) {
+    if (mSignalledError || mSawOutputEOS) {
+        return;
+    }
+
+    List<BufferInfo *> &inQueue = getPortQueue(0);
+    List<BufferInfo *> &outQueue = getPortQueue(1);
+
+    size_t frameSize = mNumChannels * sizeof(int16_t);
+    size_t numBytesPerInputBlock =
+        ImaAdpcm::blockSamples(mBlockAlign, mNumChannels) * frameSize;
+
+    for (;;) {
+        // We do the following until we run out of buffers.
+
+        while (mInputSize < numBytesPerInputBlock && !mSawInputEOS) {
+            // As long as there's still input data to be read we
+            // will gather the samples of a block into "mInputFrame"
+            // and then encode those as a unit into an output buffer.
+
+            if (inQueue.empty()) {
+                return;
+            }
+
+            BufferInfo *inInfo = *inQueue.begin();
+            OMX_BUFFERHEADERTYPE *inHeader = inInfo->mHeader;
+
+            const void *inData = inHeader->pBuffer + inHeader->nOffset;
+
+            size_t copy = numBytesPerInputBlock - mInputSize;
+            if (copy > inHeader->nFilledLen) {
+                copy = inHeader->nFilledLen;
+            }
+
+            if (mInputSize == 0) {
+                mInputTimeUs = inHeader->nTimeStamp;
+            }
+
+            memcpy((uint8_t *)mInputFrame + mInputSize, inData, copy);
+            mInputSize += copy;
+
+            inHeader->nOffset += copy;
+            inHeader->nFilledLen -= copy;
+
+            // "Time" on the input buffer has in effect advanced by the
+            // number of audio frames we just advanced nOffset by.
+            inHeader->nTimeStamp +=
+                (copy / frameSize) * 1000000ll / mSamplingRate;
+
+            if (inHeader->nFilledLen == 0) {
+                if (inHeader->nFlags & OMX_BUFFERFLAG_EOS) {
+                    ALOGV("saw input EOS");
+                    mSawInputEOS = true;
+
+                    // Pad the last block with its last frame.
+                    size_t frame = mInputSize / frameSize;
+                    if (frame > 0) {
+                        uint8_t *pad = (uint8_t *)mInputFrame + frame * frameSize;
+                        for (; frame * frameSize < numBytesPerInputBlock; frame++) {
+                            memcpy(pad, pad - frameSize, frameSize);
+                            pad += frameSize;
+                        }
+                        mInputSize = numBytesPerInputBlock;
+                    } else {
+                        mInputSize = 0;
+                    }
+                }
+
+                inQueue.erase(inQueue.begin());
+                inInfo->mOwnedByUs = false;
+                notifyEmptyBufferDone(inHeader);
+
+                inData = NULL;
+                inHeader = NULL;
+                inInfo = NULL;
+            }
+        }
+
+        // At this  point we have all the input data necessary to encode
+        // a single block, or the input has ended, all we need is an
+        // output buffer to store the result in.
+
+        if (outQueue.empty()) {
+            return;
+        }
+
+        BufferInfo *outInfo = *outQueue.begin();
+        OMX_BUFFERHEADERTYPE *outHeader = outInfo->mHeader;
+
+        outHeader->nOffset = 0;
+        outHeader->nFilledLen = 0;
+        outHeader->nFlags = 0;
+        outHeader->nTimeStamp = mInputTimeUs;
+
+        if (mInputSize > 0) {
+            if (outHeader->nAllocLen < mBlockAlign) {
+                ALOGE("output buffer of %ld bytes is too small for a block of %ld.",
+                      outHeader->nAllocLen, mBlockAlign);
+
+                notify(OMX_EventError, OMX_ErrorUndefined, 0, NULL);
+                mSignalledError = true;
+                return;
+            }
+
+            ImaAdpcm::encodeBlock(outHeader->pBuffer, mInputFrame, mNumChannels,
+                                  mBlockAlign, mStepIndex);
+
+            outHeader->nFilledLen = mBlockAlign;
+            outHeader->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+        }
+
+        if (mSawInputEOS) {
+            outHeader->nFlags |= OMX_BUFFERFLAG_EOS;
+            mSawOutputEOS = true;
+        }
+
+        outQueue.erase(outQueue.begin());
+        outInfo->mOwnedByUs = false;
+        notifyFillBufferDone(outHeader);
+
+        outHeader = NULL;
+        outInfo = NULL;
+
+        mInputSize = 0;
+
+        if (mSawOutputEOS) {
+            return;
+        }
+    }
+}
+
+void SoftIMAADPCMEncoder::onPortFlushCompleted(OMX_U32 portIndex) {
+    if (portIndex == 0) {
+        mInputSize = 0;
+        mSawInputEOS = false;
+        mSawOutputEOS = false;
+        memset(mStepIndex, 0, sizeof(mStepIndex));
+    }
+}
+
+}  // namespace android
+
+android::SoftOMXComponent *createSoftOMXComponent(
+        const char *name, const OMX_CALLBACKTYPE *callbacks,
+        OMX_PTR appData, OMX_COMPONENTTYPE **component) {
+    return new android::SoftIMAADPCMEncoder(name, callbacks, appData, component);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOFT_IMAADPCM_ENCODER_H_
+
+#define SOFT_IMAADPCM_ENCODER_H_
+
+#include "SimpleSoftOMXComponent.h"
+
+namespace android {
+
+struct SoftIMAADPCMEncoder : public SimpleSoftOMXComponent {
+    SoftIMAADPCMEncoder(const char *name,
+            const OMX_CALLBACKTYPE *callbacks,
+            OMX_PTR appData,
+            OMX_COMPONENTTYPE **component);
+
+protected:
+    virtual ~SoftIMAADPCMEncoder();
+
+    virtual OMX_ERRORTYPE internalGetParameter(
+            OMX_INDEXTYPE index, OMX_PTR params);
+
+    virtual OMX_ERRORTYPE internalSetParameter(
+            OMX_INDEXTYPE index, const OMX_PTR params);
+
+    virtual void onQueueFilled(OMX_U32 portIndex);
+
+    virtual void onPortFlushCompleted(OMX_U32 portIndex);
+
+private:
+    enum {
+        kNumBuffers = 4,
+        kMaxChannels = 2,
+        // A block holds up to 8185 samples, 16 KB of input.
+        kMaxBlockAlign = 4096,
+        kMaxBlockSamples = ((kMaxBlockAlign - 4) << 1) + 1,
+        kInputBufferSize = 8192
+    };
+
+    OMX_U32 mNumChannels;
+    OMX_U32 mSamplingRate;
+    OMX_U32 mBlockAlign;
+    bool mBlockAlignSet;
+    bool mSignalledError;
+
+    int16_t *mInputFrame;
+    size_t mInputSize;
+    int64_t mInputTimeUs;
+    bool mSawInputEOS;
+    bool mSawOutputEOS;
+    int mStepIndex[kMaxChannels];
+
+    void initPorts();
+    void updateBlockAlign();
+
+    DISALLOW_EVIL_CONSTRUCTORS(SoftIMAADPCMEncoder);
+};
+
+}  // namespace android
+
+#endif  // SOFT_IMAADPCM_ENCODER_H_
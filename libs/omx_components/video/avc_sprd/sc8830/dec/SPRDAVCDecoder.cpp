@@ -25,6 +25,7 @@
 #include <media/stagefright/MediaErrors.h>
 #include <media/IOMX.h>
 
+#include <cutils/properties.h>
 #include <dlfcn.h>
 #include <media/hardware/HardwareAPI.h>
 #include <ui/GraphicBufferMapper.h>
@@ -32,8 +33,7 @@
 #include "gralloc_priv.h"
 #include "ion_sprd.h"
 #include "avc_dec_api.h"
-
-//#define VIDEODEC_CURRENT_OPT  /*only open for SAMSUNG currently*/
+#include "SprdBandwidthGovernor.h"
 
 
 namespace android {
@@ -144,7 +144,8 @@ SPRDAVCDecoder::SPRDAVCDecoder(
       mCropWidth(mWidth),
       mCropHeight(mHeight),
       mPicId(0),
-      mSetFreqCount(0),
+      mBandwidthSession(-1),
+      mHasBFrames(false),
       mHeadersDecoded(false),
       mEOSStatus(INPUT_DATA_AVAILABLE),
       mOutputPortSettingsChange(NONE),
@@ -225,10 +226,9 @@ SPRDAVCDecoder::~SPRDAVCDecoder() {
 
     releaseDecoder();
 
-    while (mSetFreqCount > 0)
-    {
-        set_ddr_freq("0");
-        mSetFreqCount--;
+    if (mBandwidthSession >= 0) {
+        SprdBandwidthGovernor::getInstance()->close(mBandwidthSession);
+        mBandwidthSession = -1;
     }
 
     delete mHandle;
@@ -299,55 +299,24 @@ void SPRDAVCDecoder::initPorts() {
     addPort(def);
 }
 
-void SPRDAVCDecoder::set_ddr_freq(const char* freq_in_khz)
-{
-    const char* const set_freq = "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq";
-    FILE* fp = fopen(set_freq, "w");
-    if (fp != NULL)
-    {
-        fprintf(fp, "%s", freq_in_khz);
-        ALOGE("set ddr freq to %skhz", freq_in_khz);
-        fclose(fp);
-    }
-    else
-    {
-        ALOGE("Failed to open %s", set_freq);
-    }
-}
-
+// The hardware decoder votes for the DDR frequency it needs, the
+// software decoder doesn't.
 void SPRDAVCDecoder::change_ddr_freq()
 {
-    if(!mDecoderSwFlag)
-    {
-        uint32_t frame_size = mWidth * mHeight;
-        char* ddr_freq;
+    SprdBandwidthGovernor *governor = SprdBandwidthGovernor::getInstance();
 
-        if(frame_size > 1280*720)
-        {
-            ddr_freq = "500000";
-        }
-#ifdef VIDEODEC_CURRENT_OPT
-        else if(frame_size > 864*480)
-        {
-            ddr_freq = "300000";
-        }
-#else
-        else if(frame_size > 720*576)
-        {
-            ddr_freq = "400000";
-        }
-        else if(frame_size > 320*240)
-        {
-            ddr_freq = "300000";
-        }
-#endif
-        else
-        {
-            ddr_freq = "200000";
+    if (mDecoderSwFlag) {
+        if (mBandwidthSession >= 0) {
+            governor->close(mBandwidthSession);
+            mBandwidthSession = -1;
         }
-        set_ddr_freq(ddr_freq);
-        mSetFreqCount ++;
+        return;
     }
+
+    if (mBandwidthSession < 0) {
+        mBandwidthSession = governor->open(SprdBandwidthGovernor::DECODER);
+    }
+    governor->setFormat(mBandwidthSession, mWidth, mHeight, mHasBFrames);
 }
 
 status_t SPRDAVCDecoder::initDecoder() {
@@ -394,6 +363,14 @@ status_t SPRDAVCDecoder::initDecoder() {
             }
         }
     }
+    mStream.setHeap(mPbuf_stream_v, mPbuf_stream_p, mPbuf_stream_size);
+
+    // Zero bytes in front of the start codes let a NAL unit at an unaligned
+    // address be read in place. Until the VSP is known to skip them, this
+    // is off and such a NAL unit is copied to an aligned start.
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.sprd.avc.zero_pad", value, "0");
+    mStream.setByteStream(!strcmp(value, "1"));
 
     int32 size_inter = H264_DECODER_INTERNAL_BUFFER_SIZE;
     mCodecInterBuffer = (uint8 *)malloc(size_inter);
@@ -461,6 +438,7 @@ void SPRDAVCDecoder::releaseDecoder() {
             mPbuf_stream_size = 0;
         }
     }
+    mStream.setHeap(NULL, 0, 0);
     if (mPbuf_extra_v != NULL) {
         if (mIOMMUEnabled) {
             mPmem_extra->free_mm_iova(mPbuf_extra_p, mPbuf_extra_size);
@@ -728,6 +706,17 @@ OMX_ERRORTYPE SPRDAVCDecoder::internalUseBuffer(
     (*header)->nOutputPortIndex = portIndex;
     (*header)->nInputPortIndex = portIndex;
 
+    if(portIndex == OMX_DirInput && bufferPrivate != NULL) {
+        (*header)->pInputPortPrivate = new BufferCtrlStruct;
+        CHECK((*header)->pInputPortPrivate != NULL);
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)((*header)->pInputPortPrivate);
+        pBufCtrl->iRefCount = 0;
+        pBufCtrl->pMem = ((BufferPrivateStruct*)bufferPrivate)->pMem;
+        pBufCtrl->phyAddr = ((BufferPrivateStruct*)bufferPrivate)->phyAddr;
+        pBufCtrl->bufferSize = ((BufferPrivateStruct*)bufferPrivate)->bufferSize;
+        pBufCtrl->bufferFd = 0;
+    }
+
     if(portIndex == OMX_DirOutput) {
         (*header)->pOutputPortPrivate = new BufferCtrlStruct;
         CHECK((*header)->pOutputPortPrivate != NULL);
@@ -792,7 +781,54 @@ OMX_ERRORTYPE SPRDAVCDecoder::allocateBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
-        return SprdSimpleOMXComponent::allocateBuffer(header, portIndex, appPrivate, size);
+    {
+        if(mDecoderSwFlag || mChangeToSwDec) {
+            return SprdSimpleOMXComponent::allocateBuffer(header, portIndex, appPrivate, size);
+        } else {
+            // The bitstream is read in place, with room for a start code
+            // in front of it and for the prefetch behind it.
+            MemoryHeapIon* pMem = NULL;
+            int phyAddr = 0;
+            int bufferSize = 0;
+            unsigned char* pBuffer = NULL;
+            OMX_U32 size64word = (size + SprdStreamBuffer::kHeadroom + SprdStreamBuffer::kTailroom + 1024*4 - 1) & ~(1024*4 - 1);
+
+            if (mIOMMUEnabled) {
+                pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_SYSTEM);
+            } else {
+                pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_MM);
+            }
+
+            if(pMem->getHeapID() < 0) {
+                ALOGE("Failed to alloc inport pmem buffer");
+                return OMX_ErrorInsufficientResources;
+            }
+
+            if (mIOMMUEnabled) {
+                if(pMem->get_mm_iova(&phyAddr, &bufferSize)) {
+                    ALOGE("get_mm_iova fail");
+                    return OMX_ErrorInsufficientResources;
+                }
+            } else {
+                if(pMem->get_phy_addr_from_ion(&phyAddr, &bufferSize)) {
+                    ALOGE("get_phy_addr_from_ion fail");
+                    return OMX_ErrorInsufficientResources;
+                }
+            }
+
+            pBuffer = (unsigned char*)(pMem->base()) + SprdStreamBuffer::kHeadroom;
+            BufferPrivateStruct* bufferPrivate = new BufferPrivateStruct();
+            bufferPrivate->pMem = pMem;
+            bufferPrivate->phyAddr = phyAddr;
+            bufferPrivate->bufferSize = bufferSize;
+            ALOGI("allocateBuffer, allocate input buffer from pmem, pBuffer: 0x%x, phyAddr: 0x%x, size: %d", pBuffer, phyAddr, bufferSize);
+
+            SprdSimpleOMXComponent::useBuffer(header, portIndex, appPrivate, size, pBuffer, bufferPrivate);
+            delete bufferPrivate;
+
+            return OMX_ErrorNone;
+        }
+    }
 
     case OMX_DirOutput:
     {
@@ -855,7 +891,21 @@ OMX_ERRORTYPE SPRDAVCDecoder::freeBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
+    {
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)(header->pInputPortPrivate);
+        if(pBufCtrl != NULL) {
+            if(pBufCtrl->pMem != NULL) {
+                ALOGI("freeBuffer, input phyAddr: 0x%x", pBufCtrl->phyAddr);
+                if (mIOMMUEnabled) {
+                    pBufCtrl->pMem->free_mm_iova(pBufCtrl->phyAddr, pBufCtrl->bufferSize);
+                }
+                pBufCtrl->pMem.clear();
+            }
+            delete pBufCtrl;
+            header->pInputPortPrivate = NULL;
+        }
         return SprdSimpleOMXComponent::freeBuffer(portIndex, header);
+    }
 
     case OMX_DirOutput:
     {
@@ -974,6 +1024,7 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
         }
 
         mDecoderSwFlag = true;
+        change_ddr_freq();
 
         if(initDecoder() != OK) {
             ALOGE("onQueueFilled, init sw decoder failed.");
@@ -1056,39 +1107,32 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
         uint8_t *bitstream = inHeader->pBuffer + inHeader->nOffset;
         int32_t bufferSize = inHeader->nFilledLen;
 
-        dec_in.pStream = (uint8 *) mPbuf_stream_v;
-        dec_in.pStream_phy = (uint32) mPbuf_stream_p;
-        dec_in.dataLen = bufferSize;
+        // Allocated input buffers are read in place, client buffers are
+        // copied into the stream buffer once. The thumbnail decoder wants
+        // a start code in front of every access unit.
+        BufferCtrlStruct *pInBufCtrl = (BufferCtrlStruct *)(inHeader->pInputPortPrivate);
+        uint32_t bitstreamPhy = 0;
+        size_t writable = 0;
+        if (pInBufCtrl != NULL && pInBufCtrl->phyAddr != 0) {
+            writable = SprdStreamBuffer::kHeadroom + inHeader->nOffset;
+            bitstreamPhy = pInBufCtrl->phyAddr + writable;
+        }
+        if (!mStream.prepare(bitstream, bitstreamPhy, writable, bufferSize, mThumbnailMode)) {
+            ALOGE("onQueueFilled, bitstream of %d bytes doesn't fit into the stream buffer", bufferSize);
+            notify(OMX_EventError, OMX_ErrorUndefined, 0, NULL);
+            mSignalledError = true;
+            return;
+        }
+
+        dec_in.pStream = (uint8 *) mStream.data();
+        dec_in.pStream_phy = (uint32) mStream.phys();
+        dec_in.dataLen = mStream.length();
         dec_in.beLastFrm = 0;
         dec_in.expected_IVOP = mNeedIVOP;
         dec_in.beDisplayed = 1;
         dec_in.err_pkt_num = 0;
         dec_out.frameEffective = 0;
 
-        if(mThumbnailMode) {
-            int32 add_startcode_len = 0;
-
-            uint8 *p = (uint8 *)(inHeader->pBuffer + inHeader->nOffset);
-
-            if((p[0] != 0x0) || (p[1] != 0x0) || (p[2] != 0x0) || (p[3] != 0x1))
-            {
-                ALOGI("%s, %d, p[0]: %x, p[1]: %x, p[2]: %x, p[3]: %x", __FUNCTION__, __LINE__, p[0], p[1], p[2], p[3]);
-
-                ((uint8 *) mPbuf_stream_v)[0] = 0x0;
-                ((uint8 *) mPbuf_stream_v)[1] = 0x0;
-                ((uint8 *) mPbuf_stream_v)[2] = 0x0;
-                ((uint8 *) mPbuf_stream_v)[3] = 0x1;
-
-                add_startcode_len = 4;
-                dec_in.dataLen += add_startcode_len;
-            }
-            memcpy((void *)mPbuf_stream_v+add_startcode_len, inHeader->pBuffer + inHeader->nOffset, inHeader->nFilledLen);
-        } else {
-            if (mPbuf_stream_v != NULL) {
-                memcpy(mPbuf_stream_v, bitstream, bufferSize);
-            }
-        }
-
         ALOGV("%s, %d, dec_in.dataLen: %d, mPicId: %d", __FUNCTION__, __LINE__, dec_in.dataLen, mPicId);
 
         outHeader->nTimeStamp = inHeader->nTimeStamp;
@@ -1141,7 +1185,7 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
             (*mH264Dec_SetCurRecPic)(mHandle, yuv, (uint8 *)picPhyAddr, (void *)outHeader, mPicId);
         }
 
-//        dump_bs( mPbuf_stream_v, dec_in.dataLen);
+//        dump_bs( mStream.data(), dec_in.dataLen);
 
         int64_t start_decode = systemTime();
         MMDecRet decRet = (*mH264DecDecode)(mHandle, &dec_in,&dec_out);
@@ -1190,6 +1234,11 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
                 return;
             }
 
+            if ((decoderInfo.has_b_frames != 0) != mHasBFrames) {
+                mHasBFrames = (decoderInfo.has_b_frames != 0);
+                change_ddr_freq();
+            }
+
             if (handlePortSettingChangeEvent(&decoderInfo)) {
                 return;
             } else if(mChangeToSwDec == true) {
@@ -1204,8 +1253,12 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
             ALOGE("failed to get decoder information.");
         }
 
-        bufferSize = dec_in.dataLen;
+        bufferSize = mStream.consume(dec_in.dataLen);
         CHECK_LE(bufferSize, inHeader->nFilledLen);
+        if (mBandwidthSession >= 0) {
+            SprdBandwidthGovernor::getInstance()->onFrame(mBandwidthSession, inHeader->nTimeStamp,
+                    (end_decode - start_decode) / 1000, bufferSize);
+        }
         inHeader->nOffset += bufferSize;
         inHeader->nFilledLen -= bufferSize;
 
@@ -1214,6 +1267,7 @@ void SPRDAVCDecoder::onQueueFilled(OMX_U32 portIndex) {
             inInfo->mOwnedByUs = false;
             inQueue.erase(inQueue.begin());
             inInfo = NULL;
+            mStream.reset();
             notifyEmptyBufferDone(inHeader);
             inHeader = NULL;
         }
@@ -1370,6 +1424,7 @@ void SPRDAVCDecoder::onPortFlushCompleted(OMX_U32 portIndex) {
     if (portIndex == kInputPortIndex) {
         mEOSStatus = INPUT_DATA_AVAILABLE;
         mNeedIVOP = true;
+        mStream.reset();
     }
 }
 
@@ -1404,6 +1459,7 @@ void SPRDAVCDecoder::onPortFlushPrepare(OMX_U32 portIndex) {
 
 void SPRDAVCDecoder::onReset() {
     mSignalledError = false;
+    mStream.reset();
 
     //avoid process error after stop codec and restart codec when port settings changing.
     mOutputPortSettingsChange = NONE;
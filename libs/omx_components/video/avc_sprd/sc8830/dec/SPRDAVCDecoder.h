@@ -18,6 +18,7 @@
 #define SPRD_AVC_DECODER_H_
 
 #include "SprdSimpleOMXComponent.h"
+#include "SprdStreamBuffer.h"
 #include <utils/KeyedVector.h>
 #include <binder/MemoryHeapIon.h>
 #include "avc_dec_api.h"
@@ -101,6 +102,7 @@ private:
     unsigned char* mPbuf_stream_v;
     int32 mPbuf_stream_p;
     int32 mPbuf_stream_size;
+    SprdStreamBuffer mStream;
 
     sp<MemoryHeapIon> mPmem_extra;
     unsigned char*  mPbuf_extra_v;
@@ -112,7 +114,8 @@ private:
     uint32_t mCropWidth, mCropHeight;
 
     MMDecCapability mCapability;
-    int mSetFreqCount;
+    int mBandwidthSession;
+    bool mHasBFrames;
 
     OMX_BOOL iUseAndroidNativeBuffer[2];
 
@@ -170,7 +173,6 @@ private:
     int VSP_bind_cb(void *pHeader);
     int VSP_unbind_cb(void *pHeader);
     bool openDecoder(const char* libName);
-    void set_ddr_freq(const char* freq_in_khz);
     void change_ddr_freq();
 
     DISALLOW_EVIL_CONSTRUCTORS(SPRDAVCDecoder);
@@ -43,10 +43,12 @@
 #include "ion_sprd.h"
 #include "gralloc_priv.h"
 #include "OMX_Index.h"
+#include "SprdWorkerPool.h"
+#include "SprdYuvConvert.h"
 #ifdef CONVERT_THREAD
 #include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
-
+#include "SprdBandwidthGovernor.h"
 #endif
 
 #define VIDEOENC_CURRENT_OPT
@@ -177,40 +179,19 @@ static status_t ConvertAvcSpecLevelToOmxAvcLevel(
 }
 
 /*
- * In case of orginal input height_org is not 16 aligned, we shoud copy original data to a larger space
- * Example: width_org = 640, height_org = 426,
- * We have to copy this data to a width_dst = 640 height_dst = 432 buffer which is 16 aligned.
- * Be careful, when doing this convert we MUST keep UV in their right position.
- *
- * FIXME: If width_org is not 16 aligned also, this would be much complicate
- *
+ * The I420 of the client, width_org x height_org packed, into the
+ * YVU420 semi-planar frame of the encoder, whose rows are width_dst
+ * apart and whose chroma starts after height_dst rows. Any width and
+ * height, large frames are split across pool.
  */
 inline static void ConvertYUV420PlanarToYVU420SemiPlanar(uint8_t *inyuv, uint8_t* outyuv,
-        int32_t width_org, int32_t height_org, int32_t width_dst, int32_t height_dst) {
-
-    int32_t inYsize = width_org * height_org;
-    uint32_t *outy =  (uint32_t *) outyuv;
-    uint16_t *incb = (uint16_t *) (inyuv + inYsize);
-    uint16_t *incr = (uint16_t *) (inyuv + inYsize + (inYsize >> 2));
-
-    /* Y copying */
-    memcpy(outy, inyuv, inYsize);
-
-    /* U & V copying, Make sure uv data is in their right position*/
-    uint32_t *outUV = (uint32_t *) (outyuv + width_dst * height_dst);
-    for (int32_t i = height_org >> 1; i > 0; --i) {
-        for (int32_t j = width_org >> 2; j > 0; --j) {
-            uint32_t tempU = *incb++;
-            uint32_t tempV = *incr++;
-
-            tempU = (tempU & 0xFF) | ((tempU & 0xFF00) << 8);
-            tempV = (tempV & 0xFF) | ((tempV & 0xFF00) << 8);
-            uint32_t temp = tempV | (tempU << 8);
+        int32_t width_org, int32_t height_org, int32_t width_dst, int32_t height_dst,
+        SprdWorkerPool *pool) {
+    SprdYuvConvert::Frame src, dst;
 
-            // Flip U and V
-            *outUV++ = temp;
-        }
-    }
+    SprdYuvConvert::layout(&src, SprdYuvConvert::I420, inyuv, width_org, height_org);
+    SprdYuvConvert::layout(&dst, SprdYuvConvert::NV21, outyuv, width_dst, height_dst);
+    SprdYuvConvert::convert(src, dst, width_org, height_org, pool);
 }
 
 
@@ -446,22 +427,6 @@ inline static void ConvertARGB888ToYVU420SemiPlanar_neon(uint8_t *inrgb, uint8_t
     ALOGI("wfd: ConvertARGB888ToYVU420SemiPlanar_neon:  rgb2yuv cost time: %d",(unsigned int)((end_encode-start_encode) / 1000000L));
 }
 
-#ifdef VIDEOENC_CURRENT_OPT
-inline static void set_ddr_freq(const char* freq_in_khz)
-{
-    const char* const set_freq = "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq";
-
-    FILE* fp = fopen(set_freq, "w");
-    if (fp != NULL) {
-        fprintf(fp, "%s", freq_in_khz);
-        ALOGE("set ddr freq to %skhz", freq_in_khz);
-        fclose(fp);
-    } else {
-        ALOGE("Failed to open %s", set_freq);
-    }
-}
-#endif
-
 SPRDAVCEncoder::SPRDAVCEncoder(
     const char *name,
     const OMX_CALLBACKTYPE *callbacks,
@@ -500,7 +465,8 @@ SPRDAVCEncoder::SPRDAVCEncoder(
       mEncConfig(new MMEncConfig),
       mEncParams(new tagAVCEncParam),
       mSliceGroup(NULL),
-      mSetFreqCount(0),
+      mBandwidthSession(-1),
+      mConvertPool(NULL),
       mLibHandle(NULL),
       mH264EncGetCodecCapability(NULL),
       mH264EncPreInit(NULL),
@@ -557,11 +523,11 @@ SPRDAVCEncoder::SPRDAVCEncoder(
 
 
 #ifdef CONVERT_THREAD
-
-
     mIncomingBufNum = 0;
-    mCurrentNeedBufNum = 0;
+    mConvertPending = 0;
+    mSlotsInUse = 0;
     mBufIndex = 0;
+    mConvertPool = new SprdWorkerPool("rgb2yuv", CONVERT_MAX_THREAD_NUM, ANDROID_PRIORITY_AUDIO);
     mLooper_enc = new ALooper;
     mHandler_enc = new AHandlerReflector<SPRDAVCEncoder>(this);
     mLooper_enc->setName("convert_looper");
@@ -570,26 +536,24 @@ SPRDAVCEncoder::SPRDAVCEncoder(
         false, // runOnCallingThread
         false, // canCallJava
         ANDROID_PRIORITY_AUDIO);
-
-    for (int i=0;i<CONVERT_MAX_THREAD_NUM;i++)
-    {
-        mLooper_rgb2yuv[i] = new ALooper;
-        mHandler_rgb2yuv[i] = new MyRGB2YUVThreadHandle(this,i);
-        mLooper_rgb2yuv[i]->setName("rgb2yuv_looper"+i);
-        mLooper_rgb2yuv[i]->registerHandler(mHandler_rgb2yuv[i]);
-        mLooper_rgb2yuv[i]->start(
-        false, // runOnCallingThread
-        false, // canCallJava
-        ANDROID_PRIORITY_AUDIO);
-        rgb2yuv_thread_status[i] = RGB2YUR_THREAD_READY;
-        //ALOGI("wfd: start rgb2yuv_looper%d",i);
-    }
 #endif
 }
 
 SPRDAVCEncoder::~SPRDAVCEncoder() {
     ALOGI("Destruct SPRDAVCEncoder, this: %0x", (void *)this);
 
+#ifdef CONVERT_THREAD
+    //the yuv slots are released below, no conversion may be running
+    mLooper_enc->unregisterHandler(mHandler_enc->id());
+    mLooper_enc->stop();
+    delete mConvertPool;
+    mConvertPool = NULL;
+    while (!mConvertOutBufQueue.empty()) {
+        delete *mConvertOutBufQueue.begin();
+        mConvertOutBufQueue.erase(mConvertOutBufQueue.begin());
+    }
+#endif
+
     releaseEncoder();
 
     releaseResource();
@@ -618,17 +582,6 @@ SPRDAVCEncoder::~SPRDAVCEncoder() {
         mFile_bs = NULL;
     }
 #endif
-
-#ifdef CONVERT_THREAD
-    mLooper_enc->unregisterHandler(mHandler_enc->id());
-    mLooper_enc->stop();
-    for (int i=0;i<CONVERT_MAX_THREAD_NUM;i++)
-    {
-        mLooper_rgb2yuv[i]->unregisterHandler(mHandler_rgb2yuv[i]->id());
-        mLooper_rgb2yuv[i]->stop();
-        rgb2yuv_thread_status[i] = RGB2YUR_THREAD_STOPED;
-    }
-#endif
 }
 
 OMX_ERRORTYPE SPRDAVCEncoder::initEncParams() {
@@ -674,15 +627,10 @@ OMX_ERRORTYPE SPRDAVCEncoder::initEncParams() {
     mEncParams->use_overrun_buffer = AVC_OFF;
 
 #ifdef VIDEOENC_CURRENT_OPT
-    if (((mVideoWidth <= 720) && (mVideoHeight <= 480)) || ((mVideoWidth <= 480) && (mVideoHeight <= 720))) {
-        set_ddr_freq("200000");
-        mSetFreqCount ++;
-    }
-    else
-    {
-        set_ddr_freq("300000");
-        mSetFreqCount ++;
+    if (mBandwidthSession < 0) {
+        mBandwidthSession = SprdBandwidthGovernor::getInstance()->open(SprdBandwidthGovernor::ENCODER);
     }
+    SprdBandwidthGovernor::getInstance()->setFormat(mBandwidthSession, mVideoWidth, mVideoHeight, false);
 #endif
 
     MMCodecBuffer ExtraMemBfr;
@@ -880,9 +828,9 @@ OMX_ERRORTYPE SPRDAVCEncoder::releaseResource() {
     }
 
 #ifdef VIDEOENC_CURRENT_OPT
-    while (mSetFreqCount > 0) {
-        set_ddr_freq("0");
-        mSetFreqCount --;
+    if (mBandwidthSession >= 0) {
+        SprdBandwidthGovernor::getInstance()->close(mBandwidthSession);
+        mBandwidthSession = -1;
     }
 #endif
 
@@ -1331,175 +1279,179 @@ OMX_ERRORTYPE SPRDAVCEncoder::getExtensionIndex(
 
 #ifdef CONVERT_THREAD
 
-SPRDAVCEncoder::MyRGB2YUVThreadHandle::MyRGB2YUVThreadHandle(SPRDAVCEncoder *poutEnc,char relatedthreadNum)
-{
-    mPoutEnc = poutEnc;
-    mRelatedthreadNum = relatedthreadNum;
+typedef struct {
+    uint8_t *rgb;
+    uint8_t *py;
+    uint8_t *puv;
+    int32_t width;
+    int32_t height;
+    int32_t width_dst;
+} ConvertBandJob;
+
+//one band of the rows, an even number of them so that every band starts on a uv row
+static void ConvertARGB888ToYVU420SemiPlanarBand(void *job, int band, int bands) {
+    ConvertBandJob *j = (ConvertBandJob *)job;
+    int32_t rows = (j->height + bands * 2 - 1) / (bands * 2) * 2;
+    int32_t y = rows * band;
+
+    if (0 != (j->width & 1) || 0 != (j->height & 1) || y >= j->height)
+        return;
+
+    if (rows > j->height - y)
+        rows = j->height - y;
+
+    neon_intrinsics_ARGB888ToYVU420Semi(j->rgb + y * j->width * 4, j->py + y * j->width_dst,
+                                        j->puv + y / 2 * j->width_dst, j->width, rows,
+                                        j->width_dst, (rows + 15) & (~15));
 }
-void SPRDAVCEncoder::MyRGB2YUVThreadHandle::onMessageReceived(const sp<AMessage> &msg)
-{
-    switch (msg->what()) {
 
-    case kWhatRgb2Yuv:
-    {
+bool SPRDAVCEncoder::isConvertedInput(OMX_BUFFERHEADERTYPE *header) {
+    if (!mStoreMetaData || mVideoColorFormat != OMX_COLOR_FormatAndroidOpaque || header->nFilledLen == 0) {
+        return false;
+    }
 
-        int64_t mBufNum = 0;
-        sp<RefBase> obj;
-        CHECK(msg->findObject("addr_object", &obj));
-        sp<msg_addr_for_convert>addr_object = static_cast<msg_addr_for_convert *>(obj.get());
-        //ALOGE("wfd:thread%d get msg.py:%p.puv:%p,vaddr:%p",mRelatedthreadNum,addr_object->py,addr_object->puv,addr_object->vaddr);
-        ConvertARGB888ToYVU420SemiPlanar_neon((uint8_t*)addr_object->vaddr, addr_object->py, addr_object->puv,mPoutEnc->mVideoWidth, mPoutEnc->mVideoHeight/CONVERT_MAX_THREAD_NUM, (mPoutEnc->mVideoWidth+15)&(~15), (mPoutEnc->mVideoHeight/CONVERT_MAX_THREAD_NUM+15)&(~15));
-        //ConvertARGB888ToYVU420SemiPlanar((uint8_t*)addr_object->vaddr, addr_object->py, addr_object->puv,mPoutEnc->mVideoWidth, mPoutEnc->mVideoHeight/CONVERT_MAX_THREAD_NUM, (mPoutEnc->mVideoWidth+15)&(~15), (mPoutEnc->mVideoHeight/CONVERT_MAX_THREAD_NUM+15)&(~15));
-        mPoutEnc->rgb2yuv_thread_status[mRelatedthreadNum] = RGB2YUR_THREAD_READY;
-        mPoutEnc->mConvertedBufAvailableCondition.signal();
-        break;
+    const uint8_t *inputData = header->pBuffer + header->nOffset;
+    return *(unsigned int *) inputData == kMetadataBufferTypeGrallocSource;
+}
+
+//the gralloc rgb of header to yuv slot, return false if it could not be converted
+bool SPRDAVCEncoder::convertInput(ConvertOutBufferInfo *info, uint8_t slot) {
+    if (mPbuf_yuv_v == NULL) {
+        int32 yuv_size = ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) *3*CONVERT_MAX_ION_NUM/2;
+        if (mIOMMUEnabled) {
+            mYUVInPmemHeap = new MemoryHeapIon("/dev/ion", yuv_size, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_SYSTEM);
+        } else {
+            mYUVInPmemHeap = new MemoryHeapIon("/dev/ion", yuv_size, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_MM);
+        }
+        if (mYUVInPmemHeap->getHeapID() < 0) {
+            ALOGE("Failed to alloc yuv buffer");
+            return false;
+        }
+        int ret,phy_addr, buffer_size;
+        if(mIOMMUEnabled) {
+            ret = mYUVInPmemHeap->get_mm_iova(&phy_addr, &buffer_size);
+        } else {
+            ret = mYUVInPmemHeap->get_phy_addr_from_ion(&phy_addr, &buffer_size);
+        }
+        if(ret) {
+            ALOGE("Failed to get_phy_addr_from_ion %d", ret);
+            return false;
+        }
+        mPbuf_yuv_v =(uint8_t *) mYUVInPmemHeap->base();
+        mPbuf_yuv_p = (int32)phy_addr;
+        //mPbuf_yuv_size = (int32)buffer_size; //mjx note:buffer_size not equal the yuv_size.if used buffersize would make memory crash
+        mPbuf_yuv_size = (int32)yuv_size;
+    }
+
+    uint8_t *py = mPbuf_yuv_v+mPbuf_yuv_size*slot/CONVERT_MAX_ION_NUM;
+    uint8_t *py_phy = (uint8_t*)(mPbuf_yuv_p+mPbuf_yuv_size*slot/CONVERT_MAX_ION_NUM);
+
+    const uint8_t *inputData = info->header->pBuffer + info->header->nOffset;
+    GraphicBufferMapper &mapper = GraphicBufferMapper::get();
+    buffer_handle_t buf = *((buffer_handle_t *)(inputData + 4));
+    Rect bounds((mVideoWidth+15)&(~15), (mVideoHeight+15)&(~15));
+    void* vaddr = NULL;
+    if (mapper.lock(buf, GRALLOC_USAGE_SW_READ_OFTEN|GRALLOC_USAGE_SW_WRITE_NEVER, bounds, &vaddr)) {
+        ALOGE("wfd: failed to lock the buffer of frame %lld", info->buf_number);
+        return false;
     }
 
-    default:
+    ConvertBandJob job;
+    job.rgb = (uint8_t *)vaddr;
+    job.py = py;
+    job.puv = py + ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15));
+    job.width = mVideoWidth;
+    job.height = mVideoHeight;
+    job.width_dst = (mVideoWidth+15)&(~15);
+    mConvertPool->fork(ConvertARGB888ToYVU420SemiPlanarBand, &job);
+    mConvertPool->join();
 
-        TRESPASS();
-        break;
+    if (mapper.unlock(buf)) {
+        ALOGE("wfd: failed to unlock the buffer of frame %lld", info->buf_number);
+        return false;
     }
+
+    info->py = py;
+    info->py_phy = py_phy;
+    return true;
 }
 
-void SPRDAVCEncoder::sendConvertMessage(OMX_BUFFERHEADERTYPE *buffer)
+void SPRDAVCEncoder::releaseConvertSlot() {
+    Mutex::Autolock autoLock(mLock_convert);
+    mSlotsInUse--;
+    mSlotAvailableCondition.signal();
+}
 
+void SPRDAVCEncoder::sendConvertMessage(OMX_BUFFERHEADERTYPE *buffer)
 {
+    if (!isConvertedInput(buffer)) {
+        return;
+    }
+
+    {
+        Mutex::Autolock autoLock(mLock_convert);
+        mConvertPending++;
+    }
+
     sp<AMessage> msg = new AMessage(kWhatConvert, mHandler_enc->id());
     msg->setPointer("header", buffer);
+    msg->setInt64("received", systemTime());
     msg->post();
 }
 
+void SPRDAVCEncoder::onPortFlushPrepare(OMX_U32 portIndex) {
+    if (portIndex != kInputPortIndex) {
+        return;
+    }
+
+    //the flushed buffers may still be converting, wait for them and drop them all
+    Mutex::Autolock autoLock(mLock_convert);
+    for (;;) {
+        while (!mConvertOutBufQueue.empty()) {
+            delete *mConvertOutBufQueue.begin();
+            mConvertOutBufQueue.erase(mConvertOutBufQueue.begin());
+            mSlotsInUse--;
+        }
+        mSlotAvailableCondition.signal();
 
+        if (mConvertPending == 0) {
+            break;
+        }
+        mOutBufAvailableCondition.wait(mLock_convert);
+    }
+}
 
 void SPRDAVCEncoder::onMessageReceived(const sp<AMessage> &msg) {
     switch (msg->what()) {
     case kWhatConvert:
     {
-        OMX_BUFFERHEADERTYPE *header;
-        CHECK(msg->findPointer("header", (void **)&header));
-
-        PortInfo *port = editPortInfo(OMX_DirInput);
-
-        if (mPbuf_yuv_v == NULL) {
-           int32 yuv_size = ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) *3*CONVERT_MAX_ION_NUM/2;
-           if (mIOMMUEnabled) {
-               mYUVInPmemHeap = new MemoryHeapIon("/dev/ion", yuv_size, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_SYSTEM);
-           } else {
-               mYUVInPmemHeap = new MemoryHeapIon("/dev/ion", yuv_size, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_MM);
-           }
-           if (mYUVInPmemHeap->getHeapID() < 0) {
-               ALOGE("Failed to alloc yuv buffer");
-               return;
-           }
-           int ret,phy_addr, buffer_size;
-           if(mIOMMUEnabled) {
-               ret = mYUVInPmemHeap->get_mm_iova(&phy_addr, &buffer_size);
-           } else {
-               ret = mYUVInPmemHeap->get_phy_addr_from_ion(&phy_addr, &buffer_size);
-           }
-           if(ret) {
-               ALOGE("Failed to get_phy_addr_from_ion %d", ret);
-               return;
-           }
-           mPbuf_yuv_v =(uint8_t *) mYUVInPmemHeap->base();
-           mPbuf_yuv_p = (int32)phy_addr;
-           //mPbuf_yuv_size = (int32)buffer_size; //mjx note:buffer_size not equal the yuv_size.if used buffersize would make memory crash
-           mPbuf_yuv_size = (int32)yuv_size;
-           //ALOGI("wfd: yuv_size is %d, buffer_size is %d",yuv_size,buffer_size);
-        }
-        for (size_t j = 0; j < port->mBuffers.size(); ++j) {
-            BufferInfo *buffer = &port->mBuffers.editItemAt(j);
-
-            if (buffer->mHeader == header) {
-                OMX_BUFFERHEADERTYPE *inHeader = buffer->mHeader;
-                const void *inData = inHeader->pBuffer + inHeader->nOffset;
-                uint8_t *inputData = (uint8_t *) inData;
-                CHECK(inputData != NULL);
-                unsigned int type = *(unsigned int *) inputData;
-
-                if(mStoreMetaData &&(type == kMetadataBufferTypeGrallocSource))
-                {
-                    Mutex::Autolock autoLock(mLock_receive);
-                    //ALOGE("wfd: kWhatConvertThisBuffer,incoming buffer number:%llu",mIncomingBufNum);
-                    uint8_t* py;
-                    uint8_t* py_phy;
-                    const void *inData = inHeader->pBuffer + inHeader->nOffset;
-                    uint8_t *inputData = (uint8_t *) inData;
-                    CHECK(inputData != NULL);
-                    py = mPbuf_yuv_v+mPbuf_yuv_size*mBufIndex/CONVERT_MAX_ION_NUM;
-                    py_phy = (uint8_t*)(mPbuf_yuv_p+mPbuf_yuv_size*mBufIndex/CONVERT_MAX_ION_NUM);
-                    //ALOGE("wfd: mBufIndex:%d,mPbuf_yuv_size:%d.base_py:%p",mBufIndex,mPbuf_yuv_size,py);
-                    void* vaddr = NULL;
-                    GraphicBufferMapper &mapper = GraphicBufferMapper::get();
-                    buffer_handle_t buf = *((buffer_handle_t *)(inputData + 4));
-                    Rect bounds((mVideoWidth+15)&(~15), (mVideoHeight+15)&(~15));
-                    if (mapper.lock(buf, GRALLOC_USAGE_SW_READ_OFTEN|GRALLOC_USAGE_SW_WRITE_NEVER, bounds, &vaddr)) {
-                        return;
-                    }
-                    //send to multi threads
-                    int32 single_rgb_size = mVideoWidth * mVideoHeight*4;
-                    int32 single_yuv_size = ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) *3/2;
-                    int64_t start_encode = systemTime();
-                    for(int j=0;j<CONVERT_MAX_THREAD_NUM;j++)
-                    {
-                        //ALOGI("wfd: send msg to:Thread%d.",j);
-                        rgb2yuv_thread_status[j] = RGB2YUR_THREAD_BUSY;
-                        sp<AMessage> msg = new AMessage(kWhatRgb2Yuv, mHandler_rgb2yuv[j]->id());
-                        sp<msg_addr_for_convert> addr_object = new msg_addr_for_convert;
-                        addr_object->buf_number = mIncomingBufNum;
-                        addr_object->internal_index = j;
-                        addr_object->py = py+((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15))*j/CONVERT_MAX_THREAD_NUM;
-                        addr_object->puv = py+((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15))+((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15))*j/(CONVERT_MAX_THREAD_NUM*2);
-                        addr_object->vaddr = (uint8_t*)vaddr+(single_rgb_size*j)/CONVERT_MAX_THREAD_NUM;
-                        msg->setObject("addr_object",addr_object);
-                        msg->post();
-                    }
-                    // check threads status.
-                    int ready_thread_num = 0;
-                    int64_t end_encode = systemTime();
-                    //ALOGI("wfd: total rgb-yuv send msg cost time: %d",(unsigned int)((end_encode-start_encode) / 1000000L));
-                    while(ready_thread_num<CONVERT_MAX_THREAD_NUM)
-                    {
-                        //mConvertedBufAvailableCondition.wait(mLock_con);
-                        mConvertedBufAvailableCondition.waitRelative(mLock_con, 5*1000*1000); //5ms
-                        for(int j=0;j<CONVERT_MAX_THREAD_NUM;j++)
-                        {
-                            if(rgb2yuv_thread_status[j] == RGB2YUR_THREAD_READY)
-                            ready_thread_num++;
-                        }
-                        //ALOGI("wfd: ready thread num:%d",ready_thread_num);
-                        if(ready_thread_num == CONVERT_MAX_THREAD_NUM)
-                        {
-                            break;
-                        }else
-                        {
-                            ready_thread_num=0;
-                        }
-                    }
-                    if (mapper.unlock(buf)) {
-                        return;
-                    }
-                    end_encode = systemTime();
-                    ALOGI("wfd: total rgb-yuv cost time: %d",(unsigned int)((end_encode-start_encode) / 1000000L));
-                    ConvertOutBufferInfo* info = new ConvertOutBufferInfo;
-                    if(info == NULL)
-                    {
-                        ALOGE("wfd:can not new ConvertOutBufferInfo buffer");
-                        return;
-                    }
-                    info->buf_number = mIncomingBufNum;
-                    info->py = py;
-                    info->py_phy = py_phy;
-                    mConvertOutBufQueue.push_back(info);
-                    mIncomingBufNum++;
-                    mBufIndex =(mBufIndex+1)%CONVERT_MAX_ION_NUM;
-                    mOutBufAvailableCondition.signal();
-                }
-                break;
+        ConvertOutBufferInfo *info = new ConvertOutBufferInfo;
+        CHECK(msg->findPointer("header", (void **)&info->header));
+        CHECK(msg->findInt64("received", &info->received_time));
+        info->buf_number = mIncomingBufNum++;
+        info->py = NULL;
+        info->py_phy = NULL;
+
+        //frame N+1 is converted while frame N is encoded, as far ahead as there are slots
+        uint8_t slot;
+        {
+            Mutex::Autolock autoLock(mLock_convert);
+            while (mSlotsInUse == CONVERT_MAX_ION_NUM) {
+                mSlotAvailableCondition.wait(mLock_convert);
             }
+            mSlotsInUse++;
+            slot = mBufIndex;
+            mBufIndex =(mBufIndex+1)%CONVERT_MAX_ION_NUM;
         }
 
+        info->start_time = systemTime();
+        convertInput(info, slot);
+        info->converted_time = systemTime();
+
+        Mutex::Autolock autoLock(mLock_convert);
+        mConvertOutBufQueue.push_back(info);
+        mConvertPending--;
+        mOutBufAvailableCondition.broadcast();
         break;
     }
 
@@ -1633,6 +1585,9 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
             uint32_t height = 0;
             uint32_t x = 0;
             uint32_t y = 0;
+#ifdef CONVERT_THREAD
+            ConvertOutBufferInfo *convertInfo = NULL;
+#endif
 
             if (mStoreMetaData) {
                 unsigned int type = *(unsigned int *) inputData;
@@ -1645,17 +1600,28 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
                     y = (uint32_t)(*((int *) inputData + 6));
                 } else if (type == kMetadataBufferTypeGrallocSource) {
 #ifdef CONVERT_THREAD
-                while(mConvertOutBufQueue.empty())
-                {
-                    mOutBufAvailableCondition.wait(mLock_convert);
-                }
-                ConvertOutBufferInfo *BufInfo = *mConvertOutBufQueue.begin();
-                py = BufInfo->py;
-                py_phy = BufInfo->py_phy;
-                mConvertOutBufQueue.erase(mConvertOutBufQueue.begin());
-                delete BufInfo;
-                mCurrentNeedBufNum++;
-#else
+                    if (isConvertedInput(inHeader)) {
+                        {
+                            Mutex::Autolock autoLock(mLock_convert);
+                            while (mConvertOutBufQueue.empty()) {
+                                mOutBufAvailableCondition.wait(mLock_convert);
+                            }
+                            convertInfo = *mConvertOutBufQueue.begin();
+                            mConvertOutBufQueue.erase(mConvertOutBufQueue.begin());
+                        }
+                        CHECK(convertInfo->header == inHeader);
+
+                        if (convertInfo->py == NULL) {
+                            ALOGE("wfd: frame %lld was not converted", convertInfo->buf_number);
+                            delete convertInfo;
+                            releaseConvertSlot();
+                            mSignalledError = true;
+                            notify(OMX_EventError, OMX_ErrorUndefined, 0, 0);
+                            return;
+                        }
+                        py = convertInfo->py;
+                        py_phy = convertInfo->py_phy;
+                    } else {
                     if (mPbuf_yuv_v == NULL) {
                         int32 yuv_size = ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) *3/2;
                         if (mIOMMUEnabled) {
@@ -1696,7 +1662,7 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
 
                     if (mVideoColorFormat == OMX_COLOR_FormatYUV420Planar) {
                         ConvertYUV420PlanarToYVU420SemiPlanar((uint8_t*)vaddr, py, mVideoWidth, mVideoHeight,
-                                                              (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15));
+                                                              (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15), mConvertPool);
                     } else if(mVideoColorFormat == OMX_COLOR_FormatAndroidOpaque) {
                         struct private_handle_t *pH = (struct private_handle_t *)buf;
                         private_handle_t* pBuf = (private_handle_t* )buf;
@@ -1729,7 +1695,9 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
                     if (mapper.unlock(buf)) {
                         return;
                     }
-#endif //end CONVERT_THREAD
+#ifdef CONVERT_THREAD
+                    }
+#endif
                 } else {
                     ALOGE("Error MetadataBufferType %d", type);
                     return;
@@ -1766,7 +1734,7 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
 
                 if (mVideoColorFormat == OMX_COLOR_FormatYUV420Planar) {
                     ConvertYUV420PlanarToYVU420SemiPlanar(inputData, py, mVideoWidth, mVideoHeight,
-                                                          (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15));
+                                                          (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15), mConvertPool);
                 } else if(mVideoColorFormat == OMX_COLOR_FormatAndroidOpaque) {
                     //ConvertARGB888ToYVU420SemiPlanar(inputData, py, mVideoWidth, mVideoHeight, (mVideoWidth+15)&(~15), (mVideoHeight+15)&(~15));
                     ConvertARGB888ToYVU420SemiPlanar_neon(inputData, py, py+(((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15))),mVideoWidth, mVideoHeight, (mVideoWidth+15)&(~15), (mVideoHeight+15)&(~15));
@@ -1812,6 +1780,25 @@ void SPRDAVCEncoder::onQueueFilled(OMX_U32 portIndex) {
             ALOGI("H264EncStrmEncode[%lld] %dms, in {%p-%p, %dx%d}, out {%p-%d, %d}, wh{%d, %d}, xy{%d, %d}",
                   mNumInputFrames, (unsigned int)((end_encode-start_encode) / 1000000L), py, py_phy,
                   mVideoWidth, mVideoHeight, vid_out.pOutBuf, vid_out.strmSize,vid_out.vopType, width, height, x, y);
+#ifdef VIDEOENC_CURRENT_OPT
+            if (mBandwidthSession >= 0 && ret == MMENC_OK && vid_out.strmSize > 0) {
+                SprdBandwidthGovernor::getInstance()->onFrame(mBandwidthSession, inHeader->nTimeStamp,
+                        (end_encode - start_encode) / 1000, vid_out.strmSize);
+            }
+#endif
+#ifdef CONVERT_THREAD
+            if (convertInfo != NULL) {
+                releaseConvertSlot();
+                ALOGI("wfd: frame %lld slot wait %dms, convert %dms, queued %dms, encode %dms, total %dms",
+                      convertInfo->buf_number,
+                      (unsigned int)((convertInfo->start_time - convertInfo->received_time) / 1000000L),
+                      (unsigned int)((convertInfo->converted_time - convertInfo->start_time) / 1000000L),
+                      (unsigned int)((start_encode - convertInfo->converted_time) / 1000000L),
+                      (unsigned int)((end_encode - start_encode) / 1000000L),
+                      (unsigned int)((end_encode - convertInfo->received_time) / 1000000L));
+                delete convertInfo;
+            }
+#endif
             if ((vid_out.strmSize < 0) || (ret != MMENC_OK)) {
                 ALOGE("Failed to encode frame %lld, ret=%d", mNumInputFrames, ret);
 #if 0  //removed by xiaowei, 20131017, for cr224544              
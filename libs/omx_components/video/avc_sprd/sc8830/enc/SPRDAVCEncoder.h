@@ -30,11 +30,10 @@ namespace android {
 //#define SPRD_DUMP_YUV
 //#define SPRD_DUMP_BS
 
-#if 0
 //in wifidisplay case .get rgb data from surfaceflinger
 #define CONVERT_THREAD
-#endif
 
+struct SprdWorkerPool;
 #ifdef CONVERT_THREAD
 struct ALooper;
 #endif
@@ -58,7 +57,6 @@ struct SPRDAVCEncoder :  public SprdSimpleOMXComponent {
     virtual void onQueueFilled(OMX_U32 portIndex);
 
 #ifdef	CONVERT_THREAD
-	void onQueueConverted(uint64_t incoming_buf_nu,uint8_t BufIndex);
 	virtual void sendConvertMessage(OMX_BUFFERHEADERTYPE *buffer);
     void onMessageReceived(const sp<AMessage> &msg);
 
@@ -69,6 +67,10 @@ struct SPRDAVCEncoder :  public SprdSimpleOMXComponent {
 protected:
     virtual ~SPRDAVCEncoder();
 
+#ifdef CONVERT_THREAD
+    virtual void onPortFlushPrepare(OMX_U32 portIndex);
+#endif
+
 private:
     enum {
         kNumBuffers = 2,
@@ -93,49 +95,28 @@ private:
     sp<ALooper> mLooper_enc;
     sp<AHandlerReflector<SPRDAVCEncoder> > mHandler_enc;
     typedef struct {
+        OMX_BUFFERHEADERTYPE *header;
         uint64_t buf_number;
-        uint8_t *py;   //virtual addr
+        uint8_t *py;   //virtual addr, NULL if the conversion failed
         uint8_t *py_phy;    //phy addr
+        int64_t received_time;   //emptyThisBuffer
+        int64_t start_time;   //a slot was free
+        int64_t converted_time;
     } ConvertOutBufferInfo;
     List<ConvertOutBufferInfo *> mConvertOutBufQueue;
-    struct msg_addr_for_convert : public RefBase {
-        uint64_t buf_number;
-        uint8_t internal_index;
-        uint8_t *py;
-        uint8_t *puv;
-        void *vaddr;
-    } ;
-    Condition mConvertedBufAvailableCondition;
     Condition mOutBufAvailableCondition;
-    Mutex mLock_con;
-    Mutex mLock_receive;
+    Condition mSlotAvailableCondition;
     Mutex mLock_convert;
-    Mutex mLock_map;
     int64_t mIncomingBufNum;
-    int64_t mCurrentNeedBufNum;
+    int32_t mConvertPending;   //posted kWhatConvert not yet queued
+    int32_t mSlotsInUse;   //converted or encoding
     #define CONVERT_MAX_THREAD_NUM 2
     #define CONVERT_MAX_ION_NUM 4 //sync with nBufferCountMin
     uint8_t         mBufIndex;
-    struct MyRGB2YUVThreadHandle :public AHandler
-    {
-        public:
-        MyRGB2YUVThreadHandle(SPRDAVCEncoder *poutEnc,char relatedthreadNum);
-        virtual void onMessageReceived(const sp<AMessage> &msg);
-        SPRDAVCEncoder * mPoutEnc;
-        char mRelatedthreadNum;
-        friend struct SPRDAVCEncoder;
-    };
-    enum {
-        RGB2YUR_THREAD_STOPED,
-        RGB2YUR_THREAD_READY,
-        RGB2YUR_THREAD_BUSY,
-    };
-    char rgb2yuv_thread_status[CONVERT_MAX_THREAD_NUM];
-    sp<ALooper> mLooper_rgb2yuv[CONVERT_MAX_THREAD_NUM];
-    sp<MyRGB2YUVThreadHandle> mHandler_rgb2yuv[CONVERT_MAX_THREAD_NUM];
-    enum {
-        kWhatRgb2Yuv,
-    };
+
+    bool isConvertedInput(OMX_BUFFERHEADERTYPE *header);
+    bool convertInput(ConvertOutBufferInfo *info, uint8_t slot);
+    void releaseConvertSlot();
 #endif
 
     OMX_BOOL mStoreMetaData;
@@ -185,7 +166,10 @@ private:
 //    Vector<MediaBuffer *> mOutputBuffers;
     Vector<InputBufferInfo> mInputBufferInfoVec;
 
-    int mSetFreqCount;
+    int mBandwidthSession;
+
+    // Converts the rgb of wifi display and splits large yuv conversions.
+    SprdWorkerPool *mConvertPool;
 
     void* mLibHandle;
     FT_H264EncGetCodecCapability	mH264EncGetCodecCapability;
@@ -217,8 +201,6 @@ private:
 
     DISALLOW_EVIL_CONSTRUCTORS(SPRDAVCEncoder);
 
-friend struct MyRGB2YUVThreadHandle;
-
 };
 
 }  // namespace android
@@ -31,8 +31,7 @@
 #include "m4v_h263_dec_api.h"
 #include <dlfcn.h>
 #include "ion_sprd.h"
-
-//#define VIDEODEC_CURRENT_OPT  /*only open for SAMSUNG currently*/
+#include "SprdBandwidthGovernor.h"
 
 
 namespace android {
@@ -110,7 +109,7 @@ SPRDMPEG4Decoder::SPRDMPEG4Decoder(
       mCropBottom(mHeight - 1),
       mMaxWidth(352),
       mMaxHeight(288),
-      mSetFreqCount(0),
+      mBandwidthSession(-1),
       mSignalledError(false),
       mInitialized(false),
       mFramesConfigured(false),
@@ -190,10 +189,9 @@ SPRDMPEG4Decoder::~SPRDMPEG4Decoder() {
 
     releaseDecoder();
 
-    while (mSetFreqCount > 0)
-    {
-        set_ddr_freq("0");
-        mSetFreqCount--;
+    if (mBandwidthSession >= 0) {
+        SprdBandwidthGovernor::getInstance()->close(mBandwidthSession);
+        mBandwidthSession = -1;
     }
 
     if (mPVolHeader != NULL) {
@@ -271,55 +269,24 @@ void SPRDMPEG4Decoder::initPorts() {
     addPort(def);
 }
 
-void SPRDMPEG4Decoder::set_ddr_freq(const char* freq_in_khz)
-{
-    const char* const set_freq = "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq";
-    FILE* fp = fopen(set_freq, "w");
-    if (fp != NULL)
-    {
-        fprintf(fp, "%s", freq_in_khz);
-        ALOGE("set ddr freq to %skhz", freq_in_khz);
-        fclose(fp);
-    }
-    else
-    {
-        ALOGE("Failed to open %s", set_freq);
-    }
-}
-
+// The hardware decoder votes for the DDR frequency it needs, the
+// software decoder doesn't.
 void SPRDMPEG4Decoder::change_ddr_freq()
 {
-    if(!mDecoderSwFlag)
-    {
-        uint32_t frame_size = mWidth * mHeight;
-        char* ddr_freq;
+    SprdBandwidthGovernor *governor = SprdBandwidthGovernor::getInstance();
 
-        if(frame_size > 1280*720)
-        {
-            ddr_freq = "500000";
-        }
-#ifdef VIDEODEC_CURRENT_OPT
-        else if(frame_size > 864*480)
-        {
-            ddr_freq = "300000";
-        }
-#else
-        else if(frame_size > 720*576)
-        {
-            ddr_freq = "400000";
-        }
-        else if(frame_size > 320*240)
-        {
-            ddr_freq = "200000";
-        }
-#endif
-        else
-        {
-            ddr_freq = "200000";
+    if (mDecoderSwFlag) {
+        if (mBandwidthSession >= 0) {
+            governor->close(mBandwidthSession);
+            mBandwidthSession = -1;
         }
-        set_ddr_freq(ddr_freq);
-        mSetFreqCount ++;
+        return;
+    }
+
+    if (mBandwidthSession < 0) {
+        mBandwidthSession = governor->open(SprdBandwidthGovernor::DECODER);
     }
+    governor->setFormat(mBandwidthSession, mWidth, mHeight, false);
 }
 
 status_t SPRDMPEG4Decoder::initDecoder() {
@@ -366,6 +333,7 @@ status_t SPRDMPEG4Decoder::initDecoder() {
             }
         }
     }
+    mStream.setHeap(mPbuf_stream_v, mPbuf_stream_p, mPbuf_stream_size);
 
     int32 size_inter = MP4DEC_INTERNAL_BUFFER_SIZE;
     mCodecInterBuffer = (uint8 *)malloc(size_inter);
@@ -423,6 +391,7 @@ void SPRDMPEG4Decoder::releaseDecoder() {
             mPbuf_stream_size = 0;
         }
     }
+    mStream.setHeap(NULL, 0, 0);
 
     if(mPbuf_extra_v != NULL) {
         if (mIOMMUEnabled) {
@@ -684,6 +653,17 @@ OMX_ERRORTYPE SPRDMPEG4Decoder::internalUseBuffer(
     (*header)->nOutputPortIndex = portIndex;
     (*header)->nInputPortIndex = portIndex;
 
+    if(portIndex == OMX_DirInput && bufferPrivate != NULL) {
+        (*header)->pInputPortPrivate = new BufferCtrlStruct;
+        CHECK((*header)->pInputPortPrivate != NULL);
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)((*header)->pInputPortPrivate);
+        pBufCtrl->iRefCount = 0;
+        pBufCtrl->pMem = ((BufferPrivateStruct*)bufferPrivate)->pMem;
+        pBufCtrl->phyAddr = ((BufferPrivateStruct*)bufferPrivate)->phyAddr;
+        pBufCtrl->bufferSize = ((BufferPrivateStruct*)bufferPrivate)->bufferSize;
+        pBufCtrl->bufferFd = 0;
+    }
+
     if(portIndex == OMX_DirOutput) {
         (*header)->pOutputPortPrivate = new BufferCtrlStruct;
         CHECK((*header)->pOutputPortPrivate != NULL);
@@ -748,7 +728,54 @@ OMX_ERRORTYPE SPRDMPEG4Decoder::allocateBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
-        return SprdSimpleOMXComponent::allocateBuffer(header, portIndex, appPrivate, size);
+    {
+        if(mDecoderSwFlag && !mChangeToHwDec) {
+            return SprdSimpleOMXComponent::allocateBuffer(header, portIndex, appPrivate, size);
+        } else {
+            // The bitstream is read in place, with room for the prefetch
+            // behind it.
+            MemoryHeapIon* pMem = NULL;
+            int phyAddr = 0;
+            int bufferSize = 0;
+            unsigned char* pBuffer = NULL;
+            OMX_U32 size64word = (size + SprdStreamBuffer::kHeadroom + SprdStreamBuffer::kTailroom + 1024*4 - 1) & ~(1024*4 - 1);
+
+            if (mIOMMUEnabled) {
+                pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_SYSTEM);
+            } else {
+                pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_MM);
+            }
+
+            if(pMem->getHeapID() < 0) {
+                ALOGE("Failed to alloc inport pmem buffer");
+                return OMX_ErrorInsufficientResources;
+            }
+
+            if (mIOMMUEnabled) {
+                if(pMem->get_mm_iova(&phyAddr, &bufferSize)) {
+                    ALOGE("get_mm_iova fail");
+                    return OMX_ErrorInsufficientResources;
+                }
+            } else {
+                if(pMem->get_phy_addr_from_ion(&phyAddr, &bufferSize)) {
+                    ALOGE("get_phy_addr_from_ion fail");
+                    return OMX_ErrorInsufficientResources;
+                }
+            }
+
+            pBuffer = (unsigned char*)(pMem->base()) + SprdStreamBuffer::kHeadroom;
+            BufferPrivateStruct* bufferPrivate = new BufferPrivateStruct();
+            bufferPrivate->pMem = pMem;
+            bufferPrivate->phyAddr = phyAddr;
+            bufferPrivate->bufferSize = bufferSize;
+            ALOGI("allocateBuffer, allocate input buffer from pmem, pBuffer: 0x%x, phyAddr: 0x%x, size: %d", pBuffer, phyAddr, bufferSize);
+
+            SprdSimpleOMXComponent::useBuffer(header, portIndex, appPrivate, size, pBuffer, bufferPrivate);
+            delete bufferPrivate;
+
+            return OMX_ErrorNone;
+        }
+    }
 
     case OMX_DirOutput:
     {
@@ -810,7 +837,21 @@ OMX_ERRORTYPE SPRDMPEG4Decoder::freeBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
+    {
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)(header->pInputPortPrivate);
+        if(pBufCtrl != NULL) {
+            if(pBufCtrl->pMem != NULL) {
+                ALOGI("freeBuffer, input phyAddr: 0x%x", pBufCtrl->phyAddr);
+                if (mIOMMUEnabled) {
+                    pBufCtrl->pMem->free_mm_iova(pBufCtrl->phyAddr, pBufCtrl->bufferSize);
+                }
+                pBufCtrl->pMem.clear();
+            }
+            delete pBufCtrl;
+            header->pInputPortPrivate = NULL;
+        }
         return SprdSimpleOMXComponent::freeBuffer(portIndex, header);
+    }
 
     case OMX_DirOutput:
     {
@@ -912,6 +953,7 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
         }
 
         mDecoderSwFlag = false;
+        change_ddr_freq();
 
         if(initDecoder() != OK) {
             ALOGE("onQueueFilled, init hw decoder failed.");
@@ -995,6 +1037,7 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
             video_format.i_extra = vol_size;
             if(video_format.i_extra>0 && (mPbuf_stream_v != NULL)) {
                 memcpy(mPbuf_stream_v, vol_data[0],vol_size);
+                mStream.reset();
                 video_format.p_extra = (uint8 *)mPbuf_stream_v;
                 video_format.p_extra_phy = (uint32)mPbuf_stream_p;
             } else {
@@ -1076,6 +1119,22 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
 
         int32_t bufferSize = inHeader->nFilledLen;
 
+        // Allocated input buffers are read in place, client buffers are
+        // copied into the stream buffer once.
+        BufferCtrlStruct *pInBufCtrl = (BufferCtrlStruct *)(inHeader->pInputPortPrivate);
+        uint32_t bitstreamPhy = 0;
+        size_t writable = 0;
+        if (pInBufCtrl != NULL && pInBufCtrl->phyAddr != 0) {
+            writable = SprdStreamBuffer::kHeadroom + inHeader->nOffset;
+            bitstreamPhy = pInBufCtrl->phyAddr + writable;
+        }
+        if (!mStream.prepare(bitstream, bitstreamPhy, writable, bufferSize, false)) {
+            ALOGE("onQueueFilled, bitstream of %d bytes doesn't fit into the stream buffer", bufferSize);
+            notify(OMX_EventError, OMX_ErrorUndefined, 0, NULL);
+            mSignalledError = true;
+            return;
+        }
+
         MMDecInput dec_in;
         MMDecOutput dec_out;
 
@@ -1122,12 +1181,9 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
             (*mMP4DecSetCurRecPic)(mHandle,outHeader->pBuffer, (uint8*)picPhyAddr, (void *)(outHeader));
         }
 
-        if (mPbuf_stream_v != NULL) {
-            memcpy(mPbuf_stream_v, bitstream, bufferSize);
-        }
-        dec_in.pStream= (uint8 *) mPbuf_stream_v;
-        dec_in.pStream_phy= (uint32) mPbuf_stream_p;
-        dec_in.dataLen = bufferSize;
+        dec_in.pStream= (uint8 *) mStream.data();
+        dec_in.pStream_phy= (uint32) mStream.phys();
+        dec_in.dataLen = mStream.length();
         dec_in.beLastFrm = 0;
         dec_in.expected_IVOP = mNeedIVOP;
         dec_in.beDisplayed = 1;
@@ -1172,6 +1228,7 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
             inInfo->mOwnedByUs = false;
             inQueue.erase(inQueue.begin());
             inInfo = NULL;
+            mStream.reset();
             notifyEmptyBufferDone(inHeader);
             inHeader = NULL;
 
@@ -1197,6 +1254,11 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
             ALOGE("now, we don't take care of the decoder return: %d", decRet);
         }
 
+        if (mBandwidthSession >= 0) {
+            SprdBandwidthGovernor::getInstance()->onFrame(mBandwidthSession, inHeader->nTimeStamp,
+                    (end_decode - start_decode) / 1000, bufferSize);
+        }
+
         CHECK_LE(bufferSize, inHeader->nFilledLen);
         inHeader->nOffset += inHeader->nFilledLen - bufferSize;
         inHeader->nFilledLen -= bufferSize;
@@ -1208,6 +1270,7 @@ void SPRDMPEG4Decoder::onQueueFilled(OMX_U32 portIndex) {
             inInfo->mOwnedByUs = false;
             inQueue.erase(inQueue.begin());
             inInfo = NULL;
+            mStream.reset();
             notifyEmptyBufferDone(inHeader);
             inHeader = NULL;
         }
@@ -1358,6 +1421,10 @@ bool SPRDMPEG4Decoder::portSettingsChanged() {
 }
 
 void SPRDMPEG4Decoder::onPortFlushCompleted(OMX_U32 portIndex) {
+    if (portIndex == 0) {
+        mStream.reset();
+    }
+
     if (portIndex == 0 && mInitialized) {
         mEOSStatus = INPUT_DATA_AVAILABLE;
         mNeedIVOP = true;
@@ -1399,6 +1466,7 @@ void SPRDMPEG4Decoder::onPortFlushPrepare(OMX_U32 portIndex) {
 
 void SPRDMPEG4Decoder::onReset() {
     mSignalledError = false;
+    mStream.reset();
     mInitialized = false;
     //avoid process error after stop codec and restart codec when port settings changing.
     mOutputPortSettingsChange = NONE;
@@ -18,6 +18,7 @@
 #define SPRD_MPEG4_DECODER_H_
 
 #include "SprdSimpleOMXComponent.h"
+#include "SprdStreamBuffer.h"
 #include <binder/MemoryHeapIon.h>
 #include "m4v_h263_dec_api.h"
 
@@ -103,7 +104,7 @@ private:
     int32_t mCropLeft, mCropTop, mCropRight, mCropBottom;
 
     int32 mMaxWidth, mMaxHeight;
-    int mSetFreqCount;
+    int mBandwidthSession;
 
     bool mSignalledError;
     bool mInitialized;
@@ -119,6 +120,7 @@ private:
     unsigned char* mPbuf_stream_v;
     int32 mPbuf_stream_p;
     int32 mPbuf_stream_size;
+    SprdStreamBuffer mStream;
 
     sp<MemoryHeapIon> mPmem_extra;
     unsigned char*  mPbuf_extra_v;
@@ -173,7 +175,6 @@ private:
     bool portSettingsChanged();
     void updatePortDefinitions();
     bool openDecoder(const char* libName);
-    void set_ddr_freq(const char* freq_in_khz);
     void change_ddr_freq();
 
     DISALLOW_EVIL_CONSTRUCTORS(SPRDMPEG4Decoder);
@@ -40,6 +40,9 @@
 
 #include "SPRDMPEG4Encoder.h"
 #include "ion_sprd.h"
+#include "SprdBandwidthGovernor.h"
+#include "SprdWorkerPool.h"
+#include "SprdYuvConvert.h"
 
 
 #define VIDEOENC_CURRENT_OPT
@@ -62,59 +65,22 @@ void dump_yuv( uint8 * pBuffer,uint32 aInBufSize)
 }
 
 /*
- * In case of orginal input height_org is not 16 aligned, we shoud copy original data to a larger space
- * Example: width_org = 640, height_org = 426,
- * We have to copy this data to a width_dst = 640 height_dst = 432 buffer which is 16 aligned.
- * Be careful, when doing this convert we MUST keep UV in their right position.
- *
- * FIXME: If width_org is not 16 aligned also, this would be much complicate
- *
+ * The I420 of the client, width_org x height_org packed, into the
+ * YVU420 semi-planar frame of the encoder, whose rows are width_dst
+ * apart and whose chroma starts after height_dst rows. Any width and
+ * height, large frames are split across pool.
  */
 inline static void ConvertYUV420PlanarToYVU420SemiPlanar(
     uint8_t *inyuv, uint8_t* outyuv,
     int32_t width_org, int32_t height_org,
-    int32_t width_dst, int32_t height_dst) {
-
-    int32_t inYsize = width_org * height_org;
-    uint32_t *outy = (uint32_t *) outyuv;
-    uint16_t *incb = (uint16_t *) (inyuv + inYsize);
-    uint16_t *incr = (uint16_t *) (inyuv + inYsize + (inYsize >> 2));
-
-    /* Y copying */
-    memcpy(outy, inyuv, inYsize);
-
-    /* U & V copying */
-    uint32_t *outUV = (uint32_t *) (outyuv + width_dst * height_dst);
-    for (int32_t i = height_org >> 1; i > 0; --i) {
-        for (int32_t j = width_org >> 2; j > 0; --j) {
-            uint32_t tempU = *incb++;
-            uint32_t tempV = *incr++;
-
-            tempU = (tempU & 0xFF) | ((tempU & 0xFF00) << 8);
-            tempV = (tempV & 0xFF) | ((tempV & 0xFF00) << 8);
-            uint32_t temp = tempV | (tempU << 8);
-
-            // Flip U and V
-            *outUV++ = temp;
-        }
-    }
-}
-
-#ifdef VIDEOENC_CURRENT_OPT
-inline static void set_ddr_freq(const char* freq_in_khz)
-{
-    const char* const set_freq = "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq";
+    int32_t width_dst, int32_t height_dst,
+    SprdWorkerPool *pool) {
+    SprdYuvConvert::Frame src, dst;
 
-    FILE* fp = fopen(set_freq, "w");
-    if (fp != NULL) {
-        fprintf(fp, "%s", freq_in_khz);
-        ALOGE("set ddr freq to %skhz", freq_in_khz);
-        fclose(fp);
-    } else {
-        ALOGE("Failed to open %s", set_freq);
-    }
+    SprdYuvConvert::layout(&src, SprdYuvConvert::I420, inyuv, width_org, height_org);
+    SprdYuvConvert::layout(&dst, SprdYuvConvert::NV21, outyuv, width_dst, height_dst);
+    SprdYuvConvert::convert(src, dst, width_org, height_org, pool);
 }
-#endif
 
 SPRDMPEG4Encoder::SPRDMPEG4Encoder(
     const char *name,
@@ -145,7 +111,8 @@ SPRDMPEG4Encoder::SPRDMPEG4Encoder(
       mPbuf_stream_size(0),
       mHandle(new tagMP4Handle),
       mEncConfig(new MMEncConfig),
-      mSetFreqCount(0),
+      mBandwidthSession(-1),
+      mConvertPool(NULL),
       mLibHandle(NULL),
       mMP4EncGetCodecCapability(NULL),
       mMP4EncPreInit(NULL),
@@ -209,6 +176,9 @@ SPRDMPEG4Encoder::~SPRDMPEG4Encoder() {
 
     releaseEncoder();
 
+    delete mConvertPool;
+    mConvertPool = NULL;
+
     List<BufferInfo *> &outQueue = getPortQueue(1);
     List<BufferInfo *> &inQueue = getPortQueue(0);
     CHECK(outQueue.empty());
@@ -241,12 +211,17 @@ OMX_ERRORTYPE SPRDMPEG4Encoder::initEncParams() {
     memset(mEncConfig, 0, sizeof(MMEncConfig));
 
 #ifdef VIDEOENC_CURRENT_OPT
-    if (((mVideoWidth <= 720) && (mVideoHeight <= 480)) || ((mVideoWidth <= 480) && (mVideoHeight <= 720))) {
-        set_ddr_freq("200000");
-        mSetFreqCount ++;
+    if (mBandwidthSession < 0) {
+        mBandwidthSession = SprdBandwidthGovernor::getInstance()->open(SprdBandwidthGovernor::ENCODER);
     }
+    SprdBandwidthGovernor::getInstance()->setFormat(mBandwidthSession, mVideoWidth, mVideoHeight, false);
 #endif
 
+    if (mVideoColorFormat == OMX_COLOR_FormatYUV420Planar && mConvertPool == NULL &&
+            mVideoWidth * mVideoHeight >= SprdYuvConvert::kMinParallelPixels) {
+        mConvertPool = new SprdWorkerPool("yuv2yvu", kNumConvertThreads, ANDROID_PRIORITY_AUDIO);
+    }
+
     MMCodecBuffer ExtraMemBfr;
     MMCodecBuffer StreamMemBfr;
     int32 phy_addr = 0;
@@ -424,9 +399,9 @@ OMX_ERRORTYPE SPRDMPEG4Encoder::releaseEncoder() {
     }
 
 #ifdef VIDEOENC_CURRENT_OPT
-    while (mSetFreqCount > 0) {
-        set_ddr_freq("0");
-        mSetFreqCount --;
+    if (mBandwidthSession >= 0) {
+        SprdBandwidthGovernor::getInstance()->close(mBandwidthSession);
+        mBandwidthSession = -1;
     }
 #endif
 
@@ -999,7 +974,7 @@ void SPRDMPEG4Encoder::onQueueFilled(OMX_U32 portIndex) {
 
                     if (mVideoColorFormat == OMX_COLOR_FormatYUV420Planar) {
                         ConvertYUV420PlanarToYVU420SemiPlanar((uint8_t*)vaddr, py, mVideoWidth, mVideoHeight,
-                                                             (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15));
+                                                             (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15), mConvertPool);
                     } else {
                         memcpy(py, vaddr, ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) * 3/2);
                     }
@@ -1044,7 +1019,7 @@ void SPRDMPEG4Encoder::onQueueFilled(OMX_U32 portIndex) {
 
                 if (mVideoColorFormat == OMX_COLOR_FormatYUV420Planar) {
                     ConvertYUV420PlanarToYVU420SemiPlanar(inputData, py, mVideoWidth, mVideoHeight,
-                                                         (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15));
+                                                         (mVideoWidth + 15) & (~15), (mVideoHeight + 15) & (~15), mConvertPool);
                 } else {
                     memcpy(py, inputData, ((mVideoWidth+15)&(~15)) * ((mVideoHeight+15)&(~15)) * 3/2);
                 }
@@ -1086,6 +1061,12 @@ void SPRDMPEG4Encoder::onQueueFilled(OMX_U32 portIndex) {
             ALOGI("MP4EncStrmEncode[%lld] %dms, in {%p-%p, %dx%d}, out {%p-%d, %d}, wh{%d, %d}, xy{%d, %d}",
                   mNumInputFrames, (unsigned int)((end_encode-start_encode) / 1000000L), py, py_phy,
                   mVideoWidth, mVideoHeight, vid_out.pOutBuf, vid_out.strmSize, vid_out.vopType, width, height, x, y);
+#ifdef VIDEOENC_CURRENT_OPT
+            if (mBandwidthSession >= 0 && ret == MMENC_OK && vid_out.strmSize > 0) {
+                SprdBandwidthGovernor::getInstance()->onFrame(mBandwidthSession, inHeader->nTimeStamp,
+                        (end_encode - start_encode) / 1000, vid_out.strmSize);
+            }
+#endif
             if ((vid_out.strmSize < 0) || (ret != MMENC_OK)) {
                 ALOGE("Failed to encode frame %lld, ret=%d", mNumInputFrames, ret);
                 mSignalledError = true;
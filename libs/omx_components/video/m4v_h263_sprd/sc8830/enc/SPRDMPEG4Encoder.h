@@ -25,6 +25,8 @@
 
 namespace android {
 
+struct SprdWorkerPool;
+
 //#define SPRD_DUMP_YUV
 //#define SPRD_DUMP_BS
 
@@ -56,6 +58,7 @@ protected:
 private:
     enum {
         kNumBuffers = 2,
+        kNumConvertThreads = 2,
     };
 
     // OMX port indexes that refer to input and
@@ -110,7 +113,10 @@ private:
     MMEncConfig *mEncConfig;
     Vector<InputBufferInfo> mInputBufferInfoVec;
 
-    int mSetFreqCount;
+    int mBandwidthSession;
+
+    // Splits the conversion of large I420 input, NULL for small frames.
+    SprdWorkerPool *mConvertPool;
 
     void* mLibHandle;
     FT_MP4EncGetCodecCapability	mMP4EncGetCodecCapability;
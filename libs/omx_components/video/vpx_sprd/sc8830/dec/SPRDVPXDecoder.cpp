@@ -31,8 +31,7 @@
 #include "vpx_dec_api.h"
 #include <dlfcn.h>
 #include "ion_sprd.h"
-
-//#define VIDEODEC_CURRENT_OPT  /*only open for SAMSUNG currently*/
+#include "SprdBandwidthGovernor.h"
 
 
 namespace android {
@@ -68,7 +67,7 @@ SPRDVPXDecoder::SPRDVPXDecoder(
       mPbuf_stream_v(NULL),
       mPbuf_stream_p(0),
       mPbuf_stream_size(0),
-      mSetFreqCount(0),
+      mBandwidthSession(-1),
       mEOSStatus(INPUT_DATA_AVAILABLE),
       mLibHandle(NULL),
       mVPXDecSetCurRecPic(NULL),
@@ -115,6 +114,7 @@ SPRDVPXDecoder::~SPRDVPXDecoder() {
         mPbuf_stream_p = 0;
         mPbuf_stream_size = 0;
     }
+    mStream.setHeap(NULL, 0, 0);
 
     if(mPbuf_extra_v != NULL) {
         if (mIOMMUEnabled) {
@@ -130,10 +130,9 @@ SPRDVPXDecoder::~SPRDVPXDecoder() {
         dlclose(mLibHandle);
         mLibHandle = NULL;
     }
-    while (mSetFreqCount > 0)
-    {
-        set_ddr_freq("0");
-        mSetFreqCount--;
+    if (mBandwidthSession >= 0) {
+        SprdBandwidthGovernor::getInstance()->close(mBandwidthSession);
+        mBandwidthSession = -1;
     }
 }
 
@@ -198,52 +197,14 @@ void SPRDVPXDecoder::initPorts() {
     ALOGI("%s, %d, def.nBufferCountMin: %d,def.nBufferCountActual : %d ", __FUNCTION__, __LINE__, def.nBufferCountMin, def.nBufferCountActual );
 }
 
-void SPRDVPXDecoder::set_ddr_freq(const char* freq_in_khz)
-{
-    const char* const set_freq = "/sys/devices/platform/scxx30-dmcfreq.0/devfreq/scxx30-dmcfreq.0/ondemand/set_freq";
-    FILE* fp = fopen(set_freq, "w");
-    if (fp != NULL)
-    {
-        fprintf(fp, "%s", freq_in_khz);
-        ALOGE("set ddr freq to %skhz", freq_in_khz);
-        fclose(fp);
-    }
-    else
-    {
-        ALOGE("Failed to open %s", set_freq);
-    }
-}
-
 void SPRDVPXDecoder::change_ddr_freq()
 {
-    uint32_t frame_size = mWidth * mHeight;
-    char* ddr_freq;
+    SprdBandwidthGovernor *governor = SprdBandwidthGovernor::getInstance();
 
-    if(frame_size > 1280*720)
-    {
-        ddr_freq = "500000";
+    if (mBandwidthSession < 0) {
+        mBandwidthSession = governor->open(SprdBandwidthGovernor::DECODER);
     }
-#ifdef VIDEODEC_CURRENT_OPT
-    else if(frame_size > 864*480)
-    {
-        ddr_freq = "300000";
-    }
-#else
-    else if(frame_size > 720*576)
-    {
-        ddr_freq = "400000";
-    }
-    else if(frame_size > 320*240)
-    {
-        ddr_freq = "300000";
-    }
-#endif
-    else
-    {
-        ddr_freq = "200000";
-    }
-    set_ddr_freq(ddr_freq);
-    mSetFreqCount ++;
+    governor->setFormat(mBandwidthSession, mWidth, mHeight, false);
 }
 
 status_t SPRDVPXDecoder::initDecoder() {
@@ -284,6 +245,7 @@ status_t SPRDVPXDecoder::initDecoder() {
             mPbuf_stream_size = (int32)size;
         }
     }
+    mStream.setHeap(mPbuf_stream_v, mPbuf_stream_p, mPbuf_stream_size);
 
     int32 size_inter = VP8_DECODER_INTERNAL_BUFFER_SIZE;
     mPbuf_inter = (uint8 *)malloc(size_inter);
@@ -528,6 +490,17 @@ OMX_ERRORTYPE SPRDVPXDecoder::internalUseBuffer(
     (*header)->nOutputPortIndex = portIndex;
     (*header)->nInputPortIndex = portIndex;
 
+    if(portIndex == OMX_DirInput && bufferPrivate != NULL) {
+        (*header)->pInputPortPrivate = new BufferCtrlStruct;
+        CHECK((*header)->pInputPortPrivate != NULL);
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)((*header)->pInputPortPrivate);
+        pBufCtrl->iRefCount = 0;
+        pBufCtrl->pMem = ((BufferPrivateStruct*)bufferPrivate)->pMem;
+        pBufCtrl->phyAddr = ((BufferPrivateStruct*)bufferPrivate)->phyAddr;
+        pBufCtrl->bufferSize = ((BufferPrivateStruct*)bufferPrivate)->bufferSize;
+        pBufCtrl->bufferFd = 0;
+    }
+
     if(portIndex == OMX_DirOutput) {
         (*header)->pOutputPortPrivate = new BufferCtrlStruct;
         CHECK((*header)->pOutputPortPrivate != NULL);
@@ -585,7 +558,50 @@ OMX_ERRORTYPE SPRDVPXDecoder::allocateBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
-        return SprdSimpleOMXComponent::allocateBuffer(header, portIndex, appPrivate, size);
+    {
+        // The bitstream is read in place, with room for the prefetch
+        // behind it.
+        MemoryHeapIon* pMem = NULL;
+        int phyAddr = 0;
+        int bufferSize = 0;
+        unsigned char* pBuffer = NULL;
+        OMX_U32 size64word = (size + SprdStreamBuffer::kHeadroom + SprdStreamBuffer::kTailroom + 1024*4 - 1) & ~(1024*4 - 1);
+
+        if (mIOMMUEnabled) {
+            pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_SYSTEM);
+        } else {
+            pMem = new MemoryHeapIon(SPRD_ION_DEV, size64word, MemoryHeapBase::NO_CACHING, ION_HEAP_ID_MASK_MM);
+        }
+
+        if(pMem->getHeapID() < 0) {
+            ALOGE("Failed to alloc inport pmem buffer");
+            return OMX_ErrorInsufficientResources;
+        }
+
+        if (mIOMMUEnabled) {
+            if(pMem->get_mm_iova(&phyAddr, &bufferSize)) {
+                ALOGE("get_mm_iova fail");
+                return OMX_ErrorInsufficientResources;
+            }
+        } else {
+            if(pMem->get_phy_addr_from_ion(&phyAddr, &bufferSize)) {
+                ALOGE("get_phy_addr_from_ion fail");
+                return OMX_ErrorInsufficientResources;
+            }
+        }
+
+        pBuffer = (unsigned char*)(pMem->base()) + SprdStreamBuffer::kHeadroom;
+        BufferPrivateStruct* bufferPrivate = new BufferPrivateStruct();
+        bufferPrivate->pMem = pMem;
+        bufferPrivate->phyAddr = phyAddr;
+        bufferPrivate->bufferSize = bufferSize;
+        ALOGI("allocateBuffer, allocate input buffer from pmem, pBuffer: 0x%x, phyAddr: 0x%x, size: %d", pBuffer, phyAddr, bufferSize);
+
+        SprdSimpleOMXComponent::useBuffer(header, portIndex, appPrivate, size, pBuffer, bufferPrivate);
+        delete bufferPrivate;
+
+        return OMX_ErrorNone;
+    }
 
     case OMX_DirOutput:
     {
@@ -644,7 +660,21 @@ OMX_ERRORTYPE SPRDVPXDecoder::freeBuffer(
     switch(portIndex)
     {
     case OMX_DirInput:
+    {
+        BufferCtrlStruct* pBufCtrl= (BufferCtrlStruct*)(header->pInputPortPrivate);
+        if(pBufCtrl != NULL) {
+            if(pBufCtrl->pMem != NULL) {
+                ALOGI("freeBuffer, input phyAddr: 0x%x", pBufCtrl->phyAddr);
+                if (mIOMMUEnabled) {
+                    pBufCtrl->pMem->free_mm_iova(pBufCtrl->phyAddr, pBufCtrl->bufferSize);
+                }
+                pBufCtrl->pMem.clear();
+            }
+            delete pBufCtrl;
+            header->pInputPortPrivate = NULL;
+        }
         return SprdSimpleOMXComponent::freeBuffer(portIndex, header);
+    }
 
     case OMX_DirOutput:
     {
@@ -750,12 +780,25 @@ void SPRDVPXDecoder::onQueueFilled(OMX_U32 portIndex) {
         uint8_t *bitstream = inHeader->pBuffer + inHeader->nOffset;
         int32_t bufferSize = inHeader->nFilledLen;
 
-        if (mPbuf_stream_v != NULL) {
-            memcpy(mPbuf_stream_v, bitstream, bufferSize);
+        // Allocated input buffers are read in place, client buffers are
+        // copied into the stream buffer once.
+        BufferCtrlStruct *pInBufCtrl = (BufferCtrlStruct *)(inHeader->pInputPortPrivate);
+        uint32_t bitstreamPhy = 0;
+        size_t writable = 0;
+        if (pInBufCtrl != NULL && pInBufCtrl->phyAddr != 0) {
+            writable = SprdStreamBuffer::kHeadroom + inHeader->nOffset;
+            bitstreamPhy = pInBufCtrl->phyAddr + writable;
         }
-        dec_in.pStream= (uint8 *) mPbuf_stream_v;
-        dec_in.pStream_phy= (uint32) mPbuf_stream_p;
-        dec_in.dataLen = bufferSize;
+        if (!mStream.prepare(bitstream, bitstreamPhy, writable, bufferSize, false)) {
+            ALOGE("onQueueFilled, bitstream of %d bytes doesn't fit into the stream buffer", bufferSize);
+            notify(OMX_EventError, OMX_ErrorUndefined, 0, NULL);
+            mSignalledError = true;
+            return;
+        }
+
+        dec_in.pStream= (uint8 *) mStream.data();
+        dec_in.pStream_phy= (uint32) mStream.phys();
+        dec_in.dataLen = mStream.length();
         dec_in.beLastFrm = 0;
         dec_in.expected_IVOP = 0;
         dec_in.beDisplayed = 1;
@@ -810,8 +853,10 @@ void SPRDVPXDecoder::onQueueFilled(OMX_U32 portIndex) {
 
 //        dump_bs( dec_in.pStream, dec_in.dataLen);
 
+        int64_t start_decode = systemTime();
         MMDecRet decRet = (*mVPXDecDecode)(mHandle, &dec_in,&dec_out);
-        ALOGI("%s, %d, decRet: %d, dec_out.frameEffective: %d", __FUNCTION__, __LINE__, decRet, dec_out.frameEffective);
+        int64_t end_decode = systemTime();
+        ALOGI("%s, %d, decRet: %d, %dms, dec_out.frameEffective: %d", __FUNCTION__, __LINE__, decRet, (unsigned int)((end_decode-start_decode) / 1000000L), dec_out.frameEffective);
 
         if(iUseAndroidNativeBuffer[OMX_DirOutput]) {
             if(mapper.unlock((const native_handle_t*)outHeader->pBuffer)) {
@@ -859,6 +904,11 @@ void SPRDVPXDecoder::onQueueFilled(OMX_U32 portIndex) {
 //            notify(OMX_EventError, OMX_ErrorStreamCorrupt, 0, NULL);
         }
 
+        if (mBandwidthSession >= 0) {
+            SprdBandwidthGovernor::getInstance()->onFrame(mBandwidthSession, inHeader->nTimeStamp,
+                    (end_decode - start_decode) / 1000, bufferSize);
+        }
+
         ALOGI("%s, %d, bufferSize: %d, inHeader->nFilledLen: %d", __FUNCTION__, __LINE__, bufferSize, inHeader->nFilledLen);
         CHECK_LE(bufferSize, inHeader->nFilledLen);
         inHeader->nOffset += inHeader->nFilledLen - bufferSize;
@@ -871,6 +921,7 @@ void SPRDVPXDecoder::onQueueFilled(OMX_U32 portIndex) {
             inInfo->mOwnedByUs = false;
             inQueue.erase(inQueue.begin());
             inInfo = NULL;
+            mStream.reset();
             notifyEmptyBufferDone(inHeader);
             inHeader = NULL;
 
@@ -957,6 +1008,7 @@ bool SPRDVPXDecoder::drainAllOutputBuffers() {
 void SPRDVPXDecoder::onPortFlushCompleted(OMX_U32 portIndex) {
     if (portIndex == 0) {
         mEOSStatus = INPUT_DATA_AVAILABLE;
+        mStream.reset();
     }
 }
 
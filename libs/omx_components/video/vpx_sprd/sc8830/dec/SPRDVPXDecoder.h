@@ -18,6 +18,7 @@
 #define SPRD_VPX_DECODER_H_
 
 #include "SprdSimpleOMXComponent.h"
+#include "SprdStreamBuffer.h"
 #include <binder/MemoryHeapIon.h>
 
 #include "vpx_dec_api.h"
@@ -88,7 +89,7 @@ private:
     int32_t mHeight;
 
     int32 mMaxWidth, mMaxHeight;
-    int mSetFreqCount;
+    int mBandwidthSession;
 
     bool mSignalledError;
 
@@ -99,6 +100,7 @@ private:
     unsigned char* mPbuf_stream_v;
     int32 mPbuf_stream_p;
     int32 mPbuf_stream_size;
+    SprdStreamBuffer mStream;
 
     sp<MemoryHeapIon> mPmem_extra;
     unsigned char*  mPbuf_extra_v;
@@ -135,7 +137,6 @@ private:
     bool drainAllOutputBuffers();
     void updatePortDefinitions();
     bool openDecoder(const char* libName);
-    void set_ddr_freq(const char* freq_in_khz);
     void change_ddr_freq();
 
     DISALLOW_EVIL_CONSTRUCTORS(SPRDVPXDecoder);
@@ -0,0 +1,45 @@
+LOCAL_PATH:= $(call my-dir)
+
+# name:raw_param.c:table prefix:sensor_raw_info, one host converter
+# isp_param_pack_<name> is built for each sensor
+ISP_PARAM_PACK_SENSORS := \
+	JX205:sensor_JX205_raw_param.c:s_JX205:s_JX205_mipi_raw_info \
+	JX507:sensor_JX507_mipi_raw_param.c:s_JX507_mipi:s_JX507_mipi_raw_info \
+	gc2235_mipi:sensor_gc2235_mipi_raw_param.c:s_gc2235_mipi:s_gc2235_mipi_raw_info \
+	gc5004_mipi:sensor_gc5004_mipi_raw_param.c:s_gc5004_mipi:s_gc5004_mipi_raw_info \
+	hi542:sensor_hi542_raw_param.c:s_hi542:s_hi542_mipi_raw_info \
+	hi544:sensor_hi544_raw_param.c:s_hi544:s_hi544_mipi_raw_info \
+	hm5040:sensor_hm5040_raw_param.c:s_hm5040:s_hm5040_mipi_raw_info \
+	imx179:sensor_imx179_raw_param.c:s_imx179:s_imx179_mipi_raw_info \
+	imx219:sensor_imx219_raw_param.c:s_imx219:s_imx219_mipi_raw_info \
+	ov13850:sensor_ov13850_raw_param.c:s_ov13850:s_ov13850_mipi_raw_info \
+	ov2680:sensor_ov2680_raw_param.c:s_ov2680:s_ov2680_mipi_raw_info \
+	ov5647:sensor_ov5647_raw_param.c:s_ov5647:s_ov5647_mipi_raw_info \
+	ov5648:sensor_ov5648_raw_param.c:s_ov5648:s_ov5648_mipi_raw_info \
+	ov5670:sensor_ov5670_raw_param.c:s_ov5670:s_ov5670_mipi_raw_info \
+	ov8825:sensor_ov8825_raw_param.c:s_ov8825:s_ov8825_mipi_raw_info \
+	ov8830:sensor_ov8830_raw_param.c:s_ov8830:s_ov8830_mipi_raw_info \
+	ov8858:sensor_ov8858_raw_param.c:s_ov8825:s_ov8858_mipi_raw_info \
+	ov8865:sensor_ov8865_raw_param.c:s_ov8865:s_ov8865_mipi_raw_info \
+	ov9760:sensor_ov9760_raw_param.c:s_ov9760:s_ov9760_mipi_raw_info \
+	s5k3h2yx:sensor_s5k3h2yx_raw_param.c:s_s5k3h2yx:s_s5k3h2yx_mipi_raw_info \
+	s5k3h7yx:sensor_s5k3h7yx_raw_param.c:s_s5k3h7yx:s_s5k3h7yx_mipi_raw_info \
+	s5k4e1ga:sensor_s5k4e1ga_raw_param.c:s_s5k4e1ga:s_s5k4e1ga_mipi_raw_info
+
+define isp-param-pack-sensor
+include $$(CLEAR_VARS)
+LOCAL_MODULE:= isp_param_pack_$(word 1,$(1))
+LOCAL_MODULE_TAGS:= optional
+LOCAL_CFLAGS += -include stdint.h \
+	-DISP_PARAM_PACK_NAME=\"$(word 1,$(1))\" \
+	-DISP_PARAM_PACK_SRC=\"$(word 2,$(1))\" \
+	-DISP_PARAM_PACK_TAB=$(word 3,$(1)) \
+	-DISP_PARAM_PACK_INFO=$(word 4,$(1))
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../libs/libcamera/isp1.0/inc \
+	$(LOCAL_PATH)/../../libs/libcamera/sensor
+LOCAL_SRC_FILES:= isp_param_pack_gen.c \
+	../../libs/libcamera/isp1.0/isp_param_pack.c
+include $$(BUILD_HOST_EXECUTABLE)
+endef
+
+$(foreach s,$(ISP_PARAM_PACK_SENSORS),$(eval $(call isp-param-pack-sensor,$(subst :, ,$(s)))))
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "isp_param_pack_sensor.h"
+
+int main(int argc, char **argv)
+{
+	struct isp_param_pack_len len;
+	struct isp_param_pack pack;
+	char out_name[128];
+	const char *out = out_name;
+	uint8_t *buf;
+	uint32_t size;
+	FILE *fp;
+
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+		fprintf(stderr, "usage: %s [pack file]\n", argv[0]);
+		return 1;
+	}
+	if (argc == 2)
+		out = argv[1];
+	else
+		snprintf(out_name, sizeof(out_name), "sensor_%s_raw_param.pack", ISP_PARAM_PACK_NAME);
+
+	if (pack_sensor_len(&len)) {
+		fprintf(stderr, "%s: an ae table of %s is not one of its tables\n",
+			ISP_PARAM_PACK_NAME, ISP_PARAM_PACK_SRC);
+		return 1;
+	}
+
+	size = isp_param_pack_write(pack_sensor_info(), &len, ISP_PARAM_PACK_NAME, NULL, 0);
+	buf = size ? malloc(size) : NULL;
+	if (!buf || size != isp_param_pack_write(pack_sensor_info(), &len, ISP_PARAM_PACK_NAME, buf, size)) {
+		fprintf(stderr, "%s: can not lay out the pack\n", ISP_PARAM_PACK_NAME);
+		free(buf);
+		return 1;
+	}
+
+	/* what the loader will see */
+	if (isp_param_pack_parse(buf, size, ISP_PARAM_PACK_NAME, &pack)) {
+		fprintf(stderr, "%s: the pack does not parse\n", ISP_PARAM_PACK_NAME);
+		free(buf);
+		return 1;
+	}
+
+	fp = fopen(out, "wb");
+	if (!fp || fwrite(buf, 1, size, fp) != size) {
+		fprintf(stderr, "%s: can not write %s\n", ISP_PARAM_PACK_NAME, out);
+		if (fp)
+			fclose(fp);
+		free(buf);
+		return 1;
+	}
+	if (fclose(fp)) {
+		fprintf(stderr, "%s: can not write %s\n", ISP_PARAM_PACK_NAME, out);
+		free(buf);
+		return 1;
+	}
+
+	printf("%s: %u bytes, %u sections, raw version 0x%08x\n", out, size,
+		((struct isp_param_pack_head *)buf)->sec_num,
+		((struct isp_param_pack_head *)buf)->raw_version_id);
+	free(buf);
+	return 0;
+}
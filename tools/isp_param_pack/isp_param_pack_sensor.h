@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* The raw_param.c of one sensor built for the host. The build defines
+ *   ISP_PARAM_PACK_NAME  the sensor name, "imx219"
+ *   ISP_PARAM_PACK_SRC   the raw_param.c, "sensor_imx219_raw_param.c"
+ *   ISP_PARAM_PACK_TAB   the prefix of its aes and aeg tables, s_imx219
+ *   ISP_PARAM_PACK_INFO  its sensor_raw_info, s_imx219_mipi_raw_info
+ * sensor_raw_fix_info does not carry the length of the ae tables, they
+ * are taken from the aes and aeg tables the fix info points at, the
+ * weight table is the 32x32 grid of the aem and the awb map is 1024*6
+ * in every tuning, some of which record its length as 0. */
+#ifndef _ISP_PARAM_PACK_SENSOR_H_
+#define _ISP_PARAM_PACK_SENSOR_H_
+
+#include <stddef.h>
+#include <string.h>
+#include "sensor_raw.h"
+#include "isp_param_pack.h"
+
+#ifndef PNULL
+#define PNULL ((void*)0)
+#endif
+
+#include ISP_PARAM_PACK_SRC
+
+#define _PACK_CAT2(a, b) a##b
+#define _PACK_CAT(a, b) _PACK_CAT2(a, b)
+#define PACK_TAB(s) _PACK_CAT(ISP_PARAM_PACK_TAB, s)
+#define PACK_TAB_LEN(s) {PACK_TAB(s), sizeof(PACK_TAB(s))}
+#define PACK_AE_WEIGHT_LEN (32 * 32)
+#define PACK_AWB_MAP_LEN (1024 * 6 * sizeof(uint16_t))
+
+struct pack_tab {
+	const void *addr;
+	uint32_t size;
+};
+
+/* some tunings point a gain table at an exposure one */
+static const struct pack_tab s_pack_ae[] = {
+	PACK_TAB_LEN(_aes_00),
+	PACK_TAB_LEN(_aes_10),
+	PACK_TAB_LEN(_aes_01),
+	PACK_TAB_LEN(_aes_11),
+	PACK_TAB_LEN(_aeg_00),
+	PACK_TAB_LEN(_aeg_10),
+	PACK_TAB_LEN(_aeg_01),
+	PACK_TAB_LEN(_aeg_11),
+};
+
+static uint32_t pack_tab_len(const void *addr)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(s_pack_ae) / sizeof(s_pack_ae[0]); i++) {
+		if (s_pack_ae[i].addr == addr)
+			return s_pack_ae[i].size;
+	}
+	return 0;
+}
+
+static struct sensor_raw_info *pack_sensor_info(void)
+{
+	return &ISP_PARAM_PACK_INFO;
+}
+
+/* returns 0 when every table the fix info points at has a length */
+static int pack_sensor_len(struct isp_param_pack_len *len)
+{
+	const struct sensor_raw_fix_info *fix = ISP_PARAM_PACK_INFO.fix_ptr;
+	uint32_t i;
+
+	memset(len, 0, sizeof(*len));
+	if (NULL != fix->ae.weight_tab)
+		len->ae_weight = PACK_AE_WEIGHT_LEN;
+	if (NULL != fix->awb.addr)
+		len->awb_map = fix->awb.len > PACK_AWB_MAP_LEN ? fix->awb.len : PACK_AWB_MAP_LEN;
+
+	for (i = 0; i < SENSOR_AE_TAB_NUM; i++) {
+		len->ae_e[i] = pack_tab_len(fix->ae.tab[i].e_ptr);
+		len->ae_g[i] = pack_tab_len(fix->ae.tab[i].g_ptr);
+		if ((NULL != fix->ae.tab[i].e_ptr && 0 == len->ae_e[i])
+			|| (NULL != fix->ae.tab[i].g_ptr && 0 == len->ae_g[i]))
+			return -1;
+	}
+	return 0;
+}
+
+#endif
@@ -31,6 +31,7 @@ LOCAL_SRC_FILES := client_hdl.cpp \
 		   log_config.cpp \
 		   log_ctrl.cpp \
 		   log_file.cpp \
+		   log_index.cpp \
 		   log_pipe_dev.cpp \
 		   log_pipe_hdl.cpp \
 		   media_stor.cpp \
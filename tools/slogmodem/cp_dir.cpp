@@ -12,17 +12,23 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <ctime>
 #include "cp_dir.h"
 #include "cp_set_dir.h"
 #include "log_file.h"
 #include "media_stor.h"
 
+#define MANIFEST_MAGIC "SLOGMODEM_MANIFEST"
+#define MANIFEST_VERSION 2
+
 CpDirectory::CpDirectory(CpSetDirectory* par_dir, const LogString& dir)
 	:m_cp_set_dir {par_dir},
 	 m_name(dir),
 	 m_size {0},
 	 m_start_log {0},
+	 m_manifest_dirty {false},
 	 m_cur_log {0},
 	 m_log_watch {0}
 {
@@ -32,12 +38,28 @@ CpDirectory::~CpDirectory()
 {
 	// TODO: cancel file watch
 	//cancel_watch();
-	clear_ptr_container(m_log_files);
+	if (m_manifest_dirty) {
+		save_manifest();
+	}
+	while (!m_log_files.empty()) {
+		LogFile* f = m_log_files.oldest();
+		m_log_files.remove(f);
+		delete f;
+	}
 }
 
 int CpDirectory::stat()
 {
 	LogString path = m_cp_set_dir->path() + "/" + m_name;
+	struct stat dir_stat;
+
+	if (::stat(ls2cstring(path), &dir_stat)) {
+		return -1;
+	}
+	if (!load_manifest(dir_stat)) {
+		return 0;
+	}
+
 	DIR* pd = opendir(ls2cstring(path));
 
 	if (!pd) {
@@ -64,41 +86,203 @@ int CpDirectory::stat()
 						   this, LogFile::LT_UNKNOWN,
 						   file_stat.st_size);
 			log->get_type();
-			insert_ascending(m_log_files, log);
+			m_log_files.add(log);
 			m_size += file_stat.st_size;
 		}
 	}
 
 	closedir(pd);
 
+	// Drop the manifest that did not match, it may not be rewritten
+	// in this second
+	manifest_changed();
+	save_manifest();
+
 	return 0;
 }
 
-void CpDirectory::insert_ascending(LogList<LogFile*>& lst, LogFile* f)
+LogString CpDirectory::manifest_path() const
+{
+	return m_cp_set_dir->path() + "/." + m_name + ".manifest";
+}
+
+void CpDirectory::manifest_changed()
 {
-	switch (f->type()) {
-	case LogFile::LT_VERSION:
-		lst.push_back(f);
-		break;
-	case LogFile::LT_UNKNOWN:
-		lst.push_front(f);
-		break;
-	default:
-		LogList<LogFile*>::iterator it;
-		for (it = lst.begin(); it != lst.end(); ++it) {
-			LogFile* p = *it;
-			if (LogFile::LT_VERSION == p->type()) {
-				break;
-			}
-			if (LogFile::LT_UNKNOWN != p->type()) {
-				if (*f < *p) {
-					break;
-				}
-			}
+	// The manifest on disk is stale from now on, a crash before it's
+	// rewritten shall not leave it behind.
+	if (!m_manifest_dirty) {
+		unlink(ls2cstring(manifest_path()));
+		m_manifest_dirty = true;
+	}
+}
+
+int CpDirectory::count_files(const LogString& path)
+{
+	DIR* pd = opendir(ls2cstring(path));
+
+	if (!pd) {
+		return -1;
+	}
+
+	struct dirent* dent;
+	int num = 0;
+
+	while (true) {
+		dent = readdir(pd);
+		if (!dent) {
+			break;
+		}
+		// The file type from readdir saves a stat per entry.
+		bool is_reg = DT_REG == dent->d_type;
+		if (DT_UNKNOWN == dent->d_type) {
+			LogString file_path = path + "/" + dent->d_name;
+			struct stat file_stat;
+
+			is_reg = !::stat(ls2cstring(file_path), &file_stat) &&
+				 S_ISREG(file_stat.st_mode);
+		}
+		if (is_reg) {
+			++num;
 		}
-		lst.insert(it, f);
-		break;
 	}
+
+	closedir(pd);
+
+	return num;
+}
+
+int CpDirectory::load_manifest(const struct stat& dir_stat)
+{
+	LogString path = manifest_path();
+	FILE* pf = fopen(ls2cstring(path), "r");
+
+	if (!pf) {
+		return -1;
+	}
+
+	char line[512];
+	char magic[32];
+	int ver;
+	unsigned long mtime;
+	unsigned long long ino;
+	unsigned num;
+	int ret = -1;
+
+	if (!fgets(line, sizeof line, pf) ||
+	    5 != sscanf(line, "%31s %d %lu %llu %u", magic, &ver, &mtime,
+			&ino, &num) ||
+	    strcmp(magic, MANIFEST_MAGIC) || MANIFEST_VERSION != ver ||
+	    static_cast<unsigned long>(dir_stat.st_mtime) != mtime ||
+	    static_cast<unsigned long long>(dir_stat.st_ino) != ino) {
+		fclose(pf);
+		return -1;
+	}
+
+	// The mtime has a one second granularity and can be set back,
+	// the number of files shall match as well.
+	int file_num = count_files(m_cp_set_dir->path() + "/" + m_name);
+	if (file_num < 0 || static_cast<unsigned>(file_num) != num) {
+		info_log("stale manifest %s", ls2cstring(path));
+		fclose(pf);
+		return -1;
+	}
+
+	unsigned n;
+	uint64_t total = 0;
+
+	for (n = 0; n < num; ++n) {
+		if (!fgets(line, sizeof line, pf)) {
+			break;
+		}
+
+		char* endp;
+		unsigned long sz = strtoul(line, &endp, 10);
+		if (endp == line || ' ' != *endp) {
+			break;
+		}
+		char* name = endp + 1;
+		size_t len = strlen(name);
+		if (len < 2 || '\n' != name[len - 1]) {
+			break;
+		}
+		name[len - 1] = '\0';
+
+		LogFile* log = new LogFile(LogString(name), this,
+					   LogFile::LT_UNKNOWN, sz);
+		log->get_type();
+		m_log_files.add(log);
+		total += sz;
+	}
+
+	if (n == num && EOF == fgetc(pf)) {
+		m_size += total;
+		ret = 0;
+	} else {
+		err_log("invalid manifest %s", ls2cstring(path));
+		while (!m_log_files.empty()) {
+			LogFile* f = m_log_files.oldest();
+			m_log_files.remove(f);
+			delete f;
+		}
+	}
+
+	fclose(pf);
+
+	return ret;
+}
+
+int CpDirectory::save_manifest()
+{
+	LogString dir_path = m_cp_set_dir->path() + "/" + m_name;
+	struct stat dir_stat;
+
+	if (::stat(ls2cstring(dir_path), &dir_stat)) {
+		return -1;
+	}
+	// A change later in this second would not change the mtime
+	if (time(0) <= dir_stat.st_mtime) {
+		return -1;
+	}
+
+	LogString path = manifest_path();
+	LogString tmp_path = path + ".tmp";
+	FILE* pf = fopen(ls2cstring(tmp_path), "w");
+
+	if (!pf) {
+		err_log("create %s error", ls2cstring(tmp_path));
+		return -1;
+	}
+
+	fprintf(pf, "%s %d %lu %llu %u\n", MANIFEST_MAGIC, MANIFEST_VERSION,
+		static_cast<unsigned long>(dir_stat.st_mtime),
+		static_cast<unsigned long long>(dir_stat.st_ino),
+		static_cast<unsigned>(m_log_files.num()));
+	for (int t = 0; t < LogFile::LT_TYPE_NUM; ++t) {
+		LogFile::LogType type = static_cast<LogFile::LogType>(t);
+		size_t n = m_log_files.type_num(type);
+		for (size_t i = 0; i < n; ++i) {
+			const LogFile* f = m_log_files.at(type, i);
+			fprintf(pf, "%lu %s\n",
+				static_cast<unsigned long>(f->size()),
+				ls2cstring(f->base_name()));
+		}
+	}
+
+	int ret = ferror(pf) ? -1 : 0;
+	if (fclose(pf)) {
+		ret = -1;
+	}
+	if (!ret) {
+		ret = rename(ls2cstring(tmp_path), ls2cstring(path));
+	}
+	if (ret) {
+		err_log("write %s error", ls2cstring(path));
+		unlink(ls2cstring(tmp_path));
+	} else {
+		m_manifest_dirty = false;
+	}
+
+	return ret;
 }
 
 int CpDirectory::create()
@@ -132,10 +316,11 @@ LogFile* CpDirectory::create_log_file()
 		delete log_file;
 		log_file = 0;
 	} else {
-		if (!get_file_type_num(m_log_files, LogFile::LT_LOG)) {
+		if (!m_log_files.type_num(LogFile::LT_LOG)) {
 			m_start_log = log_file;
 		}
-		m_log_files.push_back(log_file);
+		m_log_files.add(log_file);
+		manifest_changed();
 		m_cur_log = log_file;
 		// TODO: Watch the current log
 		//FileWatcher* fw = cp_set_dir()->get_media()->file_watcher();
@@ -172,36 +357,40 @@ void CpDirectory::stop()
 		m_cur_log->close();
 		m_cur_log = 0;
 	}
+	if (m_manifest_dirty) {
+		save_manifest();
+	}
 }
 
 void CpDirectory::rotate()
 {
-	LogList<LogFile*>::iterator it;
 	LogString spath;
+	size_t n = m_log_files.type_num(LogFile::LT_LOG);
 
+	// The log number is part of the name, every log is renamed.
 	spath = m_cp_set_dir->path() + "/" + m_name;
-	for (it = m_log_files.begin(); it != m_log_files.end(); ++it) {
-		LogFile* f = *it;
-		if (LogFile::LT_LOG == f->type()) {
-			f->rotate(spath);
-		}
+	for (size_t i = 0; i < n; ++i) {
+		m_log_files.at(LogFile::LT_LOG, i)->rotate(spath);
+	}
+	if (n) {
+		manifest_changed();
 	}
 }
 
 uint64_t CpDirectory::trim(uint64_t sz)
 {
-	LogList<LogFile*>::iterator it = m_log_files.begin();
 	uint64_t total_dec = 0;
 	LogString par_dir = m_cp_set_dir->path() + "/" + m_name;
 
-	while (it != m_log_files.end()) {
-		LogFile* f = *it;
+	while (!m_log_files.empty()) {
+		LogFile* f = m_log_files.oldest();
 		if (f->remove(par_dir)) {
 			err_log("delete %s error",
 				ls2cstring(f->base_name()));
 			break;
 		}
-		it = m_log_files.erase(it);
+		m_log_files.remove(f);
+		manifest_changed();
 		size_t dec_size = f->size();
 		delete f;
 		total_dec += dec_size;
@@ -220,6 +409,9 @@ int CpDirectory::remove()
 {
 	LogString spath;
 	
+	unlink(ls2cstring(manifest_path()));
+	m_manifest_dirty = false;
+
 	str_assign(spath, "rm -fr ", 7);
 	spath += (m_cp_set_dir->path() + "/" + m_name);
 	return system(ls2cstring(spath));
@@ -227,44 +419,42 @@ int CpDirectory::remove()
 
 int CpDirectory::remove(LogFile* rmf)
 {
-	LogList<LogFile*>::iterator it;
-	int ret = -1;
-
-	for (it = m_log_files.begin(); it != m_log_files.end(); ++it) {
-		LogFile* f = *it;
-		if (rmf == f) {
-			m_log_files.erase(it);
-			LogString spath = m_cp_set_dir->path() + "/" + m_name;
-			f->remove(spath);
-			dec_size(f->size());
-			delete f;
-			ret = 0;
-			break;
-		}
+	if (m_log_files.remove(rmf)) {
+		return -1;
 	}
 
-	return ret;
+	LogString spath = m_cp_set_dir->path() + "/" + m_name;
+	rmf->remove(spath);
+	dec_size(rmf->size());
+	delete rmf;
+	manifest_changed();
+
+	return 0;
 }
 
 uint64_t CpDirectory::trim_working_dir(uint64_t sz)
 {
-	LogList<LogFile*>::iterator it = m_log_files.begin();
 	uint64_t total_dec = 0;
 	LogString par_dir = m_cp_set_dir->path() + "/" + m_name;
 
-	while (it != m_log_files.end()) {
-		LogFile* f = *it;
-		if (f == m_start_log || f == m_cur_log ||
-		    LogFile::LT_VERSION == f->type()) {
-			++it;
-			continue;
+	// Keep the starting log and the current log out of the way
+	bool has_start = m_start_log && !m_log_files.remove(m_start_log);
+	bool has_cur = m_cur_log && m_cur_log != m_start_log &&
+		       !m_log_files.remove(m_cur_log);
+
+	while (!m_log_files.empty()) {
+		LogFile* f = m_log_files.oldest();
+		// Version files are the last ones
+		if (LogFile::LT_VERSION == f->type()) {
+			break;
 		}
 		if (f->remove(par_dir)) {
 			err_log("delete %s error",
 				ls2cstring(f->base_name()));
 			break;
 		}
-		it = m_log_files.erase(it);
+		m_log_files.remove(f);
+		manifest_changed();
 		size_t dec_size = f->size();
 		delete f;
 		total_dec += dec_size;
@@ -276,50 +466,40 @@ uint64_t CpDirectory::trim_working_dir(uint64_t sz)
 
 	m_size -= total_dec;
 
+	if (has_start) {
+		m_log_files.add(m_start_log);
+	}
+	if (has_cur) {
+		m_log_files.add(m_cur_log);
+	}
+
 	// Rename the starting log
 	rename_start_log();
 
 	return total_dec;
 }
 
-int CpDirectory::get_file_type_num(const LogList<LogFile*>& lst,
-				   LogFile::LogType type)
-{
-	LogList<LogFile*>::const_iterator it;
-	int num = 0;
-
-	for (it = lst.begin(); it != lst.end(); ++it) {
-		const LogFile* f = *it;
-		if (type == f->type()) {
-			++num;
-		}
-	}
-
-	return num;
-}
-
 int CpDirectory::rename_start_log()
 {
 	if (!m_start_log) {
 		return 0;
 	}
 
-	LogList<LogFile*>::iterator it;
+	// The oldest log other than the starting log
+	LogFile* f = 0;
+	size_t n = m_log_files.type_num(LogFile::LT_LOG);
 
-	for (it = m_log_files.begin(); it != m_log_files.end(); ++it) {
-		LogFile* f = *it;
-		if (f == m_start_log) {
-			continue;
-		}
-		if (LogFile::LT_LOG == f->type()) {
+	for (size_t i = 0; i < n; ++i) {
+		f = m_log_files.at(LogFile::LT_LOG, i);
+		if (f != m_start_log) {
 			break;
 		}
+		f = 0;
 	}
 
 	int ret = -1;
 
-	if (it != m_log_files.end()) {
-		LogFile* f = *it;
+	if (f) {
 		const LogString& name = f->base_name();
 		size_t len;
 		unsigned num;
@@ -343,7 +523,8 @@ LogFile* CpDirectory::create_file(const LogString& fname,
 		delete log_file;
 		log_file = 0;
 	} else {
-		m_log_files.push_back(log_file);
+		m_log_files.add(log_file);
+		manifest_changed();
 	}
 
 	return log_file;
@@ -373,19 +554,8 @@ void CpDirectory::log_delete_notify(void* client, uint32_t evt)
 
 void CpDirectory::file_removed(LogFile* f)
 {
-	LogList<LogFile*>::iterator it;
-	bool found = false;
-
-	for (it = m_log_files.begin(); it != m_log_files.end(); ++it) {
-		LogFile* pf = *it;
-		if (f == pf) {
-			m_log_files.erase(it);
-			found = true;
-			break;
-		}
-	}
-
-	if (found) {
+	if (!m_log_files.remove(f)) {
+		manifest_changed();
 		m_size -= f->size();
 		if (f == m_start_log) {
 			m_start_log = 0;
@@ -10,8 +10,10 @@
 #ifndef _CP_DIR_H_
 #define _CP_DIR_H_
 
+#include <sys/stat.h>
 #include "cp_log_cmn.h"
 #include "log_file.h"
+#include "log_index.h"
 #include "file_watcher.h"
 
 class CpSetDirectory;
@@ -47,6 +49,10 @@ public:
 	}
 
 	/*  stat - collect file statistics of the directory.
+	 *
+	 *  The statistics are taken from the manifest if it's up to
+	 *  date, otherwise the directory is scanned and the manifest
+	 *  is rewritten.
 	 *
 	 *  Return 0 on success, -1 on failure.
 	 */
@@ -116,8 +122,10 @@ private:
 	uint64_t m_size;
 	// Starting log in this run. For a history directory, this is 0.
 	LogFile* m_start_log;
-	// Log list, including the starting log file (the first one)
-	LogList<LogFile*> m_log_files;
+	// Log files in trimming order, including the starting log file
+	LogIndex m_log_files;
+	// The file list has changed since the manifest was written
+	bool m_manifest_dirty;
 	// Current log file
 	LogFile* m_cur_log;
 	// File watch on current log
@@ -126,9 +134,40 @@ private:
 	int rename_start_log();
 	void cancel_watch();
 
-	static void insert_ascending(LogList<LogFile*>& lst, LogFile* f);
-	static int get_file_type_num(const LogList<LogFile*>& lst,
-				     LogFile::LogType type);
+	/*  manifest_path - path of the manifest file.
+	 *
+	 *  The manifest is kept in the CP set directory so that
+	 *  writing it does not change the modification time of the
+	 *  CP directory.
+	 */
+	LogString manifest_path() const;
+	/*  load_manifest - load the file list from the manifest.
+	 *  @dir_stat: stat of the CP directory.
+	 *
+	 *  The manifest is used only if it's written for the current
+	 *  modification time and inode of the directory, and lists as
+	 *  many files as the directory has.
+	 *
+	 *  Return 0 on success, -1 on failure.
+	 */
+	int load_manifest(const struct stat& dir_stat);
+	/*  manifest_changed - mark the file list changed.
+	 *
+	 *  The manifest on disk is removed on the first change, it's
+	 *  rewritten on stop() or when the object is deleted.
+	 */
+	void manifest_changed();
+	/*  count_files - count the regular files in a directory.
+	 *  @path: the directory path.
+	 *
+	 *  Return the number of files, -1 on failure.
+	 */
+	static int count_files(const LogString& path);
+	/*  save_manifest - write the file list to the manifest.
+	 *
+	 *  Return 0 on success, -1 on failure.
+	 */
+	int save_manifest();
 	/*  log_delete_notify - current log file deletion notification
 	 *                      function.
 	 *  @client: pointer to the CpDirectory object
@@ -60,6 +60,18 @@
 		c.remove(v);
 	}
 
+	template<typename C, typename V>
+	void insert_at(C& c, size_t index, const V& v)
+	{
+		c.insert(c.begin() + index, v);
+	}
+
+	template<typename C>
+	void remove_items(C& c, size_t index, size_t n)
+	{
+		c.erase(c.begin() + index, c.begin() + index + n);
+	}
+
 	template<typename T>
 	T rm_last(LogList<T>& c)
 	{
@@ -100,6 +112,18 @@
 		c.removeAt(index);
 	}
 
+	template<typename C, typename V>
+	void insert_at(C& c, size_t index, const V& v)
+	{
+		c.insertAt(v, index);
+	}
+
+	template<typename C>
+	void remove_items(C& c, size_t index, size_t n)
+	{
+		c.removeItemsAt(index, n);
+	}
+
 	template<typename C, typename V>
 	void ll_remove(C& c, const V& v)
 	{
@@ -46,11 +46,17 @@ int CpSetDirectory::stat()
 		    !strcmp(dent->d_name, "..")) {
 			continue;
 		}
-		d_path = m_path + "/" + dent->d_name;
-		struct stat file_stat;
-
-		if (!::stat(ls2cstring(d_path), &file_stat) &&
-		    S_ISDIR(file_stat.st_mode)) {
+		// The file type from readdir saves a stat per entry.
+		// CP manifests are regular files in this directory.
+		bool is_dir = DT_DIR == dent->d_type;
+		if (DT_UNKNOWN == dent->d_type) {
+			struct stat file_stat;
+
+			d_path = m_path + "/" + dent->d_name;
+			is_dir = !::stat(ls2cstring(d_path), &file_stat) &&
+				 S_ISDIR(file_stat.st_mode);
+		}
+		if (is_dir) {
 			CpDirectory* cp_dir = new CpDirectory(this,
 							      LogString(dent->d_name));
 			if (!cp_dir->stat()) {
@@ -10,6 +10,7 @@
 #ifndef _LOG_FILE_H_
 #define _LOG_FILE_H_
 
+#include <ctime>
 #include "cp_log_cmn.h"
 
 class CpDirectory;
@@ -26,7 +27,9 @@ public:
 		LT_MINI_DUMP,
 		LT_VERSION,
 		LT_RINGBUF,
-		LT_SLEEPLOG
+		LT_SLEEPLOG,
+		// Number of log types
+		LT_TYPE_NUM
 	};
 
 	struct FileTime
@@ -89,6 +92,15 @@ public:
 		return m_size;
 	}
 
+	/*  file_time - the time in the file name.
+	 *
+	 *  The year is 0 if the name has no time.
+	 */
+	const FileTime& file_time() const
+	{
+		return m_time;
+	}
+
 	/*  create - create the file.
 	 *
 	 *  Return 0 on success, -1 on failure.
@@ -0,0 +1,159 @@
+/*
+ *  log_index.cpp - ordered index of the files in a CP directory.
+ *
+ *  Copyright (C) 2015 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-19
+ *  Initial version.
+ */
+
+#include "log_index.h"
+
+// Removed entries kept at the head of a vector before it's compacted
+#define LOG_INDEX_MAX_HEAD 32
+
+LogIndex::LogIndex()
+	:m_num {0},
+	 m_seq {0},
+	 m_newest {0}
+{
+	for (int t = 0; t < LogFile::LT_TYPE_NUM; ++t) {
+		m_head[t] = 0;
+	}
+}
+
+uint64_t LogIndex::time_key(const LogFile::FileTime& ft)
+{
+	// Every field but the year has two digits in the file name
+	uint64_t key = static_cast<uint64_t>(ft.year);
+
+	key = key * 100 + ft.month;
+	key = key * 100 + ft.mday;
+	key = key * 100 + ft.hour;
+	key = key * 100 + ft.min;
+	key = key * 100 + ft.sec;
+
+	return key;
+}
+
+size_t LogIndex::upper_bound(int t, uint64_t key) const
+{
+	const LogVector<Entry>& v = m_files[t];
+	size_t lo = m_head[t];
+	size_t hi = v.size();
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (key < v[mid].key) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return lo;
+}
+
+void LogIndex::add(LogFile* f)
+{
+	int t = f->type();
+	const LogFile::FileTime& ft = f->file_time();
+	LogVector<Entry>& v = m_files[t];
+	Entry e;
+
+	e.key = ft.year ? time_key(ft) : m_newest;
+	e.seq = m_seq++;
+	e.file = f;
+	if (e.key > m_newest) {
+		m_newest = e.key;
+	}
+
+	if (v.size() == m_head[t] || !(e.key < v[v.size() - 1].key)) {
+		v.push_back(e);
+	} else {
+		insert_at(v, upper_bound(t, e.key), e);
+	}
+	++m_num;
+}
+
+void LogIndex::remove_entry(int t, size_t i)
+{
+	LogVector<Entry>& v = m_files[t];
+
+	if (i == m_head[t]) {
+		++m_head[t];
+		if (m_head[t] == v.size()) {
+			v.clear();
+			m_head[t] = 0;
+		} else if (m_head[t] >= LOG_INDEX_MAX_HEAD &&
+			   m_head[t] >= v.size() - m_head[t]) {
+			remove_items(v, 0, m_head[t]);
+			m_head[t] = 0;
+		}
+	} else {
+		remove_items(v, i, 1);
+	}
+	--m_num;
+}
+
+int LogIndex::remove(LogFile* f)
+{
+	int t = f->type();
+	const LogFile::FileTime& ft = f->file_time();
+	const LogVector<Entry>& v = m_files[t];
+	size_t i;
+
+	if (ft.year) {
+		// Look through the entries of the same time
+		uint64_t key = time_key(ft);
+
+		i = upper_bound(t, key);
+		while (i > m_head[t] && key == v[i - 1].key) {
+			--i;
+			if (f == v[i].file) {
+				remove_entry(t, i);
+				return 0;
+			}
+		}
+	}
+
+	// The key of a file without time is not known
+	for (i = m_head[t]; i < v.size(); ++i) {
+		if (f == v[i].file) {
+			remove_entry(t, i);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+LogFile* LogIndex::oldest() const
+{
+	if (type_num(LogFile::LT_UNKNOWN)) {
+		return at(LogFile::LT_UNKNOWN, 0);
+	}
+
+	const Entry* first = 0;
+
+	for (int t = LogFile::LT_UNKNOWN + 1; t < LogFile::LT_TYPE_NUM; ++t) {
+		if (LogFile::LT_VERSION == t || m_head[t] == m_files[t].size()) {
+			continue;
+		}
+		const Entry& e = m_files[t][m_head[t]];
+		if (!first || e.key < first->key ||
+		    (e.key == first->key && e.seq < first->seq)) {
+			first = &e;
+		}
+	}
+	if (first) {
+		return first->file;
+	}
+
+	if (type_num(LogFile::LT_VERSION)) {
+		return at(LogFile::LT_VERSION, 0);
+	}
+
+	return 0;
+}
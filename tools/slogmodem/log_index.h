@@ -0,0 +1,103 @@
+/*
+ *  log_index.h - ordered index of the files in a CP directory.
+ *
+ *  Copyright (C) 2015 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-19
+ *  Initial version.
+ */
+#ifndef _LOG_INDEX_H_
+#define _LOG_INDEX_H_
+
+#include "cp_log_cmn.h"
+#include "log_file.h"
+
+/*  LogIndex - the files of a CP directory in trimming order.
+ *
+ *  The trimming order is: files of unknown type first, then the
+ *  other files from the oldest to the newest, version files last.
+ *
+ *  Each type has its own vector sorted by file time, so the number of
+ *  files of a type is known at once, a file is found by binary search
+ *  and the oldest file is the smallest of the vector heads. New files
+ *  are usually the newest ones and are appended. Removing the oldest
+ *  file only moves the head of its vector.
+ */
+class LogIndex
+{
+public:
+	LogIndex();
+
+	bool empty() const
+	{
+		return !m_num;
+	}
+
+	size_t num() const
+	{
+		return m_num;
+	}
+
+	size_t type_num(LogFile::LogType t) const
+	{
+		return m_files[t].size() - m_head[t];
+	}
+
+	/*  at - get the i-th oldest file of the type.
+	 *  @t: the file type.
+	 *  @i: the index, shall be less than type_num(t).
+	 */
+	LogFile* at(LogFile::LogType t, size_t i) const
+	{
+		return m_files[t][m_head[t] + i].file;
+	}
+
+	/*  add - add the file into the index.
+	 *  @f: the file.
+	 *
+	 *  A file without time in its name is put after all files
+	 *  already in the index.
+	 */
+	void add(LogFile* f);
+
+	/*  remove - remove the file from the index. The file is not
+	 *           deleted.
+	 *  @f: the file.
+	 *
+	 *  Return 0 on success, -1 if f is not in the index.
+	 */
+	int remove(LogFile* f);
+
+	/*  oldest - get the first file in the trimming order.
+	 *
+	 *  Return the LogFile pointer, 0 if the index is empty.
+	 */
+	LogFile* oldest() const;
+
+private:
+	struct Entry
+	{
+		// Sort key from the file time
+		uint64_t key;
+		// Adding order, for files with the same time
+		uint32_t seq;
+		LogFile* file;
+	};
+
+	LogVector<Entry> m_files[LogFile::LT_TYPE_NUM];
+	// Number of removed entries at the beginning of m_files[]
+	size_t m_head[LogFile::LT_TYPE_NUM];
+	size_t m_num;
+	uint32_t m_seq;
+	// Largest key in the index
+	uint64_t m_newest;
+
+	size_t upper_bound(int t, uint64_t key) const;
+	void remove_entry(int t, size_t i);
+
+	static uint64_t time_key(const LogFile::FileTime& ft);
+};
+
+#endif  // !_LOG_INDEX_H_
+
@@ -12,6 +12,7 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include "cp_dir.h"
 #include "cp_set_dir.h"
 #include "def_config.h"
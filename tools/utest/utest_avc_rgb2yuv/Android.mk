@@ -0,0 +1,11 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_avc_rgb2yuv
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libstagefrighthw/include
+LOCAL_SRC_FILES:= utest_avc_rgb2yuv.cpp \
+	../../../libs/libstagefrighthw/SprdWorkerPool.cpp
+LOCAL_STATIC_LIBRARIES:= libutils libcutils liblog
+LOCAL_LDLIBS:= -lrt -lpthread
+include $(BUILD_HOST_EXECUTABLE)
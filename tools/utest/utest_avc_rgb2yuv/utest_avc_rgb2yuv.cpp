@@ -0,0 +1,410 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "SprdWorkerPool.h"
+
+using namespace android;
+
+/* CONVERT_MAX_THREAD_NUM and CONVERT_MAX_ION_NUM of SPRDAVCEncoder.h */
+#define BANDS           2
+#define SLOTS           4
+
+/* the input buffers the source may hold in the encoder, nBufferCountMin */
+#define INPUT_BUFFERS   4
+
+#define FRAMES          120
+#define SOURCES         4
+#define PACED_FPS       30
+
+/* the stub encoder sleeps as the hardware encoder keeps the cpu free */
+#define ENCODE_MB_PER_MS    300
+
+#define ALIGN16(x)      (((x) + 15) & ~15)
+
+enum {
+    MODE_SERIAL,
+    MODE_SERIAL_POOL,
+    MODE_PIPELINED,
+    MODE_NUM,
+};
+
+static const char *s_modeNames[MODE_NUM] = {
+    "serial        ",
+    "serial pool   ",
+    "pipelined pool",
+};
+
+struct frame_times {
+    int64_t received;
+    int64_t start;
+    int64_t converted;
+    int64_t encodeStart;
+    int64_t encodeEnd;
+};
+
+struct bench {
+    int width;
+    int height;
+    int mode;
+    int paced;
+    SprdWorkerPool *pool;
+
+    uint8_t *rgb[SOURCES];
+    uint8_t *ref[SOURCES];
+    uint8_t *slots;
+    size_t yuvSize;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int received;       /* frames handed to the encoder */
+    int converted;      /* frames converted into a slot */
+    int encoded;        /* frames encoded, their buffer returned */
+    int slotsInUse;
+
+    struct frame_times times[FRAMES];
+    int errors;
+};
+
+struct band_job {
+    const uint8_t *rgb;
+    uint8_t *py;
+    uint8_t *puv;
+    int width;
+    int height;
+    int widthDst;
+};
+
+static int s_failed;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t)
+{
+    struct timespec ts;
+
+    ts.tv_sec = t / 1000000000LL;
+    ts.tv_nsec = t % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        ;
+}
+
+/* ConvertARGB888ToYVU420SemiPlanar() of SPRDAVCEncoder.cpp, rows of the source */
+static void convert_rows(const uint8_t *rgb, uint8_t *py, uint8_t *puv, int width, int rows, int widthDst)
+{
+    for (int y = 0; y < rows; y++) {
+        const uint8_t *p = rgb + (size_t)y * width * 4;
+        uint8_t *yp = py + (size_t)y * widthDst;
+        uint8_t *vu = puv + (size_t)(y / 2) * widthDst;
+
+        for (int x = 0; x < width; x++, p += 4) {
+            int r = p[0], g = p[1], b = p[2];
+
+            yp[x] = ((66 * r + 129 * g + 25 * b) >> 8) + 16;
+            if (!(y & 1) && !(x & 1)) {
+                vu[x] = ((112 * r - 94 * g - 18 * b) >> 8) + 128;
+                vu[x + 1] = ((-38 * r - 74 * g + 112 * b) >> 8) + 128;
+            }
+        }
+    }
+}
+
+/* ConvertARGB888ToYVU420SemiPlanarBand() of SPRDAVCEncoder.cpp */
+static void convert_band(void *job, int band, int bands)
+{
+    struct band_job *j = (struct band_job *)job;
+    int rows = (j->height + bands * 2 - 1) / (bands * 2) * 2;
+    int y = rows * band;
+
+    if (y >= j->height)
+        return;
+
+    if (rows > j->height - y)
+        rows = j->height - y;
+
+    convert_rows(j->rgb + (size_t)y * j->width * 4, j->py + (size_t)y * j->widthDst,
+                 j->puv + (size_t)(y / 2) * j->widthDst, j->width, rows, j->widthDst);
+}
+
+static void convert(struct bench *b, int frame, int slot)
+{
+    struct band_job job;
+
+    job.rgb = b->rgb[frame % SOURCES];
+    job.py = b->slots + slot * b->yuvSize;
+    job.puv = job.py + ALIGN16(b->width) * ALIGN16(b->height);
+    job.width = b->width;
+    job.height = b->height;
+    job.widthDst = ALIGN16(b->width);
+
+    if (b->mode == MODE_SERIAL) {
+        convert_band(&job, 0, 1);
+    } else {
+        b->pool->fork(convert_band, &job);
+        b->pool->join();
+    }
+}
+
+/* the stub encoder: the slot must still hold the frame, then the hardware time */
+static void encode(struct bench *b, int frame, int slot)
+{
+    int mbs = ALIGN16(b->width) / 16 * (ALIGN16(b->height) / 16);
+
+    if (memcmp(b->slots + slot * b->yuvSize, b->ref[frame % SOURCES], b->yuvSize) != 0)
+        b->errors++;
+
+    sleep_until(now_ns() + (int64_t)mbs * 1000000 / ENCODE_MB_PER_MS);
+}
+
+static void encode_frame(struct bench *b, int frame, int slot)
+{
+    b->times[frame].encodeStart = now_ns();
+    encode(b, frame, slot);
+    b->times[frame].encodeEnd = now_ns();
+
+    pthread_mutex_lock(&b->lock);
+    b->encoded++;
+    b->slotsInUse--;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+}
+
+/*
+ *  The convert looper: frames in order of emptyThisBuffer, into the
+ *  next slot once one is free. Serial, it encodes the frame as well,
+ *  as onQueueFilled() did after the conversion.
+ * */
+static void *convert_thread(void *arg)
+{
+    struct bench *b = (struct bench *)arg;
+
+    for (int i = 0; i < FRAMES; i++) {
+        pthread_mutex_lock(&b->lock);
+        while (b->received <= i || b->slotsInUse == SLOTS)
+            pthread_cond_wait(&b->cond, &b->lock);
+        b->slotsInUse++;
+        pthread_mutex_unlock(&b->lock);
+
+        b->times[i].start = now_ns();
+        convert(b, i, i % SLOTS);
+        b->times[i].converted = now_ns();
+
+        if (b->mode != MODE_PIPELINED) {
+            encode_frame(b, i, i % SLOTS);
+            continue;
+        }
+
+        pthread_mutex_lock(&b->lock);
+        b->converted++;
+        pthread_cond_broadcast(&b->cond);
+        pthread_mutex_unlock(&b->lock);
+    }
+
+    return NULL;
+}
+
+/* onQueueFilled(): the converted frames in order, through the encoder */
+static void *encode_thread(void *arg)
+{
+    struct bench *b = (struct bench *)arg;
+
+    for (int i = 0; i < FRAMES; i++) {
+        pthread_mutex_lock(&b->lock);
+        while (b->converted <= i)
+            pthread_cond_wait(&b->cond, &b->lock);
+        pthread_mutex_unlock(&b->lock);
+
+        encode_frame(b, i, i % SLOTS);
+    }
+
+    return NULL;
+}
+
+/* the source: a frame as soon as an input buffer is back, or at PACED_FPS */
+static void source(struct bench *b)
+{
+    int64_t t0 = now_ns();
+
+    for (int i = 0; i < FRAMES; i++) {
+        if (b->paced)
+            sleep_until(t0 + (int64_t)i * 1000000000LL / PACED_FPS);
+
+        pthread_mutex_lock(&b->lock);
+        while (b->received - b->encoded == INPUT_BUFFERS)
+            pthread_cond_wait(&b->cond, &b->lock);
+        b->times[i].received = now_ns();
+        b->received++;
+        pthread_cond_broadcast(&b->cond);
+        pthread_mutex_unlock(&b->lock);
+    }
+}
+
+struct result {
+    double fps;
+    double latency;
+    double latencyP99;
+    double convert;
+    double queued;
+    double encode;
+};
+
+static int cmp_double(const void *a, const void *b)
+{
+    double d = *(const double *)a - *(const double *)b;
+
+    return (d > 0) - (d < 0);
+}
+
+static void run(struct bench *b, int paced, struct result *r)
+{
+    pthread_t convertTid, encodeTid;
+    double latencies[FRAMES];
+
+    b->paced = paced;
+    b->received = b->converted = b->encoded = b->slotsInUse = 0;
+    memset(b->times, 0, sizeof(b->times));
+    memset(b->slots, 0, SLOTS * b->yuvSize);
+
+    pthread_create(&convertTid, NULL, convert_thread, b);
+    if (b->mode == MODE_PIPELINED)
+        pthread_create(&encodeTid, NULL, encode_thread, b);
+
+    source(b);
+
+    pthread_join(convertTid, NULL);
+    if (b->mode == MODE_PIPELINED)
+        pthread_join(encodeTid, NULL);
+
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < FRAMES; i++) {
+        struct frame_times *t = &b->times[i];
+
+        latencies[i] = (t->encodeEnd - t->received) / 1e6;
+        r->latency += latencies[i] / FRAMES;
+        r->convert += (t->converted - t->start) / 1e6 / FRAMES;
+        r->queued += (t->encodeStart - t->converted) / 1e6 / FRAMES;
+        r->encode += (t->encodeEnd - t->encodeStart) / 1e6 / FRAMES;
+    }
+    qsort(latencies, FRAMES, sizeof(double), cmp_double);
+    r->latencyP99 = latencies[FRAMES * 99 / 100];
+    r->fps = (FRAMES - 1) * 1e9 / (b->times[FRAMES - 1].encodeEnd - b->times[0].encodeEnd);
+}
+
+static void test_size(SprdWorkerPool *pool, int width, int height)
+{
+    struct bench b;
+    struct result unpaced[MODE_NUM], paced[MODE_NUM];
+
+    memset(&b, 0, sizeof(b));
+    b.width = width;
+    b.height = height;
+    b.pool = pool;
+    b.yuvSize = ALIGN16(width) * ALIGN16(height) * 3 / 2;
+    b.slots = (uint8_t *)malloc(SLOTS * b.yuvSize);
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.cond, NULL);
+
+    for (int s = 0; s < SOURCES; s++) {
+        b.rgb[s] = (uint8_t *)malloc((size_t)width * height * 4);
+        for (size_t k = 0; k < (size_t)width * height * 4; k++)
+            b.rgb[s][k] = rand() & 0xff;
+
+        b.ref[s] = (uint8_t *)calloc(1, b.yuvSize);
+        convert_rows(b.rgb[s], b.ref[s], b.ref[s] + ALIGN16(width) * ALIGN16(height), width, height, ALIGN16(width));
+    }
+
+    printf("%dx%d, %d frames, encode %.1f ms\n", width, height, FRAMES,
+           ALIGN16(width) / 16 * (ALIGN16(height) / 16) / (double)ENCODE_MB_PER_MS);
+
+    for (int m = 0; m < MODE_NUM; m++) {
+        b.mode = m;
+        run(&b, 0, &unpaced[m]);
+        run(&b, 1, &paced[m]);
+
+        printf("  %s %6.1f fps, at %d fps latency mean %5.1f ms p99 %5.1f ms, convert %5.1f ms, queued %5.1f ms, encode %5.1f ms\n",
+               s_modeNames[m], unpaced[m].fps, PACED_FPS, paced[m].latency, paced[m].latencyP99,
+               paced[m].convert, paced[m].queued, paced[m].encode);
+    }
+
+    if (b.errors) {
+        printf("  %d frames overwritten before they were encoded\n", b.errors);
+        s_failed = 1;
+    }
+
+    /* the conversion is hidden behind the encode, but for scheduling noise */
+    if (unpaced[MODE_PIPELINED].fps < unpaced[MODE_SERIAL_POOL].fps * 0.9) {
+        printf("  pipelined slower than serial\n");
+        s_failed = 1;
+    }
+
+    for (int s = 0; s < SOURCES; s++) {
+        free(b.rgb[s]);
+        free(b.ref[s]);
+    }
+    free(b.slots);
+}
+
+/* every band of a fork runs once, and join waits for the slowest */
+static int s_bandRuns[BANDS];
+
+static void count_band(void *job, int band, int bands)
+{
+    if (band == bands - 1)
+        sleep_until(now_ns() + 2000000);
+    __sync_fetch_and_add(&s_bandRuns[band], 1);
+    __sync_fetch_and_add((int *)job, 1);
+}
+
+static void test_fork_join(SprdWorkerPool *pool)
+{
+    int forks = 500;
+    int errors = 0;
+
+    for (int i = 0; i < forks; i++) {
+        int done = 0;
+
+        pool->fork(count_band, &done);
+        pool->join();
+        if (done != pool->bands())
+            errors++;
+    }
+
+    for (int i = 0; i < pool->bands(); i++) {
+        if (s_bandRuns[i] != forks)
+            errors++;
+    }
+
+    printf("fork/join: %d forks of %d bands, errors %d\n", forks, pool->bands(), errors);
+    if (errors)
+        s_failed = 1;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    SprdWorkerPool *pool = new SprdWorkerPool("rgb2yuv", BANDS, 0);
+
+    srand(seed);
+    printf("utest_avc_rgb2yuv -- %d bands, %d slots, %d input buffers, %ld cpus, seed %u\n",
+           pool->bands(), SLOTS, INPUT_BUFFERS, sysconf(_SC_NPROCESSORS_ONLN), seed);
+
+    test_fork_join(pool);
+    test_size(pool, 1280, 720);
+    test_size(pool, 1920, 1080);
+
+    delete pool;
+
+    printf("%s\n", s_failed ? "FAIL" : "OK");
+
+    return s_failed;
+}
@@ -0,0 +1,19 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_cap_mem
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS:= -include stdint.h -include semaphore.h
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/oem/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/oem/isp_calibration/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/common/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/isp1.0/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/jpeg/jpeg_fw_8830/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/vsp/sc8830/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/mtrace \
+	$(TARGET_OUT_INTERMEDIATES)/KERNEL/source/include/video
+LOCAL_SRC_FILES:= utest_cap_mem.c \
+	../../../libs/libcamera/oem/src/cmr_mem.c \
+	../../../libs/libcamera/oem/src/cmr_mem_plan.c
+LOCAL_STATIC_LIBRARIES:= libcutils liblog
+include $(BUILD_HOST_EXECUTABLE)
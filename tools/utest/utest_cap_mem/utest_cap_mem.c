@@ -0,0 +1,405 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmr_mem.h"
+#include "cmr_mem_plan.h"
+#include "sensor_drv_u.h"
+
+#define ALIGN256(x)     (((x) + 255) & ~255u)
+#define RANDOM_SETS     2000
+#define CAMERA_ID       0
+#define BASE_PHY        0x80000000UL
+#define BASE_VIR        0x40000000UL
+#define BASE_MOVE       0x01234500UL
+#define ALLOC_PHY       0xc0000000u
+#define FRAME_NUM       10
+
+static const struct {
+	cmr_u32         orig_fmt;
+	cmr_u32         sn_fmt;
+	const char      *name;
+} fmt_tab[] = {
+	{IMG_DATA_TYPE_RAW, SENSOR_IMAGE_FORMAT_RAW, "raw"},
+	{IMG_DATA_TYPE_YUV422, SENSOR_IMAGE_FORMAT_YUV422, "yuv"},
+	{IMG_DATA_TYPE_JPEG, SENSOR_IMAGE_FORMAT_JPEG, "jpeg"},
+};
+
+static const cmr_u32 sensor_size[][2] = {
+	{640, 480},
+	{1280, 960},
+	{1600, 1200},
+	{2048, 1536},
+	{2592, 1944},
+	{3264, 2448},
+	{4208, 3120},
+};
+
+static const cmr_u32 thum_size[][2] = {
+	{0, 0},
+	{160, 120},
+	{320, 240},
+	{640, 480},
+};
+
+struct range {
+	const char      *name;
+	cmr_uint        start;
+	cmr_u32         size;
+};
+
+static int alloc_cnt;
+
+/* only the legacy layout allocates, out of the frame memory */
+static int test_alloc_mem(void *handle, unsigned int size, unsigned int *addr_phy,
+			unsigned int *addr_vir)
+{
+	(void)handle; (void)size;
+	*addr_phy = ALLOC_PHY;
+	*addr_vir = ALLOC_PHY;
+	alloc_cnt++;
+	return 0;
+}
+
+static int overlap(cmr_uint a_off, cmr_u32 a_size, cmr_uint b_off, cmr_u32 b_size)
+{
+	return a_size && b_size && a_off < b_off + b_size && b_off < a_off + a_size;
+}
+
+static void frame_list(struct cmr_cap_mem *mem, struct img_frm **frm)
+{
+	frm[0] = &mem->cap_raw;
+	frm[1] = &mem->cap_yuv;
+	frm[2] = &mem->target_yuv;
+	frm[3] = &mem->target_jpeg;
+	frm[4] = &mem->thum_yuv;
+	frm[5] = &mem->thum_jpeg;
+	frm[6] = &mem->jpeg_tmp;
+	frm[7] = &mem->scale_tmp;
+	frm[8] = &mem->cap_yuv_rot;
+	frm[9] = &mem->isp_tmp;
+}
+
+/* every address at the same offset from its base, physical and virtual alike */
+static int same_offsets(struct cmr_cap_mem *a, cmr_uint a_phy, cmr_uint a_vir,
+			struct cmr_cap_mem *b, cmr_uint b_phy, cmr_uint b_vir)
+{
+	struct img_frm *fa[FRAME_NUM], *fb[FRAME_NUM];
+	cmr_uint *pa, *pb, *va, *vb;
+	cmr_u32 i, j;
+
+	frame_list(a, fa);
+	frame_list(b, fb);
+	for (i = 0; i < FRAME_NUM; i++) {
+		if (fa[i]->buf_size != fb[i]->buf_size)
+			return 0;
+		pa = &fa[i]->addr_phy.addr_y;
+		pb = &fb[i]->addr_phy.addr_y;
+		va = &fa[i]->addr_vir.addr_y;
+		vb = &fb[i]->addr_vir.addr_y;
+		for (j = 0; j < 3; j++) {
+			if (!pa[j] != !va[j] || !pa[j] != !pb[j] || !pa[j] != !vb[j])
+				return 0;
+			if (pa[j] && (pa[j] - a_phy != va[j] - a_vir || pa[j] - a_phy != pb[j] - b_phy
+					|| pa[j] - a_phy != vb[j] - b_vir))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static int arrange(struct cmr_cap_mem *mem, cmr_u32 fmt, cmr_u32 w, cmr_u32 h,
+			cmr_u32 tw, cmr_u32 th, cmr_u32 rot, cmr_uint base_phy,
+			cmr_uint base_vir, cmr_u32 mem_size, cmr_u32 planned)
+{
+	struct cmr_cap_2_frm cap_2_frm;
+	struct img_size sn_size, thum;
+	struct img_rect sn_trim;
+
+	memset(&cap_2_frm, 0, sizeof(cap_2_frm));
+	cap_2_frm.mem_frm.addr_phy.addr_y = base_phy;
+	cap_2_frm.mem_frm.addr_vir.addr_y = base_vir;
+	cap_2_frm.mem_frm.buf_size = mem_size;
+	cap_2_frm.alloc_mem = test_alloc_mem;
+
+	/* full sensor frame, no trim, no scaling */
+	sn_size.width = w;
+	sn_size.height = h;
+	memset(&sn_trim, 0, sizeof(sn_trim));
+	sn_trim.width = w;
+	sn_trim.height = h;
+	thum.width = tw;
+	thum.height = th;
+
+	if (planned)
+		return arrange_planned_buf(&cap_2_frm, &sn_size, &sn_trim, &sn_size,
+					fmt_tab[fmt].orig_fmt, &sn_size, &thum, mem, rot);
+
+	return camera_arrange_capture_buf(&cap_2_frm, &sn_size, &sn_trim, &sn_size,
+					fmt_tab[fmt].orig_fmt, &sn_size, &thum, mem, rot, 1);
+}
+
+static void add_range(struct range *rg, cmr_u32 *n, const char *name, cmr_uint start,
+			cmr_u32 size)
+{
+	if (!size)
+		return;
+	rg[*n].name = name;
+	rg[*n].start = start;
+	rg[*n].size = size;
+	(*n)++;
+}
+
+static int check_capture(cmr_u32 fmt, cmr_u32 w, cmr_u32 h, cmr_u32 tw, cmr_u32 th,
+			cmr_u32 rot, cmr_u32 mem_size, cmr_u32 *used)
+{
+	struct cmr_cap_mem cap, plan, expect, moved, small;
+	struct range main_rg[5], other[4];
+	cmr_u32 jpeg_size, n_main = 0, n_other = 0;
+	int ret;
+	cmr_uint end = BASE_PHY, jpeg_tmp;
+	cmr_u32 i, j;
+
+	/* what the capture gets, the exif header is taken off the jpeg once arranged */
+	alloc_cnt = 0;
+	ret = arrange(&cap, fmt, w, h, tw, th, rot, BASE_PHY, BASE_VIR, mem_size, 0);
+	jpeg_size = cap.target_jpeg.buf_size + (ret ? 0 : JPEG_EXIF_SIZE);
+
+	/* the planned layout, or the legacy one, if any, when it does not fit */
+	memset(&plan, 0x5a, sizeof(plan));
+	plan.target_jpeg.buf_size = jpeg_size;
+	memcpy(&small, &plan, sizeof(small));
+	if (arrange(&plan, fmt, w, h, tw, th, rot, BASE_PHY, BASE_VIR, mem_size, 1)) {
+		if (memcmp(&plan, &small, sizeof(plan))) {
+			printf("capture_mem changed by a plan that does not fit\n");
+			return -1;
+		}
+		*used = 0;
+		return 1;
+	}
+	if (ret) {
+		printf("arrange failed\n");
+		return -1;
+	}
+	if (alloc_cnt) {
+		printf("%d buffers allocated\n", alloc_cnt);
+		return -1;
+	}
+
+	/* the capture uses it as is */
+	memcpy(&expect, &plan, sizeof(expect));
+	expect.target_jpeg.addr_phy.addr_y += JPEG_EXIF_SIZE;
+	expect.target_jpeg.addr_vir.addr_y += JPEG_EXIF_SIZE;
+	expect.target_jpeg.buf_size -= JPEG_EXIF_SIZE;
+	if (memcmp(&expect, &cap, sizeof(cap))) {
+		printf("capture not arranged as planned\n");
+		return -1;
+	}
+
+	/* same offsets at any base, physical and virtual in step */
+	memset(&moved, 0, sizeof(moved));
+	moved.target_jpeg.buf_size = jpeg_size;
+	if (arrange(&moved, fmt, w, h, tw, th, rot, BASE_PHY + BASE_MOVE, BASE_VIR - BASE_MOVE,
+			mem_size, 1)
+		|| !same_offsets(&plan, BASE_PHY, BASE_VIR, &moved, BASE_PHY + BASE_MOVE,
+				BASE_VIR - BASE_MOVE)) {
+		printf("layout moves with the base\n");
+		return -1;
+	}
+
+	/* the main block overlaps on purpose, nothing else may overlap it */
+	add_range(main_rg, &n_main, "cap raw", plan.cap_raw.addr_phy.addr_y, plan.cap_raw.buf_size);
+	add_range(main_rg, &n_main, "cap yuv y", plan.cap_yuv.addr_phy.addr_y,
+		plan.cap_yuv.size.width * plan.cap_yuv.size.height);
+	add_range(main_rg, &n_main, "cap yuv uv", plan.cap_yuv.addr_phy.addr_u,
+		plan.cap_yuv.size.width * plan.cap_yuv.size.height / 2);
+	add_range(main_rg, &n_main, "target yuv y", plan.target_yuv.addr_phy.addr_y,
+		plan.target_yuv.buf_size * 2 / 3);
+	add_range(main_rg, &n_main, "target yuv uv", plan.target_yuv.addr_phy.addr_u,
+		plan.target_yuv.buf_size / 3);
+	add_range(other, &n_other, "target jpeg", plan.target_jpeg.addr_phy.addr_y,
+		plan.target_jpeg.buf_size);
+	add_range(other, &n_other, "thumbnail yuv", plan.thum_yuv.addr_phy.addr_y,
+		plan.thum_yuv.buf_size);
+	add_range(other, &n_other, "thumbnail jpeg", plan.thum_jpeg.addr_phy.addr_y,
+		plan.thum_jpeg.buf_size);
+	add_range(other, &n_other, "rotation", plan.cap_yuv_rot.addr_phy.addr_y,
+		plan.cap_yuv_rot.buf_size);
+	if (!!rot != !!plan.cap_yuv_rot.buf_size) {
+		printf("rotation buffer size 0x%x\n", plan.cap_yuv_rot.buf_size);
+		return -1;
+	}
+
+	for (i = 0; i < n_main + n_other; i++) {
+		struct range *a = i < n_main ? &main_rg[i] : &other[i - n_main];
+
+		if (a->start < BASE_PHY || a->start + a->size > BASE_PHY + mem_size) {
+			printf("%s out of the frame memory\n", a->name);
+			return -1;
+		}
+		if (a->start + a->size > end)
+			end = a->start + a->size;
+	}
+	for (i = 0; i < n_other; i++) {
+		for (j = 0; j < n_main; j++) {
+			if (overlap(other[i].start, other[i].size, main_rg[j].start, main_rg[j].size)) {
+				printf("%s overlaps %s\n", other[i].name, main_rg[j].name);
+				return -1;
+			}
+		}
+		/* only the rotation buffer shares memory, done before the jpeg and thumbnails */
+		for (j = i + 1; j < n_other; j++) {
+			if (plan.cap_yuv_rot.buf_size && other[j].start == plan.cap_yuv_rot.addr_phy.addr_y
+				&& other[j].size == plan.cap_yuv_rot.buf_size)
+				continue;
+			if (overlap(other[i].start, other[i].size, other[j].start, other[j].size)) {
+				printf("%s overlaps %s\n", other[i].name, other[j].name);
+				return -1;
+			}
+		}
+	}
+	jpeg_tmp = rot ? plan.cap_yuv_rot.addr_phy.addr_u : plan.cap_yuv.addr_phy.addr_u;
+	if (plan.jpeg_tmp.addr_phy.addr_y != jpeg_tmp) {
+		printf("jpeg tmp at 0x%lx, not the uv plane at 0x%lx\n",
+			(unsigned long)plan.jpeg_tmp.addr_phy.addr_y, (unsigned long)jpeg_tmp);
+		return -1;
+	}
+
+	/*
+	 * the memory used, up to the 256 bytes the main block is padded to, is
+	 * enough, a byte less is not and leaves capture_mem alone
+	 */
+	*used = (cmr_u32)(end - BASE_PHY);
+	memset(&moved, 0, sizeof(moved));
+	moved.target_jpeg.buf_size = jpeg_size;
+	memset(&small, 0x5a, sizeof(small));
+	small.target_jpeg.buf_size = jpeg_size;
+	memcpy(&expect, &small, sizeof(expect));
+	if (arrange(&moved, fmt, w, h, tw, th, rot, BASE_PHY, BASE_VIR, ALIGN256(*used), 1)
+		|| memcmp(&moved, &plan, sizeof(plan))
+		|| !arrange(&small, fmt, w, h, tw, th, rot, BASE_PHY, BASE_VIR, *used - 1, 1)
+		|| memcmp(&small, &expect, sizeof(small))) {
+		printf("wrong fit at 0x%x\n", *used);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int check_random(void)
+{
+	struct cmr_mem_plan_buf buf[CMR_MEM_PLAN_MAX];
+	cmr_u32 fixed_off[CMR_MEM_PLAN_MAX];
+	cmr_u32 n, i, j, k, size, live, seq, bound;
+
+	srand(1);
+	for (k = 0; k < RANDOM_SETS; k++) {
+		n = 1 + rand() % CMR_MEM_PLAN_MAX;
+		for (i = 0; i < n; i++) {
+			buf[i].size = rand() % 8 ? 1 + rand() % 0x100000 : 0;
+			buf[i].align = 1u << (rand() % 13);
+			buf[i].first = rand() % 6;
+			buf[i].last = buf[i].first + rand() % (6 - buf[i].first);
+			buf[i].fixed = (0 == i && rand() % 2);
+			buf[i].offset = buf[i].fixed ? ALIGN256(rand() % 0x10000) : 0xdeadbeef;
+			fixed_off[i] = buf[i].offset;
+		}
+		if (cmr_mem_plan_layout(buf, n, &size))
+			return -1;
+
+		seq = 0;
+		for (i = 0; i < n; i++) {
+			if (!buf[i].size)
+				continue;
+			if (buf[i].fixed ? buf[i].offset != fixed_off[i]
+					: buf[i].offset & (buf[i].align - 1)) {
+				printf("set %d: buffer %d misplaced at 0x%x\n", k, i, buf[i].offset);
+				return -1;
+			}
+			if (buf[i].offset + buf[i].size > size) {
+				printf("set %d: buffer %d out of 0x%x\n", k, i, size);
+				return -1;
+			}
+			seq += buf[i].size + buf[i].align - 1;
+			for (j = i + 1; j < n; j++) {
+				if (buf[i].first <= buf[j].last && buf[j].first <= buf[i].last
+					&& overlap(buf[i].offset, buf[i].size, buf[j].offset, buf[j].size)) {
+					printf("set %d: buffers %d and %d overlap\n", k, i, j);
+					return -1;
+				}
+			}
+		}
+
+		/* never less than what is live at once, never more than all of it */
+		bound = 0;
+		for (j = 0; j < 6; j++) {
+			live = 0;
+			for (i = 0; i < n; i++) {
+				if (buf[i].first <= j && j <= buf[i].last)
+					live += buf[i].size;
+			}
+			if (live > bound)
+				bound = live;
+		}
+		if (size < bound || size > seq + (buf[0].fixed ? fixed_off[0] : 0)) {
+			printf("set %d: size 0x%x, live 0x%x, sequential 0x%x\n", k, size, bound, seq);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(void)
+{
+	cmr_u32 s, t, fmt, rot, used, max_used, mem_size, unplanned;
+	int ret;
+	struct img_size image_size;
+	cmr_u32 cases = 0;
+
+	printf("utest_cap_mem -- %d sensor sizes, %d thumbnails, raw/yuv/jpeg, rotation on/off\n",
+		(int)(sizeof(sensor_size) / sizeof(sensor_size[0])),
+		(int)(sizeof(thum_size) / sizeof(thum_size[0])));
+
+	for (s = 0; s < sizeof(sensor_size) / sizeof(sensor_size[0]); s++) {
+		for (fmt = 0; fmt < sizeof(fmt_tab) / sizeof(fmt_tab[0]); fmt++) {
+			image_size.width = sensor_size[s][0];
+			image_size.height = sensor_size[s][1];
+			if (camera_capture_buf_size(CAMERA_ID, fmt_tab[fmt].sn_fmt, &image_size, &mem_size)) {
+				printf("%dx%d %s: no frame memory\n",
+					sensor_size[s][0], sensor_size[s][1], fmt_tab[fmt].name);
+				continue;
+			}
+			max_used = 0;
+			unplanned = 0;
+			for (rot = 0; rot < 2; rot++) {
+				for (t = 0; t < sizeof(thum_size) / sizeof(thum_size[0]); t++) {
+					ret = check_capture(fmt, sensor_size[s][0], sensor_size[s][1],
+							thum_size[t][0], thum_size[t][1], rot, mem_size, &used);
+					if (ret < 0) {
+						printf("%dx%d %s rot %d thumbnail %dx%d: FAIL\n",
+							sensor_size[s][0], sensor_size[s][1], fmt_tab[fmt].name,
+							rot, thum_size[t][0], thum_size[t][1]);
+						return 1;
+					}
+					if (used > max_used)
+						max_used = used;
+					unplanned += ret;
+					cases++;
+				}
+			}
+			printf("%dx%d %s: up to %u of %u bytes used, %u not planned\n",
+				sensor_size[s][0], sensor_size[s][1], fmt_tab[fmt].name,
+				max_used, mem_size, unplanned);
+		}
+	}
+
+	if (check_random()) {
+		printf("random layouts: FAIL\n");
+		return 1;
+	}
+	printf("%u captures, %d random layouts\n", cases, RANDOM_SETS);
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "SprdBandwidthGovernor.h"
+
+using namespace android;
+
+#define KHZ_200         200000u
+#define KHZ_300         300000u
+#define KHZ_400         400000u
+#define KHZ_500         500000u
+
+static char s_node[64];
+
+/*
+ *  A fresh stand-in for the dmcfreq node.
+ * */
+static void new_node(void)
+{
+    FILE *fp = fopen(s_node, "w");
+
+    if (fp != NULL)
+        fclose(fp);
+}
+
+/*
+ *  Replays the requests written to the stand-in the way the driver
+ *  counts them: a frequency adds one, 0 removes one. Returns the number
+ *  of frequencies written, or -1 when more than one request was held at
+ *  a time, one was removed that wasn't held, or held is left.
+ * */
+static int check_node(int held)
+{
+    FILE *fp = fopen(s_node, "r");
+    unsigned khz;
+    int requests = 0, writes = 0;
+
+    if (fp == NULL)
+        return -1;
+
+    while (fscanf(fp, "%u", &khz) == 1) {
+        if (khz != 0) {
+            requests++;
+            writes++;
+        } else {
+            requests--;
+        }
+        if (requests < 0 || requests > 1) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+
+    return (requests == held) ? writes : -1;
+}
+
+/*
+ *  A session coding frames at fps. Every frame takes load percent of
+ *  the frame interval and has bytes of bitstream, and is reported in
+ *  slices. With bidir the frames come in decode order of I P B B.
+ * */
+struct stream {
+    int id;
+    int fps;
+    int load;
+    size_t bytes;
+    int slices;
+    bool bidir;
+    int frame;
+};
+
+static void play(SprdBandwidthGovernor *gov, struct stream *s, int frames)
+{
+    static const int reorder[3] = { 2, 0, 1 };
+    int64_t intervalUs = 1000000 / s->fps;
+
+    for (int i = 0; i < frames; i++, s->frame++) {
+        int n = s->frame;
+
+        if (s->bidir && n > 0)
+            n = (n - 1) / 3 * 3 + 1 + reorder[(n - 1) % 3];
+        for (int j = 0; j < s->slices; j++)
+            gov->onFrame(s->id, n * intervalUs,
+                         intervalUs * s->load / 100 / s->slices, s->bytes / s->slices);
+    }
+}
+
+static void open_stream(SprdBandwidthGovernor *gov, struct stream *s,
+                        SprdBandwidthGovernor::Kind kind, int width, int height,
+                        int fps, int load, size_t bytes, int slices, bool bidir)
+{
+    s->id = gov->open(kind);
+    gov->setFormat(s->id, width, height, bidir);
+    s->fps = fps;
+    s->load = load;
+    s->bytes = bytes;
+    s->slices = slices;
+    s->bidir = bidir;
+    s->frame = 0;
+}
+
+static int expect(const char *what, uint32_t khz, uint32_t want)
+{
+    printf("  %-40s %6u kHz\n", what, khz);
+    if (khz != want) {
+        printf("  expected %u kHz\n", want);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  A session at 30 fps with time to spare but not much gets what the
+ *  resolution ladders gave it: a decoder a step more with B-frames, an
+ *  encoder 200 MHz up to 720x480 and 300 MHz above.
+ * */
+static int test_ladder(void)
+{
+    static const struct {
+        SprdBandwidthGovernor::Kind kind;
+        int width, height;
+        bool bidir;
+        uint32_t khz;
+    } s_sizes[] = {
+        { SprdBandwidthGovernor::DECODER, 320, 240, false, KHZ_200 },
+        { SprdBandwidthGovernor::DECODER, 640, 480, false, KHZ_300 },
+        { SprdBandwidthGovernor::DECODER, 720, 576, false, KHZ_300 },
+        { SprdBandwidthGovernor::DECODER, 1280, 720, false, KHZ_400 },
+        { SprdBandwidthGovernor::DECODER, 1280, 720, true, KHZ_500 },
+        { SprdBandwidthGovernor::DECODER, 1920, 1088, false, KHZ_500 },
+        { SprdBandwidthGovernor::ENCODER, 320, 240, false, KHZ_200 },
+        { SprdBandwidthGovernor::ENCODER, 640, 480, false, KHZ_200 },
+        { SprdBandwidthGovernor::ENCODER, 720, 480, false, KHZ_200 },
+        { SprdBandwidthGovernor::ENCODER, 1280, 720, false, KHZ_300 },
+        { SprdBandwidthGovernor::ENCODER, 1920, 1088, false, KHZ_300 },
+    };
+    int errors = 0;
+
+    printf("ladder:\n");
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+        SprdBandwidthGovernor gov(s_node);
+        struct stream s;
+        char what[64];
+        bool encoder = (s_sizes[i].kind == SprdBandwidthGovernor::ENCODER);
+
+        new_node();
+        open_stream(&gov, &s, s_sizes[i].kind,
+                    s_sizes[i].width, s_sizes[i].height, 30, 50,
+                    s_sizes[i].width * s_sizes[i].height / 20, 1, s_sizes[i].bidir);
+        play(&gov, &s, 90);
+        snprintf(what, sizeof(what), "%s %dx%d%s", encoder ? "encoder" : "decoder",
+                 s_sizes[i].width, s_sizes[i].height, s_sizes[i].bidir ? " B-frames" : "");
+        errors += expect(what, gov.vote(), s_sizes[i].khz);
+        gov.close(s.id);
+        errors += expect("closed", gov.vote(), 0);
+        if (check_node(0) < 0)
+            errors++;
+    }
+
+    printf("ladder: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  Low bitrate 1080p decoded in a fifth of the frame interval steps
+ *  down, high bitrate 720p close to its deadline steps up without waiting.
+ * */
+static int test_load(void)
+{
+    int errors = 0;
+
+    printf("load:\n");
+    {
+        SprdBandwidthGovernor gov(s_node);
+        struct stream s;
+
+        new_node();
+        open_stream(&gov, &s, SprdBandwidthGovernor::DECODER,
+                    1920, 1088, 24, 20, 2000000 / 8 / 24, 1, false);
+        play(&gov, &s, 30);
+        errors += expect("1080p24 2 Mbps, 20% busy, 30 frames", gov.vote(), KHZ_500);
+        play(&gov, &s, 60);
+        errors += expect("1080p24 2 Mbps, 20% busy, 90 frames", gov.vote(), KHZ_400);
+        s.load = 60;
+        play(&gov, &s, 120);
+        errors += expect("1080p24 2 Mbps, 60% busy", gov.vote(), KHZ_400);
+        gov.close(s.id);
+        if (check_node(0) < 0)
+            errors++;
+    }
+    {
+        SprdBandwidthGovernor gov(s_node);
+        struct stream s;
+
+        new_node();
+        open_stream(&gov, &s, SprdBandwidthGovernor::DECODER,
+                    1280, 720, 30, 50, 40000000 / 8 / 30, 4, false);
+        play(&gov, &s, 30);
+        errors += expect("720p30 40 Mbps, 50% busy", gov.vote(), KHZ_400);
+        s.load = 90;
+        play(&gov, &s, 10);
+        errors += expect("720p30 40 Mbps, 90% busy, 10 frames", gov.vote(), KHZ_500);
+        s.load = 50;
+        play(&gov, &s, 120);
+        errors += expect("720p30 40 Mbps, 50% busy again", gov.vote(), KHZ_500);
+        gov.close(s.id);
+        if (check_node(0) < 0)
+            errors++;
+    }
+
+    printf("load: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  Sessions add up, a closed one is taken off at once.
+ * */
+static int test_sessions(void)
+{
+    SprdBandwidthGovernor gov(s_node);
+    struct stream a, b, c;
+    int errors = 0;
+
+    printf("sessions:\n");
+    new_node();
+
+    open_stream(&gov, &a, SprdBandwidthGovernor::DECODER, 1280, 720, 30, 50, 20000, 1, false);
+    play(&gov, &a, 30);
+    errors += expect("720p decoder", gov.vote(), KHZ_400);
+
+    open_stream(&gov, &b, SprdBandwidthGovernor::DECODER, 1280, 720, 30, 50, 20000, 1, false);
+    play(&gov, &a, 30);
+    play(&gov, &b, 30);
+    errors += expect("two 720p decoders", gov.vote(), KHZ_500);
+
+    gov.close(a.id);
+    errors += expect("one closed", gov.vote(), KHZ_400);
+
+    open_stream(&gov, &c, SprdBandwidthGovernor::ENCODER, 640, 480, 30, 50, 5000, 1, false);
+    play(&gov, &b, 60);
+    play(&gov, &c, 60);
+    errors += expect("720p decoder, VGA encoder", gov.vote(), KHZ_400);
+
+    gov.close(b.id);
+    play(&gov, &c, 60);
+    errors += expect("VGA encoder", gov.vote(), KHZ_200);
+
+    gov.close(c.id);
+    errors += expect("none", gov.vote(), 0);
+
+    if (check_node(0) < 0)
+        errors++;
+
+    printf("sessions: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  A load wandering around the middle doesn't move the vote, and the
+ *  node sees one request at a time.
+ * */
+static int test_hysteresis(void)
+{
+    SprdBandwidthGovernor gov(s_node);
+    struct stream s;
+    int errors = 0, writes;
+
+    printf("hysteresis:\n");
+    new_node();
+
+    open_stream(&gov, &s, SprdBandwidthGovernor::DECODER, 1280, 720, 30, 50, 20000, 1, false);
+    for (int i = 0; i < 300; i++) {
+        s.load = 35 + (i * 37) % 38;
+        play(&gov, &s, 1);
+    }
+    errors += expect("720p30, 35-72% busy, 300 frames", gov.vote(), KHZ_400);
+
+    writes = check_node(1);
+    printf("  %-40s %6d\n", "frequencies written", writes);
+    if (writes != 1)
+        errors++;
+
+    gov.close(s.id);
+    if (check_node(0) != 1)
+        errors++;
+
+    printf("hysteresis: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  Without the node there is no vote and nothing breaks.
+ * */
+static int test_no_node(void)
+{
+    SprdBandwidthGovernor gov("/nonexistent/set_freq");
+    struct stream s;
+    int errors = 0;
+
+    printf("no node:\n");
+    open_stream(&gov, &s, SprdBandwidthGovernor::DECODER, 1920, 1088, 30, 50, 20000, 1, false);
+    play(&gov, &s, 60);
+    errors += expect("1080p30", gov.vote(), 0);
+    gov.close(s.id);
+
+    printf("no node: errors %d\n", errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int errors = 0;
+
+    snprintf(s_node, sizeof(s_node), "/tmp/utest_ddr_governor.%d", (int)getpid());
+    printf("utest_ddr_governor -- node %s\n", s_node);
+
+    errors += test_ladder();
+    errors += test_load();
+    errors += test_sessions();
+    errors += test_hysteresis();
+    errors += test_no_node();
+
+    unlink(s_node);
+
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
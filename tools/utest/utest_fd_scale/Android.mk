@@ -0,0 +1,10 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_fd_scale
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/oem/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/mtrace
+LOCAL_SRC_FILES:= utest_fd_scale.c \
+	../../../libs/libcamera/oem/src/cmr_fd_scale.c
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmr_fd_scale.h"
+
+#define DEF_WIDTH       1920
+#define DEF_HEIGHT      1080
+#define FRAME_NUM       4
+#define LOOPS           100
+/* 30 fps preview, detector time for the pacing run */
+#define FRAME_TIME      33333333LL
+#define DETECT_TIME     45000000LL
+#define PACE_FRAMES     300
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* a moving gradient with some noise, NV21 */
+static void make_frame(cmr_u8 *frm, cmr_u32 w, cmr_u32 h, cmr_u32 n)
+{
+	cmr_u32 x, y;
+	cmr_u8 *uv = frm + w * h;
+
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++)
+			frm[y * w + x] = (cmr_u8)((x + y + n * 8) + (rand() & 15));
+	for (y = 0; y < h / 2; y++)
+		for (x = 0; x < w; x++)
+			uv[y * w + x] = (cmr_u8)(128 + ((x & 1) ? y : x) / 16 + (rand() & 3));
+}
+
+/* plain block average of one component */
+static int ref_pixel(const cmr_u8 *src, cmr_u32 stride, cmr_u32 dx, cmr_u32 dy,
+		     cmr_u32 factor, cmr_u32 comps, cmr_u32 c)
+{
+	cmr_u32 x, y, sum = 0;
+
+	for (y = 0; y < factor; y++)
+		for (x = 0; x < factor; x++)
+			sum += src[(dy * factor + y) * stride + (dx * factor + x) * comps + c];
+	return (sum + factor * factor / 2) / (factor * factor);
+}
+
+static int check(const cmr_u8 *src, cmr_u32 w, cmr_u32 h, cmr_u32 factor, const cmr_u8 *dst)
+{
+	cmr_u32 dw, dh, x, y, c;
+	const cmr_u8 *uv = src + w * h;
+	const cmr_u8 *duv;
+	int d;
+
+	cmr_fd_scale_size(w, h, factor, &dw, &dh);
+	duv = dst + dw * dh;
+
+	for (y = 0; y < dh; y++) {
+		for (x = 0; x < dw; x++) {
+			d = dst[y * dw + x] - ref_pixel(src, w, x, y, factor, 1, 0);
+			if (d > 1 || d < -1) {
+				printf("factor %u: Y(%u,%u) off by %d\n", factor, x, y, d);
+				return -1;
+			}
+		}
+	}
+	for (y = 0; y < dh / 2; y++) {
+		for (x = 0; x < dw / 2; x++) {
+			for (c = 0; c < 2; c++) {
+				d = duv[y * dw + x * 2 + c] - ref_pixel(uv, w, x, y, factor, 2, c);
+				if (d > 1 || d < -1) {
+					printf("factor %u: UV(%u,%u) off by %d\n", factor, x, y, d);
+					return -1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/* frames taken out of PACE_FRAMES with a detector that takes DETECT_TIME */
+static void bench_pace(void)
+{
+	struct cmr_fd_pace pace;
+	long long t = 0;
+	long long busy_until = 0;
+	int i, taken = 0;
+
+	cmr_fd_pace_init(&pace);
+	for (i = 0; i < PACE_FRAMES; i++, t += FRAME_TIME) {
+		if (t < busy_until || !cmr_fd_pace_ready(&pace, t))
+			continue;
+		taken++;
+		busy_until = t + DETECT_TIME;
+		cmr_fd_pace_done(&pace, t, busy_until);
+	}
+	printf("pace: %d of %d frames detected, detector busy %lld%%\n",
+	       taken, PACE_FRAMES, taken * DETECT_TIME * 100 / (PACE_FRAMES * FRAME_TIME));
+}
+
+int main(int argc, char **argv)
+{
+	cmr_u32 w = argc > 2 ? (cmr_u32)atoi(argv[1]) : DEF_WIDTH;
+	cmr_u32 h = argc > 2 ? (cmr_u32)atoi(argv[2]) : DEF_HEIGHT;
+	cmr_u32 size = w * h * 3 / 2;
+	cmr_u32 factor, dw, dh, f;
+	cmr_u8 *frm[FRAME_NUM];
+	cmr_u8 *dst;
+	cmr_u16 *line;
+	long long t0, copy_ns, scale_ns;
+	int i;
+
+	if (w < 2 || h < 2 || (w & 1) || (h & 1)) {
+		printf("Usage: utest_fd_scale [width height]\n");
+		return 1;
+	}
+
+	factor = cmr_fd_scale_factor(w, h);
+	cmr_fd_scale_size(w, h, factor, &dw, &dh);
+	printf("utest_fd_scale -- %ux%u NV21, factor %u, detector %ux%u\n", w, h, factor, dw, dh);
+
+	dst = (cmr_u8 *)malloc(size);
+	line = (cmr_u16 *)malloc(w * sizeof(cmr_u16));
+	for (i = 0; i < FRAME_NUM; i++) {
+		frm[i] = (cmr_u8 *)malloc(size);
+		if (!frm[i] || !dst || !line) {
+			printf("no memory\n");
+			return 1;
+		}
+		make_frame(frm[i], w, h, i);
+	}
+
+	/* every factor the preview sizes can give shall match a plain average */
+	for (f = 2; f <= 6; f++) {
+		if (w / f < 2 || h / f < 2)
+			break;
+		cmr_fd_scale_nv21(frm[0], frm[0] + w * h, w, h, f, dst, line);
+		if (check(frm[0], w, h, f, dst))
+			return 1;
+	}
+
+	/* the old path copied the whole frame on the preview thread */
+	t0 = now_ns();
+	for (i = 0; i < LOOPS; i++)
+		memcpy(dst, frm[i % FRAME_NUM], size);
+	copy_ns = now_ns() - t0;
+
+	t0 = now_ns();
+	for (i = 0; i < LOOPS; i++)
+		cmr_fd_scale_nv21(frm[i % FRAME_NUM], frm[i % FRAME_NUM] + w * h,
+				  w, h, factor, dst, line);
+	scale_ns = now_ns() - t0;
+
+	printf("copy: %lld us/frame, %u bytes\n", copy_ns / LOOPS / 1000, size);
+	printf("scale: %lld us/frame, %u bytes\n", scale_ns / LOOPS / 1000, dw * dh * 3 / 2);
+
+	bench_pace();
+
+	for (i = 0; i < FRAME_NUM; i++)
+		free(frm[i]);
+	free(dst);
+	free(line);
+	printf("OK\n");
+	return 0;
+}
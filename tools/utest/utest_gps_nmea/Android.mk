@@ -0,0 +1,9 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_gps_nmea
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/gps_so
+LOCAL_SRC_FILES:= utest_gps_nmea.c \
+	../../../libs/gps_so/gps_nmea.c
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "gps_nmea.h"
+
+#define MAX_LOG_SIZE    (16 * 1024 * 1024)
+#define MAX_RESULTS     (64 * 1024)
+#define LOOPS           20
+
+typedef struct {
+	int item;
+	int ivalue;
+	double fvalue;
+} Result;
+
+typedef struct {
+	Result r[MAX_RESULTS];
+	int count;
+} Results;
+
+static void record(NmeaReader* r, int item, int ivalue, double fvalue)
+{
+	Results* res = (Results*)r->opaque;
+
+	if (res->count < MAX_RESULTS) {
+		res->r[res->count].item = item;
+		res->r[res->count].ivalue = ivalue;
+		res->r[res->count].fvalue = fvalue;
+	}
+	res->count++;
+}
+
+static void add_sentence(char* log, int* len, const char* body)
+{
+	unsigned char cksum = 0;
+	const char* p;
+
+	for (p = body; *p; p++)
+		cksum ^= *p;
+	*len += sprintf(log + *len, "$%s*%02X\r\n", body, cksum);
+}
+
+/* 10 Hz epochs with GPS/GLONASS/BDS satellites and the engineering items */
+static int make_log(char* log, int seconds)
+{
+	char body[256];
+	int len = 0;
+	int i, j;
+
+	for (i = 0; i < seconds * 10; i++) {
+		sprintf(body, "GPGGA,%06d.%d,3114.1234,N,12128.5678,E,1,12,0.8,12.3,M,8.1,M,,",
+			i / 10, i % 10);
+		add_sentence(log, &len, body);
+		sprintf(body, "GPRMC,%06d.%d,A,3114.1234,N,12128.5678,E,0.02,31.66,191026,,,A",
+			i / 10, i % 10);
+		add_sentence(log, &len, body);
+		add_sentence(log, &len, "GPGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.5,0.8,1.2");
+		for (j = 1; j <= 4; j++) {
+			sprintf(body, "GPGSV,4,%d,16,%02d,40,083,46,%02d,17,308,41,%02d,07,344,39,%02d,22,228,45",
+				j, j * 4 - 3, j * 4 - 2, j * 4 - 1, j * 4);
+			add_sentence(log, &len, body);
+		}
+		for (j = 1; j <= 3; j++) {
+			sprintf(body, "GLGSV,3,%d,12,%02d,31,120,40,%02d,52,045,43,%02d,12,270,35,%02d,66,180,47",
+				j, 64 + j * 4, 65 + j * 4, 66 + j * 4, 67 + j * 4);
+			add_sentence(log, &len, body);
+		}
+		sprintf(body, "PCGDS,CWCN0,%d", 40 + i % 8);
+		add_sentence(log, &len, body);
+		sprintf(body, "PCGDS,TSXTEMP,%d.%03d", 25 + i % 5, i % 1000);
+		add_sentence(log, &len, body);
+		sprintf(body, "PCGDS,TCXO,-0.%06d", i * 37 % 1000000);
+		add_sentence(log, &len, body);
+	}
+	return len;
+}
+
+static double now_sec(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* feed one sentence per call like the GPS HAL callback does */
+static void feed_sentences(NmeaReader* r, const char* log, int len)
+{
+	const char* p = log;
+	const char* end = log + len;
+
+	while (p < end) {
+		const char* q = memchr(p, '\n', end - p);
+		q = q ? q + 1 : end;
+		nmea_reader_feed(r, p, q - p);
+		p = q;
+	}
+}
+
+/* feed random pieces, sentences get split across buffers */
+static void feed_chunks(NmeaReader* r, const char* log, int len)
+{
+	int off = 0;
+
+	while (off < len) {
+		int n = 1 + rand() % 97;
+		if (n > len - off)
+			n = len - off;
+		nmea_reader_feed(r, log + off, n);
+		off += n;
+	}
+}
+
+static int compare(Results* a, Results* b)
+{
+	int i;
+
+	if (a->count != b->count) {
+		printf("result count differs: %d vs %d\n", a->count, b->count);
+		return -1;
+	}
+	for (i = 0; i < a->count && i < MAX_RESULTS; i++) {
+		if (a->r[i].item != b->r[i].item || a->r[i].ivalue != b->r[i].ivalue
+		    || a->r[i].fvalue != b->r[i].fvalue) {
+			printf("result %d differs\n", i);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("Usage:\n");
+	printf("  utest_gps_nmea [nmea_log_file]\n");
+}
+
+int main(int argc, char** argv)
+{
+	static Results whole, chunked;
+	NmeaReader r;
+	char* log;
+	int len, i;
+	double t;
+
+	log = malloc(MAX_LOG_SIZE);
+	if (!log)
+		return -ENOMEM;
+
+	if (argc > 2) {
+		usage();
+		return -EINVAL;
+	}
+	if (argc == 2) {
+		FILE* fp = fopen(argv[1], "rb");
+		if (!fp) {
+			printf("cannot open %s (%s)\n", argv[1], strerror(errno));
+			return -errno;
+		}
+		len = fread(log, 1, MAX_LOG_SIZE, fp);
+		fclose(fp);
+	} else {
+		len = make_log(log, 600);
+	}
+	printf("utest_gps_nmea -- %d bytes of NMEA\n", len);
+
+	nmea_reader_init(&r, record, &whole);
+	feed_sentences(&r, log, len);
+	printf("sentences %u, dispatched %u, bad checksum %u, $PCGDS items %d\n",
+	       r.sentences, r.dispatched, r.bad_checksum, whole.count);
+
+	srand(1);
+	nmea_reader_init(&r, record, &chunked);
+	feed_chunks(&r, log, len);
+	if (compare(&whole, &chunked)) {
+		printf("split sentences: FAIL\n");
+		return -1;
+	}
+	printf("split sentences: OK\n");
+
+	t = now_sec();
+	for (i = 0; i < LOOPS; i++) {
+		whole.count = 0;
+		nmea_reader_init(&r, record, &whole);
+		feed_sentences(&r, log, len);
+	}
+	t = now_sec() - t;
+	printf("%.1f MB/s, %.0f sentences/s\n",
+	       (double)len * LOOPS / t / (1024 * 1024), r.sentences * LOOPS / t);
+
+	free(log);
+	return 0;
+}
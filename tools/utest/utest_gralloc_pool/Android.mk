@@ -0,0 +1,10 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_gralloc_pool
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/gralloc
+LOCAL_SRC_FILES:= utest_gralloc_pool.cpp \
+	../../../libs/gralloc/alloc_pool.cpp
+LOCAL_LDLIBS:= -lpthread
+include $(BUILD_HOST_EXECUTABLE)
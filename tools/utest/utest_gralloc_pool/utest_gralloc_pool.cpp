@@ -0,0 +1,517 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "alloc_pool.h"
+
+/* the heap masks and flags of ion_sprd.h and linux/ion.h */
+#define HEAP_SYSTEM     (1 << 1)
+#define HEAP_MM         (1 << 2)
+#define HEAP_OVERLAY    (1 << 3)
+#define FLAG_CACHED     3
+
+#define SCREEN_SIZE     (720 * 1280 * 4)
+#define PREVIEW_SIZE    (1280 * 720 * 3 / 2)
+#define CHURN_CYCLES    100
+
+/* buffers made at most in one run */
+#define MAX_SERIAL      (1 << 20)
+
+/*
+ *  ION stand-in: a memfd per buffer, numbered in ion_hnd, a heap may
+ *  be of limited size, the clock and the memory pressure can be set.
+ * */
+struct memfd_ctx {
+    pthread_mutex_t lock;       /* the worker allocates too */
+    size_t heapUsed[4];
+    size_t heapSize[4];
+    unsigned int live;
+    unsigned int serial;
+    int fakeClock;
+    int64_t nowMs;
+    int low;
+};
+
+/* the buffers the application has got */
+static unsigned char s_handedOut[MAX_SERIAL];
+
+static int heap_index(int heap_mask)
+{
+    return ffs(heap_mask) - 1;
+}
+
+static int memfd_alloc(void *ctx, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf)
+{
+    struct memfd_ctx *c = (struct memfd_ctx *)ctx;
+    int h = heap_index(heap_mask);
+    int fd;
+    void *base;
+
+    pthread_mutex_lock(&c->lock);
+    if (c->heapSize[h] && c->heapUsed[h] + size > c->heapSize[h]) {
+        pthread_mutex_unlock(&c->lock);
+        return -1;
+    }
+    c->heapUsed[h] += size;
+    c->live++;
+    buf->ion_hnd = (struct ion_handle *)(uintptr_t)(++c->serial % MAX_SERIAL);
+    pthread_mutex_unlock(&c->lock);
+
+    fd = memfd_create("gralloc", 0);
+    base = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, size) == 0)
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED) {
+        if (fd >= 0)
+            close(fd);
+        pthread_mutex_lock(&c->lock);
+        c->heapUsed[h] -= size;
+        c->live--;
+        pthread_mutex_unlock(&c->lock);
+        return -1;
+    }
+
+    buf->share_fd = fd;
+    buf->base = base;
+    buf->size = size;
+    buf->heap_mask = heap_mask;
+    buf->flags = flags;
+
+    return 0;
+}
+
+static void memfd_free(void *ctx, struct alloc_pool_buffer *buf)
+{
+    struct memfd_ctx *c = (struct memfd_ctx *)ctx;
+
+    munmap(buf->base, buf->size);
+    close(buf->share_fd);
+    pthread_mutex_lock(&c->lock);
+    c->heapUsed[heap_index(buf->heap_mask)] -= buf->size;
+    c->live--;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static int64_t memfd_now(void *ctx)
+{
+    struct memfd_ctx *c = (struct memfd_ctx *)ctx;
+    struct timespec ts;
+    int64_t ms;
+
+    pthread_mutex_lock(&c->lock);
+    ms = c->nowMs;
+    pthread_mutex_unlock(&c->lock);
+
+    if (c->fakeClock)
+        return ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int memfd_low_memory(void *ctx)
+{
+    struct memfd_ctx *c = (struct memfd_ctx *)ctx;
+    int low;
+
+    pthread_mutex_lock(&c->lock);
+    low = c->low;
+    pthread_mutex_unlock(&c->lock);
+
+    return low;
+}
+
+/* the worker reads the clock and the pressure too */
+static void set_clock(struct memfd_ctx *c, int64_t ms, int low)
+{
+    pthread_mutex_lock(&c->lock);
+    c->nowMs = ms;
+    c->low = low;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static const struct alloc_pool_ops s_ops = {
+    memfd_alloc,
+    memfd_free,
+    memfd_now,
+    memfd_low_memory,
+};
+
+static int s_failed;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            s_failed = 1; \
+        } \
+    } while (0)
+
+/*
+ *  Once the worker is done, every buffer made has left as a hit or
+ *  been freed, or is still in the pool.
+ * */
+static void check_stats(struct alloc_pool *pool, unsigned int outstanding)
+{
+    struct memfd_ctx *c = (struct memfd_ctx *)pool->ctx;
+    struct alloc_pool_stats *s = &pool->stats;
+
+    alloc_pool_wait(pool);
+    CHECK(s->made == s->hits + s->evicted + s->idle + s->pressure + (unsigned int)pool->count);
+    CHECK(c->live == outstanding + (unsigned int)pool->count);
+    CHECK(pool->bytes <= pool->budget);
+    CHECK(s->peak_bytes <= pool->budget);
+}
+
+/*
+ *  The application gets a buffer nobody has had before, all zero.
+ * */
+static int alloc_new(struct alloc_pool *pool, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf)
+{
+    int ret = alloc_pool_alloc(pool, size, heap_mask, flags, buf);
+    uintptr_t serial;
+
+    if (ret == 0) {
+        serial = (uintptr_t)buf->ion_hnd;
+        CHECK(s_handedOut[serial] == 0);
+        CHECK(((char *)buf->base)[0] == 0 && ((char *)buf->base)[buf->size - 1] == 0);
+        s_handedOut[serial] = 1;
+    }
+
+    return ret;
+}
+
+/* and fills it */
+static int alloc_fill(struct alloc_pool *pool, size_t size, int heap_mask, int flags, struct alloc_pool_buffer *buf)
+{
+    int ret = alloc_new(pool, size, heap_mask, flags, buf);
+
+    if (ret == 0)
+        memset(buf->base, 0x5a, size);
+
+    return ret;
+}
+
+/* the system heap clears its buffers, only they are replaced */
+static void free_all(struct alloc_pool *pool, struct alloc_pool_buffer *bufs, int n)
+{
+    for (int i = 0; i < n; i++)
+        alloc_pool_free(pool, &bufs[i], bufs[i].heap_mask == HEAP_SYSTEM);
+}
+
+/*
+ *  Rotation: the three window buffers come back at the same size.
+ *  App switch: a full screen application and its small buffers give
+ *  way to another one. Camera start: preview buffers from the MM heap.
+ *  A frame passes between the frees and the allocations that follow,
+ *  the worker has made the replacements by then. Returns the time
+ *  spent allocating.
+ * */
+static double run_churn(size_t budget, struct alloc_pool_stats *stats)
+{
+    struct memfd_ctx c;
+    struct alloc_pool pool;
+    struct alloc_pool_buffer win[3], app[5], cam[8];
+    struct timespec t0, t1;
+    double ms = 0;
+
+    memset(&c, 0, sizeof(c));
+    pthread_mutex_init(&c.lock, NULL);
+    memset(s_handedOut, 0, sizeof(s_handedOut));
+    alloc_pool_init(&pool, &s_ops, &c, budget);
+
+    for (int i = 0; i < 3; i++)
+        alloc_fill(&pool, SCREEN_SIZE, HEAP_SYSTEM, 0, &win[i]);
+
+    for (int cycle = 0; cycle < CHURN_CYCLES; cycle++) {
+        free_all(&pool, win, 3);
+        alloc_pool_wait(&pool);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < 3; i++)
+            alloc_new(&pool, SCREEN_SIZE, HEAP_SYSTEM, 0, &win[i]);
+
+        for (int i = 0; i < 3; i++)
+            alloc_new(&pool, SCREEN_SIZE - (cycle & 1) * 64 * 1024, HEAP_SYSTEM, 0, &app[i]);
+        alloc_new(&pool, 96 * 96 * 4, HEAP_SYSTEM, FLAG_CACHED, &app[3]);
+        alloc_new(&pool, 48 * 48 * 4, HEAP_SYSTEM, FLAG_CACHED, &app[4]);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ms += (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_nsec - t0.tv_nsec) / 1000000.0;
+        for (int i = 0; i < 5; i++)
+            memset(app[i].base, 0x5a, app[i].size);
+        free_all(&pool, app, 5);
+
+        if (cycle % 4 == 0) {
+            alloc_pool_wait(&pool);
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for (int i = 0; i < 8; i++)
+                alloc_new(&pool, PREVIEW_SIZE, HEAP_MM, FLAG_CACHED, &cam[i]);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            ms += (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_nsec - t0.tv_nsec) / 1000000.0;
+            free_all(&pool, cam, 8);
+        }
+        check_stats(&pool, 3);
+    }
+
+    free_all(&pool, win, 3);
+    alloc_pool_wait(&pool);
+    *stats = pool.stats;
+    alloc_pool_destroy(&pool);
+    CHECK(c.live == 0);
+
+    return ms;
+}
+
+/* the best of three runs */
+static double best_churn(size_t budget, struct alloc_pool_stats *stats)
+{
+    double best = run_churn(budget, stats);
+
+    for (int i = 0; i < 2; i++) {
+        double ms = run_churn(budget, stats);
+
+        if (ms < best)
+            best = ms;
+    }
+
+    return best;
+}
+
+static void test_churn(void)
+{
+    struct alloc_pool_stats s0, s1;
+    double none, pooled;
+
+    none = best_churn(0, &s0);
+    pooled = best_churn(ALLOC_POOL_BUDGET, &s1);
+
+    printf("churn: %d cycles, allocating without pool %.1f ms, with pool %.1f ms, hits %u misses %u evicted %u\n",
+           CHURN_CYCLES, none, pooled, s1.hits, s1.misses, s1.evicted);
+    CHECK(s0.hits == 0 && s0.made == 0);
+    CHECK(s1.hits >= CHURN_CYCLES * 3);
+    CHECK(pooled < none);
+}
+
+static void test_semantics(void)
+{
+    struct memfd_ctx c;
+    struct alloc_pool pool;
+    struct alloc_pool_buffer a, b, big[4];
+    char dump[256];
+
+    memset(&c, 0, sizeof(c));
+    pthread_mutex_init(&c.lock, NULL);
+    memset(s_handedOut, 0, sizeof(s_handedOut));
+    c.fakeClock = 1;
+    alloc_pool_init(&pool, &s_ops, &c, 4 * 1024 * 1024);
+
+    printf("size classes:");
+    for (size_t s = 1000; s < 16 * 1024 * 1024; s = s * 3 + 12345) {
+        size_t cls = alloc_pool_size_class(s);
+
+        printf(" %zu", cls / 1024);
+        CHECK(cls >= s && cls - s <= s / 16 + 4095);
+        CHECK(alloc_pool_size_class(cls) == cls);
+    }
+    printf(" KB\n");
+
+    /* a freed buffer is replaced by a new one, which the next allocation gets */
+    alloc_fill(&pool, 100000, HEAP_SYSTEM, 0, &a);
+    alloc_pool_free(&pool, &a, 1);
+    alloc_pool_wait(&pool);
+    CHECK(pool.count == 1 && pool.stats.made == 1);
+    alloc_new(&pool, 100000, HEAP_SYSTEM, 0, &b);
+    CHECK(pool.stats.hits == 1 && b.ion_hnd != a.ion_hnd);
+    printf("replace: hits %u, handed out again %s\n", pool.stats.hits, s_failed ? "yes" : "no");
+
+    /* cached and uncached buffers are not mixed */
+    alloc_pool_free(&pool, &b, 1);
+    alloc_new(&pool, 100000, HEAP_SYSTEM, FLAG_CACHED, &a);
+    alloc_pool_wait(&pool);
+    CHECK(pool.stats.hits == 1 && pool.count == 1);
+    alloc_pool_free(&pool, &a, 1);
+    check_stats(&pool, 0);
+
+    /* protected buffers and other heaps are not replaced */
+    alloc_new(&pool, 100000, HEAP_MM, 0, &a);
+    alloc_pool_free(&pool, &a, 0);
+    check_stats(&pool, 0);
+    CHECK(pool.count == 2 && pool.stats.made == 3);
+
+    /* buffers idle for ALLOC_POOL_IDLE_MS are freed */
+    set_clock(&c, c.nowMs + ALLOC_POOL_IDLE_MS, 0);
+    alloc_pool_trim(&pool, pool.budget);
+    CHECK(pool.count == 0 && pool.stats.idle == 2);
+    check_stats(&pool, 0);
+
+    /* nothing is made under memory pressure, all goes */
+    alloc_new(&pool, 100000, HEAP_SYSTEM, 0, &a);
+    alloc_new(&pool, 200000, HEAP_SYSTEM, 0, &b);
+    alloc_pool_free(&pool, &a, 1);
+    alloc_pool_wait(&pool);
+    set_clock(&c, c.nowMs, 1);
+    alloc_pool_free(&pool, &b, 1);
+    alloc_pool_wait(&pool);
+    CHECK(pool.count == 1);
+    alloc_new(&pool, 300000, HEAP_SYSTEM, 0, &a);
+    CHECK(pool.count == 0 && pool.stats.pressure == 1);
+    alloc_pool_free(&pool, &a, 1);
+    set_clock(&c, c.nowMs, 0);
+    check_stats(&pool, 0);
+
+    /* the budget is never exceeded, a buffer of more than half is not replaced */
+    for (int i = 0; i < 4; i++)
+        alloc_new(&pool, 1536 * 1024, HEAP_SYSTEM, 0, &big[i]);
+    alloc_new(&pool, 3 * 1024 * 1024, HEAP_SYSTEM, 0, &a);
+    alloc_pool_free(&pool, &a, 1);
+    free_all(&pool, big, 4);
+    check_stats(&pool, 0);
+    CHECK(pool.count == 2 && pool.stats.evicted == 2);
+    alloc_pool_trim(&pool, 0);
+
+    /* an exhausted heap gets the kept buffers back and retries */
+    c.heapSize[heap_index(HEAP_SYSTEM)] = 8 * 1024 * 1024;
+    for (int i = 0; i < 2; i++)
+        CHECK(alloc_new(&pool, 1536 * 1024, HEAP_SYSTEM, FLAG_CACHED, &big[i]) == 0);
+    CHECK(alloc_new(&pool, 5 * 1024 * 1024, HEAP_SYSTEM, 0, &a) == 0);
+    free_all(&pool, big, 2);
+    alloc_pool_wait(&pool);
+    CHECK(pool.count == 2);
+    CHECK(alloc_new(&pool, 3 * 1024 * 1024, HEAP_SYSTEM, 0, &b) == 0);
+    CHECK(pool.stats.retries == 1 && pool.count == 0);
+    alloc_pool_free(&pool, &a, 0);
+    alloc_pool_free(&pool, &b, 0);
+    check_stats(&pool, 0);
+    c.heapSize[heap_index(HEAP_SYSTEM)] = 0;
+
+    alloc_pool_dump(&pool, dump, sizeof(dump));
+    printf("%s", dump);
+    alloc_pool_destroy(&pool);
+    CHECK(c.live == 0);
+}
+
+/*
+ *  With nothing allocated or freed, the worker frees idle buffers
+ *  within ALLOC_POOL_CHECK_MS, and all of them under memory pressure.
+ * */
+static void test_trim(void)
+{
+    struct memfd_ctx c;
+    struct alloc_pool pool;
+    struct alloc_pool_buffer a[3];
+
+    memset(&c, 0, sizeof(c));
+    pthread_mutex_init(&c.lock, NULL);
+    memset(s_handedOut, 0, sizeof(s_handedOut));
+    c.fakeClock = 1;
+    alloc_pool_init(&pool, &s_ops, &c, ALLOC_POOL_BUDGET);
+
+    for (int i = 0; i < 3; i++)
+        alloc_new(&pool, 100000, HEAP_SYSTEM, 0, &a[i]);
+    free_all(&pool, a, 2);
+    alloc_pool_wait(&pool);
+    set_clock(&c, c.nowMs + ALLOC_POOL_IDLE_MS - 1, 0);
+    usleep(ALLOC_POOL_CHECK_MS * 1000 * 3 / 2);
+    check_stats(&pool, 1);
+    CHECK(pool.count == 2);
+
+    set_clock(&c, c.nowMs + 1, 0);
+    usleep(ALLOC_POOL_CHECK_MS * 1000 * 3 / 2);
+    check_stats(&pool, 1);
+    CHECK(pool.count == 0 && pool.stats.idle == 2);
+
+    free_all(&pool, a + 2, 1);
+    alloc_pool_wait(&pool);
+    CHECK(pool.count == 1);
+    set_clock(&c, c.nowMs, 1);
+    usleep(ALLOC_POOL_CHECK_MS * 1000 * 3 / 2);
+    check_stats(&pool, 0);
+    CHECK(pool.count == 0 && pool.stats.pressure == 1);
+
+    printf("trim: idle %u pressure %u\n", pool.stats.idle, pool.stats.pressure);
+    alloc_pool_destroy(&pool);
+    CHECK(c.live == 0);
+}
+
+/*
+ *  Random allocations and frees of every heap and flag,
+ *  the stats and the budget hold after each.
+ * */
+static void test_random(unsigned int steps)
+{
+    struct memfd_ctx c;
+    struct alloc_pool pool;
+    struct alloc_pool_buffer bufs[16];
+    int used[16];
+    unsigned int outstanding = 0;
+    static const int heaps[] = { HEAP_SYSTEM, HEAP_MM, HEAP_OVERLAY };
+
+    memset(&c, 0, sizeof(c));
+    pthread_mutex_init(&c.lock, NULL);
+    memset(used, 0, sizeof(used));
+    memset(s_handedOut, 0, sizeof(s_handedOut));
+    c.fakeClock = 1;
+    c.heapSize[heap_index(HEAP_MM)] = 24 * 1024 * 1024;
+    alloc_pool_init(&pool, &s_ops, &c, 8 * 1024 * 1024);
+
+    for (unsigned int i = 0; i < steps; i++) {
+        int k = rand() % 16;
+
+        int64_t ms = c.nowMs + rand() % 200;
+
+        set_clock(&c, ms, (rand() % 50) == 0);
+
+        if (used[k]) {
+            alloc_pool_free(&pool, &bufs[k], bufs[k].heap_mask == HEAP_SYSTEM && rand() % 8 != 0);
+            used[k] = 0;
+            outstanding--;
+        } else {
+            size_t size = 4096 + (rand() % 64) * 32768;
+            int heap = heaps[rand() % 3];
+            int flags = (rand() % 2) ? FLAG_CACHED : 0;
+
+            if (alloc_new(&pool, size, heap, flags, &bufs[k]) == 0) {
+                CHECK(bufs[k].size >= size && bufs[k].heap_mask == heap && bufs[k].flags == flags);
+                used[k] = 1;
+                outstanding++;
+            }
+        }
+        check_stats(&pool, outstanding);
+    }
+
+    for (int k = 0; k < 16; k++)
+        if (used[k])
+            alloc_pool_free(&pool, &bufs[k], 1);
+
+    alloc_pool_wait(&pool);
+    printf("random: %u steps, hits %u misses %u made %u failed %u evicted %u idle %u pressure %u\n",
+           steps, pool.stats.hits, pool.stats.misses, pool.stats.made, pool.stats.failed,
+           pool.stats.evicted, pool.stats.idle, pool.stats.pressure);
+    alloc_pool_destroy(&pool);
+    CHECK(c.live == 0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+
+    srand(seed);
+    printf("utest_gralloc_pool -- budget %d KB, seed %u\n", ALLOC_POOL_BUDGET / 1024, seed);
+
+    test_semantics();
+    test_trim();
+    test_random(20000);
+    test_churn();
+
+    printf("%s\n", s_failed ? "FAIL" : "OK");
+
+    return s_failed;
+}
@@ -0,0 +1,9 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_gralloc_sync
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/gralloc
+LOCAL_SRC_FILES:= utest_gralloc_sync.cpp \
+	../../../libs/gralloc/gralloc_sync.cpp
+include $(BUILD_HOST_EXECUTABLE)
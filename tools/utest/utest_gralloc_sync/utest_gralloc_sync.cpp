@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <system/graphics.h>
+
+#include "gralloc_sync.h"
+
+#define ALIGN(value, base)  (((value) + ((base) - 1)) & ~((base) - 1))
+#define RECTS_PER_FORMAT    600
+
+/*
+ *  Mock of the ION maintenance: the bytes of every range are marked,
+ *  a call for the whole buffer is counted.
+ * */
+struct mock {
+    unsigned char *marks;
+    size_t size;
+    struct gralloc_sync_range ranges[GRALLOC_SYNC_RANGES_MAX];
+    int op;
+    int calls;
+    int all;
+    int fail;
+    int bad;
+};
+
+static int mock_range(void *ctx, int op, size_t offset, size_t size)
+{
+    struct mock *m = (struct mock *)ctx;
+
+    if (m->fail)
+        return -1;
+
+    if (op != m->op || offset % GRALLOC_SYNC_LINE || offset + size > m->size || size == 0)
+        m->bad++;
+    for (size_t i = offset; i < offset + size && i < m->size; i++) {
+        if (m->marks[i])
+            m->bad++;
+        m->marks[i] = 1;
+    }
+    if (m->calls < GRALLOC_SYNC_RANGES_MAX) {
+        m->ranges[m->calls].offset = offset;
+        m->ranges[m->calls].size = size;
+    } else {
+        m->bad++;
+    }
+    m->calls++;
+
+    return 0;
+}
+
+static void mock_all(void *ctx, int op)
+{
+    struct mock *m = (struct mock *)ctx;
+
+    if (op != m->op)
+        m->bad++;
+    m->all++;
+}
+
+static const struct gralloc_sync_ops s_ops = { mock_range, mock_all };
+
+struct format {
+    const char *name;
+    int format;
+};
+
+static const struct format s_formats[] = {
+    { "RGBA_8888", HAL_PIXEL_FORMAT_RGBA_8888 },
+    { "RGBX_8888", HAL_PIXEL_FORMAT_RGBX_8888 },
+    { "BGRA_8888", HAL_PIXEL_FORMAT_BGRA_8888 },
+    { "RGB_888", HAL_PIXEL_FORMAT_RGB_888 },
+    { "RGB_565", HAL_PIXEL_FORMAT_RGB_565 },
+    { "RGBA_5551", HAL_PIXEL_FORMAT_RGBA_5551 },
+    { "RGBA_4444", HAL_PIXEL_FORMAT_RGBA_4444 },
+    { "YCrCb_420_SP", HAL_PIXEL_FORMAT_YCrCb_420_SP },
+    { "YCbCr_420_SP", HAL_PIXEL_FORMAT_YCbCr_420_SP },
+    { "YV12", HAL_PIXEL_FORMAT_YV12 },
+    { "YCbCr_420_P", HAL_PIXEL_FORMAT_YCbCr_420_P },
+    { "IMPL_DEFINED", HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED },
+};
+
+/* stride and size as alloc_device_alloc() gives them */
+static int buffer_of(int format, int w, int h, struct gralloc_sync_buffer *buf)
+{
+    int bpp = 0;
+
+    buf->format = format;
+    buf->width = w;
+    buf->height = h;
+
+    switch (format) {
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+        buf->stride = ALIGN(w, 16);
+        buf->size = ALIGN(h, 16) * (buf->stride + ALIGN(buf->stride / 2, 16));
+        return 0;
+    case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+        buf->stride = w;
+        buf->size = ALIGN(h * w, 64) + h * ALIGN(w / 2, 16);
+        return 0;
+    case HAL_PIXEL_FORMAT_YCbCr_420_P:
+    case HAL_PIXEL_FORMAT_YV12:
+        buf->stride = (format == HAL_PIXEL_FORMAT_YV12) ? ALIGN(w, 16) : w;
+        buf->size = ALIGN(h * buf->stride, 64) + ALIGN(h / 2 * ALIGN(buf->stride / 2, 16), 64)
+                  + h / 2 * ALIGN(buf->stride / 2, 16);
+        return 0;
+    case HAL_PIXEL_FORMAT_RGB_888:
+        bpp = 3;
+        break;
+    case HAL_PIXEL_FORMAT_RGB_565:
+    case HAL_PIXEL_FORMAT_RGBA_5551:
+    case HAL_PIXEL_FORMAT_RGBA_4444:
+        bpp = 2;
+        break;
+    default:
+        bpp = 4;
+        break;
+    }
+
+    buf->stride = ALIGN(w * bpp, 8) / bpp;
+    buf->size = ALIGN(w * bpp, 8) * h;
+
+    return 0;
+}
+
+/*
+ *  The bytes a writer of pixel x, y touches, as the producers and
+ *  gralloc_lock_ycbcr() address them. Plane index in plane.
+ *  return value: the number of offsets.
+ * */
+static int pixel_bytes(const struct gralloc_sync_buffer *b, int x, int y, size_t *offsets, int *plane)
+{
+    size_t s = b->stride;
+    size_t cp = ALIGN(s / 2, 16);
+    size_t co = ALIGN(b->height * s, 64);
+    int n = 0;
+
+    switch (b->format) {
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+        offsets[n] = y * s + x;
+        plane[n++] = 0;
+        offsets[n] = s * b->height + (y / 2) * s + (x / 2) * 2;
+        plane[n++] = 1;
+        offsets[n] = offsets[n - 1] + 1;
+        plane[n] = 1;
+        n++;
+        return n;
+    case HAL_PIXEL_FORMAT_YV12:
+    case HAL_PIXEL_FORMAT_YCbCr_420_P:
+        offsets[n] = y * s + x;
+        plane[n++] = 0;
+        offsets[n] = co + (y / 2) * cp + x / 2;
+        plane[n++] = 1;
+        offsets[n] = co + ALIGN(b->height / 2 * cp, 64) + (y / 2) * cp + x / 2;
+        plane[n++] = 2;
+        return n;
+    case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+        /* the chroma rows are the producer's, any byte of the region */
+        offsets[n] = y * s + x;
+        plane[n++] = 0;
+        offsets[n] = co + (size_t)rand() % (b->size - co);
+        plane[n++] = 1;
+        return n;
+    default: {
+        int bpp = (b->format == HAL_PIXEL_FORMAT_RGB_888) ? 3 :
+                  (b->format == HAL_PIXEL_FORMAT_RGB_565 || b->format == HAL_PIXEL_FORMAT_RGBA_5551 ||
+                   b->format == HAL_PIXEL_FORMAT_RGBA_4444) ? 2 : 4;
+
+        for (int i = 0; i < bpp; i++) {
+            offsets[n] = (y * s + x) * bpp + i;
+            plane[n++] = 0;
+        }
+        return n;
+    }
+    }
+}
+
+/*
+ *  Every byte of the rectangle is maintained, and nothing out of the
+ *  line-rounded hull of the rectangle in each plane, but for a merge.
+ * */
+static int check_rect(const struct gralloc_sync_buffer *b, struct mock *m, int l, int t, int w, int h,
+                      size_t *maintained, size_t *needed)
+{
+    size_t lo[3] = { (size_t)-1, (size_t)-1, (size_t)-1 };
+    size_t hi[3] = { 0, 0, 0 };
+    size_t offsets[4];
+    int plane[4];
+    int errors = 0;
+
+    m->calls = 0;
+    m->all = 0;
+    gralloc_sync_rect(&s_ops, m, m->op, b, l, t, w, h, 100);
+
+    if (m->all)
+        return 0;
+
+    for (int y = t; y < t + h; y++) {
+        for (int x = l; x < l + w; x++) {
+            int n = pixel_bytes(b, x, y, offsets, plane);
+
+            for (int i = 0; i < n; i++) {
+                if (m->marks[offsets[i]] == 0)
+                    errors++;
+                if (offsets[i] < lo[plane[i]])
+                    lo[plane[i]] = offsets[i];
+                if (offsets[i] > hi[plane[i]])
+                    hi[plane[i]] = offsets[i];
+                *needed += (plane[i] == 0 || b->format != HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED);
+            }
+        }
+    }
+
+    if (b->format == HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED) {
+        lo[1] = ALIGN(b->height * b->stride, 64);
+        hi[1] = b->size - 1;
+    }
+
+    for (int r = 0; r < m->calls; r++) {
+        for (size_t i = m->ranges[r].offset; i < m->ranges[r].offset + m->ranges[r].size; i++) {
+            int inside = 0;
+
+            for (int p = 0; p < 3; p++)
+                if (lo[p] != (size_t)-1 && i + GRALLOC_SYNC_MERGE_GAP >= (lo[p] & ~(size_t)(GRALLOC_SYNC_LINE - 1)) &&
+                    i < ALIGN(hi[p] + 1, GRALLOC_SYNC_LINE) + GRALLOC_SYNC_MERGE_GAP)
+                    inside = 1;
+            if (inside == 0)
+                errors++;
+            m->marks[i] = 0;
+            (*maintained)++;
+        }
+    }
+
+    return errors;
+}
+
+static int random_in(int lo, int hi)
+{
+    return lo + rand() % (hi - lo + 1);
+}
+
+static int test_formats(void)
+{
+    static const int sizes[][2] = { { 720, 1280 }, { 176, 144 }, { 34, 18 } };
+    struct mock m;
+    int ret = 0;
+
+    memset(&m, 0, sizeof(m));
+    m.op = GRALLOC_SYNC_CLEAN;
+
+    for (unsigned int f = 0; f < sizeof(s_formats) / sizeof(s_formats[0]); f++) {
+        size_t maintained = 0, needed = 0;
+        int errors = 0;
+        int full = 0;
+
+        for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            struct gralloc_sync_buffer b;
+
+            buffer_of(s_formats[f].format, sizes[s][0], sizes[s][1], &b);
+            m.marks = (unsigned char *)calloc(b.size, 1);
+            m.size = b.size;
+
+            for (int r = 0; r < RECTS_PER_FORMAT / 3; r++) {
+                int w = random_in(1, (r % 4 == 0) ? b.width : b.width / 8 + 1);
+                int h = random_in(1, (r % 4 == 0) ? b.height : b.height / 8 + 1);
+                int l = random_in(0, b.width - w);
+                int t = random_in(0, b.height - h);
+
+                errors += check_rect(&b, &m, l, t, w, h, &maintained, &needed);
+                full += m.all;
+            }
+            free(m.marks);
+        }
+
+        printf("%-13s %d rects, %d whole, maintained %5.2f x the bytes written, errors %d\n",
+               s_formats[f].name, RECTS_PER_FORMAT / 3 * 3, full,
+               needed ? (double)maintained / needed : 0.0, errors + m.bad);
+        if (errors || m.bad)
+            ret = -1;
+        m.bad = 0;
+    }
+
+    return ret;
+}
+
+/*
+ *  Ranges of full rows merge, a large rectangle, an unknown format
+ *  or a failing range falls back to the whole buffer.
+ * */
+static int test_fallback(void)
+{
+    struct gralloc_sync_buffer b;
+    struct mock m;
+    size_t bytes;
+    int ret = 0;
+
+    memset(&m, 0, sizeof(m));
+    m.op = GRALLOC_SYNC_INVALIDATE;
+    buffer_of(HAL_PIXEL_FORMAT_RGBA_8888, 720, 1280, &b);
+    m.marks = (unsigned char *)calloc(b.size, 1);
+    m.size = b.size;
+
+    bytes = gralloc_sync_rect(&s_ops, &m, m.op, &b, 0, 100, 720, 20, GRALLOC_SYNC_FULL_PCT);
+    printf("full rows:  %d ranges, %zu bytes\n", m.calls, bytes);
+    if (m.calls != 1 || m.all || bytes != 720 * 4 * 20)
+        ret = -1;
+
+    m.calls = 0;
+    memset(m.marks, 0, m.size);
+    bytes = gralloc_sync_rect(&s_ops, &m, m.op, &b, 100, 100, 16, 16, GRALLOC_SYNC_FULL_PCT);
+    printf("16x16:      %d ranges, %zu bytes\n", m.calls, bytes);
+    if (m.calls != 16 || m.all || bytes > 16 * 2 * GRALLOC_SYNC_LINE)
+        ret = -1;
+
+    m.calls = 0;
+    memset(m.marks, 0, m.size);
+    bytes = gralloc_sync_rect(&s_ops, &m, m.op, &b, 0, 0, 720, 1000, GRALLOC_SYNC_FULL_PCT);
+    printf("720x1000:   %d ranges, whole %d\n", m.calls, m.all);
+    if (m.calls != 0 || m.all != 1 || bytes != b.size)
+        ret = -1;
+
+    m.all = 0;
+    gralloc_sync_rect(&s_ops, &m, m.op, &b, 0, 0, 0, 0, GRALLOC_SYNC_FULL_PCT);
+    gralloc_sync_rect(&s_ops, &m, m.op, &b, 800, 0, 10, 10, GRALLOC_SYNC_FULL_PCT);
+    printf("empty:      whole %d\n", m.all);
+    if (m.all != 2)
+        ret = -1;
+
+    m.all = 0;
+    m.fail = 1;
+    gralloc_sync_rect(&s_ops, &m, m.op, &b, 10, 10, 10, 10, GRALLOC_SYNC_FULL_PCT);
+    m.fail = 0;
+    b.format = HAL_PIXEL_FORMAT_BLOB;
+    gralloc_sync_rect(&s_ops, &m, m.op, &b, 10, 10, 10, 10, GRALLOC_SYNC_FULL_PCT);
+    printf("failed, BLOB: whole %d\n", m.all);
+    if (m.all != 2 || m.bad)
+        ret = -1;
+
+    free(m.marks);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    int ret = 0;
+
+    srand(seed);
+    printf("utest_gralloc_sync -- line %d, seed %u\n", GRALLOC_SYNC_LINE, seed);
+
+    ret |= test_formats();
+    ret |= test_fallback();
+
+    printf("%s\n", ret ? "FAIL" : "OK");
+
+    return ret;
+}
@@ -0,0 +1,18 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_hwc_plan
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS += -include $(LOCAL_PATH)/utest_hwc_plan.h
+LOCAL_CFLAGS += -DPROCESS_VIDEO_USE_GSP -DOVERLAY_COMPOSER_GPU \
+	-DDYNAMIC_RELEASE_PLANEBUFFER -DDIRECT_DISPLAY_SINGLE_OSD_LAYER
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/hwcomposer \
+	$(LOCAL_PATH)/../../../libs/hwcomposer/SprdPrimaryDisplayDevice \
+	$(LOCAL_PATH)/../../../libs/gralloc \
+	$(LOCAL_PATH)/../../../libs/mali/src/ump/include
+LOCAL_SRC_FILES:= utest_hwc_plan.cpp \
+	../../../libs/hwcomposer/SprdPrimaryDisplayDevice/SprdHWLayerList.cpp \
+	../../../libs/hwcomposer/SprdHWLayer.cpp
+LOCAL_STATIC_LIBRARIES:= libcutils liblog
+LOCAL_LDLIBS:= -lrt -lpthread
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SprdHWLayerList.h"
+
+#define MAX_LAYERS      8
+#define BUFFER_NUM      3
+#define FB_WIDTH        720
+#define FB_HEIGHT       1280
+#define RANDOM_STEPS    20000
+
+#define PHY             private_handle_t::PRIV_FLAGS_USES_PHY
+#define NOT_OVERLAY     private_handle_t::PRIV_FLAGS_NOT_OVERLAY
+#define PROTECTED       GRALLOC_USAGE_PROTECTED
+#define YUV420SP        HAL_PIXEL_FORMAT_YCbCr_420_SP
+#define YV12            HAL_PIXEL_FORMAT_YV12
+#define RGBA            HAL_PIXEL_FORMAT_RGBA_8888
+#define RGBX            HAL_PIXEL_FORMAT_RGBX_8888
+#define RGB565          HAL_PIXEL_FORMAT_RGB_565
+
+/* events a scene plays on a frame */
+#define EV_NONE         0
+#define EV_BLANK        1
+#define EV_ACCEL        2
+#define EV_RECLAIM      3
+#define EV_LOST_PHY     4
+#define EV_CROP         5
+
+struct layerDesc {
+    int format;
+    int width;
+    int height;
+    int privFlags;
+    int usage;
+    uint32_t transform;
+    int skip;
+    hwc_frect_t crop;
+    hwc_rect_t frame;
+};
+
+struct scene {
+    const char *name;
+    int frames;
+    int count;
+    struct layerDesc layer[MAX_LAYERS];
+    /* frame, event pairs, ended by a frame of 0 */
+    int event[8][2];
+};
+
+#define FULL_CROP(w, h)  {0, 0, w, h}
+#define FULL_FRAME       {0, 0, FB_WIDTH, FB_HEIGHT}
+
+static const struct scene s_scene[] = {
+    {"launcher", 300, 4, {
+        {RGBX, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME},
+        {RGBA, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME},
+        {RGBA, FB_WIDTH, 50, 0, 0, 0, 0, FULL_CROP(720, 50), {0, 0, FB_WIDTH, 50}},
+        {RGBA, FB_WIDTH, 96, 0, 0, 0, 0, FULL_CROP(720, 96), {0, 1184, FB_WIDTH, FB_HEIGHT}}},
+        {{100, EV_BLANK}, {200, EV_ACCEL}, {0, 0}}},
+    {"video", 300, 3, {
+        {YUV420SP, 1280, 720, PHY, 0, HAL_TRANSFORM_ROT_90, 0, FULL_CROP(1280, 720), FULL_FRAME},
+        {RGBA, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME},
+        {RGBA, FB_WIDTH, 50, 0, 0, 0, 0, FULL_CROP(720, 50), {0, 0, FB_WIDTH, 50}}},
+        {{60, EV_RECLAIM}, {120, EV_LOST_PHY}, {121, EV_LOST_PHY}, {180, EV_CROP}, {0, 0}}},
+    {"protected", 200, 2, {
+        {YUV420SP, 1280, 720, PHY, PROTECTED, 0, 0, FULL_CROP(1280, 720), {0, 280, FB_WIDTH, 685}},
+        {RGBA, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME}},
+        {{100, EV_BLANK}, {0, 0}}},
+    {"camera", 200, 2, {
+        {YV12, 640, 480, NOT_OVERLAY, 0, HAL_TRANSFORM_ROT_90, 0, FULL_CROP(640, 480), FULL_FRAME},
+        {RGBA, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME}},
+        {{0, 0}}},
+    {"skip", 200, 3, {
+        {RGB565, FB_WIDTH, FB_HEIGHT, PHY, 0, 0, 0, FULL_CROP(720, 1280), FULL_FRAME},
+        {RGBA, 320, 240, 0, 0, 0, 1, FULL_CROP(320, 240), {200, 520, 520, 760}},
+        {RGBA, FB_WIDTH, 50, 0, 0, 0, 0, FULL_CROP(720, 50), {0, 0, FB_WIDTH, 50}}},
+        {{50, EV_ACCEL}, {0, 0}}},
+};
+
+struct frameList {
+    hwc_display_contents_1_t contents;
+    hwc_layer_1_t layers[MAX_LAYERS + 1];
+};
+
+/*
+ *  Both runs see the same handles, SurfaceFlinger keeps
+ *  compositionType and hints of a layer until the geometry changes.
+ * */
+struct run {
+    SprdHWLayerList *list;
+    SprdPrimaryDisplayDevice primary;
+    struct frameList frame;
+    int displayFlag;
+    double ns;
+};
+
+static private_handle_t *s_buffer[MAX_LAYERS + 1][BUFFER_NUM];
+static unsigned int s_planCount[HWC_PLAN_CACHE_EVENT_MAX];
+static FrameBufferInfo s_fbInfo;
+static GSP_CAPABILITY_T s_gspCap;
+
+void queryDebugFlag(int *debugFlag)
+{
+    *debugFlag = 0;
+}
+
+void queryDumpFlag(int *dumpFlag)
+{
+    *dumpFlag = 0;
+}
+
+int dumpImage(hwc_display_contents_1_t *list)
+{
+    (void)list;
+    return 0;
+}
+
+void countPlanCache(int event, int debugFlag)
+{
+    (void)debugFlag;
+    s_planCount[event]++;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void set_buffers(const struct layerDesc *desc, int count)
+{
+    for (int i = 0; i <= count; i++) {
+        for (int j = 0; j < BUFFER_NUM; j++) {
+            private_handle_t *h = s_buffer[i][j];
+
+            if (i == count) {
+                h->format = RGBA;
+                h->width = FB_WIDTH;
+                h->height = FB_HEIGHT;
+                h->flags = PHY;
+                h->usage = 0;
+            } else {
+                h->format = desc[i].format;
+                h->width = desc[i].width;
+                h->height = desc[i].height;
+                h->flags = desc[i].privFlags;
+                h->usage = desc[i].usage;
+            }
+        }
+    }
+}
+
+static void set_frame(struct frameList *f, const struct layerDesc *desc, int count,
+                      int seq, int geometry)
+{
+    f->contents.numHwLayers = count + 1;
+    f->contents.flags = geometry ? HWC_GEOMETRY_CHANGED : 0;
+
+    for (int i = 0; i < count; i++) {
+        hwc_layer_1_t *l = &f->layers[i];
+
+        if (geometry) {
+            l->compositionType = HWC_FRAMEBUFFER;
+        }
+        l->flags = desc[i].skip ? HWC_SKIP_LAYER : 0;
+        l->handle = (buffer_handle_t)s_buffer[i][(seq + i) % BUFFER_NUM];
+        l->transform = desc[i].transform;
+        l->blending = (i == 0) ? HWC_BLENDING_NONE : HWC_BLENDING_PREMULT;
+        l->planeAlpha = 0xff;
+        l->sourceCropf = desc[i].crop;
+        l->displayFrame = desc[i].frame;
+        l->acquireFenceFd = -1;
+        l->releaseFenceFd = -1;
+    }
+
+    hwc_layer_1_t *t = &f->layers[count];
+    memset(t, 0, sizeof(*t));
+    t->compositionType = HWC_FRAMEBUFFER_TARGET;
+    t->handle = (buffer_handle_t)s_buffer[count][seq % BUFFER_NUM];
+    t->sourceCropf.right = FB_WIDTH;
+    t->sourceCropf.bottom = FB_HEIGHT;
+    t->displayFrame.right = FB_WIDTH;
+    t->displayFrame.bottom = FB_HEIGHT;
+    t->acquireFenceFd = -1;
+    t->releaseFenceFd = -1;
+}
+
+/* SprdPrimaryDisplayDevice::prepare up to attachToDisplayPlane */
+static void prepare(struct run *r, int accelerator, int cached)
+{
+    double t = now_ns();
+
+    r->displayFlag = 0;
+    if (cached == 0 ||
+        r->list->reusePlan(&r->frame.contents, accelerator, &r->displayFlag, &r->primary) != 0) {
+        r->list->updateGeometry(&r->frame.contents, accelerator);
+        r->list->revisitGeometry(&r->displayFlag, &r->primary);
+        if (cached) {
+            r->list->savePlan(accelerator, r->displayFlag);
+        }
+    }
+    r->ns += now_ns() - t;
+}
+
+/* resetOverlayFlag leaves NULL in the OSD and video lists */
+static long layer_slot(SprdHWLayerList *list, SprdHWLayer *l)
+{
+    return l ? (long)(l - list->getSprdLayer(0)) : -1;
+}
+
+static int compare(struct run *a, struct run *b, int count)
+{
+    SprdHWLayerList *x = a->list;
+    SprdHWLayerList *y = b->list;
+
+    if (a->displayFlag != b->displayFlag)
+        return 1;
+    if (x->getOSDLayerCount() != y->getOSDLayerCount() ||
+        x->getVideoLayerCount() != y->getVideoLayerCount() ||
+        x->getFBLayerCount() != y->getFBLayerCount())
+        return 2;
+    if ((x->getFBTargetLayer() - a->frame.layers) != (y->getFBTargetLayer() - b->frame.layers))
+        return 3;
+
+    for (int i = 0; i <= count; i++) {
+        if (a->frame.layers[i].compositionType != b->frame.layers[i].compositionType ||
+            a->frame.layers[i].hints != b->frame.layers[i].hints)
+            return 4;
+    }
+
+    for (int i = 0; i < count; i++) {
+        SprdHWLayer *p = x->getSprdLayer(i);
+        SprdHWLayer *q = y->getSprdLayer(i);
+
+        if (p->getAndroidLayer() != &a->frame.layers[i] ||
+            p->getLayerType() != q->getLayerType() ||
+            p->getLayerFormat() != q->getLayerFormat() ||
+            p->getAccelerator() != q->getAccelerator() ||
+            p->getSprdLayerIndex() != q->getSprdLayerIndex() ||
+            memcmp(p->getSprdSRCRect(), q->getSprdSRCRect(), sizeof(struct sprdRect)) ||
+            memcmp(p->getSprdFBRect(), q->getSprdFBRect(), sizeof(struct sprdRect)))
+            return 5;
+    }
+
+    for (int i = 0; i < x->getOSDLayerCount(); i++) {
+        if (layer_slot(x, x->getSprdOSDLayerList()[i]) !=
+            layer_slot(y, y->getSprdOSDLayerList()[i]))
+            return 6;
+    }
+
+    for (int i = 0; i < x->getVideoLayerCount(); i++) {
+        if (layer_slot(x, x->getSprdVideoLayerList()[i]) !=
+            layer_slot(y, y->getSprdVideoLayerList()[i]))
+            return 6;
+    }
+
+    return 0;
+}
+
+static int frame_step(struct run *a, struct run *b, const struct layerDesc *desc, int count,
+                      int seq, int geometry, int accelerator, const char *name)
+{
+    int ret = 0;
+
+    set_frame(&a->frame, desc, count, seq, geometry);
+    set_frame(&b->frame, desc, count, seq, geometry);
+    prepare(a, accelerator, 1);
+    prepare(b, accelerator, 0);
+
+    ret = compare(a, b, count);
+    if (ret) {
+        printf("%s: frame %d differs (check %d), display flag 0x%x 0x%x\n",
+               name, seq, ret, a->displayFlag, b->displayFlag);
+    }
+
+    return ret;
+}
+
+static int play_scene(struct run *a, struct run *b, const struct scene *s)
+{
+    struct layerDesc desc[MAX_LAYERS];
+    unsigned int hit = s_planCount[HWC_PLAN_CACHE_HIT];
+    unsigned int miss = s_planCount[HWC_PLAN_CACHE_MISS];
+    int accelerator = ACCELERATOR_GSP | ACCELERATOR_OVERLAYCOMPOSER;
+    int geometry = 1;
+    int ev = 0;
+
+    memcpy(desc, s->layer, sizeof(desc));
+    set_buffers(desc, s->count);
+
+    for (int n = 0; n < s->frames; n++) {
+        int event = EV_NONE;
+
+        a->primary.mReclaimFail = false;
+        b->primary.mReclaimFail = false;
+
+        if (s->event[ev][0] != 0 && s->event[ev][0] == n) {
+            event = s->event[ev][1];
+            ev++;
+        }
+
+        switch (event) {
+        case EV_BLANK:
+            a->list->invalidatePlan();
+            break;
+        case EV_ACCEL:
+            accelerator = ACCELERATOR_OVERLAYCOMPOSER;
+            break;
+        case EV_RECLAIM:
+            a->primary.mReclaimFail = true;
+            b->primary.mReclaimFail = true;
+            break;
+        case EV_LOST_PHY:
+            desc[0].privFlags ^= PHY;
+            set_buffers(desc, s->count);
+            break;
+        case EV_CROP:
+            desc[0].crop.left += 16;
+            desc[0].crop.right -= 16;
+            geometry = 1;
+            break;
+        default:
+            break;
+        }
+
+        if (frame_step(a, b, desc, s->count, n, geometry, accelerator, s->name))
+            return -1;
+        geometry = 0;
+    }
+
+    printf("%-10s %d frames, %d layers, plan hit %u miss %u\n", s->name, s->frames,
+           s->count, s_planCount[HWC_PLAN_CACHE_HIT] - hit,
+           s_planCount[HWC_PLAN_CACHE_MISS] - miss);
+
+    return 0;
+}
+
+static void random_desc(struct layerDesc *d)
+{
+    static const int formats[] = {RGBA, RGBX, RGB565, YUV420SP, YV12};
+
+    d->format = formats[rand() % 5];
+    d->width = (rand() % 2) ? FB_WIDTH : 320;
+    d->height = (rand() % 2) ? FB_HEIGHT : 240;
+    d->privFlags = (rand() % 4) ? PHY : 0;
+    d->usage = (rand() % 10) ? 0 : PROTECTED;
+    d->transform = (rand() % 5) ? 0 : HAL_TRANSFORM_ROT_90;
+    d->skip = (rand() % 15) == 0;
+    d->crop.left = 0;
+    d->crop.top = 0;
+    d->crop.right = d->width;
+    d->crop.bottom = d->height;
+    if (rand() % 2) {
+        d->frame.left = 0;
+        d->frame.top = 0;
+        d->frame.right = FB_WIDTH;
+        d->frame.bottom = FB_HEIGHT;
+    } else {
+        d->frame.left = 16;
+        d->frame.top = 32;
+        d->frame.right = 16 + d->width / 2;
+        d->frame.bottom = 32 + d->height / 2;
+    }
+}
+
+static int play_random(struct run *a, struct run *b)
+{
+    struct layerDesc desc[MAX_LAYERS];
+    unsigned int hit = s_planCount[HWC_PLAN_CACHE_HIT];
+    unsigned int miss = s_planCount[HWC_PLAN_CACHE_MISS];
+    int count = 0;
+
+    for (int n = 0; n < RANDOM_STEPS; n++) {
+        int accelerator = ACCELERATOR_GSP | ACCELERATOR_OVERLAYCOMPOSER;
+        int geometry = 0;
+        int r = rand() % 100;
+
+        if (n == 0 || r < 3) {
+            count = 1 + rand() % (MAX_LAYERS - 1);
+            for (int i = 0; i < count; i++) {
+                random_desc(&desc[i]);
+            }
+            set_buffers(desc, count);
+            geometry = 1;
+        } else if (r < 5) {
+            desc[rand() % count].privFlags ^= PHY;
+            set_buffers(desc, count);
+        } else if (r < 6) {
+            desc[rand() % count].crop.right -= 2;
+            geometry = 1;
+        }
+
+        if (rand() % 200 == 0) {
+            a->list->invalidatePlan();
+        }
+        if ((n / 1000) % 5 == 4) {
+            accelerator = ACCELERATOR_OVERLAYCOMPOSER;
+        }
+        a->primary.mReclaimFail = (rand() % 50) == 0;
+        b->primary.mReclaimFail = a->primary.mReclaimFail;
+
+        if (frame_step(a, b, desc, count, n, geometry, accelerator, "random"))
+            return -1;
+    }
+
+    printf("%-10s %d frames, plan hit %u miss %u\n", "random", RANDOM_STEPS,
+           s_planCount[HWC_PLAN_CACHE_HIT] - hit, s_planCount[HWC_PLAN_CACHE_MISS] - miss);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct run *a = new struct run;
+    struct run *b = new struct run;
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    unsigned int frames = RANDOM_STEPS;
+    int ret = 0;
+
+    memset(&s_fbInfo, 0, sizeof(s_fbInfo));
+    s_fbInfo.fb_width = FB_WIDTH;
+    s_fbInfo.fb_height = FB_HEIGHT;
+    s_fbInfo.format = RGBA;
+
+    /* GSP capability of the sc8830 */
+    s_gspCap.max_layer_cnt = 2;
+    s_gspCap.max_layer_cnt_with_video = 2;
+    s_gspCap.max_videoLayer_cnt = 1;
+    s_gspCap.blend_video_with_OSD = 1;
+    s_gspCap.yuv_xywh_even = 1;
+    s_gspCap.scale_range_up = 64;
+    s_gspCap.scale_range_down = 16;
+    s_gspCap.scale_updown_sametime = 1;
+    s_gspCap.OSD_scaling = 0;
+    s_gspCap.max_video_size = 1;
+    s_gspCap.crop_min.w = s_gspCap.crop_min.h = 4;
+    s_gspCap.crop_max.w = s_gspCap.crop_max.h = 4096;
+    s_gspCap.out_min.w = s_gspCap.out_min.h = 4;
+    s_gspCap.out_max.w = s_gspCap.out_max.h = 4096;
+
+    for (int i = 0; i <= MAX_LAYERS; i++) {
+        for (int j = 0; j < BUFFER_NUM; j++) {
+            s_buffer[i][j] = new private_handle_t(0, 0, 0, NULL, 0);
+        }
+    }
+
+    a->list = new SprdHWLayerList(&s_fbInfo);
+    b->list = new SprdHWLayerList(&s_fbInfo);
+    a->list->transforGXPCapParameters(&s_gspCap);
+    b->list->transforGXPCapParameters(&s_gspCap);
+    a->ns = 0;
+    b->ns = 0;
+
+    srand(seed);
+    printf("utest_hwc_plan -- %dx%d, seed %u\n", FB_WIDTH, FB_HEIGHT, seed);
+
+    for (unsigned int i = 0; i < sizeof(s_scene) / sizeof(s_scene[0]); i++) {
+        frames += s_scene[i].frames;
+        ret = play_scene(a, b, &s_scene[i]);
+        if (ret)
+            break;
+    }
+
+    if (ret == 0) {
+        ret = play_random(a, b);
+    }
+
+    if (ret == 0) {
+        printf("prepare    cached %.0f ns, uncached %.0f ns per frame, plane buffer reclaim %u %u\n",
+               a->ns / frames, b->ns / frames, a->primary.mReclaimCount, b->primary.mReclaimCount);
+        printf("OK\n");
+    } else {
+        printf("FAIL\n");
+    }
+
+    delete a->list;
+    delete b->list;
+    delete a;
+    delete b;
+    for (int i = 0; i <= MAX_LAYERS; i++) {
+        for (int j = 0; j < BUFFER_NUM; j++) {
+            delete s_buffer[i][j];
+        }
+    }
+
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Force included ahead of the hwcomposer sources of utest_hwc_plan.
+ * SprdHWLayerList.cpp is built alone on the host, so the headers that
+ * pull in the display devices, the kernel fb and GSP headers and the
+ * binder are kept out by their guards and the few names the layer list
+ * uses are given here.
+ */
+#ifndef _UTEST_HWC_PLAN_H_
+#define _UTEST_HWC_PLAN_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cutils/log.h>
+#include <cutils/properties.h>
+#include <hardware/hardware.h>
+#include <hardware/gralloc.h>
+#include <hardware/hwcomposer.h>
+
+#define _SPRD_UTIL_H_
+#define _SPRD_PRIMARY_DISPLAY_DEVICE_H_
+#define _SPRD_FRAME_BUFFER_HAL_H_
+#define _DUMP_HWCOMPOSER_BMP_H_
+#define _GSP_HAL_H_
+
+#ifdef __cplusplus
+
+/* SprdUtil.h */
+#define ACCELERATOR_NON              (0x00000000)
+#define ACCELERATOR_GSP              (0x00000001)
+#define ACCELERATOR_GSP_IOMMU        (0x00000010)
+#define ACCELERATOR_OVERLAYCOMPOSER  (0x00000100)
+#define ACCELERATOR_DCAM             (0x00001000)
+
+#ifndef ALIGN
+#define ALIGN(value, base) (((value) + ((base) - 1)) & ~((base) - 1))
+#endif
+
+/* gsp_types_shark.h, the fields the layer list reads */
+typedef struct {
+    uint32_t w;
+    uint32_t h;
+} GSP_RECT_SIZE_T;
+
+typedef struct {
+    uint32_t max_layer_cnt;
+    uint32_t max_layer_cnt_with_video;
+    uint32_t max_videoLayer_cnt;
+    uint32_t blend_video_with_OSD;
+    uint32_t yuv_xywh_even;
+    uint32_t scale_range_up;
+    uint32_t scale_range_down;
+    uint32_t scale_updown_sametime;
+    uint32_t OSD_scaling;
+    uint32_t max_video_size;
+    GSP_RECT_SIZE_T crop_min;
+    GSP_RECT_SIZE_T crop_max;
+    GSP_RECT_SIZE_T out_min;
+    GSP_RECT_SIZE_T out_max;
+} GSP_CAPABILITY_T;
+
+/* SprdFrameBufferHAL.h */
+#define HWC_DISPLAY_MASK                  (0x00000000)
+#define HWC_DISPLAY_FRAMEBUFFER_TARGET    (0x00000001)
+#define HWC_DISPLAY_PRIMARY_PLANE         (0x00000010)
+#define HWC_DISPLAY_OVERLAY_PLANE         (0x00000100)
+#define HWC_DISPLAY_OVERLAY_COMPOSER_GPU  (0x00001000)
+#define HWC_DISPLAY_OVERLAY_COMPOSER_GSP  (0x00010000)
+
+typedef struct _FrameBufferInfo {
+    int fbfd;
+    int fb_width;
+    int fb_height;
+    float xdpi;
+    float ydpi;
+    int stride;
+    void *fb_virt_addr;
+    char *pFrontAddr;
+    char *pBackAddr;
+    int format;
+    framebuffer_device_t* fbDev;
+} FrameBufferInfo;
+
+/* dump.h */
+#define HWCOMPOSER_DUMP_ORIGINAL_LAYERS 0x1
+
+typedef enum
+{
+    HWC_PLAN_CACHE_HIT,
+    HWC_PLAN_CACHE_MISS,
+    HWC_PLAN_CACHE_INVALIDATE,
+    HWC_PLAN_CACHE_EVENT_MAX
+} plan_cache_event;
+
+extern void queryDebugFlag(int *debugFlag);
+extern void queryDumpFlag(int *dumpFlag);
+extern int dumpImage(hwc_display_contents_1_t *list);
+extern void countPlanCache(int event, int debugFlag);
+
+/* SprdPrimaryDisplayDevice.h, only the plane buffer reclaim */
+class SprdPrimaryDisplayDevice
+{
+public:
+    SprdPrimaryDisplayDevice()
+        : mReclaimFail(false), mReclaimCount(0)
+    {
+    }
+
+    int reclaimPlaneBuffer(bool condition)
+    {
+        (void)condition;
+        mReclaimCount++;
+        return mReclaimFail ? 1 : 0;
+    }
+
+    bool mReclaimFail;
+    unsigned int mReclaimCount;
+};
+
+#endif
+
+#endif
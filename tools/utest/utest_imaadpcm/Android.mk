@@ -0,0 +1,13 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_imaadpcm
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/omx_components/audio/imaadpcm/common \
+	$(LOCAL_PATH)/../../../libs/libstagefrighthw/include
+LOCAL_SRC_FILES:= utest_imaadpcm.cpp \
+	../../../libs/omx_components/audio/imaadpcm/common/ImaAdpcm.cpp \
+	../../../libs/libstagefrighthw/SprdWorkerPool.cpp
+LOCAL_STATIC_LIBRARIES:= libutils libcutils liblog
+LOCAL_LDLIBS:= -lrt -lpthread
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "ImaAdpcm.h"
+#include "SprdWorkerPool.h"
+
+using namespace android;
+
+#define BANDS               2
+#define BENCH_SECONDS       60
+#define BENCH_RATE          44100
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/*
+ *  The decoder SoftIMAADPCM had before the table, as it was: a nibble a
+ *  call, a bit loop and two clamps a sample.
+ * */
+
+/* First table lookup for Ima-ADPCM quantizer */
+static const int8_t IndexAdjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/* Second table lookup for Ima-ADPCM quantizer */
+static const short StepSize[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+typedef struct _ima_adpcm_state {
+	int pred_val;		/* Calculated predicted value */
+	int step_idx;		/* Previous StepSize lookup index */
+} ima_adpcm_state_t;
+
+static int adpcm_decoder(unsigned char code, ima_adpcm_state_t * state)
+{
+	short pred_diff;	/* Predicted difference to next sample */
+	short step;		/* holds previous StepSize value */
+	char sign;
+
+	int i;
+
+	/* Separate sign and magnitude */
+	sign = code & 0x8;
+	code &= 0x7;
+
+	step = StepSize[state->step_idx];
+
+	/* Compute difference and new predicted value */
+	pred_diff = step >> 3;
+	for (i = 0x4; i; i >>= 1, step >>= 1) {
+		if (code & i) {
+			pred_diff += step;
+		}
+	}
+	state->pred_val += (sign) ? -pred_diff : pred_diff;
+
+	/* Clamp output value */
+	if (state->pred_val > 32767) {
+		state->pred_val = 32767;
+	} else if (state->pred_val < -32768) {
+		state->pred_val = -32768;
+	}
+
+	/* Find new StepSize index value */
+	state->step_idx += IndexAdjust[code];
+
+	if (state->step_idx < 0) {
+		state->step_idx = 0;
+	} else if (state->step_idx > 88) {
+		state->step_idx = 88;
+	}
+	return (state->pred_val);
+}
+
+static void _adpcm_decode_mono(int16_t *dst_ptr,
+			  int dst_step,
+			  const uint8_t *src_ptr,
+			  unsigned int frames,
+			  ima_adpcm_state_t *states)
+{
+    int srcbit = 0;
+	while (frames-- > 0) {
+		unsigned char v;
+		if (!srcbit)
+			v = *src_ptr & 0x0f;
+		else
+			v = (*src_ptr >> 4) & 0x0f;
+		*dst_ptr = adpcm_decoder(v, states);
+		srcbit ++;
+		if (srcbit == 2) {
+			src_ptr++;
+			srcbit = 0;
+		}
+		dst_ptr += dst_step;
+	}
+}
+
+static void legacy_decode(int16_t *out, const uint8_t *src_frame_ptr, int channels, size_t inSize)
+{
+    int frames = ((inSize / channels - 4) << 1) + 1;
+    ima_adpcm_state_t state[2];
+    int16_t *dst_ptr[2];
+    int i;
+
+    for (i=0; i<channels; i++)
+    {
+        state[i].pred_val = ((int16_t)(src_frame_ptr[0] | (src_frame_ptr[1]<<8)));
+        src_frame_ptr+=2;
+        state[i].step_idx = *src_frame_ptr;
+        src_frame_ptr+=2;
+        dst_ptr[i] = out + i;
+        *dst_ptr[i] = state[i].pred_val;
+        dst_ptr[i] += channels;
+    }
+    frames --;
+    while (frames>0)
+    {
+        for (i=0; i<channels; i++)
+        {
+            int decoded_fremes = frames > 8 ? 8 : frames;
+            _adpcm_decode_mono(dst_ptr[i],
+                      channels,
+                      src_frame_ptr,
+                      decoded_fremes,
+                      &state[i]);
+            src_frame_ptr += 4;
+            dst_ptr[i] += 8*channels;
+        }
+        frames -= 8;
+    }
+}
+
+/*
+ *  Random blocks: a random sample and step index in every header, random
+ *  codes. Runs of large codes drive the step index to the top, where
+ *  the reference decoder's shorts wrap.
+ * */
+static void random_blocks(uint8_t *buf, int channels, size_t blockAlign, int blocks)
+{
+    for (int b = 0; b < blocks; b++) {
+        uint8_t *p = buf + b * blockAlign;
+        int loud = rnd() % 3 == 0;
+
+        for (size_t i = 0; i < blockAlign; i++)
+            p[i] = loud ? (0x77 | (rnd() & 0x88)) : rnd();
+        for (int ch = 0; ch < channels; ch++) {
+            p[ch * 4 + 2] = rnd() % 89;
+            p[ch * 4 + 3] = 0;
+        }
+    }
+}
+
+static int compare(const int16_t *a, const int16_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (a[i] != b[i])
+            return 1;
+    return 0;
+}
+
+/*
+ *  The table decoder against the reference decoder on random blocks of
+ *  the usual sizes and of sizes not a whole number of groups.
+ * */
+static int test_decode(void)
+{
+    static const struct {
+        int channels;
+        size_t blockAlign;
+    } s_formats[] = {
+        { 1, 256 }, { 1, 512 }, { 1, 1024 }, { 1, 2048 },
+        { 2, 512 }, { 2, 1024 }, { 2, 2048 },
+        { 1, 254 }, { 1, 1023 }, { 1, 9 }, { 2, 1016 },
+    };
+    int errors = 0;
+
+    for (size_t f = 0; f < sizeof(s_formats) / sizeof(s_formats[0]); f++) {
+        int channels = s_formats[f].channels;
+        size_t blockAlign = s_formats[f].blockAlign;
+        size_t samples = ImaAdpcm::blockSamples(blockAlign, channels) * channels;
+        /* the reference reads up to 4 bytes past a partial last group */
+        uint8_t *in = (uint8_t *)malloc(blockAlign + 8);
+        int16_t *ref = (int16_t *)malloc(samples * sizeof(int16_t));
+        int16_t *out = (int16_t *)malloc(samples * sizeof(int16_t));
+        int bad = 0;
+
+        for (int b = 0; b < 2000; b++) {
+            random_blocks(in, channels, blockAlign, 1);
+            memset(in + blockAlign, 0, 8);
+            legacy_decode(ref, in, channels, blockAlign);
+            ImaAdpcm::decodeBlock(out, in, channels, blockAlign);
+            bad += compare(ref, out, samples);
+        }
+
+        printf("decode %d ch, block %4u: 2000 blocks, %d differ\n",
+               channels, (unsigned)blockAlign, bad);
+        errors += bad;
+
+        free(in);
+        free(ref);
+        free(out);
+    }
+
+    return errors;
+}
+
+/*
+ *  PCM: a sine sweep up to a quarter of the rate with some noise, every
+ *  fourth second a full scale square wave.
+ * */
+static int is_square(size_t i, int rate)
+{
+    return (i / rate) % 4 == 3;
+}
+
+static void make_pcm(int16_t *pcm, int channels, size_t frames, int rate)
+{
+    double phase = 0;
+
+    for (size_t i = 0; i < frames; i++) {
+        double f = 100 + (rate / 4 - 100.0) * i / frames;
+        int square = is_square(i, rate);
+
+        phase += 2 * M_PI * f / rate;
+        for (int ch = 0; ch < channels; ch++) {
+            int v;
+            if (square)
+                v = ((i / (20 + 10 * ch)) & 1) ? 32767 : -32768;
+            else
+                v = (int)(12000 * sin(phase + ch) + (int)(rnd() % 2001) - 1000);
+            pcm[i * channels + ch] = v;
+        }
+    }
+}
+
+/*
+ *  The encoder's blocks decode the same with both decoders, and the sweep
+ *  comes back close to the input. The square wave only has to survive.
+ * */
+static int test_encode(void)
+{
+    static const struct {
+        int channels;
+        int rate;
+        size_t blockAlign;
+    } s_formats[] = {
+        { 1, 8000, 256 }, { 1, 22050, 512 }, { 2, 44100, 2048 }, { 2, 48000, 4096 },
+    };
+    int errors = 0;
+
+    for (size_t f = 0; f < sizeof(s_formats) / sizeof(s_formats[0]); f++) {
+        int channels = s_formats[f].channels;
+        size_t blockAlign = s_formats[f].blockAlign;
+        size_t frames = ImaAdpcm::blockSamples(blockAlign, channels);
+        int blocks = s_formats[f].rate * 8 / frames;
+        int16_t *pcm = (int16_t *)malloc(blocks * frames * channels * sizeof(int16_t));
+        int16_t *ref = (int16_t *)malloc(frames * channels * sizeof(int16_t));
+        int16_t *out = (int16_t *)malloc(frames * channels * sizeof(int16_t));
+        uint8_t *block = (uint8_t *)malloc(blockAlign);
+        int stepIndex[2] = { 0, 0 };
+        double signal = 0, noise = 0;
+        int bad = 0;
+
+        make_pcm(pcm, channels, blocks * frames, s_formats[f].rate);
+        for (int b = 0; b < blocks; b++) {
+            const int16_t *in = pcm + b * frames * channels;
+
+            ImaAdpcm::encodeBlock(block, in, channels, blockAlign, stepIndex);
+            legacy_decode(ref, block, channels, blockAlign);
+            ImaAdpcm::decodeBlock(out, block, channels, blockAlign);
+            bad += compare(ref, out, frames * channels);
+
+            for (size_t i = 0; i < frames * channels; i++) {
+                double d = out[i] - in[i];
+
+                if (is_square(b * frames + i / channels, s_formats[f].rate))
+                    continue;
+                signal += (double)in[i] * in[i];
+                noise += d * d;
+            }
+        }
+
+        double snr = 10 * log10(signal / (noise + 1));
+        printf("encode %d ch, %5d Hz, block %4u: %4d blocks, %d differ, sweep snr %4.1f dB\n",
+               channels, s_formats[f].rate, (unsigned)blockAlign, blocks, bad, snr);
+        errors += bad;
+        if (snr < 20)
+            errors++;
+
+        free(pcm);
+        free(ref);
+        free(out);
+        free(block);
+    }
+
+    return errors;
+}
+
+/*
+ *  A buffer of blocks decoded a share of its blocks per band, as
+ *  SoftIMAADPCM does.
+ * */
+struct decode_job {
+    int16_t *out;
+    const uint8_t *in;
+    int channels;
+    size_t blockAlign;
+    size_t blockSamples;
+    size_t blocks;
+};
+
+static void decode_band(void *job, int band, int bands)
+{
+    struct decode_job *j = (struct decode_job *)job;
+    size_t first = j->blocks * band / bands;
+    size_t last = j->blocks * (band + 1) / bands;
+
+    for (size_t i = first; i < last; i++)
+        ImaAdpcm::decodeBlock(j->out + i * j->blockSamples * j->channels,
+                              j->in + i * j->blockAlign, j->channels, j->blockAlign);
+}
+
+/*
+ *  A minute of 44.1 kHz stereo in buffers of 128 blocks of 2048 bytes,
+ *  decoded by the reference decoder, the table decoder and the table
+ *  decoder in the pool, and encoded.
+ * */
+static int test_bench(SprdWorkerPool *pool)
+{
+    const int channels = 2;
+    const size_t blockAlign = 2048;
+    const size_t frames = ImaAdpcm::blockSamples(blockAlign, channels);
+    const int perBuffer = 128;
+    const int buffers = (BENCH_SECONDS * BENCH_RATE / frames + perBuffer - 1) / perBuffer;
+    size_t samples = perBuffer * frames * channels;
+    uint8_t *in = (uint8_t *)malloc(perBuffer * blockAlign);
+    int16_t *ref = (int16_t *)malloc(samples * sizeof(int16_t));
+    int16_t *out = (int16_t *)malloc(samples * sizeof(int16_t));
+    int16_t *pcm = (int16_t *)malloc(samples * sizeof(int16_t));
+    int64_t t, legacy = 0, table = 0, pooled = 0, encode = 0;
+    int stepIndex[2] = { 0, 0 };
+    int errors = 0;
+
+    make_pcm(pcm, channels, perBuffer * frames, BENCH_RATE);
+
+    for (int n = 0; n < buffers; n++) {
+        struct decode_job job;
+
+        t = now_ns();
+        for (int b = 0; b < perBuffer; b++)
+            ImaAdpcm::encodeBlock(in + b * blockAlign, pcm + b * frames * channels,
+                                  channels, blockAlign, stepIndex);
+        encode += now_ns() - t;
+
+        t = now_ns();
+        for (int b = 0; b < perBuffer; b++)
+            legacy_decode(ref + b * frames * channels, in + b * blockAlign, channels, blockAlign);
+        legacy += now_ns() - t;
+
+        job.out = out;
+        job.in = in;
+        job.channels = channels;
+        job.blockAlign = blockAlign;
+        job.blockSamples = frames;
+        job.blocks = perBuffer;
+
+        t = now_ns();
+        decode_band(&job, 0, 1);
+        table += now_ns() - t;
+        errors += compare(ref, out, samples);
+
+        memset(out, 0, samples * sizeof(int16_t));
+        t = now_ns();
+        pool->fork(decode_band, &job);
+        pool->join();
+        pooled += now_ns() - t;
+        errors += compare(ref, out, samples);
+    }
+
+    double audio = (double)buffers * perBuffer * frames / BENCH_RATE;
+    printf("bench %d s of %d Hz stereo, block %u, %d blocks a buffer:\n",
+           (int)(audio + 0.5), BENCH_RATE, (unsigned)blockAlign, perBuffer);
+    printf("  reference decode %7.1f ms, %6.0fx realtime\n", legacy / 1e6, audio * 1e9 / legacy);
+    printf("  table decode     %7.1f ms, %6.0fx realtime\n", table / 1e6, audio * 1e9 / table);
+    printf("  table decode x%d  %7.1f ms, %6.0fx realtime\n", pool->bands(), pooled / 1e6,
+           audio * 1e9 / pooled);
+    printf("  encode           %7.1f ms, %6.0fx realtime\n", encode / 1e6, audio * 1e9 / encode);
+    printf("bench: %d buffers differ\n", errors);
+
+    free(in);
+    free(ref);
+    free(out);
+    free(pcm);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int errors = 0;
+
+    if (argc > 1)
+        s_seed = strtoul(argv[1], NULL, 0);
+
+    printf("utest_imaadpcm -- seed %u\n", s_seed);
+
+    errors += test_decode();
+    errors += test_encode();
+
+    SprdWorkerPool *pool = new SprdWorkerPool("imaadpcmdec", BANDS, 0);
+    errors += test_bench(pool);
+    delete pool;
+
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
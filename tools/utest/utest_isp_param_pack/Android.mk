@@ -0,0 +1,17 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_isp_param_pack
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS += -include stdint.h \
+	-DISP_PARAM_PACK_NAME=\"imx219\" \
+	-DISP_PARAM_PACK_SRC=\"sensor_imx219_raw_param.c\" \
+	-DISP_PARAM_PACK_TAB=s_imx219 \
+	-DISP_PARAM_PACK_INFO=s_imx219_mipi_raw_info
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../isp_param_pack \
+	$(LOCAL_PATH)/../../../libs/libcamera/isp1.0/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/sensor
+LOCAL_SRC_FILES:= utest_isp_param_pack.c \
+	../../../libs/libcamera/isp1.0/isp_param_pack.c
+LOCAL_LDLIBS:= -lrt
+include $(BUILD_HOST_EXECUTABLE)
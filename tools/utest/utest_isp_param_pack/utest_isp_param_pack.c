@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "isp_param_pack_sensor.h"
+
+#define LOAD_LOOPS      2000
+#define RANDOM_ROUNDS   20000
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int same(const void *a, const void *b, uint32_t size)
+{
+	if (!a || !b)
+		return a == b;
+	return !memcmp(a, b, size);
+}
+
+/* every value and table the isp init reads through the fix and tune
+ * pointers is the one of the compiled tables */
+static int check_pack(const struct isp_param_pack *pack, const struct sensor_raw_info *info,
+		const struct isp_param_pack_len *len)
+{
+	const struct sensor_raw_fix_info *fix = info->fix_ptr;
+	const struct sensor_raw_fix_info *pfix = &pack->fix;
+	uint32_t i, j;
+
+	if (!same(pack->tune_ptr, info->tune_ptr, sizeof(struct sensor_raw_tune_info)))
+		return printf("tune differs\n"), -1;
+	if (pack->raw_version_id != info->version_info->version_id)
+		return printf("raw version differs\n"), -1;
+
+	if (pack->len.ae_weight != len->ae_weight
+		|| !same(pfix->ae.weight_tab, fix->ae.weight_tab, len->ae_weight))
+		return printf("ae weight differs\n"), -1;
+	for (i = 0; i < SENSOR_AE_TAB_NUM; i++) {
+		if (memcmp(pfix->ae.tab[i].index, fix->ae.tab[i].index, sizeof(fix->ae.tab[i].index))
+			|| pack->len.ae_e[i] != len->ae_e[i]
+			|| pack->len.ae_g[i] != len->ae_g[i]
+			|| !same(pfix->ae.tab[i].e_ptr, fix->ae.tab[i].e_ptr, len->ae_e[i])
+			|| !same(pfix->ae.tab[i].g_ptr, fix->ae.tab[i].g_ptr, len->ae_g[i]))
+			return printf("ae tab %u differs\n", i), -1;
+	}
+
+	for (i = 0; i < SENSOR_MAP_NUM; i++) {
+		for (j = 0; j < SENSOR_AWB_CALI_NUM; j++) {
+			const struct sensor_lnc_map_addr *a = &pfix->lnc.map[i][j];
+			const struct sensor_lnc_map_addr *b = &fix->lnc.map[i][j];
+
+			if (a->grid != b->grid
+				|| (b->param_addr && a->len != b->len)
+				|| !same(a->param_addr, b->param_addr, b->len))
+				return printf("lnc %u %u differs\n", i, j), -1;
+		}
+	}
+
+	if (pfix->awb.len != fix->awb.len
+		|| pack->len.awb_map != (fix->awb.addr ? len->awb_map : 0)
+		|| !same(pfix->awb.addr, fix->awb.addr, len->awb_map))
+		return printf("awb map differs\n"), -1;
+	if (pfix->awb_weight.width != fix->awb_weight.width
+		|| pfix->awb_weight.height != fix->awb_weight.height
+		|| !same(pfix->awb_weight.addr, fix->awb_weight.addr,
+			fix->awb_weight.width * fix->awb_weight.height))
+		return printf("awb weight differs\n"), -1;
+	return 0;
+}
+
+static int in_pack(const struct isp_param_pack *pack, const void *p, uint32_t size)
+{
+	const uint8_t *base = pack->addr;
+
+	if (!p)
+		return 1;
+	return (const uint8_t *)p >= base && size <= pack->size
+		&& (const uint8_t *)p - base <= (long)(pack->size - size);
+}
+
+/* a pack that parses never points outside itself */
+static int check_bounds(const struct isp_param_pack *pack)
+{
+	const struct sensor_raw_fix_info *fix = &pack->fix;
+	uint32_t i, j;
+
+	if (!in_pack(pack, pack->tune_ptr, sizeof(struct sensor_raw_tune_info))
+		|| !in_pack(pack, fix->ae.weight_tab, pack->len.ae_weight)
+		|| !in_pack(pack, fix->awb.addr, pack->len.awb_map)
+		|| (fix->awb.addr && fix->awb.len > pack->len.awb_map)
+		|| !in_pack(pack, fix->awb_weight.addr, fix->awb_weight.width * fix->awb_weight.height))
+		return -1;
+	for (i = 0; i < SENSOR_AE_TAB_NUM; i++) {
+		if (!in_pack(pack, fix->ae.tab[i].e_ptr, pack->len.ae_e[i])
+			|| !in_pack(pack, fix->ae.tab[i].g_ptr, pack->len.ae_g[i]))
+			return -1;
+	}
+	for (i = 0; i < SENSOR_MAP_NUM; i++) {
+		for (j = 0; j < SENSOR_AWB_CALI_NUM; j++) {
+			if (!in_pack(pack, fix->lnc.map[i][j].param_addr, fix->lnc.map[i][j].len))
+				return -1;
+		}
+	}
+	return 0;
+}
+
+/* the compiled bytes a pack replaces, each table once */
+static uint32_t compiled_size(const struct sensor_raw_info *info, const struct isp_param_pack_len *len)
+{
+	const struct sensor_raw_fix_info *fix = info->fix_ptr;
+	const void *seen[ISP_PARAM_PACK_SEC_MAX];
+	const void *p[ISP_PARAM_PACK_SEC_MAX];
+	uint32_t n[ISP_PARAM_PACK_SEC_MAX];
+	uint32_t num = 0, seen_num = 0, total = 0, i, j;
+
+	p[num] = info->tune_ptr; n[num++] = sizeof(struct sensor_raw_tune_info);
+	p[num] = fix->ae.weight_tab; n[num++] = len->ae_weight;
+	for (i = 0; i < SENSOR_AE_TAB_NUM; i++) {
+		p[num] = fix->ae.tab[i].e_ptr; n[num++] = len->ae_e[i];
+		p[num] = fix->ae.tab[i].g_ptr; n[num++] = len->ae_g[i];
+	}
+	for (i = 0; i < SENSOR_MAP_NUM; i++) {
+		for (j = 0; j < SENSOR_AWB_CALI_NUM; j++) {
+			p[num] = fix->lnc.map[i][j].param_addr; n[num++] = fix->lnc.map[i][j].len;
+		}
+	}
+	p[num] = fix->awb.addr; n[num++] = len->awb_map;
+	p[num] = fix->awb_weight.addr; n[num++] = fix->awb_weight.width * fix->awb_weight.height;
+
+	for (i = 0; i < num; i++) {
+		if (!p[i])
+			continue;
+		for (j = 0; j < seen_num && seen[j] != p[i]; j++)
+			;
+		if (j < seen_num)
+			continue;
+		seen[seen_num++] = p[i];
+		total += n[i];
+	}
+	return total + sizeof(struct sensor_raw_fix_info);
+}
+
+/* Rss and Private_Dirty of the mapping at addr, the pages this process
+ * has touched and the ones it has copied */
+static int mapping_kb(void *addr, uint32_t *rss, uint32_t *dirty)
+{
+	unsigned long start, end;
+	char line[256];
+	int found = 0;
+	FILE *fp = fopen("/proc/self/smaps", "r");
+
+	*rss = *dirty = 0;
+	if (!fp)
+		return -1;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+			if (found)
+				break;
+			found = start == (unsigned long)addr;
+		} else if (found) {
+			sscanf(line, "Rss: %u kB", rss);
+			sscanf(line, "Private_Dirty: %u kB", dirty);
+		}
+	}
+	fclose(fp);
+	return found ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	struct sensor_raw_info *info = pack_sensor_info();
+	struct isp_param_pack_len len;
+	struct isp_param_pack pack;
+	char file_name[] = "utest_isp_param_packXXXXXX";
+	struct isp_param_pack_head *head;
+	struct isp_param_pack_sec *sec;
+	unsigned int seed = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+	uint8_t *buf, *bad;
+	uint32_t size, i, parsed = 0;
+	long long t0, t_load;
+	uint32_t rss_load, dirty_load, rss_tune, dirty_tune;
+	FILE *fp;
+	int fd;
+
+	srand(seed);
+	printf("utest_isp_param_pack -- %s, seed %u\n", ISP_PARAM_PACK_NAME, seed);
+
+	if (pack_sensor_len(&len)) {
+		printf("FAIL ae table lengths\n");
+		return 1;
+	}
+
+	size = isp_param_pack_write(info, &len, ISP_PARAM_PACK_NAME, NULL, 0);
+	buf = malloc(size);
+	bad = malloc(size);
+	if (!size || !buf || !bad
+		|| isp_param_pack_write(info, &len, ISP_PARAM_PACK_NAME, buf, size - 1)
+		|| size != isp_param_pack_write(info, &len, ISP_PARAM_PACK_NAME, buf, size)) {
+		printf("FAIL write\n");
+		return 1;
+	}
+	head = (struct isp_param_pack_head *)buf;
+	sec = (struct isp_param_pack_sec *)(head + 1);
+
+	/* in memory */
+	if (isp_param_pack_parse(buf, size, ISP_PARAM_PACK_NAME, &pack)
+		|| check_pack(&pack, info, &len) || check_bounds(&pack)) {
+		printf("FAIL round trip\n");
+		return 1;
+	}
+	for (i = 0; i < head->sec_num; i++) {
+		if (sec[i].offset & (ISP_PARAM_PACK_ALIGN - 1)) {
+			printf("FAIL section %u not aligned\n", i);
+			return 1;
+		}
+	}
+	if (!isp_param_pack_parse(buf, size, "other", &pack)
+		|| isp_param_pack_parse(buf, size, NULL, &pack)) {
+		printf("FAIL name check\n");
+		return 1;
+	}
+	printf("round trip   %u sections, identical to the compiled tables\n", head->sec_num);
+
+	/* broken packs are refused */
+	for (i = 0; i < size; i += (i < 4096 ? 1 : 997)) {
+		if (!isp_param_pack_parse(buf, i, NULL, &pack)) {
+			printf("FAIL truncated to %u parses\n", i);
+			return 1;
+		}
+	}
+	memcpy(bad, buf, size);
+	((struct isp_param_pack_head *)bad)->magic ^= 1;
+	if (!isp_param_pack_parse(bad, size, NULL, &pack)) {
+		printf("FAIL magic\n");
+		return 1;
+	}
+	memcpy(bad, buf, size);
+	((struct isp_param_pack_head *)bad)->version += 1 << 16;
+	if (!isp_param_pack_parse(bad, size, NULL, &pack)) {
+		printf("FAIL version\n");
+		return 1;
+	}
+	memcpy(bad, buf, size);
+	((struct isp_param_pack_head *)bad)->version += 1;
+	if (isp_param_pack_parse(bad, size, NULL, &pack)) {
+		printf("FAIL minor version\n");
+		return 1;
+	}
+	memcpy(bad, buf, size);
+	((struct isp_param_pack_head *)bad)->tune_size -= 4;
+	if (!isp_param_pack_parse(bad, size, NULL, &pack)) {
+		printf("FAIL tune size\n");
+		return 1;
+	}
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		uint32_t at = rand() % (sizeof(*head) + head->sec_num * sizeof(*sec));
+
+		memcpy(bad, buf, size);
+		bad[at] ^= 1 << (rand() % 8);
+		if (rand() & 1)
+			bad[rand() % (sizeof(*head) + head->sec_num * sizeof(*sec))] = rand();
+		if (!isp_param_pack_parse(bad, size, NULL, &pack)) {
+			parsed++;
+			if (check_bounds(&pack)) {
+				printf("FAIL corrupt pack points outside itself\n");
+				return 1;
+			}
+		}
+	}
+	printf("corrupt      refused or inside the pack, %u of %u still parse\n", parsed, RANDOM_ROUNDS);
+
+	/* mapped from a file */
+	fd = mkstemp(file_name);
+	fp = fd < 0 ? NULL : fdopen(fd, "wb");
+	if (!fp || fwrite(buf, 1, size, fp) != size || fflush(fp) || fsync(fd) || fclose(fp)) {
+		printf("FAIL can not write %s\n", file_name);
+		return 1;
+	}
+
+	t0 = now_ns();
+	for (i = 0; i < LOAD_LOOPS; i++) {
+		if (isp_param_pack_map(file_name, ISP_PARAM_PACK_NAME, &pack)) {
+			printf("FAIL map\n");
+			unlink(file_name);
+			return 1;
+		}
+		isp_param_pack_unmap(&pack);
+	}
+	t_load = (now_ns() - t0) / LOAD_LOOPS;
+
+	if (isp_param_pack_map(file_name, ISP_PARAM_PACK_NAME, &pack)) {
+		printf("FAIL map\n");
+		unlink(file_name);
+		return 1;
+	}
+	mapping_kb(pack.addr, &rss_load, &dirty_load);
+	if (check_pack(&pack, info, &len) || check_bounds(&pack)) {
+		printf("FAIL mapped round trip\n");
+		unlink(file_name);
+		return 1;
+	}
+
+	/* the drivers write into the tune, the file keeps the tuning */
+	memset(pack.tune_ptr, 0xff, sizeof(struct sensor_raw_tune_info));
+	mapping_kb(pack.addr, &rss_tune, &dirty_tune);
+	isp_param_pack_unmap(&pack);
+	if (isp_param_pack_map(file_name, ISP_PARAM_PACK_NAME, &pack)
+		|| check_pack(&pack, info, &len)) {
+		printf("FAIL written tune reached the file\n");
+		unlink(file_name);
+		return 1;
+	}
+	isp_param_pack_unmap(&pack);
+	unlink(file_name);
+	printf("mapped       identical to the compiled tables, the tune is copy on write\n");
+
+	printf("compiled     %u KB of tables and fix info in the library data\n",
+		compiled_size(info, &len) / 1024);
+	printf("pack         %u KB, after load %u KB resident %u KB dirty,"
+		" after the tune is written %u KB resident %u KB dirty\n",
+		size / 1024, rss_load, dirty_load, rss_tune, dirty_tune);
+	printf("load         %lld us to map and parse\n", t_load / 1000);
+
+	free(buf);
+	free(bad);
+	printf("OK\n");
+	return 0;
+}
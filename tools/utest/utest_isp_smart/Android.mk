@@ -0,0 +1,10 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_isp_smart
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS += -include stdint.h
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/isp1.0/inc
+LOCAL_SRC_FILES:= utest_isp_smart.c \
+	../../../libs/libcamera/isp1.0/isp_smart_track.c
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,670 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "isp_smart_track.h"
+
+#define MAX_INDEX       120
+#define GAMMA_TAB_NUM   7
+#define RANDOM_STEPS    20000
+#define TRACE_MAX       4096
+
+enum {
+	LVL_DISWEI = 0,
+	LVL_RANWEI,
+	LVL_PREF_Y,
+	LVL_SOFT_Y,
+	LVL_SOFT_UV,
+	LVL_NUM
+};
+
+/* the ae and smart tuning isp_smart.c reads */
+struct tuning {
+	uint32_t start_index;
+	uint32_t start_zone;
+	uint32_t target_lum;
+	uint32_t target_zone;
+	int32_t ev;
+	uint32_t lum_thr;
+	uint32_t base_gain;
+	uint32_t level[LVL_NUM][4];
+	uint32_t edge_min;
+	uint32_t edge_max;
+	uint32_t gamma_num;
+	uint32_t gamma_zone;
+	uint32_t gamma_thr[4];
+	uint32_t gamma_lum_thr;
+	uint32_t denoise_coef;
+	uint32_t edge_coef;
+};
+
+/* the blocks of struct isp_context the smart adjust writes */
+struct blocks {
+	struct {
+		uint16_t axis[2][ISP_SMART_GAMMA_NUM];
+	} gamma;
+	struct {
+		uint32_t bypass;
+		uint32_t diswei;
+		uint32_t ranwei;
+	} denoise;
+	struct {
+		uint32_t bypass;
+		uint32_t y_thr;
+		uint32_t u_thr;
+		uint32_t v_thr;
+	} pref;
+	struct {
+		uint32_t bypass;
+		uint32_t strength;
+	} edge;
+	uint32_t soft_y;
+	uint32_t soft_uv;
+	uint32_t gamma_index;
+};
+
+struct tune {
+	uint8_t gamma;
+	uint8_t denoise;
+	uint8_t pref_y;
+	uint8_t edge;
+};
+
+struct model {
+	struct blocks blk;
+	struct blocks reg;
+	struct tune tune;
+	struct isp_smart_track track;
+	uint32_t programs;
+	uint32_t tracked;
+};
+
+struct ae {
+	uint32_t cur_index;
+	uint32_t cur_lum;
+};
+
+static uint16_t s_gamma_tab[GAMMA_TAB_NUM][2][ISP_SMART_GAMMA_NUM];
+static uint32_t s_gain[MAX_INDEX + 1];
+
+/* ------------------------------------------------------------------ */
+/* reference: the interpolation of isp_smart.c before the memo        */
+
+static uint32_t ref_level(const struct tuning *t, const uint32_t *lvl, uint32_t cur_index,
+			uint32_t wYlayer, uint32_t bias_value, uint32_t cur_value, uint32_t max_value)
+{
+	uint32_t max_index = MAX_INDEX;
+	uint32_t denoise_level = 0;
+	uint16_t denoise_thr = lvl[2] - lvl[1];
+	uint32_t denoise_min_index = lvl[1];
+	uint32_t denoise_mid_index = lvl[2];
+	uint32_t denoise_max_index = lvl[3];
+	uint32_t start_index = t->start_index;
+	uint32_t target_lum = t->target_lum + t->ev;
+	uint32_t target_lum_low_thr = target_lum - t->target_zone;
+	uint32_t low_thr = t->lum_thr;
+	uint32_t outdoor_denoise_level = lvl[0];
+	uint32_t start_zone = t->start_zone;
+
+	if (cur_index <= start_index) {
+		denoise_level = outdoor_denoise_level;
+	} else {
+		if (cur_index < max_index) {
+			if (cur_value < bias_value) {
+				denoise_level = denoise_min_index;
+				if ((cur_index < (start_index + start_zone))
+					&& (outdoor_denoise_level < denoise_min_index)) {
+					denoise_level = outdoor_denoise_level
+						+ (denoise_min_index - outdoor_denoise_level) * (cur_index - start_index) / start_zone;
+				}
+			} else {
+				denoise_level = ((cur_value - bias_value) * 255) / (max_value - bias_value);
+				denoise_level = (denoise_thr * denoise_level / 255) + denoise_min_index;
+				if (denoise_level < denoise_min_index) {
+					denoise_level = denoise_min_index;
+				} else if (denoise_level > denoise_mid_index) {
+					denoise_level = denoise_mid_index;
+				}
+			}
+		} else {
+			if (target_lum_low_thr < wYlayer) {
+				denoise_level = denoise_mid_index;
+			} else if (low_thr < wYlayer) {
+				denoise_level = (target_lum_low_thr - wYlayer) * (denoise_max_index - denoise_mid_index);
+				denoise_level /= (target_lum_low_thr - low_thr);
+				denoise_level += denoise_mid_index;
+			} else {
+				denoise_level = denoise_max_index;
+			}
+		}
+	}
+
+	return denoise_level;
+}
+
+static uint32_t ref_edge(const struct tuning *t, uint32_t index, uint32_t bias_value,
+			uint32_t cur_value, uint32_t max_value)
+{
+	uint32_t max_index = MAX_INDEX;
+	uint32_t start_index = t->start_index;
+	uint32_t max_edge_idx = t->edge_max;
+	uint32_t min_edge_idx = t->edge_min;
+	uint32_t edge_index;
+
+	if (max_index == index) {
+		edge_index = t->edge_min;
+	} else if (index < start_index) {
+		edge_index = t->edge_max;
+	} else {
+		max_edge_idx = max_edge_idx > min_edge_idx ? max_edge_idx - 1 : max_edge_idx;
+		if ((cur_value <= bias_value) || (max_value <= bias_value)) {
+			edge_index = max_edge_idx;
+		} else {
+			edge_index = (max_edge_idx - min_edge_idx) * (cur_value - bias_value) / (max_value - bias_value);
+			edge_index = max_edge_idx - edge_index;
+		}
+	}
+
+	if (edge_index < min_edge_idx)
+		edge_index = min_edge_idx;
+	else if (edge_index > max_edge_idx)
+		edge_index = max_edge_idx;
+
+	return edge_index;
+}
+
+static void ref_fit_gamma(const uint16_t *g0, const uint16_t *g1, uint32_t numerator,
+			uint32_t denominator, uint16_t *axis)
+{
+	uint32_t tmp, tmp1;
+	int i;
+
+	for (i = 0; i < ISP_SMART_GAMMA_NUM; i++) {
+		tmp = g0[i] * (denominator - numerator);
+		tmp1 = g1[i] * numerator;
+		axis[i] = (tmp + tmp1) / denominator;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* one smart pass of isp_smart.c on the model blocks                  */
+
+/* _isp_adjust_gamma */
+static void select_gamma(const struct tuning *t, const struct ae *ae, uint32_t *gamma0,
+			uint32_t *gamma1, uint32_t *numerator, uint32_t *denominator)
+{
+	uint32_t target_lum_low_thr = t->target_lum + t->ev - t->target_zone;
+	uint32_t zone = t->gamma_zone;
+	uint32_t i;
+
+	*gamma0 = *gamma1 = *numerator = *denominator = 0;
+
+	if (MAX_INDEX == ae->cur_index) {
+		if (target_lum_low_thr <= ae->cur_lum || 0xff <= t->gamma_lum_thr) {
+			*gamma0 = *gamma1 = t->gamma_num;
+		} else if (t->gamma_lum_thr <= ae->cur_lum) {
+			*gamma0 = t->gamma_num;
+			*gamma1 = t->gamma_num + 1;
+			*numerator = target_lum_low_thr - ae->cur_lum;
+			*denominator = target_lum_low_thr - t->gamma_lum_thr;
+		} else {
+			*gamma0 = *gamma1 = t->gamma_num + 1;
+		}
+	} else {
+		for (i = 0; i < t->gamma_num; i++) {
+			if (ae->cur_index <= t->gamma_thr[i] - zone)
+				break;
+			else if (ae->cur_index < t->gamma_thr[i] + zone) {
+				*gamma1 = i + 1;
+				*numerator = ae->cur_index - (t->gamma_thr[i] - zone);
+				*denominator = zone * 2;
+				break;
+			}
+			*gamma0 = *gamma1 = i + 1;
+		}
+	}
+}
+
+static void smart_in(const struct tuning *t, const struct ae *ae, struct isp_smart_in *in)
+{
+	in->cur_index = ae->cur_index;
+	in->max_index = MAX_INDEX;
+	in->start_index = t->start_index;
+	in->start_zone = t->start_zone;
+	in->target_lum_low_thr = t->target_lum + t->ev - t->target_zone;
+	in->cur_lum = ae->cur_lum;
+	in->low_thr = t->lum_thr;
+	in->bias_value = t->base_gain;
+	in->cur_value = s_gain[ae->cur_index];
+	in->max_value = s_gain[MAX_INDEX];
+}
+
+static uint32_t get_level(struct model *m, const struct tuning *t, const struct ae *ae,
+			uint32_t lvl, uint32_t id)
+{
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
+
+	if (!m->tracked)
+		return ref_level(t, t->level[lvl], ae->cur_index, ae->cur_lum,
+			t->base_gain, s_gain[ae->cur_index], s_gain[MAX_INDEX]);
+
+	param.outdoor = t->level[lvl][0];
+	param.min = t->level[lvl][1];
+	param.mid = t->level[lvl][2];
+	param.max = t->level[lvl][3];
+	smart_in(t, ae, &in);
+	return isp_smart_get_level(&m->track.level[id], &in, &param);
+}
+
+static void get_block(struct model *m, struct isp_smart_block *block)
+{
+	block[ISP_SMART_BLOCK_GAMMA].param_ptr = &m->blk.gamma;
+	block[ISP_SMART_BLOCK_GAMMA].size = sizeof(m->blk.gamma);
+	block[ISP_SMART_BLOCK_GAMMA].tune_ptr = &m->tune.gamma;
+	block[ISP_SMART_BLOCK_DENOISE].param_ptr = &m->blk.denoise;
+	block[ISP_SMART_BLOCK_DENOISE].size = sizeof(m->blk.denoise);
+	block[ISP_SMART_BLOCK_DENOISE].tune_ptr = &m->tune.denoise;
+	block[ISP_SMART_BLOCK_PREF].param_ptr = &m->blk.pref;
+	block[ISP_SMART_BLOCK_PREF].size = sizeof(m->blk.pref);
+	block[ISP_SMART_BLOCK_PREF].tune_ptr = &m->tune.pref_y;
+	block[ISP_SMART_BLOCK_EDGE].param_ptr = &m->blk.edge;
+	block[ISP_SMART_BLOCK_EDGE].size = sizeof(m->blk.edge);
+	block[ISP_SMART_BLOCK_EDGE].tune_ptr = &m->tune.edge;
+}
+
+/* isp_ae_fast_smart_adjust */
+static void fast_pass(struct model *m, const struct tuning *t, const struct ae *ae)
+{
+	struct isp_smart_block block[ISP_SMART_BLOCK_NUM];
+	uint32_t mask = ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_GAMMA);
+	uint32_t g0, g1, num, den;
+	int i;
+
+	get_block(m, block);
+	if (m->tracked)
+		isp_smart_track_begin(&m->track, block, mask);
+
+	select_gamma(t, ae, &g0, &g1, &num, &den);
+	if (g0 == m->blk.gamma_index && g1 == m->blk.gamma_index) {
+		if (!m->tracked)
+			m->tune.gamma = 0;
+	} else {
+		for (i = 0; i < ISP_SMART_GAMMA_NUM; i++)
+			m->blk.gamma.axis[0][i] = s_gamma_tab[g0][0][i];
+		if (g0 == g1) {
+			memcpy(m->blk.gamma.axis[1], s_gamma_tab[g0][1], sizeof(m->blk.gamma.axis[1]));
+			m->blk.gamma_index = g0;
+		} else {
+			if (m->tracked)
+				isp_smart_fit_gamma(&m->track.gamma, s_gamma_tab[g0][1], s_gamma_tab[g1][1],
+					num, den, m->blk.gamma.axis[1]);
+			else
+				ref_fit_gamma(s_gamma_tab[g0][1], s_gamma_tab[g1][1], num, den,
+					m->blk.gamma.axis[1]);
+			m->blk.gamma_index = 0xff;
+		}
+		if (!m->tracked)
+			m->tune.gamma = 1;
+	}
+
+	if (m->tracked)
+		isp_smart_track_end(&m->track, block, mask);
+}
+
+/* isp_ae_stab_smart_adjust: denoise, nr strength, edge, edge strength */
+static void stab_pass(struct model *m, const struct tuning *t, const struct ae *ae)
+{
+	struct isp_smart_block block[ISP_SMART_BLOCK_NUM];
+	uint32_t mask = ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_DENOISE)
+		| ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_PREF)
+		| ISP_SMART_BLOCK_BIT(ISP_SMART_BLOCK_EDGE);
+	struct isp_smart_level_param param;
+	struct isp_smart_in in;
+	uint32_t level;
+
+	get_block(m, block);
+	if (m->tracked)
+		isp_smart_track_begin(&m->track, block, mask);
+
+	m->blk.denoise.diswei = get_level(m, t, ae, LVL_DISWEI, ISP_SMART_LEVEL_DISWEI);
+	m->blk.denoise.ranwei = get_level(m, t, ae, LVL_RANWEI, ISP_SMART_LEVEL_RANWEI);
+	m->blk.pref.y_thr = get_level(m, t, ae, LVL_PREF_Y, ISP_SMART_LEVEL_PREF_Y);
+	m->blk.soft_y = get_level(m, t, ae, LVL_SOFT_Y, ISP_SMART_LEVEL_SOFT_Y);
+	m->blk.soft_uv = get_level(m, t, ae, LVL_SOFT_UV, ISP_SMART_LEVEL_SOFT_UV);
+	m->blk.denoise.bypass = (0 == m->blk.denoise.diswei && 0 == m->blk.denoise.ranwei);
+
+	/* _isp_nr_strength_adjust */
+	m->blk.pref.y_thr = (m->blk.pref.y_thr * t->denoise_coef) >> 6;
+	m->blk.pref.u_thr = (m->blk.pref.u_thr * t->denoise_coef) >> 6;
+	m->blk.pref.v_thr = (m->blk.pref.v_thr * t->denoise_coef) >> 6;
+	level = (m->blk.denoise.diswei * t->denoise_coef) >> 6;
+	m->blk.denoise.diswei = level > 0xff ? 0xff : level;
+	level = (m->blk.denoise.ranwei * t->denoise_coef) >> 6;
+	m->blk.denoise.ranwei = level > 0xff ? 0xff : level;
+
+	if (m->tracked) {
+		param.outdoor = param.mid = 0;
+		param.min = t->edge_min;
+		param.max = t->edge_max;
+		smart_in(t, ae, &in);
+		level = isp_smart_get_edge(&m->track.level[ISP_SMART_LEVEL_EDGE], &in, &param);
+	} else {
+		level = ref_edge(t, ae->cur_index, t->base_gain, s_gain[ae->cur_index], s_gain[MAX_INDEX]);
+	}
+	/* _isp_edge_strength_adjust */
+	m->blk.edge.strength = (level * t->edge_coef) >> 6;
+
+	if (m->tracked) {
+		isp_smart_track_end(&m->track, block, mask);
+	} else {
+		m->tune.denoise = 1;
+		m->tune.pref_y = 1;
+		m->tune.edge = 1;
+	}
+}
+
+/* the sof handler of isp_ctrl.c */
+static void sof(struct model *m)
+{
+	if (m->tune.gamma) {
+		memcpy(&m->reg.gamma, &m->blk.gamma, sizeof(m->reg.gamma));
+		m->tune.gamma = 0;
+		m->programs++;
+	}
+	if (m->tune.denoise) {
+		memcpy(&m->reg.denoise, &m->blk.denoise, sizeof(m->reg.denoise));
+		m->tune.denoise = 0;
+		m->programs++;
+	}
+	if (m->tune.pref_y) {
+		memcpy(&m->reg.pref, &m->blk.pref, sizeof(m->reg.pref));
+		m->tune.pref_y = 0;
+		m->programs++;
+	}
+	if (m->tune.edge) {
+		memcpy(&m->reg.edge, &m->blk.edge, sizeof(m->reg.edge));
+		m->tune.edge = 0;
+		m->programs++;
+	}
+}
+
+static int reg_match(const struct model *m)
+{
+	return !memcmp(&m->reg.gamma, &m->blk.gamma, sizeof(m->reg.gamma))
+		&& !memcmp(&m->reg.denoise, &m->blk.denoise, sizeof(m->reg.denoise))
+		&& !memcmp(&m->reg.pref, &m->blk.pref, sizeof(m->reg.pref))
+		&& !memcmp(&m->reg.edge, &m->blk.edge, sizeof(m->reg.edge));
+}
+
+static void model_init(struct model *m, uint32_t tracked)
+{
+	memset(m, 0, sizeof(*m));
+	m->tracked = tracked;
+	m->blk.gamma_index = 0xfe;
+	m->blk.pref.u_thr = m->blk.pref.v_thr = 40;
+	m->reg = m->blk;
+}
+
+/* ------------------------------------------------------------------ */
+
+static void tuning_default(struct tuning *t)
+{
+	static const uint32_t level[LVL_NUM][4] = {
+		{0, 3, 18, 30},
+		{0, 2, 16, 28},
+		{2, 6, 14, 24},
+		{1, 4, 12, 20},
+		{1, 5, 13, 22},
+	};
+
+	memset(t, 0, sizeof(*t));
+	t->start_index = 30;
+	t->start_zone = 12;
+	t->target_lum = 120;
+	t->target_zone = 8;
+	t->ev = 0;
+	t->lum_thr = 50;
+	t->base_gain = 256;
+	memcpy(t->level, level, sizeof(level));
+	t->edge_min = 2;
+	t->edge_max = 70;
+	t->gamma_num = 4;
+	t->gamma_zone = 4;
+	t->gamma_thr[0] = 25;
+	t->gamma_thr[1] = 55;
+	t->gamma_thr[2] = 80;
+	t->gamma_thr[3] = 100;
+	t->gamma_lum_thr = 60;
+	t->denoise_coef = 64;
+	t->edge_coef = 64;
+}
+
+static void tables_init(void)
+{
+	int k, i;
+
+	/* exposure first, then gain from 1x up to 16x in 1/256 */
+	for (i = 0; i <= MAX_INDEX; i++)
+		s_gain[i] = i < 40 ? 128 : 128 + (i - 40) * (i - 40) * 6;
+
+	for (k = 0; k < GAMMA_TAB_NUM; k++) {
+		for (i = 0; i < ISP_SMART_GAMMA_NUM; i++) {
+			uint32_t x = i * 1023 / (ISP_SMART_GAMMA_NUM - 1);
+			uint32_t lin = x;
+			uint32_t curve = 1023 - (1023 - x) * (1023 - x) / 1023;
+
+			s_gamma_tab[k][0][i] = x;
+			s_gamma_tab[k][1][i] = (lin * k + curve * (GAMMA_TAB_NUM - 1 - k)) / (GAMMA_TAB_NUM - 1);
+		}
+	}
+}
+
+/* recorded ae sequences: the index and lum of every frame */
+static int trace_ramp(struct ae *ae, int max)
+{
+	int n = 0, i;
+
+	/* walk from daylight into the dark and stay there */
+	for (i = 10; i <= MAX_INDEX && n < max; i++, n++) {
+		ae[n].cur_index = i;
+		ae[n].cur_lum = 118 + (i & 3);
+	}
+	for (i = 0; i < 400 && n < max; i++, n++) {
+		ae[n].cur_index = MAX_INDEX;
+		ae[n].cur_lum = 112 - (i < 200 ? i / 4 : 50) + (i % 3);
+	}
+	return n;
+}
+
+static int trace_hold(struct ae *ae, int max)
+{
+	int n = 0;
+
+	/* a stable scene, the index wobbles by one */
+	for (n = 0; n < 1200 && n < max; n++) {
+		ae[n].cur_index = 66 + ((n / 7) & 1);
+		ae[n].cur_lum = 119 + (n % 5 == 0);
+	}
+	return n;
+}
+
+static int trace_settle(struct ae *ae, int max)
+{
+	int n = 0, i, index = 20, target;
+
+	/* a scene change every 150 frames, ae converging by half the step */
+	for (i = 0; i < 8 && n < max; i++) {
+		int f;
+
+		target = 20 + (i * 37) % 100;
+		for (f = 0; f < 150 && n < max; f++, n++) {
+			index += (target - index) / 2;
+			ae[n].cur_index = index;
+			ae[n].cur_lum = 120 - (target - index);
+		}
+	}
+	return n;
+}
+
+static int trace_file(const char *name, struct ae *ae, int max)
+{
+	FILE *fp = fopen(name, "r");
+	unsigned int index, lum;
+	int n = 0;
+
+	if (!fp)
+		return -1;
+	while (n < max && 2 == fscanf(fp, "%u %u", &index, &lum)) {
+		ae[n].cur_index = index > MAX_INDEX ? MAX_INDEX : index;
+		ae[n].cur_lum = lum;
+		n++;
+	}
+	fclose(fp);
+	return n;
+}
+
+static int replay(const char *name, const struct tuning *t, const struct ae *ae, int num)
+{
+	static struct model ref, trk;
+	struct isp_smart_stat stat;
+	uint32_t hit = 0, miss = 0;
+	int i;
+
+	model_init(&ref, 0);
+	model_init(&trk, 1);
+
+	for (i = 0; i < num; i++) {
+		fast_pass(&ref, t, &ae[i]);
+		fast_pass(&trk, t, &ae[i]);
+		stab_pass(&ref, t, &ae[i]);
+		stab_pass(&trk, t, &ae[i]);
+
+		if (memcmp(&ref.blk, &trk.blk, sizeof(ref.blk))) {
+			printf("%s: frame %d index %d lum %d, tables differ\n",
+				name, i, ae[i].cur_index, ae[i].cur_lum);
+			return 1;
+		}
+
+		/* an ioctl writing pref between two passes */
+		if (i % 97 == 50) {
+			ref.blk.pref.u_thr = trk.blk.pref.u_thr = 30 + (i & 15);
+			ref.tune.pref_y = trk.tune.pref_y = 1;
+		}
+
+		sof(&ref);
+		sof(&trk);
+		if (!reg_match(&trk) || !reg_match(&ref)) {
+			printf("%s: frame %d index %d, registers miss an update\n",
+				name, i, ae[i].cur_index);
+			return 1;
+		}
+	}
+
+	isp_smart_track_get_stat(&trk.track, &stat);
+	for (i = 0; i < ISP_SMART_LEVEL_NUM; i++) {
+		hit += stat.level_hit[i];
+		miss += stat.level_miss[i];
+	}
+	printf("%s: %d frames, levels %u hit %u miss, gamma %u hit %u miss\n",
+		name, num, hit, miss, stat.gamma_hit, stat.gamma_miss);
+	printf("%s: dirty gamma %u denoise %u pref %u edge %u, registers programmed %u (untracked %u)\n",
+		name, stat.block_dirty[ISP_SMART_BLOCK_GAMMA], stat.block_dirty[ISP_SMART_BLOCK_DENOISE],
+		stat.block_dirty[ISP_SMART_BLOCK_PREF], stat.block_dirty[ISP_SMART_BLOCK_EDGE],
+		trk.programs, ref.programs);
+
+	return 0;
+}
+
+/* random ae steps, with the tuning changed under the memo now and then */
+static int test_random(const struct tuning *base)
+{
+	static struct ae ae[RANDOM_STEPS];
+	struct tuning t = *base;
+	static struct model ref, trk;
+	int i, k;
+
+	model_init(&ref, 0);
+	model_init(&trk, 1);
+
+	for (i = 0; i < RANDOM_STEPS; i++) {
+		ae[i].cur_index = rand() % 8 ? rand() % (MAX_INDEX + 1) : MAX_INDEX;
+		ae[i].cur_lum = rand() % 160;
+
+		if (0 == rand() % 500) {
+			k = rand() % LVL_NUM;
+			t.level[k][rand() % 4] = rand() % 32;
+			t.ev = rand() % 9 - 4;
+			t.denoise_coef = 48 + rand() % 32;
+			t.edge_coef = 48 + rand() % 32;
+			t.edge_min = rand() % 8;
+			t.edge_max = 60 + rand() % 20;
+			s_gamma_tab[rand() % GAMMA_TAB_NUM][1][rand() % ISP_SMART_GAMMA_NUM] += 3;
+		}
+
+		fast_pass(&ref, &t, &ae[i]);
+		fast_pass(&trk, &t, &ae[i]);
+		stab_pass(&ref, &t, &ae[i]);
+		stab_pass(&trk, &t, &ae[i]);
+		if (memcmp(&ref.blk, &trk.blk, sizeof(ref.blk))) {
+			printf("random: step %d index %d lum %d, tables differ\n",
+				i, ae[i].cur_index, ae[i].cur_lum);
+			return 1;
+		}
+		sof(&trk);
+		if (!reg_match(&trk)) {
+			printf("random: step %d, registers miss an update\n", i);
+			return 1;
+		}
+	}
+	printf("random: %d steps\n", RANDOM_STEPS);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static struct ae ae[TRACE_MAX];
+	struct tuning t;
+	int num;
+
+	tables_init();
+	tuning_default(&t);
+	srand(1);
+
+	printf("utest_isp_smart -- max index %d, start index %d, %d gamma tables\n",
+		MAX_INDEX, t.start_index, GAMMA_TAB_NUM);
+
+	if (argc > 1) {
+		num = trace_file(argv[1], ae, TRACE_MAX);
+		if (num <= 0) {
+			printf("%s: no ae steps\n", argv[1]);
+			return 1;
+		}
+		if (replay(argv[1], &t, ae, num)) {
+			printf("FAILED\n");
+			return 1;
+		}
+		printf("OK\n");
+		return 0;
+	}
+
+	num = trace_ramp(ae, TRACE_MAX);
+	if (replay("ramp", &t, ae, num))
+		goto failed;
+	num = trace_hold(ae, TRACE_MAX);
+	if (replay("hold", &t, ae, num))
+		goto failed;
+	num = trace_settle(ae, TRACE_MAX);
+	if (replay("settle", &t, ae, num))
+		goto failed;
+	if (test_random(&t))
+		goto failed;
+
+	printf("OK\n");
+	return 0;
+
+failed:
+	printf("FAILED\n");
+	return 1;
+}
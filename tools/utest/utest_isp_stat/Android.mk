@@ -0,0 +1,11 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_isp_stat
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS += -include stdint.h
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/isp1.0/inc
+LOCAL_SRC_FILES:= utest_isp_stat.c \
+	../../../libs/libcamera/isp1.0/isp_stat_kernel.c
+LOCAL_LDLIBS:= -lrt
+include $(BUILD_HOST_EXECUTABLE)
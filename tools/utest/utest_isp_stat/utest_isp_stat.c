@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "isp_stat_kernel.h"
+
+#define GRID_W          32
+#define GRID_H          32
+#define GRID_NUM        (GRID_W * GRID_H)
+#define RANDOM_ROUNDS   2000
+#define BENCH_LOOPS     2000
+#define GUARD           0x5a5a5a5a
+
+/* struct isp_reg_bits of a 32 bit and of a 64 bit build */
+struct reg_bits {
+	uint32_t reg_addr;
+	uint32_t reg_value;
+};
+
+struct reg_bits64 {
+	uint64_t reg_addr;
+	uint64_t reg_value;
+};
+
+static struct reg_bits s_aem_reg[GRID_NUM];
+static struct reg_bits s_awbm_reg[2 * GRID_NUM];
+static struct reg_bits64 s_awbm_reg64[2 * GRID_NUM];
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t rand32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ ((uint32_t)rand() << 30);
+}
+
+/* the unpack loops ispGetAWBMStatistic and ispGetAEMStatistic had */
+static void ref_awbm(const struct reg_bits *reg, int sc8825, uint32_t *r, uint32_t *g, uint32_t *b, uint32_t num)
+{
+	uint32_t i, k = 0, t0, t1;
+
+	for (i = 0; i < num; i++) {
+		t0 = reg[k++].reg_value;
+		t1 = reg[k++].reg_value;
+		if (sc8825) {
+			r[i] = (t1 >> 9) & 0xfffff;
+			g[i] = t0 & 0x1fffff;
+			b[i] = ((t1 & 0x1ff) << 11) | ((t0 >> 21) & 0x7ff);
+		} else {
+			r[i] = (t1 >> 11) & 0x1fffff;
+			g[i] = t0 & 0x3fffff;
+			b[i] = ((t1 & 0x7ff) << 10) | ((t0 >> 22) & 0x3ff);
+		}
+	}
+}
+
+static int fail(const char *what, uint32_t round)
+{
+	printf("%s: mismatch in round %u\n", what, round);
+	return 1;
+}
+
+static int check_unpack(void)
+{
+	static uint32_t r0[GRID_NUM + 1], g0[GRID_NUM + 1], b0[GRID_NUM + 1];
+	static uint32_t r1[GRID_NUM + 1], g1[GRID_NUM + 1], b1[GRID_NUM + 1];
+	static uint32_t r2[GRID_NUM + 1], g2[GRID_NUM + 1], b2[GRID_NUM + 1];
+	uint32_t round, i, num, layout;
+
+	for (round = 0; round < RANDOM_ROUNDS; round++) {
+		num = (round & 1) ? GRID_NUM : (uint32_t)(rand() % (GRID_NUM + 1));
+		for (i = 0; i < 2 * GRID_NUM; i++) {
+			s_awbm_reg[i].reg_addr = 0x1000 + 4 * i;
+			s_awbm_reg[i].reg_value = rand32();
+			s_awbm_reg64[i].reg_addr = s_awbm_reg[i].reg_addr;
+			s_awbm_reg64[i].reg_value = s_awbm_reg[i].reg_value;
+		}
+		for (i = 0; i < GRID_NUM; i++) {
+			s_aem_reg[i].reg_addr = 0x2000 + 4 * i;
+			s_aem_reg[i].reg_value = rand32();
+		}
+
+		for (layout = 0; layout < ISP_STAT_AWBM_MAX; layout++) {
+			r1[num] = g1[num] = b1[num] = GUARD;
+			ref_awbm(s_awbm_reg, layout == ISP_STAT_AWBM_SC8825, r0, g0, b0, num);
+			isp_stat_unpack_awbm_c((uint32_t *)s_awbm_reg, 2, 1, layout, r2, g2, b2, num);
+			isp_stat_unpack_awbm((uint32_t *)s_awbm_reg, 2, 1, layout, r1, g1, b1, num);
+			if (memcmp(r0, r2, num * 4) || memcmp(g0, g2, num * 4) || memcmp(b0, b2, num * 4))
+				return fail("unpack awbm C against the old loop", round);
+			if (memcmp(r0, r1, num * 4) || memcmp(g0, g1, num * 4) || memcmp(b0, b1, num * 4))
+				return fail("unpack awbm", round);
+			if (r1[num] != GUARD || g1[num] != GUARD || b1[num] != GUARD)
+				return fail("unpack awbm wrote past the end", round);
+			isp_stat_unpack_awbm((uint32_t *)s_awbm_reg64, 4, 2, layout, r1, g1, b1, num);
+			if (memcmp(r0, r1, num * 4) || memcmp(g0, g1, num * 4) || memcmp(b0, b1, num * 4))
+				return fail("unpack awbm of 64 bit records", round);
+		}
+
+		for (i = 0; i < num; i++)
+			r0[i] = s_aem_reg[i].reg_value & 0x3fffff;
+		r1[num] = GUARD;
+		isp_stat_unpack_aem((uint32_t *)s_aem_reg, 2, 1, 0x3fffff, r1, num);
+		if (memcmp(r0, r1, num * 4) || r1[num] != GUARD)
+			return fail("unpack aem", round);
+		isp_stat_unpack_aem_c((uint32_t *)s_aem_reg, 2, 1, 0x3fffff, r2, num);
+		if (memcmp(r0, r2, num * 4))
+			return fail("unpack aem C", round);
+	}
+
+	return 0;
+}
+
+/* ns per 32x32 frame of the C kernel and of the built one */
+static void bench(const char *name)
+{
+	static uint32_t r[GRID_NUM], g[GRID_NUM], b[GRID_NUM];
+	long long t0, t1 = 0, t2 = 0;
+	volatile uint32_t sink = 0;
+	uint32_t i, pass;
+
+	for (pass = 0; pass < 2; pass++) {
+		t0 = now_ns();
+		for (i = 0; i < BENCH_LOOPS; i++) {
+			if (!strcmp(name, "unpack aem")) {
+				if (pass)
+					isp_stat_unpack_aem((uint32_t *)s_aem_reg, 2, 1, 0x3fffff, r, GRID_NUM);
+				else
+					isp_stat_unpack_aem_c((uint32_t *)s_aem_reg, 2, 1, 0x3fffff, r, GRID_NUM);
+			} else {
+				if (pass)
+					isp_stat_unpack_awbm((uint32_t *)s_awbm_reg, 2, 1, ISP_STAT_AWBM_SC8830, r, g, b, GRID_NUM);
+				else
+					isp_stat_unpack_awbm_c((uint32_t *)s_awbm_reg, 2, 1, ISP_STAT_AWBM_SC8830, r, g, b, GRID_NUM);
+			}
+			sink += r[i % GRID_NUM];
+		}
+		if (pass)
+			t2 = now_ns() - t0;
+		else
+			t1 = now_ns() - t0;
+	}
+	printf("%-12s bit exact, C %lld ns, %s %lld ns per frame\n", name,
+		t1 / BENCH_LOOPS, ISP_STAT_SIMD ? "simd" : "C", t2 / BENCH_LOOPS);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t seed = argc > 1 ? (uint32_t)atoi(argv[1]) : 1;
+
+	srand(seed);
+	printf("utest_isp_stat -- %s, seed %u\n",
+		ISP_STAT_SIMD ? "simd" : "no simd, C against C", seed);
+
+	if (check_unpack())
+		return 1;
+	bench("unpack aem");
+	bench("unpack awbm");
+	printf("OK\n");
+
+	return 0;
+}
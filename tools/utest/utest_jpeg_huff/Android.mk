@@ -0,0 +1,16 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_jpeg_huff
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/jpeg/jpeg_fw_8830/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/vsp/sc8830/inc
+# the jpeg headers use uint32_t without including stdint.h; the progressive
+# entropy decoder is not built into the library
+LOCAL_CFLAGS:= -include stdint.h -DPROGRESSIVE_SUPPORT=1
+LOCAL_SRC_FILES:= utest_jpeg_huff.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegdec_pvld.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegdec_bitstream.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegcodec_table.c
+LOCAL_LDLIBS:= -lrt
+include $(BUILD_HOST_EXECUTABLE)
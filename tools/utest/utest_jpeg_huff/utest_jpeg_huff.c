@@ -0,0 +1,796 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sc8830_video_header.h"
+
+/* a 512x384 4:2:0 picture, in blocks */
+#define Y_BW            64
+#define Y_BH            48
+#define C_BW            (Y_BW / 2)
+#define C_BH            (Y_BH / 2)
+#define COMP_NUM        3
+#define BENCH_ROUNDS    50
+#define MAX_CORR_BITS   1000
+#define STREAM_MAX      (4 * 1024 * 1024)
+
+typedef struct {
+	int32 comps_in_scan;
+	int32 comp[COMP_NUM];
+	int32 Ss, Se, Ah, Al;
+} scan_t;
+
+/* the scans libjpeg writes for a progressive YCbCr picture */
+static const scan_t s_script[] = {
+	{3, {0, 1, 2}, 0, 0, 0, 1},
+	{1, {0}, 1, 5, 0, 2},
+	{1, {2}, 1, 63, 0, 1},
+	{1, {1}, 1, 63, 0, 1},
+	{1, {0}, 6, 63, 0, 2},
+	{1, {0}, 1, 63, 2, 1},
+	{3, {0, 1, 2}, 0, 0, 1, 0},
+	{1, {2}, 1, 63, 1, 0},
+	{1, {1}, 1, 63, 1, 0},
+	{1, {0}, 1, 63, 1, 0},
+};
+#define SCAN_NUM        (int32)(sizeof(s_script) / sizeof(s_script[0]))
+
+static const int32 s_bw[COMP_NUM] = {Y_BW, C_BW, C_BW};
+static const int32 s_bh[COMP_NUM] = {Y_BH, C_BH, C_BH};
+
+static int16 *s_orig[COMP_NUM];
+static int16 *s_dec[COMP_NUM];
+
+/* the entropy coded data and tables of a scan */
+typedef struct {
+	uint8 *data;
+	uint32 len;
+	/* dc 0, dc 1, ac */
+	uint8 bits[3][17];
+	uint8 val[3][257];
+} coded_scan_t;
+
+static coded_scan_t s_coded[SCAN_NUM];
+
+static JPEG_CODEC_T s_codec;
+static JPEG_PROGRESSIVE_INFO_T s_info;
+static JPEG_SOS_T s_sos[SCAN_NUM];
+
+/* the rest of the decoder, not used by the entropy decoding */
+JPEG_CODEC_T *Get_JPEGDecCodec(void)
+{
+	return &s_codec;
+}
+
+JPEG_PROGRESSIVE_INFO_T *JPEGFW_GetProgInfo()
+{
+	return &s_info;
+}
+
+PUBLIC void *JpegDec_ExtraMemAlloc(uint32 mem_size)
+{
+	/* the decoder memory is cleared once */
+	return calloc(1, mem_size);
+}
+
+PUBLIC void JpegDec_FreeNBytes(uint32 mem_size)
+{
+}
+
+void *SCI_MEMSET(void *s, int c, size_t n)
+{
+	return memset(s, c, n);
+}
+
+void *SCI_MEMCPY(void *d, const void *s, size_t n)
+{
+	return memcpy(d, s, n);
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* quantized coefficients of a camera picture, fewer and smaller up the zigzag */
+static void make_picture(void)
+{
+	int32 ci, b, k, n, mag, dc;
+
+	for(ci = 0; ci < COMP_NUM; ci++)
+	{
+		n = s_bw[ci] * s_bh[ci];
+		s_orig[ci] = (int16 *)calloc(n * 64, sizeof(int16));
+		s_dec[ci] = (int16 *)calloc(n * 64, sizeof(int16));
+		dc = 0;
+		for(b = 0; b < n; b++)
+		{
+			int16 *coef = s_orig[ci] + b * 64;
+
+			/* DC a random walk, now and then a jump to the whole range */
+			if(rand() % 50 == 0)
+			{
+				dc = rand() % 4095 - 2047;
+			}
+			dc += rand() % 41 - 20;
+			dc = dc > 2047 ? 2047 : (dc < -2047 ? -2047 : dc);
+			coef[0] = (int16)dc;
+
+			/* flat blocks give the long EOB runs */
+			if(rand() % 4 == 0)
+			{
+				continue;
+			}
+			for(k = 1; k < 64; k++)
+			{
+				if(rand() % 64 < k + (ci ? 24 : 0))
+				{
+					continue;
+				}
+				mag = rand() % (rand() % 8 == 0 ? 1024 : 1 + 96 / k);
+				coef[jpeg_fw_zigzag_order[k]] = (int16)(rand() & 1 ? mag : -mag);
+			}
+		}
+	}
+}
+
+/*
+ * The progressive encoder of libjpeg: a first pass counts the symbols, the
+ * second one writes them with the optimal tables.
+ */
+typedef struct {
+	int32 gather;
+	/* dc 0, dc 1, ac */
+	long freq[3][257];
+	uint16 code[3][256];
+	uint8 size[3][256];
+	uint8 *out;
+	uint32 len;
+	uint32 put_buffer;
+	int32 put_bits;
+	uint32 EOBRUN;
+	uint32 BE;
+	char bit_buffer[MAX_CORR_BITS];
+	int32 last_dc[COMP_NUM];
+	int32 fill;
+} enc_t;
+
+static void put_byte(enc_t *e, uint8 c)
+{
+	if(e->len < STREAM_MAX)
+	{
+		e->out[e->len++] = c;
+	}
+}
+
+static void emit_bits(enc_t *e, uint32 code, int32 size)
+{
+	if(e->gather || !size)
+	{
+		return;
+	}
+	e->put_buffer = (e->put_buffer << size) | (code & ((1 << size) - 1));
+	e->put_bits += size;
+	while(e->put_bits >= 8)
+	{
+		uint8 c = (uint8)(e->put_buffer >> (e->put_bits - 8));
+
+		put_byte(e, c);
+		if(c == 0xFF)
+		{
+			put_byte(e, 0);
+		}
+		e->put_bits -= 8;
+	}
+}
+
+static void flush_bits(enc_t *e)
+{
+	emit_bits(e, 0x7F, 7);
+	e->put_buffer = 0;
+	e->put_bits = 0;
+}
+
+static void emit_symbol(enc_t *e, int32 t, int32 sym)
+{
+	if(e->gather)
+	{
+		e->freq[t][sym]++;
+	}else
+	{
+		emit_bits(e, e->code[t][sym], e->size[t][sym]);
+	}
+}
+
+static void emit_buffered_bits(enc_t *e, const char *buf, uint32 n)
+{
+	while(n--)
+	{
+		emit_bits(e, *buf++, 1);
+	}
+}
+
+static void emit_eobrun(enc_t *e)
+{
+	uint32 temp = e->EOBRUN;
+	int32 nbits = 0;
+
+	if(e->EOBRUN > 0)
+	{
+		while(temp >>= 1)
+		{
+			nbits++;
+		}
+		emit_symbol(e, 2, nbits << 4);
+		emit_bits(e, e->EOBRUN, nbits);
+		e->EOBRUN = 0;
+		emit_buffered_bits(e, e->bit_buffer, e->BE);
+		e->BE = 0;
+	}
+}
+
+static void emit_restart(enc_t *e, int32 num)
+{
+	emit_eobrun(e);
+	flush_bits(e);
+	if(!e->gather)
+	{
+		/* fill bytes are allowed in front of a marker */
+		if(e->fill++ % 3 == 0)
+		{
+			put_byte(e, 0xFF);
+		}
+		put_byte(e, 0xFF);
+		put_byte(e, (uint8)(M_RST0 + num));
+	}
+	memset(e->last_dc, 0, sizeof(e->last_dc));
+}
+
+static int32 nbits_of(int32 v)
+{
+	int32 n = 0;
+
+	while(v)
+	{
+		n++;
+		v >>= 1;
+	}
+	return n;
+}
+
+static void encode_DC_first(enc_t *e, const int16 *coef, int32 ci, int32 Al)
+{
+	int32 temp2 = coef[0] >> Al;
+	int32 temp = temp2 - e->last_dc[ci];
+	int32 nbits;
+
+	e->last_dc[ci] = temp2;
+	temp2 = temp;
+	if(temp < 0)
+	{
+		temp = -temp;
+		temp2--;
+	}
+	nbits = nbits_of(temp);
+	emit_symbol(e, ci ? 1 : 0, nbits);
+	emit_bits(e, temp2, nbits);
+}
+
+static void encode_AC_first(enc_t *e, const int16 *coef, int32 Ss, int32 Se, int32 Al)
+{
+	int32 r = 0, k, temp, temp2, nbits;
+
+	for(k = Ss; k <= Se; k++)
+	{
+		temp = coef[jpeg_fw_zigzag_order[k]];
+		if(temp < 0)
+		{
+			temp = (-temp) >> Al;
+			temp2 = ~temp;
+		}else
+		{
+			temp >>= Al;
+			temp2 = temp;
+		}
+		if(temp == 0)
+		{
+			r++;
+			continue;
+		}
+		emit_eobrun(e);
+		while(r > 15)
+		{
+			emit_symbol(e, 2, 0xF0);
+			r -= 16;
+		}
+		nbits = nbits_of(temp);
+		emit_symbol(e, 2, (r << 4) + nbits);
+		emit_bits(e, temp2, nbits);
+		r = 0;
+	}
+	if(r > 0)
+	{
+		e->EOBRUN++;
+		if(e->EOBRUN == 0x7FFF)
+		{
+			emit_eobrun(e);
+		}
+	}
+}
+
+static void encode_AC_refine(enc_t *e, const int16 *coef, int32 Ss, int32 Se, int32 Al)
+{
+	int32 absvalues[64];
+	int32 r, k, temp, EOB = 0;
+	char *BR_buffer;
+	uint32 BR;
+
+	for(k = Ss; k <= Se; k++)
+	{
+		temp = coef[jpeg_fw_zigzag_order[k]];
+		temp = (temp < 0 ? -temp : temp) >> Al;
+		absvalues[k] = temp;
+		if(temp == 1)
+		{
+			EOB = k;
+		}
+	}
+
+	r = 0;
+	BR = 0;
+	BR_buffer = e->bit_buffer + e->BE;
+	for(k = Ss; k <= Se; k++)
+	{
+		if((temp = absvalues[k]) == 0)
+		{
+			r++;
+			continue;
+		}
+		while(r > 15 && k <= EOB)
+		{
+			emit_eobrun(e);
+			emit_symbol(e, 2, 0xF0);
+			r -= 16;
+			emit_buffered_bits(e, BR_buffer, BR);
+			BR_buffer = e->bit_buffer;
+			BR = 0;
+		}
+		if(temp > 1)
+		{
+			BR_buffer[BR++] = (char)(temp & 1);
+			continue;
+		}
+		emit_eobrun(e);
+		emit_symbol(e, 2, (r << 4) + 1);
+		emit_bits(e, coef[jpeg_fw_zigzag_order[k]] < 0 ? 0 : 1, 1);
+		emit_buffered_bits(e, BR_buffer, BR);
+		BR_buffer = e->bit_buffer;
+		BR = 0;
+		r = 0;
+	}
+	if(r > 0 || BR > 0)
+	{
+		e->EOBRUN++;
+		e->BE += BR;
+		if(e->EOBRUN == 0x7FFF || e->BE > (MAX_CORR_BITS - 64 + 1))
+		{
+			emit_eobrun(e);
+		}
+	}
+}
+
+/* jpeg_gen_optimal_table() of libjpeg */
+static void gen_optimal_table(long freq_in[257], uint8 bits_out[17], uint8 val[257])
+{
+	long freq[257], v;
+	uint8 bits[33];
+	int32 codesize[257], others[257];
+	int32 c1, c2, p, i, j;
+
+	memcpy(freq, freq_in, sizeof(freq));
+	memset(bits, 0, sizeof(bits));
+	memset(codesize, 0, sizeof(codesize));
+	for(i = 0; i < 257; i++)
+	{
+		others[i] = -1;
+	}
+	freq[256] = 1;
+
+	for(;;)
+	{
+		c1 = -1;
+		v = 1000000000L;
+		for(i = 0; i <= 256; i++)
+		{
+			if(freq[i] && freq[i] <= v)
+			{
+				v = freq[i];
+				c1 = i;
+			}
+		}
+		c2 = -1;
+		v = 1000000000L;
+		for(i = 0; i <= 256; i++)
+		{
+			if(freq[i] && freq[i] <= v && i != c1)
+			{
+				v = freq[i];
+				c2 = i;
+			}
+		}
+		if(c2 < 0)
+		{
+			break;
+		}
+		freq[c1] += freq[c2];
+		freq[c2] = 0;
+		codesize[c1]++;
+		while(others[c1] >= 0)
+		{
+			c1 = others[c1];
+			codesize[c1]++;
+		}
+		others[c1] = c2;
+		codesize[c2]++;
+		while(others[c2] >= 0)
+		{
+			c2 = others[c2];
+			codesize[c2]++;
+		}
+	}
+
+	for(i = 0; i <= 256; i++)
+	{
+		if(codesize[i])
+		{
+			bits[codesize[i]]++;
+		}
+	}
+	for(i = 32; i > 16; i--)
+	{
+		while(bits[i] > 0)
+		{
+			j = i - 2;
+			while(bits[j] == 0)
+			{
+				j--;
+			}
+			bits[i] -= 2;
+			bits[i - 1]++;
+			bits[j + 1] += 2;
+			bits[j]--;
+		}
+	}
+	while(bits[i] == 0)
+	{
+		i--;
+	}
+	bits[i]--;
+
+	memcpy(bits_out, bits, 17);
+	bits_out[0] = 0;
+	p = 0;
+	for(i = 1; i <= 32; i++)
+	{
+		for(j = 0; j <= 255; j++)
+		{
+			if(codesize[j] == i)
+			{
+				val[p++] = (uint8)j;
+			}
+		}
+	}
+}
+
+static void make_codes(enc_t *e, int32 t, const uint8 bits[17], const uint8 val[257])
+{
+	uint32 code = 0;
+	int32 l, i, p = 0;
+
+	for(l = 1; l <= 16; l++)
+	{
+		for(i = 0; i < bits[l]; i++, p++)
+		{
+			e->code[t][val[p]] = (uint16)code++;
+			e->size[t][val[p]] = (uint8)l;
+		}
+		code <<= 1;
+	}
+}
+
+/* the blocks of MCU mcu of a scan */
+static int32 mcu_blocks(const scan_t *scan, int16 **org, int32 mcu, int16 *blocks[6], uint8 member[6])
+{
+	int32 ci, comp, mx, my, x, y, n = 0;
+
+	if(scan->comps_in_scan == 1)
+	{
+		comp = scan->comp[0];
+		blocks[0] = org[comp] + mcu * 64;
+		member[0] = 0;
+		return 1;
+	}
+
+	mx = mcu % C_BW;
+	my = mcu / C_BW;
+	for(ci = 0; ci < scan->comps_in_scan; ci++)
+	{
+		comp = scan->comp[ci];
+		for(y = 0; y < (comp ? 1 : 2); y++)
+		{
+			for(x = 0; x < (comp ? 1 : 2); x++)
+			{
+				blocks[n] = org[comp] + (((comp ? my : 2 * my) + y) * s_bw[comp] + (comp ? mx : 2 * mx) + x) * 64;
+				member[n++] = (uint8)ci;
+			}
+		}
+	}
+	return n;
+}
+
+static int32 mcu_num(const scan_t *scan)
+{
+	if(scan->comps_in_scan == 1)
+	{
+		return s_bw[scan->comp[0]] * s_bh[scan->comp[0]];
+	}
+	return C_BW * C_BH;
+}
+
+static void encode_pass(enc_t *e, const scan_t *scan, int32 interval)
+{
+	int16 *blocks[6];
+	uint8 member[6];
+	int32 mcu, b, n, next_restart = 0;
+
+	memset(e->last_dc, 0, sizeof(e->last_dc));
+	e->EOBRUN = 0;
+	e->BE = 0;
+	e->put_buffer = 0;
+	e->put_bits = 0;
+	for(mcu = 0; mcu < mcu_num(scan); mcu++)
+	{
+		if(interval && mcu && (mcu % interval) == 0)
+		{
+			emit_restart(e, next_restart);
+			next_restart = (next_restart + 1) & 7;
+		}
+		n = mcu_blocks(scan, s_orig, mcu, blocks, member);
+		for(b = 0; b < n; b++)
+		{
+			if(scan->Ss == 0 && scan->Ah == 0)
+			{
+				encode_DC_first(e, blocks[b], scan->comp[member[b]], scan->Al);
+			}else if(scan->Ss == 0)
+			{
+				emit_bits(e, (blocks[b][0] >> scan->Al) & 1, 1);
+			}else if(scan->Ah == 0)
+			{
+				encode_AC_first(e, blocks[b], scan->Ss, scan->Se, scan->Al);
+			}else
+			{
+				encode_AC_refine(e, blocks[b], scan->Ss, scan->Se, scan->Al);
+			}
+		}
+	}
+	emit_eobrun(e);
+	flush_bits(e);
+}
+
+/* squared counts, so that the tables get codes up to 16 bits */
+static void skew_freq(long freq[257])
+{
+	double max = 1;
+	int32 i;
+
+	for(i = 0; i < 256; i++)
+	{
+		max = freq[i] > max ? freq[i] : max;
+	}
+	for(i = 0; i < 256; i++)
+	{
+		if(freq[i])
+		{
+			freq[i] = 1 + (long)((double)freq[i] * freq[i] / (max * max) * 2000000.0);
+		}
+	}
+}
+
+static uint32 encode_picture(int32 interval, int32 skew)
+{
+	static enc_t e;
+	uint32 total = 0;
+	int32 i, t;
+
+	for(i = 0; i < SCAN_NUM; i++)
+	{
+		coded_scan_t *cs = &s_coded[i];
+
+		memset(&e, 0, sizeof(e));
+		e.out = cs->data;
+		e.gather = 1;
+		encode_pass(&e, &s_script[i], interval);
+		for(t = 0; t < 3; t++)
+		{
+			memset(cs->bits[t], 0, sizeof(cs->bits[t]));
+			memset(cs->val[t], 0, sizeof(cs->val[t]));
+			if(e.freq[t][0] || memcmp(e.freq[t], e.freq[t] + 1, 256 * sizeof(long)))
+			{
+				if(skew)
+				{
+					skew_freq(e.freq[t]);
+				}
+				gen_optimal_table(e.freq[t], cs->bits[t], cs->val[t]);
+				make_codes(&e, t, cs->bits[t], cs->val[t]);
+			}
+		}
+		e.gather = 0;
+		encode_pass(&e, &s_script[i], interval);
+		cs->len = e.len;
+		total += e.len;
+	}
+	return total;
+}
+
+/* the decoder, scan after scan as JPEG_DecodeMCULine_Progressive() does */
+static int32 decode_picture(int32 interval)
+{
+	int16 *blocks[6];
+	int32 i, ci, mcu;
+
+	for(ci = 0; ci < COMP_NUM; ci++)
+	{
+		memset(s_dec[ci], 0, s_bw[ci] * s_bh[ci] * 64 * sizeof(int16));
+	}
+	s_codec.restart_interval = interval ? interval : 0x3FFFF;
+	s_info.buf_storage = s_sos;
+
+	for(i = 0; i < SCAN_NUM; i++)
+	{
+		const scan_t *scan = &s_script[i];
+		coded_scan_t *cs = &s_coded[i];
+		JPEG_SOS_T *sos = &s_sos[i];
+		bitstream_info address;
+
+		s_codec.dc_huff_tbl[0].bits = cs->bits[0];
+		s_codec.dc_huff_tbl[0].huffval = cs->val[0];
+		s_codec.dc_huff_tbl[1].bits = cs->bits[1];
+		s_codec.dc_huff_tbl[1].huffval = cs->val[1];
+		s_codec.ac_huff_tbl[0].bits = cs->bits[2];
+		s_codec.ac_huff_tbl[0].huffval = cs->val[2];
+
+		s_info.cur_scan = (uint8)i;
+		s_info.Ss = sos->Ss = (uint16)scan->Ss;
+		s_info.Se = sos->Se = (uint16)scan->Se;
+		s_info.Ah = sos->Ah = (uint16)scan->Ah;
+		s_info.Al = sos->Al = (uint16)scan->Al;
+		s_info.comps_in_scan = sos->comps_in_scan = (uint8)scan->comps_in_scan;
+		for(ci = 0; ci < scan->comps_in_scan; ci++)
+		{
+			sos->cur_comp_info[ci].component_id = (uint8)(scan->comp[ci] + 1);
+			sos->cur_comp_info[ci].dc_tbl_no = scan->comp[ci] ? 1 : 0;
+			sos->cur_comp_info[ci].ac_tbl_no = 0;
+			s_info.cur_comp_info[ci] = &sos->cur_comp_info[ci];
+		}
+		if(init_scan_entropy_info(&sos->entropy) != JPEG_SUCCESS)
+		{
+			printf("scan %d: init_scan_entropy_info failed\n", i);
+			return 1;
+		}
+
+		memset(&address, 0, sizeof(address));
+		address.src_buf = cs->data;
+		address.src_buf_len = cs->len;
+		address.bytes_in_buf = cs->len;
+		Update_Global_Bitstrm_Info(&address);
+
+		for(mcu = 0; mcu < mcu_num(scan); mcu++)
+		{
+			s_info.block_num = (uint16)mcu_blocks(scan, s_dec, mcu, blocks, s_info.blocks_membership);
+			if((*sos->entropy.decode_mcu)(blocks) != TRUE)
+			{
+				printf("scan %d: mcu %d failed\n", i, mcu);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int32 check_picture(void)
+{
+	int32 ci, n;
+
+	for(ci = 0; ci < COMP_NUM; ci++)
+	{
+		for(n = 0; n < s_bw[ci] * s_bh[ci] * 64; n++)
+		{
+			if(s_dec[ci][n] != s_orig[ci][n])
+			{
+				printf("component %d, block %d, coefficient %d: %d, shall be %d\n",
+					ci, n / 64, n % 64, s_dec[ci][n], s_orig[ci][n]);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* number of codes longer than the lookahead, and the longest code */
+static uint32 long_codes(int32 *longest)
+{
+	int32 i, t, l;
+	uint32 n = 0;
+
+	*longest = 0;
+	for(i = 0; i < SCAN_NUM; i++)
+	{
+		for(t = 0; t < 3; t++)
+		{
+			for(l = 1; l <= 16; l++)
+			{
+				if(s_coded[i].bits[t][l])
+				{
+					*longest = l > *longest ? l : *longest;
+				}
+				if(l > HUFF_LOOKAHEAD)
+				{
+					n += s_coded[i].bits[t][l];
+				}
+			}
+		}
+	}
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	static const int32 intervals[] = {0, 1, 7, 64};
+	uint32 seed = argc > 1 ? (uint32)atoi(argv[1]) : 1;
+	uint32 bytes, n;
+	int32 i, r, skew, longest;
+	long long t0, t;
+
+	srand(seed);
+	for(i = 0; i < SCAN_NUM; i++)
+	{
+		s_coded[i].data = (uint8 *)malloc(STREAM_MAX);
+		if(!s_coded[i].data)
+		{
+			return 1;
+		}
+	}
+	make_picture();
+
+	printf("utest_jpeg_huff -- %d scans of a %dx%d 4:2:0 picture, seed %u\n",
+		SCAN_NUM, Y_BW * 8, Y_BH * 8, seed);
+	for(skew = 0; skew < 2; skew++)
+	{
+		for(i = 0; i < (int32)(sizeof(intervals) / sizeof(intervals[0])); i++)
+		{
+			bytes = encode_picture(intervals[i], skew);
+			if(decode_picture(intervals[i]) || check_picture())
+			{
+				printf("%s tables, restart %d\n", skew ? "skewed" : "optimal", intervals[i]);
+				return 1;
+			}
+			t0 = now_ns();
+			for(r = 0; r < BENCH_ROUNDS; r++)
+			{
+				decode_picture(intervals[i]);
+			}
+			t = (now_ns() - t0) / BENCH_ROUNDS;
+			n = long_codes(&longest);
+			printf("%-7s restart %-2d %6u bytes, %3u codes over %d bits, longest %d, exact, "
+				"%lld us, %lld MB/s\n", skew ? "skewed" : "optimal", intervals[i], bytes,
+				n, HUFF_LOOKAHEAD, longest, t / 1000, t ? (long long)bytes * 1000 / t : 0);
+		}
+	}
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,15 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_jpeg_idct
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/jpeg/jpeg_fw_8830/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/vsp/sc8830/inc
+# the jpeg headers use uint32_t without including stdint.h
+LOCAL_CFLAGS:= -include stdint.h
+LOCAL_SRC_FILES:= utest_jpeg_idct.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegdec_dequant.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegdec_idct_simd.c \
+	../../../libs/libcamera/jpeg/jpeg_fw_8830/src/jpegcodec_table.c
+LOCAL_LDLIBS:= -lm -lrt
+include $(BUILD_HOST_EXECUTABLE)
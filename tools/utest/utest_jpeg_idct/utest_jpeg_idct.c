@@ -0,0 +1,417 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sc8830_video_header.h"
+
+#define TEST_BLOCKS     20000
+#define BENCH_BLOCKS    1024
+#define BENCH_ROUNDS    200
+/*
+ * Bound of the spatial values a block may give before the +128, so that
+ * the C code stays inside its clip table (-640 to 383).
+ */
+#define SPATIAL_MAX     370.0
+
+enum {
+	VAR_LOW = 0,
+	VAR_4X4,
+	VAR_2X2,
+	VAR_1X1,
+	VAR_HIGH,
+	VAR_NUM
+};
+
+static const char *var_name[VAR_NUM] = {"8x8 low", "4x4", "2x2", "1x1", "8x8 high"};
+static const uint32 var_size[VAR_NUM] = {8, 4, 2, 1, 8};
+static const JPEG_TRANSFORM_FUN var_c[VAR_NUM] = {
+	JPEG_SWIDCT_LOW_Quality, JPEG_SWIDCT_4X4, JPEG_SWIDCT_2X2,
+	JPEG_SWIDCT_1X1, JPEG_SWIDCT_High_Quality
+};
+#if JPEG_SWIDCT_SIMD
+static const JPEG_TRANSFORM_FUN var_simd[VAR_NUM] = {
+	JPEG_SWIDCT_LOW_Quality_SIMD, JPEG_SWIDCT_4X4_SIMD, JPEG_SWIDCT_2X2_SIMD,
+	JPEG_SWIDCT_1X1, JPEG_SWIDCT_High_Quality_SIMD
+};
+#else
+static const JPEG_TRANSFORM_FUN *var_simd = var_c;
+#endif
+
+static JPEG_CODEC_T s_codec;
+static JPEG_PROGRESSIVE_INFO_T s_info;
+static uint8 s_quant[2][64];
+
+/* the rest of the decoder, not used by the software idct */
+JPEG_CODEC_T *Get_JPEGDecCodec(void)
+{
+	return &s_codec;
+}
+
+JPEG_PROGRESSIVE_INFO_T *JPEGFW_GetProgInfo()
+{
+	return &s_info;
+}
+
+PUBLIC void *JpegDec_ExtraMemAlloc(uint32 mem_size)
+{
+	return malloc(mem_size);
+}
+
+uint32 JPG_READ_REG(uint32 addr, char *name)
+{
+	return 0;
+}
+
+uint32 JPG_READ_REG_POLL(uint32 addr, uint32 msk, uint32 exp_value, uint32 time, char *name)
+{
+	return 0;
+}
+
+void JPG_WRITE_REG(uint32 addr, uint32 value, char *name)
+{
+}
+
+void SCI_ASSERT(int32 cond)
+{
+}
+
+void SCI_TRACE_LOW(const char *fmt, ...)
+{
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* quantization tables and transform of a scale factor, as the decoder sets them up */
+static void setup_scale(uint32 scale_factor, int32 *tbl[2])
+{
+	s_codec.scale_factor = scale_factor;
+	JPEGFW_InitTransFun(&s_info);
+	JPEGFW_AdjustQuantTbl_Dec();
+	tbl[0] = s_info.quant_tbl_new[0];
+	tbl[1] = s_info.quant_tbl_new[1];
+}
+
+/* one 8x8 block of the image content a camera gives, quantized by q */
+static void make_block(int16 *coef, const int32 *q)
+{
+	double pix[64];
+	double f;
+	int32 kind = rand() % 4;
+	int32 x, y, u, v, i, n;
+
+	memset(coef, 0, 64 * sizeof(int16));
+	if(kind == 0)
+	{
+		/* flat */
+		coef[0] = (int16)((rand() % 2048 - 1024) / q[0]);
+		return;
+	}
+	if(kind == 1)
+	{
+		/* a few coefficients anywhere */
+		n = 1 + rand() % 6;
+		for(i = 0; i < n; i++)
+		{
+			coef[rand() % 64] = (int16)(rand() % 61 - 30);
+		}
+		return;
+	}
+
+	/* gradient or edge with noise, pixels 32 to 223 */
+	for(y = 0; y < 8; y++)
+	{
+		for(x = 0; x < 8; x++)
+		{
+			if(kind == 2)
+			{
+				f = 128 + (x - 3.5) * (rand() % 5) + (y - 3.5) * (rand() % 5);
+			}else
+			{
+				f = (x + y > 7) ? 190 : 60;
+			}
+			f += rand() % 33 - 16;
+			pix[y * 8 + x] = (f < 32 ? 32 : (f > 223 ? 223 : f)) - 128;
+		}
+	}
+	for(v = 0; v < 8; v++)
+	{
+		for(u = 0; u < 8; u++)
+		{
+			f = 0;
+			for(y = 0; y < 8; y++)
+			{
+				for(x = 0; x < 8; x++)
+				{
+					f += pix[y * 8 + x] * cos((2 * x + 1) * u * M_PI / 16) * cos((2 * y + 1) * v * M_PI / 16);
+				}
+			}
+			f *= 0.25 * (u ? 1 : M_SQRT1_2) * (v ? 1 : M_SQRT1_2);
+			coef[v * 8 + u] = (int16)lrint(f / q[v * 8 + u]);
+		}
+	}
+}
+
+/* largest spatial value the dequantized block can give */
+static double spatial_bound(const int16 *coef, const int32 *q)
+{
+	double sum = 0;
+	int32 i;
+
+	for(i = 0; i < 64; i++)
+	{
+		sum += fabs((double)coef[i] * q[i]);
+	}
+	return sum / 4;
+}
+
+/* the table the low quality idct multiplies by, without the aan scaling */
+static void low_plain_tbl(int32 *plain, uint32 tbl_id)
+{
+	int32 i;
+
+	for(i = 0; i < 64; i++)
+	{
+		plain[i] = s_quant[tbl_id][i];
+	}
+}
+
+static int16 *s_blocks;
+static uint32 *s_tbl_id;
+
+static uint32 make_blocks(uint32 num, int32 *plain[2], int32 *low_plain[2])
+{
+	uint32 i, rejected = 0;
+
+	for(i = 0; i < num; )
+	{
+		int16 *coef = s_blocks + i * 64;
+		uint32 tbl_id = rand() & 1;
+
+		make_block(coef, plain[tbl_id]);
+		if(spatial_bound(coef, plain[tbl_id]) > SPATIAL_MAX
+			|| spatial_bound(coef, low_plain[tbl_id]) > SPATIAL_MAX)
+		{
+			rejected++;
+			continue;
+		}
+		s_tbl_id[i++] = tbl_id;
+	}
+	return rejected;
+}
+
+static int32 check_variant(uint32 var, int32 *tbl[2])
+{
+	uint8 ref[64], out[64];
+	uint32 size = var_size[var];
+	uint32 i, k;
+
+	for(i = 0; i < TEST_BLOCKS; i++)
+	{
+		int16 *coef = s_blocks + i * 64;
+		const int32 *q = tbl[s_tbl_id[i]];
+
+		memset(ref, 0xa5, sizeof(ref));
+		memset(out, 0x5a, sizeof(out));
+		var_c[var](coef, ref, q);
+		var_simd[var](coef, out, q);
+		for(k = 0; k < size * size; k++)
+		{
+			if(ref[k] != out[k])
+			{
+				printf("%s: block %u differs at %u, %u instead of %u\n",
+					var_name[var], i, k, out[k], ref[k]);
+				return -1;
+			}
+		}
+		/* nothing written past the output block */
+		for(; k < 64; k++)
+		{
+			if(out[k] != 0x5a)
+			{
+				printf("%s: block %u written at %u\n", var_name[var], i, k);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* one MCU of 6 blocks at a time, every other one flat */
+static int32 check_batch(uint32 var, int32 *tbl[2])
+{
+	int16 mcu[6][64];
+	uint8 ref[6][64], out[6][64];
+	int16 *block[6];
+	uint8 *dst[6];
+	const int32 *quant[6];
+	uint32 size = var_size[var];
+	uint32 i, b, k;
+
+	for(i = 0; i + 6 <= TEST_BLOCKS; i += 6)
+	{
+		memset(out, 0x5a, sizeof(out));
+		for(b = 0; b < 6; b++)
+		{
+			memcpy(mcu[b], s_blocks + (i + b) * 64, sizeof(mcu[b]));
+			if(b & 1)
+			{
+				memset(&mcu[b][1], 0, 63 * sizeof(int16));
+			}
+			block[b] = mcu[b];
+			dst[b] = out[b];
+			quant[b] = tbl[s_tbl_id[i + b]];
+			var_c[var](mcu[b], ref[b], quant[b]);
+		}
+		JPEG_SWIDCT_Batch(&s_info, block, dst, quant, 6);
+		for(b = 0; b < 6; b++)
+		{
+			if(memcmp(ref[b], out[b], size * size))
+			{
+				printf("%s: batch block %u differs\n", var_name[var], i + b);
+				return -1;
+			}
+			for(k = size * size; k < 64; k++)
+			{
+				if(out[b][k] != 0x5a)
+				{
+					printf("%s: batch block %u written at %u\n", var_name[var], i + b, k);
+					return -1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+static long long bench(JPEG_TRANSFORM_FUN fun, int32 *tbl[2])
+{
+	uint8 out[64];
+	long long t0 = now_ns();
+	uint32 r, i;
+
+	for(r = 0; r < BENCH_ROUNDS; r++)
+	{
+		for(i = 0; i < BENCH_BLOCKS; i++)
+		{
+			fun(s_blocks + i * 64, out, tbl[s_tbl_id[i]]);
+		}
+	}
+	return (now_ns() - t0) / (BENCH_ROUNDS * BENCH_BLOCKS);
+}
+
+static long long bench_batch(int32 *tbl[2])
+{
+	static uint8 out[6][64];
+	int16 *block[6];
+	uint8 *dst[6];
+	const int32 *quant[6];
+	long long t0 = now_ns();
+	uint32 r, i, b;
+
+	for(r = 0; r < BENCH_ROUNDS; r++)
+	{
+		for(i = 0; i + 6 <= BENCH_BLOCKS; i += 6)
+		{
+			for(b = 0; b < 6; b++)
+			{
+				block[b] = s_blocks + (i + b) * 64;
+				dst[b] = out[b];
+				quant[b] = tbl[s_tbl_id[i + b]];
+			}
+			JPEG_SWIDCT_Batch(&s_info, block, dst, quant, 6);
+		}
+	}
+	return (now_ns() - t0) / (BENCH_ROUNDS * (BENCH_BLOCKS / 6 * 6));
+}
+
+int main(int argc, char **argv)
+{
+	int32 *tbl[2], *plain[2], *low_tbl[2], *low_plain[2];
+	int32 low_plain_buf[2][64];
+	uint32 seed = argc > 1 ? (uint32)atoi(argv[1]) : 1;
+	uint32 var, i, rejected;
+
+	srand(seed);
+	Initialize_Clip();
+	s_blocks = (int16 *)malloc(TEST_BLOCKS * 64 * sizeof(int16));
+	s_tbl_id = (uint32 *)malloc(TEST_BLOCKS * sizeof(uint32));
+	if(!s_blocks || !s_tbl_id)
+	{
+		return 1;
+	}
+
+	/* a progressive 4:2:0 picture, the tables of a quality 75 to 95 camera */
+	for(i = 0; i < 64; i++)
+	{
+		s_quant[0][i] = (uint8)(1 + rand() % 12 + i / 6);
+		s_quant[1][i] = (uint8)(1 + rand() % 16 + i / 4);
+	}
+	s_codec.progressive_mode = 1;
+	s_codec.num_components = 3;
+	s_codec.quant_tbl[0] = s_quant[0];
+	s_codec.quant_tbl[1] = s_quant[1];
+	s_codec.tbl_map[0].quant_tbl_id = 0;
+	s_codec.tbl_map[1].quant_tbl_id = 1;
+	s_codec.tbl_map[2].quant_tbl_id = 1;
+
+	printf("utest_jpeg_idct -- %s, seed %u\n",
+		JPEG_SWIDCT_SIMD ? (JPEG_SWIDCT_SIMD_SELECT ? "simd, selected" : "simd, not selected")
+		: "no simd, C against C", seed);
+
+	for(var = 0; var < VAR_HIGH; var++)
+	{
+		setup_scale(var, tbl);
+		if(s_info.jpeg_transform != (JPEG_SWIDCT_SIMD_SELECT ? var_simd[var] : var_c[var]))
+		{
+			printf("JPEGFW_InitTransFun: wrong %s transform\n", var_name[var]);
+			return 1;
+		}
+	}
+
+	setup_scale(0, low_tbl);
+	low_plain_tbl(low_plain_buf[0], 0);
+	low_plain_tbl(low_plain_buf[1], 1);
+	low_plain[0] = low_plain_buf[0];
+	low_plain[1] = low_plain_buf[1];
+
+	setup_scale(1, plain);
+	rejected = make_blocks(TEST_BLOCKS, plain, low_plain);
+	printf("%u blocks, %u out of the clip range rejected\n", TEST_BLOCKS, rejected);
+
+	for(var = 0; var < VAR_NUM; var++)
+	{
+		if(var < VAR_HIGH)
+		{
+			setup_scale(var, tbl);
+		}else
+		{
+			setup_scale(1, tbl);
+		}
+		if(check_variant(var, tbl))
+		{
+			return 1;
+		}
+		if(var < VAR_HIGH && check_batch(var, tbl))
+		{
+			return 1;
+		}
+		printf("%-8s  bit exact, C %lld ns, simd %lld ns", var_name[var],
+			bench(var_c[var], tbl), bench(var_simd[var], tbl));
+		if(var < VAR_HIGH)
+		{
+			printf(", batch %lld ns", bench_batch(tbl));
+		}
+		printf(" per block\n");
+	}
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_jpeg_putbits
+LOCAL_MODULE_TAGS:= debug
+# jpegenc_bitstream.c is included by the test, with the BSM registers
+# replaced by a model
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/jpeg/jpeg_fw_8830/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/jpeg/jpeg_fw_8830/src \
+	$(LOCAL_PATH)/../../../libs/libcamera/vsp/sc8830/inc
+# the jpeg headers use uint32_t without including stdint.h
+LOCAL_CFLAGS:= -include stdint.h -DJPEG_ENC
+LOCAL_SRC_FILES:= utest_jpeg_putbits.c
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sc8830_video_header.h"
+
+/*
+ * The BSM of the encoder: BSM_CFG2[29:24] is the number of bits of the
+ * next BSM_WDATA write, from 1 to 32, put in the stream msb first.
+ */
+typedef struct {
+	uint32 cfg2;
+	uint8 *out;
+	uint32 out_bits;
+	uint32 polls;
+	uint32 writes;
+	/* a WDATA write with no poll in front of it */
+	uint32 unpolled;
+	uint32 polled;
+} bsm_t;
+
+#define OUT_MAX         (1024 * 1024)
+
+static bsm_t s_bsm[2];
+static bsm_t *s_cur;
+
+static void bsm_init(bsm_t *bsm)
+{
+	uint8 *out = bsm->out;
+
+	memset(bsm, 0, sizeof(*bsm));
+	bsm->out = out ? out : malloc(OUT_MAX);
+	memset(bsm->out, 0, OUT_MAX);
+}
+
+static void bsm_put(bsm_t *bsm, uint32 val, uint32 nbits)
+{
+	int32 i;
+
+	for (i = nbits - 1; i >= 0; i--) {
+		if ((val >> i) & 1)
+			bsm->out[bsm->out_bits >> 3] |= 0x80 >> (bsm->out_bits & 7);
+		bsm->out_bits++;
+	}
+}
+
+static int32 bsm_poll(uint32 reg)
+{
+	if (reg != JPG_BSM_REG_BASE + BSM_RDY_OFFSET) {
+		printf("poll of 0x%x\n", reg);
+		exit(1);
+	}
+	s_cur->polls++;
+	s_cur->polled = 1;
+	return 0;
+}
+
+static void bsm_write(uint32 reg, uint32 val)
+{
+	uint32 nbits;
+
+	/* JPG_WRITE_REG reads the register back */
+	s_cur->writes++;
+	if (JPG_BSM_REG_BASE + BSM_CFG2_OFFSET == reg) {
+		s_cur->cfg2 = val;
+	} else if (JPG_BSM_REG_BASE + BSM_WDATA_OFFSET == reg) {
+		nbits = (s_cur->cfg2 >> 24) & 0x3f;
+		if (nbits < 1 || nbits > 32) {
+			printf("write of %d bits\n", nbits);
+			exit(1);
+		}
+		if (!s_cur->polled)
+			s_cur->unpolled++;
+		s_cur->polled = 0;
+		bsm_put(s_cur, val & (uint32)(((uint64)1 << nbits) - 1), nbits);
+	} else {
+		printf("write of 0x%x\n", reg);
+		exit(1);
+	}
+}
+
+#define JPG_READ_REG_POLL(reg_addr, msk, exp_value, time, pstring) bsm_poll(reg_addr)
+#define JPG_WRITE_REG(reg_addr, value, pstring) bsm_write(reg_addr, (value))
+
+#include "jpegenc_bitstream.c"
+
+/* the writer before, a poll and two writes per call */
+static void ref_PutBits(uint32 val, uint32 nbits)
+{
+	JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "");
+	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (nbits << 24), "");
+	JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, val, "");
+}
+
+static void ref_PutBytes(const uint8 *buf, uint32 len)
+{
+	uint32 i;
+
+	/* the callers used JPEGFW_PutC() */
+	for (i = 0; i < len; i++)
+		ref_PutBits(buf[i], 8);
+}
+
+/* a put call and its arguments */
+enum { OP_C, OP_W, OP_W_II, OP_BITS, OP_BITS32_II, OP_BYTES, OP_FLUSH, OP_NUM };
+
+static void put(int32 is_ref, int32 op, uint32 val, uint32 nbits, const uint8 *buf)
+{
+	s_cur = &s_bsm[is_ref];
+
+	switch (op) {
+	case OP_C:
+		if (is_ref) ref_PutBits((uint8)val, 8); else JPEGFW_PutC((uint8)val);
+		break;
+	case OP_W:
+		if (is_ref) ref_PutBits((uint16)val, 16); else JPEGFW_PutW((uint16)val);
+		break;
+	case OP_W_II:
+		if (is_ref) ref_PutBits((uint16)((val << 8) | ((val >> 8) & 0xff)), 16);
+		else JPEGFW_PutW_II((uint16)val);
+		break;
+	case OP_BITS:
+		if (is_ref) ref_PutBits(val, nbits); else JPEGFW_PutBits(val, nbits);
+		break;
+	case OP_BITS32_II:
+		if (is_ref)
+			ref_PutBits((val << 24) | ((val << 8) & 0xff0000) | ((val >> 8) & 0xff00) | (val >> 24), 32);
+		else
+			JPEGFW_PutBits32_II(val, 32);
+		break;
+	case OP_BYTES:
+		if (is_ref) ref_PutBytes(buf, nbits); else JPEGFW_PutBytes(buf, nbits);
+		break;
+	case OP_FLUSH:
+		if (!is_ref) {
+			JPEGFW_FlushBits();
+			/* as the tail does with the writer flushed */
+			JPG_READ_REG_POLL(JPG_BSM_REG_BASE+BSM_RDY_OFFSET, 1, 1, TIME_OUT_CLK, "");
+			JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_CFG2_OFFSET, (16<<24), "");
+			JPG_WRITE_REG(JPG_BSM_REG_BASE+BSM_WDATA_OFFSET, 0xffd9, "");
+		} else {
+			ref_PutBits(0xffd9, 16);
+		}
+		break;
+	}
+}
+
+static int32 compare(const char *name)
+{
+	uint32 i;
+
+	if (s_bsm[0].out_bits != s_bsm[1].out_bits) {
+		printf("%s: %d bits, %d before\n", name, s_bsm[0].out_bits, s_bsm[1].out_bits);
+		return 1;
+	}
+	for (i = 0; i < (s_bsm[0].out_bits + 7) >> 3; i++) {
+		if (s_bsm[0].out[i] != s_bsm[1].out[i]) {
+			printf("%s: byte %d is 0x%02x, 0x%02x before\n", name, i, s_bsm[0].out[i], s_bsm[1].out[i]);
+			return 1;
+		}
+	}
+	if (s_bsm[0].unpolled) {
+		printf("%s: %d writes without a poll\n", name, s_bsm[0].unpolled);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void run_start(void)
+{
+	bsm_init(&s_bsm[0]);
+	bsm_init(&s_bsm[1]);
+	JPEGFW_InitBits();
+}
+
+static void run_end(void)
+{
+	/* the head writers flush the writer before the hardware starts */
+	s_cur = &s_bsm[0];
+	JPEGFW_FlushBits();
+}
+
+static void report(const char *name, uint32 bytes)
+{
+	/* a poll is a read, a JPG_WRITE_REG a write and a read */
+	printf("%-10s %6d bytes, register accesses %7d, %7d before\n", name, bytes,
+		s_bsm[0].polls + 2 * s_bsm[0].writes, s_bsm[1].polls + 2 * s_bsm[1].writes);
+}
+
+/* random calls, in random sized batches between flushes */
+static int32 test_random(uint32 rounds)
+{
+	static uint8 buf[64];
+	uint32 r, i, op, val, nbits;
+
+	for (r = 0; r < rounds; r++) {
+		run_start();
+		for (i = 0; i < 2000; i++) {
+			op = rand() % OP_NUM;
+			val = ((uint32)rand() << 16) ^ (uint32)rand();
+			nbits = 1 + rand() % 32;
+			if (OP_BITS == op)
+				val &= (uint32)(((uint64)1 << nbits) - 1);
+			if (OP_BYTES == op) {
+				nbits = rand() % sizeof(buf);
+				for (val = 0; val < nbits; val++)
+					buf[val] = (uint8)rand();
+			}
+			/* flushes are rare, and come on a byte boundary as in the encoder */
+			if (OP_FLUSH == op && (rand() % 8 || (s_bsm[1].out_bits & 7)))
+				op = OP_C;
+			put(0, op, val, nbits, buf);
+			put(1, op, val, nbits, buf);
+		}
+		/* one last byte boundary */
+		while (s_bsm[1].out_bits & 7) {
+			put(0, OP_BITS, 1, 1, buf);
+			put(1, OP_BITS, 1, 1, buf);
+		}
+		run_end();
+		if (compare("random"))
+			return 1;
+	}
+	printf("random     %d rounds of 2000 calls, byte exact\n", rounds);
+
+	return 0;
+}
+
+static const uint8 s_dc_bits[17] = {0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8 s_ac_bits[17] = {0, 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+
+/* the calls of JPEG_HWWriteHead(), jpegenc_header.c is not built here */
+static void put_head(int32 is_ref)
+{
+	uint8 val[256];
+	uint32 i, k, count;
+
+	for (i = 0; i < sizeof(val); i++)
+		val[i] = (uint8)(i * 7 + 1);
+
+	put(is_ref, OP_W, 0xffd8, 16, NULL);
+	put(is_ref, OP_W, 0xffe0, 16, NULL);
+	put(is_ref, OP_W, 16, 16, NULL);
+	put(is_ref, OP_BYTES, 0, 5, (const uint8 *)"JFIF");
+	put(is_ref, OP_C, 1, 8, NULL);
+	put(is_ref, OP_C, 1, 8, NULL);
+	put(is_ref, OP_C, 0, 8, NULL);
+	put(is_ref, OP_W, 1, 16, NULL);
+	put(is_ref, OP_W, 1, 16, NULL);
+	put(is_ref, OP_C, 0, 8, NULL);
+	put(is_ref, OP_C, 0, 8, NULL);
+	for (i = 0; i < 2; i++) {
+		put(is_ref, OP_W, 0xffdb, 16, NULL);
+		put(is_ref, OP_W, 67, 16, NULL);
+		put(is_ref, OP_C, i, 8, NULL);
+		for (k = 0; k < 64; k++)
+			put(is_ref, OP_C, val[k] ^ i, 8, NULL);
+	}
+	put(is_ref, OP_W, 0xffc0, 16, NULL);
+	put(is_ref, OP_W, 17, 16, NULL);
+	put(is_ref, OP_C, 8, 8, NULL);
+	put(is_ref, OP_W, 1944, 16, NULL);
+	put(is_ref, OP_W, 2592, 16, NULL);
+	put(is_ref, OP_C, 3, 8, NULL);
+	for (i = 0; i < 3; i++) {
+		put(is_ref, OP_C, i + 1, 8, NULL);
+		put(is_ref, OP_C, i ? 0x11 : 0x21, 8, NULL);
+		put(is_ref, OP_C, i ? 1 : 0, 8, NULL);
+	}
+	for (i = 0; i < 4; i++) {
+		const uint8 *bits = (i & 1) ? s_ac_bits : s_dc_bits;
+		for (k = 1, count = 0; k <= 16; k++)
+			count += bits[k];
+		put(is_ref, OP_W, 0xffc4, 16, NULL);
+		put(is_ref, OP_W, 2 + 1 + 16 + count, 16, NULL);
+		put(is_ref, OP_C, ((i & 1) << 4) | (i >> 1), 8, NULL);
+		put(is_ref, OP_BYTES, 0, 16, bits + 1);
+		put(is_ref, OP_BYTES, 0, count, val);
+	}
+	put(is_ref, OP_W, 0xffdd, 16, NULL);
+	put(is_ref, OP_W, 4, 16, NULL);
+	put(is_ref, OP_W, 64, 16, NULL);
+	put(is_ref, OP_W, 0xffda, 16, NULL);
+	put(is_ref, OP_W, 12, 16, NULL);
+	put(is_ref, OP_C, 3, 8, NULL);
+	for (i = 0; i < 3; i++) {
+		put(is_ref, OP_C, i + 1, 8, NULL);
+		put(is_ref, OP_C, i ? 0x11 : 0, 8, NULL);
+	}
+	put(is_ref, OP_C, 0, 8, NULL);
+	put(is_ref, OP_C, 63, 8, NULL);
+	put(is_ref, OP_C, 0, 8, NULL);
+}
+
+static int32 test_head(void)
+{
+	run_start();
+	put_head(0);
+	put_head(1);
+	run_end();
+	if (compare("head"))
+		return 1;
+	report("head", s_bsm[0].out_bits >> 3);
+
+	return 0;
+}
+
+/* the thumbnail of the APP1, odd sized, from an unaligned address */
+static int32 test_thumbnail(void)
+{
+	static uint8 thumb[16 * 1024 + 3];
+	uint32 i;
+
+	for (i = 0; i < sizeof(thumb); i++)
+		thumb[i] = (uint8)rand();
+
+	run_start();
+	put(0, OP_C, 0xe1, 8, NULL);
+	put(1, OP_C, 0xe1, 8, NULL);
+	put(0, OP_BYTES, 0, sizeof(thumb) - 1, thumb + 1);
+	put(1, OP_BYTES, 0, sizeof(thumb) - 1, thumb + 1);
+	run_end();
+	if (compare("thumbnail"))
+		return 1;
+	report("thumbnail", s_bsm[0].out_bits >> 3);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint32 seed = 1;
+
+	if (argc > 1)
+		seed = atoi(argv[1]);
+	srand(seed);
+
+	printf("utest_jpeg_putbits -- seed %d\n", seed);
+
+	if (test_random(200) || test_head() || test_thumbnail()) {
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+
+	return 0;
+}
@@ -0,0 +1,12 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_ovc_damage
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/hwcomposer/OverlayComposer \
+	$(LOCAL_PATH)/../../../libs/gralloc \
+	$(LOCAL_PATH)/../../../libs/mali/src/ump/include
+LOCAL_SRC_FILES:= utest_ovc_damage.cpp \
+	../../../libs/hwcomposer/OverlayComposer/OverlayDamage.cpp
+LOCAL_STATIC_LIBRARIES:= libcutils liblog
+include $(BUILD_HOST_EXECUTABLE)
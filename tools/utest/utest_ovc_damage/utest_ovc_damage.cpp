@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OverlayDamage.h"
+
+using namespace android;
+
+#define FB_WIDTH        720
+#define FB_HEIGHT       1280
+#define MAX_LAYERS      6
+#define MAX_BUFFERS     3
+#define RANDOM_STEPS    1000
+
+/*
+ *  A software stand-in for the GLES calls of
+ *  OverlayComposer::composerHWLayers(): a scissored clear and
+ *  a scissored draw of each layer, blended as Layer::draw() does.
+ * */
+struct softBuffer {
+    uint32_t *pixels;
+    /* frame number last drawn, 0 for never */
+    int frame;
+};
+
+struct softLayer {
+    int content;
+    int opaque;
+    hwc_frect_t crop;
+    hwc_rect_t frame;
+    uint32_t transform;
+    int32_t blending;
+    uint8_t planeAlpha;
+};
+
+static struct softBuffer s_buffers[MAX_BUFFERS];
+static uint32_t *s_reference;
+static int s_handles[1024];
+static uint64_t s_pixels;
+
+static uint32_t layer_pixel(const struct softLayer *l, int x, int y)
+{
+    uint32_t v = (uint32_t)(l->content * 2654435761u) ^ (uint32_t)(x / 8 * 31 + y / 8 * 17);
+    uint32_t a = l->opaque ? 0xFF : (0x40 + (v & 0x7F));
+    uint32_t r = (v >> 8) & 0xFF;
+    uint32_t g = (v >> 16) & 0xFF;
+    uint32_t b = (v >> 24) & 0xFF;
+
+    /* premultiplied */
+    r = r * a / 255;
+    g = g * a / 255;
+    b = b * a / 255;
+
+    return (a << 24) | (b << 16) | (g << 8) | r;
+}
+
+static uint32_t blend(uint32_t dst, uint32_t src, const struct softLayer *l)
+{
+    uint32_t out = 0;
+    uint32_t sa = src >> 24;
+    uint32_t pa = l->planeAlpha;
+
+    for (int c = 0; c < 32; c += 8) {
+        uint32_t s = (src >> c) & 0xFF;
+        uint32_t d = (dst >> c) & 0xFF;
+        uint32_t v;
+
+        /* glColor4f(alpha) with GL_MODULATE, then ONE or SRC_ALPHA */
+        if (l->blending == HWC_BLENDING_PREMULT) {
+            s = s * pa / 255;
+            v = s + d * (255 - sa * pa / 255) / 255;
+        } else {
+            uint32_t a = sa * pa / 255;
+            v = s * a / 255 + d * (255 - a) / 255;
+        }
+        out |= (v > 255 ? 255 : v) << c;
+    }
+
+    return out;
+}
+
+static void soft_clear(uint32_t *fb, const struct LayerRect *r)
+{
+    for (uint32_t y = r->top; y < r->bottom; y++) {
+        for (uint32_t x = r->left; x < r->right; x++) {
+            fb[y * FB_WIDTH + x] = 0xFF000000;
+        }
+    }
+    s_pixels += (r->right - r->left) * (r->bottom - r->top);
+}
+
+/* the vertices of Layer::prepareDrawData() */
+static void soft_draw(uint32_t *fb, const struct softLayer *l, const struct LayerRect *scissor)
+{
+    int left = l->frame.left & ~1;
+    int top = (l->frame.top & 1) ? l->frame.top + 1 : l->frame.top;
+    int right = l->frame.right & ~1;
+    int bottom = l->frame.bottom & ~1;
+
+    left = (left < (int)scissor->left) ? scissor->left : left;
+    top = (top < (int)scissor->top) ? scissor->top : top;
+    right = (right > (int)scissor->right) ? scissor->right : right;
+    bottom = (bottom > (int)scissor->bottom) ? scissor->bottom : bottom;
+
+    for (int y = top; y < bottom; y++) {
+        for (int x = left; x < right; x++) {
+            /* the texture is sampled through the crop and the transform */
+            int u = (int)l->crop.left + (x - l->frame.left);
+            int v = (int)l->crop.top + (y - l->frame.top);
+
+            if (l->transform & HAL_TRANSFORM_FLIP_H)
+                u = (int)l->crop.right - 1 - (x - l->frame.left);
+            fb[y * FB_WIDTH + x] = blend(fb[y * FB_WIDTH + x], layer_pixel(l, u, v), l);
+        }
+    }
+    if (right > left && bottom > top)
+        s_pixels += (right - left) * (bottom - top);
+}
+
+static struct LayerRect frame_rect(const struct softLayer *l)
+{
+    struct LayerRect r;
+
+    r.left = l->frame.left;
+    r.top = l->frame.top;
+    r.right = l->frame.right;
+    r.bottom = l->frame.bottom;
+
+    return r;
+}
+
+/* the clear and draw loop of composerHWLayers() */
+static void soft_compose(uint32_t *fb, const struct softLayer *layers, int count,
+                         const struct OverlayDamageRegion *region)
+{
+    for (int j = 0; j < region->count; j++) {
+        soft_clear(fb, &(region->rects[j]));
+    }
+
+    for (int i = 0; i < count; i++) {
+        struct LayerRect rV = frame_rect(&layers[i]);
+
+        for (int j = 0; j < region->count; j++) {
+            if (OverlayDamage::intersect(&rV, &(region->rects[j])))
+                soft_draw(fb, &layers[i], &(region->rects[j]));
+        }
+    }
+}
+
+static void set_list(hwc_display_contents_1_t *list, const struct softLayer *layers, int count)
+{
+    list->numHwLayers = count + 1;
+    list->flags = 0;
+
+    for (int i = 0; i < count; i++) {
+        hwc_layer_1_t *l = &(list->hwLayers[i]);
+
+        memset(l, 0, sizeof(*l));
+        l->compositionType = HWC_OVERLAY;
+        l->handle = (buffer_handle_t)&s_handles[layers[i].content & 1023];
+        l->sourceCropf = layers[i].crop;
+        l->displayFrame = layers[i].frame;
+        l->transform = layers[i].transform;
+        l->blending = layers[i].blending;
+        l->planeAlpha = layers[i].planeAlpha;
+    }
+
+    /* the FramebufferTarget is not drawn by OverlayComposer */
+    hwc_layer_1_t *t = &(list->hwLayers[count]);
+    memset(t, 0, sizeof(*t));
+    t->compositionType = HWC_FRAMEBUFFER_TARGET;
+    t->handle = (buffer_handle_t)&s_handles[1023];
+}
+
+struct stats {
+    int frames;
+    int mismatch;
+    uint64_t pixels;
+    uint64_t fullPixels;
+};
+
+/*
+ *  One frame on the next buffer of the swap chain, checked
+ *  against the same layers drawn in full on a clear buffer.
+ * */
+static int compose_frame(OverlayDamage *damage, hwc_display_contents_1_t *list,
+                         const struct softLayer *layers, int count, int bufferNum,
+                         int frame, struct stats *st)
+{
+    struct softBuffer *b = &s_buffers[frame % bufferNum];
+    struct OverlayDamageRegion region;
+    struct OverlayDamageRegion full;
+    int age = b->frame ? frame - b->frame : 0;
+
+    set_list(list, layers, count);
+    damage->update(list, age, &region);
+
+    s_pixels = 0;
+    soft_compose(b->pixels, layers, count, &region);
+    b->frame = frame;
+    st->pixels += s_pixels;
+
+    full.count = 1;
+    full.rects[0].left = 0;
+    full.rects[0].top = 0;
+    full.rects[0].right = FB_WIDTH;
+    full.rects[0].bottom = FB_HEIGHT;
+    s_pixels = 0;
+    memset(s_reference, 0x5A, FB_WIDTH * FB_HEIGHT * 4);
+    soft_compose(s_reference, layers, count, &full);
+    st->fullPixels += s_pixels;
+    st->frames++;
+
+    if (memcmp(b->pixels, s_reference, FB_WIDTH * FB_HEIGHT * 4)) {
+        st->mismatch++;
+        return -1;
+    }
+
+    return 0;
+}
+
+static void init_layer(struct softLayer *l, int content, int opaque,
+                       int left, int top, int right, int bottom)
+{
+    memset(l, 0, sizeof(*l));
+    l->content = content;
+    l->opaque = opaque;
+    l->crop.right = right - left;
+    l->crop.bottom = bottom - top;
+    l->frame.left = left;
+    l->frame.top = top;
+    l->frame.right = right;
+    l->frame.bottom = bottom;
+    l->blending = opaque ? HWC_BLENDING_NONE : HWC_BLENDING_PREMULT;
+    l->planeAlpha = 0xFF;
+}
+
+static void print_stats(const char *name, struct stats *st)
+{
+    printf("%-12s %d frames, %s, pixels %llu of %llu (%llu%%)\n", name, st->frames,
+           st->mismatch ? "MISMATCH" : "same as full",
+           (unsigned long long)st->pixels, (unsigned long long)st->fullPixels,
+           (unsigned long long)(st->pixels * 100 / st->fullPixels));
+}
+
+static void reset_buffers(void)
+{
+    for (int i = 0; i < MAX_BUFFERS; i++) {
+        memset(s_buffers[i].pixels, 0xA5, FB_WIDTH * FB_HEIGHT * 4);
+        s_buffers[i].frame = 0;
+    }
+}
+
+/*
+ *  Video under a still OSD, the video buffer changes every frame,
+ *  the clock of the status bar every 30.
+ * */
+static int scene_video(hwc_display_contents_1_t *list, int bufferNum)
+{
+    OverlayDamage damage(FB_WIDTH, FB_HEIGHT);
+    struct softLayer layers[3];
+    struct stats st;
+    int ret = 0;
+
+    memset(&st, 0, sizeof(st));
+    reset_buffers();
+    init_layer(&layers[0], 1, 1, 0, 280, FB_WIDTH, 686);
+    init_layer(&layers[1], 100, 0, 0, 1100, FB_WIDTH, 1280);
+    init_layer(&layers[2], 200, 0, 600, 0, FB_WIDTH, 50);
+
+    for (int f = 1; f <= 120 && ret == 0; f++) {
+        layers[0].content = 1 + f % 3;
+        if (f % 30 == 0)
+            layers[2].content = (layers[2].content == 200) ? 201 : 200;
+        ret = compose_frame(&damage, list, layers, 3, bufferNum, f, &st);
+    }
+
+    print_stats(bufferNum == 2 ? "video x2" : "video x3", &st);
+    return ret;
+}
+
+/*
+ *  A still page and a small window moving over it, fading out.
+ * */
+static int scene_move(hwc_display_contents_1_t *list, int bufferNum)
+{
+    OverlayDamage damage(FB_WIDTH, FB_HEIGHT);
+    struct softLayer layers[2];
+    struct stats st;
+    int ret = 0;
+
+    memset(&st, 0, sizeof(st));
+    reset_buffers();
+    init_layer(&layers[0], 300, 1, 0, 0, FB_WIDTH, FB_HEIGHT);
+    init_layer(&layers[1], 301, 0, 100, 100, 300, 260);
+
+    for (int f = 1; f <= 120 && ret == 0; f++) {
+        layers[1].frame.left = 100 + f * 3;
+        layers[1].frame.right = 300 + f * 3;
+        layers[1].frame.top = 100 + f * 5;
+        layers[1].frame.bottom = 260 + f * 5;
+        if (f > 60)
+            layers[1].planeAlpha = 0xFF - (f - 60) * 4;
+        ret = compose_frame(&damage, list, layers, 2, bufferNum, f, &st);
+    }
+
+    print_stats("move", &st);
+    return ret;
+}
+
+/*
+ *  Layers come and go, the buffers are written by others
+ *  now and then, as GSP frames do.
+ * */
+static int scene_random(hwc_display_contents_1_t *list)
+{
+    OverlayDamage damage(FB_WIDTH, FB_HEIGHT);
+    struct softLayer layers[MAX_LAYERS];
+    struct stats st;
+    int count = 2;
+    int ret = 0;
+
+    memset(&st, 0, sizeof(st));
+    reset_buffers();
+    init_layer(&layers[0], 400, 1, 0, 0, FB_WIDTH, FB_HEIGHT);
+    init_layer(&layers[1], 401, 0, 64, 64, 320, 320);
+
+    for (int f = 1; f <= RANDOM_STEPS && ret == 0; f++) {
+        int r = rand() % 100;
+        int i = rand() % count;
+        int bufferNum = 2 + (f / 500) % 2;
+
+        if (r < 10 && count < MAX_LAYERS) {
+            int left = rand() % (FB_WIDTH - 16);
+            int top = rand() % (FB_HEIGHT - 16);
+
+            init_layer(&layers[count], 500 + rand() % 400, rand() % 2, left, top,
+                       left + 16 + rand() % (FB_WIDTH - left - 15),
+                       top + 16 + rand() % (FB_HEIGHT - top - 15));
+            count++;
+        } else if (r < 18 && count > 1) {
+            memmove(&layers[i], &layers[i + 1], (count - i - 1) * sizeof(layers[0]));
+            count--;
+        } else if (r < 40) {
+            layers[i].content = 500 + rand() % 400;
+        } else if (r < 50) {
+            int dx = rand() % 33 - 16;
+            int dy = rand() % 33 - 16;
+
+            if (layers[i].frame.left + dx >= 0 && layers[i].frame.right + dx <= FB_WIDTH &&
+                layers[i].frame.top + dy >= 0 && layers[i].frame.bottom + dy <= FB_HEIGHT) {
+                layers[i].frame.left += dx;
+                layers[i].frame.right += dx;
+                layers[i].frame.top += dy;
+                layers[i].frame.bottom += dy;
+            }
+        } else if (r < 55) {
+            layers[i].planeAlpha = 0x80 + rand() % 0x80;
+        } else if (r < 58) {
+            layers[i].transform ^= HAL_TRANSFORM_FLIP_H;
+        } else if (r < 60) {
+            layers[i].crop.left += 1;
+            layers[i].frame.left += 1;
+        } else if (r < 61) {
+            /* a frame drawn by others on the next buffer */
+            memset(s_buffers[(f + 1) % bufferNum].pixels, rand() & 0xFF, FB_WIDTH * FB_HEIGHT * 4);
+            damage.reset();
+        }
+
+        if (f % 500 == 0) {
+            /* the swap chain changes length, the ages are from before */
+            for (int b = 0; b < MAX_BUFFERS; b++)
+                s_buffers[b].frame = 0;
+        }
+
+        ret = compose_frame(&damage, list, layers, count, bufferNum, f, &st);
+        if (ret)
+            printf("random frame %d differs\n", f);
+    }
+
+    print_stats("random", &st);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    hwc_display_contents_1_t *list = NULL;
+    int ret = 0;
+
+    list = (hwc_display_contents_1_t *)calloc(1, sizeof(hwc_display_contents_1_t) +
+                                              (MAX_LAYERS + 1) * sizeof(hwc_layer_1_t));
+    s_reference = (uint32_t *)malloc(FB_WIDTH * FB_HEIGHT * 4);
+    for (int i = 0; i < MAX_BUFFERS; i++) {
+        s_buffers[i].pixels = (uint32_t *)malloc(FB_WIDTH * FB_HEIGHT * 4);
+    }
+
+    srand(seed);
+    printf("utest_ovc_damage -- %dx%d, seed %u\n", FB_WIDTH, FB_HEIGHT, seed);
+
+    ret |= scene_video(list, 2);
+    ret |= scene_video(list, 3);
+    ret |= scene_move(list, 2);
+    ret |= scene_random(list);
+
+    printf("%s\n", ret ? "FAIL" : "OK");
+
+    for (int i = 0; i < MAX_BUFFERS; i++) {
+        free(s_buffers[i].pixels);
+    }
+    free(s_reference);
+    free(list);
+
+    return ret ? 1 : 0;
+}
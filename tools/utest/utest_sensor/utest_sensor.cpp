@@ -21,6 +21,7 @@
 #include <errno.h>
 #include <string.h>
 #include <getopt.h>
+#include <math.h>
 #include <sys/cdefs.h>
 #include <sys/types.h>
 
@@ -212,11 +213,131 @@ static int do_read(int argc, char **argv)
 	return err;
 }
 
+static int do_batch(int argc, char **argv)
+{
+	int err = 0;
+	int opt;
+	int delay = 10;
+	int latency = 200;
+	int seconds = 10;
+	char *type = NULL;
+	int id = -1;
+	static const size_t numEvents = 256;
+	sensors_event_t buffer[numEvents];
+	struct sensors_poll_device_1 *dev1 =
+	    (struct sensors_poll_device_1 *)device;
+
+	while ((opt = getopt(argc, argv, "t:d:l:s:")) != -1) {
+		switch (opt) {
+		case 't':
+			type = optarg;
+			break;
+		case 'd':
+			delay = atoi(optarg);
+			break;
+		case 'l':
+			latency = atoi(optarg);
+			break;
+		case 's':
+			seconds = atoi(optarg);
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (optind < argc || type == NULL || delay <= 0) {
+		return -EINVAL;
+	}
+	if (device->common.version < SENSORS_DEVICE_API_VERSION_1_1) {
+		printf("batch mode is not supported by this HAL\n");
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (strcmp(type, getSensorName(list[i].type)) == 0)
+			id = i;
+	}
+	if (id < 0) {
+		printf("no sensor of type '%s'\n", type);
+		return 0;
+	}
+	printf("do_batch: '%s' delay (%d ms) latency (%d ms) for %d s\n",
+	       list[id].name, delay, latency, seconds);
+
+	err = device->activate(device, list[id].handle, 1);
+	if (err != 0) {
+		printf("activate() for '%s'failed (%s)\n",
+		       list[id].name, strerror(-err));
+		return 0;
+	}
+	err = dev1->batch(dev1, list[id].handle, 0, ms2ns(delay),
+			  ms2ns(latency));
+	if (err != 0) {
+		printf("batch() for '%s'failed (%s)\n",
+		       list[id].name, strerror(-err));
+		device->activate(device, list[id].handle, 0);
+		return 0;
+	}
+
+	/*
+	 * Every return from poll() is one wake-up of the framework thread,
+	 * the jitter is the deviation of the sample interval from delay.
+	 */
+	nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	nsecs_t end = start + seconds_to_nanoseconds(seconds);
+	int64_t last = 0;
+	long long wakeups = 0, samples = 0, flushes = 0;
+	double sum = 0, sum2 = 0;
+
+	while (systemTime(SYSTEM_TIME_MONOTONIC) < end) {
+		int n = device->poll(device, buffer, numEvents);
+		if (n < 0) {
+			printf("poll() failed (%s)\n", strerror(-n));
+			break;
+		}
+		wakeups++;
+		for (int i = 0; i < n; i++) {
+			const sensors_event_t & data = buffer[i];
+			if (data.type == SENSOR_TYPE_META_DATA) {
+				flushes++;
+				continue;
+			}
+			if (data.sensor != list[id].handle)
+				continue;
+			if (last) {
+				double dev = (double)(data.timestamp - last)
+				    - (double)ms2ns(delay);
+				sum += dev;
+				sum2 += dev * dev;
+			}
+			last = data.timestamp;
+			samples++;
+		}
+	}
+	dev1->flush(dev1, list[id].handle);
+	device->activate(device, list[id].handle, 0);
+
+	double elapsed = (double)(systemTime(SYSTEM_TIME_MONOTONIC) - start)
+	    / 1000000000.0;
+	printf("samples: %lld, wakeups: %lld (%.1f/s), flushes: %lld\n",
+	       samples, wakeups, wakeups / elapsed, flushes);
+	if (samples > 1) {
+		double mean = sum / (samples - 1);
+		double var = sum2 / (samples - 1) - mean * mean;
+		printf("interval error: mean %.3f ms, stddev %.3f ms\n",
+		       mean / 1000000.0, sqrt(var > 0 ? var : 0) / 1000000.0);
+	}
+	return 0;
+}
+
 static void usage(void)
 {
 	printf("Usage:\n");
 	printf("  utest_sensor list [-a]\n");
 	printf("  utest_sensor read [-t sensor_type] [-d delay]\n");
+	printf
+	    ("  utest_sensor batch [-t sensor_type] [-d delay] [-l latency] [-s seconds]\n");
 	printf
 	    ("  utest_sensor verify [-t sensor_type] [-d delay] [-o verify_option]\n");
 }
@@ -258,6 +379,8 @@ int main(int argc, char **argv)
 		rval = show_sensor_info(argc, argv);
 	} else if (strcmp(cmd, "read") == 0) {
 		rval = do_read(argc, argv);
+	} else if (strcmp(cmd, "batch") == 0) {
+		rval = do_batch(argc, argv);
 	} else if (strcmp(cmd, "verify") == 0) {
 		rval = 0;
 	}
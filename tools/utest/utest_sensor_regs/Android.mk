@@ -0,0 +1,11 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_sensor_regs
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/oem/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/mtrace \
+	$(TARGET_OUT_INTERMEDIATES)/KERNEL/source/include/video
+LOCAL_SRC_FILES:= utest_sensor_regs.c \
+	../../../libs/libcamera/oem/src/sensor_reg_shadow.c
+include $(BUILD_HOST_EXECUTABLE)
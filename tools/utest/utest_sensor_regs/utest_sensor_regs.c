@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sensor_reg_shadow.h"
+
+#define REG_NUM         SENSOR_REG_SHADOW_SIZE
+#define MODE_NUM        4
+#define MAX_TAB         1024
+#define MAX_LOG         (4 * MAX_TAB)
+#define DEF_SWITCHES    2000
+#define AE_WRITES       3
+#define POWER_EVERY     500
+
+/* simulated sensor, CCI address auto increment on a multi byte write */
+typedef struct {
+	cmr_u16 reg[REG_NUM];
+	/* what went out since the last send, delays included */
+	struct sensor_reg_tag log[MAX_LOG];
+	cmr_u32 log_num;
+	unsigned long xfers;
+	unsigned long bytes;
+	unsigned long delays;
+} Sim;
+
+typedef struct {
+	struct sensor_reg_tag reg[MAX_TAB];
+	cmr_u32 count;
+} Tab;
+
+static Sim s_sim;
+static Sim s_ref;
+static Tab s_init;
+static Tab s_mode[MODE_NUM];
+
+static cmr_u16 reg_default(cmr_u32 addr)
+{
+	return (addr * 7) & 0xff;
+}
+
+static void sim_reset(Sim* sim)
+{
+	cmr_u32 i;
+
+	for (i = 0; i < REG_NUM; i++)
+		sim->reg[i] = reg_default(i);
+}
+
+static void sim_write(Sim* sim, cmr_u16 addr, cmr_u16 value)
+{
+	if (sim->log_num < MAX_LOG) {
+		sim->log[sim->log_num].reg_addr = addr;
+		sim->log[sim->log_num].reg_value = value;
+		sim->log_num++;
+	}
+	if (SENSOR_WRITE_DELAY == addr) {
+		sim->delays++;
+		return;
+	}
+	if (SENSOR_REG_SOFT_RESET == addr && (value & 1)) {
+		sim_reset(sim);
+		return;
+	}
+	sim->reg[addr] = value;
+}
+
+static cmr_int sim_write_tab(void* priv, struct sensor_reg_tag* reg, cmr_u32 count)
+{
+	Sim* sim = (Sim*)priv;
+	cmr_u32 i;
+
+	for (i = 0; i < count; i++) {
+		sim_write(sim, reg[i].reg_addr, reg[i].reg_value);
+		if (SENSOR_WRITE_DELAY != reg[i].reg_addr) {
+			sim->xfers++;
+			sim->bytes += 3;
+		}
+	}
+	return 0;
+}
+
+static cmr_int sim_write_burst(void* priv, cmr_u16 addr, cmr_u8* value, cmr_u32 count)
+{
+	Sim* sim = (Sim*)priv;
+	cmr_u32 i;
+
+	if (count > SENSOR_REG_BURST_MAX) {
+		printf("burst of %u registers\n", count);
+		exit(1);
+	}
+	for (i = 0; i < count; i++)
+		sim_write(sim, (cmr_u16)(addr + i), value[i]);
+	sim->xfers++;
+	sim->bytes += 2 + count;
+	return 0;
+}
+
+static void tab_add(Tab* t, cmr_u16 addr, cmr_u16 value)
+{
+	if (t->count < MAX_TAB) {
+		t->reg[t->count].reg_addr = addr;
+		t->reg[t->count].reg_value = value;
+		t->count++;
+	}
+}
+
+/* a run of consecutive registers, values from a small set so modes share many */
+static void tab_add_run(Tab* t, cmr_u16 addr, cmr_u32 len, cmr_u32 spread)
+{
+	cmr_u32 i;
+
+	for (i = 0; i < len; i++)
+		tab_add(t, (cmr_u16)(addr + i), (cmr_u16)(rand() % spread));
+}
+
+static void make_tabs(void)
+{
+	cmr_u32 m;
+
+	/* init: software reset, PLL, then the common block */
+	tab_add(&s_init, SENSOR_REG_SOFT_RESET, 0x01);
+	tab_add(&s_init, SENSOR_WRITE_DELAY, 5);
+	tab_add(&s_init, 0x0100, 0x00);
+	tab_add_run(&s_init, 0x0300, 12, 256);
+	tab_add(&s_init, SENSOR_WRITE_DELAY, 2);
+	tab_add_run(&s_init, 0x3000, 200, 256);
+	tab_add_run(&s_init, 0x3600, 60, 256);
+	tab_add_run(&s_init, 0x4000, 40, 256);
+	tab_add_run(&s_init, 0x5000, 8, 256);
+
+	for (m = 0; m < MODE_NUM; m++) {
+		Tab* t = &s_mode[m];
+
+		/* the access code of imx219, its registers are set twice or once */
+		if (MODE_NUM - 1 == m) {
+			tab_add(t, 0x30EB, 0x05);
+			tab_add(t, 0x30EB, 0x0C);
+			tab_add(t, 0x300A, 0xFF);
+			tab_add(t, 0x300B, 0xFF);
+			tab_add(t, 0x30EB, 0x05);
+			tab_add(t, 0x30EB, 0x09);
+		}
+		/* timing and size */
+		tab_add_run(t, 0x0300, 12, 4);
+		tab_add(t, SENSOR_WRITE_DELAY, 1);
+		tab_add_run(t, 0x3500, 6, 256);
+		tab_add_run(t, 0x3600, 20, 2);
+		tab_add_run(t, 0x3800, 32, 8);
+		tab_add_run(t, 0x3820, 4, 2);
+		tab_add_run(t, 0x4000, 16, 2);
+		tab_add_run(t, 0x4800, 3, 256);
+		tab_add_run(t, 0x5000, 7, 2);
+		/* a register set twice, the second value shall win */
+		if (MODE_NUM - 2 == m)
+			tab_add(t, 0x5000, 0x80 + m);
+	}
+}
+
+static int tab_repeats(const Tab* t, cmr_u16 addr)
+{
+	cmr_u32 i;
+	cmr_u32 n = 0;
+
+	for (i = 0; i < t->count; i++)
+		n += t->reg[i].reg_addr == addr;
+	return n > 1;
+}
+
+/*
+ * What the sensor got shall be a subsequence of the table with all the
+ * delays and the reset, and a table that sets a register twice shall
+ * go out in full.
+ */
+static int check_order(const Tab* t, const Sim* sim)
+{
+	cmr_u32 i = 0;
+	cmr_u32 j;
+	int full = 0;
+
+	for (i = 0; i < t->count; i++)
+		full |= SENSOR_WRITE_DELAY != t->reg[i].reg_addr && tab_repeats(t, t->reg[i].reg_addr);
+	i = 0;
+
+	for (j = 0; j <= sim->log_num; j++) {
+		while (i < t->count && (j == sim->log_num
+			|| t->reg[i].reg_addr != sim->log[j].reg_addr
+			|| t->reg[i].reg_value != sim->log[j].reg_value)) {
+			if (SENSOR_WRITE_DELAY == t->reg[i].reg_addr
+				|| SENSOR_REG_SOFT_RESET == t->reg[i].reg_addr
+				|| full)
+				return -1;
+			i++;
+		}
+		if (j < sim->log_num && i++ == t->count)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int send(struct sensor_reg_shadow* shadow, const struct sensor_reg_ops* ops,
+		struct sensor_reg_stat* stat, const Tab* t)
+{
+	cmr_u32 i;
+
+	s_sim.log_num = 0;
+	if (sensor_reg_shadow_send(shadow, t->reg, t->count, 1, ops, stat)) {
+		printf("send failed\n");
+		return -1;
+	}
+	if (check_order(t, &s_sim)) {
+		printf("table order, delays or a table setting a register twice not kept\n");
+		return -1;
+	}
+	sim_write_tab(&s_ref, (struct sensor_reg_tag*)t->reg, t->count);
+	if (memcmp(s_sim.reg, s_ref.reg, sizeof(s_sim.reg))) {
+		for (i = 0; i < REG_NUM; i++) {
+			if (s_sim.reg[i] != s_ref.reg[i])
+				break;
+		}
+		printf("register 0x%04x is 0x%02x, a full write gives 0x%02x\n",
+		       i, s_sim.reg[i], s_ref.reg[i]);
+		return -1;
+	}
+	return 0;
+}
+
+static int run(const char* name, int bursts, int switches)
+{
+	struct sensor_reg_shadow shadow;
+	struct sensor_reg_ops ops;
+	struct sensor_reg_stat stat;
+	int i, j;
+
+	if (sensor_reg_shadow_init(&shadow)) {
+		printf("no memory\n");
+		return -1;
+	}
+	ops.write_tab = sim_write_tab;
+	ops.write_burst = bursts ? sim_write_burst : NULL;
+	ops.priv = &s_sim;
+	memset(&stat, 0, sizeof(stat));
+	memset(&s_sim, 0, sizeof(s_sim));
+	memset(&s_ref, 0, sizeof(s_ref));
+	sim_reset(&s_sim);
+	sim_reset(&s_ref);
+
+	srand(1);
+	for (i = 0; i < switches; i++) {
+		if (!(i % POWER_EVERY)) {
+			/* power on: the sensor is back to defaults, the shadow forgets */
+			sim_reset(&s_sim);
+			sim_reset(&s_ref);
+			sensor_reg_shadow_clear(&shadow);
+			if (send(&shadow, &ops, &stat, &s_init))
+				goto Fail;
+		}
+		if (send(&shadow, &ops, &stat, &s_mode[rand() % MODE_NUM]))
+			goto Fail;
+
+		/* exposure and gain, written one by one like Sensor_WriteReg() */
+		for (j = 0; j < AE_WRITES; j++) {
+			cmr_u16 addr = (cmr_u16)(0x3500 + rand() % 6);
+			cmr_u16 value = (cmr_u16)(rand() & 0xff);
+
+			sim_write(&s_sim, addr, value);
+			sim_write(&s_ref, addr, value);
+			sensor_reg_shadow_update(&shadow, addr, value);
+		}
+	}
+	sensor_reg_shadow_deinit(&shadow);
+
+	printf("%s: %u regs, %u skipped, %u single, %u bursts (%u regs)\n",
+	       name, stat.reg_count, stat.skipped, stat.singles,
+	       stat.bursts, stat.burst_regs);
+	printf("%s: %lu transfers, %lu bytes, full write %lu transfers, %lu bytes\n",
+	       name, s_sim.xfers, s_sim.bytes, s_ref.xfers, s_ref.bytes);
+	return 0;
+
+Fail:
+	sensor_reg_shadow_deinit(&shadow);
+	printf("%s: switch %d FAILED\n", name, i);
+	return -1;
+}
+
+int main(int argc, char** argv)
+{
+	int switches = argc > 1 ? atoi(argv[1]) : DEF_SWITCHES;
+
+	if (switches <= 0) {
+		printf("Usage: utest_sensor_regs [switches]\n");
+		return 1;
+	}
+
+	make_tabs();
+	printf("utest_sensor_regs -- init %u entries, %d modes of %u to %u entries, %d switches\n",
+	       s_init.count, MODE_NUM, s_mode[0].count, s_mode[MODE_NUM - 1].count, switches);
+
+	if (run("delta", 0, switches) || run("delta+burst", 1, switches))
+		return 1;
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,15 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_slogstor
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../slogmodem
+LOCAL_SRC_FILES:= utest_slogstor.cpp \
+	../../slogmodem/cp_dir.cpp \
+	../../slogmodem/cp_set_dir.cpp \
+	../../slogmodem/log_file.cpp \
+	../../slogmodem/log_index.cpp \
+	../../slogmodem/media_stor.cpp \
+	../../slogmodem/parse_utils.cpp
+LOCAL_CPPFLAGS += -std=c++11 -DHOST_TEST_
+include $(BUILD_HOST_EXECUTABLE)
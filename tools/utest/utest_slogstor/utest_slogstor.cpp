@@ -0,0 +1,418 @@
+/*
+ *  utest_slogstor.cpp - host benchmark of the slogmodem log storage.
+ *
+ *  History:
+ *  2026-10-19
+ *  Initial version.
+ */
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "cp_dir.h"
+#include "cp_set_dir.h"
+#include "file_watcher.h"
+#include "log_file.h"
+#include "media_stor.h"
+#include "stor_mgr.h"
+
+#define DEF_TOP_DIR     "/tmp/utest_slogstor"
+#define DEF_FILE_NUM    5000
+#define CP_NAME         "w"
+#define SET_NAME        "2015-06-01-00-00-00"
+#define UNKNOWN_NUM     8
+#define SIPC_EVERY      100
+#define LOG_SIZE        (1024 * 1024)
+#define SIPC_SIZE       (64 * 1024)
+#define UNKNOWN_SIZE    4096
+#define VERSION_SIZE    1024
+#define ROUNDS          5
+#define MAX_TRIMS       1000
+#define ROTATIONS       200
+#define WRITE_SIZE      (64 * 1024)
+
+// Only called when the working directory is removed under slogmodem
+void StorageManager::proc_working_dir_removed()
+{
+}
+
+// No file watch is set up without a FileWatcher
+int FileWatcher::del(FileWatch* /*fw*/)
+{
+	return 0;
+}
+
+static char s_cp_dir[256];
+static char s_manifest[256];
+// File names in the expected trimming order
+static LogVector<LogString> s_names;
+static uint64_t s_total;
+
+static long long now_us()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int make_file(const char* name, off_t size)
+{
+	char path[512];
+
+	snprintf(path, sizeof path, "%s/%s", s_cp_dir, name);
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	// Sparse files, only the sizes matter
+	int ret = ftruncate(fd, size);
+	close(fd);
+	if (ret) {
+		perror(path);
+		return -1;
+	}
+	s_names.push_back(LogString(name));
+	s_total += size;
+	return 0;
+}
+
+static int make_history(const char* top, int num)
+{
+	char cmd[512];
+	char name[128];
+	struct tm base_tm;
+	time_t base;
+
+	snprintf(cmd, sizeof cmd, "rm -fr %s && mkdir -p %s/modem_log/%s/%s",
+		 top, top, SET_NAME, CP_NAME);
+	if (system(cmd)) {
+		return -1;
+	}
+	snprintf(s_cp_dir, sizeof s_cp_dir, "%s/modem_log/%s/%s",
+		 top, SET_NAME, CP_NAME);
+	snprintf(s_manifest, sizeof s_manifest, "%s/modem_log/%s/.%s.manifest",
+		 top, SET_NAME, CP_NAME);
+
+	for (int i = 0; i < UNKNOWN_NUM; ++i) {
+		snprintf(name, sizeof name, "notes_%d.txt", i);
+		if (make_file(name, UNKNOWN_SIZE)) {
+			return -1;
+		}
+	}
+
+	memset(&base_tm, 0, sizeof base_tm);
+	base_tm.tm_year = 2015 - 1900;
+	base_tm.tm_mon = 5;
+	base_tm.tm_mday = 1;
+	base = timegm(&base_tm);
+
+	for (int i = 0; i < num; ++i) {
+		struct tm t;
+		time_t ft = base + i * 60;
+
+		gmtime_r(&ft, &t);
+		snprintf(name, sizeof name,
+			 "%d-" CP_NAME "-%04d-%02d-%02d_%02d-%02d-%02d.log",
+			 num - i, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
+			 t.tm_hour, t.tm_min, t.tm_sec);
+		if (make_file(name, LOG_SIZE)) {
+			return -1;
+		}
+		if (!(i % SIPC_EVERY)) {
+			ft += 30;
+			gmtime_r(&ft, &t);
+			snprintf(name, sizeof name,
+				 "sblock_%04d-%02d-%02d_%02d-%02d-%02d",
+				 t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
+				 t.tm_hour, t.tm_min, t.tm_sec);
+			if (make_file(name, SIPC_SIZE)) {
+				return -1;
+			}
+		}
+	}
+
+	return make_file(CP_NAME ".version", VERSION_SIZE);
+}
+
+static bool file_exists(const LogString& name)
+{
+	LogString path = LogString(s_cp_dir) + "/" + name;
+	return !access(ls2cstring(path), F_OK);
+}
+
+static MediaStorage* open_storage(const char* top, long long& us)
+{
+	MediaStorage* ms = new MediaStorage(0, LogString(top));
+	long long t0 = now_us();
+
+	if (ms->init(0)) {
+		delete ms;
+		return 0;
+	}
+	us = now_us() - t0;
+	return ms;
+}
+
+static int bench_init(const char* top)
+{
+	long long scan_us = 0;
+	long long manifest_us = 0;
+
+	for (int i = 0; i < ROUNDS; ++i) {
+		long long us;
+		MediaStorage* ms;
+
+		unlink(s_manifest);
+		ms = open_storage(top, us);
+		if (!ms || ms->size() != s_total) {
+			printf("scan: wrong size\n");
+			delete ms;
+			return -1;
+		}
+		delete ms;
+		scan_us += us;
+
+		if (access(s_manifest, F_OK)) {
+			printf("manifest not written\n");
+			return -1;
+		}
+		ms = open_storage(top, us);
+		if (!ms || ms->size() != s_total) {
+			printf("manifest: wrong size\n");
+			delete ms;
+			return -1;
+		}
+		delete ms;
+		manifest_us += us;
+	}
+
+	printf("init by scan: %lld us, by manifest: %lld us\n",
+	       scan_us / ROUNDS, manifest_us / ROUNDS);
+	return 0;
+}
+
+// Add or remove a file behind the manifest, the directory mtime put back
+static int change_behind(const char* name, bool add)
+{
+	char path[512];
+	struct stat dir_stat;
+	struct timeval tv[2];
+
+	snprintf(path, sizeof path, "%s/%s", s_cp_dir, name);
+	if (stat(s_cp_dir, &dir_stat)) {
+		perror(s_cp_dir);
+		return -1;
+	}
+	if (add) {
+		int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 || ftruncate(fd, UNKNOWN_SIZE)) {
+			perror(path);
+			if (fd >= 0) {
+				close(fd);
+			}
+			return -1;
+		}
+		close(fd);
+	} else if (unlink(path)) {
+		perror(path);
+		return -1;
+	}
+
+	tv[0].tv_sec = dir_stat.st_atime;
+	tv[0].tv_usec = 0;
+	tv[1].tv_sec = dir_stat.st_mtime;
+	tv[1].tv_usec = 0;
+	if (utimes(s_cp_dir, tv)) {
+		perror(s_cp_dir);
+		return -1;
+	}
+	return 0;
+}
+
+static int check_stale(const char* top)
+{
+	long long us;
+	MediaStorage* ms;
+
+	// The manifest left by bench_init() lists one file less
+	if (change_behind("stale.txt", true)) {
+		return -1;
+	}
+	ms = open_storage(top, us);
+	if (!ms || ms->size() != s_total + UNKNOWN_SIZE) {
+		printf("stale: added file not seen\n");
+		delete ms;
+		return -1;
+	}
+	delete ms;
+
+	// The scan rewrote it, now it lists one file more
+	if (change_behind("stale.txt", false)) {
+		return -1;
+	}
+	ms = open_storage(top, us);
+	if (!ms || ms->size() != s_total) {
+		printf("stale: removed file still seen\n");
+		delete ms;
+		return -1;
+	}
+	delete ms;
+
+	printf("stale: OK\n");
+	return 0;
+}
+
+static int bench_trim(MediaStorage* ms, int trims)
+{
+	long long total_us = 0;
+	long long max_us = 0;
+
+	for (int i = 0; i < trims; ++i) {
+		ms->set_total_limit(ms->size() - 1);
+
+		long long t0 = now_us();
+		ms->check_quota(0);
+		long long us = now_us() - t0;
+
+		total_us += us;
+		if (us > max_us) {
+			max_us = us;
+		}
+		// Exactly the oldest file shall be gone. Files of unknown
+		// type are trimmed first, in no particular order.
+		bool ok;
+		if (i < UNKNOWN_NUM) {
+			int left = 0;
+			for (int j = 0; j < UNKNOWN_NUM; ++j) {
+				left += file_exists(s_names[j]);
+			}
+			ok = UNKNOWN_NUM - i - 1 == left &&
+			     file_exists(s_names[UNKNOWN_NUM]);
+		} else {
+			ok = !file_exists(s_names[i]) &&
+			     file_exists(s_names[i + 1]);
+		}
+		if (!ok) {
+			printf("trim %d: %s is not the oldest\n", i,
+			       ls2cstring(s_names[i]));
+			return -1;
+		}
+		// Until stop() the manifest is gone, not stale
+		if (!access(s_manifest, F_OK)) {
+			printf("trim %d: manifest kept\n", i);
+			return -1;
+		}
+	}
+
+	printf("trim: %d files, %lld us avg, %lld us max\n",
+	       trims, total_us / trims, max_us);
+	return 0;
+}
+
+static int bench_rotate(MediaStorage* ms)
+{
+	static char buf[WRITE_SIZE];
+	LogFile* f = ms->create_cp_file(LogString(CP_NAME));
+
+	if (!f) {
+		printf("can not create the working directory\n");
+		return -1;
+	}
+
+	CpDirectory* cp_dir = f->dir();
+	long long total_us = 0;
+	long long max_us = 0;
+
+	ms->set_total_limit(ms->size());
+	for (int i = 0; i < ROTATIONS; ++i) {
+		if (f->write(buf, sizeof buf) != sizeof buf) {
+			printf("write error\n");
+			return -1;
+		}
+
+		// The same steps as CpStorage::write_data on a full log
+		long long t0 = now_us();
+		cp_dir->close_log_file();
+		cp_dir->rotate();
+		f = cp_dir->create_log_file();
+		if (!f) {
+			printf("can not create log file\n");
+			return -1;
+		}
+		ms->check_quota(cp_dir);
+		long long us = now_us() - t0;
+
+		total_us += us;
+		if (us > max_us) {
+			max_us = us;
+		}
+	}
+
+	printf("rotate: %d rotations, %lld us avg, %lld us max\n",
+	       ROTATIONS, total_us / ROTATIONS, max_us);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* top = argc > 1 ? argv[1] : DEF_TOP_DIR;
+	int num = argc > 2 ? atoi(argv[2]) : DEF_FILE_NUM;
+
+	if (num < 2) {
+		printf("Usage: utest_slogstor [dir] [file_num]\n");
+		return 1;
+	}
+
+	if (make_history(top, num)) {
+		return 1;
+	}
+	printf("utest_slogstor -- %u files, %llu bytes\n",
+	       static_cast<unsigned>(s_names.size()),
+	       static_cast<unsigned long long>(s_total));
+
+	// The manifest is not written in the second the directory changes.
+	sleep(1);
+
+	if (bench_init(top) || check_stale(top)) {
+		return 1;
+	}
+
+	long long us;
+	MediaStorage* ms = open_storage(top, us);
+	if (!ms) {
+		return 1;
+	}
+
+	int trims = static_cast<int>(s_names.size()) - 2;
+	if (trims > MAX_TRIMS) {
+		trims = MAX_TRIMS;
+	}
+	if (bench_trim(ms, trims) || bench_rotate(ms)) {
+		delete ms;
+		return 1;
+	}
+
+	// The storage seen after a restart shall be the same
+	uint64_t size = ms->size();
+	ms->stop();
+	delete ms;
+	ms = open_storage(top, us);
+	if (!ms || ms->size() != size) {
+		printf("restart: wrong size\n");
+		delete ms;
+		return 1;
+	}
+	delete ms;
+	printf("restart: OK\n");
+
+	return 0;
+}
@@ -0,0 +1,12 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_sw_cvt
+LOCAL_MODULE_TAGS:= debug
+LOCAL_CFLAGS += -include stdint.h
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libcamera/oem/inc \
+	$(LOCAL_PATH)/../../../libs/libcamera/mtrace
+LOCAL_SRC_FILES:= utest_sw_cvt.c \
+	../../../libs/libcamera/oem/src/cmr_sw_cvt.c
+LOCAL_LDLIBS:= -lrt -lpthread
+include $(BUILD_HOST_EXECUTABLE)
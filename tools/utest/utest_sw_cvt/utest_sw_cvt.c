@@ -0,0 +1,556 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cmr_sw_cvt.h"
+
+#define RANDOM_CASES    200
+#define BENCH_LOOPS     5
+#define SHARED_CALLERS  3
+#define SHARED_LOOPS    10
+/* scale error against the float model: two roundings and 1/256 positions */
+#define SCALE_TOL       2
+
+struct img {
+	struct cmr_sw_frame     f;
+	cmr_u8                  *buf;
+};
+
+struct bench {
+	const char              *name;
+	cmr_u32                 layout;
+	cmr_u32                 w;
+	cmr_u32                 h;
+	/* scale when angle is CMR_SW_CVT_ANGLE_MAX */
+	cmr_u32                 angle;
+	struct cmr_sw_rect      rect;
+	cmr_u32                 dw;
+	cmr_u32                 dh;
+};
+
+static const struct bench s_bench[] = {
+	{"crop 13M",      CMR_SW_CVT_SEMIPLANAR, 4160, 3120, CMR_SW_CVT_ANGLE_MAX, {416, 312, 3328, 2496}, 3328, 2496},
+	{"area 13M/2",    CMR_SW_CVT_SEMIPLANAR, 4160, 3120, CMR_SW_CVT_ANGLE_MAX, {0, 0, 4160, 3120}, 2080, 1560},
+	{"area thumb",    CMR_SW_CVT_SEMIPLANAR, 4160, 3120, CMR_SW_CVT_ANGLE_MAX, {0, 0, 4160, 3120}, 320, 240},
+	{"bilinear 720p", CMR_SW_CVT_SEMIPLANAR, 1920, 1080, CMR_SW_CVT_ANGLE_MAX, {0, 0, 1920, 1080}, 1280, 720},
+	{"to planar",     CMR_SW_CVT_SEMIPLANAR, 1920, 1080, CMR_SW_CVT_ANGLE_MAX, {0, 0, 1920, 1080}, 1920, 1080},
+	{"rot 90 1080p",  CMR_SW_CVT_SEMIPLANAR, 1920, 1080, CMR_SW_CVT_ROT_90, {0, 0, 0, 0}, 1080, 1920},
+	{"rot 90 13M",    CMR_SW_CVT_SEMIPLANAR, 4160, 3120, CMR_SW_CVT_ROT_90, {0, 0, 0, 0}, 3120, 4160},
+	{"rot 180 13M",   CMR_SW_CVT_SEMIPLANAR, 4160, 3120, CMR_SW_CVT_ROT_180, {0, 0, 0, 0}, 4160, 3120},
+	{"mirror 1080p",  CMR_SW_CVT_PLANAR,     1920, 1080, CMR_SW_CVT_MIRROR, {0, 0, 0, 0}, 1920, 1080},
+};
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int img_alloc(struct img *m, cmr_u32 layout, cmr_u32 w, cmr_u32 h, cmr_u32 stride)
+{
+	cmr_u32 y_size = stride * h;
+	cmr_u32 size = y_size * 3 / 2;
+
+	memset(m, 0, sizeof(*m));
+	m->buf = (cmr_u8 *)malloc(size);
+	if (!m->buf)
+		return -1;
+	memset(m->buf, 0x5a, size);
+	m->f.layout = layout;
+	m->f.width = w;
+	m->f.height = h;
+	m->f.stride = stride;
+	m->f.y = m->buf;
+	m->f.u = m->buf + y_size;
+	m->f.v = CMR_SW_CVT_PLANAR == layout ? m->f.u + y_size / 4 : NULL;
+	return 0;
+}
+
+static void img_free(struct img *m)
+{
+	free(m->buf);
+	m->buf = NULL;
+}
+
+/* component c (0 y, 1 u, 2 v) at x, y of its own plane */
+static cmr_u8 *comp(const struct cmr_sw_frame *f, cmr_u32 c, cmr_u32 x, cmr_u32 y)
+{
+	if (0 == c)
+		return f->y + y * f->stride + x;
+	if (CMR_SW_CVT_SEMIPLANAR == f->layout)
+		return f->u + y * f->stride + 2 * x + c - 1;
+	return (1 == c ? f->u : f->v) + y * (f->stride / 2) + x;
+}
+
+/* smooth for the float model, noisy for the bit exact runs */
+static void img_fill(struct img *m, cmr_u32 noise)
+{
+	cmr_u32 c, x, y, w, h, v;
+
+	for (c = 0; c < 3; c++) {
+		w = c ? m->f.width / 2 : m->f.width;
+		h = c ? m->f.height / 2 : m->f.height;
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				if (noise)
+					v = rand() & 255;
+				else
+					v = (x * 3 + y * 2 + c * 40) % 200 + 20 + (rand() & 3);
+				*comp(&m->f, c, x, y) = (cmr_u8)v;
+			}
+		}
+	}
+}
+
+static int img_same(const struct img *a, const struct img *b)
+{
+	cmr_u32 c, x, y, w, h;
+
+	for (c = 0; c < 3; c++) {
+		w = c ? a->f.width / 2 : a->f.width;
+		h = c ? a->f.height / 2 : a->f.height;
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++)
+				if (*comp(&a->f, c, x, y) != *comp(&b->f, c, x, y))
+					return 0;
+	}
+	return 1;
+}
+
+/* ---------------------------------------------------------- float model */
+
+/* weight of source tap t for output i of an axis, as documented */
+static double axis_weight(cmr_u32 s, cmr_u32 d, cmr_u32 i, cmr_u32 t)
+{
+	double pos, f;
+	cmr_u32 a, b, i0;
+
+	if (s == d)
+		return t == i ? 1.0 : 0.0;
+
+	if (s >= 2 * d) {
+		a = (cmr_u32)((unsigned long long)i * s / d);
+		b = (cmr_u32)((unsigned long long)(i + 1) * s / d);
+		return t >= a && t < b ? 1.0 / (b - a) : 0.0;
+	}
+
+	pos = (i + 0.5) * s / d - 0.5;
+	if (pos < 0)
+		pos = 0;
+	if (pos > s - 1)
+		pos = s - 1;
+	i0 = (cmr_u32)pos;
+	f = pos - i0;
+	if (t == i0)
+		return 1.0 - f;
+	if (t == i0 + 1)
+		return f;
+	return 0.0;
+}
+
+static int check_scale(const struct img *src, const struct cmr_sw_rect *r, const struct img *dst)
+{
+	cmr_u32 c, x, y, tx, ty, sw, sh, dw, dh, ox, oy;
+	double v, wy, wx;
+	int d;
+
+	for (c = 0; c < 3; c++) {
+		sw = c ? r->w / 2 : r->w;
+		sh = c ? r->h / 2 : r->h;
+		ox = c ? r->x / 2 : r->x;
+		oy = c ? r->y / 2 : r->y;
+		dw = c ? dst->f.width / 2 : dst->f.width;
+		dh = c ? dst->f.height / 2 : dst->f.height;
+		for (y = 0; y < dh; y++) {
+			for (x = 0; x < dw; x++) {
+				v = 0;
+				for (ty = 0; ty < sh; ty++) {
+					wy = axis_weight(sh, dh, y, ty);
+					if (0.0 == wy)
+						continue;
+					for (tx = 0; tx < sw; tx++) {
+						wx = axis_weight(sw, dw, x, tx);
+						if (0.0 != wx)
+							v += wy * wx * *comp(&src->f, c, ox + tx, oy + ty);
+					}
+				}
+				d = (int)*comp(&dst->f, c, x, y) - (int)(v + 0.5);
+				if (d > SCALE_TOL || d < -SCALE_TOL) {
+					printf("scale %ux%u -> %ux%u: comp %u at %u,%u is %u, model %.2f\n",
+						r->w, r->h, dst->f.width, dst->f.height, c, x, y,
+						*comp(&dst->f, c, x, y), v);
+					return -1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+static int check_rotate(const struct img *src, const struct img *dst, cmr_u32 angle)
+{
+	cmr_u32 c, x, y, w, h, dx, dy;
+
+	for (c = 0; c < 3; c++) {
+		w = c ? src->f.width / 2 : src->f.width;
+		h = c ? src->f.height / 2 : src->f.height;
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				switch (angle) {
+				case CMR_SW_CVT_ROT_90:
+					dx = h - 1 - y;
+					dy = x;
+					break;
+				case CMR_SW_CVT_ROT_270:
+					dx = y;
+					dy = w - 1 - x;
+					break;
+				case CMR_SW_CVT_ROT_180:
+					dx = w - 1 - x;
+					dy = h - 1 - y;
+					break;
+				default:
+					dx = w - 1 - x;
+					dy = y;
+					break;
+				}
+				if (*comp(&dst->f, c, dx, dy) != *comp(&src->f, c, x, y)) {
+					printf("rotate %u of %ux%u: comp %u at %u,%u\n",
+						angle, src->f.width, src->f.height, c, x, y);
+					return -1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/* ------------------------------------------------------------- golden */
+
+static int golden_scale(cmr_u32 sl, cmr_u32 dl, cmr_u32 w, cmr_u32 h,
+			cmr_u32 rx, cmr_u32 ry, cmr_u32 rw, cmr_u32 rh, cmr_u32 dw, cmr_u32 dh)
+{
+	struct img src, dst;
+	struct cmr_sw_rect r = {rx, ry, rw, rh};
+	int ret = -1;
+
+	if (img_alloc(&src, sl, w, h, w + 32) || img_alloc(&dst, dl, dw, dh, dw))
+		return -1;
+	img_fill(&src, 0);
+	if (0 == cmr_sw_scale(&src.f, &r, &dst.f))
+		ret = check_scale(&src, &r, &dst);
+	else
+		printf("scale %ux%u -> %ux%u refused\n", rw, rh, dw, dh);
+	img_free(&src);
+	img_free(&dst);
+	return ret;
+}
+
+static int golden_rotate(cmr_u32 layout, cmr_u32 w, cmr_u32 h, cmr_u32 angle)
+{
+	struct img src, dst, back;
+	cmr_u32 turn = CMR_SW_CVT_ROT_90 == angle || CMR_SW_CVT_ROT_270 == angle;
+	cmr_u32 dw = turn ? h : w, dh = turn ? w : h;
+	cmr_u32 undo = CMR_SW_CVT_ROT_90 == angle ? CMR_SW_CVT_ROT_270
+		: CMR_SW_CVT_ROT_270 == angle ? CMR_SW_CVT_ROT_90 : angle;
+	int ret = -1;
+
+	if (img_alloc(&src, layout, w, h, w + 64) || img_alloc(&dst, layout, dw, dh, dw + 16)
+		|| img_alloc(&back, layout, w, h, w))
+		return -1;
+	img_fill(&src, 1);
+	if (0 == cmr_sw_rotate(&src.f, &dst.f, angle) && 0 == check_rotate(&src, &dst, angle)
+		&& 0 == cmr_sw_rotate(&dst.f, &back.f, undo)) {
+		if (img_same(&src, &back))
+			ret = 0;
+		else
+			printf("rotate %u of %ux%u does not come back\n", angle, w, h);
+	}
+	img_free(&src);
+	img_free(&dst);
+	img_free(&back);
+	return ret;
+}
+
+static int golden(void)
+{
+	static const cmr_u32 size[][2] = {{64, 48}, {66, 34}, {130, 98}, {18, 202}};
+	cmr_u32 i, a, sl, dl;
+
+	for (sl = 0; sl < CMR_SW_CVT_LAYOUT_MAX; sl++) {
+		for (dl = 0; dl < CMR_SW_CVT_LAYOUT_MAX; dl++) {
+			/* crop, 2x and 3x area, odd area, bilinear down and up, mixed axes */
+			if (golden_scale(sl, dl, 128, 96, 10, 6, 64, 48, 64, 48)
+				|| golden_scale(sl, dl, 128, 96, 0, 0, 128, 96, 64, 48)
+				|| golden_scale(sl, dl, 132, 96, 0, 0, 132, 96, 44, 32)
+				|| golden_scale(sl, dl, 130, 98, 2, 4, 126, 90, 50, 34)
+				|| golden_scale(sl, dl, 128, 96, 0, 0, 128, 96, 96, 72)
+				|| golden_scale(sl, dl, 64, 48, 4, 2, 40, 30, 100, 78)
+				|| golden_scale(sl, dl, 128, 96, 0, 0, 128, 96, 40, 80))
+				return -1;
+		}
+		for (i = 0; i < sizeof(size) / sizeof(size[0]); i++)
+			for (a = 0; a < CMR_SW_CVT_ANGLE_MAX; a++)
+				if (golden_rotate(sl, size[i][0], size[i][1], a))
+					return -1;
+	}
+	return 0;
+}
+
+/* ---------------------------------------------------------- bit exact */
+
+static cmr_u32 rand_even(cmr_u32 lo, cmr_u32 hi)
+{
+	return (lo + rand() % (hi - lo + 1)) & ~1;
+}
+
+static int exact_case(void)
+{
+	struct img src, ref, out;
+	struct cmr_sw_rect r;
+	cmr_u32 sl = rand() & 1, dl = rand() & 1;
+	cmr_u32 w = rand_even(2, 1400), h = rand_even(2, 1100);
+	cmr_u32 angle = rand() % (CMR_SW_CVT_ANGLE_MAX + 1);
+	cmr_u32 dw, dh, turn;
+	int ret = -1;
+
+	if (w < 2)
+		w = 2;
+	if (h < 2)
+		h = 2;
+	r.w = rand_even(2, w);
+	r.h = rand_even(2, h);
+	r.w = r.w < 2 ? 2 : r.w;
+	r.h = r.h < 2 ? 2 : r.h;
+	r.x = rand_even(0, w - r.w);
+	r.y = rand_even(0, h - r.h);
+	turn = CMR_SW_CVT_ROT_90 == angle || CMR_SW_CVT_ROT_270 == angle;
+	if (CMR_SW_CVT_ANGLE_MAX == angle) {
+		dw = rand_even(2, 1400);
+		dh = rand_even(2, 1100);
+		dw = dw < 2 ? 2 : dw;
+		dh = dh < 2 ? 2 : dh;
+		/* the halving paths */
+		if (0 == (rand() & 3) && r.w >= 4) {
+			r.w &= ~3;
+			dw = r.w / 2;
+			dh = r.h >= 4 ? (r.h & ~3) / 2 : dh;
+		}
+	} else {
+		dl = sl;
+		dw = turn ? h : w;
+		dh = turn ? w : h;
+	}
+
+	if (img_alloc(&src, sl, w, h, w + (rand() & 30))
+		|| img_alloc(&ref, dl, dw, dh, dw) || img_alloc(&out, dl, dw, dh, dw))
+		return -1;
+	img_fill(&src, 1);
+
+	cmr_sw_cvt_config(0, 1);
+	if (CMR_SW_CVT_ANGLE_MAX == angle)
+		ret = cmr_sw_scale(&src.f, &r, &ref.f);
+	else
+		ret = cmr_sw_rotate(&src.f, &ref.f, angle);
+
+	cmr_sw_cvt_config(1, CMR_SW_CVT_THREAD_MAX);
+	if (0 == ret) {
+		if (CMR_SW_CVT_ANGLE_MAX == angle)
+			ret = cmr_sw_scale(&src.f, &r, &out.f);
+		else
+			ret = cmr_sw_rotate(&src.f, &out.f, angle);
+	}
+	if (0 == ret && !img_same(&ref, &out)) {
+		printf("%s %ux%u rect %u,%u %ux%u -> %ux%u differs\n",
+			CMR_SW_CVT_ANGLE_MAX == angle ? "scale" : "rotate",
+			w, h, r.x, r.y, r.w, r.h, dw, dh);
+		ret = -1;
+	}
+
+	img_free(&src);
+	img_free(&ref);
+	img_free(&out);
+	return ret ? -1 : 0;
+}
+
+static int refused(void)
+{
+	struct img a, b;
+	struct cmr_sw_rect r = {0, 0, 64, 48};
+	int ret = 0;
+
+	if (img_alloc(&a, CMR_SW_CVT_SEMIPLANAR, 64, 48, 64) || img_alloc(&b, CMR_SW_CVT_PLANAR, 48, 64, 48))
+		return -1;
+
+	/* rect out of the frame, odd rect, rotation across layouts, wrong size */
+	r.x = 2;
+	ret |= 0 == cmr_sw_scale(&a.f, &r, &b.f);
+	r.x = 0;
+	r.w = 63;
+	ret |= 0 == cmr_sw_scale(&a.f, &r, &b.f);
+	ret |= 0 == cmr_sw_rotate(&a.f, &b.f, CMR_SW_CVT_ROT_90);
+	b.f.layout = CMR_SW_CVT_SEMIPLANAR;
+	ret |= 0 == cmr_sw_rotate(&a.f, &b.f, CMR_SW_CVT_ROT_180);
+	ret |= 0 == cmr_sw_rotate(&a.f, &b.f, CMR_SW_CVT_ANGLE_MAX);
+
+	img_free(&a);
+	img_free(&b);
+	if (ret)
+		printf("bad parameters accepted\n");
+	return ret ? -1 : 0;
+}
+
+/* ------------------------------------------------------------- shared */
+
+struct shared_caller {
+	pthread_t thread;
+	struct img *src;
+	struct img *ref;
+	struct img out;
+	cmr_u32 angle;
+	int errors;
+};
+
+static void *shared_proc(void *data)
+{
+	struct shared_caller *c = (struct shared_caller *)data;
+	cmr_u32 i;
+
+	for (i = 0; i < SHARED_LOOPS; i++) {
+		memset(c->out.buf, 0, c->out.f.stride * c->out.f.height * 3 / 2);
+		if (cmr_sw_rotate(&c->src->f, &c->out.f, c->angle) || !img_same(c->ref, &c->out))
+			c->errors++;
+	}
+	return NULL;
+}
+
+/*
+ * Callers of several threads at once, large enough to be split: the one
+ * holding the workers and the ones running in their own thread shall all
+ * get the frame of a single thread.
+ */
+static int shared(void)
+{
+	struct shared_caller caller[SHARED_CALLERS];
+	struct img src, ref[2];
+	cmr_u32 i;
+	int errors = 0;
+
+	if (img_alloc(&src, CMR_SW_CVT_SEMIPLANAR, 1920, 1080, 1920)
+		|| img_alloc(&ref[0], CMR_SW_CVT_SEMIPLANAR, 1080, 1920, 1080)
+		|| img_alloc(&ref[1], CMR_SW_CVT_SEMIPLANAR, 1920, 1080, 1920))
+		return -1;
+	img_fill(&src, 1);
+
+	cmr_sw_cvt_config(1, 1);
+	if (cmr_sw_rotate(&src.f, &ref[0].f, CMR_SW_CVT_ROT_90)
+		|| cmr_sw_rotate(&src.f, &ref[1].f, CMR_SW_CVT_ROT_180))
+		return -1;
+	cmr_sw_cvt_config(1, CMR_SW_CVT_THREAD_MAX);
+
+	for (i = 0; i < SHARED_CALLERS; i++) {
+		caller[i].src = &src;
+		caller[i].ref = &ref[i & 1];
+		caller[i].angle = (i & 1) ? CMR_SW_CVT_ROT_180 : CMR_SW_CVT_ROT_90;
+		caller[i].errors = 0;
+		if (img_alloc(&caller[i].out, CMR_SW_CVT_SEMIPLANAR, caller[i].ref->f.width,
+			caller[i].ref->f.height, caller[i].ref->f.width))
+			return -1;
+		if (pthread_create(&caller[i].thread, NULL, shared_proc, &caller[i]))
+			return -1;
+	}
+
+	for (i = 0; i < SHARED_CALLERS; i++) {
+		pthread_join(caller[i].thread, NULL);
+		errors += caller[i].errors;
+		img_free(&caller[i].out);
+	}
+
+	img_free(&src);
+	img_free(&ref[0]);
+	img_free(&ref[1]);
+	if (errors)
+		printf("shared         %d frames differ\n", errors);
+	return errors ? -1 : 0;
+}
+
+/* -------------------------------------------------------------- bench */
+
+static double bench_ms(const struct bench *b, struct img *src, struct img *dst)
+{
+	long long t0 = now_ns();
+	cmr_u32 i;
+
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		if (CMR_SW_CVT_ANGLE_MAX == b->angle)
+			cmr_sw_scale(&src->f, &b->rect, &dst->f);
+		else
+			cmr_sw_rotate(&src->f, &dst->f, b->angle);
+	}
+	return (now_ns() - t0) / 1e6 / BENCH_LOOPS;
+}
+
+static int bench(void)
+{
+	const struct bench *b;
+	struct img src, dst;
+	double c_ms, simd_ms, thr_ms;
+	cmr_u32 i, dl;
+
+	for (i = 0; i < sizeof(s_bench) / sizeof(s_bench[0]); i++) {
+		b = &s_bench[i];
+		dl = b->layout;
+		if (CMR_SW_CVT_ANGLE_MAX == b->angle && b->w == b->dw)
+			dl = !b->layout;
+		if (img_alloc(&src, b->layout, b->w, b->h, b->w) || img_alloc(&dst, dl, b->dw, b->dh, b->dw))
+			return -1;
+		img_fill(&src, 1);
+
+		cmr_sw_cvt_config(0, 1);
+		c_ms = bench_ms(b, &src, &dst);
+		cmr_sw_cvt_config(1, 1);
+		simd_ms = bench_ms(b, &src, &dst);
+		cmr_sw_cvt_config(1, CMR_SW_CVT_THREAD_MAX);
+		thr_ms = bench_ms(b, &src, &dst);
+
+		printf("%-14s C %6.2f ms, simd %6.2f ms, threads %6.2f ms per frame\n",
+			b->name, c_ms, simd_ms, thr_ms);
+		img_free(&src);
+		img_free(&dst);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int seed = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+	cmr_u32 i;
+
+	srand(seed);
+	printf("utest_sw_cvt -- %s, seed %u\n", CMR_SW_CVT_SIMD ? "simd" : "C only", seed);
+
+	cmr_sw_cvt_config(1, CMR_SW_CVT_THREAD_MAX);
+	if (golden() || refused())
+		return 1;
+	printf("golden         crop, area, bilinear and layouts within %d of the model, rotations exact\n",
+		SCALE_TOL);
+
+	for (i = 0; i < RANDOM_CASES; i++)
+		if (exact_case())
+			return 1;
+	printf("exact          simd and threads same as C on %d random cases\n", RANDOM_CASES);
+
+	if (shared())
+		return 1;
+	printf("shared         %d callers at once, %d frames each same as one thread\n",
+		SHARED_CALLERS, SHARED_LOOPS);
+
+	if (bench())
+		return 1;
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,9 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_vsp_stream
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libstagefrighthw/include
+LOCAL_SRC_FILES:= utest_vsp_stream.cpp \
+	../../../libs/libstagefrighthw/SprdStreamBuffer.cpp
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,562 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "SprdStreamBuffer.h"
+
+using namespace android;
+
+/* H264_DECODER_STREAM_BUFFER_SIZE of SPRDAVCDecoder.h */
+#define HEAP_SIZE           (2 * 1024 * 1024)
+#define HEAP_PHYS           0x80000000u
+
+/* the input buffers the decoders ask for at 1080p */
+#define INPUT_BUFFERS       4
+#define INPUT_SIZE          (1024 * 1024)
+#define INPUT_PHYS          0x90000000u
+
+#define FPS                 30
+#define SECONDS             10
+#define GOP                 30
+#define SLICES              4
+
+enum {
+    CODEC_AVC,
+    CODEC_MPEG4,
+    CODEC_VPX,
+    CODEC_NUM,
+};
+
+/* 1080p bitrates of the three decoders' usual content */
+static const int s_bitrates[CODEC_NUM] = { 12000000, 8000000, 10000000 };
+
+/*
+ *  The decoders as they run: AVC without zero padding, as by default,
+ *  and with it, as with debug.sprd.avc.zero_pad 1.
+ * */
+static const struct {
+    const char *name;
+    int codec;
+    bool byteStream;
+} s_configs[] = {
+    { "avc  ", CODEC_AVC, false },
+    { "avc-z", CODEC_AVC, true },
+    { "mpeg4", CODEC_MPEG4, false },
+    { "vpx  ", CODEC_VPX, false },
+};
+
+enum {
+    MODE_LEGACY,        /* every decode call copies what is left to the heap */
+    MODE_CLIENT,        /* client buffers, copied once */
+    MODE_ALLOCATED,     /* allocated input buffers, read in place */
+    MODE_NUM,
+};
+
+static const char *s_modeNames[MODE_NUM] = { "legacy   ", "client   ", "allocated" };
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+/*
+ *  A buffer the stub decoder may be handed an address in, with its
+ *  physical address when it has one.
+ * */
+struct region {
+    uint8_t *v;
+    uint32_t phys;
+    size_t size;
+};
+
+/*
+ *  Stub of the decoder libraries: it checks the span against the access
+ *  unit it should see and reports how much of it it consumed. The AVC
+ *  decoder takes zero bytes in front of a start code and consumes them
+ *  and one NAL unit a call, the others the whole span. The first call
+ *  for an access unit may ask for the span again, as
+ *  MMDEC_MEMORY_ALLOCED does.
+ * */
+struct stub_dec {
+    int codec;
+    int phys;
+    struct region regions[INPUT_BUFFERS + 1];
+    int numRegions;
+
+    const uint8_t *expect;      /* the start code, if any, and the access unit left */
+    size_t expectLen;
+    int retry;
+
+    int calls;
+    int errors;
+};
+
+static int stub_find(const uint8_t *p, size_t len, size_t from)
+{
+    for (size_t i = from; i + 3 <= len; i++) {
+        if (p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1) {
+            return (i > 0 && p[i - 1] == 0) ? i - 1 : i;
+        }
+    }
+    return len;
+}
+
+static size_t stub_zeros(const uint8_t *p, size_t len)
+{
+    size_t n = 0;
+
+    while (n < len && p[n] == 0)
+        n++;
+    return n;
+}
+
+static size_t stub_decode(struct stub_dec *d, const uint8_t *stream, uint32_t stream_phy, size_t len)
+{
+    size_t pad = 0;
+
+    d->calls++;
+
+    if (d->codec == CODEC_AVC) {
+        size_t zeros = stub_zeros(stream, len);
+        size_t expectZeros = stub_zeros(d->expect, d->expectLen);
+
+        if (zeros > expectZeros && zeros < len && stream[zeros] == 1)
+            pad = zeros - expectZeros;
+    }
+    if (len != pad + d->expectLen || memcmp(stream + pad, d->expect, d->expectLen)) {
+        d->errors++;
+        return len;
+    }
+
+    if (d->phys) {
+        int found = 0;
+
+        if (stream_phy & (SprdStreamBuffer::kAlign - 1)) {
+            d->errors++;
+        }
+        for (int i = 0; i < d->numRegions; i++) {
+            struct region *r = &d->regions[i];
+            if (stream >= r->v && stream + len <= r->v + r->size) {
+                found = 1;
+                if (stream_phy != r->phys + (stream - r->v)) {
+                    d->errors++;
+                }
+            }
+        }
+        if (!found) {
+            d->errors++;
+        }
+    }
+
+    if (d->retry) {
+        d->retry = 0;
+        return 0;
+    }
+
+    size_t n = len;
+    if (d->codec == CODEC_AVC) {
+        n = stub_find(stream, len, pad + 4);
+    }
+    d->expect += n - pad;
+    d->expectLen -= n - pad;
+
+    return n;
+}
+
+/*
+ *  An access unit of the stream: a start code and a header byte before
+ *  every NAL unit of AVC, SPS and PPS on an IDR frame. The payload has no
+ *  zero bytes, so no start code shows up in it.
+ * */
+static size_t make_frame(uint8_t *p, int codec, int frame, size_t size, int startCodes)
+{
+    int nals = 1;
+    size_t pos = 0;
+
+    if (codec == CODEC_AVC) {
+        nals = (frame % GOP == 0) ? SLICES + 2 : SLICES;
+    }
+
+    for (int i = 0; i < nals; i++) {
+        size_t nal = (i == nals - 1) ? size - pos : size / nals;
+
+        if (startCodes && codec == CODEC_AVC) {
+            p[pos++] = 0;
+            p[pos++] = 0;
+            p[pos++] = 0;
+            p[pos++] = 1;
+            nal -= 4;
+        }
+        for (size_t j = 0; j < nal; j++) {
+            p[pos++] = 1 + rnd() % 255;
+        }
+    }
+
+    return pos;
+}
+
+static size_t frame_size(int codec, int frame)
+{
+    /* an IDR frame is eight times the size of the others */
+    size_t bytes = s_bitrates[codec] / 8 * GOP / FPS;
+    size_t p = bytes / (GOP + 7);
+
+    return (frame % GOP == 0) ? 8 * p : p - 64 + rnd() % 128;
+}
+
+/*
+ *  One second of playback after another through the decoder's loop over
+ *  an input buffer.
+ * */
+static int play(int codec, int mode, bool byteStream, uint64_t *copied, uint64_t *played)
+{
+    static uint8_t heap[HEAP_SIZE];
+    static uint8_t inputs[INPUT_BUFFERS][INPUT_SIZE + SprdStreamBuffer::kHeadroom + SprdStreamBuffer::kTailroom];
+    static uint8_t expect[INPUT_SIZE + 4];
+    SprdStreamBuffer stream;
+    struct stub_dec d;
+    uint64_t legacyCopied = 0;
+
+    memset(&d, 0, sizeof(d));
+    d.codec = codec;
+    d.phys = 1;
+    d.regions[0].v = heap;
+    d.regions[0].phys = HEAP_PHYS;
+    d.regions[0].size = HEAP_SIZE;
+    d.numRegions = 1;
+    if (mode == MODE_ALLOCATED) {
+        for (int i = 0; i < INPUT_BUFFERS; i++) {
+            d.regions[i + 1].v = inputs[i];
+            d.regions[i + 1].phys = INPUT_PHYS + i * 0x200000;
+            d.regions[i + 1].size = sizeof(inputs[i]);
+        }
+        d.numRegions = INPUT_BUFFERS + 1;
+    }
+
+    stream.setHeap(heap, HEAP_PHYS, HEAP_SIZE);
+    stream.setByteStream(byteStream);
+    *played = 0;
+
+    for (int frame = 0; frame < FPS * SECONDS; frame++) {
+        int buf = frame % INPUT_BUFFERS;
+        uint8_t *pBuffer = inputs[buf] + SprdStreamBuffer::kHeadroom;
+        uint32_t phyAddr = INPUT_PHYS + buf * 0x200000;
+        size_t nOffset = 0;
+        size_t nFilledLen = make_frame(pBuffer, codec, frame, frame_size(codec, frame), 1);
+
+        memcpy(expect, pBuffer, nFilledLen);
+        d.expect = expect;
+        d.expectLen = nFilledLen;
+        d.retry = (codec != CODEC_AVC && frame == 0);
+        *played += nFilledLen;
+
+        while (nFilledLen > 0) {
+            uint8_t *bitstream = pBuffer + nOffset;
+            size_t consumed;
+
+            if (mode == MODE_LEGACY) {
+                memcpy(heap, bitstream, nFilledLen);
+                legacyCopied += nFilledLen;
+                consumed = stub_decode(&d, heap, HEAP_PHYS, nFilledLen);
+            } else {
+                uint32_t bitstreamPhy = 0;
+                size_t writable = 0;
+
+                if (mode == MODE_ALLOCATED) {
+                    writable = SprdStreamBuffer::kHeadroom + nOffset;
+                    bitstreamPhy = phyAddr + writable;
+                }
+                if (!stream.prepare(bitstream, bitstreamPhy, writable, nFilledLen, false)) {
+                    return -1;
+                }
+                consumed = stream.consume(stub_decode(&d, stream.data(), stream.phys(), stream.length()));
+            }
+
+            nOffset += consumed;
+            nFilledLen -= consumed;
+        }
+        stream.reset();
+    }
+
+    *copied = (mode == MODE_LEGACY) ? legacyCopied : stream.copiedBytes();
+    if (mode == MODE_ALLOCATED && (codec != CODEC_AVC || byteStream)
+            && stream.inPlaceBytes() != *played) {
+        d.errors++;
+    }
+
+    return d.errors;
+}
+
+/*
+ *  Thumbnail mode: NAL units without a start code get one, and it is
+ *  not counted as consumed. It goes into the bytes in front of the NAL
+ *  unit of an allocated buffer when the start code is aligned there,
+ *  otherwise into the heap.
+ * */
+static int start_code(void)
+{
+    static uint8_t heap[4096];
+    uint8_t input[SprdStreamBuffer::kHeadroom + 256];
+    uint8_t *pBuffer = input + SprdStreamBuffer::kHeadroom;
+    SprdStreamBuffer stream;
+    int errors = 0;
+
+    for (int i = 0; i < 256; i++) {
+        pBuffer[i] = 1 + rnd() % 255;
+    }
+    stream.setHeap(heap, HEAP_PHYS, sizeof(heap));
+
+    /* a client buffer, an allocated buffer at nOffset 0 and at 4 */
+    for (int c = 0; c < 3; c++) {
+        size_t nOffset = (c == 2) ? 4 : 0;
+        uint8_t *src = pBuffer + nOffset;
+        uint32_t phys = (c > 0) ? INPUT_PHYS + SprdStreamBuffer::kHeadroom + nOffset : 0;
+        size_t writable = (c > 0) ? SprdStreamBuffer::kHeadroom + nOffset : 0;
+        int inPlace = (c == 2);
+        uint64_t copied = stream.copiedBytes();
+        uint8_t nal[200];
+
+        memcpy(nal, src, sizeof(nal));
+        stream.prepare(src, phys, writable, 200, true);
+        if (stream.length() != 204 || memcmp(stream.data(), "\0\0\0\1", 4) || memcmp(stream.data() + 4, nal, 200)) {
+            errors++;
+        }
+        if (inPlace != (stream.data() == src - 4) || inPlace != (stream.phys() == phys - 4)) {
+            errors++;
+        }
+        if (stream.copiedBytes() - copied != (inPlace ? 0u : 200u)) {
+            errors++;
+        }
+
+        /* the start code and 96 bytes, then the rest */
+        if (stream.consume(100) != 96 || stream.consume(stream.length()) != 104) {
+            errors++;
+        }
+        stream.reset();
+    }
+
+    /* a NAL unit with a start code is left alone */
+    memcpy(pBuffer, "\0\0\0\1", 4);
+    stream.prepare(pBuffer, 0, 0, 200, true);
+    if (stream.length() != 200 || stream.consume(200) != 200) {
+        errors++;
+    }
+
+    printf("start code: errors %d\n", errors);
+
+    return errors;
+}
+
+/*
+ *  An allocated buffer whose bitstream doesn't start at an aligned
+ *  address is copied, and the copy is read until it is consumed. After
+ *  a reset a buffer is copied again, though it has the same address and
+ *  length.
+ * */
+static int fallbacks(void)
+{
+    static uint8_t heap[4096];
+    uint8_t input[SprdStreamBuffer::kHeadroom + 256];
+    uint8_t *src = input + SprdStreamBuffer::kHeadroom;
+    SprdStreamBuffer stream;
+    int errors = 0;
+
+    for (int i = 0; i < 256; i++) {
+        src[i] = 1 + rnd() % 255;
+    }
+    stream.setHeap(heap, HEAP_PHYS, sizeof(heap));
+
+    /* aligned, read in place */
+    stream.prepare(src, INPUT_PHYS, SprdStreamBuffer::kHeadroom, 256, false);
+    if (stream.data() != src || stream.consume(3) != 3) {
+        errors++;
+    }
+
+    /* unaligned, copied to the heap */
+    stream.prepare(src + 3, INPUT_PHYS + 3, SprdStreamBuffer::kHeadroom + 3, 253, false);
+    if (stream.data() != heap || stream.phys() != HEAP_PHYS || stream.copiedBytes() != 253) {
+        errors++;
+    }
+
+    /* read again from the heap, where it stays aligned */
+    stream.consume(8);
+    stream.prepare(src + 11, INPUT_PHYS + 11, SprdStreamBuffer::kHeadroom + 11, 245, false);
+    if (stream.data() != heap + 8 || stream.phys() != HEAP_PHYS + 8 || stream.copiedBytes() != 253) {
+        errors++;
+    }
+
+    /* and copied again where it doesn't */
+    stream.consume(1);
+    stream.prepare(src + 12, INPUT_PHYS + 12, SprdStreamBuffer::kHeadroom + 12, 244, false);
+    if (stream.data() != heap || memcmp(heap, src + 12, 244) || stream.copiedBytes() != 253 + 244) {
+        errors++;
+    }
+
+    /* a returned buffer, refilled, is not taken for the one before */
+    stream.reset();
+    src[12] ^= 0xff;
+    stream.prepare(src + 12, 0, 0, 244, false);
+    if (stream.data() != heap || heap[0] != src[12]) {
+        errors++;
+    }
+
+    /* too big for the heap */
+    if (stream.prepare(input, 0, 0, sizeof(heap) + 1, false)) {
+        errors++;
+    }
+
+    printf("fallbacks: errors %d\n", errors);
+
+    return errors;
+}
+
+/*
+ *  NAL units of 8, 13 and 230 bytes, 5 bytes into p.
+ * */
+static void make_nals(uint8_t *p)
+{
+    for (int i = 0; i < 256; i++) {
+        p[i] = 1 + rnd() % 255;
+    }
+    memcpy(p + 5, "\0\0\1", 3);
+    memcpy(p + 13, "\0\0\0\1", 4);
+    memcpy(p + 26, "\0\0\1", 3);
+}
+
+/*
+ *  In a byte stream a NAL unit at an address the hardware can't start
+ *  reading at gets zero bytes in front of its start code, in place in
+ *  an allocated buffer and in the heap after a copy, and they are not
+ *  counted as consumed. Where the decoder didn't stop at a start code
+ *  the rest is copied.
+ * */
+static int padding(void)
+{
+    static uint8_t heap[4096];
+    uint8_t input[SprdStreamBuffer::kHeadroom + 256];
+    uint8_t *pBuffer = input + SprdStreamBuffer::kHeadroom;
+    uint32_t phyAddr = INPUT_PHYS + SprdStreamBuffer::kHeadroom;
+    SprdStreamBuffer stream;
+    uint8_t nals[251];
+    int errors = 0;
+
+    stream.setHeap(heap, HEAP_PHYS, sizeof(heap));
+    stream.setByteStream(true);
+
+    /* in place, over the bytes consumed before */
+    make_nals(pBuffer);
+    memcpy(nals, pBuffer + 5, sizeof(nals));
+    stream.prepare(pBuffer + 5, phyAddr + 5, SprdStreamBuffer::kHeadroom + 5, 251, false);
+    if (stream.data() != pBuffer || stream.phys() != phyAddr || stream.length() != 256 ||
+        memcmp(stream.data(), "\0\0\0\0\0", 5) || memcmp(stream.data() + 5, nals, 251) ||
+        stream.consume(13) != 8) {
+        errors++;
+    }
+    stream.prepare(pBuffer + 13, phyAddr + 13, SprdStreamBuffer::kHeadroom + 13, 243, false);
+    if (stream.data() != pBuffer + 8 || stream.phys() != phyAddr + 8 || stream.length() != 248 ||
+        memcmp(stream.data() + 5, nals + 8, 243) || stream.consume(18) != 13) {
+        errors++;
+    }
+    stream.prepare(pBuffer + 26, phyAddr + 26, SprdStreamBuffer::kHeadroom + 26, 230, false);
+    if (stream.data() != pBuffer + 24 || stream.phys() != phyAddr + 24 ||
+        memcmp(stream.data() + 2, nals + 21, 230) || stream.consume(232) != 230) {
+        errors++;
+    }
+    if (stream.copiedBytes() != 0 || stream.inPlaceBytes() != 251) {
+        errors++;
+    }
+    stream.reset();
+
+    /* a client buffer, copied once */
+    make_nals(pBuffer);
+    memcpy(nals, pBuffer + 5, sizeof(nals));
+    stream.prepare(pBuffer + 5, 0, 0, 251, false);
+    if (stream.data() != heap || stream.consume(8) != 8) {
+        errors++;
+    }
+    stream.prepare(pBuffer + 13, 0, 0, 243, false);
+    if (stream.data() != heap + 8 || stream.phys() != HEAP_PHYS + 8 || stream.consume(13) != 13) {
+        errors++;
+    }
+    stream.prepare(pBuffer + 26, 0, 0, 230, false);
+    if (stream.data() != heap + 16 || stream.phys() != HEAP_PHYS + 16 || stream.length() != 235 ||
+        memcmp(stream.data(), "\0\0\0\0\0", 5) || memcmp(stream.data() + 5, nals + 21, 230) ||
+        stream.consume(235) != 230) {
+        errors++;
+    }
+    if (stream.copiedBytes() != 251) {
+        errors++;
+    }
+    stream.reset();
+
+    /* stopped short of a start code */
+    make_nals(pBuffer);
+    stream.prepare(pBuffer + 5, 0, 0, 251, false);
+    stream.consume(12);
+    stream.prepare(pBuffer + 17, 0, 0, 239, false);
+    if (stream.data() != heap || stream.copiedBytes() != 251 + 251 + 239) {
+        errors++;
+    }
+    stream.reset();
+
+    printf("padding: errors %d\n", errors);
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int errors = 0;
+
+    if (argc > 1)
+        s_seed = strtoul(argv[1], NULL, 0);
+
+    printf("utest_vsp_stream -- 1080p%d, %d s, seed %u\n", FPS, SECONDS, s_seed);
+
+    for (size_t c = 0; c < sizeof(s_configs) / sizeof(s_configs[0]); c++) {
+        int codec = s_configs[c].codec;
+        bool byteStream = s_configs[c].byteStream;
+        uint64_t copied[MODE_NUM];
+        uint64_t played;
+
+        for (int mode = 0; mode < MODE_NUM; mode++) {
+            uint32_t seed = s_seed;
+            int err = play(codec, mode, byteStream, &copied[mode], &played);
+
+            s_seed = seed;
+            printf("%s %s %9llu bytes copied/s, %9llu bitstream bytes/s, errors %d\n",
+                   s_configs[c].name, s_modeNames[mode],
+                   (unsigned long long)(copied[mode] / SECONDS),
+                   (unsigned long long)(played / SECONDS), err);
+            if (err != 0)
+                errors++;
+        }
+        rnd();
+
+        /*
+         *  A client buffer is copied once, an allocated one not at all.
+         *  Without zero padding an AVC NAL unit at an unaligned address
+         *  is copied to an aligned start, as the decoder always did.
+         * */
+        if (codec == CODEC_AVC && !byteStream)
+            continue;
+        if (copied[MODE_CLIENT] > played || copied[MODE_ALLOCATED] != 0)
+            errors++;
+    }
+
+    errors += start_code();
+    errors += fallbacks();
+    errors += padding();
+
+    if (errors) {
+        printf("FAILED, %d errors\n", errors);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
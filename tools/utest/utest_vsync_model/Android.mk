@@ -0,0 +1,10 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_vsync_model
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/hwcomposer/SprdPrimaryDisplayDevice
+LOCAL_SRC_FILES:= utest_vsync_model.cpp \
+	../../../libs/hwcomposer/SprdPrimaryDisplayDevice/SprdVsyncModel.cpp
+LOCAL_LDLIBS:= -lm
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "SprdVsyncModel.h"
+
+using namespace android;
+
+#define NOMINAL_PERIOD  16666666
+#define SIM_SECONDS     60
+#define SIM_FRAMES      (SIM_SECONDS * 60)
+#define ERROR_MAX       (SIM_FRAMES * 2)
+
+/*
+ *  The display runs a little off the period of the panel timing,
+ *  its phase may jump once when it is set up again. An unblank
+ *  calls SprdVsyncEvent::resync(), other jumps come unannounced.
+ * */
+struct display {
+    double period;
+    double phase;
+    nsecs_t jumpTime;
+    double jumpPhase;
+    bool jumpResync;
+};
+
+struct result {
+    nsecs_t errors[ERROR_MAX];
+    int count;
+    unsigned int hwWakes;
+    unsigned int timerWakes;
+};
+
+static double uniform(void)
+{
+    return (rand() + 0.5) / ((double)RAND_MAX + 1);
+}
+
+static nsecs_t exponential(double mean)
+{
+    return (nsecs_t)(-mean * log(uniform()));
+}
+
+/*
+ *  Interrupt and scheduler latency of a wake-up:
+ *  mostly short, now and then a preemption of a few ms.
+ * */
+static nsecs_t wake_latency(void)
+{
+    nsecs_t l = 30000 + exponential(150000);
+
+    if (uniform() < 0.03)
+        l += 1000000 + (nsecs_t)(uniform() * 5000000);
+
+    return l;
+}
+
+static double phase_at(const struct display *d, nsecs_t t)
+{
+    return (d->jumpTime && t >= d->jumpTime) ? d->jumpPhase : d->phase;
+}
+
+/* the first display vsync after t */
+static nsecs_t vsync_after(const struct display *d, nsecs_t t)
+{
+    double phase = phase_at(d, t);
+    double k = floor((t - phase) / d->period) + 1;
+
+    return (nsecs_t)(phase + k * d->period);
+}
+
+/* the display vsync nearest to t */
+static nsecs_t vsync_nearest(const struct display *d, nsecs_t t)
+{
+    double phase = phase_at(d, t);
+    double k = floor((t - phase) / d->period + 0.5);
+
+    return (nsecs_t)(phase + k * d->period);
+}
+
+/* the unblank after the jump */
+static void check_resync(const struct display *d, SprdVsyncModel *m, nsecs_t now, bool *done)
+{
+    if (d->jumpResync && *done == false && now >= d->jumpTime) {
+        m->reset();
+        *done = true;
+    }
+}
+
+static void add_error(struct result *r, nsecs_t e)
+{
+    if (r->count < ERROR_MAX)
+        r->errors[r->count++] = (e < 0) ? -e : e;
+}
+
+/*
+ *  The hardware loop of SprdVsyncEvent::threadLoop():
+ *  model 0 posts the wake-up time as the loop did before,
+ *  model 1 posts the model vsync, model 2 also runs predicted.
+ * */
+static void run_hw(const struct display *d, int model, struct result *r)
+{
+    SprdVsyncModel m(NOMINAL_PERIOD);
+    nsecs_t end = (nsecs_t)SIM_SECONDS * 1000000000;
+    nsecs_t now = 1000000;
+    nsecs_t last = 0;
+    bool resynced = false;
+
+    m.setPredictMode(model == 2);
+    memset(r, 0, sizeof(*r));
+
+    while (now < end) {
+        if (m.waitHardware()) {
+            nsecs_t v = vsync_after(d, now);
+            nsecs_t wake = v + wake_latency();
+            nsecs_t ts = wake;
+
+            if (model) {
+                m.addSample(wake);
+                ts = m.vsyncOf(wake);
+                if (ts <= last)
+                    ts = wake;
+            }
+            add_error(r, ts - v);
+            r->hwWakes++;
+            last = ts;
+            now = wake;
+        } else {
+            nsecs_t t = last + m.getPeriod() / 2;
+            nsecs_t ts = m.vsyncAfter((now > t) ? now : t);
+
+            add_error(r, ts - vsync_nearest(d, ts));
+            r->timerWakes++;
+            last = ts;
+            now = ts + wake_latency();
+        }
+
+        /* the vsync callback */
+        now += 50000;
+        check_resync(d, &m, now, &resynced);
+    }
+}
+
+/*
+ *  The timer loop of SprdVsyncEvent::threadLoop(): model 0 as
+ *  before, model 1 locked by the synchronous displays of commit,
+ *  which end a little after a vsync on some frames.
+ * */
+static void run_timer(const struct display *d, int model, struct result *r)
+{
+    SprdVsyncModel m(NOMINAL_PERIOD);
+    nsecs_t end = (nsecs_t)SIM_SECONDS * 1000000000;
+    nsecs_t now = 1000000;
+    nsecs_t next = 0;
+    nsecs_t last = 0;
+    nsecs_t present = vsync_after(d, now);
+    bool resynced = false;
+
+    memset(r, 0, sizeof(*r));
+
+    while (now < end) {
+        nsecs_t ts;
+
+        while (model && present <= now) {
+            m.addSample(present + 200000 + exponential(300000));
+            present = vsync_after(d, present + (1 + rand() % 3) * NOMINAL_PERIOD);
+        }
+
+        if (m.isLocked()) {
+            nsecs_t t = last + m.getPeriod() / 2;
+            ts = m.vsyncAfter((now > t) ? now : t);
+        } else {
+            ts = next;
+            if (ts - now < 0)
+                ts = now + (NOMINAL_PERIOD - ((now - ts) % NOMINAL_PERIOD));
+        }
+        next = ts + NOMINAL_PERIOD;
+
+        add_error(r, ts - vsync_nearest(d, ts));
+        r->timerWakes++;
+        last = ts;
+        now = ts + wake_latency() + 50000;
+        check_resync(d, &m, now, &resynced);
+    }
+}
+
+static int compare_nsecs(const void *a, const void *b)
+{
+    nsecs_t x = *(const nsecs_t *)a;
+    nsecs_t y = *(const nsecs_t *)b;
+
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/* p99 of the error in us */
+static long long print_result(const char *name, struct result *r)
+{
+    long long sum = 0;
+
+    qsort(r->errors, r->count, sizeof(nsecs_t), compare_nsecs);
+    for (int i = 0; i < r->count; i++)
+        sum += r->errors[i];
+
+    long long p99 = r->errors[r->count * 99 / 100] / 1000;
+
+    printf("%-14s error mean %5lld us, p50 %5lld us, p99 %5lld us, max %5lld us,"
+           " wake-ups/s hw %2u timer %2u\n", name,
+           sum / r->count / 1000, (long long)r->errors[r->count / 2] / 1000, p99,
+           (long long)r->errors[r->count - 1] / 1000,
+           r->hwWakes / SIM_SECONDS, r->timerWakes / SIM_SECONDS);
+
+    return p99;
+}
+
+static struct result s_result;
+
+static int run_display(const char *title, const struct display *d)
+{
+    long long hw, model, predict, timer, present;
+    unsigned int predictWakes;
+    int ret = 0;
+
+    printf("%s\n", title);
+
+    run_hw(d, 0, &s_result);
+    hw = print_result("  hw loop", &s_result);
+    run_hw(d, 1, &s_result);
+    model = print_result("  hw model", &s_result);
+    run_hw(d, 2, &s_result);
+    predictWakes = s_result.hwWakes / SIM_SECONDS;
+    predict = print_result("  hw predicted", &s_result);
+    run_timer(d, 0, &s_result);
+    timer = print_result("  timer loop", &s_result);
+    run_timer(d, 1, &s_result);
+    present = print_result("  timer model", &s_result);
+
+    /*
+     *  The model shall post vsync closer than the loop did, and the
+     *  predicted mode shall seldom wait for the hardware. An
+     *  unannounced jump is only found by the next resynchronisation
+     *  in predicted mode.
+     * */
+    if (model >= hw || present >= timer || predictWakes > 6)
+        ret = -1;
+    if ((d->jumpTime == 0 || d->jumpResync) && predict >= hw)
+        ret = -1;
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    struct display d;
+    int ret = 0;
+
+    srand(seed);
+    printf("utest_vsync_model -- %d s at %d ns, seed %u\n", SIM_SECONDS, NOMINAL_PERIOD, seed);
+
+    d.period = NOMINAL_PERIOD * 1.002;
+    d.phase = uniform() * d.period;
+    d.jumpTime = 0;
+    d.jumpPhase = 0;
+    d.jumpResync = false;
+    ret |= run_display("steady", &d);
+
+    d.jumpTime = (nsecs_t)SIM_SECONDS / 2 * 1000000000;
+    d.jumpPhase = d.phase + d.period * (0.25 + uniform() / 2);
+    d.jumpResync = true;
+    ret |= run_display("unblank", &d);
+
+    d.jumpResync = false;
+    ret |= run_display("phase jump", &d);
+
+    printf("%s\n", ret ? "FAIL" : "OK");
+
+    return ret;
+}
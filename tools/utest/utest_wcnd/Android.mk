@@ -0,0 +1,9 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_wcnd
+LOCAL_MODULE_TAGS:= debug
+LOCAL_MODULE_PATH:= $(TARGET_OUT_OPTIONAL_EXECUTABLES)
+LOCAL_SRC_FILES:= utest_wcnd.c
+LOCAL_SHARED_LIBRARIES:= libcutils
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2012 Spreadtrum Communications Inc.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <cutils/sockets.h>
+
+#define ERR(x...) fprintf(stderr, x)
+#define INFO(x...) fprintf(stdout, x)
+
+#define WCND_SOCKET_NAME "wcnd"
+#define TEST_NOTIFY_STRING "WCN-TEST-NOTIFY"
+
+#define MAX_CLIENTS 30
+#define DEFAULT_CLIENTS 20
+#define DEFAULT_STUCK 4
+#define DEFAULT_ROUNDS 2000
+#define ROUND_TIMEOUT_MS 1000
+/* makes each notify about 200 bytes, so stuck clients fill up early */
+#define PAD_LEN 180
+
+typedef struct {
+    int fd;
+    int stuck;          /* never reads */
+    int got;            /* notify of this round received */
+    char buf[1024];
+    int len;
+} client_t;
+
+static client_t clients[MAX_CLIENTS + 1];
+static long long *samples;
+
+static long long now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* read what is there, return 1 once the notify of the round is seen */
+static int client_read(client_t *c, int round)
+{
+    char want[32];
+    int r, start, i;
+
+    r = read(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+    if (r <= 0)
+        return r < 0 && errno == EAGAIN ? 0 : -1;
+    c->len += r;
+
+    snprintf(want, sizeof(want), "%s %d-", TEST_NOTIFY_STRING, round);
+
+    /* messages from wcnd end with a null character */
+    start = 0;
+    for (i = 0; i < c->len; i++) {
+        if (c->buf[i])
+            continue;
+        if (!strncmp(c->buf + start, want, strlen(want)))
+            c->got = 1;
+        start = i + 1;
+    }
+    memmove(c->buf, c->buf + start, c->len - start);
+    c->len -= start;
+    if (c->len == sizeof(c->buf) - 1)
+        c->len = 0;
+
+    return c->got;
+}
+
+int main(int argc, char **argv)
+{
+    int nclients = argc > 1 ? atoi(argv[1]) : DEFAULT_CLIENTS;
+    int nstuck = argc > 2 ? atoi(argv[2]) : DEFAULT_STUCK;
+    int rounds = argc > 3 ? atoi(argv[3]) : DEFAULT_ROUNDS;
+    struct pollfd pfds[MAX_CLIENTS + 1];
+    char cmd[256], pad[PAD_LEN + 1];
+    int round, i, n, missed = 0, dropped = 0, nsamples = 0;
+    client_t *trigger;
+
+    if (nclients < 1 || nclients > MAX_CLIENTS || nstuck < 0 || nstuck >= nclients || rounds < 1) {
+        ERR("Usage: utest_wcnd [clients(1-%d)] [stuck] [rounds]\n", MAX_CLIENTS);
+        return -1;
+    }
+
+    /* clients[nclients] sends the commands and also listens */
+    for (i = 0; i <= nclients; i++) {
+        clients[i].fd = socket_local_client(WCND_SOCKET_NAME,
+                ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+        if (clients[i].fd < 0) {
+            ERR("connect %s failed: %s\n", WCND_SOCKET_NAME, strerror(errno));
+            return -1;
+        }
+        fcntl(clients[i].fd, F_SETFL, O_NONBLOCK);
+        clients[i].stuck = i < nstuck;
+    }
+    trigger = &clients[nclients];
+
+    samples = malloc(sizeof(long long) * rounds * (nclients + 1));
+    if (!samples)
+        return -1;
+
+    memset(pad, 'x', PAD_LEN);
+    pad[PAD_LEN] = 0;
+
+    INFO("utest_wcnd -- %d clients (%d never read), %d rounds\n", nclients + 1, nstuck, rounds);
+
+    for (round = 0; round < rounds; round++) {
+        long long start, fanout = 0;
+        int pending = 0;
+
+        for (i = nstuck; i <= nclients; i++) {
+            clients[i].got = 0;
+            if (clients[i].fd >= 0)
+                pending++;
+        }
+
+        snprintf(cmd, sizeof(cmd), "wcn notifytest %d-%s", round, pad);
+        start = now_us();
+        if (write(trigger->fd, cmd, strlen(cmd) + 1) < 0) {
+            ERR("send cmd failed: %s\n", strerror(errno));
+            return -1;
+        }
+
+        while (pending > 0) {
+            int timeout = ROUND_TIMEOUT_MS - (int)((now_us() - start) / 1000);
+
+            n = 0;
+            for (i = nstuck; i <= nclients; i++) {
+                if (clients[i].fd < 0 || clients[i].got)
+                    continue;
+                pfds[n].fd = clients[i].fd;
+                pfds[n].events = POLLIN;
+                pfds[n].revents = 0;
+                n++;
+            }
+            if (timeout <= 0 || poll(pfds, n, timeout) <= 0) {
+                missed += pending;
+                break;
+            }
+
+            for (i = nstuck; i <= nclients; i++) {
+                client_t *c = &clients[i];
+                int r;
+
+                if (c->fd < 0 || c->got)
+                    continue;
+                r = client_read(c, round);
+                if (r < 0) {
+                    ERR("client %d closed by wcnd\n", i);
+                    close(c->fd);
+                    c->fd = -1;
+                    pending--;
+                } else if (r > 0) {
+                    long long lat = now_us() - start;
+                    samples[nsamples++] = lat;
+                    if (lat > fanout)
+                        fanout = lat;
+                    pending--;
+                }
+            }
+        }
+        if (trigger->fd < 0) {
+            ERR("command client lost\n");
+            return -1;
+        }
+    }
+
+    /* wcnd should have given up on the clients that never read */
+    for (i = 0; i < nstuck; i++) {
+        struct pollfd p;
+        char buf[4096];
+        int r = -1;
+
+        p.fd = clients[i].fd;
+        p.events = POLLIN;
+        while (poll(&p, 1, ROUND_TIMEOUT_MS) > 0) {
+            r = read(clients[i].fd, buf, sizeof(buf));
+            if (r <= 0)
+                break;
+        }
+        if (r == 0)
+            dropped++;
+        close(clients[i].fd);
+    }
+
+    if (!nsamples) {
+        ERR("no notify received, is wcnd a userdebug build with CP2 started?\n");
+        return -1;
+    }
+
+    qsort(samples, nsamples, sizeof(long long), cmp_ll);
+    INFO("notify latency: p50 %lld us, p99 %lld us, max %lld us, missed %d\n",
+            samples[nsamples / 2], samples[nsamples * 99 / 100],
+            samples[nsamples - 1], missed);
+    INFO("stuck clients dropped by wcnd: %d/%d\n", dropped, nstuck);
+
+    free(samples);
+    return missed ? -1 : 0;
+}
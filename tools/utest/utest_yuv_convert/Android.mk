@@ -0,0 +1,12 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE:= utest_yuv_convert
+LOCAL_MODULE_TAGS:= debug
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/../../../libs/libstagefrighthw/include
+LOCAL_SRC_FILES:= utest_yuv_convert.cpp \
+	../../../libs/libstagefrighthw/SprdYuvConvert.cpp \
+	../../../libs/libstagefrighthw/SprdWorkerPool.cpp
+LOCAL_STATIC_LIBRARIES:= libutils libcutils liblog
+LOCAL_LDLIBS:= -lrt -lpthread
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,432 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "SprdYuvConvert.h"
+#include "SprdWorkerPool.h"
+
+using namespace android;
+
+#define MAX_SMALL       34
+#define CANARY          0xa5
+#define BENCH_FRAMES    30
+
+#define ALIGN16(x)      (((x) + 15) & ~15)
+
+static const char *s_formatNames[4] = { "I420", "YV12", "NV12", "NV21" };
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ *  The samples of a test picture, different in every plane and position.
+ * */
+static uint8_t sample(int plane, int x, int y)
+{
+    return (uint8_t)(x * 7 + y * 13 + plane * 85 + ((x * y) >> 3));
+}
+
+static void fill(const SprdYuvConvert::Frame *f, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            f->y[y * f->yStride + x] = sample(0, x, y);
+    for (int y = 0; y < (height + 1) / 2; y++) {
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            f->u[y * f->uvStride + x * f->uvStep] = sample(1, x, y);
+            f->v[y * f->uvStride + x * f->uvStep] = sample(2, x, y);
+        }
+    }
+}
+
+static int check_picture(const SprdYuvConvert::Frame *f, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            if (f->y[y * f->yStride + x] != sample(0, x, y))
+                return 1;
+    for (int y = 0; y < (height + 1) / 2; y++) {
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            if (f->u[y * f->uvStride + x * f->uvStep] != sample(1, x, y) ||
+                f->v[y * f->uvStride + x * f->uvStep] != sample(2, x, y))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  The byte order of a 2x2 frame in every format, as the formats are
+ *  defined: I420 Y U V, YV12 Y V U, NV12 Y UV, NV21 Y VU.
+ * */
+static int test_layout(void)
+{
+    static const uint8_t s_expected[4][6] = {
+        { 1, 2, 3, 4, 5, 6 },
+        { 1, 2, 3, 4, 6, 5 },
+        { 1, 2, 3, 4, 5, 6 },
+        { 1, 2, 3, 4, 6, 5 },
+    };
+    int errors = 0;
+
+    for (int fmt = 0; fmt < 4; fmt++) {
+        uint8_t buf[6];
+        SprdYuvConvert::Frame f;
+
+        SprdYuvConvert::layout(&f, (SprdYuvConvert::Format)fmt, buf, 2, 2);
+        f.y[0] = 1;
+        f.y[1] = 2;
+        f.y[f.yStride] = 3;
+        f.y[f.yStride + 1] = 4;
+        f.u[0] = 5;
+        f.v[0] = 6;
+        if (memcmp(buf, s_expected[fmt], 6) != 0 ||
+            SprdYuvConvert::frameSize((SprdYuvConvert::Format)fmt, 2, 2) != 6) {
+            printf("layout %s: wrong byte order\n", s_formatNames[fmt]);
+            errors++;
+        }
+    }
+
+    printf("layout: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  Every pair of formats, every size up to MAX_SMALL x MAX_SMALL, with
+ *  tight and padded strides and slice heights. The picture shall arrive,
+ *  and every byte of dst shall be what the reference leaves there, the
+ *  padding untouched.
+ * */
+static int test_small(void)
+{
+    size_t maxSize = SprdYuvConvert::frameSize(SprdYuvConvert::I420, MAX_SMALL + 7, MAX_SMALL + 3);
+    uint8_t *src = (uint8_t *)malloc(maxSize);
+    uint8_t *dst = (uint8_t *)malloc(maxSize);
+    uint8_t *ref = (uint8_t *)malloc(maxSize);
+    int errors = 0, cases = 0;
+
+    for (int sf = 0; sf < 4; sf++) {
+        for (int df = 0; df < 4; df++) {
+            int bad = 0;
+
+            for (int h = 1; h <= MAX_SMALL; h++) {
+                for (int w = 1; w <= MAX_SMALL; w++) {
+                    for (int pad = 0; pad < 4; pad++) {
+                        int sStride = w + ((pad & 1) ? 1 + rnd() % 7 : 0);
+                        int dStride = w + ((pad & 2) ? 1 + rnd() % 7 : 0);
+                        int sSlice = h + ((pad & 1) ? rnd() % 4 : 0);
+                        int dSlice = h + ((pad & 2) ? rnd() % 4 : 0);
+                        SprdYuvConvert::Frame s, d, r;
+
+                        /* interleaved chroma of an odd width needs an even stride */
+                        if (sf >= SprdYuvConvert::NV12 && (w & 1) && sStride == w)
+                            sStride++;
+                        if (df >= SprdYuvConvert::NV12 && (w & 1) && dStride == w)
+                            dStride++;
+
+                        SprdYuvConvert::layout(&s, (SprdYuvConvert::Format)sf, src, sStride, sSlice);
+                        SprdYuvConvert::layout(&d, (SprdYuvConvert::Format)df, dst, dStride, dSlice);
+                        SprdYuvConvert::layout(&r, (SprdYuvConvert::Format)df, ref, dStride, dSlice);
+
+                        for (size_t i = 0; i < maxSize; i++)
+                            src[i] = rnd();
+                        memset(dst, CANARY, maxSize);
+                        memset(ref, CANARY, maxSize);
+                        fill(&s, w, h);
+
+                        if (!SprdYuvConvert::convert(s, d, w, h, NULL) ||
+                            !SprdYuvConvert::convertReference(s, r, w, h) ||
+                            check_picture(&r, w, h) ||
+                            memcmp(dst, ref, maxSize) != 0) {
+                            if (bad == 0)
+                                printf("  %s -> %s %dx%d stride %d/%d slice %d/%d differs\n",
+                                       s_formatNames[sf], s_formatNames[df], w, h,
+                                       sStride, dStride, sSlice, dSlice);
+                            bad++;
+                        }
+                        cases++;
+                    }
+                }
+            }
+            errors += bad;
+        }
+    }
+
+    printf("small: %d conversions up to %dx%d, errors %d\n", cases, MAX_SMALL, MAX_SMALL, errors);
+
+    free(src);
+    free(dst);
+    free(ref);
+    return errors;
+}
+
+/*
+ *  A plane smaller than the picture is refused, nothing written.
+ * */
+static int test_refuse(void)
+{
+    uint8_t src[64], dst[64];
+    SprdYuvConvert::Frame s, d;
+    int errors = 0;
+
+    SprdYuvConvert::layout(&s, SprdYuvConvert::I420, src, 4, 4);
+    SprdYuvConvert::layout(&d, SprdYuvConvert::NV21, dst, 3, 4);
+    memset(dst, CANARY, sizeof(dst));
+    if (SprdYuvConvert::convert(s, d, 4, 4, NULL))
+        errors++;
+    if (SprdYuvConvert::convert(s, s, 0, 4, NULL))
+        errors++;
+    for (size_t i = 0; i < sizeof(dst); i++)
+        if (dst[i] != CANARY)
+            errors++;
+
+    printf("refuse: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  Frames large enough to be split, of odd sizes, through pools of 2 and
+ *  3 bands, against the reference.
+ * */
+static int test_bands(void)
+{
+    static const int s_sizes[][2] = {
+        { 640, 480 }, { 641, 481 }, { 1283, 723 }, { 1920, 1080 },
+    };
+    static const int s_pairs[][2] = {
+        { SprdYuvConvert::I420, SprdYuvConvert::NV21 },
+        { SprdYuvConvert::NV21, SprdYuvConvert::NV12 },
+        { SprdYuvConvert::NV12, SprdYuvConvert::YV12 },
+        { SprdYuvConvert::YV12, SprdYuvConvert::I420 },
+    };
+    int errors = 0;
+
+    for (int bands = 2; bands <= 3; bands++) {
+        SprdWorkerPool *pool = new SprdWorkerPool("yuvconvert", bands, 0);
+
+        for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+            int w = s_sizes[i][0], h = s_sizes[i][1];
+            int stride = ALIGN16(w), slice = ALIGN16(h);
+            size_t size = SprdYuvConvert::frameSize(SprdYuvConvert::I420, stride, slice);
+            uint8_t *src = (uint8_t *)malloc(size);
+            uint8_t *dst = (uint8_t *)malloc(size);
+            uint8_t *ref = (uint8_t *)malloc(size);
+
+            for (size_t p = 0; p < sizeof(s_pairs) / sizeof(s_pairs[0]); p++) {
+                SprdYuvConvert::Frame s, d, r;
+
+                SprdYuvConvert::layout(&s, (SprdYuvConvert::Format)s_pairs[p][0], src, stride, slice);
+                SprdYuvConvert::layout(&d, (SprdYuvConvert::Format)s_pairs[p][1], dst, stride, slice);
+                SprdYuvConvert::layout(&r, (SprdYuvConvert::Format)s_pairs[p][1], ref, stride, slice);
+                for (size_t k = 0; k < size; k++)
+                    src[k] = rnd();
+                memset(dst, CANARY, size);
+                memset(ref, CANARY, size);
+
+                if (!SprdYuvConvert::convert(s, d, w, h, pool) ||
+                    !SprdYuvConvert::convertReference(s, r, w, h) ||
+                    memcmp(dst, ref, size) != 0) {
+                    printf("  %d bands %s -> %s %dx%d differs\n", bands,
+                           s_formatNames[s_pairs[p][0]], s_formatNames[s_pairs[p][1]], w, h);
+                    errors++;
+                }
+            }
+
+            free(src);
+            free(dst);
+            free(ref);
+        }
+
+        delete pool;
+    }
+
+    printf("bands: errors %d\n", errors);
+    return errors;
+}
+
+/*
+ *  The conversion both encoders had, for 16 aligned widths.
+ * */
+static void legacy_convert(uint8_t *inyuv, uint8_t* outyuv,
+        int32_t width_org, int32_t height_org, int32_t width_dst, int32_t height_dst) {
+
+    int32_t inYsize = width_org * height_org;
+    uint32_t *outy =  (uint32_t *) outyuv;
+    uint16_t *incb = (uint16_t *) (inyuv + inYsize);
+    uint16_t *incr = (uint16_t *) (inyuv + inYsize + (inYsize >> 2));
+
+    /* Y copying */
+    memcpy(outy, inyuv, inYsize);
+
+    /* U & V copying, Make sure uv data is in their right position*/
+    uint32_t *outUV = (uint32_t *) (outyuv + width_dst * height_dst);
+    for (int32_t i = height_org >> 1; i > 0; --i) {
+        for (int32_t j = width_org >> 2; j > 0; --j) {
+            uint32_t tempU = *incb++;
+            uint32_t tempV = *incr++;
+
+            tempU = (tempU & 0xFF) | ((tempU & 0xFF00) << 8);
+            tempV = (tempV & 0xFF) | ((tempV & 0xFF00) << 8);
+            uint32_t temp = tempV | (tempU << 8);
+
+            // Flip U and V
+            *outUV++ = temp;
+        }
+    }
+}
+
+/*
+ *  Where the old conversion was right, 16 aligned widths, the encoders
+ *  get the same frame as before.
+ * */
+static int test_legacy(void)
+{
+    static const int s_sizes[][2] = {
+        { 176, 144 }, { 640, 426 }, { 1280, 720 },
+    };
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+        int w = s_sizes[i][0], h = s_sizes[i][1];
+        size_t inSize = w * h * 3 / 2;
+        size_t outSize = w * ALIGN16(h) * 3 / 2;
+        uint8_t *in = (uint8_t *)malloc(inSize);
+        uint8_t *old = (uint8_t *)malloc(outSize);
+        uint8_t *out = (uint8_t *)malloc(outSize);
+        SprdYuvConvert::Frame s, d;
+
+        for (size_t k = 0; k < inSize; k++)
+            in[k] = rnd();
+        memset(old, CANARY, outSize);
+        memset(out, CANARY, outSize);
+
+        legacy_convert(in, old, w, h, w, ALIGN16(h));
+        SprdYuvConvert::layout(&s, SprdYuvConvert::I420, in, w, h);
+        SprdYuvConvert::layout(&d, SprdYuvConvert::NV21, out, w, ALIGN16(h));
+        if (!SprdYuvConvert::convert(s, d, w, h, NULL) || memcmp(old, out, outSize) != 0) {
+            printf("  %dx%d differs from the old conversion\n", w, h);
+            errors++;
+        }
+
+        free(in);
+        free(old);
+        free(out);
+    }
+
+    printf("legacy: errors %d\n", errors);
+    return errors;
+}
+
+static void print_rate(const char *what, int64_t ns, int w, int h)
+{
+    double ms = ns / 1e6 / BENCH_FRAMES;
+
+    printf("  %-24s %6.2f ms %8.0f MB/s\n", what, ms, w * h * 1.5 / (ms * 1000));
+}
+
+/*
+ *  I420 to NV21 into the 16 aligned frame of the encoders, the old way,
+ *  a byte at a time, with the kernels and with the kernels in the pool.
+ *  Then every other pair of formats with the kernels.
+ * */
+static int test_bench(SprdWorkerPool *pool)
+{
+    static const int s_sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+        int w = s_sizes[i][0], h = s_sizes[i][1];
+        int stride = ALIGN16(w), slice = ALIGN16(h);
+        size_t size = SprdYuvConvert::frameSize(SprdYuvConvert::I420, stride, slice);
+        uint8_t *src = (uint8_t *)malloc(size);
+        uint8_t *dst = (uint8_t *)malloc(size);
+        SprdYuvConvert::Frame s, d;
+        int64_t t;
+        char what[32];
+
+        for (size_t k = 0; k < size; k++)
+            src[k] = rnd();
+        memset(dst, 0, size);
+
+        printf("bench %dx%d, %d frames:\n", w, h, BENCH_FRAMES);
+        SprdYuvConvert::layout(&s, SprdYuvConvert::I420, src, w, h);
+        SprdYuvConvert::layout(&d, SprdYuvConvert::NV21, dst, stride, slice);
+
+        t = now_ns();
+        for (int n = 0; n < BENCH_FRAMES; n++)
+            legacy_convert(src, dst, w, h, stride, slice);
+        print_rate("I420 -> NV21 old", now_ns() - t, w, h);
+
+        t = now_ns();
+        for (int n = 0; n < BENCH_FRAMES; n++)
+            SprdYuvConvert::convertReference(s, d, w, h);
+        print_rate("I420 -> NV21 reference", now_ns() - t, w, h);
+
+        t = now_ns();
+        for (int n = 0; n < BENCH_FRAMES; n++)
+            SprdYuvConvert::convert(s, d, w, h, NULL);
+        print_rate("I420 -> NV21", now_ns() - t, w, h);
+
+        t = now_ns();
+        for (int n = 0; n < BENCH_FRAMES; n++)
+            SprdYuvConvert::convert(s, d, w, h, pool);
+        snprintf(what, sizeof(what), "I420 -> NV21 x%d", pool->bands());
+        print_rate(what, now_ns() - t, w, h);
+
+        for (int sf = 0; sf < 4; sf++) {
+            for (int df = 0; df < 4; df++) {
+                if (sf == df || (sf == SprdYuvConvert::I420 && df == SprdYuvConvert::NV21))
+                    continue;
+                SprdYuvConvert::layout(&s, (SprdYuvConvert::Format)sf, src, stride, slice);
+                SprdYuvConvert::layout(&d, (SprdYuvConvert::Format)df, dst, stride, slice);
+                t = now_ns();
+                for (int n = 0; n < BENCH_FRAMES; n++)
+                    SprdYuvConvert::convert(s, d, w, h, NULL);
+                snprintf(what, sizeof(what), "%s -> %s", s_formatNames[sf], s_formatNames[df]);
+                print_rate(what, now_ns() - t, w, h);
+            }
+        }
+
+        free(src);
+        free(dst);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int errors = 0;
+
+    if (argc > 1)
+        s_seed = strtoul(argv[1], NULL, 0);
+
+    printf("utest_yuv_convert -- seed %u\n", s_seed);
+
+    errors += test_layout();
+    errors += test_small();
+    errors += test_refuse();
+    errors += test_bands();
+    errors += test_legacy();
+
+    SprdWorkerPool *pool = new SprdWorkerPool("yuvconvert", 2, 0);
+    errors += test_bench(pool);
+    delete pool;
+
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}